@@ -12,16 +12,26 @@
 #include "Log/Logger.h"
 #include "Util/TimeClock.h"
 #include "Util/Thread.h"
+#include "IoUring.h"
 
+#include <algorithm>
+#include <cstring>
 #include <sys/epoll.h>
 #include <sys/eventfd.h>
+#include <netinet/in.h>
 #include <unistd.h>
 
 using namespace std;
 
 #define EPOLL_SIZE 1024
 
+// io_uring的sq深度，以及每个loop用于接收的缓冲个数和大小
+#define URING_ENTRIES 4096
+#define URING_BUF_COUNT 256
+#define URING_BUF_SIZE (16 * 1024)
+
 static thread_local std::weak_ptr<EventLoop> gCurrentLoop;
+static string g_backend = "epoll";
 
 static int createEventfd(){
     int evtfd = eventfd(0, EFD_NONBLOCK);
@@ -32,9 +42,16 @@ static int createEventfd(){
 }
 
 EventLoop::EventLoop()
+    :EventLoop(true)
+{}
+
+EventLoop::EventLoop(bool uring)
 {
     _epollFd = epoll_create(EPOLL_SIZE);
     _wakeupFd = createEventfd();
+    _statistic = make_shared<LoopStatistic>();
+
+    _useUring = uring && (g_backend == "io_uring" || g_backend == "auto");
 
     for (int i = 0; i < 10; i++) {
         shared_ptr<ReaderWriterQueue<asyncEventFunc>> que = make_shared<ReaderWriterQueue<asyncEventFunc>>(10);
@@ -62,6 +79,16 @@ EventLoop::Ptr EventLoop::getCurrentLoop()
     return gCurrentLoop.lock();
 }
 
+void EventLoop::setBackend(const string& backend)
+{
+    if (backend != "epoll" && backend != "io_uring" && backend != "auto") {
+        logWarn << "unknown event loop backend: " << backend << ", use epoll";
+        g_backend = "epoll";
+        return ;
+    }
+    g_backend = backend;
+}
+
 void EventLoop::start()
 {
     Thread::setThreadName("looper-" + to_string(_epollFd));
@@ -70,6 +97,19 @@ void EventLoop::start()
     gCurrentLoop = shared_from_this();
     logInfo << "EventLoop::start(): " << gCurrentLoop.lock();
 
+#ifdef ENABLE_IO_URING
+    // 创建ring的线程会被内核关联上，之后可能被io_uring的task_work打断阻塞调用，所以探测和创建都放在loop线程里
+    if (_useUring && IoUring::isSupported()) {
+        auto uring = make_shared<IoUring>();
+        if (uring->init(URING_ENTRIES, URING_BUF_COUNT, URING_BUF_SIZE)) {
+            _uring = uring;
+        }
+    }
+#endif
+    if (_useUring && g_backend == "io_uring" && !_uring) {
+        logWarn << "io_uring is not available, use epoll";
+    }
+
     addEvent(_wakeupFd, EPOLLIN, [this](int event, void* args){ onAsyncEvent(); }, nullptr);
     _timer = make_shared<Timer>();
 
@@ -78,9 +118,12 @@ void EventLoop::start()
     while (!_quit) {
         loopStrat = TimeClock::now();
 
-        uint64_t minDelay = _timer->flushTimerTask();
+        uint64_t timerStartUs = LoopStatistic::nowUs();
+        uint64_t minDelay = _timer->flushTimerTask(_statistic.get());
         // logTrace << "next epoll run time: " << minDelay;
         _delayTaskDuration = TimeClock::now() - loopStrat;
+        uint64_t waitStartUs = LoopStatistic::nowUs();
+        _statistic->timerHist.record(waitStartUs - timerStartUs);
 
         computeLoad();
 
@@ -89,16 +132,35 @@ void EventLoop::start()
         // logTrace << "_waitTime: " << _waitTime;
         _lastRunDuration = _waitTime - _runTime;
 
-        int ret = epoll_wait(_epollFd, events, EPOLL_SIZE, minDelay ? minDelay : -1);
+        int ret = 0;
+        if (_uring) {
+            waitUring(minDelay);
+        } else {
+            ret = epoll_wait(_epollFd, events, EPOLL_SIZE, minDelay ? minDelay : -1);
+            _statistic->addSyscall();
+        }
 
         _eventRun = true;
         _runTime = TimeClock::now();
+        uint64_t waitUs = LoopStatistic::nowUs() - waitStartUs;
+        _statistic->waitHist.record(waitUs);
+        _windowWaitUs += waitUs;
         // logTrace << "_runTime: " << _runTime;
         _lastWaitDuration = _runTime - _waitTime;
 
         _fdCount = _mapHander.size();
         _timerTaskCount = _timer->getTaskSize();
 
+#ifdef ENABLE_IO_URING
+        if (_uring) {
+            _uring->forEachCqe([this](io_uring_cqe* cqe){
+                onUringCqe(cqe->user_data, cqe->res, cqe->flags);
+            });
+            _eventDuration = TimeClock::now() - _runTime;
+            continue;
+        }
+#endif
+
         if (ret <= 0) {
             //超时或被打断
             continue;
@@ -113,17 +175,37 @@ void EventLoop::start()
                 epoll_ctl(_epollFd, EPOLL_CTL_DEL, fd, nullptr);
                 continue;
             }
-            auto func = it->second.callback;
-            try {
-                func(ev.events, it->second.args);
-            } catch (std::exception &ex) {
-                logWarn << "Exception occurred when do event task: " << ex.what();
-            }
+            runEvent(it->second, fd, ev.events);
         }
         _eventDuration = TimeClock::now() - _runTime;
     }
 }
 
+void EventLoop::runEvent(const EventHander& hander, int fd, int event)
+{
+    // 回调里可能删除自己，先拷贝一份
+    auto func = hander.callback;
+    auto args = hander.args;
+    SlowCallbackTracer::setSite(hander.file, hander.line);
+    uint64_t eventStartUs = LoopStatistic::nowUs();
+    try {
+        func(event, args);
+    } catch (std::exception &ex) {
+        logWarn << "Exception occurred when do event task: " << ex.what();
+    }
+    // 唤醒fd的回调即异步队列，单独统计
+    if (fd != _wakeupFd) {
+        uint64_t costUs = LoopStatistic::nowUs() - eventStartUs;
+        _statistic->eventHist.record(costUs);
+        if (_statistic->slowTracer.isSlow(costUs)) {
+            const char* file = nullptr;
+            int line = 0;
+            SlowCallbackTracer::getSite(file, line);
+            _statistic->slowTracer.record("event", file, line, costUs);
+        }
+    }
+}
+
 void EventLoop::computeLoad()
 {
     if (_waitTime == 0) {
@@ -143,7 +225,27 @@ void EventLoop::computeLoad()
         }
     }
 
-    float load = (float)_lastRunDuration / (_lastWaitDuration + _lastRunDuration);
+    // 每秒刷新一次负载，平滑处理，避免单次抖动影响负载均衡
+    auto nowUs = LoopStatistic::nowUs();
+    if (_windowStartUs == 0) {
+        _windowStartUs = nowUs;
+        return ;
+    }
+    auto windowUs = nowUs - _windowStartUs;
+    if (windowUs < 1000000) {
+        return ;
+    }
+
+    int runPermille = windowUs > _windowWaitUs ? (windowUs - _windowWaitUs) * 1000 / windowUs : 0;
+    _loadPermille.store((_loadPermille.load(std::memory_order_relaxed) * 7 + runPermille * 3) / 10, std::memory_order_relaxed);
+
+    auto totalBytes = _totalBytes.load(std::memory_order_relaxed);
+    uint64_t byteRate = (totalBytes - _windowBytes) * 1000000 / windowUs;
+    _byteRate.store((_byteRate.load(std::memory_order_relaxed) * 7 + byteRate * 3) / 10, std::memory_order_relaxed);
+
+    _windowBytes = totalBytes;
+    _windowWaitUs = 0;
+    _windowStartUs = nowUs;
 }
 
 void EventLoop::getLoad(int& lastWaitDuration, int& lastRunDuration, int& curWaitDuration, int& curRunDuration)
@@ -173,26 +275,27 @@ bool EventLoop::isCurrent()
     return !_loopThread || _loopThread->get_id() == this_thread::get_id();
 }
 
-void EventLoop::addTimerTask(uint64_t ms, const TimerTask::timerHander &handler, TaskCompleteCB cb)
+void EventLoop::addTimerTask(uint64_t ms, const TimerTask::timerHander &handler, TaskCompleteCB cb,
+                                const char* file, int line)
 {
     if (!handler) {
         return ;
     }
     if (isCurrent()) {
         logTrace << "add timer";
-        auto task = _timer->addTimer(ms, handler);
+        auto task = _timer->addTimer(ms, handler, file, line);
         if (cb) {
             cb(true, task);
         }
         return ;
     }
     
-    async([this, ms, handler, cb](){
-        addTimerTask(ms, handler, cb);
-    }, true, false);
+    async([this, ms, handler, cb, file, line](){
+        addTimerTask(ms, handler, cb, file, line);
+    }, true, false, file, line);
 }
 
-void EventLoop::async(asyncEventFunc func, bool sync, bool front)
+void EventLoop::async(asyncEventFunc func, bool sync, bool front, const char* file, int line)
 {
     // logInfo << "EventLoop::async";
     if (sync && isCurrent()) {
@@ -200,12 +303,17 @@ void EventLoop::async(asyncEventFunc func, bool sync, bool front)
         return ;
     }
 #if 1
+    AsyncTask task;
+    task.func = std::move(func);
+    task.postTime = LoopStatistic::nowUs();
+    task.file = file;
+    task.line = line;
     {
         lock_guard<mutex> lck(_mtxEvents);
         if (front) {
-            _asyncEvents.emplace_front(func);
+            _asyncEvents.emplace_front(std::move(task));
         } else {
-            _asyncEvents.emplace_back(func);
+            _asyncEvents.emplace_back(std::move(task));
         }
     }
 #else
@@ -219,6 +327,7 @@ void EventLoop::async(asyncEventFunc func, bool sync, bool front)
     //写数据到管道,唤醒主线程
     uint64_t  one = 1111;
     ssize_t n = write(_wakeupFd, &one, sizeof(one));
+    _statistic->addSyscall();
     if(n != sizeof(one)) {
         logWarn << "write wakeup Fd failed, n: " << n << ", _wakeupFd: " << _wakeupFd;
     }
@@ -228,6 +337,7 @@ void EventLoop::async(asyncEventFunc func, bool sync, bool front)
 inline void EventLoop::onAsyncEvent()
 {
     uint64_t  startTime = TimeClock::now();
+    uint64_t  startUs = LoopStatistic::nowUs();
     uint64_t  one;
     // ssize_t size = 0;
     // while (true) {
@@ -239,6 +349,7 @@ inline void EventLoop::onAsyncEvent()
     // }
 
     read(_wakeupFd, &one, sizeof(one));
+    _statistic->addSyscall();
 #if 1
     decltype(_asyncEvents) _enventSwap;
     {
@@ -246,12 +357,18 @@ inline void EventLoop::onAsyncEvent()
         _enventSwap.swap(_asyncEvents);
     }
 
-    for (auto& func : _enventSwap) {
+    for (auto& task : _enventSwap) {
+        uint64_t taskStartUs = LoopStatistic::nowUs();
+        _statistic->postHist.record(taskStartUs - task.postTime);
         try {
-            func();
+            task.func();
         } catch (std::exception &ex) {
             logWarn << "do async event failed: " << ex.what();
         }
+        uint64_t costUs = LoopStatistic::nowUs() - taskStartUs;
+        if (_statistic->slowTracer.isSlow(costUs)) {
+            _statistic->slowTracer.record("async", task.file, task.line, costUs);
+        }
     }
 #else
     bool success;
@@ -272,29 +389,37 @@ inline void EventLoop::onAsyncEvent()
     }
 #endif
     _asyncEventDuration = TimeClock::now() - startTime;
+    _statistic->asyncHist.record(LoopStatistic::nowUs() - startUs);
 }
 
-int EventLoop::addEvent(int fd, int event, EventHander::eventCallback cb, void* args)
+int EventLoop::addEvent(int fd, int event, EventHander::eventCallback cb, void* args, const char* file, int line)
 {
     if (!cb) {
         logInfo << "cb is empty" << endl;
         return -1;
     }
     if (isCurrent()) {
+        if (_uring) {
+            return addUringPoll(fd, event, cb, args, file, line);
+        }
         struct epoll_event ev = {0};
         ev.events = event;
         ev.data.fd = fd;
         int ret = epoll_ctl(_epollFd, EPOLL_CTL_ADD, fd, &ev);
+        _statistic->addSyscall();
         if (ret == 0) {
-            _mapHander[fd].callback = cb;
-            _mapHander[fd].args = args;
+            auto& hander = _mapHander[fd];
+            hander.callback = cb;
+            hander.args = args;
+            hander.file = file;
+            hander.line = line;
         }
         return ret;
     }
     
-    async([this, fd, event, cb, args](){
-        addEvent(fd, event, cb, args);
-    }, true, false);
+    async([this, fd, event, cb, args, file, line](){
+        addEvent(fd, event, cb, args, file, line);
+    }, true, false, file, line);
 
     return 0;
 }
@@ -305,6 +430,13 @@ void EventLoop::delEvent(int fd, PollCompleteCB cb) {
     }
 
     if (isCurrent()) {
+        if (_uring) {
+            bool found = cancelUringFd(fd);
+            found = _mapHander.erase(fd) > 0 || found;
+            cb(found);
+            return ;
+        }
+        _statistic->addSyscall();
         if (epoll_ctl(_epollFd, EPOLL_CTL_DEL, fd, nullptr) != 0) {
             cb(false);
             return ;
@@ -326,9 +458,14 @@ void EventLoop::modifyEvent(int fd, int event, PollCompleteCB cb) {
         cb = [](bool success) {};
     }
     if (isCurrent()) {
+        if (_uring) {
+            cb(modifyUringPoll(fd, event));
+            return ;
+        }
         struct epoll_event ev = { 0 };
         ev.events = event;
         ev.data.fd = fd;
+        _statistic->addSyscall();
         if (epoll_ctl(_epollFd, EPOLL_CTL_MOD, fd, &ev) != 0) {
             cb(false);
             return ;
@@ -339,4 +476,377 @@ void EventLoop::modifyEvent(int fd, int event, PollCompleteCB cb) {
     async([this, fd, event, cb]() {
         modifyEvent(fd, event, std::move(const_cast<PollCompleteCB &>(cb)));
     }, true, false);
-}
\ No newline at end of file
+}
+
+#ifdef ENABLE_IO_URING
+
+int EventLoop::addRecv(int fd, bool datagram, const RecvCallback& cb)
+{
+    if (!_uring || !cb) {
+        return -1;
+    }
+    if (!isCurrent()) {
+        async([this, fd, datagram, cb](){
+            addRecv(fd, datagram, cb);
+        }, true);
+        return 0;
+    }
+
+    UringOp op;
+    op.type = datagram ? UringOp::RECVMSG : UringOp::RECV;
+    op.fd = fd;
+    op.multishot = true;
+    op.recvCb = cb;
+    memset(&op.msg, 0, sizeof(op.msg));
+    // 内核按这里的长度在缓冲头部预留地址空间
+    op.msg.msg_namelen = sizeof(struct sockaddr_in6);
+
+    return addUringOp(std::move(op)) ? 0 : -1;
+}
+
+int EventLoop::addAccept(int fd, const ResultCallback& cb)
+{
+    if (!_uring || !cb) {
+        return -1;
+    }
+    if (!isCurrent()) {
+        async([this, fd, cb](){
+            addAccept(fd, cb);
+        }, true);
+        return 0;
+    }
+
+    UringOp op;
+    op.type = UringOp::ACCEPT;
+    op.fd = fd;
+    op.multishot = true;
+    op.resultCb = cb;
+
+    return addUringOp(std::move(op)) ? 0 : -1;
+}
+
+int EventLoop::addSend(int fd, struct msghdr* msg, int flags, bool link, const ResultCallback& cb)
+{
+    if (!_uring || !cb) {
+        return -1;
+    }
+    if (!isCurrent()) {
+        // msghdr拷贝一份，iov指向的数据由cb持有
+        auto copy = *msg;
+        async([this, fd, copy, flags, link, cb]() mutable {
+            addSend(fd, &copy, flags, link, cb);
+        }, true);
+        return 0;
+    }
+
+    UringOp op;
+    op.type = UringOp::SEND;
+    op.fd = fd;
+    op.events = flags;
+    op.link = link;
+    op.resultCb = cb;
+    op.msg = *msg;
+
+    return addUringOp(std::move(op)) ? 0 : -1;
+}
+
+int EventLoop::addUringPoll(int fd, int event, const EventHander::eventCallback& cb, void* args, const char* file, int line)
+{
+    auto it = _mapHander.find(fd);
+    if (it != _mapHander.end() && it->second.opId) {
+        // 和epoll_ctl一致，重复添加失败
+        return -1;
+    }
+
+    UringOp op;
+    op.type = UringOp::POLL;
+    op.fd = fd;
+    op.events = event;
+    op.multishot = !(event & EPOLLONESHOT);
+    auto id = addUringOp(std::move(op));
+    if (!id) {
+        return -1;
+    }
+
+    auto& hander = _mapHander[fd];
+    hander.callback = cb;
+    hander.args = args;
+    hander.file = file;
+    hander.line = line;
+    hander.events = event;
+    hander.opId = id;
+
+    return 0;
+}
+
+bool EventLoop::modifyUringPoll(int fd, int event)
+{
+    auto it = _mapHander.find(fd);
+    if (it == _mapHander.end()) {
+        return false;
+    }
+    auto& hander = it->second;
+    if (hander.events == event && hander.opId) {
+        return true;
+    }
+
+    // poll请求不能修改事件，删掉重新提交
+    if (hander.opId) {
+        cancelUringOp(hander.opId);
+        removeUringFdOp(fd, hander.opId);
+    }
+    UringOp op;
+    op.type = UringOp::POLL;
+    op.fd = fd;
+    op.events = event;
+    op.multishot = !(event & EPOLLONESHOT);
+    hander.events = event;
+    hander.opId = addUringOp(std::move(op));
+
+    return hander.opId != 0;
+}
+
+bool EventLoop::cancelUringFd(int fd)
+{
+    auto it = _uringFdOps.find(fd);
+    if (it == _uringFdOps.end()) {
+        return false;
+    }
+    // 发送请求不取消，关闭前写入的数据仍然发出去
+    for (auto id : it->second) {
+        cancelUringOp(id);
+    }
+    _uringFdOps.erase(it);
+
+    return true;
+}
+
+void EventLoop::removeUringFdOp(int fd, uint64_t id)
+{
+    auto it = _uringFdOps.find(fd);
+    if (it == _uringFdOps.end()) {
+        return ;
+    }
+    auto& ids = it->second;
+    ids.erase(std::remove(ids.begin(), ids.end(), id), ids.end());
+    if (ids.empty()) {
+        _uringFdOps.erase(it);
+    }
+}
+
+uint64_t EventLoop::addUringOp(UringOp&& op)
+{
+    // id递增不复用，旧请求迟到的完成事件不会误投给新请求
+    auto id = ++_uringSeq;
+    auto& stored = _uringOps[id];
+    stored = std::move(op);
+    if (!armUringOp(id, stored)) {
+        _uringOps.erase(id);
+        return 0;
+    }
+    if (stored.type != UringOp::SEND) {
+        _uringFdOps[stored.fd].push_back(id);
+    }
+
+    return id;
+}
+
+bool EventLoop::armUringOp(uint64_t id, UringOp& op)
+{
+    auto sqe = _uring->getSqe();
+    if (!sqe) {
+        return false;
+    }
+
+    sqe->fd = op.fd;
+    sqe->user_data = id;
+    switch (op.type) {
+    case UringOp::POLL:
+        sqe->opcode = IORING_OP_POLL_ADD;
+        // 多发poll每次唤醒都会产生事件，相当于边沿触发
+        sqe->poll32_events = op.events & 0xffff;
+        sqe->len = op.multishot ? IORING_POLL_ADD_MULTI : 0;
+        break;
+    case UringOp::RECV:
+        sqe->opcode = IORING_OP_RECV;
+        sqe->flags = IOSQE_BUFFER_SELECT;
+        sqe->buf_group = _uring->getBufGroup();
+        sqe->ioprio = IORING_RECV_MULTISHOT;
+        break;
+    case UringOp::RECVMSG:
+        sqe->opcode = IORING_OP_RECVMSG;
+        sqe->addr = (uint64_t)&op.msg;
+        sqe->len = 1;
+        sqe->flags = IOSQE_BUFFER_SELECT;
+        sqe->buf_group = _uring->getBufGroup();
+        sqe->ioprio = IORING_RECV_MULTISHOT;
+        break;
+    case UringOp::ACCEPT:
+        sqe->opcode = IORING_OP_ACCEPT;
+        sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+        sqe->accept_flags = SOCK_NONBLOCK | SOCK_CLOEXEC;
+        break;
+    case UringOp::SEND:
+        sqe->opcode = IORING_OP_SENDMSG;
+        sqe->addr = (uint64_t)&op.msg;
+        sqe->len = 1;
+        sqe->msg_flags = op.events;
+        if (op.link) {
+            sqe->flags = IOSQE_IO_LINK;
+        }
+        break;
+    default:
+        break;
+    }
+
+    return true;
+}
+
+void EventLoop::cancelUringOp(uint64_t id)
+{
+    auto it = _uringOps.find(id);
+    if (it == _uringOps.end() || it->second.canceled) {
+        return ;
+    }
+    it->second.canceled = true;
+
+    // 取消成功不产生完成事件，失败的事件user_data为0，直接忽略
+    auto sqe = _uring->getSqe();
+    if (!sqe) {
+        return ;
+    }
+    sqe->opcode = it->second.type == UringOp::POLL ? IORING_OP_POLL_REMOVE : IORING_OP_ASYNC_CANCEL;
+    sqe->fd = -1;
+    sqe->addr = id;
+    sqe->flags = IOSQE_CQE_SKIP_SUCCESS;
+    sqe->user_data = 0;
+}
+
+void EventLoop::waitUring(uint64_t minDelay)
+{
+    // 上一轮归还的接收缓冲和新请求一起交给内核
+    _uring->commitBuffers();
+    _uring->submitAndWait(minDelay);
+
+    auto enterCount = _uring->getEnterCount();
+    _statistic->addSyscall(enterCount - _uringEnterCount);
+    _uringEnterCount = enterCount;
+}
+
+void EventLoop::onUringCqe(uint64_t id, int res, uint32_t flags)
+{
+    bool hasBuffer = flags & IORING_CQE_F_BUFFER;
+    uint16_t bid = flags >> IORING_CQE_BUFFER_SHIFT;
+    auto it = _uringOps.find(id);
+    if (it == _uringOps.end()) {
+        if (hasBuffer) {
+            _uring->recycleBuffer(bid);
+        }
+        return ;
+    }
+
+    // 回调里可能新增请求，节点引用不会失效，迭代器会
+    auto& op = it->second;
+    // 完成式收包的回调和fd事件一样统计，归属位置由Socket在回调里设置
+    bool traced = op.type == UringOp::RECV || op.type == UringOp::RECVMSG;
+    uint64_t startUs = 0;
+    if (traced) {
+        SlowCallbackTracer::setSite(nullptr, 0);
+        startUs = LoopStatistic::nowUs();
+    }
+    if (!op.canceled || op.type == UringOp::SEND) {
+        switch (op.type) {
+        case UringOp::POLL: {
+            auto hander = _mapHander.find(op.fd);
+            if (res > 0 && hander != _mapHander.end() && hander->second.opId == id) {
+                runEvent(hander->second, op.fd, res);
+            }
+            break;
+        }
+        case UringOp::RECV:
+            if (res > 0 && hasBuffer) {
+                op.recvCb(res, _uring->getBuffer(bid), res, nullptr, 0);
+            } else if (res != -ENOBUFS && res != -ECANCELED) {
+                // 对端关闭或出错，接收结束
+                op.canceled = true;
+                op.recvCb(res, nullptr, 0, nullptr, 0);
+            }
+            break;
+        case UringOp::RECVMSG:
+            if (res > 0 && hasBuffer) {
+                auto buffer = _uring->getBuffer(bid);
+                auto out = (io_uring_recvmsg_out*)buffer;
+                auto name = buffer + sizeof(io_uring_recvmsg_out);
+                auto payload = name + op.msg.msg_namelen + op.msg.msg_controllen;
+                int size = min((int)out->payloadlen, (int)(buffer + res - payload));
+                if (out->flags & MSG_TRUNC) {
+                    logWarn << "udp packet truncated, fd: " << op.fd << ", size: " << out->payloadlen;
+                }
+                op.recvCb(size, payload, size, (struct sockaddr*)name, min(out->namelen, op.msg.msg_namelen));
+            } else if (res < 0 && res != -ENOBUFS && res != -ECANCELED) {
+                logWarn << "Recv err on udp socket[" << op.fd << "]: " << strerror(-res);
+            }
+            break;
+        case UringOp::ACCEPT:
+            if (res >= 0) {
+                op.resultCb(res);
+            } else if (res != -ECANCELED) {
+                logWarn << "accept error: " << strerror(-res);
+            }
+            break;
+        case UringOp::SEND:
+            op.resultCb(res);
+            break;
+        default:
+            break;
+        }
+    }
+    if (traced) {
+        uint64_t costUs = LoopStatistic::nowUs() - startUs;
+        _statistic->eventHist.record(costUs);
+        if (_statistic->slowTracer.isSlow(costUs)) {
+            const char* file = nullptr;
+            int line = 0;
+            SlowCallbackTracer::getSite(file, line);
+            _statistic->slowTracer.record("event", file, line, costUs);
+        }
+    }
+    if (hasBuffer) {
+        _uring->recycleBuffer(bid);
+    }
+    if (flags & IORING_CQE_F_MORE) {
+        return ;
+    }
+
+    // 多发请求被内核结束(缓冲耗尽、连接数超限等)，重新提交
+    if (!op.canceled && op.multishot) {
+        if (op.type == UringOp::ACCEPT && (res == -EMFILE || res == -ENFILE)) {
+            addTimerTask(100, [this, id](){
+                auto it = _uringOps.find(id);
+                if (it != _uringOps.end() && (it->second.canceled || !armUringOp(id, it->second))) {
+                    removeUringFdOp(it->second.fd, id);
+                    _uringOps.erase(it);
+                }
+                return 0;
+            }, nullptr);
+            return ;
+        }
+        if (armUringOp(id, op)) {
+            return ;
+        }
+    }
+    removeUringFdOp(op.fd, id);
+    _uringOps.erase(id);
+}
+
+#else
+
+int EventLoop::addRecv(int fd, bool datagram, const RecvCallback& cb) {return -1;}
+int EventLoop::addAccept(int fd, const ResultCallback& cb) {return -1;}
+int EventLoop::addSend(int fd, struct msghdr* msg, int flags, bool link, const ResultCallback& cb) {return -1;}
+int EventLoop::addUringPoll(int fd, int event, const EventHander::eventCallback& cb, void* args, const char* file, int line) {return -1;}
+bool EventLoop::modifyUringPoll(int fd, int event) {return false;}
+bool EventLoop::cancelUringFd(int fd) {return false;}
+void EventLoop::waitUring(uint64_t minDelay) {}
+
+#endif //ENABLE_IO_URING
@@ -10,8 +10,11 @@
 #include <unordered_map>
 #include <iostream>
 #include <vector>
+#include <atomic>
+#include <sys/socket.h>
 
 #include "Timer.h"
+#include "LoopStatistic.h"
 #include "ReadWriteQueue/atomicops.h"
 #include "ReadWriteQueue/readerwriterqueue.h"
 
@@ -23,6 +26,45 @@ public:
     using eventCallback = function<void(int event, void* args)>;
     eventCallback callback;
     void* args;
+    // 注册位置，用于慢回调追踪
+    const char* file = nullptr;
+    int line = 0;
+    // io_uring后端下对应的poll请求
+    int events = 0;
+    uint64_t opId = 0;
+};
+
+// io_uring后端的一个请求，user_data为请求id，最后一个完成事件到达后才释放
+class UringOp {
+public:
+    enum Type {
+        POLL,
+        RECV,
+        RECVMSG,
+        ACCEPT,
+        SEND
+    };
+
+    int type = POLL;
+    int fd = -1;
+    int events = 0;
+    bool multishot = false;
+    bool link = false;
+    bool canceled = false;
+    function<void(int res, char* data, int size, struct sockaddr* addr, int addrLen)> recvCb;
+    function<void(int res)> resultCb;
+    // 多发recvmsg期间内核一直引用
+    struct msghdr msg;
+};
+
+class IoUring;
+
+class AsyncTask {
+public:
+    function<void()> func;
+    uint64_t postTime = 0;
+    const char* file = nullptr;
+    int line = 0;
 };
 
 class EventLoop : public std::enable_shared_from_this<EventLoop> {
@@ -31,12 +73,20 @@ public:
     using asyncEventFunc = function<void()>;
     using PollCompleteCB = std::function<void(bool success)>;
     using TaskCompleteCB = std::function<void (bool success, shared_ptr<TimerTask>)>;
+    using RecvCallback = function<void(int res, char* data, int size, struct sockaddr* addr, int addrLen)>;
+    using ResultCallback = function<void(int res)>;
 
     EventLoop();
     ~EventLoop();
 
+protected:
+    // 派生的loop不使用epoll/io_uring时传false
+    explicit EventLoop(bool uring);
+
 public:
     static EventLoop::Ptr getCurrentLoop();
+    // 事件后端，需在创建loop之前设置: epoll, io_uring, auto(内核支持时使用io_uring)
+    static void setBackend(const string& backend);
 
 public:
     virtual void start();
@@ -44,11 +94,15 @@ public:
 
     virtual bool isCurrent();
     virtual void onAsyncEvent();
-    virtual void async(asyncEventFunc func, bool sync, bool front = false);
+    // file和line默认取调用处的位置，用于慢回调追踪
+    virtual void async(asyncEventFunc func, bool sync, bool front = false,
+                        const char* file = __builtin_FILE(), int line = __builtin_LINE());
 
-    virtual void addTimerTask(uint64_t ms, const TimerTask::timerHander &handler, TaskCompleteCB cb);
+    virtual void addTimerTask(uint64_t ms, const TimerTask::timerHander &handler, TaskCompleteCB cb,
+                        const char* file = __builtin_FILE(), int line = __builtin_LINE());
 
-    virtual int addEvent(int fd, int event, EventHander::eventCallback cb, void* args = nullptr);
+    virtual int addEvent(int fd, int event, EventHander::eventCallback cb, void* args = nullptr,
+                        const char* file = __builtin_FILE(), int line = __builtin_LINE());
     virtual void delEvent(int fd, PollCompleteCB cb);
     virtual void modifyEvent(int fd, int event, PollCompleteCB cb);
 
@@ -62,6 +116,40 @@ public:
     virtual void setEpollID(int id) {_epollID = id;}
     virtual int getEpollID() {return _epollID;}
 
+    LoopStatistic::Ptr getStatistic() {return _statistic;}
+    void addSyscall(uint64_t count = 1) {_statistic->addSyscall(count);}
+
+    // 以下接口只在io_uring后端、loop线程内使用，loop启动后才能确定是否使用io_uring
+    bool isUring() {return _uring != nullptr;}
+    // 多发接收，收到的数据在回调返回后归还给内核；res<=0时接收结束，不会再回调
+    int addRecv(int fd, bool datagram, const RecvCallback& cb);
+    // 多发accept，res为新连接的fd
+    int addAccept(int fd, const ResultCallback& cb);
+    // 异步发送，msg及其引用的数据在回调之前必须有效；link为true时和下一个发送串联，保证先后顺序
+    int addSend(int fd, struct msghdr* msg, int flags, bool link, const ResultCallback& cb);
+
+    // 负载均衡使用的统计，可跨线程读取
+    void addBytes(uint64_t bytes) {_totalBytes.fetch_add(bytes, std::memory_order_relaxed);}
+    void addConnection(int num) {_connCount.fetch_add(num, std::memory_order_relaxed);}
+    int getConnCount() {return _connCount.load(std::memory_order_relaxed);}
+    // 最近一段时间运行时长占比，千分比
+    int getLoadPermille() {return _loadPermille.load(std::memory_order_relaxed);}
+    // 最近一段时间收发字节速率, byte/s
+    uint64_t getByteRate() {return _byteRate.load(std::memory_order_relaxed);}
+
+private:
+    void runEvent(const EventHander& hander, int fd, int event);
+
+    int addUringPoll(int fd, int event, const EventHander::eventCallback& cb, void* args, const char* file, int line);
+    bool modifyUringPoll(int fd, int event);
+    bool cancelUringFd(int fd);
+    void waitUring(uint64_t minDelay);
+    void onUringCqe(uint64_t id, int res, uint32_t flags);
+    uint64_t addUringOp(UringOp&& op);
+    bool armUringOp(uint64_t id, UringOp& op);
+    void cancelUringOp(uint64_t id);
+    void removeUringFdOp(int fd, uint64_t id);
+
 private:
     bool _quit =false;
     bool _eventRun = false;
@@ -85,10 +173,27 @@ private:
     std::thread* _loopThread = nullptr;
     std::mutex _mtxEvents;
     Timer::Ptr _timer;
-    std::list<asyncEventFunc> _asyncEvents;
+    std::list<AsyncTask> _asyncEvents;
     unordered_map<int, EventHander> _mapHander;
+    LoopStatistic::Ptr _statistic;
+
+    uint64_t _windowStartUs = 0;
+    uint64_t _windowWaitUs = 0;
+    uint64_t _windowBytes = 0;
+    std::atomic<int> _connCount{0};
+    std::atomic<int> _loadPermille{0};
+    std::atomic<uint64_t> _byteRate{0};
+    std::atomic<uint64_t> _totalBytes{0};
 
     std::vector<shared_ptr<ReaderWriterQueue<asyncEventFunc>>> _asyncQueues;
+
+    bool _useUring = false;
+    shared_ptr<IoUring> _uring;
+    uint64_t _uringSeq = 0;
+    uint64_t _uringEnterCount = 0;
+    unordered_map<uint64_t, UringOp> _uringOps;
+    // fd上未结束的poll/recv/accept请求，删除事件时取消
+    unordered_map<int, vector<uint64_t>> _uringFdOps;
 };
 
 #endif //EventLoop_h
\ No newline at end of file
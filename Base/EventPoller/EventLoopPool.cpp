@@ -11,6 +11,9 @@
 #include "EventLoopPool.h"
 #include "Log/Logger.h"
 
+#include <algorithm>
+#include <climits>
+
 using namespace std;
 
 EventLoopPool::EventLoopPool()
@@ -63,7 +66,84 @@ void EventLoopPool::for_each_loop(const function<void(const EventLoop::Ptr &)> &
 
 EventLoop::Ptr EventLoopPool::getLoopByCircle()
 {
-    return _loops[_index++ % _threadSize];
+    return _loops[_index.fetch_add(1, std::memory_order_relaxed) % _threadSize];
+}
+
+int EventLoopPool::getLoopScore(const EventLoop::Ptr& loop, int maxConn, uint64_t maxByteRate)
+{
+    int connScore = maxConn > 0 ? loop->getConnCount() * 1000 / maxConn : 0;
+    int byteScore = maxByteRate > 0 ? loop->getByteRate() * 1000 / maxByteRate : 0;
+
+    // 运行占比最直接反映loop的繁忙程度，权重最大
+    return (loop->getLoadPermille() * 2 + connScore + byteScore) / 4;
+}
+
+int EventLoopPool::getLoopScore(const EventLoop::Ptr& loop)
+{
+    int maxConn = 0;
+    uint64_t maxByteRate = 0;
+    for (auto& item : _loops) {
+        maxConn = std::max(maxConn, item->getConnCount());
+        maxByteRate = std::max(maxByteRate, item->getByteRate());
+    }
+
+    return getLoopScore(loop, maxConn, maxByteRate);
+}
+
+EventLoop::Ptr EventLoopPool::getLoopByLoad(const EventLoop::Ptr& prefer)
+{
+    int maxConn = 0;
+    uint64_t maxByteRate = 0;
+    for (auto& loop : _loops) {
+        maxConn = std::max(maxConn, loop->getConnCount());
+        maxByteRate = std::max(maxByteRate, loop->getByteRate());
+    }
+
+    EventLoop::Ptr minLoop;
+    int minScore = INT_MAX;
+    // 从轮询位置开始遍历，评分相同时分散到不同loop
+    uint32_t start = _index.fetch_add(1, std::memory_order_relaxed) % _threadSize;
+    for (int i = 0; i < _threadSize; ++i) {
+        auto& loop = _loops[(start + i) % _threadSize];
+        int score = getLoopScore(loop, maxConn, maxByteRate);
+        if (score < minScore) {
+            minScore = score;
+            minLoop = loop;
+        }
+    }
+
+    if (prefer && getLoopScore(prefer, maxConn, maxByteRate) <= minScore + _balanceSlack) {
+        return prefer;
+    }
+
+    return minLoop;
+}
+
+EventLoop::Ptr EventLoopPool::getMigrateTarget(const EventLoop::Ptr& from)
+{
+    if (!from || _migrateThreshold <= 0 || _balancePolicy != BALANCE_LOAD) {
+        return nullptr;
+    }
+
+    auto target = getLoopByLoad();
+    if (!target || target == from) {
+        return nullptr;
+    }
+
+    if (getLoopScore(from) - getLoopScore(target) < _migrateThreshold) {
+        return nullptr;
+    }
+
+    return target;
+}
+
+EventLoop::Ptr EventLoopPool::getLoopForSession(const EventLoop::Ptr& prefer)
+{
+    if (_balancePolicy == BALANCE_LOAD) {
+        return getLoopByLoad(prefer);
+    }
+
+    return prefer ? prefer : getLoopByCircle();
 }
 
 int EventLoopPool::getStartTime()
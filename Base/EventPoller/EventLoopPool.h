@@ -2,9 +2,16 @@
 #define EventLoopPool_h
 
 #include <vector>
+#include <atomic>
 #include "EventLoop.h"
 #include "SrtEventLoop.h"
 
+enum LoopBalancePolicy {
+    // 新连接留在接收的loop上(tcp由内核reuseport决定，udp由收包的loop决定)
+    BALANCE_NONE = 0,
+    // 根据loop的运行占比、字节速率、连接数选择
+    BALANCE_LOAD = 1
+};
 
 class EventLoopPool : public std::enable_shared_from_this<EventLoopPool> {
 public:
@@ -16,12 +23,34 @@ public:
     void init(int size, int priority, bool affinity);
     void for_each_loop(const function<void(const EventLoop::Ptr &)> &cb, int count = 0);
     EventLoop::Ptr getLoopByCircle();
+    // 选择负载最低的loop，prefer的负载与最低负载相差不超过slack时，优先使用prefer，避免无谓的线程切换
+    EventLoop::Ptr getLoopByLoad(const EventLoop::Ptr& prefer = nullptr);
+    // 按当前策略为新会话选择loop
+    EventLoop::Ptr getLoopForSession(const EventLoop::Ptr& prefer);
+    // 负载评分，千分比，越大越忙
+    int getLoopScore(const EventLoop::Ptr& loop);
+    // from比最闲的loop评分高出migrateThreshold时返回迁移目标，否则返回空
+    EventLoop::Ptr getMigrateTarget(const EventLoop::Ptr& from);
     int getThreadSize() {return _threadSize;}
     int getStartTime();
 
+    void setBalancePolicy(int policy) {_balancePolicy = policy;}
+    int getBalancePolicy() {return _balancePolicy;}
+    void setBalanceSlack(int permille) {_balanceSlack = permille;}
+    void setMigrateThreshold(int permille) {_migrateThreshold = permille;}
+    int getMigrateThreshold() {return _migrateThreshold;}
+
+protected:
+    int getLoopScore(const EventLoop::Ptr& loop, int maxConn, uint64_t maxByteRate);
+
 protected:
     std::vector<EventLoop::Ptr> _loops;
-    int _index = 0;
+    // 多个线程同时取loop
+    std::atomic<uint32_t> _index{0};
+    int _balancePolicy = BALANCE_NONE;
+    int _balanceSlack = 100;
+    // 大于0时开启会话迁移，最忙和最闲的loop评分差超过该值时迁移
+    int _migrateThreshold = 0;
     int _threadSize = 0;
     int _startTime = 0;
 };
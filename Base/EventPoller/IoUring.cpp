@@ -0,0 +1,303 @@
+#ifdef ENABLE_IO_URING
+
+#include "IoUring.h"
+#include "Log/Logger.h"
+
+#include <atomic>
+#include <cstring>
+#include <csignal>
+#include <cstdlib>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/utsname.h>
+
+using namespace std;
+
+static inline unsigned loadAcquire(unsigned* p)
+{
+    return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+static inline void storeRelease(unsigned* p, unsigned v)
+{
+    __atomic_store_n(p, v, __ATOMIC_RELEASE);
+}
+
+IoUring::IoUring()
+{}
+
+IoUring::~IoUring()
+{
+    if (_bufRing) {
+        munmap(_bufRing, _bufRingSize);
+    }
+    if (_bufBase) {
+        free(_bufBase);
+    }
+    if (_sqes) {
+        munmap(_sqes, _sqesSize);
+    }
+    if (_cqRing && _cqRing != _sqRing) {
+        munmap(_cqRing, _cqRingSize);
+    }
+    if (_sqRing) {
+        munmap(_sqRing, _sqRingSize);
+    }
+    if (_fd >= 0) {
+        close(_fd);
+    }
+}
+
+bool IoUring::isSupported()
+{
+    // 多个loop线程同时启动，局部静态变量保证只探测一次
+    static bool supported = probe();
+    return supported;
+}
+
+bool IoUring::probe()
+{
+    // 多发recv需要6.0
+    struct utsname name;
+    int major = 0, minor = 0;
+    if (uname(&name) != 0 || sscanf(name.release, "%d.%d", &major, &minor) != 2 || major < 6) {
+        logInfo << "io_uring needs kernel 6.0+";
+        return false;
+    }
+
+    IoUring ring;
+    if (!ring.init(8, 8, 4096)) {
+        return false;
+    }
+    if (!(ring._features & IORING_FEAT_EXT_ARG) || !(ring._features & IORING_FEAT_NODROP)) {
+        logInfo << "io_uring lacks ext arg or nodrop";
+        return false;
+    }
+
+    size_t probeSize = sizeof(io_uring_probe) + 256 * sizeof(io_uring_probe_op);
+    auto probe = (io_uring_probe*)calloc(1, probeSize);
+    int ret = syscall(__NR_io_uring_register, ring._fd, IORING_REGISTER_PROBE, probe, 256);
+    bool ok = ret == 0;
+    for (int op : {IORING_OP_POLL_ADD, IORING_OP_POLL_REMOVE, IORING_OP_RECV, IORING_OP_RECVMSG,
+                    IORING_OP_SENDMSG, IORING_OP_ACCEPT, IORING_OP_ASYNC_CANCEL}) {
+        ok = ok && op <= probe->last_op && (probe->ops[op].flags & IO_URING_OP_SUPPORTED);
+    }
+    free(probe);
+    if (!ok) {
+        logInfo << "io_uring lacks required ops";
+        return false;
+    }
+
+    return true;
+}
+
+bool IoUring::init(unsigned entries, unsigned bufCount, unsigned bufSize)
+{
+    io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    // 不能用COOP_TASKRUN，loop阻塞等待时异步完成的发送不会唤醒它
+    params.flags = IORING_SETUP_CQSIZE | IORING_SETUP_SUBMIT_ALL;
+    // 大量连接同时收包时cq比sq更容易满
+    params.cq_entries = entries * 4;
+    _fd = syscall(__NR_io_uring_setup, entries, &params);
+    if (_fd < 0) {
+        memset(&params, 0, sizeof(params));
+        params.flags = IORING_SETUP_CQSIZE;
+        params.cq_entries = entries * 4;
+        _fd = syscall(__NR_io_uring_setup, entries, &params);
+    }
+    if (_fd < 0) {
+        logWarn << "io_uring_setup failed: " << strerror(errno);
+        return false;
+    }
+    _features = params.features;
+
+    _sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    _cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    if (_features & IORING_FEAT_SINGLE_MMAP) {
+        _sqRingSize = _cqRingSize = max(_sqRingSize, _cqRingSize);
+    }
+    _sqRing = mmap(nullptr, _sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _fd, IORING_OFF_SQ_RING);
+    if (_sqRing == MAP_FAILED) {
+        _sqRing = nullptr;
+        return false;
+    }
+    if (_features & IORING_FEAT_SINGLE_MMAP) {
+        _cqRing = _sqRing;
+    } else {
+        _cqRing = mmap(nullptr, _cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _fd, IORING_OFF_CQ_RING);
+        if (_cqRing == MAP_FAILED) {
+            _cqRing = nullptr;
+            return false;
+        }
+    }
+    _sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+    _sqes = (io_uring_sqe*)mmap(nullptr, _sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _fd, IORING_OFF_SQES);
+    if (_sqes == MAP_FAILED) {
+        _sqes = nullptr;
+        return false;
+    }
+
+    auto sq = (char*)_sqRing;
+    _sqHead = (unsigned*)(sq + params.sq_off.head);
+    _sqTail = (unsigned*)(sq + params.sq_off.tail);
+    _sqMask = *(unsigned*)(sq + params.sq_off.ring_mask);
+    _sqEntries = params.sq_entries;
+    _sqeTail = *_sqTail;
+    // sqe按顺序使用，array固定为一一对应
+    auto array = (unsigned*)(sq + params.sq_off.array);
+    for (unsigned i = 0; i < _sqEntries; ++i) {
+        array[i] = i;
+    }
+
+    auto cq = (char*)_cqRing;
+    _cqHead = (unsigned*)(cq + params.cq_off.head);
+    _cqTail = (unsigned*)(cq + params.cq_off.tail);
+    _cqMask = *(unsigned*)(cq + params.cq_off.ring_mask);
+    _cqes = (io_uring_cqe*)(cq + params.cq_off.cqes);
+
+    return setupBufRing(bufCount, bufSize);
+}
+
+bool IoUring::setupBufRing(unsigned bufCount, unsigned bufSize)
+{
+    // 个数必须是2的幂
+    _bufCount = 1;
+    while (_bufCount < bufCount && _bufCount < 32768) {
+        _bufCount <<= 1;
+    }
+    _bufSize = bufSize;
+
+    _bufRingSize = _bufCount * sizeof(io_uring_buf);
+    _bufRing = (io_uring_buf_ring*)mmap(nullptr, _bufRingSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (_bufRing == MAP_FAILED) {
+        _bufRing = nullptr;
+        return false;
+    }
+    if (posix_memalign((void**)&_bufBase, 4096, (size_t)_bufCount * _bufSize) != 0) {
+        _bufBase = nullptr;
+        return false;
+    }
+
+    io_uring_buf_reg reg;
+    memset(&reg, 0, sizeof(reg));
+    reg.ring_addr = (uint64_t)_bufRing;
+    reg.ring_entries = _bufCount;
+    reg.bgid = _bufGroup;
+    if (syscall(__NR_io_uring_register, _fd, IORING_REGISTER_PBUF_RING, &reg, 1) != 0) {
+        logWarn << "register buffer ring failed: " << strerror(errno);
+        return false;
+    }
+
+    for (unsigned i = 0; i < _bufCount; ++i) {
+        recycleBuffer(i);
+    }
+    commitBuffers();
+
+    return true;
+}
+
+void IoUring::recycleBuffer(uint16_t bid)
+{
+    // c++下头文件里的柔性数组bufs会偏移8字节，直接按ring起始地址取
+    auto& buf = ((io_uring_buf*)_bufRing)[_bufTail & (_bufCount - 1)];
+    buf.addr = (uint64_t)getBuffer(bid);
+    buf.len = _bufSize;
+    buf.bid = bid;
+    ++_bufTail;
+}
+
+void IoUring::commitBuffers()
+{
+    __atomic_store_n(&_bufRing->tail, _bufTail, __ATOMIC_RELEASE);
+}
+
+io_uring_sqe* IoUring::getSqe()
+{
+    if (_sqeTail - loadAcquire(_sqHead) >= _sqEntries) {
+        submit();
+        if (_sqeTail - loadAcquire(_sqHead) >= _sqEntries) {
+            logWarn << "io_uring sq full";
+            return nullptr;
+        }
+    }
+
+    auto sqe = &_sqes[_sqeTail & _sqMask];
+    memset(sqe, 0, sizeof(*sqe));
+    ++_sqeTail;
+
+    return sqe;
+}
+
+int IoUring::enter(unsigned toSubmit, unsigned minComplete, unsigned flags, void* arg, size_t argSize)
+{
+    ++_enterCount;
+    int ret;
+    do {
+        ret = syscall(__NR_io_uring_enter, _fd, toSubmit, minComplete, flags, arg, argSize);
+    } while (ret < 0 && errno == EINTR);
+
+    return ret;
+}
+
+int IoUring::submit()
+{
+    unsigned toSubmit = _sqeTail - *_sqTail;
+    if (toSubmit == 0) {
+        return 0;
+    }
+    storeRelease(_sqTail, _sqeTail);
+
+    return enter(toSubmit, 0, 0, nullptr, 0);
+}
+
+int IoUring::submitAndWait(uint64_t timeoutMs)
+{
+    unsigned toSubmit = _sqeTail - *_sqTail;
+    storeRelease(_sqTail, _sqeTail);
+
+    // 已经有完成事件时不等待
+    unsigned minComplete = loadAcquire(_cqTail) == *_cqHead ? 1 : 0;
+    if (minComplete == 0 && toSubmit == 0) {
+        return 0;
+    }
+
+    struct __kernel_timespec ts;
+    io_uring_getevents_arg arg;
+    memset(&arg, 0, sizeof(arg));
+    arg.sigmask_sz = _NSIG / 8;
+    if (timeoutMs) {
+        ts.tv_sec = timeoutMs / 1000;
+        ts.tv_nsec = (timeoutMs % 1000) * 1000000;
+        arg.ts = (uint64_t)&ts;
+    }
+
+    int ret = enter(toSubmit, minComplete, IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg, sizeof(arg));
+    if (ret < 0 && errno != ETIME) {
+        logWarn << "io_uring_enter failed: " << strerror(errno);
+    }
+
+    return ret;
+}
+
+int IoUring::forEachCqe(const function<void(io_uring_cqe* cqe)>& cb)
+{
+    int count = 0;
+    unsigned head = *_cqHead;
+    unsigned tail = loadAcquire(_cqTail);
+    while (head != tail) {
+        // 先拷贝再归还槽位，回调里可能提交新的请求
+        io_uring_cqe cqe = _cqes[head & _cqMask];
+        storeRelease(_cqHead, ++head);
+        cb(&cqe);
+        ++count;
+        if (head == tail) {
+            tail = loadAcquire(_cqTail);
+        }
+    }
+
+    return count;
+}
+
+#endif //ENABLE_IO_URING
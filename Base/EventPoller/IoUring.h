@@ -0,0 +1,85 @@
+#ifndef IoUring_h
+#define IoUring_h
+
+#ifdef ENABLE_IO_URING
+
+#include <cstdint>
+#include <functional>
+#include <linux/io_uring.h>
+
+using namespace std;
+
+// io_uring的最小封装，直接使用系统调用，不依赖liburing
+// 只在所属loop线程内使用，不加锁
+// 接收使用provided buffer ring，内核收包时自己挑选空闲缓冲，用完后由上层归还
+class IoUring
+{
+public:
+    IoUring();
+    ~IoUring();
+
+public:
+    // 内核是否支持loop需要的全部能力(多发recv/accept，buffer ring，等待超时参数)，结果缓存
+    static bool isSupported();
+
+    bool init(unsigned entries, unsigned bufCount, unsigned bufSize);
+
+    // sq满时先提交一次，仍然拿不到返回nullptr
+    io_uring_sqe* getSqe();
+    // 只提交不等待
+    int submit();
+    // 提交并等待至少一个完成事件，timeoutMs为0时一直等待
+    int submitAndWait(uint64_t timeoutMs);
+    // 遍历已完成的事件，回调里可以继续getSqe
+    int forEachCqe(const function<void(io_uring_cqe* cqe)>& cb);
+
+    uint16_t getBufGroup() {return _bufGroup;}
+    char* getBuffer(uint16_t bid) {return _bufBase + (size_t)bid * _bufSize;}
+    unsigned getBufSize() {return _bufSize;}
+    // 归还缓冲，commitBuffers之后内核才可见
+    void recycleBuffer(uint16_t bid);
+    void commitBuffers();
+
+    uint64_t getEnterCount() {return _enterCount;}
+
+private:
+    static bool probe();
+    int enter(unsigned toSubmit, unsigned minComplete, unsigned flags, void* arg, size_t argSize);
+    bool setupBufRing(unsigned bufCount, unsigned bufSize);
+
+private:
+    int _fd = -1;
+    unsigned _features = 0;
+    uint64_t _enterCount = 0;
+
+    void* _sqRing = nullptr;
+    size_t _sqRingSize = 0;
+    void* _cqRing = nullptr;
+    size_t _cqRingSize = 0;
+    io_uring_sqe* _sqes = nullptr;
+    size_t _sqesSize = 0;
+
+    unsigned* _sqHead = nullptr;
+    unsigned* _sqTail = nullptr;
+    unsigned _sqMask = 0;
+    unsigned _sqEntries = 0;
+    // 本地的sq尾，submit时才写回内核
+    unsigned _sqeTail = 0;
+
+    unsigned* _cqHead = nullptr;
+    unsigned* _cqTail = nullptr;
+    unsigned _cqMask = 0;
+    io_uring_cqe* _cqes = nullptr;
+
+    uint16_t _bufGroup = 0;
+    unsigned _bufCount = 0;
+    unsigned _bufSize = 0;
+    uint16_t _bufTail = 0;
+    char* _bufBase = nullptr;
+    io_uring_buf_ring* _bufRing = nullptr;
+    size_t _bufRingSize = 0;
+};
+
+#endif //ENABLE_IO_URING
+
+#endif //IoUring_h
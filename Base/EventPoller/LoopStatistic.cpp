@@ -0,0 +1,161 @@
+#include "LoopStatistic.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <time.h>
+#include <cxxabi.h>
+
+using namespace std;
+
+static thread_local const char* g_siteFile = nullptr;
+static thread_local int g_siteLine = 0;
+
+static inline int getBucketIndex(uint64_t us)
+{
+    if (us == 0) {
+        return 0;
+    }
+    int index = 64 - __builtin_clzll(us);
+    return index < LatencyHistogram::kBucketNum ? index : LatencyHistogram::kBucketNum - 1;
+}
+
+LatencyHistogram::LatencyHistogram()
+{
+    reset();
+}
+
+void LatencyHistogram::record(uint64_t us)
+{
+    _buckets[getBucketIndex(us)].fetch_add(1, memory_order_relaxed);
+    _count.fetch_add(1, memory_order_relaxed);
+    _sum.fetch_add(us, memory_order_relaxed);
+    // 只有loop线程写，不需要cas
+    if (us > _max.load(memory_order_relaxed)) {
+        _max.store(us, memory_order_relaxed);
+    }
+}
+
+void LatencyHistogram::reset()
+{
+    _count.store(0, memory_order_relaxed);
+    _sum.store(0, memory_order_relaxed);
+    _max.store(0, memory_order_relaxed);
+    for (int i = 0; i < kBucketNum; ++i) {
+        _buckets[i].store(0, memory_order_relaxed);
+    }
+}
+
+uint64_t LatencyHistogram::bucketUpperBound(int index)
+{
+    if (index == 0) {
+        return 0;
+    }
+    return (1ULL << index) - 1;
+}
+
+uint64_t LatencyHistogram::percentile(double ratio) const
+{
+    uint64_t total = count();
+    if (total == 0) {
+        return 0;
+    }
+
+    uint64_t target = total * ratio;
+    if (target >= total) {
+        target = total - 1;
+    }
+
+    uint64_t seen = 0;
+    for (int i = 0; i < kBucketNum; ++i) {
+        seen += bucket(i);
+        if (seen > target) {
+            return std::min(bucketUpperBound(i), max());
+        }
+    }
+
+    return max();
+}
+
+///////////////////////////////////////////////////////////
+
+SlowCallbackTracer::SlowCallbackTracer(int topN, uint64_t thresholdUs)
+    :_topN(topN)
+    ,_threshold(thresholdUs)
+    ,_slowCount(0)
+{}
+
+void SlowCallbackTracer::record(const char* type, const char* file, int line, uint64_t us)
+{
+    _slowCount.fetch_add(1, memory_order_relaxed);
+
+    lock_guard<mutex> lck(_mtx);
+    if (_top.size() >= (size_t)_topN && _top.back().duration >= us) {
+        return ;
+    }
+
+    SlowCallbackInfo info;
+    info.type = type;
+    if (file && line == 0) {
+        int status = 0;
+        char* name = abi::__cxa_demangle(file, nullptr, nullptr, &status);
+        info.site = status == 0 && name ? name : file;
+        free(name);
+    } else {
+        info.site = string(file ? file : "unknown") + ":" + to_string(line);
+    }
+    info.duration = us;
+    info.time = time(nullptr);
+
+    auto it = std::upper_bound(_top.begin(), _top.end(), info, [](const SlowCallbackInfo& lhs, const SlowCallbackInfo& rhs){
+        return lhs.duration > rhs.duration;
+    });
+    _top.insert(it, std::move(info));
+    if (_top.size() > (size_t)_topN) {
+        _top.pop_back();
+    }
+}
+
+void SlowCallbackTracer::setSite(const char* file, int line)
+{
+    g_siteFile = file;
+    g_siteLine = line;
+}
+
+void SlowCallbackTracer::getSite(const char*& file, int& line)
+{
+    file = g_siteFile;
+    line = g_siteLine;
+}
+
+vector<SlowCallbackInfo> SlowCallbackTracer::getTop()
+{
+    lock_guard<mutex> lck(_mtx);
+    return _top;
+}
+
+void SlowCallbackTracer::reset()
+{
+    _slowCount.store(0, memory_order_relaxed);
+    lock_guard<mutex> lck(_mtx);
+    _top.clear();
+}
+
+///////////////////////////////////////////////////////////
+
+uint64_t LoopStatistic::nowUs()
+{
+    struct timespec ti;
+    clock_gettime(CLOCK_MONOTONIC, &ti);
+    return (uint64_t)ti.tv_sec * 1000000 + ti.tv_nsec / 1000;
+}
+
+void LoopStatistic::reset()
+{
+    waitHist.reset();
+    eventHist.reset();
+    asyncHist.reset();
+    timerHist.reset();
+    postHist.reset();
+    slowTracer.reset();
+    syscalls.store(0, memory_order_relaxed);
+}
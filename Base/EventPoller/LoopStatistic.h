@@ -0,0 +1,112 @@
+#ifndef LoopStatistic_h
+#define LoopStatistic_h
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <typeinfo>
+
+using namespace std;
+
+// 按2的幂分桶的延迟直方图(单位:微秒)，只由loop线程写，api线程读
+// 桶i统计 [2^(i-1), 2^i) 微秒的样本，最后一个桶收集所有溢出的样本
+class LatencyHistogram
+{
+public:
+    static const int kBucketNum = 32;
+
+    LatencyHistogram();
+    ~LatencyHistogram() = default;
+
+public:
+    void record(uint64_t us);
+    void reset();
+
+    uint64_t count() const {return _count.load(memory_order_relaxed);}
+    uint64_t sum() const {return _sum.load(memory_order_relaxed);}
+    uint64_t max() const {return _max.load(memory_order_relaxed);}
+    uint64_t bucket(int index) const {return _buckets[index].load(memory_order_relaxed);}
+    // 返回对应百分位所在桶的上边界
+    uint64_t percentile(double ratio) const;
+
+    static uint64_t bucketUpperBound(int index);
+
+private:
+    atomic<uint64_t> _count;
+    atomic<uint64_t> _sum;
+    atomic<uint64_t> _max;
+    atomic<uint64_t> _buckets[kBucketNum];
+};
+
+class SlowCallbackInfo
+{
+public:
+    string type;
+    string site;
+    uint64_t duration = 0;
+    uint64_t time = 0;
+};
+
+// 记录最慢的N个回调及其注册位置
+class SlowCallbackTracer
+{
+public:
+    SlowCallbackTracer(int topN = 16, uint64_t thresholdUs = 10000);
+    ~SlowCallbackTracer() = default;
+
+public:
+    bool isSlow(uint64_t us) const {return us >= _threshold.load(memory_order_relaxed);}
+    // line为0时file是类型名(type_info::name)，记录时转成可读的类名
+    void record(const char* type, const char* file, int line, uint64_t us);
+    void setThreshold(uint64_t us) {_threshold.store(us, memory_order_relaxed);}
+    uint64_t getThreshold() const {return _threshold.load(memory_order_relaxed);}
+    uint64_t getSlowCount() const {return _slowCount.load(memory_order_relaxed);}
+    vector<SlowCallbackInfo> getTop();
+    void reset();
+
+    // 当前线程正在执行的fd回调的归属位置，loop在回调前设为注册位置，
+    // 通用的注册处(如Socket)在回调里改成实际的模块，慢回调按这个位置记录
+    static void setSite(const char* file, int line);
+    static void setOwnerSite(const std::type_info& type) {setSite(type.name(), 0);}
+    static void getSite(const char*& file, int& line);
+
+private:
+    int _topN;
+    atomic<uint64_t> _threshold;
+    atomic<uint64_t> _slowCount;
+    mutex _mtx;
+    // 按耗时从大到小排序
+    vector<SlowCallbackInfo> _top;
+};
+
+class LoopStatistic
+{
+public:
+    using Ptr = shared_ptr<LoopStatistic>;
+
+    // 单调时钟，微秒
+    static uint64_t nowUs();
+
+    void reset();
+    void addSyscall(uint64_t count = 1) {syscalls.fetch_add(count, memory_order_relaxed);}
+
+public:
+    // loop线程发起的收发和事件相关系统调用次数
+    atomic<uint64_t> syscalls{0};
+    // epoll_wait等待时长
+    LatencyHistogram waitHist;
+    // 单个fd事件回调耗时
+    LatencyHistogram eventHist;
+    // 单次异步队列处理总耗时
+    LatencyHistogram asyncHist;
+    // 单次定时器处理总耗时
+    LatencyHistogram timerHist;
+    // 跨线程async投递到执行的延迟
+    LatencyHistogram postHist;
+    SlowCallbackTracer slowTracer;
+};
+
+#endif //LoopStatistic_h
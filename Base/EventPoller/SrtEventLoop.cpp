@@ -27,6 +27,12 @@ using namespace std;
 
 static thread_local std::weak_ptr<SrtEventLoop> gCurrentLoop;
 
+// event: 0：读，1：写，都会关注错误事件
+static int srtModes(int event)
+{
+    return SRT_EPOLL_ERR | (event ? SRT_EPOLL_OUT : SRT_EPOLL_IN);
+}
+
 static int createEventfd(){
     int evtfd = eventfd(0, EFD_NONBLOCK);
     if(evtfd < 0){
@@ -36,6 +42,7 @@ static int createEventfd(){
 }
 
 SrtEventLoop::SrtEventLoop()
+    :EventLoop(false)
 {
     _epollFd = srt_epoll_create();
     srt_epoll_set(_epollFd, SRT_EPOLL_ENABLE_EMPTY);
@@ -69,7 +76,7 @@ void SrtEventLoop::start()
     _timer = make_shared<Timer>();
 
     _runTime = TimeClock::now();
-    struct epoll_event events[EPOLL_SIZE];
+    SRT_EPOLL_EVENT events[EPOLL_SIZE];
     while (!_quit) {
         // if (_mapHander.size() == 0) {
         //     sleep(1);
@@ -78,7 +85,7 @@ void SrtEventLoop::start()
         // }
         loopStrat = TimeClock::now();
 
-        uint64_t minDelay = _timer->flushTimerTask();
+        uint64_t minDelay = _timer->flushTimerTask(getStatistic().get());
         _delayTaskDuration = TimeClock::now() - loopStrat;
 
         computeLoad();
@@ -86,18 +93,20 @@ void SrtEventLoop::start()
         _waitTime = TimeClock::now();
         _lastRunDuration = _waitTime - _runTime;
 
-        int read_len  = 1024;
-        int write_len = 1024;
-        SRTSOCKET  m_read_socks[1024];
-        SRTSOCKET  m_write_socks[1024];
         // 此处没有好的办法对epoll进行唤醒，暂时没10ms唤醒一次，检查是否有异步任务执行
-        int ret = srt_epoll_wait(_epollFd, m_read_socks, &read_len, m_write_socks, &write_len, 10, 0, 0, 0, 0);
+        // 有定时任务更早到期时提前醒来，连接超时等定时器不会被拖后
+        int64_t waitMs = 10;
+        if ((int64_t)minDelay < waitMs) {
+            waitMs = minDelay;
+        }
+        // uwait直接给出每个fd的读、写、错误事件，不用再区分读写数组
+        int ret = srt_epoll_uwait(_epollFd, events, EPOLL_SIZE, waitMs);
         _runTime = TimeClock::now();
 
         // logInfo << "start async event";
         onAsyncEvent();
 
-        if (ret < 0) {
+        if (ret <= 0) {
             //超时或被打断
             continue;
         }
@@ -105,36 +114,40 @@ void SrtEventLoop::start()
         _fdCount = _mapHander.size();
         _timerTaskCount = _timer->getTaskSize();
 
-        // logInfo << "ret: " << ret << ", _mapHander.size(): " << _mapHander.size();
-        for (int i = 0; i < read_len; ++i) {
-            // struct epoll_event &ev = events[i];
-            int fd = m_read_socks[i];
+        for (int i = 0; i < ret && i < EPOLL_SIZE; ++i) {
+            int fd = events[i].fd;
             auto it = _mapHander.find(fd);
             if (it == _mapHander.end()) {
                 srt_epoll_remove_usock(_epollFd, fd);
                 continue;
             }
-            auto func = it->second.callback;
-            try {
-                func(EPOLLIN, it->second.args);
-            } catch (std::exception &ex) {
-                logWarn << "Exception occurred when do event task: " << ex.what();
+            // SRT_EPOLL_IN/OUT/ERR和EPOLLIN/OUT/ERR的取值相同
+            int event = 0;
+            if (events[i].events & SRT_EPOLL_IN) {
+                event |= EPOLLIN;
             }
-        }
-        for (int i = 0; i < write_len; ++i) {
-            // struct epoll_event &ev = events[i];
-            int fd = m_write_socks[i];
-            auto it = _mapHander.find(fd);
-            if (it == _mapHander.end()) {
-                srt_epoll_remove_usock(_epollFd, fd);
-                continue;
+            if (events[i].events & SRT_EPOLL_OUT) {
+                event |= EPOLLOUT;
+            }
+            if (events[i].events & SRT_EPOLL_ERR) {
+                event |= EPOLLERR;
             }
             auto func = it->second.callback;
+            SlowCallbackTracer::setSite(it->second.file, it->second.line);
+            uint64_t startUs = LoopStatistic::nowUs();
             try {
-                func(EPOLLIN, it->second.args);
+                func(event, it->second.args);
             } catch (std::exception &ex) {
                 logWarn << "Exception occurred when do event task: " << ex.what();
             }
+            uint64_t costUs = LoopStatistic::nowUs() - startUs;
+            getStatistic()->eventHist.record(costUs);
+            if (getStatistic()->slowTracer.isSlow(costUs)) {
+                const char* file = nullptr;
+                int line = 0;
+                SlowCallbackTracer::getSite(file, line);
+                getStatistic()->slowTracer.record("event", file, line, costUs);
+            }
         }
         _eventDuration = TimeClock::now() - _runTime;
     }
@@ -181,38 +194,44 @@ bool SrtEventLoop::isCurrent()
     return !_loopThread || _loopThread->get_id() == this_thread::get_id();
 }
 
-void SrtEventLoop::addTimerTask(uint64_t ms, const TimerTask::timerHander &handler, TaskCompleteCB cb)
+void SrtEventLoop::addTimerTask(uint64_t ms, const TimerTask::timerHander &handler, TaskCompleteCB cb,
+                                const char* file, int line)
 {
     if (!handler) {
         return ;
     }
     if (isCurrent()) {
         logInfo << "add timer";
-        auto task = _timer->addTimer(ms, handler);
+        auto task = _timer->addTimer(ms, handler, file, line);
         if (cb) {
             cb(true, task);
         }
         return ;
     }
     
-    async([this, ms, handler, cb](){
-        addTimerTask(ms, handler, cb);
-    }, true, false);
+    async([this, ms, handler, cb, file, line](){
+        addTimerTask(ms, handler, cb, file, line);
+    }, true, false, file, line);
 }
 
-void SrtEventLoop::async(asyncEventFunc func, bool sync, bool front)
+void SrtEventLoop::async(asyncEventFunc func, bool sync, bool front, const char* file, int line)
 {
     if (sync && isCurrent()) {
         func();
         return ;
     }
 
+    AsyncTask task;
+    task.func = std::move(func);
+    task.postTime = LoopStatistic::nowUs();
+    task.file = file;
+    task.line = line;
     {
         lock_guard<mutex> lck(_mtxEvents);
         if (front) {
-            _asyncEvents.emplace_front(func);
+            _asyncEvents.emplace_front(std::move(task));
         } else {
-            _asyncEvents.emplace_back(func);
+            _asyncEvents.emplace_back(std::move(task));
         }
     }
     //写数据到管道,唤醒主线程
@@ -249,28 +268,33 @@ inline void SrtEventLoop::onAsyncEvent()
         _enventSwap.swap(_asyncEvents);
     }
 
-    for (auto& func : _enventSwap) {
+    auto stat = getStatistic();
+    for (auto& task : _enventSwap) {
+        uint64_t taskStartUs = LoopStatistic::nowUs();
+        stat->postHist.record(taskStartUs - task.postTime);
         try {
-            func();
-            // logInfo << "do a async event";
+            task.func();
         } catch (std::exception &ex) {
             logWarn << "do async event failed: " << ex.what();
         }
+        uint64_t costUs = LoopStatistic::nowUs() - taskStartUs;
+        if (stat->slowTracer.isSlow(costUs)) {
+            stat->slowTracer.record("async", task.file, task.line, costUs);
+        }
     }
     _asyncEventDuration = TimeClock::now() - startTime;
 }
 
-int SrtEventLoop::addEvent(int fd, int event, SrtEventHander::eventCallback cb, void* args)
+int SrtEventLoop::addEvent(int fd, int event, SrtEventHander::eventCallback cb, void* args, const char* file, int line)
 {
     if (!cb) {
         logInfo << "cb is empty" << endl;
         return -1;
     }
-    // if (isCurrent()) {
+    // 回调表只在loop线程里访问，accept后分配到其他loop的fd切过去再添加
+    if (isCurrent()) {
         int ret = 0;
-        int modes = event ? SRT_EPOLL_OUT : SRT_EPOLL_IN;
-
-        modes |= SRT_EPOLL_ERR;
+        int modes = srtModes(event);
         ret = srt_epoll_add_usock(_epollFd, fd, &modes);
         if (ret < 0) {
             logError << "add to epoll failed, fd: " << fd;
@@ -279,12 +303,14 @@ int SrtEventLoop::addEvent(int fd, int event, SrtEventHander::eventCallback cb,
         logInfo << "add srt fd: " << fd;
         _mapHander[fd].callback = cb;
         _mapHander[fd].args = args;
+        _mapHander[fd].file = file;
+        _mapHander[fd].line = line;
         return ret;
-    // }
+    }
     
-    async([this, fd, event, cb, args](){
-        addEvent(fd, event, cb, args);
-    }, true, false);
+    async([this, fd, event, cb, args, file, line](){
+        addEvent(fd, event, cb, args, file, line);
+    }, true, false, file, line);
 
     return 0;
 }
@@ -319,9 +345,7 @@ void SrtEventLoop::modifyEvent(int fd, int event, PollCompleteCB cb) {
     }
     if (isCurrent()) {
         int ret = 0;
-        int modes = event ? SRT_EPOLL_OUT : SRT_EPOLL_IN;
-
-        modes |= SRT_EPOLL_ERR;
+        int modes = srtModes(event);
         ret = srt_epoll_update_usock(_epollFd, fd, &modes);
         if (ret < 0) {
             logError << "del from epoll failed, fd: " << fd << ", errno: " << srt_getlasterror_str();
@@ -22,6 +22,9 @@ public:
     using eventCallback = function<void(int event, void* args)>;
     eventCallback callback;
     void* args;
+    // 注册位置，用于慢回调追踪
+    const char* file = nullptr;
+    int line = 0;
 };
 
 class SrtEventLoop : public EventLoop {
@@ -43,11 +46,14 @@ public:
 
     bool isCurrent() override;
     void onAsyncEvent() override;
-    void async(asyncEventFunc func, bool sync, bool front = false) override;
+    void async(asyncEventFunc func, bool sync, bool front = false,
+                const char* file = __builtin_FILE(), int line = __builtin_LINE()) override;
 
-    void addTimerTask(uint64_t ms, const TimerTask::timerHander &handler, TaskCompleteCB cb) override;
+    void addTimerTask(uint64_t ms, const TimerTask::timerHander &handler, TaskCompleteCB cb,
+                const char* file = __builtin_FILE(), int line = __builtin_LINE()) override;
 
-    int addEvent(int fd, int event, SrtEventHander::eventCallback cb, void* args = nullptr) override;
+    int addEvent(int fd, int event, SrtEventHander::eventCallback cb, void* args = nullptr,
+                const char* file = __builtin_FILE(), int line = __builtin_LINE()) override;
     void delEvent(int fd, PollCompleteCB cb) override;
     void modifyEvent(int fd, int event, PollCompleteCB cb) override;
 
@@ -79,7 +85,7 @@ private:
     std::thread* _loopThread = nullptr;
     std::mutex _mtxEvents;
     Timer::Ptr _timer;
-    std::list<asyncEventFunc> _asyncEvents;
+    std::list<AsyncTask> _asyncEvents;
     unordered_map<int, SrtEventHander> _mapHander;
 };
 
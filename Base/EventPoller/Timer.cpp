@@ -1,5 +1,6 @@
 ﻿#include "Timer.h"
 #include "Logger.h"
+#include "LoopStatistic.h"
 #include <vector>
 
 using namespace std;
@@ -26,12 +27,14 @@ TimerTask::~TimerTask()
 Timer::Timer()
 {}
 
-shared_ptr<TimerTask> Timer::addTimer(uint64_t ms, const TimerTask::timerHander &cb)
+shared_ptr<TimerTask> Timer::addTimer(uint64_t ms, const TimerTask::timerHander &cb, const char* file, int line)
 {
     shared_ptr<TimerTask> task = make_shared<TimerTask>();
     task->delay = ms;
     task->click = getTick() + ms;
     task->hander = cb;
+    task->file = file;
+    task->line = line;
     _tasks.emplace(task, task);
     // _tasks[task] = task;
 
@@ -49,7 +52,7 @@ int Timer::getTaskSize()
     return _tasks.size();
 }
 
-uint64_t Timer::flushTimerTask()
+uint64_t Timer::flushTimerTask(LoopStatistic* stat)
 {
     uint64_t now = getTick();
     vector<shared_ptr<TimerTask>> tmp;
@@ -73,7 +76,14 @@ uint64_t Timer::flushTimerTask()
         //     logInfo << "erase task failed";
         // }
         // logInfo << "task->hander()";
+        uint64_t startUs = stat ? LoopStatistic::nowUs() : 0;
         uint64_t delay = task->hander();
+        if (stat) {
+            uint64_t costUs = LoopStatistic::nowUs() - startUs;
+            if (stat->slowTracer.isSlow(costUs)) {
+                stat->slowTracer.record("timer", task->file, task->line, costUs);
+            }
+        }
         // logInfo << "(delay > 0 && !task->quit): " << (delay > 0 && !task->quit);
         if (delay > 0 && !task->quit) {
             task->click = now + delay;
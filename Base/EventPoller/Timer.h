@@ -7,6 +7,7 @@
 
 using namespace std;
 
+class LoopStatistic;
 
 class TimerTask
 {
@@ -20,6 +21,9 @@ public:
     uint64_t delay;
     uint64_t click;
     timerHander hander;
+    // 注册位置，用于慢回调追踪
+    const char* file = nullptr;
+    int line = 0;
 };
 
 struct CmpByTimerTask {
@@ -35,9 +39,9 @@ public:
     ~Timer() = default;
 
 public:
-    shared_ptr<TimerTask> addTimer(uint64_t ms, const TimerTask::timerHander &cb);
+    shared_ptr<TimerTask> addTimer(uint64_t ms, const TimerTask::timerHander &cb, const char* file = nullptr, int line = 0);
     void delTimer(const shared_ptr<TimerTask> &task);
-    uint64_t flushTimerTask();
+    uint64_t flushTimerTask(LoopStatistic* stat = nullptr);
     int getTaskSize();
 
 public:
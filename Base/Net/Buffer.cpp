@@ -13,11 +13,20 @@
 #include "Buffer.h"
 
 StreamBuffer::~StreamBuffer()
+{
+    release();
+}
+
+void StreamBuffer::release()
 {
     if (_data && _free) {
-        delete[] _data;
-        _data = nullptr;
+        if (_pooled) {
+            BufferPool::deallocate(_data);
+        } else {
+            delete[] _data;
+        }
     }
+    _data = nullptr;
 }
 
 StreamBuffer::StreamBuffer(size_t capacity) 
@@ -78,7 +87,11 @@ void StreamBuffer::setCapacity(size_t capacity)
             }
         } while (false);
     }
-    _data = new char[capacity];
+    release();
+    _data = (char*)BufferPool::allocate(capacity);
+    _free = true;
+    _pooled = true;
+    _offset = 0;
     _capacity = capacity;
     _size = capacity - 1;
 }
@@ -104,7 +117,10 @@ void StreamBuffer::assign(const char *data, size_t size)
 
 void StreamBuffer::move(char *data, size_t size, int free) 
 {
+    release();
     _free = free;
+    _pooled = false;
+    _offset = 0;
     if (size <= 0) {
         size = strlen(data);
     }
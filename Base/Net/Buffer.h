@@ -19,6 +19,8 @@
 #include <type_traits>
 #include <functional>
 
+#include "BufferPool.h"
+
 using namespace std;
 
 //缓存基类
@@ -44,7 +46,7 @@ public:
     }
 };
 
-// 用于存储申请后，长度不变的内存
+// 用于存储申请后，长度不变的内存，内存从BufferPool分配
 class StreamBuffer : public Buffer {
 public:
     using Ptr = std::shared_ptr<StreamBuffer>;
@@ -87,8 +89,13 @@ public:
 
     void useAllBuffer();
 
+private:
+    void release();
+
 private:
     bool _free = true;
+    // 内存来自BufferPool，否则是外部move进来的new[]内存
+    bool _pooled = false;
     size_t _size = 0;
     size_t _capacity = 0;
     size_t _offset = 0;
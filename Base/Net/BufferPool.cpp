@@ -0,0 +1,363 @@
+#include "BufferPool.h"
+
+#include <atomic>
+#include <mutex>
+#include <new>
+#include <algorithm>
+#include <cstdlib>
+
+using namespace std;
+
+namespace {
+
+const size_t kClassSize[] = {64, 256, 1536, 4096, 8192, 16384, 32768, 65536};
+const int kClassNum = sizeof(kClassSize) / sizeof(kClassSize[0]);
+const int kLargeClass = kClassNum;
+// 每个线程每一级最多缓存的字节数
+const size_t kMaxCacheBytes = 1024 * 1024;
+// 别的线程释放回来还没收回的字节上限，所属线程不再分配时避免无限堆积
+const int64_t kMaxRemoteBytes = 4 * 1024 * 1024;
+// 线程内在用字节的变化累计到该值才同步到全局
+const int64_t kLiveFlushBytes = 256 * 1024;
+
+struct ThreadCache;
+
+// 块头放在返回给用户的内存前面，保持16字节对齐
+struct BlockHeader
+{
+    ThreadCache* owner;
+    uint32_t cls;
+    // 大块的实际大小
+    uint32_t size;
+};
+static_assert(sizeof(BlockHeader) == 16, "block header must keep 16 bytes alignment");
+
+// 空闲块复用用户区保存链表指针
+struct FreeBlock
+{
+    FreeBlock* next;
+};
+
+// 统计只由所属线程写，用原子变量是为了api线程读
+inline void addCounter(atomic<uint64_t>& counter, int64_t n = 1)
+{
+    counter.store(counter.load(memory_order_relaxed) + n, memory_order_relaxed);
+}
+
+struct ThreadCache
+{
+    FreeBlock* freeList[kClassNum];
+    size_t freeCount[kClassNum];
+    atomic<FreeBlock*> remoteFree{nullptr};
+    atomic<int64_t> remoteBytes{0};
+    atomic<bool> alive{true};
+
+    atomic<uint64_t> allocs[kClassNum + 1];
+    atomic<uint64_t> hits[kClassNum + 1];
+    atomic<uint64_t> cached[kClassNum];
+    atomic<int64_t> liveDelta{0};
+
+    ThreadCache()
+    {
+        for (int i = 0; i <= kClassNum; ++i) {
+            if (i < kClassNum) {
+                freeList[i] = nullptr;
+                freeCount[i] = 0;
+                cached[i] = 0;
+            }
+            allocs[i] = 0;
+            hits[i] = 0;
+        }
+    }
+};
+
+struct PoolGlobal
+{
+    mutex mtx;
+    // 所有线程的缓存，线程退出后不释放，留给新线程复用
+    vector<ThreadCache*> caches;
+    atomic<int64_t> liveBytes{0};
+    atomic<int64_t> peakBytes{0};
+    atomic<bool> enable{false};
+};
+
+// 静态析构之后还可能有buffer释放，不析构
+PoolGlobal& global()
+{
+    static PoolGlobal* instance = new PoolGlobal;
+    return *instance;
+}
+
+void addLive(ThreadCache* cache, int64_t bytes)
+{
+    auto& g = global();
+    if (cache && cache->alive.load(memory_order_relaxed)) {
+        int64_t delta = cache->liveDelta.load(memory_order_relaxed) + bytes;
+        if (delta < kLiveFlushBytes && delta > -kLiveFlushBytes) {
+            cache->liveDelta.store(delta, memory_order_relaxed);
+            return ;
+        }
+        cache->liveDelta.store(0, memory_order_relaxed);
+        bytes = delta;
+    }
+
+    int64_t live = g.liveBytes.fetch_add(bytes, memory_order_relaxed) + bytes;
+    int64_t peak = g.peakBytes.load(memory_order_relaxed);
+    while (live > peak && !g.peakBytes.compare_exchange_weak(peak, live, memory_order_relaxed)) {
+    }
+}
+
+// 放回本线程缓存，超过上限还给系统
+void cacheBlock(ThreadCache* cache, BlockHeader* header)
+{
+    auto cls = header->cls;
+    if (cache->freeCount[cls] * kClassSize[cls] >= kMaxCacheBytes) {
+        free(header);
+        return ;
+    }
+    auto block = (FreeBlock*)(header + 1);
+    block->next = cache->freeList[cls];
+    cache->freeList[cls] = block;
+    ++cache->freeCount[cls];
+    addCounter(cache->cached[cls]);
+}
+
+// 收回别的线程释放的块
+void drainRemote(ThreadCache* cache)
+{
+    auto block = cache->remoteFree.exchange(nullptr, memory_order_acquire);
+    int64_t bytes = 0;
+    while (block) {
+        auto next = block->next;
+        auto header = (BlockHeader*)block - 1;
+        bytes += header->size;
+        cacheBlock(cache, header);
+        block = next;
+    }
+    if (bytes) {
+        cache->remoteBytes.fetch_sub(bytes, memory_order_relaxed);
+    }
+}
+
+// 清空之后才标记为退出，标记后缓存对象随时可能被新线程拿走
+void releaseCache(ThreadCache* cache)
+{
+    drainRemote(cache);
+    for (int cls = 0; cls < kClassNum; ++cls) {
+        auto block = cache->freeList[cls];
+        while (block) {
+            auto next = block->next;
+            free((BlockHeader*)block - 1);
+            block = next;
+        }
+        cache->freeList[cls] = nullptr;
+        cache->freeCount[cls] = 0;
+        cache->cached[cls] = 0;
+    }
+
+    int64_t delta = cache->liveDelta.exchange(0, memory_order_relaxed);
+    global().liveBytes.fetch_add(delta, memory_order_relaxed);
+    cache->alive.store(false, memory_order_release);
+}
+
+thread_local ThreadCache* t_cache = nullptr;
+// 缓存已回收，线程正在退出
+thread_local bool t_exited = false;
+
+// 线程退出时回收缓存，之后该线程的分配直接走malloc，释放按别的线程处理
+// 回收后的缓存对象可能马上被新线程复用，这里不能再碰它的空闲链表
+struct CacheHolder
+{
+    ThreadCache* cache = nullptr;
+
+    ~CacheHolder()
+    {
+        if (cache) {
+            releaseCache(cache);
+        }
+        t_cache = nullptr;
+        t_exited = true;
+    }
+};
+
+thread_local CacheHolder t_holder;
+
+// 线程退出后返回nullptr
+ThreadCache* getCache()
+{
+    if (t_cache || t_exited) {
+        return t_cache;
+    }
+
+    auto& g = global();
+    ThreadCache* cache = nullptr;
+    {
+        lock_guard<mutex> lock(g.mtx);
+        for (auto item : g.caches) {
+            if (!item->alive.load(memory_order_acquire)) {
+                cache = item;
+                break;
+            }
+        }
+        if (!cache) {
+            cache = new ThreadCache;
+            g.caches.push_back(cache);
+        }
+        cache->alive.store(true, memory_order_release);
+    }
+    // 复用的缓存可能还挂着线程退出后才释放的块
+    drainRemote(cache);
+
+    t_cache = cache;
+    t_holder.cache = cache;
+
+    return cache;
+}
+
+int sizeToClass(size_t size)
+{
+    for (int cls = 0; cls < kClassNum; ++cls) {
+        if (size <= kClassSize[cls]) {
+            return cls;
+        }
+    }
+
+    return kLargeClass;
+}
+
+}
+
+void* BufferPool::allocate(size_t size, size_t* capacity)
+{
+    auto cache = getCache();
+    int cls = sizeToClass(size);
+    bool pooled = cls != kLargeClass && cache && global().enable.load(memory_order_relaxed);
+    if (!pooled) {
+        auto header = (BlockHeader*)malloc(sizeof(BlockHeader) + size);
+        if (!header) {
+            throw bad_alloc();
+        }
+        header->owner = nullptr;
+        header->cls = kLargeClass;
+        header->size = size;
+        if (cache) {
+            addCounter(cache->allocs[kLargeClass]);
+        }
+        addLive(cache, size);
+        if (capacity) {
+            *capacity = size;
+        }
+        return header + 1;
+    }
+
+    addCounter(cache->allocs[cls]);
+    addLive(cache, kClassSize[cls]);
+    if (capacity) {
+        *capacity = kClassSize[cls];
+    }
+
+    if (!cache->freeList[cls]) {
+        drainRemote(cache);
+    }
+    auto block = cache->freeList[cls];
+    if (block) {
+        cache->freeList[cls] = block->next;
+        --cache->freeCount[cls];
+        addCounter(cache->cached[cls], -1);
+        addCounter(cache->hits[cls]);
+        return block;
+    }
+
+    auto header = (BlockHeader*)malloc(sizeof(BlockHeader) + kClassSize[cls]);
+    if (!header) {
+        throw bad_alloc();
+    }
+    header->owner = cache;
+    header->cls = cls;
+    header->size = kClassSize[cls];
+
+    return header + 1;
+}
+
+void BufferPool::deallocate(void* ptr)
+{
+    if (!ptr) {
+        return ;
+    }
+
+    auto header = (BlockHeader*)ptr - 1;
+    auto cache = getCache();
+    addLive(cache, -(int64_t)header->size);
+
+    // 线程退出后cache为nullptr，自己缓存的块也走下面的远程链表或直接释放
+    auto owner = header->owner;
+    if (!owner || !owner->alive.load(memory_order_acquire)) {
+        free(header);
+        return ;
+    }
+
+    if (owner == cache) {
+        cacheBlock(cache, header);
+        return ;
+    }
+
+    if (owner->remoteBytes.fetch_add(header->size, memory_order_relaxed) >= kMaxRemoteBytes) {
+        owner->remoteBytes.fetch_sub(header->size, memory_order_relaxed);
+        free(header);
+        return ;
+    }
+    auto block = (FreeBlock*)ptr;
+    auto head = owner->remoteFree.load(memory_order_relaxed);
+    do {
+        block->next = head;
+    } while (!owner->remoteFree.compare_exchange_weak(head, block, memory_order_release, memory_order_relaxed));
+}
+
+void BufferPool::setEnable(bool enable)
+{
+    global().enable = enable;
+}
+
+bool BufferPool::isEnable()
+{
+    return global().enable;
+}
+
+BufferPoolStatistic BufferPool::getStatistic()
+{
+    BufferPoolStatistic stat;
+    stat.classes.resize(kClassNum + 1);
+    for (int cls = 0; cls < kClassNum; ++cls) {
+        stat.classes[cls].blockSize = kClassSize[cls];
+    }
+
+    auto& g = global();
+    stat.enable = g.enable;
+    stat.liveBytes = g.liveBytes.load(memory_order_relaxed);
+    {
+        lock_guard<mutex> lock(g.mtx);
+        for (auto cache : g.caches) {
+            if (cache->alive.load(memory_order_relaxed)) {
+                ++stat.threads;
+            }
+            stat.liveBytes += cache->liveDelta.load(memory_order_relaxed);
+            for (int cls = 0; cls <= kClassNum; ++cls) {
+                auto& item = stat.classes[cls];
+                item.allocs += cache->allocs[cls].load(memory_order_relaxed);
+                item.hits += cache->hits[cls].load(memory_order_relaxed);
+                if (cls < kClassNum) {
+                    item.cachedBlocks += cache->cached[cls].load(memory_order_relaxed);
+                }
+            }
+        }
+    }
+
+    for (auto& item : stat.classes) {
+        stat.allocs += item.allocs;
+        stat.hits += item.hits;
+        stat.cachedBytes += item.cachedBlocks * item.blockSize;
+    }
+    stat.peakBytes = max(g.peakBytes.load(memory_order_relaxed), stat.liveBytes);
+
+    return stat;
+}
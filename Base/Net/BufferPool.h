@@ -0,0 +1,57 @@
+#ifndef BufferPool_h
+#define BufferPool_h
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+struct BufferPoolClassStatistic
+{
+    // 大块为0
+    size_t blockSize = 0;
+    uint64_t allocs = 0;
+    // 从线程缓存里直接拿到的次数
+    uint64_t hits = 0;
+    uint64_t cachedBlocks = 0;
+};
+
+struct BufferPoolStatistic
+{
+    bool enable = false;
+    int threads = 0;
+    uint64_t allocs = 0;
+    uint64_t hits = 0;
+    int64_t liveBytes = 0;
+    // 在用字节的历史最大值，按线程批量同步，有几百K的误差
+    int64_t peakBytes = 0;
+    uint64_t cachedBytes = 0;
+    // 最后一项为超过最大级别的大块
+    vector<BufferPoolClassStatistic> classes;
+};
+
+// 按大小分级的内存池: 64B/256B/1.5K/4K/8K/16K/32K/64K，更大的直接malloc
+// 每个线程缓存自己的空闲块，分配释放都不加锁
+// 别的线程释放的块挂到所属线程的无锁链表上，所属线程缓存用完时再收回
+// 线程退出后缓存里的块还给系统，缓存对象留给之后的新线程复用
+// 默认关闭，由Util.bufferPool打开: 单线程收发快20~30%，但跨线程释放的块要等所属线程收回，
+// RSS能涨到malloc的10倍，短命线程多时反而更慢，详见Tests/bufferPool.cpp
+// StringBuffer不走池子，上层拼好的string直接move进来，拷贝进池子更慢
+class BufferPool
+{
+public:
+    // capacity返回块的实际可用大小
+    static void* allocate(size_t size, size_t* capacity = nullptr);
+    // 只能释放allocate返回的指针
+    static void deallocate(void* ptr);
+
+    // 关闭后新的分配直接走malloc，已分配的块照常释放
+    static void setEnable(bool enable);
+    static bool isEnable();
+
+    static BufferPoolStatistic getStatistic();
+};
+
+#endif //BufferPool_h
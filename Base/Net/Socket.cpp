@@ -13,9 +13,48 @@
 #include <netinet/tcp.h>
 #include <fcntl.h>
 #include <sys/epoll.h>
+#include <linux/filter.h>
 
 using namespace std;
 
+// io_uring单次sendmsg合并的iovec上限
+#define URING_MAX_IOV 1024
+// io_uring单次串联提交的udp报文上限
+#define URING_MAX_DATAGRAM 64
+
+// io_uring发送中的一批数据，完成前保持引用
+class UringSendBatch
+{
+public:
+    using Ptr = shared_ptr<UringSendBatch>;
+
+    vector<SocketBuffer::Ptr> buffers;
+    vector<iovec> vecBuffer;
+    struct msghdr msg;
+    // 上层传入的地址不保证在完成前有效，拷贝一份
+    sockaddr_storage addr;
+    int length = 0;
+};
+
+// 去掉已发送的部分，剩余数据下次从断点继续
+static void trimSocketBuffer(const SocketBuffer::Ptr& sendBuffer, size_t sendSize)
+{
+    for (auto it = sendBuffer->vecBuffer.begin(); it != sendBuffer->vecBuffer.end();) {
+        size_t size = it->iov_len;
+        if (sendSize >= size) {
+            sendSize -= size;
+            it = sendBuffer->vecBuffer.erase(it);
+            // sendBuffer->rawBuffer.pop_front();
+            sendBuffer->length -= size;
+        } else {
+            it->iov_base = (char*)(it->iov_base) + sendSize;
+            it->iov_len -= sendSize;
+            sendBuffer->length -= sendSize;
+            break;
+        }
+    }
+}
+
 static int setIpv6Only(int fd, bool flag)
 {
     int opt = flag;
@@ -214,6 +253,40 @@ int Socket::setReuseable()
     return ret;
 }
 
+// 同一端口的reuseport组内，按负载中offset处的4字节选择socket，
+// 保证同一个流(如rtp的ssrc)总是落到同一个socket，即同一个loop
+// 必须在bind之后调用，count为组内socket个数
+int Socket::setReusePortSteering(uint32_t offset, uint32_t count)
+{
+#ifdef SO_ATTACH_REUSEPORT_CBPF
+    if (count <= 1) {
+        return 0;
+    }
+
+    struct sock_filter code[] = {
+        // A = ntohl(*(uint32_t*)(payload + offset))，udp的负载从udp头之后开始
+        { BPF_LD | BPF_W | BPF_ABS, 0, 0, offset },
+        // A = A % count
+        { BPF_ALU | BPF_MOD | BPF_K, 0, 0, count },
+        // return A
+        { BPF_RET | BPF_A, 0, 0, 0 },
+    };
+    struct sock_fprog prog = {
+        sizeof(code) / sizeof(code[0]),
+        code,
+    };
+
+    int ret = setsockopt(_fd, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &prog, sizeof(prog));
+    if (ret == -1) {
+        logWarn << "setsockopt SO_ATTACH_REUSEPORT_CBPF failed: " << strerror(errno);
+    }
+
+    return ret;
+#else
+    return -1;
+#endif
+}
+
 int Socket::setIpv6Only(bool enable)
 {
     if (_family != AF_INET6) {
@@ -360,6 +433,60 @@ int Socket::setKeepAlive(int interval, int idle, int times)
     return ret;
 }
 
+int Socket::setMulticastTtl(int ttl)
+{
+    int ret = setsockopt(_fd, IPPROTO_IP, IP_MULTICAST_TTL, (char *) &ttl, static_cast<socklen_t>(sizeof(ttl)));
+    if (ret == -1) {
+        logWarn << "setsockopt IP_MULTICAST_TTL failed: " << strerror(errno);
+    }
+    return ret;
+}
+
+int Socket::setMulticastLoop(bool enable)
+{
+    int opt = enable ? 1 : 0;
+    int ret = setsockopt(_fd, IPPROTO_IP, IP_MULTICAST_LOOP, (char *) &opt, static_cast<socklen_t>(sizeof(opt)));
+    if (ret == -1) {
+        logWarn << "setsockopt IP_MULTICAST_LOOP failed: " << strerror(errno);
+    }
+    return ret;
+}
+
+int Socket::setMulticastIf(const string& localIp)
+{
+    struct in_addr addr;
+    if (inet_pton(AF_INET, localIp.data(), &addr) != 1) {
+        logWarn << "invalid multicast interface: " << localIp;
+        return -1;
+    }
+    int ret = setsockopt(_fd, IPPROTO_IP, IP_MULTICAST_IF, (char *) &addr, static_cast<socklen_t>(sizeof(addr)));
+    if (ret == -1) {
+        logWarn << "setsockopt IP_MULTICAST_IF failed: " << strerror(errno);
+    }
+    return ret;
+}
+
+int Socket::joinMulticast(const string& group, const string& localIp)
+{
+    struct ip_mreq mreq;
+    memset(&mreq, 0, sizeof(mreq));
+    if (inet_pton(AF_INET, group.data(), &mreq.imr_multiaddr) != 1) {
+        logWarn << "invalid multicast group: " << group;
+        return -1;
+    }
+    if (localIp.empty()) {
+        mreq.imr_interface.s_addr = htonl(INADDR_ANY);
+    } else if (inet_pton(AF_INET, localIp.data(), &mreq.imr_interface) != 1) {
+        logWarn << "invalid multicast interface: " << localIp;
+        return -1;
+    }
+    int ret = setsockopt(_fd, IPPROTO_IP, IP_ADD_MEMBERSHIP, (char *) &mreq, static_cast<socklen_t>(sizeof(mreq)));
+    if (ret == -1) {
+        logWarn << "setsockopt IP_ADD_MEMBERSHIP failed: " << strerror(errno);
+    }
+    return ret;
+}
+
 bool Socket::bindPeerAddr(const struct sockaddr *dst_addr)
 {
     if (_type != SOCKET_UDP) {
@@ -461,6 +588,7 @@ void Socket::handleEvent(int event, void* args)
     // logInfo << "EPOLLOUT: " << EPOLLOUT;
     // logInfo << "EPOLLERR: " << EPOLLERR;
     // logInfo << "EPOLLHUP: " << EPOLLHUP;
+    setTraceSite();
     if (event & EPOLLIN) {
         // logInfo << "handle read: " << this;
         onRead(args);
@@ -481,6 +609,26 @@ void Socket::handleEvent(int event, void* args)
 void Socket::addToEpoll()
 {
     Socket::Wptr weakSocket = shared_from_this();
+    if (_loop->isUring()) {
+        if (_isClient && !_isConnected) {
+            // 一次性poll等待连接结果，收发都走完成事件
+            _loop->addEvent(_fd, EPOLLOUT | EPOLLHUP | EPOLLERR | EPOLLONESHOT, [weakSocket](int event, void* args){
+                auto socket = weakSocket.lock();
+                if (!socket) {
+                    return ;
+                }
+                socket->handleEvent(event, args);
+            });
+        }
+        _loop->addRecv(_fd, _type != SOCKET_TCP, [weakSocket](int res, char* data, int size, struct sockaddr* addr, int addrLen){
+            auto socket = weakSocket.lock();
+            if (!socket) {
+                return ;
+            }
+            socket->onUringRecv(res, data, size, addr, addrLen);
+        });
+        return ;
+    }
     _loop->addEvent(_fd, EPOLLIN | EPOLLHUP | EPOLLERR | EPOLLOUT | EPOLLET, [weakSocket](int event, void* args){
         auto socket = weakSocket.lock();
         if (!socket) {
@@ -496,17 +644,16 @@ StreamBuffer::Ptr Socket::onGetRecvBuffer()
 {
     if (_onGetRecvBuffer) {
         return _onGetRecvBuffer();
-    } else {
-        return g_readBuffer;
     }
-}
-
-int Socket::onRead(void* args)
-{
     if (!g_readBuffer) {
         g_readBuffer = StreamBuffer::create();
         g_readBuffer->setCapacity(1 + 4 * 1024 * 1024);
     }
+    return g_readBuffer;
+}
+
+int Socket::onRead(void* args)
+{
     ssize_t ret = 0, nread = 0;
 
     struct sockaddr_storage addr;
@@ -523,10 +670,11 @@ int Socket::onRead(void* args)
         
         do {
             nread = recvfrom(_fd, data, capacity, 0, (struct sockaddr *)&addr, &len);
+            _loop->addSyscall();
         } while (-1 == nread && EINTR == errno);
 
         if (nread == 0) {
-            if (_type == 1) {
+            if (_type == SOCKET_TCP) {
                 onError("end of file");
             } else {
                 logInfo << "Recv eof on udp socket[" << _fd << "]";
@@ -536,7 +684,7 @@ int Socket::onRead(void* args)
 
         if (nread == -1) {
             if (errno != EAGAIN) {
-                if (_type == 1) {
+                if (_type == SOCKET_TCP) {
                     logDebug << errno;
                 } else {
                     logWarn << "Recv err on udp socket[" << _fd << "]: " << strerror(errno);
@@ -546,6 +694,7 @@ int Socket::onRead(void* args)
         }
 
         ret += nread;
+        _loop->addBytes(nread);
         data[nread] = '\0';
         // 设置buffer有效数据大小
         readBuffer->setSize(nread);
@@ -562,6 +711,56 @@ int Socket::onRead(void* args)
     return 0;
 }
 
+void Socket::setTraceSite()
+{
+    if (_owner) {
+        SlowCallbackTracer::setOwnerSite(*_owner);
+    } else if (_readFile) {
+        SlowCallbackTracer::setSite(_readFile, _readLine);
+    }
+}
+
+void Socket::onUringRecv(int res, char* data, int size, struct sockaddr* addr, int addrLen)
+{
+    setTraceSite();
+    if (res <= 0) {
+        if (_type == SOCKET_TCP) {
+            onError(res == 0 ? "end of file" : strerror(-res));
+        } else {
+            logInfo << "Recv end on udp socket[" << _fd << "]: " << res;
+        }
+        return ;
+    }
+
+    auto readBuffer = onGetRecvBuffer();
+    if (!readBuffer) {
+        return ;
+    }
+    // 内核挑选的缓冲在回调后归还，拷贝到接收buffer，上层接口不变
+    int capacity = readBuffer->getCapacity() - 1;
+    if (size > capacity) {
+        logWarn << "recv buffer too small, fd: " << _fd << ", size: " << size << ", capacity: " << capacity;
+        size = capacity;
+    }
+    auto buffer = readBuffer->data();
+    memcpy(buffer, data, size);
+    buffer[size] = '\0';
+    readBuffer->setSize(size);
+    _loop->addBytes(size);
+
+    struct sockaddr_storage empty;
+    if (!addr) {
+        memset(&empty, 0, sizeof(empty));
+        addr = (struct sockaddr*)&empty;
+        addrLen = 0;
+    }
+    try {
+        _onRead(readBuffer, addr, addrLen);
+    } catch (std::exception &ex) {
+        logInfo << "Exception occurred when emit on_read: " << ex.what();
+    }
+}
+
 int Socket::onWrite(void* args)
 {
     // if (!g_writeBuffer) {
@@ -572,6 +771,12 @@ int Socket::onWrite(void* args)
         _onWrite();
     }
 
+    if (_loop->isUring()) {
+        // 只在连接完成时触发一次，发送由完成事件驱动
+        send(nullptr);
+        return 0;
+    }
+
     if (_readyBuffer.size() == 0) {
         if (!_sendBuffer) {
             return 0;
@@ -721,6 +926,10 @@ ssize_t Socket::send(const Buffer::Ptr pkt, int flag, int offset, int length, st
         return 0;
     }
 
+    if (_loop->isUring()) {
+        return sendByUring();
+    }
+
     // logInfo << "_remainSize: " << _remainSize;
 
     ssize_t totalSendSize = 0;
@@ -741,6 +950,7 @@ ssize_t Socket::send(const Buffer::Ptr pkt, int flag, int offset, int length, st
             msg.msg_namelen = sendBuffer->addr_len;
             
             sendSize = sendmsg(_fd, &msg, MSG_DONTWAIT | MSG_NOSIGNAL);
+            _loop->addSyscall();
         } while (sendSize == -1 && errno == EINTR);
 
         // logInfo << "sendBuffer->length: " << sendBuffer->length;
@@ -753,20 +963,7 @@ ssize_t Socket::send(const Buffer::Ptr pkt, int flag, int offset, int length, st
             continue;
         } else if (sendSize > 0) {
             totalSendSize += sendSize;
-            for (auto it = sendBuffer->vecBuffer.begin(); it != sendBuffer->vecBuffer.end();) {
-                size_t size = it->iov_len;
-                if (sendSize >= size) {
-                    sendSize -= size;
-                    it = sendBuffer->vecBuffer.erase(it);
-                    // sendBuffer->rawBuffer.pop_front();
-                    sendBuffer->length -= size;
-                } else {
-                    it->iov_base = (char*)(it->iov_base) + sendSize;
-                    it->iov_len -= sendSize;
-                    sendBuffer->length -= sendSize;
-                    break;
-                }
-            }
+            trimSocketBuffer(sendBuffer, sendSize);
             logTrace << "sendBuffer->length: " << sendBuffer->length;
             break;
         } else {
@@ -814,6 +1011,7 @@ ssize_t Socket::send(const Buffer::Ptr pkt, int flag, int offset, int length, st
     // }
 
     _remainSize -= totalSendSize;
+    _loop->addBytes(totalSendSize);
     // logInfo << "_remainSize: " << _remainSize;
     // logInfo << "totalSendSize: " << totalSendSize;
 
@@ -828,6 +1026,143 @@ ssize_t Socket::send(const Buffer::Ptr pkt, int flag, int offset, int length, st
     return totalSendSize;
 }
 
+ssize_t Socket::sendByUring()
+{
+    // 同一时间只有一批请求在发送，完成后再提交后面的数据，保证顺序
+    if (_uringSending > 0) {
+        return 0;
+    }
+    while (!_readyBuffer.empty() && _readyBuffer.front()->length == 0) {
+        _readyBuffer.pop_front();
+    }
+    if (_readyBuffer.empty()) {
+        return 0;
+    }
+
+    vector<UringSendBatch::Ptr> batches;
+    if (_type == SOCKET_TCP) {
+        // 多个buffer合并成一次sendmsg
+        auto batch = make_shared<UringSendBatch>();
+        for (auto& sendBuffer : _readyBuffer) {
+            if (!batch->vecBuffer.empty() && batch->vecBuffer.size() + sendBuffer->vecBuffer.size() > URING_MAX_IOV) {
+                break;
+            }
+            batch->vecBuffer.insert(batch->vecBuffer.end(), sendBuffer->vecBuffer.begin(), sendBuffer->vecBuffer.end());
+            batch->buffers.push_back(sendBuffer);
+            batch->length += sendBuffer->length;
+        }
+        batches.push_back(batch);
+    } else {
+        // 一个buffer是一个报文，串联提交
+        for (auto& sendBuffer : _readyBuffer) {
+            if (batches.size() >= URING_MAX_DATAGRAM) {
+                break;
+            }
+            auto batch = make_shared<UringSendBatch>();
+            batch->vecBuffer = sendBuffer->vecBuffer;
+            batch->buffers.push_back(sendBuffer);
+            batch->length = sendBuffer->length;
+            batches.push_back(batch);
+        }
+    }
+
+    Socket::Wptr wSelf = shared_from_this();
+    ssize_t queuedSize = 0;
+    for (size_t i = 0; i < batches.size(); ++i) {
+        auto& batch = batches[i];
+        auto& sendBuffer = batch->buffers.front();
+        memset(&batch->msg, 0, sizeof(batch->msg));
+        batch->msg.msg_iov = batch->vecBuffer.data();
+        batch->msg.msg_iovlen = batch->vecBuffer.size();
+        if (sendBuffer->addr && sendBuffer->addr_len <= sizeof(batch->addr)) {
+            memcpy(&batch->addr, sendBuffer->addr, sendBuffer->addr_len);
+            batch->msg.msg_name = &batch->addr;
+            batch->msg.msg_namelen = sendBuffer->addr_len;
+        }
+
+        // tcp等全部写完才完成，避免部分发送后重新提交
+        int flags = MSG_NOSIGNAL | (_type == SOCKET_TCP ? MSG_WAITALL : 0);
+        int ret = _loop->addSend(_fd, &batch->msg, flags, i + 1 < batches.size(), [wSelf, batch](int res){
+            auto self = wSelf.lock();
+            if (self) {
+                self->onUringSend(batch, res);
+            }
+        });
+        if (ret != 0) {
+            logWarn << "submit send failed, fd: " << _fd;
+            break;
+        }
+        ++_uringSending;
+        queuedSize += batch->length;
+    }
+
+    // sq满了一个都没提交上，没有完成事件来驱动后续发送，等loop提交完sq后重试
+    if (_uringSending == 0 && !_uringRetry) {
+        _uringRetry = true;
+        _loop->addTimerTask(1, [wSelf](){
+            auto self = wSelf.lock();
+            if (self) {
+                self->_uringRetry = false;
+                if (self->_sendBuffer) {
+                    self->sendByUring();
+                }
+            }
+            return 0;
+        }, nullptr);
+    }
+
+    return queuedSize;
+}
+
+void Socket::onUringSend(const UringSendBatch::Ptr& batch, int res)
+{
+    --_uringSending;
+    if (res < 0 && res != -ECANCELED) {
+        if (_type == SOCKET_TCP) {
+            // 和epoll一样，tcp发送失败断开连接，onError里清空发送队列，串联的后续请求不再重复通知
+            logDebug << "send err on tcp socket[" << _fd << "]: " << strerror(-res);
+            if (_sendBuffer) {
+                onError(strerror(-res));
+            }
+            return ;
+        }
+        logWarn << "send err on udp socket[" << _fd << "]: " << strerror(-res);
+    }
+
+    // udp出错的报文直接丢弃
+    size_t consumed = 0;
+    size_t remain = res > 0 ? res : 0;
+    for (auto& sendBuffer : batch->buffers) {
+        if (_readyBuffer.empty() || _readyBuffer.front() != sendBuffer) {
+            break;
+        }
+        if (_type == SOCKET_TCP && res >= 0 && remain < (size_t)sendBuffer->length) {
+            trimSocketBuffer(sendBuffer, remain);
+            consumed += remain;
+            break;
+        }
+        remain -= min(remain, (size_t)sendBuffer->length);
+        consumed += sendBuffer->length;
+        _readyBuffer.pop_front();
+    }
+    _remainSize -= min(consumed, _remainSize);
+    if (res > 0) {
+        _loop->addBytes(res);
+    }
+
+    if (_uringSending > 0 || !_sendBuffer) {
+        return ;
+    }
+    if (!_readyBuffer.empty()) {
+        sendByUring();
+    } else if (_sendBuffer->length > 0) {
+        send(nullptr);
+    } else {
+        // 上层根据实际情况，是发后面的buffer，还是断开链接
+        onGetBuffer();
+    }
+}
+
 void Socket::getLocalInfo()
 {
     if (_family == AF_INET) {
@@ -22,6 +22,7 @@ enum NetType {
 };
 
 class Socket;
+class UringSendBatch;
 
 class SocketBuffer
 {
@@ -63,6 +64,7 @@ public:
     int createUdpSocket(int family);
 
     int setReuseable();
+    int setReusePortSteering(uint32_t offset, uint32_t count);
     int setIpv6Only(bool enable);
     int setNoSigpipe();
     int setNoBlocked();
@@ -72,6 +74,12 @@ public:
     int setCloseWait(int second = 0);
     int setCloExec();
     int setKeepAlive(int interval, int idle, int times);
+    // 组播发送，只支持ipv4
+    int setMulticastTtl(int ttl);
+    int setMulticastLoop(bool enable);
+    int setMulticastIf(const string& localIp);
+    // 加入组播组接收数据，localIp为空时由系统选择网卡
+    int joinMulticast(const string& group, const string& localIp);
     int bind(const uint16_t port, const char *localIp);
     int listen(int backlog);
     bool bindPeerAddr(const struct sockaddr *dst_addr);
@@ -103,7 +111,15 @@ public:
     ssize_t send(const char* data, int len, int flag = true, struct sockaddr *addr = nullptr, socklen_t addr_len = 0);
     ssize_t send(const Buffer::Ptr pkt, int flag = true, int offset = 0, int length = 0, struct sockaddr *addr = nullptr, socklen_t addr_len = 0);
 
-    void setReadCb(const onReadCb& cb) { _onRead = cb;}
+    // file和line默认取调用处的位置，慢回调按读回调的注册位置记录
+    void setReadCb(const onReadCb& cb, const char* file = __builtin_FILE(), int line = __builtin_LINE())
+    {
+        _onRead = cb;
+        _readFile = file;
+        _readLine = line;
+    }
+    // 通用的注册处(TcpServer、TcpClient)下所有会话的读回调位置相同，改为按会话类型记录
+    void setOwner(const std::type_info& type) {_owner = &type;}
     void setWriteCb(const onWriteCb& cb) { _onWrite = cb;}
     void setErrorCb(const onErrorCb& cb) { _onError = cb;}
     void setOnGetBuffer(const function<bool()>& cb) {_onGetBuffer = cb;}
@@ -117,14 +133,23 @@ public:
     void setOnGetRecvBuffer(const function<StreamBuffer::Ptr()>& cb) {_onGetRecvBuffer = cb;}
     StreamBuffer::Ptr onGetRecvBuffer();
 
+private:
+    // io_uring后端: 完成式收发
+    void onUringRecv(int res, char* data, int size, struct sockaddr* addr, int addrLen);
+    void setTraceSite();
+    ssize_t sendByUring();
+    void onUringSend(const shared_ptr<UringSendBatch>& batch, int res);
+
 private:
     bool _isClient = false;
     bool _isConnected = false;
     bool _drop = false;
     int _fd = -1;
     int _family = AF_INET;
-    int _type = 1;
+    int _type = SOCKET_TCP;
     int _localPort = -1;
+    int _uringSending = 0;
+    bool _uringRetry = false;
     int _peerPort = -1;
     size_t _remainSize = 0;
     string _localIp;
@@ -139,6 +164,9 @@ private:
     onErrorCb _onError;
     function<bool()> _onGetBuffer;
     function<StreamBuffer::Ptr()> _onGetRecvBuffer;
+    const char* _readFile = nullptr;
+    int _readLine = 0;
+    const std::type_info* _owner = nullptr;
 };
 
 #endif //Socket_h
\ No newline at end of file
@@ -19,8 +19,6 @@ using namespace std;
 
 #ifdef ENABLE_SRT
 
-#define POLLING_TIME 1
-
 bool SrtSocket::_srtInited = false;
 
 static int setIpv6Only(int fd, bool flag)
@@ -111,6 +109,8 @@ SrtSocket::SrtSocket(const SrtEventLoop::Ptr& loop, int fd)
     ,_fd(fd)
 {
     logTrace << "SrtSocket";
+    // accept出来的socket已经完成握手
+    _isConnected = fd > 0;
 }
 
 SrtSocket::~SrtSocket()
@@ -273,66 +273,6 @@ int SrtSocket::setNoBlocked(int enable)
     return srt_setsockopt(_fd, 0, SRTO_RCVSYN, &blocking, sizeof(blocking));
 }
 
-int SrtSocket::epollCreate(int write)
-{
-    int modes = SRT_EPOLL_ERR | (write ? SRT_EPOLL_OUT : SRT_EPOLL_IN);
-    int eid = srt_epoll_create();
-    if (eid < 0) {
-        return srtErrno();
-    }
-
-    if (srt_epoll_add_usock(eid, _fd, &modes) < 0) {
-        srt_epoll_release(eid);
-        return srtErrno();
-    }
-
-    return eid;
-}
-
-int SrtSocket::networkWaitFd(int eid, int write)
-{
-    int ret, len = 1, errlen = 1;
-    SRTSOCKET ready[1];
-    SRTSOCKET error[1];
-
-    if (write) {
-        ret = srt_epoll_wait(eid, error, &errlen, ready, &len, POLLING_TIME, 0, 0, 0, 0);
-    } else {
-        ret = srt_epoll_wait(eid, ready, &len, error, &errlen, POLLING_TIME, 0, 0, 0, 0);
-    }
-    if (ret < 0) {
-        if (srt_getlasterror(NULL) == SRT_ETIMEOUT)
-            ret = EAGAIN;
-        else
-            ret = srtErrno();
-    } else {
-        ret = errlen ? EIO : 0;
-    }
-
-    return ret;
-}
-
-int SrtSocket::networkWaitFdTimeout(int eid, int write, int64_t timeout)
-{
-    int ret;
-    int64_t wait_start = 0;
-
-    while (1) {
-        ret = networkWaitFd(eid, write);
-        if (ret != EAGAIN) {
-            return ret;
-        }
-        
-        if (timeout > 0) {
-            if (!wait_start)
-                wait_start = TimeClock::now();
-            else if (TimeClock::now() - wait_start > timeout)
-                return ETIMEDOUT;
-        }
-    }
-}
-
-
 int SrtSocket::setReuseable()
 {
     int opt = 1;
@@ -441,7 +381,7 @@ int SrtSocket::bind(const uint16_t port, const char *localIp)
 int SrtSocket::listen(int backlog)
 {
     //开始监听
-    if (srt_listen(_fd, 1)) {
+    if (srt_listen(_fd, backlog)) {
         logInfo << "Listen socket failed: " << srtErrno();
         close();
         return -1;
@@ -457,8 +397,6 @@ int SrtSocket::accept()
     char ip[30] = {0};
     struct sockaddr_in * addrtmp;
 
-    logInfo << "accept fd: " << _fd;
-
     int new_sock = srt_accept(_fd, (struct sockaddr*)&scl, &sclen);//NULL, NULL);//(sockaddr*)&scl, &sclen);
     if (new_sock == SRT_INVALID_SOCK) {
         int err_no = srtErrno();
@@ -483,42 +421,70 @@ int SrtSocket::connect(const string& peerIp, int port, int timeout)
         return -1;
     }
 
-    // struct timeval timeo = {3, 0};
-    // timeo.tv_sec = timeout;
-    // setsockopt(_fd, SOL_SOCKET, SRTO_SNDTIMEO, &timeo, sizeof(timeo));
-    int conn_timeout_len = sizeof(timeout);
-    srt_getsockopt(_fd, 0, SRTO_CONNTIMEO, &timeout, &conn_timeout_len);
+    if (timeout > 0) {
+        srt_setsockopt(_fd, 0, SRTO_CONNTIMEO, &timeout, sizeof(timeout));
+    }
 
     ((sockaddr_in *) &addr)->sin_port = htons(port);
-    errno = 0;
-    if (srt_connect(_fd, (sockaddr *) &addr, sizeof(sockaddr_in)) >= 0) {
-        addToEpoll();
-        //同步连接成功
+    // 非阻塞模式下srt_connect立即返回，握手由srt的线程完成，
+    // 连接成功时可写，失败时报错误事件，都在loop的srt epoll上等，不阻塞loop
+    if (srt_connect(_fd, (sockaddr *) &addr, sizeof(sockaddr_in)) == SRT_ERROR) {
+        logInfo << "srt connect failed: " << srt_getlasterror_str();
+        return -1;
+    }
+
+    _isConnecting = true;
+    _writeEvent = true;
+    SrtSocket::Wptr weakSocket = shared_from_this();
+    _loop->addEvent(_fd, 1, [weakSocket](int event, void* args){
+        auto socket = weakSocket.lock();
+        if (!socket) {
+            return ;
+        }
+        socket->handleEvent(event, args);
+    });
+
+    // srt自己有连接超时，这里再加一个定时器兜底
+    _loop->addTimerTask((timeout > 0 ? timeout : 3000) + 100, [weakSocket](){
+        auto socket = weakSocket.lock();
+        if (socket && socket->_isConnecting) {
+            logInfo << "srt connect timeout, fd: " << socket->_fd;
+            socket->onConnect(false);
+        }
         return 0;
+    }, nullptr);
+
+    return 0;
+}
+
+void SrtSocket::onConnect(bool ok)
+{
+    if (!_isConnecting) {
+        return ;
     }
-    
-    // logInfo << "errno: " << errno;
-    // if (errno == 115) {
-    //     addToEpoll();
-    //     weak_ptr<SrtSocket> wSelf = shared_from_this();
-    //     _loop->addTimerTask(timeout * 1000, [wSelf](){
-    //         logInfo << "time task start";
-    //         auto self = wSelf.lock();
-    //         if (!self) {
-    //             return 0;
-    //         }
-    //         logInfo << "time task connect: " << self->_isConnected;
-    //         if (self->_isConnected) {
-    //             return 0;
-    //         }
-    //         self->onError(nullptr);
-    //         return 0;
-    //     }, [](bool success, const shared_ptr<TimerTask>& task){});
-
-    //     return 0;
-    // }
+    _isConnecting = false;
+    _isConnected = ok;
 
-    return -1;
+    if (ok) {
+        // 连接成功后只关注读，有待发的数据时继续关注写
+        setWriteEvent(_remainSize > 0);
+    }
+
+    if (_onConnect) {
+        auto cb = _onConnect;
+        cb(ok);
+    } else if (!ok && _onError) {
+        _onError();
+    }
+}
+
+void SrtSocket::setWriteEvent(bool enable)
+{
+    if (_writeEvent == enable || _fd <= 0) {
+        return ;
+    }
+    _writeEvent = enable;
+    _loop->modifyEvent(_fd, enable ? 1 : 0, nullptr);
 }
 
 void SrtSocket::handleEvent(int event, void* args)
@@ -528,6 +494,17 @@ void SrtSocket::handleEvent(int event, void* args)
         onAccept(args);
         return ;
     }
+    if (_isConnecting) {
+        // 连接中只关注了写和错误事件
+        auto state = srt_getsockstate(_fd);
+        if (state == SRTS_CONNECTED) {
+            onConnect(true);
+        } else if ((event & EPOLLERR) || state >= SRTS_BROKEN) {
+            logInfo << "srt connect failed, fd: " << _fd << ", reason: " << srt_rejectreason_str(srt_getrejectreason(_fd));
+            onConnect(false);
+        }
+        return ;
+    }
     // logInfo << "EPOLLIN: " << EPOLLIN;
     // logInfo << "EPOLLOUT: " << EPOLLOUT;
     // logInfo << "EPOLLERR: " << EPOLLERR;
@@ -537,10 +514,6 @@ void SrtSocket::handleEvent(int event, void* args)
         onRead(args);
     } 
     if (event & EPOLLOUT) {
-        logInfo << "handle write";
-        if (!_isConnected) {
-            _isConnected = true;
-        }
         onWrite(args);
     } 
     if (event & EPOLLERR || event & EPOLLHUP) {
@@ -623,8 +596,8 @@ int SrtSocket::onWrite(void* args)
     }
 
     if (_readyBuffer.size() == 0) {
-        logInfo << "no buffer to send";
-        _loop->modifyEvent(_fd, 1, nullptr);
+        // 没有待发的数据，回到只关注读，避免可写事件一直触发
+        setWriteEvent(false);
         return 0;
     }
 
@@ -673,6 +646,7 @@ int SrtSocket::close()
         srt_close(_fd);
         _fd = 0;
     }
+    _isConnecting = false;
 
     return 0;
 }
@@ -714,6 +688,11 @@ ssize_t SrtSocket::send(const Buffer::Ptr pkt, int flag, int offset, struct sock
         // logInfo << "send pkt size: " << 0 << ", flag : " << flag;
     }
 
+    // 还在握手，先缓存，连接成功后再发
+    if (_isConnecting) {
+        return 0;
+    }
+
     int readySize = _readyBuffer.size();
     if (readySize == 0) {
         // logInfo << "_readyBuffer empty";
@@ -759,9 +738,7 @@ ssize_t SrtSocket::send(const Buffer::Ptr pkt, int flag, int offset, struct sock
     // logInfo << "_remainSize: " << _remainSize;
     // logInfo << "totalSendSize: " << totalSendSize;
 
-    if (_remainSize > 0) {
-        _loop->modifyEvent(_fd, 1, nullptr);
-    }
+    setWriteEvent(_remainSize > 0);
 
     return totalSendSize;
 }
@@ -29,6 +29,7 @@ public:
     using onReadCb = function<int(const StreamBuffer::Ptr& buffer, struct sockaddr* addr, int len)>;
     using onWriteCb = function<void()>;
     using onErrorCb = function<void()>;
+    using onConnectCb = function<void(bool ok)>;
     SrtSocket(const SrtEventLoop::Ptr& loop);
     SrtSocket(const SrtEventLoop::Ptr& loop, bool isListen);
     SrtSocket(const SrtEventLoop::Ptr& loop, int fd);
@@ -47,9 +48,6 @@ public:
     int setsockopt(int fd, int level, SRT_SOCKOPT optname, const void * optval, int optlen);
     int getsockopt(SRT_SOCKOPT optname, const char * optnamestr, void * optval, int * optlen);
 
-    int epollCreate(int write);
-    int networkWaitFd(int eid, int write);
-    int networkWaitFdTimeout(int eid, int write, int64_t timeout);
     int setReuseable();
     int setNoSigpipe();
     int setNoBlocked(int enable);
@@ -60,7 +58,9 @@ public:
     int bind(const uint16_t port, const char *localIp);
     int listen(int backlog);
     int accept();
-    int connect(const string& peetIp, int port, int timeout = 5);
+    // 非阻塞连接，握手在loop的srt epoll上完成，结果通过setConnectCb回调，timeout单位ms
+    int connect(const string& peetIp, int port, int timeout = 5000);
+    bool isConnected() {return _isConnected;}
 
     int getFd() {return _fd;}
     int getLocalPort();
@@ -85,15 +85,22 @@ public:
     void setWriteCb(const onWriteCb& cb) { _onWrite = cb;}
     void setErrorCb(const onErrorCb& cb) { _onError = cb;}
     void setAcceptCb(const onWriteCb& cb) { _onAccept = cb;}
+    void setConnectCb(const onConnectCb& cb) { _onConnect = cb;}
 
     SrtEventLoop::Ptr getLoop() {return _loop;}
     int setOptionsPost();
 
+private:
+    void onConnect(bool ok);
+    void setWriteEvent(bool enable);
+
 private:
     static bool _srtInited;
     bool _isListen = false;
     bool _isClient = false;
     bool _isConnected = false;
+    bool _isConnecting = false;
+    bool _writeEvent = false;
 
     int _inputbw = -1;
     int _oheadbw = -1;
@@ -142,6 +149,7 @@ private:
     onWriteCb _onWrite;
     onWriteCb _onAccept;
     onErrorCb _onError;
+    onConnectCb _onConnect;
 };
 
 #endif
@@ -88,6 +88,7 @@ int TcpClient::create(const string& localIp, int localPort)
         self->onRecv(buffer, addr, len);
         return 0;
     });
+    _socket->setOwner(typeid(*this));
     _socket->setErrorCb([wSelf](const std::string& errMsg){
         auto self = wSelf.lock();
         if (!self) {
@@ -199,4 +200,17 @@ ssize_t TcpClient::send(Buffer::Ptr pkt)
     } else {
         return _socket->send(pkt);
     }
+}
+
+ssize_t TcpClient::send(Buffer::Ptr pkt, bool flush)
+{
+    if (!_socket) {
+        return 0;
+    }
+    
+    if (_tlsCtx) {
+        return _tlsCtx->send(pkt);
+    } else {
+        return _socket->send(pkt, flush);
+    }
 }
\ No newline at end of file
@@ -34,6 +34,8 @@ public:
     virtual void close();
     virtual void onConnect() {}
     ssize_t send(Buffer::Ptr pkt);
+    // flush为false时只放进发送队列，和后面的包一起发出去
+    ssize_t send(Buffer::Ptr pkt, bool flush);
 
     int getLocalPort() {return _localPort;}
     int getPeerPort() {return _peerPort;}
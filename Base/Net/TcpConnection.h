@@ -32,6 +32,8 @@ public:
     virtual void init() {}
     virtual void close();
     virtual ssize_t send(Buffer::Ptr pkt);
+    // flush为false时只放进发送队列，和后面的包一起发出去，用于头和负载分开的包
+    ssize_t send(Buffer::Ptr pkt, bool flush);
 
     // session结束时，从tcpserver中删除
     void setCloseCallback(closeCb cb) {_closeCb = cb;}
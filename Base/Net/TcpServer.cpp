@@ -1,11 +1,14 @@
 ﻿#include "TcpServer.h"
 #include "Logger.h"
 #include "Util/TimeClock.h"
+#include "EventPoller/EventLoopPool.h"
 
 #include <cstring>
+#include <vector>
 #include <iostream>
 
 #include <errno.h>
+#include <unistd.h>
 #include <sys/epoll.h>
 #include <netinet/in.h>
 
@@ -34,14 +37,27 @@ void TcpServer::start(NetType type)
     _socket->listen(1024);
 
     TcpServer::Wptr weakServer = shared_from_this();
-    _loop->addEvent(_socket->getFd(), EPOLLIN | EPOLLHUP | EPOLLERR | 0, [weakServer](int event, void* args){
-        auto server = weakServer.lock();
-        if (!server) {
-            logInfo << "server exit";
-            return ;
-        }
-        server->accept(event, args);
-    }, nullptr);
+    if (_loop->isUring()) {
+        // 多发accept，每个新连接一个完成事件
+        _loop->addAccept(_socket->getFd(), [weakServer](int connFd){
+            auto server = weakServer.lock();
+            if (!server) {
+                ::close(connFd);
+                return ;
+            }
+            server->_lastAcceptTime = TimeClock::now();
+            server->onAccept(connFd);
+        });
+    } else {
+        _loop->addEvent(_socket->getFd(), EPOLLIN | EPOLLHUP | EPOLLERR | 0, [weakServer](int event, void* args){
+            auto server = weakServer.lock();
+            if (!server) {
+                logInfo << "server exit";
+                return ;
+            }
+            server->accept(event, args);
+        }, nullptr);
+    }
     // std::bind(&TcpServer::accept, shared_from_this(), placeholders::_1, placeholders::_2), nullptr);
 
     _loop->addTimerTask(2000, [weakServer](){
@@ -68,6 +84,7 @@ void TcpServer::accept(int event, void* args)
         if (event & EPOLLIN) {
             do {
                 connFd = (int)::accept(_socket->getFd(), (struct sockaddr *)&peer_addr, &addr_len);
+                _loop->addSyscall();
             } while (0 /*-1 == fd && UV_EINTR == get_uv_error(true)*/);
         }
 
@@ -96,62 +113,7 @@ void TcpServer::accept(int event, void* args)
                 break;
             }
         } else {
-            // 暂时分配到当前loop，后续根据测试结果修改
-            Socket::Ptr socket(new Socket(_loop, connFd));
-            socket->setReuseable();
-            socket->setNoSigpipe();
-            socket->setNoBlocked();
-            socket->setNoDelay();
-            socket->setSendBuf();
-            socket->setRecvBuf();
-            socket->setCloseWait();
-            socket->setCloExec();
-            socket->setFamily(_socket->getFamily());
-
-            TcpConnection::Ptr session = createSession(_loop, socket);
-            session->init();
-
-            Socket::Wptr weakSocket = socket;
-            _loop->addEvent(connFd, EPOLLIN | EPOLLHUP | EPOLLERR | EPOLLOUT | 0, [weakSocket](int event, void* args){
-                auto socket = weakSocket.lock();
-                if (!socket) {
-                    return ;
-                }
-                socket->handleEvent(event, args);
-            });
-
-            session->setCloseCallback([wServer](TcpConnection::Ptr session){
-                auto server = wServer.lock();
-                if (!server) {
-                    return ;
-                }
-                logTrace << "port: " << server->_port << ", close: " << session->getSocket()->getFd();
-                server->_mapSession.erase(session->getSocket()->getFd());
-                server->_curConns = server->_mapSession.size();
-            });
-
-            TcpConnection::Wptr weakSession = session;
-            socket->setReadCb([weakSession](const StreamBuffer::Ptr& buffer, struct sockaddr* addr, int len){
-                auto session = weakSession.lock();
-                if (!session) {
-                    return -1;
-                }
-                session->onRecv(buffer, addr, len);
-                return 0;
-            });
-            socket->setErrorCb([weakSession](const std::string& errMsg){
-                auto session = weakSession.lock();
-                if (!session) {
-                    return -1;
-                }
-                session->onError(errMsg);
-                return 0;
-            });
-            
-            // logInfo << "add session";
-            _mapSession.emplace(socket->getFd(), session);
-            _curConns = _mapSession.size();
-            logTrace << "port: " << _port  << ",add session: " << _mapSession.size();
+            onAccept(connFd);
         }
 
         if (event & (EPOLLHUP | EPOLLERR)) {
@@ -161,6 +123,103 @@ void TcpServer::accept(int event, void* args)
 }
 
 
+void TcpServer::onAccept(int connFd)
+{
+    weak_ptr<TcpServer> wServer = shared_from_this();
+    // 根据负载均衡策略选择loop，默认仍分配到当前loop
+    auto loop = EventLoopPool::instance()->getLoopForSession(_loop);
+    Socket::Ptr socket(new Socket(loop, connFd));
+    socket->setReuseable();
+    socket->setNoSigpipe();
+    socket->setNoBlocked();
+    socket->setNoDelay();
+    socket->setSendBuf();
+    socket->setRecvBuf();
+    socket->setCloseWait();
+    socket->setCloExec();
+    socket->setFamily(_socket->getFamily());
+
+    TcpConnection::Ptr session = createSession(loop, socket);
+    TcpSessionMap::Wptr wSessionMap = getSessionMap(loop);
+
+    session->setCloseCallback([wServer, wSessionMap, connFd](TcpConnection::Ptr session){
+        auto server = wServer.lock();
+        auto sessionMap = wSessionMap.lock();
+        if (!server || !sessionMap) {
+            return ;
+        }
+        logTrace << "port: " << server->_port << ", close: " << connFd;
+        auto delSession = [server, sessionMap, connFd, session](){
+            auto it = sessionMap->sessions.find(connFd);
+            if (it != sessionMap->sessions.end() && it->second == session) {
+                sessionMap->sessions.erase(it);
+                sessionMap->loop->addConnection(-1);
+                --server->_curConns;
+            }
+        };
+        // 会话表只在所属loop里修改，其他线程关闭或正在遍历时切回loop再删
+        if (sessionMap->loop->isCurrent() && !sessionMap->managing) {
+            delSession();
+        } else {
+            sessionMap->loop->async(delSession, false);
+        }
+    });
+
+    TcpConnection::Wptr weakSession = session;
+    socket->setReadCb([weakSession](const StreamBuffer::Ptr& buffer, struct sockaddr* addr, int len){
+        auto session = weakSession.lock();
+        if (!session) {
+            return -1;
+        }
+        session->onRecv(buffer, addr, len);
+        return 0;
+    });
+    socket->setOwner(typeid(*session));
+    socket->setErrorCb([weakSession](const std::string& errMsg){
+        auto session = weakSession.lock();
+        if (!session) {
+            return -1;
+        }
+        session->onError(errMsg);
+        return 0;
+    });
+
+    // logInfo << "add session";
+    ++_curConns;
+    loop->addConnection(1);
+    logTrace << "port: " << _port  << ",add session: " << _curConns.load();
+
+    Socket::Wptr weakSocket = socket;
+    auto addToLoop = [session, loop, connFd, weakSocket, wSessionMap](){
+        auto sessionMap = wSessionMap.lock();
+        if (sessionMap) {
+            sessionMap->sessions[connFd] = session;
+        }
+        session->init();
+        if (loop->isUring()) {
+            auto socket = weakSocket.lock();
+            if (socket) {
+                socket->addToEpoll();
+            }
+            return ;
+        }
+        loop->addEvent(connFd, EPOLLIN | EPOLLHUP | EPOLLERR | EPOLLOUT | 0, [weakSocket](int event, void* args){
+            auto socket = weakSocket.lock();
+            if (!socket) {
+                return ;
+            }
+            socket->handleEvent(event, args);
+        });
+    };
+
+    if (loop == _loop) {
+        addToLoop();
+    } else {
+        // 会话的初始化和事件注册都在目标loop上执行
+        loop->async(addToLoop, false);
+    }
+}
+
 TcpConnection::Ptr TcpServer::createSession(const EventLoop::Ptr& loop, const Socket::Ptr& socket)
 {
     if (_createSessionCb) {
@@ -170,17 +229,57 @@ TcpConnection::Ptr TcpServer::createSession(const EventLoop::Ptr& loop, const So
     }
 }
 
-void TcpServer::onManager()
+TcpSessionMap::Ptr TcpServer::getSessionMap(const EventLoop::Ptr& loop)
 {
-    // logInfo << "manager: " << _mapSession.size();
-    assert(_loop->isCurrent());
-    for (auto &session : _mapSession) {
-        //遍历时，可能触发onErr事件(也会操作_session_map)
+    lock_guard<mutex> lck(_mtx);
+    auto& sessionMap = _mapLoopSession[loop.get()];
+    if (!sessionMap) {
+        sessionMap = make_shared<TcpSessionMap>();
+        sessionMap->loop = loop;
+    }
+
+    return sessionMap;
+}
+
+void TcpServer::manageSessions(const TcpSessionMap::Ptr& sessionMap, int port)
+{
+    sessionMap->managing = true;
+    for (auto &session : sessionMap->sessions) {
+        //遍历时，可能触发onErr事件，关闭的会话由close回调延后删除
         try {
-            // onManger中不要执行close函数，会破坏map迭代器
             session.second->onManager();
         } catch (exception &ex) {
-            logWarn << "port: " << _port << ", error: " << ex.what();
+            logWarn << "port: " << port << ", error: " << ex.what();
         }
     }
-}
\ No newline at end of file
+    sessionMap->managing = false;
+}
+
+void TcpServer::onManager()
+{
+    assert(_loop->isCurrent());
+    // 只拷贝每个loop的表指针，会话表由各自的loop遍历
+    vector<TcpSessionMap::Ptr> sessionMaps;
+    {
+        lock_guard<mutex> lck(_mtx);
+        sessionMaps.reserve(_mapLoopSession.size());
+        for (auto &iter : _mapLoopSession) {
+            sessionMaps.push_back(iter.second);
+        }
+    }
+
+    int port = _port;
+    for (auto &sessionMap : sessionMaps) {
+        if (sessionMap->loop == _loop) {
+            manageSessions(sessionMap, port);
+            continue;
+        }
+        TcpSessionMap::Wptr wSessionMap = sessionMap;
+        sessionMap->loop->async([wSessionMap, port](){
+            auto sessionMap = wSessionMap.lock();
+            if (sessionMap) {
+                manageSessions(sessionMap, port);
+            }
+        }, false);
+    }
+}
@@ -4,6 +4,7 @@
 #include <string>
 #include <unordered_map>
 #include <mutex>
+#include <atomic>
 #include <memory>
 
 #include "EventPoller/EventLoop.h"
@@ -12,7 +13,17 @@
 
 using namespace std;
 
+// 一个loop上的会话，只在该loop线程里增删和遍历
+class TcpSessionMap {
+public:
+    using Ptr = shared_ptr<TcpSessionMap>;
+    using Wptr = weak_ptr<TcpSessionMap>;
 
+    EventLoop::Ptr loop;
+    // 遍历中关闭的会话延后删除，避免破坏迭代器
+    bool managing = false;
+    unordered_map<int, TcpConnection::Ptr> sessions;
+};
 
 class TcpServer  : public std::enable_shared_from_this<TcpServer> {
 public:
@@ -25,23 +36,30 @@ public:
 public:
     void start(NetType type = NET_IPV4);
     void accept(int event, void* args);
+    void onAccept(int connFd);
     TcpConnection::Ptr createSession(const EventLoop::Ptr& loop, const Socket::Ptr& socket);
     void setOnCreateSession(createSessionCb cb) {_createSessionCb = cb;}
     void onManager();
     int getPort() {return _port;}
     int getLastAcceptTime() {return _lastAcceptTime;}
-    int getCurConnNum() {return _curConns;}
+    int getCurConnNum() {return _curConns.load();}
+
+private:
+    TcpSessionMap::Ptr getSessionMap(const EventLoop::Ptr& loop);
+    static void manageSessions(const TcpSessionMap::Ptr& sessionMap, int port);
 
 private:
     int _maxConns;
     int _threadNum;
     int _port;
     int _lastAcceptTime = 0;
-    int _curConns = 0;
+    atomic<int> _curConns{0};
     string _ip;
     EventLoop::Ptr _loop;
     Socket::Ptr _socket;
-    unordered_map<int, TcpConnection::Ptr> _mapSession;
+    // 负载均衡后会话分布在不同loop上，按loop分表，锁只保护表的索引
+    mutex _mtx;
+    unordered_map<EventLoop*, TcpSessionMap::Ptr> _mapLoopSession;
     createSessionCb _createSessionCb;
 };
 
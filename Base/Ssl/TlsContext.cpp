@@ -1,73 +1,199 @@
 #include "TlsContext.h"
+#include "TlsTicketKeys.h"
 #include "Log/Logger.h"
 #include "Util/Thread.h"
 
+#include <mutex>
+#include <cstring>
 #include <openssl/err.h>
+#include <openssl/rand.h>
+#include <openssl/hmac.h>
 
 string TlsContext::_keyFile;
 string TlsContext::_crtFile;
+bool TlsContext::_enableKtls = false;
+
+static mutex g_sslCtxMtx;
+static shared_ptr<SSL_CTX> g_serverCtx;
+static shared_ptr<SSL_CTX> g_clientCtx;
+
+static string getSslErrorString()
+{
+    unsigned long code = ERR_get_error();
+    auto buffer = ERR_reason_error_string(code);
+
+    return buffer ? buffer : "";
+}
+
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+#include <openssl/core_names.h>
+
+using TicketHmacCtx = EVP_MAC_CTX;
+
+static bool initTicketHmac(EVP_MAC_CTX* hctx, uint8_t* key, size_t size)
+{
+    OSSL_PARAM params[] = {
+        OSSL_PARAM_construct_octet_string(OSSL_MAC_PARAM_KEY, key, size),
+        OSSL_PARAM_construct_utf8_string(OSSL_MAC_PARAM_DIGEST, (char*)"SHA256", 0),
+        OSSL_PARAM_construct_end()
+    };
+
+    return EVP_MAC_CTX_set_params(hctx, params) == 1;
+}
+#else
+using TicketHmacCtx = HMAC_CTX;
+
+static bool initTicketHmac(HMAC_CTX* hctx, uint8_t* key, size_t size)
+{
+    return HMAC_Init_ex(hctx, key, size, EVP_sha256(), nullptr) == 1;
+}
+#endif
+
+// 票据的加解密密钥来自TlsTicketKeys，所有loop一致，定期轮换
+static int onTicketKey(SSL* ssl, unsigned char* name, unsigned char* iv, 
+                        EVP_CIPHER_CTX* ctx, TicketHmacCtx* hctx, int enc)
+{
+    TlsTicketKeys::Key key;
+    if (enc) {
+        if (!TlsTicketKeys::instance().getEncryptKey(key) || RAND_bytes(iv, EVP_MAX_IV_LENGTH) != 1) {
+            return -1;
+        }
+        memcpy(name, key.name, sizeof(key.name));
+        if (EVP_EncryptInit_ex(ctx, EVP_aes_256_cbc(), nullptr, key.aesKey, iv) != 1 ||
+            !initTicketHmac(hctx, key.hmacKey, sizeof(key.hmacKey)))
+        {
+            return -1;
+        }
+
+        return 1;
+    }
+
+    bool renew = false;
+    if (!TlsTicketKeys::instance().getDecryptKey(name, key, renew)) {
+        // 密钥已过期，走完整握手
+        return 0;
+    }
+    if (!initTicketHmac(hctx, key.hmacKey, sizeof(key.hmacKey)) ||
+        EVP_DecryptInit_ex(ctx, EVP_aes_256_cbc(), nullptr, key.aesKey, iv) != 1)
+    {
+        return -1;
+    }
+
+    // tls1.3的票据只用一次，复用后要换发新票据；返回1时openssl不会再发
+    if (renew || SSL_version(ssl) >= TLS1_3_VERSION) {
+        return 2;
+    }
+
+    return 1;
+}
 
 TlsContext::TlsContext(bool server, const Socket::Ptr& socket)
     :_server(server)
     ,_socket(socket)
 {
-    SSL_library_init();
-    SSL_load_error_strings();
-    OpenSSL_add_all_digests();
-    OpenSSL_add_all_ciphers();
-    OpenSSL_add_all_algorithms();
 }
 
 TlsContext::~TlsContext()
-{}
+{
+    // 握手期间_bioOut没有交给ssl管理
+    if (_bioOut && (!_ssl || SSL_get_wbio(_ssl.get()) != _bioOut)) {
+        BIO_free(_bioOut);
+    }
+}
 
 void TlsContext::setKeyFile(const string& keyFile, const string& crtFile)
 {
+    lock_guard<mutex> lock(g_sslCtxMtx);
     _keyFile = keyFile;
     _crtFile = crtFile;
+    // 证书变化后重新创建，已有连接继续使用旧的
+    g_serverCtx.reset();
+    g_clientCtx.reset();
 }
 
-void TlsContext::initSsl()
+void TlsContext::setEnableKtls(bool enable)
 {
-    SSL_CTX* sslCtx;
-#if (OPENSSL_VERSION_NUMBER < 0x10002000L) // v1.0.2
-    sslCtx = SSL_CTX_new(TLS_method());
-#else
-    sslCtx = SSL_CTX_new(TLS_method());
-#endif
-    _sslCtx.reset(sslCtx, [](SSL_CTX *ptr){ SSL_CTX_free(ptr); });
+    _enableKtls = enable;
+}
 
-    if (!_sslCtx) {
+void TlsContext::setTicketLifetime(int seconds)
+{
+    TlsTicketKeys::instance().setLifetime(seconds);
+}
+
+shared_ptr<SSL_CTX> TlsContext::getSslCtx(bool server)
+{
+    lock_guard<mutex> lock(g_sslCtxMtx);
+    auto& sslCtx = server ? g_serverCtx : g_clientCtx;
+    if (!sslCtx) {
+        sslCtx = createSslCtx(server);
+    }
+
+    return sslCtx;
+}
+
+shared_ptr<SSL_CTX> TlsContext::createSslCtx(bool server)
+{
+    SSL_library_init();
+    SSL_load_error_strings();
+    OpenSSL_add_all_digests();
+    OpenSSL_add_all_ciphers();
+    OpenSSL_add_all_algorithms();
+
+    shared_ptr<SSL_CTX> sslCtx(SSL_CTX_new(TLS_method()), [](SSL_CTX *ptr){ SSL_CTX_free(ptr); });
+    if (!sslCtx) {
         ERR_print_errors_fp(stderr);
         logError << "SSL_CTX_new failed";
-        return ;
+        return nullptr;
     }
 
-    SSL_CTX_set_verify(_sslCtx.get(), SSL_VERIFY_NONE, NULL);
-    if (SSL_CTX_set_cipher_list(_sslCtx.get(), "ALL") != 1) {
-        logError << "SSL_CTX_set_cipher_list failed: " << getSslError();
-        return ;
+    SSL_CTX_set_verify(sslCtx.get(), SSL_VERIFY_NONE, NULL);
+    if (SSL_CTX_set_cipher_list(sslCtx.get(), "ALL") != 1) {
+        logError << "SSL_CTX_set_cipher_list failed: " << getSslErrorString();
+        return nullptr;
     }
 
     // 载入用户的数字证书， 此证书用来发送给客户端。证书里包含有公钥
-    if (SSL_CTX_use_certificate_file(_sslCtx.get(), _crtFile.c_str() /*"cert.pem"*/, SSL_FILETYPE_PEM) <= 0) {
+    if (SSL_CTX_use_certificate_file(sslCtx.get(), _crtFile.c_str() /*"cert.pem"*/, SSL_FILETYPE_PEM) <= 0) {
         ERR_print_errors_fp(stderr);
-        logError << "SSL_CTX_use_certificate_file failed: " << getSslError();
-        return ;
+        logError << "SSL_CTX_use_certificate_file failed: " << getSslErrorString();
+        return nullptr;
     }
 
     // 载入用户私钥
-    if (SSL_CTX_use_PrivateKey_file(_sslCtx.get(), _keyFile.c_str()/*"key.pem"*/, SSL_FILETYPE_PEM) <= 0) {
+    if (SSL_CTX_use_PrivateKey_file(sslCtx.get(), _keyFile.c_str()/*"key.pem"*/, SSL_FILETYPE_PEM) <= 0) {
         ERR_print_errors_fp(stderr);
-        logError << "SSL_CTX_use_PrivateKey_file failed: " << getSslError();
-        return;
+        logError << "SSL_CTX_use_PrivateKey_file failed: " << getSslErrorString();
+        return nullptr;
     }
 
     // 检查用户私钥是否正确
-    if (!SSL_CTX_check_private_key(_sslCtx.get())) {
+    if (!SSL_CTX_check_private_key(sslCtx.get())) {
         ERR_print_errors_fp(stdout);
-        logError << "SSL_CTX_check_private_key failed: " << getSslError();
-        return;
+        logError << "SSL_CTX_check_private_key failed: " << getSslErrorString();
+        return nullptr;
+    }
+
+    if (server) {
+        // tls1.2的session id缓存，openssl内部加锁，多个loop共用
+        static const unsigned char sessionIdContext[] = "sms";
+        SSL_CTX_set_session_cache_mode(sslCtx.get(), SSL_SESS_CACHE_SERVER);
+        SSL_CTX_set_session_id_context(sslCtx.get(), sessionIdContext, sizeof(sessionIdContext) - 1);
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+        SSL_CTX_set_tlsext_ticket_key_evp_cb(sslCtx.get(), onTicketKey);
+#else
+        SSL_CTX_set_tlsext_ticket_key_cb(sslCtx.get(), onTicketKey);
+#endif
+    }
+
+    return sslCtx;
+}
+
+void TlsContext::initSsl()
+{
+    _sslCtx = getSslCtx(_server);
+    if (!_sslCtx) {
+        return ;
     }
 
     auto sslPtr = SSL_new(_sslCtx.get());
@@ -91,7 +217,15 @@ void TlsContext::initSsl()
         logError << "BIO_new out failed";
     }
 
-    SSL_set_bio(_ssl.get(), _bioIn, _bioOut);
+#ifdef SSL_OP_ENABLE_KTLS
+    // openssl只在写bio是socket时开启ktls，握手期间直接写socket，握手完成后再决定是否改回内存bio
+    if (_enableKtls && _server && _socket && _socket->getFd() > 0) {
+        _bioSock = BIO_new_socket(_socket->getFd(), BIO_NOCLOSE);
+        SSL_set_options(_ssl.get(), SSL_OP_ENABLE_KTLS);
+    }
+#endif
+
+    SSL_set_bio(_ssl.get(), _bioIn, _bioSock ? _bioSock : _bioOut);
 
     // SSL setup active, as server role.
     if (_server) {
@@ -152,10 +286,16 @@ void TlsContext::onRead(const StreamBuffer::Ptr &buffer) {
             if (r0 == 1 && r1 == SSL_ERROR_NONE) {
                 logInfo << "handshake success =================== " << _server;
                 handshakeFlag = 2;
+                _retryHandshake = false;
+                onHandshakeDone();
+                // tls1.2完整握手时服务端最后一轮(ticket、finished)还在内存bio里
+                protect();
                 if (!_server) {
                     send(nullptr);
                 }
                 break;
+            } else if (r1 == SSL_ERROR_WANT_WRITE && _bioSock) {
+                retryHandshake();
             } else {
                 uint8_t* data = nullptr;
                 int size = 0;
@@ -205,6 +345,73 @@ void TlsContext::onRead(const StreamBuffer::Ptr &buffer) {
     }
 }
 
+void TlsContext::retryHandshake()
+{
+    if (_retryHandshake || !_socket) {
+        return ;
+    }
+
+    _retryHandshake = true;
+    weak_ptr<TlsContext> wSelf = shared_from_this();
+    _socket->getLoop()->addTimerTask(5, [wSelf](){
+        auto self = wSelf.lock();
+        // onRead里已经完成握手
+        if (!self || !self->_retryHandshake) {
+            return 0;
+        }
+
+        int r0 = SSL_do_handshake(self->_ssl.get());
+        int r1 = SSL_get_error(self->_ssl.get(), r0);
+        if (r0 != 1 && r1 == SSL_ERROR_WANT_WRITE) {
+            return 5;
+        }
+
+        self->_retryHandshake = false;
+        if (r0 == 1) {
+            logInfo << "handshake success after retry";
+            self->onHandshakeDone();
+            // 发出握手期间缓存的数据，读出对端已经发来的应用数据
+            self->send(nullptr);
+            if (BIO_ctrl_pending(self->_bioIn) > 0) {
+                self->unprotect();
+            }
+        } else if (r1 != SSL_ERROR_WANT_READ) {
+            logError << "handshake failed: " << self->getSslError();
+        }
+        // WANT_READ时等对端的数据，在onRead里继续握手
+        return 0;
+    }, [](bool success, shared_ptr<TimerTask>){
+
+    });
+}
+
+void TlsContext::onHandshakeDone()
+{
+    if (!_bioSock) {
+        return ;
+    }
+
+#ifdef SSL_OP_ENABLE_KTLS
+    if (BIO_get_ktls_send(_bioSock)) {
+        logInfo << "ktls send enabled";
+        _ktlsSend = true;
+        BIO_free(_bioOut);
+        _bioOut = nullptr;
+        // 握手期间缓存的数据
+        while (!_bufferSend.empty()) {
+            _socket->send(_bufferSend.front());
+            _bufferSend.pop_front();
+        }
+        return ;
+    }
+#endif
+
+    // 内核不支持，改回内存bio，加密后的数据走socket的发送队列
+    logDebug << "ktls send not available, fallback to user space";
+    SSL_set0_wbio(_ssl.get(), _bioOut);
+    _bioSock = nullptr;
+}
+
 void TlsContext::unprotect()
 {
     int total = 0;
@@ -258,6 +465,16 @@ ssize_t TlsContext::send(Buffer::Ptr buffer)
         return 0;
     }
 
+    if (_ktlsSend) {
+        // 内核负责加密，明文直接进socket的发送队列
+        while (!_bufferSend.empty()) {
+            totalSendSize += _bufferSend.front()->size();
+            _socket->send(_bufferSend.front());
+            _bufferSend.pop_front();
+        }
+        return totalSendSize;
+    }
+
     if (!SSL_is_init_finished(_ssl.get()) || _bufferSend.empty()) {
         //ssl未握手结束或没有需要发送的数据
         protect();
@@ -300,6 +517,10 @@ ssize_t TlsContext::send(Buffer::Ptr buffer)
 
 void TlsContext::protect()
 {
+    if (!_bioOut) {
+        return ;
+    }
+
     int total = 0;
     int nread = 0;
     auto buffer_bio = make_shared<StreamBuffer>();
@@ -342,10 +563,7 @@ void TlsContext::setOnConnSend(const function<void(const Buffer::Ptr& buffer)>&
 
 string TlsContext::getSslError()
 {
-    unsigned long code = ERR_get_error();
-    auto buffer = ERR_reason_error_string(code);
-    
-    return buffer;
+    return getSslErrorString();
 }
 
 void TlsContext::shutdown()
@@ -20,6 +20,13 @@ public:
 
 public:
     static void setKeyFile(const string& keyFile, const string& crtFile);
+    // 内核tls发送，需要openssl 3.0以上并且内核加载了tls模块，否则自动回退到用户态加密
+    static void setEnableKtls(bool enable);
+    // 会话票据密钥的轮换间隔，秒
+    static void setTicketLifetime(int seconds);
+    // 同一角色的连接共用一个SSL_CTX，证书只加载一次，会话缓存和票据密钥在所有loop间共享
+    static shared_ptr<SSL_CTX> getSslCtx(bool server);
+
     void initSsl();
     void onRead(const StreamBuffer::Ptr& buffer);
     ssize_t send(Buffer::Ptr pkt);
@@ -28,20 +35,33 @@ public:
     void unprotect();
     void protect();
     void handshake();
+    // 已开启内核tls发送，明文直接写socket，可以配合sendfile使用
+    bool isKtlsSend() {return _ktlsSend;}
 
     void setOnConnRead(const function<void(const StreamBuffer::Ptr& buffer)>& cb);
     void setOnConnSend(const function<void(const Buffer::Ptr& buffer)>& cb);
 
+private:
+    static shared_ptr<SSL_CTX> createSslCtx(bool server);
+    void onHandshakeDone();
+    // 握手直接写socket时发送缓冲满(EAGAIN)，待发的握手数据留在openssl里，定时重试直到发出
+    void retryHandshake();
+
 private:
     static string _keyFile;
     static string _crtFile;
+    static bool _enableKtls;
 
     bool _server = true;
     bool _hasHandshake = false;
+    bool _ktlsSend = false;
+    bool _retryHandshake = false;
     int _bufSize = 32 * 1024;
 
     BIO* _bioIn = nullptr;
     BIO* _bioOut = nullptr;
+    // 开启ktls时，握手期间的写bio
+    BIO* _bioSock = nullptr;
     shared_ptr<SSL_CTX> _sslCtx;
     shared_ptr<SSL> _ssl;
     Socket::Ptr _socket;
@@ -0,0 +1,69 @@
+#include "TlsTicketKeys.h"
+#include "Log/Logger.h"
+#include "Util/TimeClock.h"
+
+#include <cstring>
+#include <openssl/rand.h>
+
+TlsTicketKeys& TlsTicketKeys::instance()
+{
+    static TlsTicketKeys instance;
+    return instance;
+}
+
+void TlsTicketKeys::setLifetime(int seconds)
+{
+    lock_guard<mutex> lock(_mtx);
+    if (seconds > 0) {
+        _lifetimeMs = seconds * 1000ULL;
+    }
+}
+
+bool TlsTicketKeys::getEncryptKey(Key& key)
+{
+    lock_guard<mutex> lock(_mtx);
+    auto now = TimeClock::now();
+    if (_keys.empty() || now - _keys.front().createTime >= _lifetimeMs) {
+        if (!rotate(now)) {
+            return false;
+        }
+    }
+    key = _keys.front();
+
+    return true;
+}
+
+bool TlsTicketKeys::getDecryptKey(const uint8_t* name, Key& key, bool& renew)
+{
+    lock_guard<mutex> lock(_mtx);
+    for (size_t i = 0; i < _keys.size(); ++i) {
+        if (memcmp(_keys[i].name, name, sizeof(key.name)) == 0) {
+            key = _keys[i];
+            renew = i != 0;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool TlsTicketKeys::rotate(uint64_t now)
+{
+    Key key;
+    if (RAND_bytes(key.name, sizeof(key.name)) != 1 ||
+        RAND_bytes(key.aesKey, sizeof(key.aesKey)) != 1 ||
+        RAND_bytes(key.hmacKey, sizeof(key.hmacKey)) != 1)
+    {
+        logError << "generate ticket key failed";
+        return false;
+    }
+    key.createTime = now;
+
+    _keys.emplace_front(key);
+    while (_keys.size() > kMaxKeys) {
+        _keys.pop_back();
+    }
+    logInfo << "rotate tls ticket key, keys: " << _keys.size();
+
+    return true;
+}
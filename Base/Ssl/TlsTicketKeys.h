@@ -0,0 +1,44 @@
+#ifndef TlsTicketKeys_H_
+#define TlsTicketKeys_H_
+
+#include <mutex>
+#include <deque>
+#include <cstdint>
+
+using namespace std;
+
+// 会话票据(session ticket)的密钥，所有loop共用一份
+// 当前密钥用于加密新票据，旧密钥保留一段时间用于解密，客户端重连时可以跳过完整握手
+class TlsTicketKeys
+{
+public:
+    struct Key
+    {
+        uint8_t name[16];
+        uint8_t aesKey[32];
+        uint8_t hmacKey[32];
+        uint64_t createTime = 0;
+    };
+
+    static TlsTicketKeys& instance();
+
+    // 密钥轮换间隔，秒
+    void setLifetime(int seconds);
+    // 返回当前用于加密的密钥，到期时先轮换
+    bool getEncryptKey(Key& key);
+    // 按票据里的name查找密钥，renew表示密钥已轮换，需要给客户端换发新票据
+    bool getDecryptKey(const uint8_t* name, Key& key, bool& renew);
+
+private:
+    bool rotate(uint64_t now);
+
+private:
+    // 当前密钥加上最多2个旧密钥，票据最长有效期约为3个轮换周期
+    static const int kMaxKeys = 3;
+
+    uint64_t _lifetimeMs = 3600 * 1000;
+    mutex _mtx;
+    deque<Key> _keys;
+};
+
+#endif //TlsTicketKeys_H_
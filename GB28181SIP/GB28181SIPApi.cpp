@@ -1,4 +1,4 @@
-﻿#include "Api/ApiUtil.h"
+﻿#include "Common/ApiUtil.h"
 #include "Logger.h"
 #include "Common/Config.h"
 #include "Util/String.h"
@@ -20,12 +20,20 @@ void GB28181SIPApi::catalog(const HttpParser& parser, const UrlParser& urlParser
                         const function<void(HttpResponse& rsp)>& rspFunc)
 {
     checkArgs(parser._body, {"deviceId"});
-    auto deviceCtx = GB28181SIPManager::instance()->getContext(parser._body["deviceId"]);
-    deviceCtx->catalog();
-
     HttpResponse rsp;
     rsp._status = 200;
     json value;
+
+    auto deviceCtx = GB28181SIPManager::instance()->getContext(parser._body["deviceId"]);
+    if (!deviceCtx) {
+        value["code"] = "400";
+        value["msg"] = "device is not exist";
+        rsp.setContent(value.dump());
+        rspFunc(rsp);
+        return ;
+    }
+    deviceCtx->catalog();
+
     value["code"] = "200";
     value["msg"] = "success";
     rsp.setContent(value.dump());
@@ -54,6 +62,7 @@ void GB28181SIPApi::invite(const HttpParser& parser, const UrlParser& urlParser,
         value["msg"] = "device is not exist";
         rsp.setContent(value.dump());
         rspFunc(rsp);
+        return ;
     }
     GB28181SIPManager::instance()->addContext(info.channelId, deviceCtx);
     deviceCtx->invite(info);
@@ -63,10 +63,10 @@ void GB28181SIPConnection::onRead(const StreamBuffer::Ptr& buffer, struct sockad
     _parser.parse(buffer->data(), buffer->size());
 }
 
-void GB28181SIPConnection::onError()
+void GB28181SIPConnection::onError(const string& err)
 {
     close();
-    logWarn << "get a error: ";
+    logWarn << "get a error: " << err;
 }
 
 ssize_t GB28181SIPConnection::send(Buffer::Ptr pkt)
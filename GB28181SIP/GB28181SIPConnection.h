@@ -26,7 +26,7 @@ public:
 public:
     // 继承自tcpseesion
     void onRead(const StreamBuffer::Ptr& buffer, struct sockaddr* addr, int len) override;
-    void onError() override;
+    void onError(const string& err) override;
     void onManager() override;
     void init() override;
     void close() override;
@@ -11,6 +11,7 @@
 #include "Common/Define.h"
 #include "Common/Config.h"
 #include "Hook/MediaHook.h"
+#include "GB28181SIPRegistrar.h"
 
 using namespace std;
 
@@ -21,6 +22,7 @@ GB28181SIPContext::GB28181SIPContext(const EventLoop::Ptr& loop, const string& d
     ,_type(type)
     ,_loop(loop)
 {
+    _aliveTime = TimeClock::now();
     logTrace << "GB28181SIPContext::GB28181SIPContext";
     _req.reset(new SipRequest());
     _req->serial = Config::instance()->get("SipServer", "Server", "id");
@@ -41,39 +43,59 @@ bool GB28181SIPContext::init()
     return true;
 }
 
-void GB28181SIPContext::onSipPacket(const Socket::Ptr& socket, const SipRequest::Ptr& req, struct sockaddr* addr, int len, bool sort)
+bool GB28181SIPContext::updatePeer(const Socket::Ptr& socket, struct sockaddr* addr)
 {
     if (addr) {
         if (!_addr) {
             _addr = make_shared<sockaddr>();
             memcpy(_addr.get(), addr, sizeof(sockaddr));
-            if (addr) {
-                char buf[INET_ADDRSTRLEN] = "";
-                _req->peer_port = ntohs(((sockaddr_in*)&addr)->sin_port);
-                inet_ntop(AF_INET, &(((sockaddr_in*)&addr)->sin_addr), buf, INET_ADDRSTRLEN);
-                _req->peer_ip.assign(buf);
-            } else {
-                _req->peer_ip = socket->getPeerIp();
-                _req->peer_port = socket->getPeerPort();
-            }
+            char buf[INET_ADDRSTRLEN] = "";
+            _req->peer_port = ntohs(((sockaddr_in*)addr)->sin_port);
+            inet_ntop(AF_INET, &(((sockaddr_in*)addr)->sin_addr), buf, INET_ADDRSTRLEN);
+            _req->peer_ip.assign(buf);
         } else if (memcmp(_addr.get(), addr, sizeof(struct sockaddr)) != 0) {
             // 记录一下这个流，提供切换流的api
             logWarn<< "收到 sip 包，但已经存在一个相同的设备，忽略";
-            return ;
+            return false;
         }
+    } else if (_req->peer_ip.empty()) {
+        _req->peer_ip = socket->getPeerIp();
+        _req->peer_port = socket->getPeerPort();
     }
 
     if (_socket != socket) {
         _socket = socket;
     }
 
+    return true;
+}
+
+void GB28181SIPContext::onSipPacket(const Socket::Ptr& socket, const SipRequest::Ptr& req, struct sockaddr* addr, int len, bool sort)
+{
+    if (!updatePeer(socket, addr)) {
+        return ;
+    }
+
     stringstream ss;
     if (req->is_register()) {
-        if (req->authorization.empty()) {
-            _sipStack.resp_status(ss, req);
+        string wwwAuthenticate;
+        int ret = GB28181SIPRegistrar::instance()->onRegister(req, _req->peer_ip, _req->peer_port, wwwAuthenticate);
+        if (ret == GB28181SIPRegistrar::REGISTER_CHALLENGE) {
+            req->www_authenticate = wwwAuthenticate;
+            req->peer_ip = _req->peer_ip;
+            req->peer_port = _req->peer_port;
+            _sipStack.resp_401_unauthorized(ss, req);
+        } else if (ret == GB28181SIPRegistrar::REGISTER_FORBIDDEN) {
+            _sipStack.resp_403_forbidden(ss, req);
         } else {
-            // TODO auth
             _sipStack.resp_status(ss, req);
+            _registered = ret == GB28181SIPRegistrar::REGISTER_OK;
+            if (ret == GB28181SIPRegistrar::UNREGISTER_OK) {
+                // 注销后等心跳把上下文删掉
+                sendMessage(ss.str().data(), ss.str().size());
+                _alive = false;
+                return ;
+            }
         }
     } else if (req->is_message()) {
         if (req->cmdtype == SipCmdRequest) {
@@ -111,9 +133,11 @@ void GB28181SIPContext::onSipPacket(const Socket::Ptr& socket, const SipRequest:
         _sipStack.resp_status(ss, req);
     }
 
-    sendMessage(ss.str().data(), ss.str().size());
+    if (ss.tellp() > 0) {
+        sendMessage(ss.str().data(), ss.str().size());
+    }
 
-    _timeClock.update();
+    keepalive();
 }
 
 void GB28181SIPContext::heartbeat()
@@ -122,9 +146,9 @@ void GB28181SIPContext::heartbeat()
     static int timeout = Config::instance()->getAndListen([](const json& config){
         timeout = config["GB28181"]["Server"]["timeout"];
         logInfo << "timeout: " << timeout;
-    }, "GB28181", "Server", "timeout");
+    }, "GB28181", "Server", "timeout", "", "180000");
 
-    if (_timeClock.startToNow() > timeout) {
+    if (TimeClock::now() - _aliveTime > (uint64_t)timeout) {
         logInfo << "alive is false";
         _alive = false;
     }
@@ -8,6 +8,7 @@
 #include "SipMessage.h"
 
 #include <memory>
+#include <atomic>
 #include <unordered_map>
 
 using namespace std;
@@ -34,6 +35,13 @@ public:
     void onSipPacket(const Socket::Ptr& socket, const SipRequest::Ptr& req, struct sockaddr* addr = nullptr, int len = 0, bool sort = false);
     void heartbeat();
     bool isAlive() {return _alive;}
+    // 记录设备地址，已经记录了其他地址时返回false
+    bool updatePeer(const Socket::Ptr& socket, struct sockaddr* addr);
+    // 保活快速路径只刷新时间，不经过完整解析
+    void keepalive() {_aliveTime = TimeClock::now();}
+    // 注册成功，或者从持久化的注册信息恢复
+    bool isRegistered() {return _registered;}
+    void setRegistered(bool registered) {_registered = registered;}
     void catalog();
     void invite(const MediaInfo& mediainfo);
     void bye(const string& channelId, const string& callId);
@@ -41,13 +49,14 @@ public:
     void sendMessage(const char* msg, size_t size);
 
 private:
-    bool _alive = true;
+    atomic<bool> _alive{true};
+    atomic<bool> _registered{false};
     string _deviceId;
     string _vhost;
     string _protocol;
     string _type;
     string _payloadType = "ps";
-    TimeClock _timeClock;
+    atomic<uint64_t> _aliveTime{0};
     SipStack _sipStack;
     shared_ptr<sockaddr> _addr;
     shared_ptr<SipRequest> _req = NULL;
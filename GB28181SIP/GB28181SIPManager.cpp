@@ -1,11 +1,12 @@
 ﻿#include "GB28181SIPManager.h"
+#include "GB28181SIPRegistrar.h"
+#include "EventLoopPool.h"
 #include "Logger.h"
 #include "Common/Define.h"
+#include "Common/Config.h"
 
 using namespace std;
 
-static thread_local unordered_map<string, GB28181SIPContext::Wptr> _mapContextPerThread;
-
 GB28181SIPManager::GB28181SIPManager()
 {}
 
@@ -19,97 +20,203 @@ GB28181SIPManager::Ptr& GB28181SIPManager::instance()
     return instance;
 }
 
+void GB28181SIPManager::initShards()
+{
+    call_once(_shardFlag, [this](){
+        EventLoopPool::instance()->for_each_loop([this](const EventLoop::Ptr& loop){
+            auto shard = make_shared<Shard>();
+            shard->loop = loop;
+            _shards.emplace_back(shard);
+        });
+
+        // 没有loop时在收包的线程上处理
+        if (_shards.empty()) {
+            _shards.emplace_back(make_shared<Shard>());
+        }
+    });
+}
+
+GB28181SIPManager::Shard::Ptr& GB28181SIPManager::getShard(const string& deviceId)
+{
+    initShards();
+    return _shards[hash<string>()(deviceId) % _shards.size()];
+}
+
 void GB28181SIPManager::init(const EventLoop::Ptr& loop)
 {
-    // _loop = EventLoop::getCurrentLoop();
-    weak_ptr<GB28181SIPManager> wSelf = shared_from_this();
-    loop->addTimerTask(5000, [wSelf](){
-        auto self = wSelf.lock();
-        if (!self) {
-            return 0;
+    // 每个udp socket所在的loop都会调用一次，只需要初始化一次
+    {
+        lock_guard<mutex> lock(_initMtx);
+        if (_isInited) {
+            return ;
         }
+        _isInited = true;
+    }
 
-        self->heartbeat();
-        return 5000;
-    }, [wSelf](bool success, shared_ptr<TimerTask>){
+    initShards();
+    GB28181SIPRegistrar::instance()->init(loop);
 
-    });
+    weak_ptr<GB28181SIPManager> wSelf = shared_from_this();
+    for (auto& shard : _shards) {
+        auto shardLoop = shard->loop ? shard->loop : loop;
+        weak_ptr<Shard> wShard = shard;
+        shardLoop->addTimerTask(5000, [wSelf, wShard](){
+            auto self = wSelf.lock();
+            auto shard = wShard.lock();
+            if (!self || !shard) {
+                return 0;
+            }
+
+            self->heartbeat(shard);
+            return 5000;
+        }, [wSelf](bool success, shared_ptr<TimerTask>){
+
+        });
+    }
 }
 
 void GB28181SIPManager::onSipPacket(const Socket::Ptr& socket, const StreamBuffer::Ptr& buffer, struct sockaddr* addr, int len)
 {
-    logTrace << "get a message: " << buffer->data();
-    shared_ptr<SipRequest> req;
-    _sipStack.parse_request(req, buffer->data(), buffer->size());
+    ++_packetCount;
 
-    string deviceId;
-    // if (req->cmdtype == SipCmdRequest) {
-        deviceId = req->sip_username;
-    // }
+    // 收包的buffer是复用的，需要拷贝一份再交给其他loop，上下文只在分片的loop上操作
+    // brief的字段指向报文，在拷贝上解析，随拷贝一起交给分片的loop，不用再解析一次
+    auto copy = make_shared<StreamBuffer>(buffer->data(), buffer->size());
+    SipBrief brief;
+    if (!brief.parse(copy->data(), copy->size())) {
+        logDebug << "invalid sip packet, size: " << buffer->size();
+        return ;
+    }
 
-    logInfo << "get a deviceId: " << deviceId;
+    string deviceId = brief.device_id.str();
+    auto shard = getShard(deviceId);
+    auto peer = make_shared<sockaddr_storage>();
+    memcpy(peer.get(), addr, min((size_t)len, sizeof(sockaddr_storage)));
 
-    // auto ssrc = req->sip_channel_id;
-    auto iter = _mapContextPerThread.find(deviceId);
-    if (iter != _mapContextPerThread.end())
-    {
-        auto context = iter->second.lock();
-        if (context) {
-            if (context->isAlive()) {
-                context->onSipPacket(socket, req, addr, len, true);
-            } else {
-                auto key = iter->first;
-                _mapContextPerThread.erase(iter);
-                lock_guard<mutex> loc(_contextLck);
-                _mapContext.erase(key);
-            }
+    weak_ptr<GB28181SIPManager> wSelf = shared_from_this();
+    auto task = [wSelf, shard, socket, copy, brief, peer, len, deviceId](){
+        auto self = wSelf.lock();
+        if (!self) {
             return ;
-        } else {
-            _mapContextPerThread.erase(iter);
         }
-    }
 
-    {
-        lock_guard<mutex> lock(_contextLck);
-        auto iterAll = _mapContext.find(deviceId);
-        if (iterAll != _mapContext.end())
-        {
-            auto context = iterAll->second;
-            if (context->isAlive()) {
-                context->onSipPacket(socket, req, addr, len, true);
-                _mapContextPerThread[deviceId] = context;
-            } else {
-                _mapContext.erase(iterAll);
-            }
+        if (brief.is_keepalive() && self->onKeepalive(shard, socket, brief, peer, len, deviceId)) {
             return ;
         }
+        self->onShardPacket(shard, socket, copy, peer, len, deviceId);
+    };
+
+    if (shard->loop) {
+        shard->loop->async(task, true);
+    } else {
+        task();
+    }
+}
+
+GB28181SIPContext::Ptr GB28181SIPManager::getOrCreateContext(const Shard::Ptr& shard, const string& deviceId, bool create)
+{
+    // 查找和创建在同一把锁内完成，避免并发时创建出多个上下文
+    lock_guard<mutex> lock(shard->mtx);
+    auto iter = shard->contexts.find(deviceId);
+    if (iter != shard->contexts.end()) {
+        if (iter->second->isAlive()) {
+            return iter->second;
+        }
+        shard->contexts.erase(iter);
     }
 
-    // string uri = "/live/" + to_string(deviceId);
-    auto context = make_shared<GB28181SIPContext>(EventLoop::getCurrentLoop(), deviceId, 
-                                        DEFAULT_VHOST, PROTOCOL_GB28181, DEFAULT_TYPE);
+    if (!create) {
+        return nullptr;
+    }
 
+    auto loop = shard->loop ? shard->loop : EventLoop::getCurrentLoop();
+    auto context = make_shared<GB28181SIPContext>(loop, deviceId, DEFAULT_VHOST, PROTOCOL_GB28181, DEFAULT_TYPE);
     if (!context->init()) {
+        return nullptr;
+    }
+    logInfo << "create context, deviceId: " << deviceId;
+    shard->contexts[deviceId] = context;
+
+    return context;
+}
+
+bool GB28181SIPManager::onKeepalive(const Shard::Ptr& shard, const Socket::Ptr& socket, const SipBrief& brief, 
+                                        const shared_ptr<sockaddr_storage>& peer, int len, const string& deviceId)
+{
+    // 未注册设备的保活是否直接回403，关闭时交给上下文走完整的流程
+    static int rejectUnregistered = Config::instance()->getAndListen([](const json &){
+        rejectUnregistered = Config::instance()->get("GB28181", "Sip", "rejectUnregisteredKeepalive", "", "0");
+    }, "GB28181", "Sip", "rejectUnregisteredKeepalive", "", "0");
+
+    // 重启后从持久化的注册信息恢复，不需要设备重新注册
+    auto addr = (struct sockaddr*)peer.get();
+    bool registered = GB28181SIPRegistrar::instance()->isRegistered(deviceId);
+    auto context = getOrCreateContext(shard, deviceId, registered);
+
+    string resp;
+    if (!context || (!context->isRegistered() && !registered)) {
+        if (!rejectUnregistered) {
+            return false;
+        }
+        // 没有注册过的设备，让它重新注册
+        brief.resp_status(resp, "403 Forbidden");
+        sendResponse(socket, resp, peer, len);
+        return true;
+    }
+
+    // 地址变了走完整的流程
+    if (!context->updatePeer(socket, addr)) {
+        return false;
+    }
+    context->setRegistered(true);
+    context->keepalive();
+    ++_keepaliveCount;
+    brief.resp_ok(resp);
+    sendResponse(socket, resp, peer, len);
+
+    return true;
+}
+
+void GB28181SIPManager::sendResponse(const Socket::Ptr& socket, const string& resp, const shared_ptr<sockaddr_storage>& peer, int len)
+{
+    // Socket::send切换线程时只保存了地址指针，在socket的loop上发送，保证地址在发送时还有效
+    auto buffer = make_shared<StreamBuffer>(resp.data(), resp.size());
+    socket->getLoop()->async([socket, buffer, peer, len](){
+        socket->send(buffer, 1, 0, 0, (struct sockaddr*)peer.get(), len);
+    }, true);
+}
+
+void GB28181SIPManager::onShardPacket(const Shard::Ptr& shard, const Socket::Ptr& socket, const StreamBuffer::Ptr& buffer, 
+                                        const shared_ptr<sockaddr_storage>& addr, int len, const string& deviceId)
+{
+    shared_ptr<SipRequest> req;
+    SipStack sipStack;
+    sipStack.parse_request(req, buffer->data(), buffer->size());
+
+    auto context = getOrCreateContext(shard, deviceId, true);
+    if (!context) {
         return ;
     }
-    context->onSipPacket(socket, req, addr, len, true);
-    logInfo << "_mapContextPerThread, deviceId: " << deviceId;
-    _mapContextPerThread[deviceId] = context;
-    lock_guard<mutex> lock(_contextLck);
-    _mapContext[deviceId] = context;
 
+    context->onSipPacket(socket, req, (struct sockaddr*)addr.get(), len, true);
 }
 
 void GB28181SIPManager::heartbeat()
 {
-    for (auto iter = _mapContextPerThread.begin(); iter != _mapContextPerThread.end();) {
-        auto context = iter->second.lock();
-        if (!context || !context->isAlive()) {
-            logInfo << "_mapContextPerThread.erase, deviceId: " << iter->first;
-            auto deviceId = iter->first;
-            iter = _mapContextPerThread.erase(iter);
-            lock_guard<mutex> lock(_contextLck);
-            _mapContext.erase(deviceId);
+    initShards();
+    for (auto& shard : _shards) {
+        heartbeat(shard);
+    }
+}
+
+void GB28181SIPManager::heartbeat(const Shard::Ptr& shard)
+{
+    lock_guard<mutex> lock(shard->mtx);
+    for (auto iter = shard->contexts.begin(); iter != shard->contexts.end();) {
+        iter->second->heartbeat();
+        if (!iter->second->isAlive()) {
+            logInfo << "context erase, deviceId: " << iter->first;
+            iter = shard->contexts.erase(iter);
         } else {
             ++iter;
         }
@@ -118,24 +225,37 @@ void GB28181SIPManager::heartbeat()
 
 void GB28181SIPManager::addContext(const string& deviceId, const GB28181SIPContext::Ptr& context)
 {
-    lock_guard<mutex> lock(_contextLck);
-    _mapContext[deviceId] = context;
+    auto& shard = getShard(deviceId);
+    lock_guard<mutex> lock(shard->mtx);
+    shard->contexts[deviceId] = context;
 }
 
 void GB28181SIPManager::delContext(const string& deviceId)
 {
-    lock_guard<mutex> lock(_contextLck);
-    _mapContext.erase(deviceId);
+    auto& shard = getShard(deviceId);
+    lock_guard<mutex> lock(shard->mtx);
+    shard->contexts.erase(deviceId);
 }
 
 GB28181SIPContext::Ptr GB28181SIPManager::getContext(const string& deviceId)
 {
-    lock_guard<mutex> lock(_contextLck);
-    auto iter = _mapContext.find(deviceId);
-    if (iter == _mapContext.end()) 
+    auto& shard = getShard(deviceId);
+    lock_guard<mutex> lock(shard->mtx);
+    auto iter = shard->contexts.find(deviceId);
+    if (iter == shard->contexts.end()) 
     {
         return nullptr;
     }
     return iter->second;
 }
 
+size_t GB28181SIPManager::getContextCount()
+{
+    initShards();
+    size_t count = 0;
+    for (auto& shard : _shards) {
+        lock_guard<mutex> lock(shard->mtx);
+        count += shard->contexts.size();
+    }
+    return count;
+}
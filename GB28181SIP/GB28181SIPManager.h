@@ -6,12 +6,16 @@
 #include <unordered_map>
 #include <mutex>
 #include <memory>
+#include <vector>
+#include <atomic>
 
 #include "GB28181SIPContext.h"
 #include "Net/Socket.h"
 
 using namespace std;
 
+// 设备上下文按设备id哈希分到各个loop上，每个分片一把锁，避免所有设备挤在一把全局锁上
+// 收包的loop只做预解析，报文拷贝后交给分片的loop，保活在分片的loop上直接回复，注册等其他报文再完整解析
 class GB28181SIPManager : public enable_shared_from_this<GB28181SIPManager> {
 public:
     using Ptr = shared_ptr<GB28181SIPManager>;
@@ -30,12 +34,38 @@ public:
     void delContext(const string& deviceId);
     GB28181SIPContext::Ptr getContext(const string& deviceId);
 
+    size_t getContextCount();
+    uint64_t getKeepaliveCount() {return _keepaliveCount;}
+    uint64_t getPacketCount() {return _packetCount;}
+
+private:
+    struct Shard
+    {
+        using Ptr = shared_ptr<Shard>;
+
+        mutex mtx;
+        EventLoop::Ptr loop;
+        unordered_map<string, GB28181SIPContext::Ptr> contexts;
+    };
+
+    void initShards();
+    Shard::Ptr& getShard(const string& deviceId);
+    GB28181SIPContext::Ptr getOrCreateContext(const Shard::Ptr& shard, const string& deviceId, bool create);
+    // brief的字段指向拷贝出来的报文
+    bool onKeepalive(const Shard::Ptr& shard, const Socket::Ptr& socket, const SipBrief& brief, 
+                        const shared_ptr<sockaddr_storage>& peer, int len, const string& deviceId);
+    void sendResponse(const Socket::Ptr& socket, const string& resp, const shared_ptr<sockaddr_storage>& peer, int len);
+    void onShardPacket(const Shard::Ptr& shard, const Socket::Ptr& socket, const StreamBuffer::Ptr& buffer, 
+                        const shared_ptr<sockaddr_storage>& addr, int len, const string& deviceId);
+    void heartbeat(const Shard::Ptr& shard);
+
 private:
     bool _isInited = false;
-    mutex _contextLck;
-    SipStack _sipStack;
-    // EventLoop::Ptr _loop;
-    unordered_map<string, GB28181SIPContext::Ptr> _mapContext;
+    once_flag _shardFlag;
+    mutex _initMtx;
+    atomic<uint64_t> _keepaliveCount{0};
+    atomic<uint64_t> _packetCount{0};
+    vector<Shard::Ptr> _shards;
 };
 
-#endif //GB28181SIPManager_h
\ No newline at end of file
+#endif //GB28181SIPManager_h
@@ -0,0 +1,354 @@
+﻿#include <cstdio>
+#include <strings.h>
+
+#include "GB28181SIPRegistrar.h"
+#include "Logger.h"
+#include "Common/Config.h"
+#include "Util/MD5.h"
+#include "Util/File.h"
+#include "Util/String.h"
+#include "Util/TimeClock.h"
+
+using namespace std;
+
+// Digest username="xxx",realm="xxx",nonce="xxx",uri="xxx",response="xxx",algorithm=MD5
+static unordered_map<string, string> parseDigest(const string& auth)
+{
+    unordered_map<string, string> params;
+    size_t pos = 0;
+    if (strncasecmp(auth.data(), "Digest", 6) == 0) {
+        pos = 6;
+    }
+
+    while (pos < auth.size()) {
+        while (pos < auth.size() && (auth[pos] == ' ' || auth[pos] == ',')) {
+            ++pos;
+        }
+        size_t eq = auth.find('=', pos);
+        if (eq == string::npos) {
+            break;
+        }
+        string key = auth.substr(pos, eq - pos);
+        key = trim(key, " ");
+        toLower(key);
+
+        pos = eq + 1;
+        string value;
+        if (pos < auth.size() && auth[pos] == '"') {
+            size_t quote = auth.find('"', pos + 1);
+            if (quote == string::npos) {
+                break;
+            }
+            value = auth.substr(pos + 1, quote - pos - 1);
+            pos = quote + 1;
+        } else {
+            size_t comma = auth.find(',', pos);
+            if (comma == string::npos) {
+                comma = auth.size();
+            }
+            value = auth.substr(pos, comma - pos);
+            value = trim(value, " ");
+            pos = comma;
+        }
+        params[key] = value;
+    }
+
+    return params;
+}
+
+static string md5Hex(const string& text)
+{
+    return MD5(text).hexdigest();
+}
+
+GB28181SIPRegistrar::GB28181SIPRegistrar()
+{}
+
+GB28181SIPRegistrar::~GB28181SIPRegistrar()
+{}
+
+GB28181SIPRegistrar::Ptr& GB28181SIPRegistrar::instance()
+{
+    static GB28181SIPRegistrar::Ptr instance = make_shared<GB28181SIPRegistrar>();
+    return instance;
+}
+
+void GB28181SIPRegistrar::init(const EventLoop::Ptr& loop)
+{
+    {
+        lock_guard<mutex> lock(_mtx);
+        if (_isInited) {
+            return ;
+        }
+        _isInited = true;
+        _path = Config::instance()->get("GB28181", "Sip", "registryFile", "", "./gb28181Registry.json");
+    }
+
+    load(_path);
+
+    static int saveInterval = Config::instance()->getAndListen([](const json &config){
+        saveInterval = Config::instance()->get("GB28181", "Sip", "saveInterval");
+    }, "GB28181", "Sip", "saveInterval", "", "5000");
+
+    weak_ptr<GB28181SIPRegistrar> wSelf = shared_from_this();
+    loop->addTimerTask(saveInterval, [wSelf](){
+        auto self = wSelf.lock();
+        if (!self) {
+            return 0;
+        }
+
+        self->onTimer();
+        return saveInterval;
+    }, nullptr);
+}
+
+int GB28181SIPRegistrar::onRegister(const SipRequest::Ptr& req, const string& ip, int port, string& wwwAuthenticate)
+{
+    static string realm = Config::instance()->getAndListen([](const json &config){
+        realm = Config::instance()->get("SipServer", "Server", "realm");
+    }, "SipServer", "Server", "realm");
+
+    static string password = Config::instance()->getAndListen([](const json &config){
+        password = Config::instance()->get("SipServer", "Server", "password");
+    }, "SipServer", "Server", "password");
+
+    const string& deviceId = req->sip_username;
+
+    // 没有配置密码时不鉴权
+    if (!password.empty()) {
+        if (req->authorization.empty()) {
+            wwwAuthenticate = "Digest realm=\"" + realm + "\",qop=\"auth\",nonce=\"" + getNonce(deviceId) + "\"";
+            return REGISTER_CHALLENGE;
+        }
+
+        auto params = parseDigest(req->authorization);
+        // nonce过期或者服务重启后不认识的nonce，重新挑战，设备用新的nonce再注册一次即可
+        if (!checkNonce(deviceId, params["nonce"])) {
+            wwwAuthenticate = "Digest realm=\"" + realm + "\",qop=\"auth\",nonce=\"" + getNonce(deviceId) + "\",stale=true";
+            return REGISTER_CHALLENGE;
+        }
+
+        if (!checkResponse(req->authorization, req->method, realm, password)) {
+            logWarn << "register auth failed, deviceId: " << deviceId;
+            return REGISTER_FORBIDDEN;
+        }
+    }
+
+    lock_guard<mutex> lock(_mtx);
+    _dirty = true;
+    if (req->expires == 0) {
+        _mapRegistration.erase(deviceId);
+        _mapNonce.erase(deviceId);
+        return UNREGISTER_OK;
+    }
+
+    auto& registration = _mapRegistration[deviceId];
+    registration.deviceId = deviceId;
+    registration.ip = ip;
+    registration.port = port;
+    registration.expires = req->expires;
+    registration.registerTime = TimeClock::now();
+
+    return REGISTER_OK;
+}
+
+bool GB28181SIPRegistrar::isRegistered(const string& deviceId)
+{
+    lock_guard<mutex> lock(_mtx);
+    auto iter = _mapRegistration.find(deviceId);
+    if (iter == _mapRegistration.end()) {
+        return false;
+    }
+
+    return iter->second.registerTime + iter->second.expires * 1000ULL > TimeClock::now();
+}
+
+bool GB28181SIPRegistrar::getRegistration(const string& deviceId, SipRegistration& registration)
+{
+    lock_guard<mutex> lock(_mtx);
+    auto iter = _mapRegistration.find(deviceId);
+    if (iter == _mapRegistration.end()) {
+        return false;
+    }
+
+    registration = iter->second;
+    return true;
+}
+
+void GB28181SIPRegistrar::unregister(const string& deviceId)
+{
+    lock_guard<mutex> lock(_mtx);
+    if (_mapRegistration.erase(deviceId)) {
+        _dirty = true;
+    }
+}
+
+bool GB28181SIPRegistrar::load(const string& path)
+{
+    if (!File::isFile(path.data())) {
+        return false;
+    }
+
+    json value;
+    try {
+        value = json::parse(File::loadFile(path.data()));
+    } catch (exception& ex) {
+        logWarn << "parse registry file failed: " << path << ", " << ex.what();
+        return false;
+    }
+
+    if (!value["devices"].is_array()) {
+        return false;
+    }
+
+    auto now = TimeClock::now();
+    int count = 0;
+    lock_guard<mutex> lock(_mtx);
+    for (auto& device : value["devices"]) {
+        SipRegistration registration;
+        try {
+            registration.deviceId = device["deviceId"];
+            registration.ip = device["ip"];
+            registration.port = device["port"];
+            registration.expires = device["expires"];
+            registration.registerTime = device["registerTime"];
+        } catch (exception& ex) {
+            continue;
+        }
+
+        // 重启期间已经过期的不恢复
+        if (registration.registerTime + registration.expires * 1000ULL <= now) {
+            continue;
+        }
+        _mapRegistration[registration.deviceId] = registration;
+        ++count;
+    }
+    logInfo << "load " << count << " registrations from " << path;
+
+    return true;
+}
+
+bool GB28181SIPRegistrar::save(const string& path)
+{
+    json value;
+    value["devices"] = json::array();
+    {
+        lock_guard<mutex> lock(_mtx);
+        _dirty = false;
+        for (auto& iter : _mapRegistration) {
+            auto& registration = iter.second;
+            json device;
+            device["deviceId"] = registration.deviceId;
+            device["ip"] = registration.ip;
+            device["port"] = registration.port;
+            device["expires"] = registration.expires;
+            device["registerTime"] = registration.registerTime;
+            value["devices"].push_back(device);
+        }
+    }
+
+    // 先写临时文件再改名，避免写到一半重启留下损坏的文件
+    string tmpPath = path + ".tmp";
+    if (!File::saveFile(value.dump(), tmpPath.data())) {
+        logWarn << "save registry file failed: " << tmpPath;
+        return false;
+    }
+
+    if (::rename(tmpPath.data(), path.data()) != 0) {
+        logWarn << "rename registry file failed: " << path;
+        return false;
+    }
+
+    return true;
+}
+
+size_t GB28181SIPRegistrar::getRegistrationCount()
+{
+    lock_guard<mutex> lock(_mtx);
+    return _mapRegistration.size();
+}
+
+size_t GB28181SIPRegistrar::getNonceCount()
+{
+    lock_guard<mutex> lock(_mtx);
+    return _mapNonce.size();
+}
+
+string GB28181SIPRegistrar::getNonce(const string& deviceId)
+{
+    static int nonceExpire = Config::instance()->getAndListen([](const json &config){
+        nonceExpire = Config::instance()->get("GB28181", "Sip", "nonceExpire");
+    }, "GB28181", "Sip", "nonceExpire", "", "300000");
+
+    auto now = TimeClock::now();
+    lock_guard<mutex> lock(_mtx);
+    auto& nonce = _mapNonce[deviceId];
+    // 有效期内复用同一个nonce，注册风暴时不用每次都重新生成
+    if (nonce.first.empty() || nonce.second <= now) {
+        nonce.first = md5Hex(deviceId + ":" + to_string(now) + ":" + to_string(++_nonceIndex));
+        nonce.second = now + nonceExpire;
+    }
+
+    return nonce.first;
+}
+
+bool GB28181SIPRegistrar::checkNonce(const string& deviceId, const string& nonce)
+{
+    lock_guard<mutex> lock(_mtx);
+    auto iter = _mapNonce.find(deviceId);
+    if (iter == _mapNonce.end()) {
+        return false;
+    }
+
+    return !nonce.empty() && iter->second.first == nonce && iter->second.second > TimeClock::now();
+}
+
+bool GB28181SIPRegistrar::checkResponse(const string& authorization, const string& method, const string& realm, const string& password)
+{
+    auto params = parseDigest(authorization);
+    // HA1 = MD5(username:realm:password), HA2 = MD5(method:uri)
+    string ha1 = md5Hex(params["username"] + ":" + realm + ":" + password);
+    string ha2 = md5Hex(method + ":" + params["uri"]);
+
+    string response;
+    if (params["qop"].empty()) {
+        response = md5Hex(ha1 + ":" + params["nonce"] + ":" + ha2);
+    } else {
+        response = md5Hex(ha1 + ":" + params["nonce"] + ":" + params["nc"] + ":" 
+                        + params["cnonce"] + ":" + params["qop"] + ":" + ha2);
+    }
+
+    return strcasecmp(response.data(), params["response"].data()) == 0;
+}
+
+void GB28181SIPRegistrar::onTimer()
+{
+    bool dirty = false;
+    auto now = TimeClock::now();
+    {
+        lock_guard<mutex> lock(_mtx);
+        for (auto iter = _mapNonce.begin(); iter != _mapNonce.end();) {
+            if (iter->second.second <= now) {
+                iter = _mapNonce.erase(iter);
+            } else {
+                ++iter;
+            }
+        }
+
+        for (auto iter = _mapRegistration.begin(); iter != _mapRegistration.end();) {
+            if (iter->second.registerTime + iter->second.expires * 1000ULL <= now) {
+                logInfo << "registration expired, deviceId: " << iter->first;
+                iter = _mapRegistration.erase(iter);
+                _dirty = true;
+            } else {
+                ++iter;
+            }
+        }
+        dirty = _dirty;
+    }
+
+    // 注册风暴时也只在定时器里落盘一次
+    if (dirty) {
+        save(_path);
+    }
+}
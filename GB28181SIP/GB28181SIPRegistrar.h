@@ -0,0 +1,78 @@
+﻿#ifndef GB28181SIPRegistrar_h
+#define GB28181SIPRegistrar_h
+
+#include <string>
+#include <unordered_map>
+#include <mutex>
+#include <memory>
+
+#include "EventPoller/EventLoop.h"
+#include "SipMessage.h"
+
+using namespace std;
+
+struct SipRegistration
+{
+    string deviceId;
+    string ip;
+    int port = 0;
+    // 秒
+    int expires = 0;
+    // 注册时间，毫秒
+    uint64_t registerTime = 0;
+};
+
+// 设备注册管理：digest鉴权，nonce缓存，注册信息定时落盘
+// 重启后从文件恢复，未过期的设备保活直接放行，不需要所有设备同时重新注册
+class GB28181SIPRegistrar : public enable_shared_from_this<GB28181SIPRegistrar>
+{
+public:
+    using Ptr = shared_ptr<GB28181SIPRegistrar>;
+    using Wptr = weak_ptr<GB28181SIPRegistrar>;
+
+    enum Result
+    {
+        REGISTER_OK = 0,
+        UNREGISTER_OK,
+        // 需要回401，WWW-Authenticate带回挑战
+        REGISTER_CHALLENGE,
+        // 鉴权失败，回403
+        REGISTER_FORBIDDEN
+    };
+
+    GB28181SIPRegistrar();
+    ~GB28181SIPRegistrar();
+
+public:
+    static GB28181SIPRegistrar::Ptr& instance();
+
+    // 加载注册信息并启动定时落盘，重复调用只生效一次
+    void init(const EventLoop::Ptr& loop);
+    int onRegister(const SipRequest::Ptr& req, const string& ip, int port, string& wwwAuthenticate);
+    bool isRegistered(const string& deviceId);
+    bool getRegistration(const string& deviceId, SipRegistration& registration);
+    void unregister(const string& deviceId);
+
+    bool load(const string& path);
+    bool save(const string& path);
+    size_t getRegistrationCount();
+    size_t getNonceCount();
+
+private:
+    string getNonce(const string& deviceId);
+    bool checkNonce(const string& deviceId, const string& nonce);
+    bool checkResponse(const string& authorization, const string& method, const string& realm, const string& password);
+    void onTimer();
+
+private:
+    bool _isInited = false;
+    bool _dirty = false;
+    uint64_t _nonceIndex = 0;
+    mutex _mtx;
+    string _path;
+    unordered_map<string, SipRegistration> _mapRegistration;
+    // deviceId -> nonce, 过期时间
+    unordered_map<string, pair<string, uint64_t>> _mapNonce;
+};
+
+#endif //GB28181SIPRegistrar_h
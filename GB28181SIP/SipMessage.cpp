@@ -23,7 +23,7 @@
 
 #include "SipMessage.h"
 #include "tinyxml.h"
-#include "Common/config.h"
+#include "Common/Config.h"
 #include "Log/Logger.h"
 #include "Util/String.h"
 #include "Util/TimeClock.h"
@@ -230,6 +230,168 @@ void SipRequest::copy(SipRequest* src)
      peer_port = src->peer_port;
 }
 
+bool SipBrief::Field::equal(const char* str) const
+{
+    int size = strlen(str);
+    return size == len && strncasecmp(data, str, len) == 0;
+}
+
+static void sip_trim(const char*& begin, const char*& end)
+{
+    while (begin < end && (*begin == ' ' || *begin == '\t')) {
+        ++begin;
+    }
+    while (end > begin && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\r')) {
+        --end;
+    }
+}
+
+static bool sip_header_is(const char* name, int len, const char* full, const char* compact)
+{
+    int fullLen = strlen(full);
+    if (len == fullLen && strncasecmp(name, full, len) == 0) {
+        return true;
+    }
+    return compact && len == 1 && tolower(name[0]) == compact[0];
+}
+
+bool SipBrief::parse(const char* data, int len)
+{
+    const char* end = data + len;
+    const char* line = data;
+    bool firstLine = true;
+
+    while (line < end) {
+        const char* lineEnd = (const char*)memchr(line, '\n', end - line);
+        if (!lineEnd) {
+            lineEnd = end;
+        }
+        const char* next = lineEnd < end ? lineEnd + 1 : end;
+        const char* valueEnd = lineEnd;
+        if (valueEnd > line && valueEnd[-1] == '\r') {
+            --valueEnd;
+        }
+
+        // 空行，后面是body
+        if (valueEnd == line) {
+            line = next;
+            break;
+        }
+
+        if (firstLine) {
+            firstLine = false;
+            // SIP/2.0 200 OK 或者 MESSAGE sip:xxx SIP/2.0
+            const char* space = (const char*)memchr(line, ' ', valueEnd - line);
+            if (!space) {
+                return false;
+            }
+            if (space - line == 7 && strncasecmp(line, "SIP/2.0", 7) == 0) {
+                is_response = true;
+                const char* code = space + 1;
+                const char* codeEnd = (const char*)memchr(code, ' ', valueEnd - code);
+                method.data = code;
+                method.len = (codeEnd ? codeEnd : valueEnd) - code;
+            } else {
+                method.data = line;
+                method.len = space - line;
+            }
+        } else {
+            const char* colon = (const char*)memchr(line, ':', valueEnd - line);
+            if (colon) {
+                const char* name = line;
+                const char* nameEnd = colon;
+                sip_trim(name, nameEnd);
+                const char* value = colon + 1;
+                const char* vEnd = valueEnd;
+                sip_trim(value, vEnd);
+
+                Field field;
+                field.data = value;
+                field.len = vEnd - value;
+                int nameLen = nameEnd - name;
+
+                if (sip_header_is(name, nameLen, "via", "v")) {
+                    // 多个Via只保留第一个
+                    if (via.empty()) {
+                        via = field;
+                    }
+                } else if (sip_header_is(name, nameLen, "from", "f")) {
+                    from = field;
+                } else if (sip_header_is(name, nameLen, "to", "t")) {
+                    to = field;
+                } else if (sip_header_is(name, nameLen, "call-id", "i")) {
+                    call_id = field;
+                } else if (sip_header_is(name, nameLen, "cseq", nullptr)) {
+                    cseq = field;
+                }
+            }
+        }
+
+        line = next;
+    }
+
+    if (method.empty() || from.empty() || call_id.empty() || cseq.empty()) {
+        return false;
+    }
+
+    // <sip:34020000001320000003@3402000000>;tag=xxx
+    const char* fromEnd = from.data + from.len;
+    const char* user = from.data;
+    while (user + 4 <= fromEnd && strncasecmp(user, "sip:", 4) != 0) {
+        ++user;
+    }
+    if (user + 4 <= fromEnd) {
+        user += 4;
+        const char* userEnd = user;
+        while (userEnd < fromEnd && *userEnd != '@' && *userEnd != '>' && *userEnd != ';') {
+            ++userEnd;
+        }
+        device_id.data = user;
+        device_id.len = userEnd - user;
+    }
+
+    if (line < end) {
+        static const char tagBegin[] = "<CmdType>";
+        const char* cmd = (const char*)memmem(line, end - line, tagBegin, sizeof(tagBegin) - 1);
+        if (cmd) {
+            cmd += sizeof(tagBegin) - 1;
+            const char* cmdEnd = (const char*)memchr(cmd, '<', end - cmd);
+            if (cmdEnd) {
+                const char* cmdBegin = cmd;
+                sip_trim(cmdBegin, cmdEnd);
+                cmd_type.data = cmdBegin;
+                cmd_type.len = cmdEnd - cmdBegin;
+            }
+        }
+    }
+
+    return !device_id.empty();
+}
+
+bool SipBrief::is_keepalive() const
+{
+    return !is_response && method.equal(SIP_METHOD_MESSAGE) && cmd_type.equal("Keepalive");
+}
+
+void SipBrief::resp_ok(std::string& resp) const
+{
+    resp_status(resp, "200 OK");
+}
+
+void SipBrief::resp_status(std::string& resp, const char* status) const
+{
+    resp.clear();
+    resp.reserve(160 + via.len + from.len + to.len + call_id.len + cseq.len);
+    resp.append(SIP_VERSION " ").append(status).append(RTSP_CRLF);
+    resp.append("Via: ").append(via.data ? via.data : "", via.len).append(RTSP_CRLF);
+    resp.append("From: ").append(from.data, from.len).append(RTSP_CRLF);
+    resp.append("To: ").append(to.data ? to.data : "", to.len).append(RTSP_CRLF);
+    resp.append("Call-ID: ").append(call_id.data, call_id.len).append(RTSP_CRLF);
+    resp.append("CSeq: ").append(cseq.data, cseq.len).append(RTSP_CRLF);
+    resp.append("User-Agent: " SIP_USER_AGENT RTSP_CRLF);
+    resp.append("Content-Length: 0" RTSP_CRLFCRLF);
+}
+
 SipStack::SipStack(const string& role)
     :_role(role)
 {
@@ -463,11 +625,7 @@ void SipStack::resp_status(stringstream& ss, shared_ptr<SipRequest> req)
         Content-Length: 0
 
         */
-        if (req->authorization.empty()){
-            //TODO: fixme supoort 401
-            return resp_401_unauthorized(ss, req);
-        }
-
+        // 是否需要鉴权由注册模块判断，需要挑战时调用resp_401_unauthorized
         ss << SIP_VERSION <<" 200 OK" << RTSP_CRLF
         << "Via: " << req->via << RTSP_CRLF
         << "From: <sip:"<< req->from << ">" << RTSP_CRLF
@@ -957,11 +1115,29 @@ void SipStack::resp_401_unauthorized(std::stringstream& ss, shared_ptr<SipReques
     << "Call-ID: " << req->call_id << RTSP_CRLF
     << "Contact: " << req->contact << RTSP_CRLF
     << "User-Agent: " << SIP_USER_AGENT << RTSP_CRLF
-    << "Content-Length: 0" << RTSP_CRLF
-    << "WWW-Authenticate: Digest realm=\"3402000000\",qop=\"auth\",nonce=\"f1da98bd160f3e2efe954c6eedf5f75a\"" << RTSP_CRLFCRLF;
+    << "Content-Length: 0" << RTSP_CRLF;
+
+    // 注册模块生成了带nonce的挑战时使用它，否则用默认值
+    if (!req->www_authenticate.empty()) {
+        ss << "WWW-Authenticate: " << req->www_authenticate << RTSP_CRLFCRLF;
+    } else {
+        ss << "WWW-Authenticate: Digest realm=\"3402000000\",qop=\"auth\",nonce=\"f1da98bd160f3e2efe954c6eedf5f75a\"" << RTSP_CRLFCRLF;
+    }
     return;
 }
 
+void SipStack::resp_403_forbidden(std::stringstream& ss, shared_ptr<SipRequest> req)
+{
+    ss << SIP_VERSION <<" 403 Forbidden" << RTSP_CRLF
+    << "Via: " << req->via << RTSP_CRLF
+    << "From: <sip:"<< req->from << ">" << RTSP_CRLF
+    << "To: <sip:"<< req->to << ">" << RTSP_CRLF
+    << "CSeq: "<< req->seq << " " << req->method << RTSP_CRLF
+    << "Call-ID: " << req->call_id << RTSP_CRLF
+    << "User-Agent: " << SIP_USER_AGENT << RTSP_CRLF
+    << "Content-Length: 0" << RTSP_CRLFCRLF;
+}
+
 void SipStack::resp_ack(std::stringstream& ss, shared_ptr<SipRequest> req){
     /*
     //request: sip-agent <------ ACK ------- sip-server
@@ -122,6 +122,42 @@ public:
     virtual std::string get_cmdtype_str();
 };
 
+// 只扫描首行和几个关键头域的轻量解析，不拷贝数据，字段指向原始报文
+// 用于注册/保活风暴时快速分流，保活直接回复，其他报文再走完整的parse_request
+class SipBrief
+{
+public:
+    struct Field
+    {
+        const char* data = nullptr;
+        int len = 0;
+
+        bool empty() const {return len == 0;}
+        bool equal(const char* str) const;
+        std::string str() const {return std::string(data ? data : "", len);}
+    };
+
+    bool parse(const char* data, int len);
+    bool is_keepalive() const;
+    // 保活的200 OK，Via/From/To原样带回
+    void resp_ok(std::string& resp) const;
+    // 其他状态码，如未注册设备的保活回复403
+    void resp_status(std::string& resp, const char* status) const;
+
+public:
+    bool is_response = false;
+    // 请求时为方法名，响应时为状态码
+    Field method;
+    Field via;
+    Field from;
+    Field to;
+    Field call_id;
+    Field cseq;
+    Field cmd_type;
+    // From里的sip用户名，即设备id
+    Field device_id;
+};
+
 // The gb28181 sip protocol stack.
 class SipStack
 {
@@ -143,6 +179,7 @@ public:
     virtual void resp_keepalive(std::stringstream& ss, std::shared_ptr<SipRequest> req);
     virtual void resp_ack(std::stringstream& ss, std::shared_ptr<SipRequest> req);
     virtual void resp_401_unauthorized(std::stringstream& ss, std::shared_ptr<SipRequest> req);
+    virtual void resp_403_forbidden(std::stringstream& ss, std::shared_ptr<SipRequest> req);
     virtual void req_query_catalog(std::stringstream& ss, std::shared_ptr<SipRequest> req);
      
     virtual std::string req_invite(std::stringstream& ss, std::shared_ptr<SipRequest> req, std::string ip, int port, uint32_t ssrc);
@@ -7,6 +7,9 @@
 #include "WorkPoller/WorkLoopPool.h"
 #include "FfmpegApi.h"
 #include "Ffmpeg/TranscodeTask.h"
+#include "Ffmpeg/Snapshot.h"
+#include "EventPoller/EventLoop.h"
+#include "Common/Define.h"
 
 using namespace std;
 
@@ -16,8 +19,10 @@ extern unordered_map<string, function<void(const HttpParser& parser, const UrlPa
 void FfmpegApi::initApi()
 {
     g_mapApi.emplace("/api/v1/ffmpeg/task/add", FfmpegApi::addTask);
+    g_mapApi.emplace("/api/v1/ffmpeg/task/addLadder", FfmpegApi::addLadderTask);
     g_mapApi.emplace("/api/v1/ffmpeg/task/del", FfmpegApi::delTask);
     g_mapApi.emplace("/api/v1/ffmpeg/task/reconfig", FfmpegApi::reconfig);
+    g_mapApi.emplace("/api/v1/ffmpeg/snapshot", FfmpegApi::getSnapshot);
 }
 
 void FfmpegApi::addTask(const HttpParser& parser, const UrlParser& urlParser, 
@@ -52,6 +57,66 @@ void FfmpegApi::addTask(const HttpParser& parser, const UrlParser& urlParser,
     rspFunc(rsp);
 }
 
+void FfmpegApi::addLadderTask(const HttpParser& parser, const UrlParser& urlParser, 
+                        const function<void(HttpResponse& rsp)>& rspFunc)
+{
+    checkArgs(parser._body, {"path", "renditions"});
+
+    string videoCodec = "h264";
+    string audioCodec;
+
+    if (parser._body.find("videoCodec") != parser._body.end()) {
+        videoCodec = parser._body["videoCodec"];
+    }
+
+    if (parser._body.find("audioCodec") != parser._body.end()) {
+        audioCodec = parser._body["audioCodec"];
+    }
+
+    auto& jRenditions = parser._body["renditions"];
+    if (!jRenditions.is_array() || jRenditions.empty()) {
+        throw ApiException(400, "renditions must be a non-empty array");
+    }
+
+    // 所有码率用同一个gop，保证关键帧对齐
+    int gop = 0;
+    if (parser._body.find("gop") != parser._body.end()) {
+        gop = toInt(parser._body["gop"]);
+    }
+
+    vector<VideoEncodeOption> renditions;
+    for (auto& jRendition : jRenditions) {
+        if (jRendition.find("name") == jRendition.end()) {
+            throw ApiException(400, "rendition name must be set");
+        }
+
+        VideoEncodeOption option;
+        option.name_ = jRendition["name"];
+        if (jRendition.find("width") != jRendition.end()) {
+            option.width_ = toInt(jRendition["width"]);
+        }
+        if (jRendition.find("height") != jRendition.end()) {
+            option.height_ = toInt(jRendition["height"]);
+        }
+        if (jRendition.find("bitrate") != jRendition.end()) {
+            option.bitrate_ = toInt(jRendition["bitrate"]);
+        }
+        option.gop_ = gop;
+        renditions.push_back(option);
+    }
+
+    string taskId = TranscodeTask::addLadderTask(parser._body["path"], videoCodec, audioCodec, renditions);
+
+    HttpResponse rsp;
+    rsp._status = 200;
+    json value;
+    value["code"] = "200";
+    value["msg"] = "success";
+    value["taskId"] = taskId;
+    rsp.setContent(value.dump());
+    rspFunc(rsp);
+}
+
 void FfmpegApi::delTask(const HttpParser& parser, const UrlParser& urlParser, 
                         const function<void(HttpResponse& rsp)>& rspFunc)
 {
@@ -91,4 +156,55 @@ void FfmpegApi::reconfig(const HttpParser& parser, const UrlParser& urlParser,
     rspFunc(rsp);
 }
 
+void FfmpegApi::getSnapshot(const HttpParser& parser, const UrlParser& urlParser, 
+                        const function<void(HttpResponse& rsp)>& rspFunc)
+{
+    checkArgs(parser._body, {"path"});
+
+    SnapshotOption option;
+    if (parser._body.find("format") != parser._body.end()) {
+        option.format_ = parser._body["format"];
+    }
+    if (option.format_ != "jpeg" && option.format_ != "webp") {
+        throw ApiException(400, "format must be jpeg or webp");
+    }
+    if (parser._body.find("width") != parser._body.end()) {
+        option.width_ = toInt(parser._body["width"]);
+    }
+    if (parser._body.find("height") != parser._body.end()) {
+        option.height_ = toInt(parser._body["height"]);
+    }
+    if (parser._body.find("quality") != parser._body.end()) {
+        option.quality_ = toInt(parser._body["quality"]);
+    }
+    if (option.width_ > 4096 || option.height_ > 4096) {
+        throw ApiException(400, "width or height is too large");
+    }
+
+    auto curLoop = EventLoop::getCurrentLoop();
+    if (!curLoop) {
+        throw ApiException(400, "loop is empty");
+    }
+
+    string contentType = option.contentType();
+    Snapshot::getSnapshot(parser._body["path"], parser._body.value("vhost", DEFAULT_VHOST), 
+        parser._body.value("type", DEFAULT_TYPE), option, 
+        [curLoop, contentType, rspFunc](const string& err, const string& image){
+        // 回调在work loop里，切回http连接的loop回复
+        curLoop->async([err, image, contentType, rspFunc](){
+            HttpResponse rsp;
+            rsp._status = 200;
+            if (err.empty()) {
+                rsp.setContent(image, contentType);
+            } else {
+                json value;
+                value["code"] = "400";
+                value["msg"] = err;
+                rsp.setContent(value.dump());
+            }
+            rspFunc(rsp);
+        }, true);
+    });
+}
+
 #endif
\ No newline at end of file
@@ -8,6 +8,8 @@
 #include "Common/Define.h"
 #include "Common/ApiUtil.h"
 #include "Util/TimeClock.h"
+#include "Net/BufferPool.h"
+#include "Common/EdgeRelay.h"
 
 using namespace std;
 
@@ -23,11 +25,16 @@ void HttpApi::initApi()
     g_mapApi.emplace("/api/v1/getClientList", HttpApi::getClientList);
     g_mapApi.emplace("/api/v1/closeClient", HttpApi::closeClient);
     g_mapApi.emplace("/api/v1/getLoopList", HttpApi::getLoopList);
+    g_mapApi.emplace("/api/v1/getLoopStatistic", HttpApi::getLoopStatistic);
+    g_mapApi.emplace("/api/v1/setLoopStatistic", HttpApi::setLoopStatistic);
+    g_mapApi.emplace("/api/v1/getBufferPoolInfo", HttpApi::getBufferPoolInfo);
+    g_mapApi.emplace("/api/v1/getEdgeRelayInfo", HttpApi::getEdgeRelayInfo);
     g_mapApi.emplace("/api/v1/exitServer", HttpApi::exitServer);
     g_mapApi.emplace("/api/v1/version", HttpApi::getVersion);
     g_mapApi.emplace("/api/v1/getServerInfo", HttpApi::getServerInfo);
 
     g_mapApi.emplace("/api/v1/streams/keyframe", HttpApi::getKeyframe);
+    g_mapApi.emplace("/api/v1/streams/keyframeIndex", HttpApi::getKeyframeIndex);
     g_mapApi.emplace("/api/v1/streams/setStampMode", HttpApi::setStampMode);
 }
 
@@ -386,6 +393,10 @@ void HttpApi::getLoopList(const HttpParser& parser, const UrlParser& urlParser,
         item["lastRunDuration"] = lastRunDuration;
         item["curWaitDuration"] = curWaitDuration;
         item["curRunDuration"] = curRunDuration;
+        item["loadPermille"] = loop->getLoadPermille();
+        item["byteRate"] = loop->getByteRate();
+        item["connCount"] = loop->getConnCount();
+        item["score"] = EventLoopPool::instance()->getLoopScore(loop);
 
         value["loops"].push_back(item);
     });
@@ -396,6 +407,166 @@ void HttpApi::getLoopList(const HttpParser& parser, const UrlParser& urlParser,
     rspFunc(rsp);
 }
 
+static json histogramToJson(const LatencyHistogram& hist)
+{
+    json item;
+    uint64_t count = hist.count();
+    item["count"] = count;
+    item["avg"] = count ? hist.sum() / count : 0;
+    item["max"] = hist.max();
+    item["p50"] = hist.percentile(0.5);
+    item["p90"] = hist.percentile(0.9);
+    item["p99"] = hist.percentile(0.99);
+    item["p999"] = hist.percentile(0.999);
+
+    // 只输出非空的桶，key为桶的上边界(us)
+    for (int i = 0; i < LatencyHistogram::kBucketNum; ++i) {
+        auto num = hist.bucket(i);
+        if (num) {
+            item["buckets"][to_string(LatencyHistogram::bucketUpperBound(i))] = num;
+        }
+    }
+
+    return item;
+}
+
+void HttpApi::getLoopStatistic(const HttpParser& parser, const UrlParser& urlParser, 
+                        const function<void(HttpResponse& rsp)>& rspFunc)
+{
+    HttpResponse rsp;
+    rsp._status = 200;
+    json value;
+
+    EventLoopPool::instance()->for_each_loop([&value](const EventLoop::Ptr &loop){
+        auto stat = loop->getStatistic();
+
+        json item;
+        item["epollFd"] = loop->getEpollFd();
+        item["fdCount"] = loop->getFdCount();
+        item["timerTaskCount"] = loop->getTimerTaskCount();
+        item["backend"] = loop->isUring() ? "io_uring" : "epoll";
+        item["syscalls"] = stat->syscalls.load();
+        item["unit"] = "us";
+        item["wait"] = histogramToJson(stat->waitHist);
+        item["event"] = histogramToJson(stat->eventHist);
+        item["async"] = histogramToJson(stat->asyncHist);
+        item["timer"] = histogramToJson(stat->timerHist);
+        item["postToRun"] = histogramToJson(stat->postHist);
+
+        item["slowCallback"]["thresholdUs"] = stat->slowTracer.getThreshold();
+        item["slowCallback"]["count"] = stat->slowTracer.getSlowCount();
+        item["slowCallback"]["top"] = json::array();
+        for (auto& info : stat->slowTracer.getTop()) {
+            json slow;
+            slow["type"] = info.type;
+            slow["site"] = info.site;
+            slow["duration"] = info.duration;
+            slow["time"] = info.time;
+            item["slowCallback"]["top"].push_back(slow);
+        }
+
+        value["loops"].push_back(item);
+    });
+
+    value["code"] = "200";
+    value["msg"] = "success";
+    rsp.setContent(value.dump());
+    rspFunc(rsp);
+}
+
+void HttpApi::setLoopStatistic(const HttpParser& parser, const UrlParser& urlParser, 
+                        const function<void(HttpResponse& rsp)>& rspFunc)
+{
+    // 会清空统计、修改阈值，只接受POST
+    if (parser._method != "POST") {
+        throw ApiException(400, "method must be POST");
+    }
+
+    HttpResponse rsp;
+    rsp._status = 200;
+    json value;
+
+    json body = parser._body;
+    if (!body.is_object()) {
+        throw ApiException(400, "body must be a json object");
+    }
+    bool reset = body.value("reset", false);
+    int slowThreshold = getInt(body, "slowThresholdUs", 0);
+
+    EventLoopPool::instance()->for_each_loop([reset, slowThreshold](const EventLoop::Ptr &loop){
+        auto stat = loop->getStatistic();
+        if (slowThreshold > 0) {
+            stat->slowTracer.setThreshold(slowThreshold);
+        }
+        if (reset) {
+            stat->reset();
+        }
+    });
+
+    value["code"] = "200";
+    value["msg"] = "success";
+    rsp.setContent(value.dump());
+    rspFunc(rsp);
+}
+
+void HttpApi::getBufferPoolInfo(const HttpParser& parser, const UrlParser& urlParser, 
+                        const function<void(HttpResponse& rsp)>& rspFunc)
+{
+    HttpResponse rsp;
+    rsp._status = 200;
+    json value;
+
+    auto stat = BufferPool::getStatistic();
+    value["enable"] = stat.enable;
+    value["threads"] = stat.threads;
+    value["allocs"] = stat.allocs;
+    value["hits"] = stat.hits;
+    value["liveBytes"] = stat.liveBytes;
+    value["peakBytes"] = stat.peakBytes;
+    value["cachedBytes"] = stat.cachedBytes;
+    value["classes"] = json::array();
+    for (auto& cls : stat.classes) {
+        json item;
+        // 大块的blockSize为0，不缓存
+        item["blockSize"] = cls.blockSize;
+        item["allocs"] = cls.allocs;
+        item["hits"] = cls.hits;
+        item["hitRate"] = cls.allocs ? (double)cls.hits / cls.allocs : 0;
+        item["cachedBlocks"] = cls.cachedBlocks;
+        value["classes"].push_back(item);
+    }
+
+    value["code"] = "200";
+    value["msg"] = "success";
+    rsp.setContent(value.dump());
+    rspFunc(rsp);
+}
+
+void HttpApi::getEdgeRelayInfo(const HttpParser& parser, const UrlParser& urlParser, 
+                        const function<void(HttpResponse& rsp)>& rspFunc)
+{
+    HttpResponse rsp;
+    rsp._status = 200;
+    json value;
+
+    auto relay = EdgeRelay::instance();
+    value["sessions"] = relay->getSessionCount();
+    value["origins"] = json::array();
+    for (auto& info : relay->getOriginInfo()) {
+        json item;
+        item["endpoint"] = info.endpoint;
+        item["healthy"] = info.healthy;
+        item["failCount"] = info.failCount;
+        item["downTime"] = info.downTime;
+        value["origins"].push_back(item);
+    }
+
+    value["code"] = "200";
+    value["msg"] = "success";
+    rsp.setContent(value.dump());
+    rspFunc(rsp);
+}
+
 void HttpApi::exitServer(const HttpParser& parser, const UrlParser& urlParser, 
                         const function<void(HttpResponse& rsp)>& rspFunc)
 {
@@ -464,6 +635,39 @@ void HttpApi::setStampMode(const HttpParser& parser, const UrlParser& urlParser,
     rspFunc(rsp);
 }
 
+void HttpApi::getKeyframeIndex(const HttpParser& parser, const UrlParser& urlParser, 
+                        const function<void(HttpResponse& rsp)>& rspFunc)
+{
+    HttpResponse rsp;
+    rsp._status = 200;
+    json value;
+
+    json body = parser._body;
+    checkArgs(body, {"path", "protocol"});
+
+    auto source = MediaSource::get(body["path"], body.value("vhost", DEFAULT_VHOST), body["protocol"], body.value("type", DEFAULT_TYPE));
+    if (!source) {
+        value["code"] = "400";
+        value["msg"] = "source is empty";
+    } else {
+        auto now = TimeClock::now();
+        auto index = source->getKeyframeIndex();
+        for (auto& info : index) {
+            json item;
+            item["seq"] = info.seq;
+            item["time"] = info.time;
+            item["ageMs"] = now > info.time ? now - info.time : 0;
+            value["keyframes"].push_back(item);
+        }
+        value["count"] = index.size();
+        value["code"] = "200";
+        value["msg"] = "success";
+    }
+
+    rsp.setContent(value.dump());
+    rspFunc(rsp);
+}
+
 void HttpApi::getKeyframe(const HttpParser& parser, const UrlParser& urlParser, 
                         const function<void(HttpResponse& rsp)>& rspFunc)
 {
@@ -125,7 +125,42 @@ void HttpStreamApi::stopHlsPlay(const HttpParser& parser, const UrlParser& urlPa
 void HttpStreamApi::listHlsPlayInfo(const HttpParser& parser, const UrlParser& urlParser, 
                         const function<void(HttpResponse& rsp)>& rspFunc)
 {
-    
+    HttpResponse rsp;
+    rsp._status = 200;
+    json value;
+
+    int count = 0;
+    auto allClients = MediaClient::getAllMediaClient();
+    for (auto& pr : allClients) {
+        string protocol;
+        MediaClientType type;
+        pr.second->getProtocolAndType(protocol, type);
+
+        if (protocol == "hls" && type == MediaClientType_Pull) {
+            auto hlsClient = dynamic_pointer_cast<HlsClientContext>(pr.second);
+            if (!hlsClient) {
+                continue ;
+            }
+            json item;
+            item["path"] = hlsClient->getPath();
+            item["url"] = hlsClient->getUrl();
+            item["playlistUrl"] = hlsClient->getPlaylistUrl();
+            item["bandwidth"] = hlsClient->getBandwidth();
+            item["variantBandwidth"] = hlsClient->getVariantBandwidth();
+            item["recvBytes"] = hlsClient->getRecvBytes();
+            item["segmentCount"] = hlsClient->getSegmentCount();
+            item["connectionCount"] = hlsClient->getConnectionCount();
+
+            value["clients"].push_back(item);
+            ++count;
+        }
+    }
+
+    value["code"] = "200";
+    value["msg"] = "success";
+    value["count"] = count;
+    rsp.setContent(value.dump());
+    rspFunc(rsp);
 }
 #endif
 
@@ -1,4 +1,6 @@
-﻿#include "Common/ApiUtil.h"
+﻿#include <cmath>
+
+#include "Common/ApiUtil.h"
 #include "Logger.h"
 #include "VodApi.h"
 #include "Common/MediaSource.h"
@@ -83,8 +85,9 @@ void VodApi::control(const HttpParser& parser, const UrlParser& urlParser,
         return ;
     }
 
+    // 负数为倒放，超过Record.trickPlayScale或倒放时只发关键帧
     float scale = getFloat(parser._body, "scale", 0);
-    if (scale > 0.01) {
+    if (fabs(scale) > 0.01) {
         reader->scale(scale);
     }
 
@@ -8,6 +8,7 @@
 #include "Webrtc/WebrtcContextManager.h"
 #include "Webrtc/WebrtcContext.h"
 #include "Webrtc/WebrtcClient.h"
+#include "Webrtc/WebrtcForwarder.h"
 
 #include <unordered_map>
 
@@ -32,6 +33,8 @@ void WebrtcApi::initApi()
     g_mapApi.emplace("/api/v1/rtc/push/start", WebrtcApi::startRtcPush);
     g_mapApi.emplace("/api/v1/rtc/push/stop", WebrtcApi::stopRtcPush);
     g_mapApi.emplace("/api/v1/rtc/push/list", WebrtcApi::listRtcPush);
+
+    g_mapApi.emplace("/api/v1/rtc/forward/statistic", WebrtcApi::getForwardStatistic);
 }
 
 void WebrtcApi::rtcPlay(const HttpParser& parser, const UrlParser& urlParser, 
@@ -320,4 +323,22 @@ void WebrtcApi::listRtcPush(const HttpParser& parser, const UrlParser& urlParser
     // rspFunc(rsp);
 }
 
-#endif
\ No newline at end of file
+void WebrtcApi::getForwardStatistic(const HttpParser& parser, const UrlParser& urlParser, 
+             const function<void(HttpResponse& rsp)>& rspFunc)
+{
+    HttpResponse rsp;
+    rsp._status = 200;
+    json value;
+
+    auto forwarder = WebrtcForwarder::instance();
+    value["forwardCount"] = forwarder->getForwardCount();
+    value["batchCount"] = forwarder->getBatchCount();
+    value["fallbackCount"] = forwarder->getFallbackCount();
+
+    value["code"] = "200";
+    value["msg"] = "success";
+    rsp.setContent(value.dump());
+    rspFunc(rsp);
+}
+
+#endif
@@ -44,6 +44,10 @@ public:
 
     static void listRtcPush(const HttpParser& parser, const UrlParser& urlParser, 
                         const function<void(HttpResponse& rsp)>& rspFunc);
+
+    // 跨loop转发统计
+    static void getForwardStatistic(const HttpParser& parser, const UrlParser& urlParser, 
+                        const function<void(HttpResponse& rsp)>& rspFunc);
 };
 
 #endif
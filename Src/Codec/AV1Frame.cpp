@@ -121,7 +121,7 @@ int aom_av1_obu_split(const uint8_t* data, size_t bytes, const function<int (con
 
 AV1Frame::AV1Frame()
 {
-    _codec = "av1";
+    _codec = CodecAV1;
     _trackType = 0; //VideoTrackType;
 }
 
@@ -182,7 +182,7 @@ FrameBuffer::Ptr AV1Frame::createFrame(int startSize, int index, bool addStart)
     auto frame = make_shared<AV1Frame>();
         
     frame->_startSize = startSize;
-    frame->_codec = "av1";
+    frame->_codec = CodecAV1;
     frame->_index = index;
     frame->_trackType = 0;//VideoTrackType;
 
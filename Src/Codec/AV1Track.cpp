@@ -316,7 +316,7 @@ AV1Track::Ptr AV1Track::createTrack(int index, int payloadType, int samplerate)
 {
     auto trackInfo = make_shared<AV1Track>();
     trackInfo->index_ = index;
-    trackInfo->codec_ = "av1";
+    trackInfo->codec_ = CodecAV1;
     trackInfo->payloadType_ = payloadType;
     trackInfo->trackType_ = "video";
     trackInfo->samplerate_ = samplerate;
@@ -329,7 +329,7 @@ void AV1Track::registerTrackInfo()
 	TrackInfo::registerTrackInfo("av1", [](int index, int payloadType, int samplerate){
 		auto trackInfo = make_shared<AV1Track>();
 		trackInfo->index_ = VideoTrackType;
-		trackInfo->codec_ = "av1";
+		trackInfo->codec_ = CodecAV1;
 		trackInfo->payloadType_ = 96;
 		trackInfo->trackType_ = "video";
 		trackInfo->samplerate_ = 90000;
@@ -33,7 +33,7 @@ static FrameBuffer::Ptr getAdtsAac()
     frame->_buffer[m_data_len++] = (char)0x8C;
     frame->_buffer[m_data_len++] = (char)0x1C;
 
-    frame->_codec = "aac";
+    frame->_codec = CodecAAC;
     frame->_trackType = 1; //AudioTrackType
     frame->_startSize = 7;
     frame->_index = 1;
@@ -114,7 +114,7 @@ FrameBuffer::Ptr AacFrame::createFrame(int startSize, int index, bool addStart)
     auto frame = make_shared<AacFrame>();
         
     frame->_startSize = startSize;
-    frame->_codec = "aac";
+    frame->_codec = CodecAAC;
     frame->_index = index;
     frame->_trackType = 1;//AudioTrackType;
 
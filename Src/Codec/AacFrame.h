@@ -18,7 +18,7 @@ public:
 
     AacFrame()
     {
-        _codec = "aac";
+        _codec = CodecAAC;
     }
 
     void split(const function<void(const FrameBuffer::Ptr& frame)>& cb) override;
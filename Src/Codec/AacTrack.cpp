@@ -365,7 +365,7 @@ AacTrack::Ptr AacTrack::createTrack(int index, int payloadType, int samplerate)
 {
     auto trackInfo = make_shared<AacTrack>();
     trackInfo->index_ = index;
-    trackInfo->codec_ = "aac";
+    trackInfo->codec_ = CodecAAC;
     trackInfo->payloadType_ = payloadType;
     trackInfo->trackType_ = "audio";
     trackInfo->samplerate_ = samplerate;
@@ -379,7 +379,7 @@ void AacTrack::registerTrackInfo()
 	TrackInfo::registerTrackInfo("aac", [](int index, int payloadType, int samplerate){
 		auto trackInfo = make_shared<AacTrack>();
 		trackInfo->index_ = AudioTrackType;
-		trackInfo->codec_ = "aac";
+		trackInfo->codec_ = CodecAAC;
 		trackInfo->payloadType_ = 97;
 		trackInfo->trackType_ = "audio";
 		trackInfo->samplerate_ = 44100;
@@ -33,7 +33,7 @@ AdpcmaTrack::Ptr AdpcmaTrack::createTrack(int index, int payloadType, int sample
 {
     auto trackInfo = make_shared<AdpcmaTrack>();
     trackInfo->index_ = index;
-    trackInfo->codec_ = "adpcma";
+    trackInfo->codec_ = CodecAdpcma;
     trackInfo->payloadType_ = payloadType;
     trackInfo->trackType_ = "audio";
     trackInfo->samplerate_ = samplerate;
@@ -47,7 +47,7 @@ void AdpcmaTrack::registerTrackInfo()
 	TrackInfo::registerTrackInfo("adpcma", [](int index, int payloadType, int samplerate){
 		auto trackInfo = make_shared<AdpcmaTrack>();
 		trackInfo->index_ = AudioTrackType;
-		trackInfo->codec_ = "adpcma";
+		trackInfo->codec_ = CodecAdpcma;
 		trackInfo->payloadType_ = PayloadType_ADPCMA;
 		trackInfo->trackType_ = "audio";
 		trackInfo->samplerate_ = 8000;
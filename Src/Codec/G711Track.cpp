@@ -33,7 +33,7 @@ G711aTrack::Ptr G711aTrack::createTrack(int index, int payloadType, int samplera
 {
     auto trackInfo = make_shared<G711aTrack>();
     trackInfo->index_ = index;
-    trackInfo->codec_ = "g711a";
+    trackInfo->codec_ = CodecG711A;
     trackInfo->payloadType_ = payloadType;
     trackInfo->trackType_ = "audio";
     trackInfo->samplerate_ = samplerate;
@@ -47,7 +47,7 @@ void G711aTrack::registerTrackInfo()
 	TrackInfo::registerTrackInfo("g711a", [](int index, int payloadType, int samplerate){
 		auto trackInfo = make_shared<G711aTrack>();
 		trackInfo->index_ = AudioTrackType;
-		trackInfo->codec_ = "g711a";
+		trackInfo->codec_ = CodecG711A;
 		trackInfo->payloadType_ = 8;
 		trackInfo->trackType_ = "audio";
 		trackInfo->samplerate_ = 8000;
@@ -78,7 +78,7 @@ G711uTrack::Ptr G711uTrack::createTrack(int index, int payloadType, int samplera
 {
     auto trackInfo = make_shared<G711uTrack>();
     trackInfo->index_ = index;
-    trackInfo->codec_ = "g711u";
+    trackInfo->codec_ = CodecG711U;
     trackInfo->payloadType_ = payloadType;
     trackInfo->trackType_ = "audio";
     trackInfo->samplerate_ = samplerate;
@@ -92,7 +92,7 @@ void G711uTrack::registerTrackInfo()
 	TrackInfo::registerTrackInfo("g711u", [](int index, int payloadType, int samplerate){
 		auto trackInfo = make_shared<G711uTrack>();
 		trackInfo->index_ = AudioTrackType;
-		trackInfo->codec_ = "g711u";
+		trackInfo->codec_ = CodecG711U;
 		trackInfo->payloadType_ = 0;
 		trackInfo->trackType_ = "audio";
 		trackInfo->samplerate_ = 8000;
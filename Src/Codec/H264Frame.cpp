@@ -155,7 +155,7 @@ FrameBuffer::Ptr H264Frame::createFrame(int startSize, int index, bool addStart)
     auto frame = make_shared<H264Frame>();
         
     frame->_startSize = startSize;
-    frame->_codec = "h264";
+    frame->_codec = CodecH264;
     frame->_index = index;
     frame->_trackType = 0;//VideoTrackType;
 
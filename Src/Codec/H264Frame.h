@@ -42,7 +42,7 @@ public:
 
     H264Frame()
     {
-        _codec = "h264";
+        _codec = CodecH264;
     }
 
     H264Frame(const H264Frame::Ptr& frame);
@@ -162,7 +162,7 @@ void H264Track::setConfig(const string& config)
         index += 2;
         auto frame = make_shared<H264Frame>();
         frame->_startSize = 4;
-        frame->_codec = "h264";
+        frame->_codec = CodecH264;
         frame->_index = index_;
         frame->_trackType = VideoTrackType;
 
@@ -184,7 +184,7 @@ void H264Track::setConfig(const string& config)
         index += 2;
         auto frame = make_shared<H264Frame>();
         frame->_startSize = 4;
-        frame->_codec = "h264";
+        frame->_codec = CodecH264;
         frame->_index = index_;
         frame->_trackType = VideoTrackType;
 
@@ -204,7 +204,7 @@ H264Track::Ptr H264Track::createTrack(int index, int payloadType, int samplerate
 {
     auto trackInfo = make_shared<H264Track>();
     trackInfo->index_ = index;
-    trackInfo->codec_ = "h264";
+    trackInfo->codec_ = CodecH264;
     trackInfo->payloadType_ = payloadType;
     trackInfo->trackType_ = "video";
     trackInfo->samplerate_ = samplerate;
@@ -217,7 +217,7 @@ void H264Track::registerTrackInfo()
 	TrackInfo::registerTrackInfo("h264", [](int index, int payloadType, int samplerate){
 		auto trackInfo = make_shared<H264Track>();
 		trackInfo->index_ = VideoTrackType;
-		trackInfo->codec_ = "h264";
+		trackInfo->codec_ = CodecH264;
 		trackInfo->payloadType_ = 96;
 		trackInfo->trackType_ = "video";
 		trackInfo->samplerate_ = 90000;
@@ -124,7 +124,7 @@ FrameBuffer::Ptr H265Frame::createFrame(int startSize, int index, bool addStart)
     auto frame = make_shared<H265Frame>();
         
     frame->_startSize = startSize;
-    frame->_codec = "h265";
+    frame->_codec = CodecH265;
     frame->_index = index;
     frame->_trackType = 0;//VideoTrackType;
 
@@ -50,7 +50,7 @@ public:
 
     H265Frame()
     {
-        _codec = "h265";
+        _codec = CodecH265;
     }
     
     H265Frame(const H265Frame::Ptr& frame);
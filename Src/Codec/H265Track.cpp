@@ -492,7 +492,7 @@ void H265Track::setConfig(const string& config)
 
 			auto frame = make_shared<H265Frame>();
 			frame->_startSize = 4;
-			frame->_codec = "h265";
+			frame->_codec = CodecH265;
 			frame->_index = index_;
 			frame->_trackType = VideoTrackType;
 
@@ -568,7 +568,7 @@ H265Track::Ptr H265Track::createTrack(int index, int payloadType, int samplerate
 {
     auto trackInfo = make_shared<H265Track>();
     trackInfo->index_ = index;
-    trackInfo->codec_ = "h265";
+    trackInfo->codec_ = CodecH265;
     trackInfo->payloadType_ = payloadType;
     trackInfo->trackType_ = "video";
     trackInfo->samplerate_ = samplerate;
@@ -581,7 +581,7 @@ void H265Track::registerTrackInfo()
 	TrackInfo::registerTrackInfo("h265", [](int index, int payloadType, int samplerate){
 		auto trackInfo = make_shared<H265Track>();
 		trackInfo->index_ = VideoTrackType;
-		trackInfo->codec_ = "h265";
+		trackInfo->codec_ = CodecH265;
 		trackInfo->payloadType_ = 96;
 		trackInfo->trackType_ = "video";
 		trackInfo->samplerate_ = 90000;
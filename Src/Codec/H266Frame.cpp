@@ -128,7 +128,7 @@ FrameBuffer::Ptr H266Frame::createFrame(int startSize, int index, bool addStart)
     auto frame = make_shared<H266Frame>();
         
     frame->_startSize = startSize;
-    frame->_codec = "h266";
+    frame->_codec = CodecH266;
     frame->_index = index;
     frame->_trackType = 0;//VideoTrackType;
 
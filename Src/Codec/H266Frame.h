@@ -34,7 +34,7 @@ public:
 
     H266Frame()
     {
-        _codec = "h266";
+        _codec = CodecH266;
     }
     
     H266Frame(const H266Frame::Ptr& frame);
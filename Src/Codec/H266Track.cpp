@@ -186,7 +186,7 @@ H266Track::Ptr H266Track::createTrack(int index, int payloadType, int samplerate
 {
     auto trackInfo = make_shared<H266Track>();
     trackInfo->index_ = index;
-    trackInfo->codec_ = "h266";
+    trackInfo->codec_ = CodecH266;
     trackInfo->payloadType_ = payloadType;
     trackInfo->trackType_ = "video";
     trackInfo->samplerate_ = samplerate;
@@ -199,7 +199,7 @@ void H266Track::registerTrackInfo()
 	TrackInfo::registerTrackInfo("h266", [](int index, int payloadType, int samplerate){
 		auto trackInfo = make_shared<H266Track>();
 		trackInfo->index_ = VideoTrackType;
-		trackInfo->codec_ = "h266";
+		trackInfo->codec_ = CodecH266;
 		trackInfo->payloadType_ = 96;
 		trackInfo->trackType_ = "video";
 		trackInfo->samplerate_ = 90000;
@@ -201,7 +201,7 @@ Mp3Track::Ptr Mp3Track::createTrack(int index, int payloadType, int samplerate)
 {
     auto trackInfo = make_shared<Mp3Track>();
     trackInfo->index_ = index;
-    trackInfo->codec_ = "mp3";
+    trackInfo->codec_ = CodecMP3;
     trackInfo->payloadType_ = payloadType;
     trackInfo->trackType_ = "audio";
     trackInfo->samplerate_ = samplerate;
@@ -217,7 +217,7 @@ void Mp3Track::registerTrackInfo()
 	TrackInfo::registerTrackInfo("mp3", [](int index, int payloadType, int samplerate){
 		auto trackInfo = make_shared<Mp3Track>();
 		trackInfo->index_ = AudioTrackType;
-		trackInfo->codec_ = "mp3";
+		trackInfo->codec_ = CodecMP3;
 		trackInfo->payloadType_ = 14;
 		trackInfo->trackType_ = "audio";
 		trackInfo->samplerate_ = 44100;
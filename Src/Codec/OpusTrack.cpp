@@ -33,7 +33,7 @@ OpusTrack::Ptr OpusTrack::createTrack(int index, int payloadType, int samplerate
 {
     auto trackInfo = make_shared<OpusTrack>();
     trackInfo->index_ = index;
-    trackInfo->codec_ = "opus";
+    trackInfo->codec_ = CodecOpus;
     trackInfo->payloadType_ = payloadType;
     trackInfo->trackType_ = "audio";
     trackInfo->samplerate_ = samplerate;
@@ -47,7 +47,7 @@ void OpusTrack::registerTrackInfo()
 	TrackInfo::registerTrackInfo("opus", [](int index, int payloadType, int samplerate){
 		auto trackInfo = make_shared<OpusTrack>();
 		trackInfo->index_ = AudioTrackType;
-		trackInfo->codec_ = "opus";
+		trackInfo->codec_ = CodecOpus;
 		trackInfo->payloadType_ = PayloadType_OPUS;
 		trackInfo->trackType_ = "audio";
 		trackInfo->samplerate_ = 48000;
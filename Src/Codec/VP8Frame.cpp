@@ -41,7 +41,7 @@ FrameBuffer::Ptr VP8Frame::createFrame(int startSize, int index, bool addStart)
     auto frame = make_shared<VP8Frame>();
         
     frame->_startSize = startSize;
-    frame->_codec = "vp8";
+    frame->_codec = CodecVP8;
     frame->_index = index;
     frame->_trackType = 0;//VideoTrackType;
 
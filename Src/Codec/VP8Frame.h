@@ -23,7 +23,7 @@ public:
 
     VP8Frame()
     {
-        _codec = "vp8";
+        _codec = CodecVP8;
     }
     
     VP8Frame(const VP8Frame::Ptr& frame);
@@ -89,7 +89,7 @@ VP8Track::Ptr VP8Track::createTrack(int index, int payloadType, int samplerate)
 {
     auto trackInfo = make_shared<VP8Track>();
     trackInfo->index_ = index;
-    trackInfo->codec_ = "vp8";
+    trackInfo->codec_ = CodecVP8;
     trackInfo->payloadType_ = payloadType;
     trackInfo->trackType_ = "video";
     trackInfo->samplerate_ = samplerate;
@@ -102,7 +102,7 @@ void VP8Track::registerTrackInfo()
 	TrackInfo::registerTrackInfo("vp8", [](int index, int payloadType, int samplerate){
 		auto trackInfo = make_shared<VP8Track>();
 		trackInfo->index_ = VideoTrackType;
-		trackInfo->codec_ = "vp8";
+		trackInfo->codec_ = CodecVP8;
 		trackInfo->payloadType_ = 96;
 		trackInfo->trackType_ = "video";
 		trackInfo->samplerate_ = 90000;
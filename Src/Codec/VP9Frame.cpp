@@ -41,7 +41,7 @@ FrameBuffer::Ptr VP9Frame::createFrame(int startSize, int index, bool addStart)
     auto frame = make_shared<VP9Frame>();
         
     frame->_startSize = startSize;
-    frame->_codec = "vp9";
+    frame->_codec = CodecVP9;
     frame->_index = index;
     frame->_trackType = 0;//VideoTrackType;
 
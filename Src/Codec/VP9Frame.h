@@ -95,7 +95,7 @@ public:
 
     VP9Frame()
     {
-        _codec = "vp9";
+        _codec = CodecVP9;
     }
     
     VP9Frame(const VP9Frame::Ptr& frame);
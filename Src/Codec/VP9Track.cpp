@@ -101,7 +101,7 @@ VP9Track::Ptr VP9Track::createTrack(int index, int payloadType, int samplerate)
 {
     auto trackInfo = make_shared<VP9Track>();
     trackInfo->index_ = index;
-    trackInfo->codec_ = "vp9";
+    trackInfo->codec_ = CodecVP9;
     trackInfo->payloadType_ = payloadType;
     trackInfo->trackType_ = "video";
     trackInfo->samplerate_ = samplerate;
@@ -114,7 +114,7 @@ void VP9Track::registerTrackInfo()
 	TrackInfo::registerTrackInfo("vp9", [](int index, int payloadType, int samplerate){
 		auto trackInfo = make_shared<VP9Track>();
 		trackInfo->index_ = VideoTrackType;
-		trackInfo->codec_ = "vp9";
+		trackInfo->codec_ = CodecVP9;
 		trackInfo->payloadType_ = 96;
 		trackInfo->trackType_ = "video";
 		trackInfo->samplerate_ = 90000;
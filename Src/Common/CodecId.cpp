@@ -0,0 +1,129 @@
+#include "CodecId.h"
+
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+
+using namespace std;
+
+// 下标和CodecType一一对应
+static const char* kBuiltinNames[CodecBuiltinEnd] = {
+    "",
+    "unknown",
+    "h264",
+    "h265",
+    "h266",
+    "vp8",
+    "vp9",
+    "av1",
+    "aac",
+    "mp3",
+    "opus",
+    "g711a",
+    "g711u",
+    "g726",
+    "adpcma",
+    "ps",
+    "rtx",
+    "red",
+    "ulpfec"
+};
+
+// 内置名字表只读，动态名字只增不删，名字常驻内存，name()返回的引用一直有效
+class CodecTable
+{
+public:
+    static CodecTable& instance()
+    {
+        static CodecTable table;
+        return table;
+    }
+
+    CodecTable()
+    {
+        for (int i = 0; i < CodecBuiltinEnd; ++i) {
+            _builtin[i] = kBuiltinNames[i];
+            if (i > CodecInvalid) {
+                _mapBuiltin.emplace(_builtin[i], (uint16_t)i);
+            }
+        }
+        for (auto& name : _dynamic) {
+            name.store(nullptr, memory_order_relaxed);
+        }
+    }
+
+    const string& name(uint16_t id)
+    {
+        if (id < CodecBuiltinEnd) {
+            return _builtin[id];
+        }
+        int index = id - CodecBuiltinEnd;
+        const string* name = index < CodecId::kMaxDynamicNum ? _dynamic[index].load(memory_order_acquire) : nullptr;
+        return name ? *name : _builtin[CodecUnknown];
+    }
+
+    uint16_t find(const string& name)
+    {
+        auto it = _mapBuiltin.find(name);
+        if (it != _mapBuiltin.end()) {
+            return it->second;
+        }
+
+        lock_guard<mutex> lck(_mtx);
+        auto iter = _mapDynamic.find(name);
+        return iter == _mapDynamic.end() ? CodecId::kNoCodec : iter->second;
+    }
+
+    uint16_t intern(const string& name)
+    {
+        auto it = _mapBuiltin.find(name);
+        if (it != _mapBuiltin.end()) {
+            return it->second;
+        }
+
+        lock_guard<mutex> lck(_mtx);
+        auto iter = _mapDynamic.find(name);
+        if (iter != _mapDynamic.end()) {
+            return iter->second;
+        }
+        if (_dynamicNum >= CodecId::kMaxDynamicNum) {
+            return CodecUnknown;
+        }
+        uint16_t id = CodecBuiltinEnd + _dynamicNum;
+        _dynamic[_dynamicNum++].store(new string(name), memory_order_release);
+        _mapDynamic.emplace(name, id);
+
+        return id;
+    }
+
+private:
+    int _dynamicNum = 0;
+    string _builtin[CodecBuiltinEnd];
+    unordered_map<string, uint16_t> _mapBuiltin;
+    mutex _mtx;
+    unordered_map<string, uint16_t> _mapDynamic;
+    atomic<const string*> _dynamic[CodecId::kMaxDynamicNum];
+};
+
+const string& CodecId::name() const
+{
+    return CodecTable::instance().name(_id);
+}
+
+uint16_t CodecId::lookup(const char* name, size_t size)
+{
+    if (size == 0) {
+        return CodecInvalid;
+    }
+
+    return CodecTable::instance().find(string(name, size));
+}
+
+uint16_t CodecId::intern(const char* name, size_t size)
+{
+    if (size == 0) {
+        return CodecInvalid;
+    }
+
+    return CodecTable::instance().intern(string(name, size));
+}
@@ -0,0 +1,95 @@
+#ifndef CodecId_H
+#define CodecId_H
+
+#include <string>
+#include <ostream>
+#include <cstdint>
+#include <cstring>
+
+// 内置的编码类型，新增编码时加在CodecBuiltinEnd前，并在CodecId.cpp里补上名字
+enum CodecType : uint16_t
+{
+    CodecInvalid = 0,
+    // 动态id用完后不认识的名字都归到这里，名字为"unknown"
+    CodecUnknown,
+    CodecH264,
+    CodecH265,
+    CodecH266,
+    CodecVP8,
+    CodecVP9,
+    CodecAV1,
+    CodecAAC,
+    CodecMP3,
+    CodecOpus,
+    CodecG711A,
+    CodecG711U,
+    CodecG726,
+    CodecAdpcma,
+    CodecPS,
+    CodecRtx,
+    CodecRed,
+    CodecUlpfec,
+    CodecBuiltinEnd
+};
+
+// 编码名字对应的id，帧和track里只存2字节的id，拷贝和比较都是整数操作
+// 字符串只在配置、sdp、api这些边界上通过name()/构造函数转换
+// 内置名字之外的名字在构造时分配动态id并保留原名，最多kMaxDynamicNum个，用完后为CodecUnknown
+class CodecId
+{
+public:
+    static const int kMaxDynamicNum = 1024;
+
+    CodecId() = default;
+    CodecId(CodecType type) : _id(type < CodecBuiltinEnd ? type : CodecUnknown) {}
+    CodecId(const std::string& name) : _id(intern(name.data(), name.size())) {}
+    CodecId(const char* name) : _id(intern(name, strlen(name))) {}
+
+public:
+    uint16_t id() const { return _id; }
+    CodecType type() const { return (CodecType)_id; }
+    bool empty() const { return _id == CodecInvalid; }
+    const std::string& name() const;
+    operator const std::string&() const { return name(); }
+
+    bool operator==(const CodecId& other) const { return _id == other._id; }
+    bool operator!=(const CodecId& other) const { return _id != other._id; }
+    bool operator==(CodecType type) const { return _id == type; }
+    bool operator!=(CodecType type) const { return _id != type; }
+    // 兼容和字符串比较的写法，先把名字哈希查成id再比较id，不会分配新id，热路径上请和CodecType比较
+    bool operator==(const char* name) const { return _id == lookup(name, strlen(name)); }
+    bool operator!=(const char* name) const { return _id != lookup(name, strlen(name)); }
+    bool operator==(const std::string& name) const { return _id == lookup(name.data(), name.size()); }
+    bool operator!=(const std::string& name) const { return _id != lookup(name.data(), name.size()); }
+
+    // 只查表不分配，空串为CodecInvalid，没有分配过id的名字返回kNoCodec，和任何id都不相等
+    static const uint16_t kNoCodec = 0xffff;
+    static uint16_t lookup(const char* name, size_t size);
+
+private:
+    // 查不到时分配动态id
+    static uint16_t intern(const char* name, size_t size);
+
+private:
+    uint16_t _id = CodecInvalid;
+};
+
+inline bool operator==(const char* name, const CodecId& codec) { return codec == name; }
+inline bool operator!=(const char* name, const CodecId& codec) { return codec != name; }
+inline bool operator==(const std::string& name, const CodecId& codec) { return codec == name; }
+inline bool operator!=(const std::string& name, const CodecId& codec) { return codec != name; }
+inline std::string operator+(const std::string& str, const CodecId& codec) { return str + codec.name(); }
+inline std::string operator+(const CodecId& codec, const std::string& str) { return codec.name() + str; }
+inline std::string operator+(const char* str, const CodecId& codec) { return str + codec.name(); }
+inline std::string operator+(const CodecId& codec, const char* str) { return codec.name() + str; }
+inline std::ostream& operator<<(std::ostream& os, const CodecId& codec) { return os << codec.name(); }
+
+namespace std {
+template<>
+struct hash<CodecId>
+{
+    size_t operator()(const CodecId& codec) const { return codec.id(); }
+};
+}
+
+#endif //CodecId_H
@@ -1 +1,55 @@
-﻿
\ No newline at end of file
+﻿#include "DataQue.h"
+#include "Config.h"
+
+using namespace std;
+
+DataQueStartPolicy DataQueStartPolicy::getDefault()
+{
+    static int mode = Config::instance()->getAndListen([](const json &config){
+        mode = Config::instance()->get("Util", "fastStartMode");
+    }, "Util", "fastStartMode");
+
+    static int backMs = Config::instance()->getAndListen([](const json &config){
+        backMs = Config::instance()->get("Util", "fastStartBackMs");
+    }, "Util", "fastStartBackMs");
+
+    DataQueStartPolicy policy;
+    policy.mode = mode;
+    policy.backMs = backMs;
+    return policy;
+}
+
+size_t DataQueStartPolicy::getGopCacheCount()
+{
+    static int gopCacheCount = Config::instance()->getAndListen([](const json &config){
+        gopCacheCount = Config::instance()->get("Util", "gopCacheCount");
+    }, "Util", "gopCacheCount");
+
+    return gopCacheCount > 1 ? gopCacheCount : 1;
+}
+
+bool DataQueStartPolicy::parseParam(const unordered_map<string, string> &params, DataQueStartPolicy &policy)
+{
+    auto iter = params.find("startMode");
+    if (iter == params.end()) {
+        return false;
+    }
+
+    policy = getDefault();
+    if (iter->second == "cache") {
+        policy.mode = START_FROM_CACHE;
+    } else if (iter->second == "latest") {
+        policy.mode = START_FROM_LATEST_KEY;
+    } else if (iter->second == "back") {
+        policy.mode = START_FROM_BACK_MS;
+    } else {
+        policy.mode = atoi(iter->second.c_str());
+    }
+
+    iter = params.find("startBackMs");
+    if (iter != params.end()) {
+        policy.backMs = strtoull(iter->second.c_str(), nullptr, 10);
+    }
+
+    return true;
+}
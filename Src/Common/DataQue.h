@@ -16,10 +16,15 @@
 #include <memory>
 #include <mutex>
 #include <unordered_map>
+#include <deque>
+#include <vector>
+#include <algorithm>
+#include <climits>
 #include <condition_variable>
 #include <functional>
 #include "EventPoller/EventLoop.h"
 #include "Log/Logger.h"
+#include "Util/TimeClock.h"
 
 // using namespace std;
 
@@ -38,12 +43,100 @@ public:
     function<void()> close_;
 };
 
+// 新播放者加入时从哪里开始回放gop缓存
+enum DataQueStartMode {
+    // 回放缓存中所有gop
+    START_FROM_CACHE = 0,
+    // 低延迟模式，只从最新的关键帧开始
+    START_FROM_LATEST_KEY = 1,
+    // 从backMs之前最近的关键帧开始，缓冲更平滑
+    START_FROM_BACK_MS = 2,
+};
+
+class DataQueStartPolicy
+{
+public:
+    int mode = START_FROM_CACHE;
+    uint64_t backMs = 0;
+
+public:
+    // 读取配置Util.fastStartMode和Util.fastStartBackMs
+    static DataQueStartPolicy getDefault();
+    // 读取配置Util.gopCacheCount，快速启动索引保留的关键帧个数
+    static size_t getGopCacheCount();
+    // 播放地址参数startMode(cache/latest/back)和startBackMs，没有startMode返回false
+    static bool parseParam(const unordered_map<string, string> &params, DataQueStartPolicy &policy);
+};
+
+class DataQueKeyframeInfo
+{
+public:
+    uint64_t seq = 0;
+    // 关键帧写入时间，单位ms
+    uint64_t time = 0;
+};
+
 template <typename T>
 class DataQueStorage;
 
 template <typename T>
 class DataQueReaderDispatcher;
 
+// GOP缓存分块的元素个数
+#define DATAQUE_CHUNK_SIZE 64
+
+/**
+ * GOP缓存的存储块，只追加不修改
+ * 写入线程写满一块后挂上下一块，已发布的元素和next不再改变，
+ * 所以快照可以在其他线程无锁遍历
+ */
+template <typename T>
+class DataQueChunk {
+public:
+    using Ptr = std::shared_ptr<DataQueChunk>;
+
+    class Item {
+    public:
+        bool key = false;
+        uint64_t seq = 0;
+        T data;
+    };
+
+    size_t count = 0;
+    Ptr next;
+    Item items[DATAQUE_CHUNK_SIZE];
+};
+
+/**
+ * GOP缓存的不可变快照，创建只需拷贝两个游标
+ * 持有头部块即可保证到尾部的所有块不被释放
+ */
+template <typename T>
+class DataQueSnapshot {
+public:
+    using ChunkT = DataQueChunk<T>;
+
+    bool empty() const { return _head_seq == _end_seq; }
+    // 快照中第一个元素的序号
+    uint64_t beginSeq() const { return _head_seq; }
+    uint64_t endSeq() const { return _end_seq; }
+
+    // 遍历序号小于end_seq的元素，func(seq, is_key, data)
+    template <typename FUNC>
+    void forEach(FUNC &&func, uint64_t end_seq = UINT64_MAX) const;
+
+private:
+    template <typename U>
+    friend class DataQueStorage;
+
+    typename ChunkT::Ptr _head;
+    size_t _head_index = 0;
+    ChunkT *_tail = nullptr;
+    size_t _tail_count = 0;
+    uint64_t _head_seq = 0;
+    uint64_t _end_seq = 0;
+};
+
 /**
  * 环形缓存读取器
  * 该对象的事件触发都会在绑定的poller线程中执行
@@ -56,7 +149,8 @@ public:
     using Ptr = std::shared_ptr<DataQueReader>;
     friend class DataQueReaderDispatcher<T>;
 
-    DataQueReader(std::shared_ptr<DataQueStorage<T>> storage);
+    DataQueReader(std::shared_ptr<DataQueStorage<T>> storage, 
+                  const std::shared_ptr<DataQueReaderDispatcher<T>> &dispatcher);
 
     ~DataQueReader();
 
@@ -68,6 +162,9 @@ public:
 
     void setMessageCB(std::function<void(const ClientInfo &data)> cb);
 
+    // 需要在setReadCB之前调用
+    void setStartPolicy(const DataQueStartPolicy &policy);
+
 private:
     void onRead(const T &data, bool /*is_key*/);
     void onMessage(const ClientInfo &data);
@@ -77,18 +174,27 @@ private:
     void flushGop();
 
 private:
+    // 序号小于该值的数据已由gop缓存回放或在关键帧之前，不再下发
+    uint64_t _skip_seq = 0;
+    DataQueStartPolicy _policy;
     std::shared_ptr<DataQueStorage<T>> _storage;
+    std::weak_ptr<DataQueReaderDispatcher<T>> _dispatcher;
     std::function<void(void)> _detach_cb;
     std::function<void(const T &)> _read_cb;
     std::function<ClientInfo()> _info_cb;
     std::function<void(const ClientInfo &data)> _msg_cb;
 };
 
+/**
+ * 所有loop共享的GOP缓存
+ * 只有一个写入线程，其他线程通过snapshot()获取不可变快照
+ */
 template <typename T>
 class DataQueStorage {
 public:
     using Ptr = std::shared_ptr<DataQueStorage>;
-    using GopType = list<list<std::pair<bool, T>>>;
+    using ChunkT = DataQueChunk<T>;
+    using SnapshotT = DataQueSnapshot<T>;
     
     DataQueStorage(size_t max_size, size_t max_gop_size);
 
@@ -98,28 +204,47 @@ public:
      * 写入环形缓存数据
      * @param in 数据
      * @param is_key 是否为关键帧
-     * @return 是否触发重置环形缓存大小
+     * @return 该数据的序号
      */
-    void write(T in, bool is_key = true);
+    uint64_t write(T in, bool is_key = true);
+
+    // O(1)获取当前缓存的快照，policy决定从哪个关键帧开始
+    SnapshotT snapshot(const DataQueStartPolicy &policy = DataQueStartPolicy()) const;
 
-    Ptr clone() const;
+    // 缓存中各gop起始关键帧的索引，从旧到新
+    std::vector<DataQueKeyframeInfo> getKeyframeIndex() const;
 
-    const GopType &getCache() const;
+    // 下一个写入数据的序号
+    uint64_t getWriteSeq() const;
 
     void clearCache();
 
 private:
-    DataQueStorage() = default;
+    class Cursor {
+    public:
+        typename ChunkT::Ptr chunk;
+        size_t index = 0;
+        uint64_t seq = 0;
+        uint64_t time = 0;
+    };
 
+    Cursor endCursor(uint64_t seq) const;
     void popFrontGop();
+    void resetCache();
 
 private:
     bool _started = false;
     bool _have_idr;
-    size_t _size;
     size_t _max_size;
     size_t _max_gop_size;
-    GopType _data_cache;
+    // 下一个写入数据的序号，包括未缓存的数据
+    uint64_t _seq = 0;
+    // 已缓存数据的结束序号
+    uint64_t _end_seq = 0;
+    mutable std::mutex _mtx;
+    typename ChunkT::Ptr _tail;
+    // 每个gop的起始位置，即关键帧索引
+    std::deque<Cursor> _gop_starts;
 };
 
 template <typename T>
@@ -145,7 +270,7 @@ private:
     DataQueReaderDispatcher(
         const typename DataQueStorageT::Ptr &storage, std::function<void(int, bool)> onSizeChanged);
 
-    void write(T in, bool is_key = true);
+    void write(T in, bool is_key, uint64_t seq);
 
     void sendMessage(const ClientInfo &data);
 
@@ -153,11 +278,13 @@ private:
 
     void onSizeChanged(bool add_flag);
 
-    void clearCache();
-
     std::list<ClientInfo> getInfoList(const onChangeInfoCB &on_change);
 
 private:
+    friend class DataQueReader<T>;
+
+    // 本loop已派发数据的结束序号，新reader只回放序号小于它的缓存
+    uint64_t _end_seq = 0;
     std::atomic_int _reader_size;
     std::function<void(int, bool)> _on_size_changed;
     typename DataQueStorageT::Ptr _storage;
@@ -201,6 +328,11 @@ public:
 
     void getInfoList(const onGetInfoCB &cb, const typename DataQueReaderDispatcherT::onChangeInfoCB &on_change = nullptr);
 
+    // 之后attach的reader默认使用该策略
+    void setStartPolicy(const DataQueStartPolicy &policy);
+
+    std::vector<DataQueKeyframeInfo> getKeyframeIndex();
+
 private:
     void onSizeChanged(const EventLoop::Ptr &loop, int size, bool add_flag);
 
@@ -213,6 +345,7 @@ private:
     std::mutex _mtx_map;
     std::atomic_int _total_count { 0 };
     std::atomic_int _total_bytes { 0 };
+    DataQueStartPolicy _start_policy;
     typename DataQueStorageT::Ptr _storage;
     std::unordered_map<void*, onWriteFunc> _on_write_map;
     onReaderChanged _on_reader_changed;
@@ -225,9 +358,11 @@ private:
 using namespace std;
 
 template <typename T>
-DataQueReader<T>::DataQueReader(std::shared_ptr<DataQueStorage<T>> storage)
+DataQueReader<T>::DataQueReader(std::shared_ptr<DataQueStorage<T>> storage, 
+                                const std::shared_ptr<DataQueReaderDispatcher<T>> &dispatcher)
 {
     _storage = std::move(storage);
+    _dispatcher = dispatcher;
     setReadCB(nullptr);
     setDetachCB(nullptr);
     setGetInfoCB(nullptr);
@@ -270,6 +405,12 @@ void DataQueReader<T>::setMessageCB(std::function<void(const ClientInfo &data)>
     _msg_cb = cb ? std::move(cb) : [](const ClientInfo &data) {};
 }
 
+template <typename T>
+void DataQueReader<T>::setStartPolicy(const DataQueStartPolicy &policy)
+{
+    _policy = policy;
+}
+
 template <typename T>
 void DataQueReader<T>::onRead(const T &data, bool /*is_key*/) 
 { 
@@ -305,14 +446,48 @@ void DataQueReader<T>::flushGop()
     if (!_storage) {
         return;
     }
-    // _storage->getCache().for_each([this](const list<std::pair<bool, T>> &lst) {
-    //     lst.for_each([this](const std::pair<bool, T> &pr) { onRead(pr.second, pr.first); });
-    // });
-    auto cache = _storage->getCache();
-    for (auto& list : cache) {
-        for (auto& pr : list) {
-            onRead(pr.second, pr.first);
+    auto dispatcher = _dispatcher.lock();
+    if (!dispatcher) {
+        return;
+    }
+
+    // 快照可能比本loop已派发的数据新，只回放本loop已派发过的部分，剩余的由dispatcher继续下发
+    auto end_seq = dispatcher->_end_seq;
+    auto snapshot = _storage->snapshot(_policy);
+    if (!snapshot.empty() && snapshot.beginSeq() >= end_seq) {
+        // 旧gop已被淘汰，丢弃新gop之前的数据
+        _skip_seq = snapshot.beginSeq();
+        return;
+    }
+    _skip_seq = end_seq;
+    snapshot.forEach([this](uint64_t seq, bool is_key, const T &data) {
+        onRead(data, is_key);
+    }, end_seq);
+}
+
+///////////////////////////////////////////////////////////////////////
+
+template <typename T>
+template <typename FUNC>
+void DataQueSnapshot<T>::forEach(FUNC &&func, uint64_t end_seq) const
+{
+    auto chunk = _head.get();
+    auto index = _head_index;
+    while (chunk) {
+        auto count = chunk == _tail ? _tail_count : DATAQUE_CHUNK_SIZE;
+        for (; index < count; ++index) {
+            auto &item = chunk->items[index];
+            if (item.seq >= end_seq) {
+                return;
+            }
+            func(item.seq, item.key, item.data);
+        }
+        // 尾部块的next可能正在被写入线程修改，不能访问
+        if (chunk == _tail) {
+            break;
         }
+        chunk = chunk->next.get();
+        index = 0;
     }
 }
 
@@ -334,19 +509,24 @@ DataQueStorage<T>::DataQueStorage(size_t max_size, size_t max_gop_size)
  * 写入环形缓存数据
  * @param in 数据
  * @param is_key 是否为关键帧
- * @return 是否触发重置环形缓存大小
+ * @return 该数据的序号
  */
 template <typename T>
-void DataQueStorage<T>::write(T in, bool is_key) 
+uint64_t DataQueStorage<T>::write(T in, bool is_key) 
 {
+    LOCK_GUARD(_mtx);
+    auto seq = _seq++;
     if (is_key) {
         _have_idr = true;
         _started = true;
-        if (!_data_cache.back().empty()) {
-            //当前gop列队还没收到任意缓存
-            _data_cache.emplace_back();
+        if (_end_seq > _gop_starts.back().seq) {
+            //当前gop列队已有缓存，新建gop
+            _gop_starts.emplace_back(endCursor(seq));
+        } else {
+            //当前gop列队还没收到任意缓存，直接复用
+            _gop_starts.back() = endCursor(seq);
         }
-        if (_data_cache.size() > _max_gop_size) {
+        if (_gop_starts.size() > _max_gop_size) {
             // GOP个数超过限制，那么移除最早的GOP
             popFrontGop();
         }
@@ -354,59 +534,124 @@ void DataQueStorage<T>::write(T in, bool is_key)
 
     if (!_have_idr && _started) {
         //缓存中没有关键帧，那么gop缓存无效
-        return;
+        return seq;
     }
-    _data_cache.back().emplace_back(std::make_pair(is_key, std::move(in)));
-    if (++_size > _max_size) {
+
+    auto &item = _tail->items[_tail->count];
+    item.key = is_key;
+    item.seq = seq;
+    item.data = std::move(in);
+    _end_seq = seq + 1;
+    if (++_tail->count == DATAQUE_CHUNK_SIZE) {
+        // 提前挂上下一块，保证结束位置总是在尾部块内
+        _tail->next = std::make_shared<ChunkT>();
+        _tail = _tail->next;
+    }
+
+    if (_end_seq - _gop_starts.front().seq > _max_size) {
         // GOP缓存溢出
-        while (_data_cache.size() > 1) {
+        while (_gop_starts.size() > 1) {
             //先尝试清除老的GOP缓存
             popFrontGop();
         }
-        if (_size > _max_size) {
+        if (_end_seq - _gop_starts.front().seq > _max_size) {
             //还是大于最大缓冲限制，那么清空所有GOP
-            clearCache();
+            resetCache();
         }
     }
+    return seq;
 }
 
 template <typename T>
-std::shared_ptr<DataQueStorage<T>> DataQueStorage<T>::clone() const
+DataQueSnapshot<T> DataQueStorage<T>::snapshot(const DataQueStartPolicy &policy) const
 {
-    Ptr ret(new DataQueStorage<T>());
-    ret->_size = _size;
-    ret->_have_idr = _have_idr;
-    ret->_started = _started;
-    ret->_max_size = _max_size;
-    ret->_max_gop_size = _max_gop_size;
-    ret->_data_cache = _data_cache;
+    SnapshotT ret;
+    LOCK_GUARD(_mtx);
+    auto it = _gop_starts.begin();
+    if (policy.mode == START_FROM_LATEST_KEY) {
+        it = _gop_starts.end() - 1;
+    } else if (policy.mode == START_FROM_BACK_MS) {
+        // 找到不晚于backMs之前的最新关键帧，都不满足则从最旧的开始
+        auto now = TimeClock::now();
+        for (auto iter = _gop_starts.begin(); iter != _gop_starts.end(); ++iter) {
+            if (iter->time + policy.backMs > now) {
+                break;
+            }
+            it = iter;
+        }
+    }
+    auto &head = *it;
+    ret._head = head.chunk;
+    ret._head_index = head.index;
+    ret._head_seq = head.seq;
+    ret._tail = _tail.get();
+    ret._tail_count = _tail->count;
+    ret._end_seq = _end_seq;
     return ret;
 }
 
 template <typename T>
-const list<list<std::pair<bool, T>>> &DataQueStorage<T>::getCache() const 
-{ 
-    return _data_cache; 
+std::vector<DataQueKeyframeInfo> DataQueStorage<T>::getKeyframeIndex() const
+{
+    std::vector<DataQueKeyframeInfo> ret;
+    LOCK_GUARD(_mtx);
+    for (auto &cursor : _gop_starts) {
+        if (cursor.seq >= _end_seq) {
+            // 空的gop
+            continue;
+        }
+        DataQueKeyframeInfo info;
+        info.seq = cursor.seq;
+        info.time = cursor.time;
+        ret.emplace_back(info);
+    }
+    return ret;
+}
+
+template <typename T>
+uint64_t DataQueStorage<T>::getWriteSeq() const
+{
+    LOCK_GUARD(_mtx);
+    return _seq;
 }
 
 template <typename T>
 void DataQueStorage<T>::clearCache()
 {
-    _size = 0;
-    _have_idr = false;
-    _data_cache.clear();
-    _data_cache.emplace_back();
+    LOCK_GUARD(_mtx);
+    resetCache();
 }
 
+// seq为该位置上第一个数据序号的下限
+template <typename T>
+typename DataQueStorage<T>::Cursor DataQueStorage<T>::endCursor(uint64_t seq) const
+{
+    Cursor cursor;
+    cursor.chunk = _tail;
+    cursor.index = _tail->count;
+    cursor.seq = seq;
+    cursor.time = TimeClock::now();
+    return cursor;
+}
+
+template <typename T>
+void DataQueStorage<T>::resetCache()
+{
+    _have_idr = false;
+    // 换新的块，旧块由仍持有快照的reader释放
+    _tail = std::make_shared<ChunkT>();
+    _end_seq = _seq;
+    _gop_starts.clear();
+    _gop_starts.emplace_back(endCursor(_seq));
+}
 
 template <typename T>
 void DataQueStorage<T>::popFrontGop()
 {
-    if (!_data_cache.empty()) {
-        _size -= _data_cache.front().size();
-        _data_cache.pop_front();
-        if (_data_cache.empty()) {
-            _data_cache.emplace_back();
+    if (!_gop_starts.empty()) {
+        _gop_starts.pop_front();
+        if (_gop_starts.empty()) {
+            _gop_starts.emplace_back(endCursor(_seq));
         }
     }
 }
@@ -433,12 +678,14 @@ DataQueReaderDispatcher<T>::DataQueReaderDispatcher(
 {
     _reader_size = 0;
     _storage = storage;
+    // 创建前写入的数据视为已派发，新reader可从共享缓存回放
+    _end_seq = _storage->getWriteSeq();
     _on_size_changed = std::move(onSizeChanged);
     assert(_on_size_changed);
 }
 
 template <typename T>
-void DataQueReaderDispatcher<T>::write(T in, bool is_key) 
+void DataQueReaderDispatcher<T>::write(T in, bool is_key, uint64_t seq) 
 {
     // logInfo << "write: " << _reader_map.size();
     for (auto it = _reader_map.begin(); it != _reader_map.end();) {
@@ -450,10 +697,12 @@ void DataQueReaderDispatcher<T>::write(T in, bool is_key)
             onSizeChanged(false);
             continue;
         }
-        reader->onRead(in, is_key);
+        if (seq >= reader->_skip_seq) {
+            reader->onRead(in, is_key);
+        }
         ++it;
     }
-    _storage->write(std::move(in), is_key);
+    _end_seq = seq + 1;
 }
 
 template <typename T>
@@ -491,7 +740,7 @@ std::shared_ptr<DataQueReader<T>> DataQueReaderDispatcher<T>::attach(const Event
         }, true, true);
     };
 
-    std::shared_ptr<DataQueReaderT> reader(new DataQueReader<T>(use_cache ? _storage : nullptr), on_dealloc);
+    std::shared_ptr<DataQueReaderT> reader(new DataQueReader<T>(use_cache ? _storage : nullptr, this->shared_from_this()), on_dealloc);
     _reader_map[reader.get()] = reader;
     ++_reader_size;
     onSizeChanged(true);
@@ -504,14 +753,6 @@ void DataQueReaderDispatcher<T>::onSizeChanged(bool add_flag)
     _on_size_changed(_reader_size, add_flag); 
 }
 
-template <typename T>
-void DataQueReaderDispatcher<T>::clearCache() 
-{
-    if (_reader_size == 0) {
-        _storage->clearCache();
-    }
-}
-
 template <typename T>
 std::list<ClientInfo> DataQueReaderDispatcher<T>::getInfoList(const onChangeInfoCB &on_change) 
 {
@@ -535,7 +776,8 @@ std::list<ClientInfo> DataQueReaderDispatcher<T>::getInfoList(const onChangeInfo
 template <typename T>
 DataQue<T>::DataQue(size_t max_size, onReaderChanged cb, size_t max_gop_size) 
 {
-    _storage = std::make_shared<DataQueStorage<T>>(max_size, max_gop_size);
+    _start_policy = DataQueStartPolicy::getDefault();
+    _storage = std::make_shared<DataQueStorage<T>>(max_size, std::max(max_gop_size, DataQueStartPolicy::getGopCacheCount()));
     _on_reader_changed = cb ? std::move(cb) : [](int size) {};
     //先触发无人观看
     _on_reader_changed(0);
@@ -557,16 +799,17 @@ void DataQue<T>::write(T in, bool is_key)
     }
 
     LOCK_GUARD(_mtx_map);
+    // 在锁内分配序号，保证与dispatcher创建的先后顺序一致
+    auto seq = _storage->write(in, is_key);
         // logInfo << "_dispatcher_map =================: " << _dispatcher_map.size();
     for (auto &pr : _dispatcher_map) {
         // logInfo << "_dispatcher_map =================: " << pr.second;
         auto &second = pr.second;
         //切换线程后触发onRead事件
-        pr.first->async([second, in, is_key]() { 
-            second->write(const_cast<T &>(in), is_key); 
+        pr.first->async([second, in, is_key, seq]() { 
+            second->write(const_cast<T &>(in), is_key, seq); 
         }, true, false);
     }
-    _storage->write(std::move(in), is_key);
 }
 
 template <typename T>
@@ -596,15 +839,9 @@ void DataQue<T>::addOnWrite(void* key, onWriteFunc onWrite)
     if (!_storage || !onWrite) {
         return;
     }
-    // _storage->getCache().for_each([this](const list<std::pair<bool, T>> &lst) {
-    //     lst.for_each([this](const std::pair<bool, T> &pr) { _on_write(pr.second, pr.first); });
-    // });
-    auto cache = _storage->getCache();
-    for (auto& list : cache) {
-        for (auto& pr : list) {
-            onWrite(pr.second, pr.first);
-        }
-    }
+    _storage->snapshot().forEach([&onWrite](uint64_t seq, bool is_key, const T &data) {
+        onWrite(data, is_key);
+    });
 }
 
 template <typename T>
@@ -636,6 +873,7 @@ template <typename T>
 std::shared_ptr<DataQueReader<T>> DataQue<T>::attach(const EventLoop::Ptr &loop, bool use_cache) 
 {
     typename DataQueReaderDispatcher<T>::Ptr dispatcher;
+    DataQueStartPolicy policy;
     {
         LOCK_GUARD(_mtx_map);
         auto &ref = _dispatcher_map[loop];
@@ -647,12 +885,15 @@ std::shared_ptr<DataQueReader<T>> DataQue<T>::attach(const EventLoop::Ptr &loop,
                 }
             };
             auto onDealloc = [loop](DataQueReaderDispatcher<T> *ptr) { loop->async([ptr]() { delete ptr; }, true, true); };
-            ref.reset(new DataQueReaderDispatcher<T>(_storage->clone(), std::move(onSizeChanged)), std::move(onDealloc));
+            ref.reset(new DataQueReaderDispatcher<T>(_storage, std::move(onSizeChanged)), std::move(onDealloc));
         }
         dispatcher = ref;
+        policy = _start_policy;
     }
 
-    return dispatcher->attach(loop, use_cache);
+    auto reader = dispatcher->attach(loop, use_cache);
+    reader->setStartPolicy(policy);
+    return reader;
 }
 
 template <typename T>
@@ -664,13 +905,8 @@ int DataQue<T>::readerCount()
 template <typename T>
 void DataQue<T>::clearCache() 
 {
-    LOCK_GUARD(_mtx_map);
+    // 缓存由所有loop共享，已回放给reader的快照不受影响
     _storage->clearCache();
-    for (auto &pr : _dispatcher_map) {
-        auto &second = pr.second;
-        //切换线程后清空缓存
-        pr.first->async([second]() { second->clearCache(); }, false);
-    }
 }
 
 template <typename T>
@@ -710,6 +946,19 @@ void DataQue<T>::getInfoList(const onGetInfoCB &cb, const typename DataQueReader
     }
 }
 
+template <typename T>
+void DataQue<T>::setStartPolicy(const DataQueStartPolicy &policy)
+{
+    LOCK_GUARD(_mtx_map);
+    _start_policy = policy;
+}
+
+template <typename T>
+std::vector<DataQueKeyframeInfo> DataQue<T>::getKeyframeIndex()
+{
+    return _storage->getKeyframeIndex();
+}
+
 template <typename T>
 void DataQue<T>::onSizeChanged(const EventLoop::Ptr &loop, int size, bool add_flag) 
 {
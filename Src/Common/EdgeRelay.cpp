@@ -0,0 +1,616 @@
+#include "EdgeRelay.h"
+#include "MediaSource.h"
+#include "UrlParser.h"
+#include "Config.h"
+#include "Logger.h"
+#include "Util/String.h"
+#include "Util/TimeClock.h"
+#include "Net/TcpClient.h"
+#include "EventPoller/EventLoopPool.h"
+
+#include <algorithm>
+
+using namespace std;
+
+// 只检查端口能否连通
+class EdgeOriginProbe : public TcpClient
+{
+public:
+    EdgeOriginProbe(const EventLoop::Ptr& loop, const function<void(bool alive)>& cb)
+        :TcpClient(loop)
+        ,_cb(cb)
+    {}
+
+    void onConnect() override
+    {
+        onResult(true);
+    }
+
+    void onError(const string& err) override
+    {
+        logDebug << "probe origin failed: " << err;
+        onResult(false);
+    }
+
+    void onResult(bool alive)
+    {
+        if (!_cb) {
+            return ;
+        }
+        auto cb = _cb;
+        _cb = nullptr;
+        close();
+        cb(alive);
+    }
+
+private:
+    function<void(bool alive)> _cb;
+};
+
+static string getEndpoint(const string& url)
+{
+    static unordered_map<string, int> defaultPort = {{"rtmp", 1935}, {"rtsp", 554}, {"http", 80}};
+
+    UrlParser parser;
+    parser.parse(url);
+    int port = parser.port_;
+    if (port == 0) {
+        auto iter = defaultPort.find(parser.protocol_);
+        if (iter == defaultPort.end()) {
+            return "";
+        }
+        port = iter->second;
+    }
+
+    return parser.host_ + ":" + to_string(port);
+}
+
+EdgeRelay::Ptr EdgeRelay::instance()
+{
+    static EdgeRelay::Ptr relay(new EdgeRelay());
+    return relay;
+}
+
+EdgeRelay::EdgeRelay()
+{
+    // 单例不会析构，可以直接捕获this
+    for (auto key : {"protocol", "endpoint", "origins", "params", "idleLingerMs", "originCheckMs", "keyframeWaitMs"}) {
+        Config::instance()->addUpdateFunc(string("Cdn.") + key, [this](const json&){
+            loadConfig();
+        });
+    }
+    loadConfig();
+}
+
+void EdgeRelay::loadConfig()
+{
+    auto config = Config::instance();
+    string protocol = config->get("Cdn", "protocol", "", "", "rtmp");
+    string params = config->get("Cdn", "params");
+    string endpoint = config->get("Cdn", "endpoint");
+    string origins = config->get("Cdn", "origins");
+    int idleLingerMs = config->get("Cdn", "idleLingerMs", "", "", "30000");
+    int originCheckMs = config->get("Cdn", "originCheckMs", "", "", "5000");
+    int keyframeWaitMs = config->get("Cdn", "keyframeWaitMs", "", "", "2000");
+
+    // origins为空时只用endpoint
+    vector<string> vecOrigin;
+    for (auto& origin : split(origins.empty() ? endpoint : origins, ",")) {
+        auto item = trim(origin, " ");
+        if (!item.empty()) {
+            vecOrigin.push_back(item);
+        }
+    }
+
+    lock_guard<mutex> lck(_mtx);
+    _protocol = protocol;
+    _params = params;
+    _origins = vecOrigin;
+    _idleLingerMs = max(idleLingerMs, 0);
+    _originCheckMs = max(originCheckMs, 100);
+    _keyframeWaitMs = max(keyframeWaitMs, 0);
+}
+
+int EdgeRelay::getIdleLingerMs()
+{
+    lock_guard<mutex> lck(_mtx);
+    return _idleLingerMs;
+}
+
+int EdgeRelay::getKeyframeWaitMs()
+{
+    lock_guard<mutex> lck(_mtx);
+    return _keyframeWaitMs;
+}
+
+void EdgeRelay::pullFromOrigin(const string& uri, const string& vhost, void* connKey,
+                        const function<void()>& onReady, const function<void()>& onFail)
+{
+    string protocol;
+    vector<EdgeRelayCandidate> candidates;
+    {
+        lock_guard<mutex> lck(_mtx);
+        protocol = _protocol;
+        // 可用的源站在前，不可用的放到最后兜底，都按配置顺序
+        vector<EdgeRelayCandidate> down;
+        for (auto& origin : _origins) {
+            EdgeRelayCandidate candidate;
+            candidate.endpoint = origin;
+            candidate.url = _protocol + "://" + origin + uri;
+            if (!_params.empty()) {
+                candidate.url += "?" + _params;
+            }
+
+            auto iter = _mapOrigin.find(origin);
+            if (iter != _mapOrigin.end() && !iter->second.healthy) {
+                down.push_back(candidate);
+            } else {
+                candidates.push_back(candidate);
+            }
+        }
+        candidates.insert(candidates.end(), down.begin(), down.end());
+    }
+
+    if (candidates.empty()) {
+        logWarn << "no origin configured, uri: " << uri;
+        onFail();
+        return ;
+    }
+
+    pull(uri, vhost, protocol, candidates, connKey, onReady, onFail);
+}
+
+void EdgeRelay::pullFromUrl(const string& uri, const string& vhost, const string& url, void* connKey,
+                        const function<void()>& onReady, const function<void()>& onFail)
+{
+    UrlParser parser;
+    parser.parse(url);
+
+    EdgeRelayCandidate candidate;
+    candidate.url = url;
+    candidate.endpoint = getEndpoint(url);
+
+    pull(uri, vhost, parser.protocol_, {candidate}, connKey, onReady, onFail);
+}
+
+void EdgeRelay::pull(const string& uri, const string& vhost, const string& protocol, const vector<EdgeRelayCandidate>& candidates,
+                void* connKey, const function<void()>& onReady, const function<void()>& onFail)
+{
+    EdgeRelayWaiter waiter;
+    waiter.connKey = connKey;
+    waiter.loop = EventLoop::getCurrentLoop();
+    if (!waiter.loop) {
+        waiter.loop = EventLoopPool::instance()->getLoopByCircle();
+    }
+    waiter.onReady = onReady;
+    waiter.onFail = onFail;
+
+    string key = uri + "_" + vhost;
+    bool isNew = false;
+    EdgeRelaySession::Ptr session;
+    {
+        lock_guard<mutex> lck(_mtx);
+        auto& item = _mapSession[key];
+        if (!item) {
+            item = make_shared<EdgeRelaySession>(uri, vhost, protocol, candidates, waiter.loop);
+            isNew = true;
+        }
+        session = item;
+    }
+
+    logInfo << "edge relay add waiter, key: " << key << ", new session: " << isNew;
+    session->addWaiter(waiter);
+    if (isNew) {
+        session->start();
+    }
+}
+
+void EdgeRelay::delSession(const string& key, EdgeRelaySession* session)
+{
+    lock_guard<mutex> lck(_mtx);
+    auto iter = _mapSession.find(key);
+    if (iter != _mapSession.end() && iter->second.get() == session) {
+        _mapSession.erase(iter);
+    }
+}
+
+void EdgeRelay::onOriginFailed(const string& endpoint)
+{
+    if (endpoint.empty()) {
+        return ;
+    }
+
+    bool probe = false;
+    {
+        lock_guard<mutex> lck(_mtx);
+        auto& info = _mapOrigin[endpoint];
+        info.endpoint = endpoint;
+        info.healthy = false;
+        ++info.failCount;
+        info.downTime = TimeClock::now();
+        if (!info.probing) {
+            info.probing = true;
+            probe = true;
+        }
+        logWarn << "origin is down: " << endpoint << ", fail count: " << info.failCount;
+    }
+
+    if (probe) {
+        scheduleProbe(endpoint);
+    }
+}
+
+void EdgeRelay::onOriginAlive(const string& endpoint)
+{
+    if (endpoint.empty()) {
+        return ;
+    }
+
+    lock_guard<mutex> lck(_mtx);
+    auto& info = _mapOrigin[endpoint];
+    if (!info.healthy) {
+        logInfo << "origin is alive: " << endpoint;
+    }
+    info.endpoint = endpoint;
+    info.healthy = true;
+    info.failCount = 0;
+}
+
+void EdgeRelay::scheduleProbe(const string& endpoint)
+{
+    int interval;
+    {
+        lock_guard<mutex> lck(_mtx);
+        interval = _originCheckMs;
+    }
+
+    auto loop = EventLoopPool::instance()->getLoopByCircle();
+    weak_ptr<EdgeRelay> wSelf = shared_from_this();
+    loop->addTimerTask(interval, [wSelf, endpoint](){
+        auto self = wSelf.lock();
+        if (self) {
+            self->probeOrigin(endpoint);
+        }
+        return 0;
+    }, nullptr);
+}
+
+void EdgeRelay::probeOrigin(const string& endpoint)
+{
+    {
+        lock_guard<mutex> lck(_mtx);
+        auto& info = _mapOrigin[endpoint];
+        // 期间回源成功过
+        if (info.healthy) {
+            info.probing = false;
+            return ;
+        }
+    }
+
+    auto pos = endpoint.rfind(":");
+    string host = endpoint.substr(0, pos);
+    int port = pos == string::npos ? 0 : atoi(endpoint.substr(pos + 1).data());
+
+    weak_ptr<EdgeRelay> wSelf = shared_from_this();
+    auto probe = make_shared<EdgeOriginProbe>(EventLoop::getCurrentLoop(), [wSelf, endpoint](bool alive){
+        auto self = wSelf.lock();
+        if (!self) {
+            return ;
+        }
+        {
+            lock_guard<mutex> lck(self->_mtx);
+            self->_mapProbe.erase(endpoint);
+            if (alive) {
+                self->_mapOrigin[endpoint].probing = false;
+            }
+        }
+        if (alive) {
+            self->onOriginAlive(endpoint);
+        } else {
+            self->scheduleProbe(endpoint);
+        }
+    });
+
+    {
+        lock_guard<mutex> lck(_mtx);
+        _mapProbe[endpoint] = probe;
+    }
+    if (port <= 0 || probe->create("0.0.0.0") < 0 || probe->connect(host, port, 3) < 0) {
+        probe->onResult(false);
+    }
+}
+
+vector<EdgeOriginInfo> EdgeRelay::getOriginInfo()
+{
+    lock_guard<mutex> lck(_mtx);
+    vector<EdgeOriginInfo> infos;
+    for (auto& origin : _origins) {
+        auto iter = _mapOrigin.find(origin);
+        if (iter == _mapOrigin.end()) {
+            EdgeOriginInfo info;
+            info.endpoint = origin;
+            infos.push_back(info);
+        } else {
+            infos.push_back(iter->second);
+        }
+    }
+    // onStreamNotFound返回的地址
+    for (auto& iter : _mapOrigin) {
+        if (find(_origins.begin(), _origins.end(), iter.first) == _origins.end()) {
+            infos.push_back(iter.second);
+        }
+    }
+
+    return infos;
+}
+
+int EdgeRelay::getSessionCount()
+{
+    lock_guard<mutex> lck(_mtx);
+    return _mapSession.size();
+}
+
+EdgeRelaySession::EdgeRelaySession(const string& uri, const string& vhost, const string& protocol,
+                    const vector<EdgeRelayCandidate>& candidates, const EventLoop::Ptr& loop)
+    :_uri(uri)
+    ,_vhost(vhost)
+    ,_protocol(protocol)
+    ,_candidates(candidates)
+    ,_loop(loop)
+{}
+
+EdgeRelaySession::~EdgeRelaySession()
+{
+    logTrace << "~EdgeRelaySession: " << _uri;
+}
+
+void EdgeRelaySession::start()
+{
+    weak_ptr<EdgeRelaySession> wSelf = shared_from_this();
+    _loop->async([wSelf](){
+        auto self = wSelf.lock();
+        if (self) {
+            self->tryNext();
+        }
+    }, true);
+}
+
+void EdgeRelaySession::addWaiter(const EdgeRelayWaiter& waiter)
+{
+    auto self = shared_from_this();
+    _loop->async([self, waiter](){
+        // 已经就绪或者回源成功后结束的，让播放者重新走一遍查找流程
+        if (self->_ready) {
+            waiter.loop->async(waiter.onReady, false);
+            return ;
+        } else if (self->_finish) {
+            waiter.loop->async(waiter.onFail, false);
+            return ;
+        }
+        self->_waiters.push_back(waiter);
+    }, true);
+}
+
+void EdgeRelaySession::tryNext()
+{
+    while (!_finish && ++_index < (int)_candidates.size()) {
+        // 上一个源站拉流失败时可能留下了没有就绪的流
+        auto src = MediaSource::get(_uri, _vhost);
+        if (src && !src->isReady()) {
+            src->release();
+        }
+
+        auto& candidate = _candidates[_index];
+        auto client = MediaClient::createClient(_protocol, _uri, MediaClientType_Pull);
+        if (!client) {
+            logWarn << "unsupported edge protocol: " << _protocol;
+            break;
+        }
+        logInfo << "edge relay pull from origin: " << candidate.url;
+        _client = client;
+
+        weak_ptr<EdgeRelaySession> wSelf = shared_from_this();
+        weak_ptr<MediaClient> wClient = client;
+        // close可能在start里同步调用，统一放到下一轮处理
+        client->setOnClose([wSelf, wClient](){
+            auto self = wSelf.lock();
+            if (!self) {
+                return ;
+            }
+            self->_loop->async([wSelf, wClient](){
+                auto self = wSelf.lock();
+                auto client = wClient.lock();
+                if (self && client) {
+                    self->onClientClose(client);
+                }
+            }, false);
+        });
+        // 流被销毁时也会回调，在onSourceReady里区分
+        client->addOnReady(this, [wSelf, wClient](){
+            auto self = wSelf.lock();
+            if (!self) {
+                return ;
+            }
+            self->_loop->async([wSelf, wClient](){
+                auto self = wSelf.lock();
+                auto client = wClient.lock();
+                if (self && client) {
+                    self->onSourceReady(client);
+                }
+            }, false);
+        });
+
+        MediaClient::addMediaClient(_uri, client);
+        client->start("0.0.0.0", 0, candidate.url, 5);
+        return ;
+    }
+
+    logWarn << "all origins failed, uri: " << _uri;
+    finish();
+    notifyWaiters(false);
+}
+
+void EdgeRelaySession::onClientClose(const MediaClient::Ptr& client)
+{
+    if (_finish || client != _client) {
+        return ;
+    }
+
+    if (MediaClient::getMediaClient(_uri) == client) {
+        MediaClient::delMediaClient(_uri);
+    }
+    _client = nullptr;
+    EdgeRelay::instance()->onOriginFailed(_candidates[_index].endpoint);
+
+    if (!_ready) {
+        tryNext();
+        return ;
+    }
+
+    // 播放中源站断开，释放流，播放者重连时重新回源
+    logWarn << "origin closed while playing, uri: " << _uri;
+    finish();
+    auto src = MediaSource::get(_uri, _vhost);
+    if (src) {
+        src->release();
+    }
+}
+
+void EdgeRelaySession::failCurrent()
+{
+    auto client = _client;
+    if (!client) {
+        return ;
+    }
+    client->setOnClose(nullptr);
+    client->stop();
+    _readyTime = 0;
+    onClientClose(client);
+}
+
+void EdgeRelaySession::onSourceReady(const MediaClient::Ptr& client)
+{
+    if (_finish || _ready || client != _client || _readyTime) {
+        return ;
+    }
+
+    auto src = MediaSource::get(_uri, _vhost);
+    if (!src || src->getStatus() != SourceStatus::AVAILABLE) {
+        // 流没有就绪就被销毁了，按拉流失败处理
+        failCurrent();
+        return ;
+    }
+
+    bool hasVideo = false;
+    for (auto& track : src->getTrackInfo()) {
+        if (track.second->trackType_ == "video") {
+            hasVideo = true;
+        }
+    }
+    _readyTime = TimeClock::now();
+    if (!hasVideo) {
+        onKeyframeReady();
+        return ;
+    }
+
+    // 等到源站的gop缓存到达，第一个播放者就能从关键帧开始
+    int keyframeWaitMs = EdgeRelay::instance()->getKeyframeWaitMs();
+    weak_ptr<EdgeRelaySession> wSelf = shared_from_this();
+    weak_ptr<MediaSource> wSrc = src;
+    _loop->addTimerTask(20, [wSelf, wSrc, keyframeWaitMs](){
+        auto self = wSelf.lock();
+        if (!self || self->_finish || self->_ready) {
+            return 0;
+        }
+        auto src = wSrc.lock();
+        if (!src) {
+            self->failCurrent();
+            return 0;
+        }
+        if (src->getKeyframeIndex().empty() && TimeClock::now() - self->_readyTime < (uint64_t)keyframeWaitMs) {
+            return 20;
+        }
+        self->onKeyframeReady();
+        return 0;
+    }, nullptr);
+}
+
+void EdgeRelaySession::onKeyframeReady()
+{
+    logInfo << "edge relay ready, uri: " << _uri << ", waiters: " << _waiters.size()
+            << ", wait keyframe: " << TimeClock::now() - _readyTime << "ms";
+    _ready = true;
+    EdgeRelay::instance()->onOriginAlive(_candidates[_index].endpoint);
+    notifyWaiters(true);
+
+    int idleLingerMs = EdgeRelay::instance()->getIdleLingerMs();
+    int interval = min(1000, max(idleLingerMs, 100));
+    weak_ptr<EdgeRelaySession> wSelf = shared_from_this();
+    _loop->addTimerTask(interval, [wSelf, interval](){
+        auto self = wSelf.lock();
+        if (!self || self->_finish) {
+            return 0;
+        }
+        return self->checkIdle() ? interval : 0;
+    }, nullptr);
+}
+
+int EdgeRelaySession::checkIdle()
+{
+    auto src = MediaSource::get(_uri, _vhost);
+    if (!src) {
+        // 流被别处释放了，比如stopNonePlayerStream
+        finish();
+        if (_client) {
+            _client->setOnClose(nullptr);
+            _client->stop();
+        }
+        return 0;
+    }
+
+    if (src->totalPlayerCount() > 0) {
+        _idleTime = 0;
+        return 1;
+    }
+
+    auto now = TimeClock::now();
+    if (_idleTime == 0) {
+        _idleTime = now;
+        return 1;
+    }
+
+    if (now - _idleTime < (uint64_t)EdgeRelay::instance()->getIdleLingerMs()) {
+        return 1;
+    }
+
+    logInfo << "edge relay idle, stop pulling, uri: " << _uri;
+    finish();
+    if (_client) {
+        _client->setOnClose(nullptr);
+        _client->stop();
+    }
+    src->release();
+
+    return 0;
+}
+
+void EdgeRelaySession::notifyWaiters(bool success)
+{
+    auto waiters = std::move(_waiters);
+    _waiters.clear();
+    for (auto& waiter : waiters) {
+        waiter.loop->async(success ? waiter.onReady : waiter.onFail, false);
+    }
+}
+
+void EdgeRelaySession::finish()
+{
+    if (_finish) {
+        return ;
+    }
+    _finish = true;
+    if (_client && MediaClient::getMediaClient(_uri) == _client) {
+        MediaClient::delMediaClient(_uri);
+    }
+    EdgeRelay::instance()->delSession(_uri + "_" + _vhost, this);
+}
@@ -0,0 +1,136 @@
+#ifndef EdgeRelay_H
+#define EdgeRelay_H
+
+#include <string>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <functional>
+#include <unordered_map>
+
+#include "EventPoller/EventLoop.h"
+#include "MediaClient.h"
+
+using namespace std;
+
+struct EdgeOriginInfo
+{
+    // ip:port
+    string endpoint;
+    bool healthy = true;
+    // 连续失败次数，恢复后清零
+    int failCount = 0;
+    uint64_t downTime = 0;
+    // 正在定时探测
+    bool probing = false;
+};
+
+struct EdgeRelayWaiter
+{
+    void* connKey = nullptr;
+    EventLoop::Ptr loop;
+    function<void()> onReady;
+    function<void()> onFail;
+};
+
+struct EdgeRelayCandidate
+{
+    string url;
+    // 为空时不做健康检查
+    string endpoint;
+};
+
+class TcpClient;
+class EdgeRelaySession;
+
+// 边缘回源，同一个流的所有首播请求合并成一路回源
+// 源站按配置顺序优先，失败的源站标记为不可用，定时探测恢复后重新启用
+// 回源的流收到关键帧后才通知播放者，保证从gop开始播放
+// 没有播放者超过idleLingerMs后停止回源
+class EdgeRelay : public enable_shared_from_this<EdgeRelay>
+{
+public:
+    using Ptr = shared_ptr<EdgeRelay>;
+
+    static EdgeRelay::Ptr instance();
+
+public:
+    // 按Cdn配置的源站回源
+    void pullFromOrigin(const string& uri, const string& vhost, void* connKey,
+                        const function<void()>& onReady, const function<void()>& onFail);
+    // 按指定的地址回源，比如onStreamNotFound返回的地址
+    void pullFromUrl(const string& uri, const string& vhost, const string& url, void* connKey,
+                        const function<void()>& onReady, const function<void()>& onFail);
+
+    void onOriginFailed(const string& endpoint);
+    void onOriginAlive(const string& endpoint);
+    void delSession(const string& key, EdgeRelaySession* session);
+
+    vector<EdgeOriginInfo> getOriginInfo();
+    int getSessionCount();
+
+    int getIdleLingerMs();
+    int getKeyframeWaitMs();
+
+private:
+    EdgeRelay();
+    void loadConfig();
+    void pull(const string& uri, const string& vhost, const string& protocol, const vector<EdgeRelayCandidate>& candidates,
+                void* connKey, const function<void()>& onReady, const function<void()>& onFail);
+    void scheduleProbe(const string& endpoint);
+    void probeOrigin(const string& endpoint);
+
+private:
+    int _idleLingerMs = 30000;
+    int _originCheckMs = 5000;
+    int _keyframeWaitMs = 2000;
+    string _protocol;
+    string _params;
+    vector<string> _origins;
+
+    mutex _mtx;
+    unordered_map<string/*uri_vhost*/, shared_ptr<EdgeRelaySession>> _mapSession;
+    unordered_map<string/*endpoint*/, EdgeOriginInfo> _mapOrigin;
+    unordered_map<string/*endpoint*/, shared_ptr<TcpClient>> _mapProbe;
+};
+
+// 一个流的回源会话，除了添加等待者，其他操作都在会话所在的loop里执行
+class EdgeRelaySession : public enable_shared_from_this<EdgeRelaySession>
+{
+public:
+    using Ptr = shared_ptr<EdgeRelaySession>;
+
+    EdgeRelaySession(const string& uri, const string& vhost, const string& protocol,
+                    const vector<EdgeRelayCandidate>& candidates, const EventLoop::Ptr& loop);
+    ~EdgeRelaySession();
+
+public:
+    void start();
+    void addWaiter(const EdgeRelayWaiter& waiter);
+
+private:
+    void tryNext();
+    void onClientClose(const MediaClient::Ptr& client);
+    void failCurrent();
+    void onSourceReady(const MediaClient::Ptr& client);
+    void onKeyframeReady();
+    int checkIdle();
+    void notifyWaiters(bool success);
+    void finish();
+
+private:
+    bool _ready = false;
+    bool _finish = false;
+    int _index = -1;
+    uint64_t _readyTime = 0;
+    uint64_t _idleTime = 0;
+    string _uri;
+    string _vhost;
+    string _protocol;
+    vector<EdgeRelayCandidate> _candidates;
+    EventLoop::Ptr _loop;
+    MediaClient::Ptr _client;
+    vector<EdgeRelayWaiter> _waiters;
+};
+
+#endif //EdgeRelay_H
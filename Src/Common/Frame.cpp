@@ -9,7 +9,7 @@
 
 using namespace std;
 
-unordered_map<string, FrameBuffer::funcCreateFrame> FrameBuffer::_mapCreateFrame;
+unordered_map<CodecId, FrameBuffer::funcCreateFrame> FrameBuffer::_mapCreateFrame;
 
 FrameBuffer::FrameBuffer()
 {
@@ -55,16 +55,16 @@ int FrameBuffer::startSize(const char* data, int len)
     return 0;
 }
 
-FrameBuffer::Ptr FrameBuffer::createFrame(const string& codecName, int startSize, int index, bool addStart)
+FrameBuffer::Ptr FrameBuffer::createFrame(const CodecId& codec, int startSize, int index, bool addStart)
 {
-    auto iter = _mapCreateFrame.find(codecName);
+    auto iter = _mapCreateFrame.find(codec);
     if (iter != _mapCreateFrame.end()) {
         return iter->second(startSize, index, addStart);
     } else {
         auto frame = make_shared<FrameBuffer>();
         
         frame->_startSize = startSize;
-        frame->_codec = codecName;
+        frame->_codec = codec;
         frame->_index = index;
         frame->_trackType = 1;//AudioTrackType;
 
@@ -72,7 +72,7 @@ FrameBuffer::Ptr FrameBuffer::createFrame(const string& codecName, int startSize
     }
 }
 
-void FrameBuffer::registerFrame(const string& codecName, const funcCreateFrame& func)
+void FrameBuffer::registerFrame(const CodecId& codec, const funcCreateFrame& func)
 {
-    _mapCreateFrame[codecName] = func;
+    _mapCreateFrame[codec] = func;
 }
\ No newline at end of file
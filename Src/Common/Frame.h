@@ -7,6 +7,7 @@
 #include <vector>
 
 #include "Net/Buffer.h"
+#include "CodecId.h"
 
 using namespace std;
 
@@ -26,7 +27,7 @@ public:
     uint64_t dts() const { return _dts; }
     uint64_t pts() const { return _pts; }
     size_t startSize() const { return _startSize; }
-    string codec() const { return _codec; }
+    CodecId codec() const { return _codec; }
     int getTrackType() {return _trackType;}
     int getTrackIndex() {return _index;}
 
@@ -41,9 +42,9 @@ public:
     virtual bool isNonPicNalu() {return false;}
 
     
-    static FrameBuffer::Ptr createFrame(const string& codecName, int startSize, int index, bool addStart);
+    static FrameBuffer::Ptr createFrame(const CodecId& codec, int startSize, int index, bool addStart);
     
-    static void registerFrame(const string& codecName, const funcCreateFrame& func);
+    static void registerFrame(const CodecId& codec, const funcCreateFrame& func);
 
 public:
     bool _isKeyframe = false;
@@ -53,10 +54,10 @@ public:
     uint64_t _dts = 0;
     uint64_t _pts = 0;
     size_t _startSize = 0;
-    string _codec;
+    CodecId _codec;
     StringBuffer _buffer;
 
-    static unordered_map<string, funcCreateFrame> _mapCreateFrame;
+    static unordered_map<CodecId, funcCreateFrame> _mapCreateFrame;
 };
 
 
@@ -1,5 +1,6 @@
 ﻿#include "FrameMediaSource.h"
 #include "Log/Logger.h"
+#include "PcmTranscode/AudioNormalizer.h"
 
 using namespace std;
 
@@ -112,16 +113,16 @@ void FrameMediaSource::onFrame(const FrameBuffer::Ptr& frame)
                     _keyframe = _frame;
                     _gopTime = now - _lastKeyframeTime;
                     _lastKeyframeTime = now;
-                    if (_frame->codec() == "h264" || _frame->codec() == "h265") {
+                    if (_frame->codec() == CodecH264 || _frame->codec() == CodecH265) {
                         if (!_sendConfig) {
                             FrameBuffer::Ptr vps;
                             FrameBuffer::Ptr sps;
                             FrameBuffer::Ptr pps;
                             _mapTrackInfo[_frame->_index]->getVpsSpsPps(vps, sps, pps);
 
-                            if (_mapTrackInfo[_frame->_index]->codec_ == "h264") {
+                            if (_mapTrackInfo[_frame->_index]->codec_ == CodecH264) {
                                 keyframe = true;
-                            } else if (_mapTrackInfo[_frame->_index]->codec_ == "h265") {
+                            } else if (_mapTrackInfo[_frame->_index]->codec_ == CodecH265) {
                                 keyframe = false;
                                 vps->_dts = _frame->_dts;
                                 vps->_pts = _frame->_pts;
@@ -160,9 +161,9 @@ void FrameMediaSource::onFrame(const FrameBuffer::Ptr& frame)
             }
         } else {
             int samples = 0;
-            if (frame->_codec == "aac") {
+            if (frame->_codec == CodecAAC) {
                 samples = 1024;
-            } else if (frame->_codec == "g711a" || frame->_codec == "g711u") {
+            } else if (frame->_codec == CodecG711A || frame->_codec == CodecG711U) {
                 samples = frame->size() - frame->startSize();
             }
             if (_audioStampAdjust)
@@ -178,6 +179,61 @@ void FrameMediaSource::onFrame(const FrameBuffer::Ptr& frame)
     // }
 }
 
+shared_ptr<TrackInfo> FrameMediaSource::getSinkTrack(const shared_ptr<TrackInfo>& track)
+{
+    if (!track || track->trackType_ != "audio" || !AudioNormalizer::isSupported(track->codec_)) {
+        return track;
+    }
+
+    auto dstCodec = AudioNormalizer::getTargetCodec();
+    if (dstCodec.empty()) {
+        return track;
+    }
+
+    auto& normalizer = _mapAudioNormalizer[track->index_];
+    if (!normalizer) {
+        logInfo << "normalize audio from " << track->codec_ << " to " << dstCodec << ", path: " << _urlParser.path_;
+        normalizer = make_shared<AudioNormalizer>(track->codec_, dstCodec);
+    }
+    auto normalizedTrack = normalizer->createTrackInfo(track->index_);
+    normalizedTrack->_hasReady = track->isReady();
+
+    return normalizedTrack;
+}
+
+FrameBuffer::Ptr FrameMediaSource::getSinkFrame(const FrameBuffer::Ptr& frame)
+{
+    if (!frame || _mapAudioNormalizer.empty() || frame->getTrackType() != AudioTrackType) {
+        return frame;
+    }
+
+    auto iter = _mapAudioNormalizer.find(frame->getTrackIndex());
+    if (iter == _mapAudioNormalizer.end()) {
+        return frame;
+    }
+
+    // 转换器有跨帧状态，缓存也不加锁，只能在源的loop里使用
+    if (!_loop->isCurrent()) {
+        logWarn << "normalize audio out of the source loop, drop frame, path: " << _urlParser.path_;
+        return nullptr;
+    }
+
+    auto it = _normalizedFrames.find(frame);
+    if (it != _normalizedFrames.end()) {
+        return it->second;
+    }
+
+    auto newFrame = iter->second->normalize(frame);
+    _normalizedFrames.emplace(frame, newFrame);
+    _normalizedOrder.push_back(frame);
+    if (_normalizedOrder.size() > (size_t)_ring_size) {
+        _normalizedFrames.erase(_normalizedOrder.front());
+        _normalizedOrder.pop_front();
+    }
+
+    return newFrame;
+}
+
 void FrameMediaSource::addTrack(const shared_ptr<TrackInfo>& track)
 {
     logTrace << "on add track to sink, uri: " << _urlParser.path_;
@@ -215,7 +271,8 @@ void FrameMediaSource::addTrack(const shared_ptr<TrackInfo>& track)
         //     if (sink.second.lock()) {
         //         sink.second.lock()->addTrack(track);
         //     }
-            sink.second->addTrack(track);
+            // adpcma/g726等播放端普遍不支持的音频，给协议源的是转换后的track
+            sink.second->addTrack(getSinkTrack(track));
         }
     }
 }
@@ -229,7 +286,7 @@ void FrameMediaSource::addSink(const MediaSource::Ptr &sink)
             continue;
         }
         logTrace << "on add track to sink, uri: " << _urlParser.path_;
-        sink->addTrack(track.second);
+        sink->addTrack(getSinkTrack(track.second));
     }
     sink->onReady();
     weak_ptr<FrameMediaSource> weak_self = static_pointer_cast<FrameMediaSource>(shared_from_this());
@@ -251,7 +308,10 @@ void FrameMediaSource::addSink(const MediaSource::Ptr &sink)
         // logInfo << "frame pts: " << in->_pts << ", frame dts: " << in->_dts << ", type: " << in->_trackType;
         // logInfo << "keyframe: " << is_key << ", size: " << in->size() << ", type: " << (int)in->getNalType();
         // logInfo << "frame source type: " << strong_self->_urlParser.type_;
-        sink->onFrame(in);
+        auto frame = strong_self->getSinkFrame(in);
+        if (frame) {
+            sink->onFrame(frame);
+        }
         // for (auto& sinkW: strong_self->_mapSink) {
         //     // auto sink = sinkW.second.lock();
         //     auto sink = sinkW.second;
@@ -263,12 +323,31 @@ void FrameMediaSource::addSink(const MediaSource::Ptr &sink)
     });
 }
 
+bool FrameMediaSource::isIdle()
+{
+    if (_ring && _ring->readerCount() > 0) {
+        return false;
+    }
+
+    return MediaSource::isIdle();
+}
+
 void FrameMediaSource::delSink(const MediaSource::Ptr& sink)
 {
     logTrace << "FrameMediaSource::delSink, uri: " << _urlParser.path_;
     MediaSource::delSink(sink);
     _ring->delOnWrite(sink.get());
     if (_mapSink.size() == 0) {
+        // 没有协议源了，不再转换音频
+        _mapAudioNormalizer.clear();
+        _normalizedFrames.clear();
+        _normalizedOrder.clear();
+
+        // 最后一个协议源走了先不摘，空闲计时内来的新协议源直接从缓存的gop开始，不用等关键帧
+        if (!_origin && _urlParser.type_ != "transcode" && getMuxerIdleTime() > 0) {
+            startIdleTimer();
+            return ;
+        }
         for (auto& source : _mapSource) {
             source.second->delSink(static_pointer_cast<FrameMediaSource>(shared_from_this()));
         }
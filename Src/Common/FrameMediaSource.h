@@ -12,6 +12,7 @@
 #define SRC_FRAME_FRAMEMEDIASOURCE_H_
 
 #include <vector>
+#include <deque>
 #include <string>
 #include <memory>
 #include <functional>
@@ -20,6 +21,8 @@
 #include "StampAdjust.h"
 #include "Util/TimeClock.h"
 
+class AudioNormalizer;
+
 #define RTP_GOP_SIZE 512
 
 
@@ -40,12 +43,23 @@ public:
 
     void inputFrame(const FrameBuffer::Ptr& frame);
     FrameRingType::Ptr getRing() {return _ring;}
+    vector<DataQueKeyframeInfo> getKeyframeIndex() override { return _ring ? _ring->getKeyframeIndex() : vector<DataQueKeyframeInfo>();}
     float getFps() {return _fps;}
     uint64_t getLastFrameTime() {return TimeClock::now() - _lastFrameTime;}
     int getLastGopTime() {return _gopTime;}
     uint64_t getLastKeyframeTime() {return TimeClock::now() - _lastKeyframeTime;}
     FrameBuffer::Ptr getKeyframe() {return _keyframe;}
 
+protected:
+    // 录像、转码等直接挂在帧源上的reader不是sink，有reader时也不能回收
+    bool isIdle() override;
+
+private:
+    // 给协议源的track，需要转换的音轨在第一个协议源要这个track时才创建转换器
+    shared_ptr<TrackInfo> getSinkTrack(const shared_ptr<TrackInfo>& track);
+    // 给协议源的帧，同一帧只转换一次，所有协议源共享
+    FrameBuffer::Ptr getSinkFrame(const FrameBuffer::Ptr& frame);
+
 private:
     bool _sendConfig = false;
     int _ring_size = 256;
@@ -60,6 +74,13 @@ private:
     FrameRingType::Ptr _ring;
     FrameBuffer::Ptr _frame;
     FrameBuffer::Ptr _keyframe;
+    // 音轨index -> 音频转换器，没有协议源时不存在
+    unordered_map<int, shared_ptr<AudioNormalizer>> _mapAudioNormalizer;
+    // 原始帧 -> 转换后的帧，同一帧的其他协议源和gop缓存回放给后加入的协议源时复用，
+    // g726有跨帧状态不能重复解码；key持有原始帧，地址不会被复用
+    unordered_map<FrameBuffer::Ptr, FrameBuffer::Ptr> _normalizedFrames;
+    // 转换的先后顺序，超过gop缓存大小时淘汰最旧的
+    deque<FrameBuffer::Ptr> _normalizedOrder;
 };
 
 
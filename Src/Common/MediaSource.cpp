@@ -13,6 +13,7 @@
 #include "HookManager.h"
 #include "Util/TimeClock.h"
 #include "Config.h"
+#include "EdgeRelay.h"
 
 using namespace std;
 
@@ -227,14 +228,6 @@ void MediaSource::getOrCreateAsync(const string& uri, const string& vhost, const
                         OnStreamNotFoundInfo info;
                         info.uri = uri;
                         hook->onStreamNotFound(info, [uri, vhost, protocol, type, cb, create, connKey](const OnStreamNotFoundResponse &rsp){
-                            auto tmpPlayer = MediaClient::getMediaClient(uri);
-                            if (tmpPlayer) {
-                                tmpPlayer->addOnReady(connKey, [uri, vhost, protocol, type, cb, create, connKey](){
-                                    MediaSource::getOrCreateAsync(uri, vhost, protocol, type, cb, create, connKey);
-                                });
-                                return ;
-                            }
-
                             if (rsp.pullUrl.empty()) {
                                 return ;
                             }
@@ -246,22 +239,11 @@ void MediaSource::getOrCreateAsync(const string& uri, const string& vhost, const
                                 return;
                             }
 
-                            // For non-file URIs, use MediaClient to pull the stream
-                            UrlParser up;
-                            up.parse(rsp.pullUrl);
-                            auto player = MediaClient::createClient(up.protocol_, uri, MediaClientType_Pull);
-                            player->start("0.0.0.0", 0, rsp.pullUrl, 5);
-
-                            MediaClient::addMediaClient(uri, player);
-
-                            player->setOnClose([uri, player](){
-                                MediaClient::delMediaClient(uri);
-                                const_pointer_cast<MediaClient>(player) = nullptr;
-                            });
-
-                            player->addOnReady(connKey, [uri, vhost, protocol, type, cb, create, connKey](){
+                            // 其他地址走边缘回源，并发的请求共用一路拉流
+                            // 失败时由下面注册的等待超时回调cb
+                            EdgeRelay::instance()->pullFromUrl(uri, vhost, rsp.pullUrl, connKey, [uri, vhost, protocol, type, cb, create, connKey](){
                                 MediaSource::getOrCreateAsync(uri, vhost, protocol, type, cb, create, connKey);
-                            });
+                            }, [](){});
                         });
 
                         // return ;
@@ -396,12 +378,16 @@ bool MediaSource::getOrCreateAsync(const string &protocol, const string& type,
     auto frameSource = wframeSource.lock();
     
     if (frameSource) {
+        // 帧源可能正在空闲计时，addSink之前不能被回收
+        frameSource->keepAlive();
         frameSource->getLoop()->async([frameSource, src, cb](){
             // src->setLoop(frameSource->getLoop());
             src->addSource(frameSource);
             src->setStatus(SourceStatus::INIT);
             src->setOrigin(frameSource->getOrigin());
             frameSource->addSink(src);
+            // 播放者可能还没attach就走了，没有读者变化的通知，这里先开始计时
+            src->startIdleTimer();
             cb(src);
         }, true, true);
         return true;
@@ -432,6 +418,7 @@ bool MediaSource::getOrCreateAsync(const string &protocol, const string& type,
         
         frameSource->addSource(srcStream);
         src->addSource(frameSource);
+        src->startIdleTimer();
 
         logTrace << "getOrCreateAsync find other src end： " << src;
         cb(src);
@@ -557,43 +544,11 @@ void MediaSource::pullStreamFromOrigin(const string& uri, const string& vhost, c
             const string& type, const function<void(const MediaSource::Ptr &src)> &cb, 
             const std::function<MediaSource::Ptr()> &create, void* connKey)
 {
-    auto tmpPlayer = MediaClient::getMediaClient(uri);
-    if (tmpPlayer) {
-        tmpPlayer->addOnReady(connKey, [uri, vhost, protocol, type, cb, create, connKey](){
-            MediaSource::getOrCreateAsync(uri, vhost, protocol, type, cb, create, connKey);
-        });
-        return ;
-    }
-    static string pullProtocol = Config::instance()->getAndListen([](const json &config){
-        pullProtocol = Config::instance()->get("Cdn", "protocol");
-    }, "Cdn", "protocol");
-    
-    static string endpoint = Config::instance()->getAndListen([](const json &config){
-        endpoint = Config::instance()->get("Cdn", "endpoint");
-    }, "Cdn", "endpoint");
-    
-    static string params = Config::instance()->getAndListen([](const json &config){
-        params = Config::instance()->get("Cdn", "params");
-    }, "Cdn", "params");
-
-    string url = pullProtocol + "://" + endpoint + uri;
-    if (!params.empty()) {
-        url += "?" + params;
-    }
-
-    auto player = MediaClient::createClient(pullProtocol, uri, MediaClientType_Pull);
-    player->start("0.0.0.0", 0, url, 5);
-
-    MediaClient::addMediaClient(uri, player);
-
-    player->setOnClose([uri, player](){
-        MediaClient::delMediaClient(uri);
-        const_pointer_cast<MediaClient>(player) = nullptr;
-    });
-
-    // TODO 
-    player->addOnReady(connKey, [uri, vhost, protocol, type, cb, create, connKey](){
+    // 同一个流的并发请求合并成一路回源，就绪后重新查找流
+    EdgeRelay::instance()->pullFromOrigin(uri, vhost, connKey, [uri, vhost, protocol, type, cb, create, connKey](){
         MediaSource::getOrCreateAsync(uri, vhost, protocol, type, cb, create, connKey);
+    }, [cb](){
+        cb(nullptr);
     });
 }
 
@@ -913,6 +868,11 @@ void MediaSource::onReaderChanged(int size)
     if (size != 0) {
         return ;
     }
+
+    if (!_origin && getMuxerIdleTime() > 0) {
+        startIdleTimer();
+        return ;
+    }
     
     if (_origin) {
         auto hook = HookManager::instance()->getHook(MEDIA_HOOK);
@@ -935,22 +895,22 @@ void MediaSource::onReaderChanged(int size)
         logTrace << "nonePlayerWaitTime: " << nonePlayerWaitTime << ", path: " << _urlParser.path_;
 
         weak_ptr<MediaSource> wSelf = shared_from_this();
-        _loop->addTimerTask(nonePlayerWaitTime, [wSelf, size](){
+        _loop->addTimerTask(nonePlayerWaitTime, [wSelf](){
             auto self = wSelf.lock();
             if (!self) {
                 return 0;
             }
             logTrace << "onReaderChanged task" << ", path: " << self->_urlParser.path_;
-            if (size == 0 && self->_origin) {
+            if (self->_origin) {
                 lock_guard<recursive_mutex> lock(MediaSource::_mtxTotalSource);
                 logTrace << "onReaderChanged _mtxStreamSource";
-                if (self->_mapConnection.size() > 0 || self->_mapSink.size() > 0) {
+                if (!self->isIdle()) {
                     return 0;
                 }
                 logTrace << "onReaderChanged relese" << ", path: " << self->_urlParser.path_;
                 self->release();
-
-            } else if (size == 0 && !self->_origin) {
+            } else {
+                // 没开空闲回收时，转协议源没人看就从上游摘下
                 auto src = MediaSource::get(self->_urlParser.path_, self->_urlParser.vhost_);
                 logTrace << "onReaderChanged get src" << ", path: " << self->_urlParser.path_;
                 if (src) {
@@ -966,6 +926,7 @@ void MediaSource::onReaderChanged(int size)
                     self->_mapSource.clear();
                 }
             }
+
             return 0;
         }, [wSelf](bool flag, const shared_ptr<TimerTask>& task){
             auto self = wSelf.lock();
@@ -981,6 +942,83 @@ void MediaSource::onReaderChanged(int size)
     
 }
 
+int MediaSource::getMuxerIdleTime()
+{
+    static int muxerIdleTime = Config::instance()->getAndListen([](const json&){
+        muxerIdleTime = Config::instance()->get("Util", "muxerIdleTime", "", "", "0");
+    }, "Util", "muxerIdleTime", "", "", "0");
+
+    return muxerIdleTime;
+}
+
+void MediaSource::startIdleTimer()
+{
+    keepAlive();
+    if (_origin || !_loop || getMuxerIdleTime() <= 0 || _idleTimerStarted.exchange(true)) {
+        return ;
+    }
+
+    weak_ptr<MediaSource> wSelf = shared_from_this();
+    _loop->addTimerTask(getMuxerIdleTime(), [wSelf]() -> uint64_t {
+        auto self = wSelf.lock();
+        if (!self) {
+            return 0;
+        }
+
+        // 计时期间被用过，从最后一次使用开始重新算；中途关掉回收时不再释放
+        int64_t idleTime = getMuxerIdleTime();
+        int64_t elapse = TimeClock::now() - self->_lastActiveTime;
+        if (idleTime > 0 && elapse < idleTime) {
+            return idleTime - elapse;
+        }
+
+        self->_idleTimerStarted = false;
+        if (idleTime <= 0) {
+            return 0;
+        }
+
+        self->releaseIfIdle();
+
+        return 0;
+    }, nullptr);
+}
+
+bool MediaSource::isIdle()
+{
+    {
+        lock_guard<mutex> lck(_mtxConnection);
+        if (!_mapConnection.empty()) {
+            return false;
+        }
+    }
+
+    return _mapSink.empty() && playerCount() <= 0;
+}
+
+void MediaSource::releaseIfIdle()
+{
+    auto origin = _originSrc.lock();
+    if (!origin) {
+        return ;
+    }
+
+    // 和getOrCreateAsync用同一把锁，检查和摘除之间不会有新的播放者拿到这个源
+    lock_guard<recursive_mutex> lck(origin->_mtxStreamSource);
+    if (!isIdle()) {
+        return ;
+    }
+
+    logInfo << "release idle source, path: " << _urlParser.path_ << ", protocol: " << _urlParser.protocol_
+            << ", type: " << _urlParser.type_;
+    // 上游是帧源的话，最后一个sink摘掉后帧源自己开始空闲计时
+    auto self = shared_from_this();
+    auto mapSource = _mapSource;
+    for (auto& source : mapSource) {
+        source.second->delSink(self);
+    }
+    release();
+}
+
 void MediaSource::addOnReady(void* key, const onReadyFunc& func)
 {
     {
@@ -7,6 +7,7 @@
 #include <vector>
 #include <mutex>
 #include <list>
+#include <atomic>
 
 #include "UrlParser.h"
 #include "DataQue.h"
@@ -100,6 +101,7 @@ public:
     virtual int playerCount() {return 0;}
     virtual int totalPlayerCount();
     virtual uint64_t getBytes() {return 0;}
+    virtual vector<DataQueKeyframeInfo> getKeyframeIndex() {return {};}
     virtual float getBitrate() {return _bitrate;}
     virtual void getClientList(const function<void(const list<ClientInfo>& info)>& func) {}
     virtual void setOriginSocket(const Socket::Ptr& socket) {_originSocket = socket;}
@@ -128,6 +130,17 @@ public:
     bool isReady() {return _hasReady;}
     RecordReaderBase::Ptr getReader();
 
+protected:
+    // Util.muxerIdleTime，为0时不开启空闲回收
+    static int getMuxerIdleTime();
+    // 派生的协议源(包括帧源)没人用时启动空闲计时，Util.muxerIdleTime内一直没人用就从上游摘下并释放
+    // 期间有新的播放者或sink进来就继续使用，不用重新等关键帧
+    void startIdleTimer();
+    // 重新计算空闲时间，防止已经选中要复用的源被回收
+    void keepAlive() {_lastActiveTime = TimeClock::now();}
+    virtual bool isIdle();
+    void releaseIfIdle();
+
 protected:
     bool _origin = false;
     bool _isPush = true;
@@ -170,6 +183,8 @@ private:
     uint64_t _lastBytes_5s = 0;
     Socket::Wptr _originSocket;
     shared_ptr<TimerTask> _task;
+    atomic<bool> _idleTimerStarted{false};
+    atomic<uint64_t> _lastActiveTime{0};
     mutex _mtxConnection;
     unordered_map<void*, int> _mapConnection;
     unordered_map<MediaClient*, MediaClient::Ptr> _mapPusher;
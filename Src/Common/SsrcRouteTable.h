@@ -0,0 +1,193 @@
+#ifndef SsrcRouteTable_H
+#define SsrcRouteTable_H
+
+#include <atomic>
+#include <mutex>
+#include <memory>
+#include <thread>
+#include <functional>
+#include <unordered_map>
+
+using namespace std;
+
+// ssrc -> context 的路由表，读多写少
+// 按ssrc分片，每个分片是一份只读快照，查找不加锁
+// 增删时拷贝所在分片，修改后原子替换；旧快照按epoch回收:
+// 读者进出时在分片当前epoch的两个计数之一上加减，写者替换快照后两次切换epoch，
+// 每次等切换前那个计数归零，两个计数都清空过一次后释放旧快照
+// 切换后新来的读者计入另一个计数，写者不会被持续的读饿死
+template <typename T>
+class SsrcRouteTable
+{
+public:
+    using Table = unordered_map<uint32_t, shared_ptr<T>>;
+
+    SsrcRouteTable()
+    {
+        for (auto& shard : _shards) {
+            shard.table.store(new Table(), std::memory_order_relaxed);
+        }
+    }
+
+    ~SsrcRouteTable()
+    {
+        for (auto& shard : _shards) {
+            delete shard.table.load(std::memory_order_relaxed);
+        }
+    }
+
+    shared_ptr<T> find(uint32_t ssrc) const
+    {
+        auto& cur = shard(ssrc);
+        ReadGuard guard(cur);
+        auto table = cur.table.load();
+        auto iter = table->find(ssrc);
+        if (iter == table->end()) {
+            return nullptr;
+        }
+
+        return iter->second;
+    }
+
+    // 已存在时不覆盖，返回表里的那个
+    shared_ptr<T> emplace(uint32_t ssrc, const shared_ptr<T>& value)
+    {
+        lock_guard<mutex> lock(_mtx);
+        auto& cur = shard(ssrc);
+        auto table = cur.table.load(std::memory_order_relaxed);
+        auto iter = table->find(ssrc);
+        if (iter != table->end()) {
+            return iter->second;
+        }
+
+        auto newTable = new Table(*table);
+        newTable->emplace(ssrc, value);
+        publish(cur, newTable);
+
+        return value;
+    }
+
+    void set(uint32_t ssrc, const shared_ptr<T>& value)
+    {
+        lock_guard<mutex> lock(_mtx);
+        auto& cur = shard(ssrc);
+        auto newTable = new Table(*cur.table.load(std::memory_order_relaxed));
+        (*newTable)[ssrc] = value;
+        publish(cur, newTable);
+    }
+
+    void erase(uint32_t ssrc)
+    {
+        lock_guard<mutex> lock(_mtx);
+        auto& cur = shard(ssrc);
+        auto table = cur.table.load(std::memory_order_relaxed);
+        if (table->find(ssrc) == table->end()) {
+            return ;
+        }
+
+        auto newTable = new Table(*table);
+        newTable->erase(ssrc);
+        publish(cur, newTable);
+    }
+
+    // 删除pred返回true的项，一个分片最多替换一次
+    void eraseIf(const function<bool(uint32_t ssrc, const shared_ptr<T>& value)>& pred)
+    {
+        lock_guard<mutex> lock(_mtx);
+        for (auto& cur : _shards) {
+            auto table = cur.table.load(std::memory_order_relaxed);
+            Table* newTable = nullptr;
+            for (auto& iter : *table) {
+                if (!pred(iter.first, iter.second)) {
+                    continue;
+                }
+                if (!newTable) {
+                    newTable = new Table(*table);
+                }
+                newTable->erase(iter.first);
+            }
+            if (newTable) {
+                publish(cur, newTable);
+            }
+        }
+    }
+
+    size_t size() const
+    {
+        size_t count = 0;
+        for (auto& shard : _shards) {
+            ReadGuard guard(shard);
+            count += shard.table.load()->size();
+        }
+
+        return count;
+    }
+
+private:
+    // 每个分片独占缓存行，不同分片的读者计数互不干扰
+    struct alignas(64) Shard
+    {
+        atomic<Table*> table{nullptr};
+        atomic<uint32_t> epoch{0};
+        mutable atomic<int> readers[2];
+
+        Shard()
+        {
+            readers[0].store(0, std::memory_order_relaxed);
+            readers[1].store(0, std::memory_order_relaxed);
+        }
+    };
+
+    // 计数和快照的读写都是seq_cst:
+    // 写者检查计数时没看到的读者，它的load一定排在写者替换快照之后，拿不到旧快照
+    // 读者可能读到过期的epoch，计入哪个计数都不确定，所以写者两个计数都要等
+    class ReadGuard
+    {
+    public:
+        ReadGuard(const Shard& shard)
+            :_readers(shard.readers[shard.epoch.load() & 1])
+        {
+            _readers.fetch_add(1);
+        }
+
+        ~ReadGuard()
+        {
+            _readers.fetch_sub(1, std::memory_order_release);
+        }
+
+    private:
+        atomic<int>& _readers;
+    };
+
+    Shard& shard(uint32_t ssrc)
+    {
+        return _shards[(ssrc * 2654435761u) >> (32 - kShardBits)];
+    }
+
+    const Shard& shard(uint32_t ssrc) const
+    {
+        return _shards[(ssrc * 2654435761u) >> (32 - kShardBits)];
+    }
+
+    // 持有_mtx时调用，返回时旧快照已经没有读者，直接释放
+    void publish(Shard& cur, Table* table)
+    {
+        auto old = cur.table.exchange(table);
+        for (int i = 0; i < 2; ++i) {
+            auto epoch = cur.epoch.fetch_add(1) & 1;
+            // 读者只在一次查找期间持有计数，等待很短
+            while (cur.readers[epoch].load() != 0) {
+                std::this_thread::yield();
+            }
+        }
+        delete old;
+    }
+
+private:
+    static const int kShardBits = 6;
+
+    mutex _mtx;
+    Shard _shards[1 << kShardBits];
+};
+
+#endif //SsrcRouteTable_H
@@ -48,7 +48,7 @@ void AudioStampAdjust::inputStamp(uint64_t& pts, uint64_t& dts, int samples)
         step = 1;
     }
 
-    if (_stampMode == useSamplerate && (_codec == "g711a" || _codec == "g711u") && samples > 8) {
+    if (_stampMode == useSamplerate && (_codec == CodecG711A || _codec == CodecG711U) && samples > 8) {
         // 先写成8000 / 1000， 后续需要用真实的_samplerate / 1000
         // 不等于0，表明时间戳不是倍数（考虑丢包），时间戳异常，需要调整
         if (step % (samples / 8) != 0) {
@@ -7,6 +7,7 @@
 #include <vector>
 
 #include "Net/Buffer.h"
+#include "CodecId.h"
 
 using namespace std;
 
@@ -22,7 +23,7 @@ class StampAdjust
 public:
     using Ptr = shared_ptr<StampAdjust>;
     virtual void inputStamp(uint64_t& pts, uint64_t& dts, int samples) {}
-    virtual void setCodec(const string& codec) {}
+    virtual void setCodec(const CodecId& codec) {}
     virtual void setStampMode(StampMode mode) {}
 };
 
@@ -36,7 +37,7 @@ public:
 
 public:
     void inputStamp(uint64_t& pts, uint64_t& dts, int samples) override;
-    void setCodec(const string& codec) override {_codec = codec;}
+    void setCodec(const CodecId& codec) override {_codec = codec;}
     void setStampMode(StampMode mode) {_stampMode = mode;}
 
 private:
@@ -51,7 +52,7 @@ private:
 
     uint64_t _adjustPts;
 
-    string _codec;
+    CodecId _codec;
 };
 
 class VideoStampAdjust : public StampAdjust, public enable_shared_from_this<VideoStampAdjust>
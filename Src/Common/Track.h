@@ -94,7 +94,7 @@ public:
     uint32_t _PicSizeInCtbsY = 0;
     uint64_t duration_ = 0;
     string trackType_;
-    string codec_;
+    CodecId codec_;
     UrlParser _parser;
 
     static unordered_map<string, funcCreateTrackInfo> _mapCreateTrack;
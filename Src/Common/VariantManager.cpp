@@ -0,0 +1,39 @@
+#include "VariantManager.h"
+
+using namespace std;
+
+VariantManager::Ptr& VariantManager::instance()
+{
+    static VariantManager::Ptr instance = make_shared<VariantManager>();
+    return instance;
+}
+
+void VariantManager::addVariant(const string& path, const string& vhost, const VariantInfo& info)
+{
+    lock_guard<mutex> lck(_mtx);
+    auto& variants = _mapVariant[path + "_" + vhost];
+    for (auto& variant : variants) {
+        if (variant.path == info.path) {
+            variant = info;
+            return ;
+        }
+    }
+    variants.push_back(info);
+}
+
+void VariantManager::delVariants(const string& path, const string& vhost)
+{
+    lock_guard<mutex> lck(_mtx);
+    _mapVariant.erase(path + "_" + vhost);
+}
+
+vector<VariantInfo> VariantManager::getVariants(const string& path, const string& vhost)
+{
+    lock_guard<mutex> lck(_mtx);
+    auto it = _mapVariant.find(path + "_" + vhost);
+    if (it == _mapVariant.end()) {
+        return {};
+    }
+
+    return it->second;
+}
@@ -0,0 +1,39 @@
+#ifndef VariantManager_H
+#define VariantManager_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+
+// 同一个源转出来的一路码率，hls/llhls据此生成多码率的主m3u8
+class VariantInfo
+{
+public:
+    std::string name;
+    std::string path;
+    int width = 0;
+    int height = 0;
+    int bandwidth = 0;
+};
+
+class VariantManager : public std::enable_shared_from_this<VariantManager>
+{
+public:
+    using Ptr = std::shared_ptr<VariantManager>;
+
+    static VariantManager::Ptr& instance();
+
+public:
+    void addVariant(const std::string& path, const std::string& vhost, const VariantInfo& info);
+    void delVariants(const std::string& path, const std::string& vhost);
+    std::vector<VariantInfo> getVariants(const std::string& path, const std::string& vhost);
+
+private:
+    std::mutex _mtx;
+    // path_vhost -> 各路码率
+    std::unordered_map<std::string, std::vector<VariantInfo>> _mapVariant;
+};
+
+#endif //VariantManager_H
@@ -0,0 +1,385 @@
+#ifdef ENABLE_FFMPEG
+
+#include "Snapshot.h"
+#include "Log/Logger.h"
+#include "Common/Config.h"
+#include "Common/Define.h"
+#include "Util/TimeClock.h"
+
+extern "C" {
+#include <libswscale/swscale.h>
+}
+
+using namespace std;
+
+mutex Snapshot::_mtx;
+unordered_map<string, Snapshot::Ptr> Snapshot::_mapSnapshot;
+
+static string ffmpeg_err(int errnum) {
+    char errbuf[AV_ERROR_MAX_STRING_SIZE];
+    av_strerror(errnum, errbuf, AV_ERROR_MAX_STRING_SIZE);
+    return errbuf;
+}
+
+string SnapshotOption::key() const
+{
+    return format_ + "_" + to_string(width_) + "x" + to_string(height_) + "_" + to_string(quality_);
+}
+
+string SnapshotOption::contentType() const
+{
+    return format_ == "webp" ? "image/webp" : "image/jpeg";
+}
+
+Snapshot::Snapshot(const FrameMediaSource::Ptr& source)
+    :_source(source)
+{
+    _workLoop = WorkLoopPool::instance()->getLoopByCircle();
+    _lastAccess = TimeClock::now();
+}
+
+Snapshot::~Snapshot()
+{
+    av_frame_free(&_frame);
+}
+
+size_t Snapshot::getCount()
+{
+    lock_guard<mutex> lck(_mtx);
+    return _mapSnapshot.size();
+}
+
+Snapshot::Ptr Snapshot::get(const string& path, const string& vhost, const string& type)
+{
+    lock_guard<mutex> lck(_mtx);
+    auto it = _mapSnapshot.find(vhost + "/" + type + "/" + path);
+    if (it == _mapSnapshot.end()) {
+        return nullptr;
+    }
+    return it->second;
+}
+
+void Snapshot::clearExpired()
+{
+    static int expire = Config::instance()->getAndListen([](const json&){
+        expire = Config::instance()->get("Ffmpeg", "Snapshot", "expire", "", "60000");
+    }, "Ffmpeg", "Snapshot", "expire", "", "60000");
+
+    // 一段时间没有请求或者流已经没了，释放缓存的解码帧和图片
+    auto now = TimeClock::now();
+    lock_guard<mutex> lck(_mtx);
+    for (auto it = _mapSnapshot.begin(); it != _mapSnapshot.end();) {
+        auto& snapshot = it->second;
+        if (!snapshot->_source.lock() || now - snapshot->_lastAccess > (uint64_t)expire) {
+            it = _mapSnapshot.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void Snapshot::getSnapshot(const string& path, const string& vhost, const string& type,
+                           const SnapshotOption& option, const onSnapshot& cb)
+{
+    clearExpired();
+
+    auto source = MediaSource::get(path, vhost, PROTOCOL_FRAME, type);
+    auto frameSrc = dynamic_pointer_cast<FrameMediaSource>(source);
+    if (!frameSrc) {
+        throw runtime_error("frame source is not exists: " + path);
+    }
+
+    if (!frameSrc->getLoop()) {
+        throw runtime_error("loop is empty: " + path);
+    }
+
+    Snapshot::Ptr snapshot;
+    {
+        string key = vhost + "/" + type + "/" + path;
+        lock_guard<mutex> lck(_mtx);
+        auto& value = _mapSnapshot[key];
+        // 流重建过，旧的缓存作废
+        if (!value || value->_source.lock() != frameSrc) {
+            value = make_shared<Snapshot>(frameSrc);
+        }
+        snapshot = value;
+    }
+
+    snapshot->request(option, cb);
+}
+
+void Snapshot::request(const SnapshotOption& option, const onSnapshot& cb)
+{
+    _lastAccess = TimeClock::now();
+
+    auto source = _source.lock();
+    if (!source) {
+        cb("source is empty", "");
+        return ;
+    }
+
+    weak_ptr<Snapshot> wSelf = shared_from_this();
+    // 关键帧和参数集在流的loop里取，解码编码放到work loop
+    source->getLoop()->async([wSelf, source, option, cb](){
+        auto self = wSelf.lock();
+        if (!self) {
+            cb("snapshot is released", "");
+            return ;
+        }
+
+        auto keyframe = source->getKeyframe();
+        if (!keyframe) {
+            cb("keyframe is empty", "");
+            return ;
+        }
+
+        string config;
+        CodecId codec;
+        for (auto& iter : source->getTrackInfo()) {
+            auto& track = iter.second;
+            if (track->trackType_ != "video") {
+                continue;
+            }
+            codec = track->codec_;
+            FrameBuffer::Ptr vps;
+            FrameBuffer::Ptr sps;
+            FrameBuffer::Ptr pps;
+            track->getVpsSpsPps(vps, sps, pps);
+            if (vps) {
+                config.append(vps->data(), vps->size());
+            }
+            if (sps) {
+                config.append(sps->data(), sps->size());
+            }
+            if (pps) {
+                config.append(pps->data(), pps->size());
+            }
+            break;
+        }
+
+        WorkTask::Ptr task = make_shared<WorkTask>();
+        task->priority_ = 100;
+        task->func_ = [wSelf, keyframe, config, codec, option, cb](){
+            auto self = wSelf.lock();
+            if (!self) {
+                cb("snapshot is released", "");
+                return ;
+            }
+            self->process(keyframe, config, codec, option, cb);
+        };
+        self->_workLoop->addOrderTask(task);
+    }, true);
+}
+
+void Snapshot::process(const FrameBuffer::Ptr& keyframe, const string& config, CodecId codec,
+                       const SnapshotOption& option, const onSnapshot& cb)
+{
+    // 来了新的关键帧，之前的解码帧和图片都作废
+    if (keyframe != _keyframe) {
+        _keyframe = keyframe;
+        _decodeFailed = false;
+        _images.clear();
+        av_frame_free(&_frame);
+    }
+
+    auto key = option.key();
+    auto it = _images.find(key);
+    if (it != _images.end()) {
+        cb("", it->second);
+        return ;
+    }
+
+    // 同一个关键帧解码失败过就不再重试，等下一个关键帧
+    if (!_frame && (_decodeFailed || !decode(keyframe, config, codec))) {
+        _decodeFailed = true;
+        cb("decode keyframe failed", "");
+        return ;
+    }
+
+    string image;
+    if (!encode(option, image)) {
+        cb("encode " + option.format_ + " failed", "");
+        return ;
+    }
+
+    // 尺寸由请求决定，防止缓存无限增长
+    if (_images.size() >= 16) {
+        _images.clear();
+    }
+    _images[key] = image;
+    cb("", image);
+}
+
+bool Snapshot::decode(const FrameBuffer::Ptr& keyframe, const string& config, CodecId codec)
+{
+    AVCodecID codecId;
+    if (codec == CodecH264) {
+        codecId = AV_CODEC_ID_H264;
+    } else if (codec == CodecH265) {
+        codecId = AV_CODEC_ID_H265;
+    } else {
+        logWarn << "snapshot not support codec: " << codec;
+        return false;
+    }
+
+    auto deCodec = avcodec_find_decoder(codecId);
+    if (!deCodec) {
+        logError << "Codec not found";
+        return false;
+    }
+
+    auto deCodecCtx = avcodec_alloc_context3(deCodec);
+    if (!deCodecCtx) {
+        logError << "Could not allocate video codec context";
+        return false;
+    }
+
+    int ret = avcodec_open2(deCodecCtx, deCodec, NULL);
+    if (ret < 0) {
+        logError << "Could not open codec: " << ffmpeg_err(ret);
+        avcodec_free_context(&deCodecCtx);
+        return false;
+    }
+
+    // 参数集+关键帧作为一个包送进解码器，解码器要求数据后面有padding
+    string data = config;
+    data.append(keyframe->data(), keyframe->size());
+    int size = data.size();
+    data.append(AV_INPUT_BUFFER_PADDING_SIZE, '\0');
+
+    auto pkt = av_packet_alloc();
+    pkt->data = (uint8_t *)data.data();
+    pkt->size = size;
+    pkt->flags |= AV_PKT_FLAG_KEY;
+
+    _frame = av_frame_alloc();
+    ret = avcodec_send_packet(deCodecCtx, pkt);
+    if (ret >= 0) {
+        // 只有一帧，直接flush拿到解码结果
+        avcodec_send_packet(deCodecCtx, NULL);
+        ret = avcodec_receive_frame(deCodecCtx, _frame);
+    }
+
+    av_packet_free(&pkt);
+    avcodec_free_context(&deCodecCtx);
+
+    if (ret < 0) {
+        logWarn << "decode keyframe failed: " << ffmpeg_err(ret);
+        av_frame_free(&_frame);
+        return false;
+    }
+
+    ++_decodeCount;
+
+    return true;
+}
+
+bool Snapshot::encode(const SnapshotOption& option, string& image)
+{
+    int width = option.width_;
+    int height = option.height_;
+    if (width <= 0 && height <= 0) {
+        width = _frame->width;
+        height = _frame->height;
+    } else if (width <= 0) {
+        width = (int64_t)_frame->width * height / _frame->height;
+    } else if (height <= 0) {
+        height = (int64_t)_frame->height * width / _frame->width;
+    }
+    width = max(width & ~1, 2);
+    height = max(height & ~1, 2);
+
+    const AVCodec *enCodec;
+    AVPixelFormat pixFmt;
+    if (option.format_ == "webp") {
+        enCodec = avcodec_find_encoder_by_name("libwebp");
+        pixFmt = AV_PIX_FMT_YUV420P;
+    } else {
+        enCodec = avcodec_find_encoder(AV_CODEC_ID_MJPEG);
+        pixFmt = AV_PIX_FMT_YUVJ420P;
+    }
+    if (!enCodec) {
+        logError << "codec not found: " << option.format_;
+        return false;
+    }
+
+    auto enCodecCtx = avcodec_alloc_context3(enCodec);
+    if (!enCodecCtx) {
+        logError << "Could not allocate image codec context";
+        return false;
+    }
+
+    int quality = min(max(option.quality_, 1), 100);
+    enCodecCtx->width = width;
+    enCodecCtx->height = height;
+    enCodecCtx->pix_fmt = pixFmt;
+    enCodecCtx->time_base = (AVRational){1, 25};
+    enCodecCtx->flags |= AV_CODEC_FLAG_QSCALE;
+    if (option.format_ == "webp") {
+        // libwebp的质量是0-100
+        enCodecCtx->global_quality = quality * FF_QP2LAMBDA;
+    } else {
+        // mjpeg的qscale是2-31，越小质量越好
+        enCodecCtx->global_quality = (2 + (100 - quality) * 29 / 100) * FF_QP2LAMBDA;
+        enCodecCtx->color_range = AVCOL_RANGE_JPEG;
+    }
+
+    int ret = avcodec_open2(enCodecCtx, enCodec, NULL);
+    if (ret < 0) {
+        logError << "Could not open codec: " << ffmpeg_err(ret);
+        avcodec_free_context(&enCodecCtx);
+        return false;
+    }
+
+    auto swsCtx = sws_getContext(_frame->width, _frame->height, (AVPixelFormat)_frame->format,
+                                 width, height, pixFmt, SWS_BILINEAR, NULL, NULL, NULL);
+    auto scaleFrame = av_frame_alloc();
+    auto pkt = av_packet_alloc();
+    bool ok = false;
+    do {
+        if (!swsCtx || !scaleFrame || !pkt) {
+            logError << "Could not create scale context";
+            break;
+        }
+
+        scaleFrame->format = pixFmt;
+        scaleFrame->width = width;
+        scaleFrame->height = height;
+        if (av_frame_get_buffer(scaleFrame, 0) < 0) {
+            logError << "Could not allocate scale frame";
+            break;
+        }
+        sws_scale(swsCtx, _frame->data, _frame->linesize, 0, _frame->height,
+                  scaleFrame->data, scaleFrame->linesize);
+        scaleFrame->pts = 0;
+        scaleFrame->quality = enCodecCtx->global_quality;
+
+        ret = avcodec_send_frame(enCodecCtx, scaleFrame);
+        if (ret < 0) {
+            logError << "Error sending a frame for encoding: " << ffmpeg_err(ret);
+            break;
+        }
+        avcodec_send_frame(enCodecCtx, NULL);
+
+        ret = avcodec_receive_packet(enCodecCtx, pkt);
+        if (ret < 0) {
+            logError << "Error during encoding: " << ffmpeg_err(ret);
+            break;
+        }
+
+        image.assign((char*)pkt->data, pkt->size);
+        ++_encodeCount;
+        ok = true;
+    } while (0);
+
+    av_packet_free(&pkt);
+    av_frame_free(&scaleFrame);
+    if (swsCtx) {
+        sws_freeContext(swsCtx);
+    }
+    avcodec_free_context(&enCodecCtx);
+
+    return ok;
+}
+
+#endif
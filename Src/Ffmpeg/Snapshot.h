@@ -0,0 +1,87 @@
+#ifndef Snapshot_H
+#define Snapshot_H
+
+#ifdef ENABLE_FFMPEG
+
+#include "Common/Frame.h"
+#include "Common/FrameMediaSource.h"
+#include "WorkPoller/WorkLoopPool.h"
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+}
+
+#include <string>
+#include <memory>
+#include <atomic>
+#include <functional>
+#include <unordered_map>
+#include <mutex>
+
+class SnapshotOption
+{
+public:
+    // jpeg或webp
+    std::string format_ = "jpeg";
+    // 为0时使用源分辨率，只设置其中一个时按源宽高比计算另一个
+    int width_ = 0;
+    int height_ = 0;
+    // 1-100，越大质量越好
+    int quality_ = 80;
+
+    std::string key() const;
+    std::string contentType() const;
+};
+
+// 关键帧截图，每路流一个，解码最近的关键帧后按请求的尺寸缩放编码成图片
+// 解码结果和图片都缓存到下一个关键帧，同一路流的请求都排在同一个work loop上，
+// 同一个gop内多个并发请求只解码一次，同一尺寸只编码一次
+class Snapshot : public std::enable_shared_from_this<Snapshot>
+{
+public:
+    using Ptr = std::shared_ptr<Snapshot>;
+    using onSnapshot = std::function<void(const std::string& err, const std::string& image)>;
+
+    Snapshot(const FrameMediaSource::Ptr& source);
+    ~Snapshot();
+
+public:
+    // 回调在work loop线程里执行，流不存在时抛异常
+    static void getSnapshot(const std::string& path, const std::string& vhost, const std::string& type,
+                            const SnapshotOption& option, const onSnapshot& cb);
+    static size_t getCount();
+    // 已有的截图缓存，没有时返回空
+    static Snapshot::Ptr get(const std::string& path, const std::string& vhost, const std::string& type);
+
+    uint64_t getDecodeCount() {return _decodeCount;}
+    uint64_t getEncodeCount() {return _encodeCount;}
+
+private:
+    void request(const SnapshotOption& option, const onSnapshot& cb);
+    void process(const FrameBuffer::Ptr& keyframe, const std::string& config, CodecId codec,
+                 const SnapshotOption& option, const onSnapshot& cb);
+    bool decode(const FrameBuffer::Ptr& keyframe, const std::string& config, CodecId codec);
+    bool encode(const SnapshotOption& option, std::string& image);
+    static void clearExpired();
+
+private:
+    bool _decodeFailed = false;
+    std::atomic<uint64_t> _lastAccess{0};
+    // 在work loop里累加，其他线程读取
+    std::atomic<uint64_t> _decodeCount{0};
+    std::atomic<uint64_t> _encodeCount{0};
+    AVFrame* _frame = NULL;
+    FrameBuffer::Ptr _keyframe;
+    FrameMediaSource::Wptr _source;
+    WorkLoop::Ptr _workLoop;
+    // SnapshotOption::key -> 图片
+    std::unordered_map<std::string, std::string> _images;
+
+    static std::mutex _mtx;
+    // vhost/type/path -> 截图
+    static std::unordered_map<std::string, Snapshot::Ptr> _mapSnapshot;
+};
+
+#endif
+
+#endif //Snapshot_H
@@ -67,13 +67,13 @@ AVFrame *FFmpegFrame::get() const {
 AudioDecoder::AudioDecoder(const TrackInfo::Ptr &track) {
     const AVCodec *codec = nullptr;
     const AVCodec *codec_default = nullptr;
-    if (track->codec_ == "aac") {
+    if (track->codec_ == CodecAAC) {
         codec = avcodec_find_decoder(AV_CODEC_ID_AAC);
-    } else if (track->codec_ == "g711a") {
+    } else if (track->codec_ == CodecG711A) {
         codec = avcodec_find_decoder(AV_CODEC_ID_PCM_ALAW);
-    } else if (track->codec_ == "g711u") {
+    } else if (track->codec_ == CodecG711U) {
         codec = avcodec_find_decoder(AV_CODEC_ID_PCM_MULAW);
-    } else if (track->codec_ == "opus") {
+    } else if (track->codec_ == CodecOpus) {
         codec = avcodec_find_decoder(AV_CODEC_ID_OPUS);
     }
 
@@ -97,7 +97,7 @@ AudioDecoder::AudioDecoder(const TrackInfo::Ptr &track) {
         _context->flags |= AV_CODEC_FLAG_LOW_DELAY;
         _context->flags2 |= AV_CODEC_FLAG2_FAST;
         if (track->trackType_ == "audio") {
-            if (track->codec_ == "g711a" || track->codec_ == "g711u") {
+            if (track->codec_ == CodecG711A || track->codec_ == CodecG711U) {
                 _context->sample_rate = track->samplerate_;
                 av_channel_layout_default(&_context->ch_layout, track->channel_);
             }
@@ -433,7 +433,7 @@ bool AudioEncoder::initCodec(int samplerate, int channel, int bitrate, const AVC
         av_channel_layout_default(&_context->ch_layout, channel);
         //logInfo << "_context->channels:+++++++++++"  << _context->channels << "|| _context->channel_layout:" << _context->channel_layout << endl;
 
-        if (_trackInfo->codec_ == "opus")
+        if (_trackInfo->codec_ == CodecOpus)
             _context->compression_level = 1;
 
         //_sample_bytes = av_get_bytes_per_sample(_context->sample_fmt) * _context->channels;
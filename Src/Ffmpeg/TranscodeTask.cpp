@@ -4,6 +4,7 @@
 #include "Log/Logger.h"
 #include "Common/Define.h"
 #include "Common/UrlParser.h"
+#include "Common/VariantManager.h"
 #include "Codec/H264Track.h"
 #include "Codec/H265Track.h"
 #include "Codec/AacTrack.h"
@@ -27,6 +28,14 @@ TranscodeTask::~TranscodeTask()
         _source->delConnection(this);
     }
 
+    if (!_ladderSources.empty()) {
+        VariantManager::instance()->delVariants(_uri, DEFAULT_VHOST);
+    }
+    for (auto& source : _ladderSources) {
+        source->release();
+        source->delConnection(this);
+    }
+
     auto originSrc = _originSource.lock();
     if (originSrc) {
         // originSrc->release();
@@ -63,6 +72,32 @@ std::string TranscodeTask::addTask(const std::string& uri, const std::string& vi
     return taskId;
 }
 
+std::string TranscodeTask::addLadderTask(const std::string& uri, const std::string& videoCodec, const std::string& audioCodec,
+                                         const std::vector<VideoEncodeOption>& renditions)
+{
+    if (renditions.empty()) {
+        throw runtime_error("renditions is empty");
+    }
+
+    string key = uri + "_ladder";
+    {
+        lock_guard<mutex> lck(_mtx);
+        if (_mapTask.find(key) != _mapTask.end()) {
+            throw runtime_error("a same task is exists");
+        }
+    }
+
+    auto task = std::make_shared<TranscodeTask>();
+    string taskId = task->initLadder(uri, videoCodec, audioCodec, renditions);
+
+    {
+        lock_guard<mutex> lck(_mtx);
+        _mapTask.emplace(key, task);
+    }
+
+    return taskId;
+}
+
 std::string TranscodeTask::init(const std::string& uri, const std::string& videoCodec, const std::string& audioCodec)
 {
     if (!_workLoop) {
@@ -108,125 +143,262 @@ std::string TranscodeTask::init(const std::string& uri, const std::string& video
 
         if (track->trackType_ == "video" && !videoCodec.empty()) {
             VideoEncodeOption option;
-            TrackInfo::Ptr newTrack;
-            if (videoCodec == "h264") {
-                option.codec_ = "libx264";
-                newTrack = H264Track::createTrack(track->index_, track->payloadType_, 90000);
-            } else if (videoCodec == "h265") {
-                option.codec_ = "libx265";
-                newTrack = make_shared<H265Track>();
-                newTrack->codec_ = "h265";
-            } else {
-                throw runtime_error("video codec not support: " + videoCodec);
-            }
-
-            newTrack->payloadType_ = track->payloadType_;
-            newTrack->index_ = track->index_;
-            newTrack->trackType_ = track->trackType_;
-            newTrack->samplerate_ = track->samplerate_;
+            auto newTrack = createVideoTrack(track, videoCodec, option);
             frameSrc->addTrack(newTrack);
             // 如果要264转265，这里改成AV_CODEC_ID_H264
-            _transcodeVideo.reset(new TranscodeVideo(option, track->codec_ == "h264"? AV_CODEC_ID_H264 : AV_CODEC_ID_H265));
+            _transcodeVideo.reset(new TranscodeVideo(option, track->codec_ == CodecH264? AV_CODEC_ID_H264 : AV_CODEC_ID_H265));
             _transcodeVideo->setOnPacket([wSelf, frameSrc, newTrack](const StreamBuffer::Ptr &packet){
                 auto self = wSelf.lock();
-                if (!self || !self->_eventLoop) {
-                    return ;
-                }
-
-                FrameBuffer::Ptr frame;
-                if (newTrack->codec_ == "h264") {
-                    frame = make_shared<H264Frame>();
-                } else {
-                    frame = make_shared<H265Frame>();
+                if (self) {
+                    self->onVideoPacket(frameSrc, newTrack, packet);
                 }
-                // frame->_buffer.assign("\x0\x0\x0\x1", 4);
-                frame->_buffer.assign(packet->data(), packet->size());
-                frame->_startSize = 4;
-                frame->_index = newTrack->index_;
-                frame->_trackType = VideoTrackType;
-                frame->_codec = newTrack->codec_;
-
-                // FILE* fp = fopen("testvod.h265", "ab+");
-                // fwrite(frame->data(), 1, frame->size(), fp);
-                // fclose(fp);
-
-                self->_eventLoop->async([newTrack, frameSrc, frame]() {
-                    // logInfo << "on frame after transcode";
-                    frame->split([newTrack, frameSrc](const FrameBuffer::Ptr& subFrame) {
-                        if (!newTrack->isReady()) {
-                            if (subFrame->getNalType() == H265_VPS) {
-                                newTrack->setVps(subFrame);
-                            } else if (subFrame->getNalType() == H265_SPS
-                                        || subFrame->getNalType() == H264_SPS) {
-                                newTrack->setSps(subFrame);
-                            } else if (subFrame->getNalType() == H265_PPS
-                                        || subFrame->getNalType() == H264_PPS) {
-                                newTrack->setPps(subFrame);
-                            }
-                        }
-                        // logInfo << "get a frame type: " << (int)subFrame->getNalType();
-
-                        if (newTrack->isReady()) {
-                            frameSrc->onFrame(subFrame);
-                        }
-                    });
-                    // frameSrc->onFrame(frame);
-                }, true);
             });
             _transcodeVideo->initDecode();
         } else if (track->trackType_ == "audio" && !audioCodec.empty()) {
-            TrackInfo::Ptr newTrack;
-            if (audioCodec == "aac") {
-                newTrack = make_shared<AacTrack>();
-                newTrack->codec_ = "aac";
-            } else if (audioCodec == "g711a") {
-                newTrack = make_shared<G711aTrack>();
-                newTrack->codec_ = audioCodec;
-            } else if (audioCodec == "g711u") {
-                newTrack = make_shared<G711uTrack>();
-                newTrack->codec_ = audioCodec;
-            } else {
-                throw runtime_error("audio codec not support: " + audioCodec);
+            auto newTrack = createAudioTrack(track, audioCodec);
+            frameSrc->addTrack(newTrack);
+            initAudio(track, newTrack);
+        } else {
+            frameSrc->addTrack(track);
+        }
+    }
+
+    // frameSrc->onReady();
+    attachOrigin(uri);
+
+    return _taskId;
+}
+
+std::string TranscodeTask::initLadder(const std::string& uri, const std::string& videoCodec, const std::string& audioCodec,
+                                      const std::vector<VideoEncodeOption>& renditions)
+{
+    if (!_workLoop) {
+        _workLoop = WorkLoopPool::instance()->getLoopByCircle();
+    }
+
+    _uri = uri;
+    _taskId = uri + "_ladder";
+    auto originSource = MediaSource::get(uri, DEFAULT_VHOST);
+    if (!originSource) {
+        throw runtime_error("origin source is not exists: " + uri);
+    }
+
+    auto tracks = originSource->getTrackInfo();
+    TrackInfo::Ptr videoTrack;
+    TrackInfo::Ptr audioTrack;
+    for (auto& iter: tracks) {
+        if (iter.second->trackType_ == "video") {
+            videoTrack = iter.second;
+        } else if (iter.second->trackType_ == "audio") {
+            audioTrack = iter.second;
+        }
+    }
+
+    if (!videoTrack) {
+        throw runtime_error("origin source has no video track: " + uri);
+    }
+
+    // 音频只转一次，所有码率共用
+    TrackInfo::Ptr newAudioTrack = audioTrack;
+    if (audioTrack && !audioCodec.empty()) {
+        newAudioTrack = createAudioTrack(audioTrack, audioCodec);
+    }
+
+    weak_ptr<TranscodeTask> wSelf = shared_from_this();
+    // 一个解码器，每个码率一路缩放+编码
+    _transcodeVideo.reset(new TranscodeVideo(videoTrack->codec_ == CodecH264? AV_CODEC_ID_H264 : AV_CODEC_ID_H265));
+    for (auto option : renditions) {
+        UrlParser urlParser;
+        urlParser.protocol_ = PROTOCOL_FRAME;
+        urlParser.path_ = uri + "_" + option.name_;
+        urlParser.vhost_ = DEFAULT_VHOST;
+        urlParser.type_ = DEFAULT_TYPE;
+        auto source = MediaSource::getOrCreate(urlParser.path_, urlParser.vhost_, urlParser.protocol_, urlParser.type_,
+        [urlParser, originSource](){
+            return make_shared<FrameMediaSource>(urlParser, originSource->getLoop());
+        });
+
+        auto frameSrc = dynamic_pointer_cast<FrameMediaSource>(source);
+        if (!frameSrc) {
+            throw runtime_error("rendition source is exists: " + urlParser.path_);
+        }
+
+        if (frameSrc->getLoop() == nullptr) {
+            frameSrc->setLoop(originSource->getLoop());
+        }
+        frameSrc->setOrigin();
+        frameSrc->setAction(true);
+        _ladderSources.push_back(frameSrc);
+
+        auto newTrack = createVideoTrack(videoTrack, videoCodec, option);
+        frameSrc->addTrack(newTrack);
+        if (newAudioTrack) {
+            frameSrc->addTrack(newAudioTrack);
+        }
+
+        auto branch = _transcodeVideo->addBranch(option);
+        branch->setOnPacket([wSelf, frameSrc, newTrack](const StreamBuffer::Ptr &packet){
+            auto self = wSelf.lock();
+            if (self) {
+                self->onVideoPacket(frameSrc, newTrack, packet);
             }
+        });
+
+        VariantInfo info;
+        info.name = option.name_;
+        info.path = urlParser.path_;
+        info.width = option.width_;
+        info.height = option.height_;
+        info.bandwidth = option.bitrate_ > 0 ? option.bitrate_ : 1000000;
+        VariantManager::instance()->addVariant(uri, DEFAULT_VHOST, info);
+    }
+    _transcodeVideo->initDecode();
 
-            newTrack->payloadType_ = track->payloadType_;
-            newTrack->index_ = track->index_;
-            newTrack->trackType_ = track->trackType_;
-            newTrack->samplerate_ = track->samplerate_;
-            newTrack->channel_ = track->channel_;
-            newTrack->bitPerSample_ = track->bitPerSample_;
-            frameSrc->addTrack(newTrack);
+    if (audioTrack && !audioCodec.empty()) {
+        initAudio(audioTrack, newAudioTrack);
+    }
 
-            _transcodeAudio = make_shared<AudioDecoder>(track);
-            auto encoder = make_shared<AudioEncoder>(newTrack);
+    attachOrigin(uri);
 
-            _transcodeAudio->setOnDecode([encoder](const FFmpegFrame::Ptr & frame) {
-                encoder->inputFrame(frame, true);
-            });
-            //_audio_enc->setOnEncode([this](const Frame::Ptr& frame) {
-            encoder->setOnPacket([wSelf, frameSrc, newTrack](const FrameBuffer::Ptr& frame) {
-                auto self = wSelf.lock();
-                if (!self || !self->_eventLoop) {
-                    return ;
-                }
+    return _taskId;
+}
 
-                // frame->_startSize = 7;
-                frame->_index = newTrack->index_;
-                frame->_trackType = AudioTrackType;
-                // frame->_codec = newTrack->codec_;
-                // frameSrc->onFrame(frame);
+TrackInfo::Ptr TranscodeTask::createVideoTrack(const TrackInfo::Ptr& track, const std::string& videoCodec, VideoEncodeOption& option)
+{
+    TrackInfo::Ptr newTrack;
+    if (videoCodec == "h264") {
+        option.codec_ = "libx264";
+        newTrack = H264Track::createTrack(track->index_, track->payloadType_, 90000);
+    } else if (videoCodec == "h265") {
+        option.codec_ = "libx265";
+        newTrack = make_shared<H265Track>();
+        newTrack->codec_ = CodecH265;
+    } else {
+        throw runtime_error("video codec not support: " + videoCodec);
+    }
 
-                self->_eventLoop->async([newTrack, frameSrc, frame]() {
-                    frameSrc->onFrame(frame);
-                }, true);
-            });
-        } else {
-            frameSrc->addTrack(track);
+    newTrack->payloadType_ = track->payloadType_;
+    newTrack->index_ = track->index_;
+    newTrack->trackType_ = track->trackType_;
+    newTrack->samplerate_ = track->samplerate_;
+
+    return newTrack;
+}
+
+TrackInfo::Ptr TranscodeTask::createAudioTrack(const TrackInfo::Ptr& track, const std::string& audioCodec)
+{
+    TrackInfo::Ptr newTrack;
+    if (audioCodec == "aac") {
+        newTrack = make_shared<AacTrack>();
+        newTrack->codec_ = CodecAAC;
+    } else if (audioCodec == "g711a") {
+        newTrack = make_shared<G711aTrack>();
+        newTrack->codec_ = audioCodec;
+    } else if (audioCodec == "g711u") {
+        newTrack = make_shared<G711uTrack>();
+        newTrack->codec_ = audioCodec;
+    } else {
+        throw runtime_error("audio codec not support: " + audioCodec);
+    }
+
+    newTrack->payloadType_ = track->payloadType_;
+    newTrack->index_ = track->index_;
+    newTrack->trackType_ = track->trackType_;
+    newTrack->samplerate_ = track->samplerate_;
+    newTrack->channel_ = track->channel_;
+    newTrack->bitPerSample_ = track->bitPerSample_;
+
+    return newTrack;
+}
+
+void TranscodeTask::initAudio(const TrackInfo::Ptr& track, const TrackInfo::Ptr& newTrack)
+{
+    weak_ptr<TranscodeTask> wSelf = shared_from_this();
+    _transcodeAudio = make_shared<AudioDecoder>(track);
+    auto encoder = make_shared<AudioEncoder>(newTrack);
+
+    _transcodeAudio->setOnDecode([encoder](const FFmpegFrame::Ptr & frame) {
+        encoder->inputFrame(frame, true);
+    });
+    //_audio_enc->setOnEncode([this](const Frame::Ptr& frame) {
+    encoder->setOnPacket([wSelf, newTrack](const FrameBuffer::Ptr& frame) {
+        auto self = wSelf.lock();
+        if (!self || !self->_eventLoop) {
+            return ;
         }
+
+        // frame->_startSize = 7;
+        frame->_index = newTrack->index_;
+        frame->_trackType = AudioTrackType;
+        // frame->_codec = newTrack->codec_;
+        // frameSrc->onFrame(frame);
+
+        self->_eventLoop->async([wSelf, frame]() {
+            auto self = wSelf.lock();
+            if (self) {
+                self->onOutputFrame(frame);
+            }
+        }, true);
+    });
+}
+
+void TranscodeTask::onVideoPacket(const FrameMediaSource::Ptr& frameSrc, const TrackInfo::Ptr& newTrack, const StreamBuffer::Ptr &packet)
+{
+    if (!_eventLoop) {
+        return ;
     }
 
-    // frameSrc->onReady();
+    FrameBuffer::Ptr frame;
+    if (newTrack->codec_ == CodecH264) {
+        frame = make_shared<H264Frame>();
+    } else {
+        frame = make_shared<H265Frame>();
+    }
+    // frame->_buffer.assign("\x0\x0\x0\x1", 4);
+    frame->_buffer.assign(packet->data(), packet->size());
+    frame->_startSize = 4;
+    frame->_index = newTrack->index_;
+    frame->_trackType = VideoTrackType;
+    frame->_codec = newTrack->codec_;
+
+    _eventLoop->async([newTrack, frameSrc, frame]() {
+        // logInfo << "on frame after transcode";
+        frame->split([newTrack, frameSrc](const FrameBuffer::Ptr& subFrame) {
+            if (!newTrack->isReady()) {
+                if (subFrame->getNalType() == H265_VPS) {
+                    newTrack->setVps(subFrame);
+                } else if (subFrame->getNalType() == H265_SPS
+                            || subFrame->getNalType() == H264_SPS) {
+                    newTrack->setSps(subFrame);
+                } else if (subFrame->getNalType() == H265_PPS
+                            || subFrame->getNalType() == H264_PPS) {
+                    newTrack->setPps(subFrame);
+                }
+            }
+            // logInfo << "get a frame type: " << (int)subFrame->getNalType();
 
+            if (newTrack->isReady()) {
+                frameSrc->onFrame(subFrame);
+            }
+        });
+        // frameSrc->onFrame(frame);
+    }, true);
+}
+
+void TranscodeTask::onOutputFrame(const FrameBuffer::Ptr& frame)
+{
+    if (_source) {
+        _source->onFrame(frame);
+    }
+
+    for (auto& source : _ladderSources) {
+        source->onFrame(frame);
+    }
+}
+
+void TranscodeTask::attachOrigin(const std::string& uri)
+{
+    weak_ptr<TranscodeTask> wSelf = shared_from_this();
     UrlParser urlParser;
     urlParser.protocol_ = PROTOCOL_FRAME;
     urlParser.path_ = uri;
@@ -256,8 +428,6 @@ std::string TranscodeTask::init(const std::string& uri, const std::string& video
         }
         return make_shared<FrameMediaSource>(urlParser, nullptr);
     }, this);
-
-    return _taskId;
 }
 
 void TranscodeTask::setBitrate(int bitrate)
@@ -270,12 +440,16 @@ void TranscodeTask::setBitrate(int bitrate)
 void TranscodeTask::onOriginFrameSource(const MediaSource::Ptr &src)
 {
     _eventLoop = src->getLoop();
-    auto transSrc = _source;
-    if (!transSrc) {
+    if (!_source && _ladderSources.empty()) {
         return;
     }
 
-    transSrc->setLoop(_eventLoop);
+    if (_source) {
+        _source->setLoop(_eventLoop);
+    }
+    for (auto& source : _ladderSources) {
+        source->setLoop(_eventLoop);
+    }
 
     auto frameSrc = dynamic_pointer_cast<FrameMediaSource>(src);
     _originSource = frameSrc;
@@ -314,11 +488,6 @@ void TranscodeTask::onOriginFrameSource(const MediaSource::Ptr &src)
         if (!self/* || pack->empty()*/) {
             return;
         }
-        
-        auto frameSrc = self->_source;
-        if (!frameSrc) {
-            return ;
-        }
 
         // logInfo << "start decode ===========";
         if (pack->_trackType == VideoTrackType) {
@@ -339,7 +508,7 @@ void TranscodeTask::onOriginFrameSource(const MediaSource::Ptr &src)
                 // logInfo << "add work task";
                 self->_workLoop->addOrderTask(task);
             } else {
-                frameSrc->onFrame(pack);
+                self->onOutputFrame(pack);
             }
         } else if (pack->_trackType == AudioTrackType) {
             if (self->_transcodeAudio) {
@@ -356,7 +525,7 @@ void TranscodeTask::onOriginFrameSource(const MediaSource::Ptr &src)
                 };
                 self->_workLoop->addOrderTask(task);
             } else {
-                frameSrc->onFrame(pack);
+                self->onOutputFrame(pack);
             }
         }
     });
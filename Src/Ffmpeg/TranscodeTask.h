@@ -12,6 +12,7 @@
 #include "EventPoller/EventLoop.h"
 
 #include <string>
+#include <vector>
 #include <memory>
 #include <unordered_map>
 #include <mutex>
@@ -27,18 +28,34 @@ public:
 public:
     TranscodeTask::Ptr instance();
     static std::string addTask(const std::string& uri, const std::string& videoCodec, const std::string& audioCodec);
+    // 多码率: 只解码一次，每个码率发布成uri_name的流，关键帧对齐
+    static std::string addLadderTask(const std::string& uri, const std::string& videoCodec, const std::string& audioCodec,
+                                     const std::vector<VideoEncodeOption>& renditions);
     static void delTask(const std::string& taskId);
     static TranscodeTask::Ptr getTask(const std::string& taskId);
 
     std::string init(const std::string& uri, const std::string& videoCodec, const std::string& audioCodec);
+    std::string initLadder(const std::string& uri, const std::string& videoCodec, const std::string& audioCodec,
+                           const std::vector<VideoEncodeOption>& renditions);
     void setBitrate(int bitrate);
 
     void onOriginFrameSource(const MediaSource::Ptr &src);
     void close();
 
 private:
+    TrackInfo::Ptr createVideoTrack(const TrackInfo::Ptr& track, const std::string& videoCodec, VideoEncodeOption& option);
+    TrackInfo::Ptr createAudioTrack(const TrackInfo::Ptr& track, const std::string& audioCodec);
+    void initAudio(const TrackInfo::Ptr& track, const TrackInfo::Ptr& newTrack);
+    void attachOrigin(const std::string& uri);
+    void onVideoPacket(const FrameMediaSource::Ptr& frameSrc, const TrackInfo::Ptr& newTrack, const StreamBuffer::Ptr &packet);
+    // 不需要转码的帧和转码后的音频，发给所有输出流
+    void onOutputFrame(const FrameBuffer::Ptr& frame);
+
+private:
+    std::string _uri;
     std::string _taskId;
     FrameMediaSource::Ptr _source;
+    std::vector<FrameMediaSource::Ptr> _ladderSources;
     FrameMediaSource::Wptr _originSource;
     MediaSource::FrameRingType::DataQueReaderT::Ptr _playReader;
     std::shared_ptr<TranscodeVideo> _transcodeVideo;
@@ -3,15 +3,13 @@
 #include "TranscodeVideo.h"
 #include "Log/Logger.h"
 
-using namespace std;
+#include <algorithm>
 
-// static string getAvError(int errnum)
-// {
-//     char buffer[AV_ERROR_MAX_STRING_SIZE] = {0};
-//     av_err2str_cpp(errnum, buffer, AV_ERROR_MAX_STRING_SIZE);
+extern "C" {
+#include <libavutil/opt.h>
+}
 
-//     return string(buffer);
-// }
+using namespace std;
 
 static string ffmpeg_err(int errnum) {
     char errbuf[AV_ERROR_MAX_STRING_SIZE];
@@ -19,109 +17,168 @@ static string ffmpeg_err(int errnum) {
     return errbuf;
 }
 
-TranscodeVideo::TranscodeVideo(const VideoEncodeOption& option, AVCodecID deVideoCodecId)
+TranscodeVideoBranch::TranscodeVideoBranch(const VideoEncodeOption& option)
     :_option(option)
-    ,_deVideoCodecId(deVideoCodecId)
 {}
 
-TranscodeVideo::~TranscodeVideo()
+TranscodeVideoBranch::~TranscodeVideoBranch()
 {
-    /* flush the decoder */
-    decode(_deCodecCtx, _deFrame, NULL);
-
-    av_parser_close(_deParser);
-    avcodec_free_context(&_deCodecCtx);
     avcodec_free_context(&_enCodecCtx);
-    av_frame_free(&_deFrame);
-    av_packet_free(&_pkt);
     av_packet_free(&_enPkt);
+    av_frame_free(&_scaleFrame);
+    if (_swsCtx) {
+        sws_freeContext(_swsCtx);
+        _swsCtx = NULL;
+    }
 }
 
-void TranscodeVideo::initEncode(AVCodecContext *dec_ctx)
+bool TranscodeVideoBranch::initEncode(AVCodecContext *dec_ctx, int gop)
 {
-    /* find the mpeg1video encoder */
+    _initEncode = true;
+
     const AVCodec *en_codec;
-    // char* codec_name = "libx264";
     en_codec = avcodec_find_encoder_by_name(_option.codec_.data());
     if (!en_codec) {
         logError << "codec not found: " << _option.codec_;
-        return ;
+        return false;
     }
 
     _enCodecCtx = avcodec_alloc_context3(en_codec);
     if (!_enCodecCtx) {
         logError << "Could not allocate video codec context";
-        return ;
+        return false;
     }
 
     _enPkt = av_packet_alloc();
     if (!_enPkt)
-        return ;
-
-    /* put sample parameters */
-    // en_c->bit_rate = 2000000;
+        return false;
+
+    // 只给宽或高时按源的宽高比算另一边
+    int width = _option.width_;
+    int height = _option.height_;
+    if (width <= 0 && height <= 0) {
+        width = dec_ctx->width;
+        height = dec_ctx->height;
+    } else if (width <= 0) {
+        width = (int64_t)dec_ctx->width * height / dec_ctx->height;
+    } else if (height <= 0) {
+        height = (int64_t)dec_ctx->height * width / dec_ctx->width;
+    }
     /* resolution must be a multiple of two */
-    _enCodecCtx->width = dec_ctx->width;
-    _enCodecCtx->height = dec_ctx->height;
+    width = max(width & ~1, 2);
+    height = max(height & ~1, 2);
+
+    _enCodecCtx->width = width;
+    _enCodecCtx->height = height;
     /* frames per second */
     _enCodecCtx->time_base = (AVRational){1, 25};
     _enCodecCtx->framerate = (AVRational){25, 1};
 
-    int bitrate = 1000000;
+    int bitrate = _option.bitrate_ > 0 ? _option.bitrate_ : 1000000;
     _enCodecCtx->bit_rate = bitrate;
     _enCodecCtx->rc_buffer_size = bitrate;
     _enCodecCtx->rc_max_rate = bitrate;
     _enCodecCtx->rc_min_rate = bitrate;
     _enCodecCtx->rc_initial_buffer_occupancy = bitrate * 3 / 4;
 
-    /* emit one intra frame every ten frames
-     * check frame pict_type before passing frame
-     * to encoder, if frame->pict_type is AV_PICTURE_TYPE_I
-     * then gop_size is ignored and the output of encoder
-     * will always be I frame irrespective to gop_size
-     */
-    _enCodecCtx->gop_size = 25;
-    _enCodecCtx->max_b_frames = 0;
-    _enCodecCtx->pix_fmt = AV_PIX_FMT_YUV420P;
-
-    // if (en_codec->id == AV_CODEC_ID_H264)
-    //     av_opt_set(en_c->priv_data, "preset", "slow", 0);
+    // 所有分支用同一个gop，再关掉场景切换，关键帧只出现在TranscodeVideo强制的位置
+    _enCodecCtx->gop_size = gop;
+    _enCodecCtx->max_b_frames = _option.maxBFrame_;
+    _enCodecCtx->pix_fmt = _option.fixFmt_;
+    av_opt_set(_enCodecCtx->priv_data, "forced-idr", "1", 0);
+    if (_option.codec_ == "libx264") {
+        av_opt_set(_enCodecCtx->priv_data, "x264-params", "scenecut=0", 0);
+    } else if (_option.codec_ == "libx265") {
+        av_opt_set(_enCodecCtx->priv_data, "x265-params", "scenecut=0", 0);
+    }
 
     /* open it */
     int ret = avcodec_open2(_enCodecCtx, en_codec, NULL);
     if (ret < 0) {
         logError << "Could not open codec: " << ffmpeg_err(ret);
-        return ;
+        avcodec_free_context(&_enCodecCtx);
+        return false;
     }
+
+    if (width != dec_ctx->width || height != dec_ctx->height || dec_ctx->pix_fmt != _option.fixFmt_) {
+        _swsCtx = sws_getContext(dec_ctx->width, dec_ctx->height, dec_ctx->pix_fmt,
+                                 width, height, _option.fixFmt_, SWS_BILINEAR, NULL, NULL, NULL);
+        _scaleFrame = av_frame_alloc();
+        if (!_swsCtx || !_scaleFrame) {
+            logError << "Could not create scale context";
+            avcodec_free_context(&_enCodecCtx);
+            return false;
+        }
+        _scaleFrame->format = _option.fixFmt_;
+        _scaleFrame->width = width;
+        _scaleFrame->height = height;
+        if (av_frame_get_buffer(_scaleFrame, 0) < 0) {
+            logError << "Could not allocate scale frame";
+            avcodec_free_context(&_enCodecCtx);
+            return false;
+        }
+    }
+
+    logInfo << "init encode branch: " << _option.name_ << ", " << width << "x" << height
+            << ", bitrate: " << bitrate << ", gop: " << gop;
+
+    return true;
 }
 
-void TranscodeVideo::setBitrate(int bitrate)
+void TranscodeVideoBranch::setBitrate(int bitrate)
 {
+    _option.bitrate_ = bitrate;
+    if (!_enCodecCtx) {
+        return ;
+    }
+
     _enCodecCtx->bit_rate = bitrate;
     _enCodecCtx->rc_buffer_size = bitrate;
     _enCodecCtx->rc_max_rate = bitrate;
     _enCodecCtx->rc_min_rate = bitrate;
     _enCodecCtx->rc_initial_buffer_occupancy = bitrate * 3 / 4;
-    // _enCodecCtx->rc_max_available_vbv_use = 100;
 }
 
-void TranscodeVideo::encode(AVCodecContext *enc_ctx, AVFrame *frame, AVPacket *pkt)
+AVFrame* TranscodeVideoBranch::scale(AVFrame *frame)
 {
-    /* send the frame to the encoder */
-    // if (frame) {
-    //     logInfo << "Send frame: " << frame->pts;
-    // }
+    if (!_swsCtx) {
+        return frame;
+    }
 
-    frame->pts = _index++;
-    // frame->dts = _index++;
-    int ret = avcodec_send_frame(enc_ctx, frame);
+    // 编码器可能还引用着上一帧的数据
+    if (av_frame_make_writable(_scaleFrame) < 0) {
+        logError << "scale frame is not writable";
+        return NULL;
+    }
+
+    sws_scale(_swsCtx, frame->data, frame->linesize, 0, frame->height,
+              _scaleFrame->data, _scaleFrame->linesize);
+
+    return _scaleFrame;
+}
+
+void TranscodeVideoBranch::encode(AVFrame *frame, bool forceKey)
+{
+    if (!_enCodecCtx || !_enPkt) {
+        return ;
+    }
+
+    auto enFrame = scale(frame);
+    if (!enFrame) {
+        return ;
+    }
+
+    enFrame->pts = _index++;
+    enFrame->pict_type = forceKey ? AV_PICTURE_TYPE_I : AV_PICTURE_TYPE_NONE;
+    /* send the frame to the encoder */
+    int ret = avcodec_send_frame(_enCodecCtx, enFrame);
     if (ret < 0) {
         logError << "Error sending a frame for encoding";
         return ;
     }
 
     while (ret >= 0) {
-        ret = avcodec_receive_packet(enc_ctx, pkt);
+        ret = avcodec_receive_packet(_enCodecCtx, _enPkt);
         if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF) {
             return;
         } else if (ret < 0) {
@@ -129,12 +186,55 @@ void TranscodeVideo::encode(AVCodecContext *enc_ctx, AVFrame *frame, AVPacket *p
             return ;
         }
 
-        // logInfo << "Write packet pts: " << pkt->pts << ", size: " << pkt->size;
-        StreamBuffer::Ptr buffer = make_shared<StreamBuffer>(pkt->size);
-        buffer->assign((char*)pkt->data, pkt->size);
-        onPacket(buffer);
+        StreamBuffer::Ptr buffer = make_shared<StreamBuffer>(_enPkt->size);
+        buffer->assign((char*)_enPkt->data, _enPkt->size);
+        if (_onPacket) {
+            _onPacket(buffer);
+        }
+
+        av_packet_unref(_enPkt);
+    }
+}
+
+TranscodeVideo::TranscodeVideo(const VideoEncodeOption& option, AVCodecID deVideoCodecId)
+    :_deVideoCodecId(deVideoCodecId)
+{
+    addBranch(option);
+}
+
+TranscodeVideo::TranscodeVideo(AVCodecID deVideoCodecId)
+    :_deVideoCodecId(deVideoCodecId)
+{}
+
+TranscodeVideo::~TranscodeVideo()
+{
+    /* flush the decoder */
+    if (_deCodecCtx && _deFrame) {
+        decode(_deCodecCtx, _deFrame, NULL);
+    }
+
+    avcodec_free_context(&_deCodecCtx);
+    av_frame_free(&_deFrame);
+    av_packet_free(&_pkt);
+    _branches.clear();
+}
+
+TranscodeVideoBranch::Ptr TranscodeVideo::addBranch(const VideoEncodeOption& option)
+{
+    auto branch = make_shared<TranscodeVideoBranch>(option);
+    // 所有分支用第一路的gop，0或负数用默认值25
+    if (_branches.empty()) {
+        _gop = option.gop_ > 0 ? option.gop_ : 25;
+    }
+    _branches.push_back(branch);
+
+    return branch;
+}
 
-        av_packet_unref(pkt);
+void TranscodeVideo::setBitrate(int bitrate)
+{
+    if (!_branches.empty()) {
+        _branches[0]->setBitrate(bitrate);
     }
 }
 
@@ -144,7 +244,7 @@ void TranscodeVideo::decode(AVCodecContext *dec_ctx, AVFrame *frame, AVPacket *p
 
     ret = avcodec_send_packet(dec_ctx, pkt);
     if (ret < 0) {
-        fprintf(stderr, "Error sending a packet for decoding\n");
+        logError << "Error sending a packet for decoding: " << ffmpeg_err(ret);
         return ;
     }
 
@@ -153,27 +253,26 @@ void TranscodeVideo::decode(AVCodecContext *dec_ctx, AVFrame *frame, AVPacket *p
         if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF)
             return;
         else if (ret < 0) {
-            fprintf(stderr, "Error during decoding\n");
+            logError << "Error during decoding: " << ffmpeg_err(ret);
             return ;
         }
 
-        // logInfo << "saving frame: " << dec_ctx->frame_num;
-        fflush(stdout);
-
-        if (!_bInitEncode) {
-            _bInitEncode = 1;
-            initEncode(dec_ctx);
-        }
-
-        if (!_enCodecCtx || !_enPkt) {
-            logError << "init encode error";
-            return ;
+        if (!_initEncode) {
+            _initEncode = true;
+            for (auto& branch : _branches) {
+                if (!branch->initEncode(dec_ctx, _gop)) {
+                    logError << "init encode error: " << branch->getOption().name_;
+                }
+            }
         }
 
         /* the picture is allocated by the decoder. no need to
            free it */
-        // snprintf(buf, sizeof(buf), "%s-%"PRId64, filename, dec_ctx->frame_num);
-        encode(_enCodecCtx, frame, _enPkt);
+        // 同一解码帧在所有分支上同时强制为关键帧，各路切片边界一致
+        bool forceKey = _decodeCount++ % _gop == 0;
+        for (auto& branch : _branches) {
+            branch->encode(frame, forceKey);
+        }
     }
 }
 
@@ -189,12 +288,6 @@ void TranscodeVideo::initDecode()
         return ;
     }
 
-    _deParser = av_parser_init(_deCodec->id);
-    if (!_deParser) {
-        logError << "parser not found";
-        return ;
-    }
-
     _deCodecCtx = avcodec_alloc_context3(_deCodec);
     if (!_deCodecCtx) {
         logError << "Could not allocate video codec context";
@@ -220,55 +313,26 @@ void TranscodeVideo::initDecode()
 
 int TranscodeVideo::inputFrame(const FrameBuffer::Ptr& frame)
 {
-    uint8_t *data = (uint8_t*)frame->data();
-    size_t   data_size = frame->size();
-    int ret;
-
-    /* find the MPEG-1 video decoder */
-    
-    // logInfo << "TranscodeVideo::inputFrame: " << data_size << " bytes";
-    bool eof = !data_size;
-
-    auto pkt = av_packet_alloc();
-    pkt->data = (uint8_t *) data;
-    pkt->size = data_size;
-    pkt->dts = frame->dts();
-    pkt->pts = frame->pts();
-    if (frame->keyFrame()) {
-        pkt->flags |= AV_PKT_FLAG_KEY;
+    if (!_deCodecCtx || !_deFrame || !_pkt) {
+        return -1;
     }
 
-    decode(_deCodecCtx, _deFrame, pkt);
+    // _pkt不持有数据，avcodec_send_packet会拷贝，可以每帧复用
+    _pkt->data = (uint8_t*)frame->data();
+    _pkt->size = frame->size();
+    _pkt->dts = frame->dts();
+    _pkt->pts = frame->pts();
+    _pkt->flags = frame->keyFrame() ? AV_PKT_FLAG_KEY : 0;
 
-    av_packet_free(&pkt);
-
-    /* use the parser to split the data into frames */
-    // while (data_size > 0 || eof) {
-    //     ret = av_parser_parse2(_deParser, _deCodecCtx, &_pkt->data, &_pkt->size,
-    //                             data, data_size, AV_NOPTS_VALUE, AV_NOPTS_VALUE, 0);
-    //     if (ret < 0) {
-    //         logError << "Error while parsing";
-    //         return ret;
-    //     }
-    //     data      += ret;
-    //     data_size -= ret;
-
-    //     if (_pkt->size)
-    //         decode(_deCodecCtx, _deFrame, _pkt);
-    // }
+    decode(_deCodecCtx, _deFrame, _pkt);
 
     return 0;
 }
 
 void TranscodeVideo::setOnPacket(const function<void(const StreamBuffer::Ptr& packet)>& cb)
 {
-    _onPacket = cb;
-}
-
-void TranscodeVideo::onPacket(const StreamBuffer::Ptr& packet)
-{
-    if (_onPacket) {
-        _onPacket(packet);
+    if (!_branches.empty()) {
+        _branches[0]->setOnPacket(cb);
     }
 }
 
@@ -7,55 +7,92 @@
 
 extern "C" {
 #include <libavcodec/avcodec.h>
+#include <libswscale/swscale.h>
 }
 
 #include <string>
+#include <vector>
+#include <memory>
 
 class VideoEncodeOption
 {
 public:
+    std::string name_;
     std::string codec_;
-    int width_;
-    int height_;
-    int bitrate_;
-    int gop_;
-    int maxBFrame_;
-    AVPixelFormat fixFmt_;
+    // 为0时使用源分辨率，只设置高度时按源宽高比计算宽度
+    int width_ = 0;
+    int height_ = 0;
+    // 为0时使用默认码率1000000
+    int bitrate_ = 0;
+    // 为0时使用默认值25
+    int gop_ = 0;
+    int maxBFrame_ = 0;
+    AVPixelFormat fixFmt_ = AV_PIX_FMT_YUV420P;
+};
+
+// 一路缩放+编码，多路共享同一个解码器
+class TranscodeVideoBranch
+{
+public:
+    using Ptr = std::shared_ptr<TranscodeVideoBranch>;
+
+    TranscodeVideoBranch(const VideoEncodeOption& option);
+    ~TranscodeVideoBranch();
+
+public:
+    bool initEncode(AVCodecContext *dec_ctx, int gop);
+    // forceKey为true时强制编成IDR，保证各路关键帧对齐
+    void encode(AVFrame *frame, bool forceKey);
+    void setBitrate(int bitrate);
+    void setOnPacket(const function<void(const StreamBuffer::Ptr& packet)>& cb) {_onPacket = cb;}
+    const VideoEncodeOption& getOption() {return _option;}
+
+private:
+    AVFrame* scale(AVFrame *frame);
+
+private:
+    bool _initEncode = false;
+    uint64_t _index = 0;
+    VideoEncodeOption _option;
+    AVCodecContext *_enCodecCtx = NULL;
+    AVPacket *_enPkt = NULL;
+    SwsContext *_swsCtx = NULL;
+    AVFrame *_scaleFrame = NULL;
+    function<void(const StreamBuffer::Ptr& packet)> _onPacket;
 };
 
 class TranscodeVideo
 {
 public:
+    // 只有一路输出，分辨率同源
     TranscodeVideo(const VideoEncodeOption& option, AVCodecID deVideoCodecId);
+    // 多码率，通过addBranch添加输出
+    TranscodeVideo(AVCodecID deVideoCodecId);
     ~TranscodeVideo();
 
 public:
-    void initEncode(AVCodecContext *dec_ctx);
-    void encode(AVCodecContext *enc_ctx, AVFrame *frame, AVPacket *pkt);
+    // 需要在initDecode之前调用
+    TranscodeVideoBranch::Ptr addBranch(const VideoEncodeOption& option);
     void initDecode();
     void decode(AVCodecContext *dec_ctx, AVFrame *frame, AVPacket *pkt);
     int inputFrame(const FrameBuffer::Ptr& frame);
 
+    // 设置第一路输出的回调和码率
     void setOnPacket(const function<void(const StreamBuffer::Ptr& packet)>& cb);
-    void onPacket(const StreamBuffer::Ptr& packet);
     void setBitrate(int bitrate);
 
 private:
-    VideoEncodeOption _option;
-    AVCodecContext *_enCodecCtx= NULL;
-    AVPacket *_enPkt;
-    int _bInitEncode = 0;
-    uint64_t _index = 0;
+    bool _initEncode = false;
+    int _gop = 25;
+    uint64_t _decodeCount = 0;
+    std::vector<TranscodeVideoBranch::Ptr> _branches;
 
-    const AVCodec *_deCodec;
-    AVCodecParserContext *_deParser;
-    AVCodecContext *_deCodecCtx= NULL;
-    AVFrame *_deFrame;
-    AVPacket *_pkt;
+    const AVCodec *_deCodec = NULL;
+    AVCodecContext *_deCodecCtx = NULL;
+    AVFrame *_deFrame = NULL;
+    AVPacket *_pkt = NULL;
 
     AVCodecID _deVideoCodecId;
-
-    function<void(const StreamBuffer::Ptr& packet)> _onPacket;
 };
 
 #endif
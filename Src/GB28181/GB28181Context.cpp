@@ -166,7 +166,15 @@ void GB28181Context::initAfterPublish()
 
     });
 
-    _sort = make_shared<RtpSort>(256);
+    // 旧的配置文件没有这两项时保持原来的256个包的排序深度
+    static int jitterDepth = Config::instance()->getAndListen([](const json& config){
+        jitterDepth = Config::instance()->get("Rtp", "jitterDepth", "", "", "256");
+    }, "Rtp", "jitterDepth", "", "", "256");
+    static int jitterMaxWait = Config::instance()->getAndListen([](const json& config){
+        jitterMaxWait = Config::instance()->get("Rtp", "jitterMaxWait", "", "", "100");
+    }, "Rtp", "jitterMaxWait", "", "", "100");
+
+    _sort = make_shared<RtpSort>(jitterDepth, jitterMaxWait);
     _sort->setOnRtpPacket([wSelf](const RtpPacket::Ptr& rtp){
         // logInfo << "decode rtp seq: " << rtp->getSeq() << ", rtp size: " << rtp->size() << ", rtp time: " << rtp->getStamp();
         auto self = wSelf.lock();
@@ -182,12 +190,31 @@ void GB28181Context::initAfterPublish()
             }
         }
     });
+    _sort->startTimer(_loop);
 
     _timeClock.start();
 }
 
 void GB28181Context::onRtpPacket(const RtpPacket::Ptr& rtp, struct sockaddr* addr, int len, bool sort)
 {
+    if (_loop && !_loop->isCurrent()) {
+        // context可能被负载均衡分配到其他loop，切换到context所在线程处理
+        weak_ptr<GB28181Context> wSelf = shared_from_this();
+        shared_ptr<sockaddr_storage> peerAddr;
+        if (addr) {
+            peerAddr = make_shared<sockaddr_storage>();
+            memcpy(peerAddr.get(), addr, std::min((size_t)len, sizeof(sockaddr_storage)));
+        }
+        _loop->async([wSelf, rtp, peerAddr, len, sort](){
+            auto self = wSelf.lock();
+            if (self) {
+                self->onRtpPacket(rtp, (struct sockaddr*)peerAddr.get(), len, sort);
+            }
+        }, true);
+
+        return ;
+    }
+
     if (rtp->getHeader()->version != 2) {
         logInfo << "version is invalid: " << (int)rtp->getHeader()->version;
         return ;
@@ -216,7 +243,8 @@ void GB28181Context::onRtpPacket(const RtpPacket::Ptr& rtp, struct sockaddr* add
     rtp->trackIndex_ = 0;
     
     if (sort && _sort) {
-        _sort->onRtpPacket(rtp);
+        // udp才需要重排
+        _sort->inputRtp(rtp);
     } else {
         if (rtp->getHeader()->pt == 104 || rtp->getHeader()->pt == 8 || rtp->getHeader()->pt == 0) {
             rtp->trackIndex_ = AudioTrackType;
@@ -244,6 +272,16 @@ void GB28181Context::heartbeat()
         logInfo << "timeout: " << timeout;
     }, "GB28181", "Server", "timeout");
 
+    if (_sort) {
+        auto& stats = _sort->getStatistics();
+        if (stats.lost > _lastRtpLost) {
+            logInfo << "rtp loss, uri: " << _uri << ", received: " << stats.received
+                    << ", lost: " << stats.lost << ", reordered: " << stats.reordered
+                    << ", late: " << stats.late << ", duplicate: " << stats.duplicate;
+            _lastRtpLost = stats.lost;
+        }
+    }
+
     if (_timeClock.startToNow() > timeout) {
         logInfo << "alive is false";
         _alive = false;
@@ -35,6 +35,7 @@ public:
 private:
     bool _alive = true;
     int64_t _ssrc = -1;
+    uint64_t _lastRtpLost = 0;
     string _uri;
     string _vhost;
     string _protocol;
@@ -20,7 +20,7 @@ GB28181DecodeTrack::GB28181DecodeTrack(int trackIndex)
     :_index(trackIndex)
 {
     _trackInfo = make_shared<TrackInfo>();
-    _trackInfo->codec_ = "ps";
+    _trackInfo->codec_ = CodecPS;
     _trackInfo->index_ = 0;
     _trackInfo->samplerate_ = 90000;
 
@@ -139,7 +139,7 @@ void GB28181DecodeTrack::onFrame(const FrameBuffer::Ptr& frame)
 {
     // logInfo << "get a raw frame: " << frame->_codec;
     if (!_isPs) {
-        if (_trackInfo->codec_ == "h265") {
+        if (_trackInfo->codec_ == CodecH265) {
             auto h265frame = dynamic_pointer_cast<H265Frame>(frame);
             h265frame->split([this, h265frame](const FrameBuffer::Ptr &subFrame){
                 // if (_firstVps || _firstSps || _firstPps) {
@@ -173,7 +173,7 @@ void GB28181DecodeTrack::onFrame(const FrameBuffer::Ptr& frame)
                     _onFrame(subFrame);
                 }
             });
-        } else if (_trackInfo->codec_ == "h264") {
+        } else if (_trackInfo->codec_ == CodecH264) {
             auto h264frame = dynamic_pointer_cast<H264Frame>(frame);
             h264frame->split([this, h264frame](const FrameBuffer::Ptr &subFrame){
                 // if (_firstSps || _firstPps) {
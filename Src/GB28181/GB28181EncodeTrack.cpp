@@ -18,7 +18,7 @@ GB28181EncodeTrack::GB28181EncodeTrack(int trackIndex)
 {
     logInfo << "GB28181EncodeTrack::GB28181EncodeTrack";
     _trackInfo = make_shared<TrackInfo>();
-    _trackInfo->codec_ = "ps";
+    _trackInfo->codec_ = CodecPS;
     _trackInfo->index_ = 0;
     _trackInfo->samplerate_ = 90000;
     _trackInfo->ssrc_ = _trackInfo->index_;
@@ -56,7 +56,7 @@ void GB28181EncodeTrack::onFrame(const FrameBuffer::Ptr& frame)
     if (_muxer) {
         logInfo << "ps mux a frame";
         // if (frame->keyFrame()) {
-        //     if (_mapTrackInfo[frame->_index]->codec_ == "h264") {
+        //     if (_mapTrackInfo[frame->_index]->codec_ == CodecH264) {
         //         auto trackinfo = dynamic_pointer_cast<H264Track>(_mapTrackInfo[frame->_index]);
         //         trackinfo->_sps->_dts = frame->_dts;
         //         trackinfo->_sps->_pts = frame->_pts;
@@ -67,7 +67,7 @@ void GB28181EncodeTrack::onFrame(const FrameBuffer::Ptr& frame)
         //         trackinfo->_pps->_pts = frame->_pts;
         //         trackinfo->_pps->_index = frame->_index;
         //         _muxer->onFrame(trackinfo->_pps);
-        //     } else if (_mapTrackInfo[frame->_index]->codec_ == "h265") {
+        //     } else if (_mapTrackInfo[frame->_index]->codec_ == CodecH265) {
         //         auto trackinfo = dynamic_pointer_cast<H265Track>(_mapTrackInfo[frame->_index]);
         //         trackinfo->_vps->_dts = frame->_dts;
         //         trackinfo->_vps->_pts = frame->_pts;
@@ -1,11 +1,10 @@
 ﻿#include "GB28181Manager.h"
 #include "Logger.h"
+#include "EventPoller/EventLoopPool.h"
 #include "Common/Define.h"
 
 using namespace std;
 
-static thread_local unordered_map<uint32_t, GB28181Context::Wptr> _mapContextPerThread;
-
 GB28181Manager::GB28181Manager()
 {}
 
@@ -39,81 +38,52 @@ void GB28181Manager::init(const EventLoop::Ptr& loop)
 void GB28181Manager::onRtpPacket(const RtpPacket::Ptr& rtp, struct sockaddr* addr, int len)
 {
     auto ssrc = rtp->getSSRC();
-    auto iter = _mapContextPerThread.find(ssrc);
-    if (iter != _mapContextPerThread.end())
-    {
-        auto context = iter->second.lock();
-        if (context) {
-            if (context->isAlive()) {
-                context->onRtpPacket(rtp, addr, len, true);
-            } else {
-                auto key = iter->first;
-                _mapContextPerThread.erase(iter);
-                lock_guard<mutex> loc(_contextLck);
-                _mapContext.erase(key);
-            }
-            return ;
+    auto context = _mapContext.find(ssrc);
+    if (context) {
+        if (context->isAlive()) {
+            context->onRtpPacket(rtp, addr, len, true);
         } else {
-            _mapContextPerThread.erase(iter);
-        }
-    }
-
-    {
-        lock_guard<mutex> lock(_contextLck);
-        auto iterAll = _mapContext.find(ssrc);
-        if (iterAll != _mapContext.end())
-        {
-            auto context = iterAll->second;
-            if (context->isAlive()) {
-                context->onRtpPacket(rtp, addr, len, true);
-                _mapContextPerThread[ssrc] = context;
-            } else {
-                _mapContext.erase(iterAll);
-            }
-            return ;
+            _mapContext.erase(ssrc);
         }
+        return ;
     }
 
     string uri = "/live/" + to_string(ssrc);
-    auto context = make_shared<GB28181Context>(EventLoop::getCurrentLoop(), uri, 
+    // 按负载均衡策略选择context所在loop，不在当前loop时，context内部会切换线程处理
+    auto loop = EventLoopPool::instance()->getLoopForSession(EventLoop::getCurrentLoop());
+    context = make_shared<GB28181Context>(loop, uri, 
                                         DEFAULT_VHOST, PROTOCOL_GB28181, DEFAULT_TYPE);
 
     if (!context->init()) {
         return ;
     }
+    // 其他线程可能同时创建了同一个ssrc的context，以先插入的为准
+    auto exist = _mapContext.emplace(ssrc, context);
+    if (exist != context) {
+        exist->onRtpPacket(rtp, addr, len, true);
+        return ;
+    }
+    logInfo << "add context, ssrc: " << ssrc;
     context->onRtpPacket(rtp, addr, len, true);
-    logInfo << "_mapContextPerThread, ssrc: " << ssrc;
-    _mapContextPerThread[ssrc] = context;
-    lock_guard<mutex> lock(_contextLck);
-    _mapContext[ssrc] = context;
-
 }
 
 void GB28181Manager::heartbeat()
 {
-    for (auto iter = _mapContextPerThread.begin(); iter != _mapContextPerThread.end();) {
-        auto context = iter->second.lock();
-        if (!context || !context->isAlive()) {
-            logInfo << "_mapContextPerThread.erase, ssrc: " << iter->first;
-            auto ssrc = iter->first;
-            iter = _mapContextPerThread.erase(iter);
-            lock_guard<mutex> lock(_contextLck);
-            _mapContext.erase(ssrc);
-        } else {
-            ++iter;
+    _mapContext.eraseIf([](uint32_t ssrc, const GB28181Context::Ptr& context){
+        if (context->isAlive()) {
+            return false;
         }
-    }
+        logInfo << "del context, ssrc: " << ssrc;
+        return true;
+    });
 }
 
 void GB28181Manager::addContext(uint32_t ssrc, const GB28181Context::Ptr& context)
 {
-    lock_guard<mutex> lock(_contextLck);
-    _mapContext[ssrc] = context;
+    _mapContext.set(ssrc, context);
 }
 
 void GB28181Manager::delContext(uint32_t ssrc)
 {
-    lock_guard<mutex> lock(_contextLck);
     _mapContext.erase(ssrc);
 }
-
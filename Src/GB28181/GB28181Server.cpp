@@ -4,6 +4,7 @@
 #include "Rtp/RtpConnection.h"
 #include "Rtp/RtpConnectionSend.h"
 #include "Rtp/RtpManager.h"
+#include "Common/Config.h"
 
 using namespace std;
 
@@ -120,6 +121,15 @@ void GB28181Server::start(const string& ip, int port, int count, int sockType)
                 logInfo << "bind udp failed, port: " << port;
                 return ;
             }
+            // 每个loop一个socket绑定同一端口，开启后内核按ssrc(rtp头偏移8)分发，同一路流固定在一个loop上
+            // 不开启时内核按四元组分发，同一个发送端本来就固定在一个loop上
+            // balancePolicy为1时上下文可能放在其他loop，收包loop只负责转发，分发方式只影响收包这一跳
+            static bool reuseportSteering = Config::instance()->getAndListen([](const json& config){
+                reuseportSteering = config["Rtp"]["reuseportSteering"];
+            }, "Rtp", "reuseportSteering");
+            if (reuseportSteering) {
+                socket->setReusePortSteering(8, EventLoopPool::instance()->getThreadSize());
+            }
             socket->addToEpoll();
             static auto gbManager = RtpManager::instance();
             gbManager->init(loop);
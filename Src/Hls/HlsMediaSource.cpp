@@ -92,6 +92,15 @@ string HlsMediaSource::getM3u8(void* key)
     return "";
 }
     
+int HlsMediaSource::addPlayer(void* key)
+{
+    if (_hlsMuxer) {
+        return _hlsMuxer->addPlayer(key);
+    }
+
+    return 0;
+}
+
 FrameBuffer::Ptr HlsMediaSource::getTsBuffer(const string& key)
 {
     if (_hlsMuxer) {
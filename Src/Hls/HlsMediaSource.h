@@ -29,6 +29,7 @@ public:
     int playerCount() override;
 
     string getM3u8(void* key);
+    int addPlayer(void* key);
     FrameBuffer::Ptr getTsBuffer(const string& key);
     void onHlsReady();
 
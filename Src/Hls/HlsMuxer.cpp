@@ -6,6 +6,7 @@
 #include "HlsManager.h"
 #include "EventPoller/EventLoop.h"
 #include "Log/Logger.h"
+#include "Common/VariantManager.h"
 // #include "Codec/AacTrack.h"
 #include "Codec/H264Track.h"
 #include "Codec/H265Track.h"
@@ -110,7 +111,7 @@ void HlsMuxer::onFrame(const FrameBuffer::Ptr& frame)
 		}
 		if (frame->keyFrame()) {
 			_hasKeyframe = true;
-            if (_mapTrackInfo[frame->_index]->codec_ == "h264") {
+            if (_mapTrackInfo[frame->_index]->codec_ == CodecH264) {
                 auto trackinfo = dynamic_pointer_cast<H264Track>(_mapTrackInfo[frame->_index]);
                 trackinfo->_sps->_dts = frame->_dts;
                 trackinfo->_sps->_pts = frame->_pts;
@@ -121,7 +122,7 @@ void HlsMuxer::onFrame(const FrameBuffer::Ptr& frame)
                 trackinfo->_pps->_pts = frame->_pts;
                 trackinfo->_pps->_index = frame->_index;
                 _tsMuxer->onFrame(trackinfo->_pps);
-            } else if (_mapTrackInfo[frame->_index]->codec_ == "h265") {
+            } else if (_mapTrackInfo[frame->_index]->codec_ == CodecH265) {
                 auto trackinfo = dynamic_pointer_cast<H265Track>(_mapTrackInfo[frame->_index]);
                 trackinfo->_vps->_dts = frame->_dts;
                 trackinfo->_vps->_pts = frame->_pts;
@@ -266,12 +267,11 @@ void HlsMuxer::updateM3u8()
 	}
 }
 
-string HlsMuxer::getM3u8(void* key)
+int HlsMuxer::addPlayer(void* key)
 {
 	int uid = getUid();
 	_playClick.update();
 
-	// HlsManager::instance()->addMuxer(uid, shared_from_this());
 	{
 		lock_guard<mutex> lck(_uidMtx);
 		HlsPlayerInfo info;
@@ -281,13 +281,30 @@ string HlsMuxer::getM3u8(void* key)
 		_mapPlayer[uid] = info;
 	}
 
+	return uid;
+}
+
+string HlsMuxer::getM3u8(void* key)
+{
+	int uid = addPlayer(key);
+	auto pos = _parse.path_.find_last_of("/");
+
 	stringstream ss;
 	ss << "#EXTM3U\n"
 	   << "#EXT-X-STREAM-INF:BANDWIDTH=1280000\n";
 	{
 		// lock_guard<mutex> lck(_tsMtx);
-		auto pos = _parse.path_.find_last_of("/");
-		ss << _parse.path_.substr(pos + 1) << ".m3u8?uid=" << uid;
+		ss << _parse.path_.substr(pos + 1) << ".m3u8?uid=" << uid << "\n";
+	}
+
+	// 转码出来的其他码率，播放器请求时重定向到带uid的二级m3u8
+	auto variants = VariantManager::instance()->getVariants(_parse.path_, _parse.vhost_);
+	for (auto& variant : variants) {
+		ss << "#EXT-X-STREAM-INF:BANDWIDTH=" << variant.bandwidth;
+		if (variant.width > 0 && variant.height > 0) {
+			ss << ",RESOLUTION=" << variant.width << "x" << variant.height;
+		}
+		ss << "\n" << variant.path.substr(variant.path.find_last_of("/") + 1) << ".m3u8?variant=1\n";
 	}
 
 	return ss.str();
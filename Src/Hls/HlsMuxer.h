@@ -49,6 +49,8 @@ public:
 
 	// 两级m3u8
 	string getM3u8(void* key);
+	// 注册一个播放者，返回二级m3u8用的uid
+	int addPlayer(void* key);
 	string getM3u8WithUid(int uid);
 	FrameBuffer::Ptr getTsBuffer(const string& key);
 
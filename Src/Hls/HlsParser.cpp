@@ -29,6 +29,12 @@ map<uint64_t, TsInfo> HlsParser::getTsList(const string &m3u8)
     int index = -1;
 
     while(getline(ss, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (line.empty()) {
+            continue;
+        }
         if (line.find("#EXTINF:") != string::npos) {
             sscanf(line.data(), "#EXTINF:%f,", &info.duration);
             _totalDuration += info.duration;
@@ -70,13 +76,23 @@ bool HlsParser::isMutilM3u8()
 
 int HlsParser::getSeq()
 {
+    // 没有EXT-X-MEDIA-SEQUENCE时第一个切片的序号为0
     if (!existHeader("#EXT-X-MEDIA-SEQUENCE")) {
-        return -1;
+        return 0;
     }
 
     return getHeader("#EXT-X-MEDIA-SEQUENCE");
 }
 
+float HlsParser::getTargetDuration()
+{
+    if (!existHeader("#EXT-X-TARGETDURATION")) {
+        return 0;
+    }
+
+    return getHeader("#EXT-X-TARGETDURATION");
+}
+
 void HlsParser::onTsInfo(const map<uint64_t, TsInfo> &tsList)
 {
     if (_onTsInfo) {
@@ -109,6 +125,9 @@ map<uint64_t, M3u8Info> HlsParser::getM3u8List(const string &m3u8)
     map<uint64_t, M3u8Info> m3u8List;
 
     getline(ss, line);
+    if (!line.empty() && line.back() == '\r') {
+        line.pop_back();
+    }
     if (line != "#EXTM3U") {
         logWarn << "it is not a m3u8";
         return m3u8List;
@@ -116,6 +135,12 @@ map<uint64_t, M3u8Info> HlsParser::getM3u8List(const string &m3u8)
 
     M3u8Info info;
     while(getline(ss, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (line.empty()) {
+            continue;
+        }
         static string streamInf = "#EXT-X-STREAM-INF:";
         if (line.find(streamInf) != string::npos) {
             _isMutilM3u8 = true;
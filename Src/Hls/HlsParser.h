@@ -38,6 +38,8 @@ public:
     bool isLive();
     bool isMutilM3u8();
     int getSeq();
+    // 单位秒，没有时返回0
+    float getTargetDuration();
     map<uint64_t, M3u8Info> getM3u8List(const string &m3u8);
 
     void onTsInfo(const map<uint64_t, TsInfo> &tsList);
@@ -88,6 +88,15 @@ string LLHlsMediaSource::getM3u8(void* key)
     return "";
 }
     
+int LLHlsMediaSource::addPlayer(void* key)
+{
+    if (_hlsMuxer) {
+        return _hlsMuxer->addPlayer(key);
+    }
+
+    return 0;
+}
+
 FrameBuffer::Ptr LLHlsMediaSource::getTsBuffer(const string& key)
 {
     if (_hlsMuxer) {
@@ -28,6 +28,7 @@ public:
     void onReady() override;
 
     string getM3u8(void* key);
+    int addPlayer(void* key);
     FrameBuffer::Ptr getTsBuffer(const string& key);
     void onHlsReady();
 
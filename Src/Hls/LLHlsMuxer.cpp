@@ -7,6 +7,7 @@
 #include "LLHlsManager.h"
 #include "EventPoller/EventLoop.h"
 #include "Log/Logger.h"
+#include "Common/VariantManager.h"
 // #include "Codec/AacTrack.h"
 #include "Codec/H264Track.h"
 #include "Codec/H265Track.h"
@@ -128,7 +129,7 @@ void LLHlsMuxer::onFrame(const FrameBuffer::Ptr& frame)
 		}
 		if (frame->keyFrame()) {
 			_hasKeyframe = true;
-            if (_mapTrackInfo[frame->_index]->codec_ == "h264") {
+            if (_mapTrackInfo[frame->_index]->codec_ == CodecH264) {
                 auto trackinfo = dynamic_pointer_cast<H264Track>(_mapTrackInfo[frame->_index]);
                 trackinfo->_sps->_dts = frame->_dts;
                 trackinfo->_sps->_pts = frame->_pts;
@@ -139,7 +140,7 @@ void LLHlsMuxer::onFrame(const FrameBuffer::Ptr& frame)
                 trackinfo->_pps->_pts = frame->_pts;
                 trackinfo->_pps->_index = frame->_index;
                 _fmp4Muxer->inputFrame(trackinfo->index_, trackinfo->_pps->data(), trackinfo->_pps->size(), frame->_dts, frame->_pts, true);
-            } else if (_mapTrackInfo[frame->_index]->codec_ == "h265") {
+            } else if (_mapTrackInfo[frame->_index]->codec_ == CodecH265) {
                 auto trackinfo = dynamic_pointer_cast<H265Track>(_mapTrackInfo[frame->_index]);
                 trackinfo->_vps->_dts = frame->_dts;
                 trackinfo->_vps->_pts = frame->_pts;
@@ -320,12 +321,11 @@ void LLHlsMuxer::updateM3u8()
 	}
 }
 
-string LLHlsMuxer::getM3u8(void* key)
+int LLHlsMuxer::addPlayer(void* key)
 {
 	int uid = getUid();
 	_playClick.update();
 
-	// LLHlsManager::instance()->addMuxer(uid, shared_from_this());
 	{
 		lock_guard<mutex> lck(_uidMtx);
 		LLHlsPlayerInfo info;
@@ -334,13 +334,30 @@ string LLHlsMuxer::getM3u8(void* key)
 		_mapPlayer[uid] = info;
 	}
 
+	return uid;
+}
+
+string LLHlsMuxer::getM3u8(void* key)
+{
+	int uid = addPlayer(key);
+	auto pos = _parse.path_.find_last_of("/");
+
 	stringstream ss;
 	ss << "#EXTM3U\n"
 	   << "#EXT-X-STREAM-INF:BANDWIDTH=1280000\n";
 	{
 		// lock_guard<mutex> lck(_tsMtx);
-		auto pos = _parse.path_.find_last_of("/");
-		ss << _parse.path_.substr(pos + 1) << ".ll.m3u8?uid=" << uid;
+		ss << _parse.path_.substr(pos + 1) << ".ll.m3u8?uid=" << uid << "\n";
+	}
+
+	// 转码出来的其他码率，播放器请求时重定向到带uid的二级m3u8
+	auto variants = VariantManager::instance()->getVariants(_parse.path_, _parse.vhost_);
+	for (auto& variant : variants) {
+		ss << "#EXT-X-STREAM-INF:BANDWIDTH=" << variant.bandwidth;
+		if (variant.width > 0 && variant.height > 0) {
+			ss << ",RESOLUTION=" << variant.width << "x" << variant.height;
+		}
+		ss << "\n" << variant.path.substr(variant.path.find_last_of("/") + 1) << ".ll.m3u8?variant=1\n";
 	}
 
 	return ss.str();
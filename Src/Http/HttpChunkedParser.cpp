@@ -32,7 +32,7 @@ void HttpChunkedParser::parse(const char *data, size_t len)
         len = _remainData.size();
     }
 
-    logInfo << "_contentLen: " << _contentLen 
+    logTrace << "_contentLen: " << _contentLen 
             << ", _state: " << (int)_stage
             << ", remainSize: " << (int)remainSize
             << ", len: " << (int)len;
@@ -80,13 +80,14 @@ void HttpChunkedParser::parse(const char *data, size_t len)
         if (_stage == 1) {
             auto pos = strstr(data,"\r\n");
             if(pos == nullptr){
-                logInfo << "pos == nullptr";
+                logTrace << "pos == nullptr";
                 break;
             }
             // handle request line
             string sizeStr(data, pos - data);
             sscanf(sizeStr.data(),"%X",&_contentLen);
-            logInfo << "_contentLen: " << _contentLen;
+            logTrace << "_contentLen: " << _contentLen;
+            _lastChunk = _contentLen == 0;
             _contentLen += 2;
             _stage = 2;
             data = pos + 2;
@@ -94,9 +95,11 @@ void HttpChunkedParser::parse(const char *data, size_t len)
             if (end - data < _contentLen) {
                 break;
             } else {
-                logInfo << "onHttpBody: " << (_contentLen - 2);
+                logTrace << "onHttpBody: " << (_contentLen - 2);
                 if (_contentLen > 2) {
                     onHttpBody(data, _contentLen - 2);
+                } else if (_lastChunk) {
+                    onHttpBody(nullptr, 0);
                 }
                 data += _contentLen;
                 _stage = 1;
@@ -116,7 +119,7 @@ void HttpChunkedParser::parse(const char *data, size_t len)
 
 void HttpChunkedParser::setOnHttpBody(const function<void(const char* data, int len)>& cb)
 {
-    logInfo << "setOnHttpBody";
+    logTrace << "setOnHttpBody";
     _onHttpBody = cb;
 }
 
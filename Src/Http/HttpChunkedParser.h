@@ -24,6 +24,7 @@ public:
     void parse(const char *data, size_t len);
 ;
     void onHttpBody(const char* data, int len);
+    // 收到长度为0的最后一块时回调(nullptr, 0)
     void setOnHttpBody(const function<void(const char* data, int len)>& cb);
 
 public:
@@ -37,6 +38,7 @@ public:
 
 private:
     int _stage = 1; //1:parse size; 2:parse body
+    bool _lastChunk = false;
     StringBuffer _remainData;
     function<void(const char* data, int len)> _onHttpBody;
 };
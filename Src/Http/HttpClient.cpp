@@ -137,6 +137,15 @@ void HttpClient::onConnect()
     send(ss.str());
 }
 
+void HttpClient::sendRequest(const string& url)
+{
+    logTrace << "url: " << url;
+    _urlParser.parse(url);
+    _parser.clear();
+    _parser._mapHeaders.clear();
+    HttpClient::onConnect();
+}
+
 void HttpClient::sendContent(const char* data, int len)
 {
     auto buffer = StreamBuffer::create();
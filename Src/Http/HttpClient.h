@@ -34,6 +34,8 @@ public:
     void setMethod(const string& method);
 
     int sendHeader(const string& url, int timeout);
+    // 在已经建立的长连接上发下一个请求，需要服务端支持keep-alive
+    void sendRequest(const string& url);
     void sendContent(const char* data, int len);
     void send(const string& msg);
 
@@ -34,7 +34,8 @@ void HttpClientApi::onHttpRequest()
                 return ;
             }
 
-            if (len == 0 && self->_parser._contentLen == 0) {
+            // 最后一块为(nullptr, 0)
+            if (len == 0 && (!data || self->_parser._contentLen == 0)) {
                 self->HttpClient::close();
                 self->onHttpResponce();
             }else if (self->_parser._contentLen == 0) {
@@ -151,7 +151,8 @@ ssize_t HttpConnection::send(Buffer::Ptr pkt)
         auto header = make_shared<StringBuffer>();
         _websocket.encodeHeader(frame, header);
 
-        TcpConnection::send(header);
+        // 头和负载作为两个iovec一次sendmsg发出，负载不拷贝
+        TcpConnection::send(header, false);
 
         // 因为此处不用做掩码，payload不用encode
         // if (pkt->size() > 0) {
@@ -336,6 +337,7 @@ void HttpConnection::writeHttpResponse(HttpResponse& rsp) // 将要素按照Http
         if (_parser._mapHeaders.find("sec-websocket-version") != _parser._mapHeaders.end()) {
             rsp.setHeader("Sec-WebSocket-Version", _parser._mapHeaders["sec-websocket-version"]);
         }
+        // 不回Sec-WebSocket-Extensions，媒体数据已经压缩过，permessage-deflate只会白白耗cpu
     }
     
     // 将rsp完善，按照http协议格式进行组织
@@ -911,6 +913,19 @@ void HttpConnection::onPlayHls(const HlsMediaSource::Ptr &hlsSrc)
         if (!self) {
             return ;
         }
+        // 多码率主m3u8里的子码率，直接跳到带uid的二级m3u8
+        if (_urlParser.vecParam_.find("variant") != _urlParser.vecParam_.end()) {
+            auto uid = hlsSrc->addPlayer(this);
+            auto pos = _urlParser.path_.find_last_of("/");
+
+            HttpResponse rsp;
+            rsp._status = 302;
+            rsp._redirectFlag = true;
+            rsp._redirectUrl = _urlParser.path_.substr(pos + 1) + ".m3u8?uid=" + to_string(uid);
+            self->writeHttpResponse(rsp);
+            return ;
+        }
+
         auto strM3u8 = hlsSrc->getM3u8(this);
 
         HttpResponse rsp;
@@ -1062,6 +1077,19 @@ void HttpConnection::onPlayLLHls(const LLHlsMediaSource::Ptr &hlsSrc)
         if (!self) {
             return ;
         }
+        // 多码率主m3u8里的子码率，直接跳到带uid的二级m3u8
+        if (_urlParser.vecParam_.find("variant") != _urlParser.vecParam_.end()) {
+            auto uid = hlsSrc->addPlayer(this);
+            auto pos = _urlParser.path_.find_last_of("/");
+
+            HttpResponse rsp;
+            rsp._status = 302;
+            rsp._redirectFlag = true;
+            rsp._redirectUrl = _urlParser.path_.substr(pos + 1) + ".ll.m3u8?uid=" + to_string(uid);
+            self->writeHttpResponse(rsp);
+            return ;
+        }
+
         auto strM3u8 = hlsSrc->getM3u8(this);
 
         HttpResponse rsp;
@@ -1193,6 +1221,10 @@ void HttpConnection::onPlayTs(const TsMediaSource::Ptr &tsSrc)
     if (!_playTsReader) {
 		logTrace << "set _playTsReader";
 		_playTsReader = tsSrc->getRing()->attach(EventLoop::getCurrentLoop(), true);
+		DataQueStartPolicy policy;
+		if (DataQueStartPolicy::parseParam(_urlParser.vecParam_, policy)) {
+			_playTsReader->setStartPolicy(policy);
+		}
 		_playTsReader->setGetInfoCB([wSelf]() {
 			auto self = wSelf.lock();
 			ClientInfo ret;
@@ -1305,6 +1337,10 @@ void HttpConnection::onPlayPs(const PsMediaSource::Ptr &psSrc)
     if (!_playPsReader) {
 		logTrace << "set _playPsReader";
 		_playPsReader = psSrc->getRing()->attach(EventLoop::getCurrentLoop(), true);
+		DataQueStartPolicy policy;
+		if (DataQueStartPolicy::parseParam(_urlParser.vecParam_, policy)) {
+			_playPsReader->setStartPolicy(policy);
+		}
 		_playPsReader->setGetInfoCB([wSelf]() {
 			auto self = wSelf.lock();
 			ClientInfo ret;
@@ -1421,6 +1457,10 @@ void HttpConnection::onPlayFmp4(const Fmp4MediaSource::Ptr &fmp4Src)
     if (!_playFmp4Reader) {
 		logTrace << "set _playFmp4Reader";
 		_playFmp4Reader = fmp4Src->getRing()->attach(EventLoop::getCurrentLoop(), true);
+		DataQueStartPolicy policy;
+		if (DataQueStartPolicy::parseParam(_urlParser.vecParam_, policy)) {
+			_playFmp4Reader->setStartPolicy(policy);
+		}
 		_playFmp4Reader->setGetInfoCB([wSelf]() {
 			auto self = wSelf.lock();
 			ClientInfo ret;
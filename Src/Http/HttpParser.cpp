@@ -3,6 +3,7 @@
 #include "Util/String.h"
 
 #include <algorithm>
+#include <cstdlib>
 
 using namespace std;
 
@@ -115,6 +116,10 @@ void HttpParser::parse(const char *data, size_t len)
             }
             _method = std::string(data, blank - data);
             data = blank + 1;
+            // 响应行 HTTP/1.1 200 OK，原因短语可以没有
+            if (_method.compare(0, 5, "HTTP/") == 0) {
+                _status = atoi(data);
+            }
             blank = strchr(data, ' ');
             if (!(blank > data && blank < pos)) {
                 _stage = 2;
@@ -215,6 +220,7 @@ void HttpParser::clear()
 {
     // logTrace << "HttpParser::clear() : " << this;
     _contentLen = -1;
+    _status = 0;
     _stage = 1;
     _content = "";
     // _method = "";
@@ -32,6 +32,8 @@ public:
 
 public:
     int _contentLen = -1;
+    // 响应的状态码，请求为0
+    int _status = 0;
     string _content;
     string _method;
     string _url;
@@ -100,7 +100,8 @@ void WebsocketClient::sendData(const Buffer::Ptr& buffer)
     auto header = make_shared<StringBuffer>();
     _websocket.encodeHeader(frame, header);
 
-    TcpClient::send(header);
+    // 头和负载一次sendmsg发出
+    TcpClient::send(header, false);
     TcpClient::send(buffer);
 }
 
@@ -2,8 +2,17 @@
 #include <string>
 #include <algorithm>
 #include <cctype>
+#include <cstring>
 #include <arpa/inet.h>
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define WEBSOCKET_MASK_X86
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define WEBSOCKET_MASK_NEON
+#endif
+
 #include "WebsocketContext.h"
 #include "Logger.h"
 #include "Util/String.h"
@@ -33,6 +42,136 @@ using namespace std;
  *
  */
 
+// 以下几个函数处理完整的16/32字节块，返回处理的字节数，剩下的由调用者处理
+// key是按phase转好后的4个字节按内存顺序读成的uint32，块大小都是4的倍数，处理完phase不变
+#ifdef WEBSOCKET_MASK_X86
+__attribute__((target("avx2")))
+static size_t maskAvx2(uint8_t* data, size_t len, uint32_t key)
+{
+    __m256i vkey = _mm256_set1_epi32((int)key);
+
+    size_t pos = 0;
+    for (; pos + 128 <= len; pos += 128) {
+        __m256i* p = (__m256i*)(data + pos);
+        __m256i a = _mm256_xor_si256(_mm256_loadu_si256(p), vkey);
+        __m256i b = _mm256_xor_si256(_mm256_loadu_si256(p + 1), vkey);
+        __m256i c = _mm256_xor_si256(_mm256_loadu_si256(p + 2), vkey);
+        __m256i d = _mm256_xor_si256(_mm256_loadu_si256(p + 3), vkey);
+        _mm256_storeu_si256(p, a);
+        _mm256_storeu_si256(p + 1, b);
+        _mm256_storeu_si256(p + 2, c);
+        _mm256_storeu_si256(p + 3, d);
+    }
+    for (; pos + 32 <= len; pos += 32) {
+        __m256i* p = (__m256i*)(data + pos);
+        _mm256_storeu_si256(p, _mm256_xor_si256(_mm256_loadu_si256(p), vkey));
+    }
+
+    return pos;
+}
+
+static bool supportAvx2()
+{
+    static bool avx2 = [](){
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2") != 0;
+    }();
+
+    return avx2;
+}
+#endif
+
+#ifdef __SSE2__
+static size_t maskSse2(uint8_t* data, size_t len, uint32_t key)
+{
+    __m128i vkey = _mm_set1_epi32((int)key);
+
+    size_t pos = 0;
+    for (; pos + 64 <= len; pos += 64) {
+        __m128i* p = (__m128i*)(data + pos);
+        __m128i a = _mm_xor_si128(_mm_loadu_si128(p), vkey);
+        __m128i b = _mm_xor_si128(_mm_loadu_si128(p + 1), vkey);
+        __m128i c = _mm_xor_si128(_mm_loadu_si128(p + 2), vkey);
+        __m128i d = _mm_xor_si128(_mm_loadu_si128(p + 3), vkey);
+        _mm_storeu_si128(p, a);
+        _mm_storeu_si128(p + 1, b);
+        _mm_storeu_si128(p + 2, c);
+        _mm_storeu_si128(p + 3, d);
+    }
+    for (; pos + 16 <= len; pos += 16) {
+        __m128i* p = (__m128i*)(data + pos);
+        _mm_storeu_si128(p, _mm_xor_si128(_mm_loadu_si128(p), vkey));
+    }
+
+    return pos;
+}
+#endif
+
+#ifdef WEBSOCKET_MASK_NEON
+static size_t maskNeon(uint8_t* data, size_t len, uint32_t key)
+{
+    uint8x16_t vkey = vreinterpretq_u8_u32(vdupq_n_u32(key));
+
+    size_t pos = 0;
+    for (; pos + 64 <= len; pos += 64) {
+        uint8x16_t a = veorq_u8(vld1q_u8(data + pos), vkey);
+        uint8x16_t b = veorq_u8(vld1q_u8(data + pos + 16), vkey);
+        uint8x16_t c = veorq_u8(vld1q_u8(data + pos + 32), vkey);
+        uint8x16_t d = veorq_u8(vld1q_u8(data + pos + 48), vkey);
+        vst1q_u8(data + pos, a);
+        vst1q_u8(data + pos + 16, b);
+        vst1q_u8(data + pos + 32, c);
+        vst1q_u8(data + pos + 48, d);
+    }
+    for (; pos + 16 <= len; pos += 16) {
+        vst1q_u8(data + pos, veorq_u8(vld1q_u8(data + pos), vkey));
+    }
+
+    return pos;
+}
+#endif
+
+uint32_t WebsocketContext::mask(uint8_t* data, size_t len, const uint8_t* key, uint32_t phase)
+{
+    // 把key转到当前phase，后面都从rotate[0]开始对齐
+    uint8_t rotate[8];
+    phase %= 4;
+    for (int i = 0; i < 8; ++i) {
+        rotate[i] = key[(phase + i) % 4];
+    }
+    uint32_t key32;
+    uint64_t key64;
+    memcpy(&key32, rotate, 4);
+    memcpy(&key64, rotate, 8);
+
+    size_t pos = 0;
+#ifdef WEBSOCKET_MASK_X86
+    if (len >= 128 && supportAvx2()) {
+        pos = maskAvx2(data, len, key32);
+    }
+#endif
+#ifdef __SSE2__
+    pos += maskSse2(data + pos, len - pos, key32);
+#endif
+#ifdef WEBSOCKET_MASK_NEON
+    pos += maskNeon(data + pos, len - pos, key32);
+#endif
+
+    // 剩下的按8字节处理，memcpy避免非对齐访问
+    for (; pos + 8 <= len; pos += 8) {
+        uint64_t word;
+        memcpy(&word, data + pos, 8);
+        word ^= key64;
+        memcpy(data + pos, &word, 8);
+    }
+
+    for (size_t i = 0; pos < len; ++pos, ++i) {
+        data[pos] ^= rotate[i];
+    }
+
+    return (phase + len) % 4;
+}
+
 void WebsocketContext::decode(unsigned char *data, size_t len)
 {
     // 从配置中获取
@@ -62,7 +201,7 @@ void WebsocketContext::decode(unsigned char *data, size_t len)
             }
 
             _otherHeaderSize = 0;
-            _maskIndex = 0;
+            _maskedSize = 0;
 
             _frame.finish = (data[0] >> 7) & 1;
             _frame.rsv1 = (data[0] >> 6) & 1;
@@ -115,14 +254,23 @@ void WebsocketContext::decode(unsigned char *data, size_t len)
         }
 
         // logInfo << "payloadSize: " << _frame.payloadLen << ", len: " << len << ", used : " << (data - start);
+        // 收到多少解多少，没收齐的部分连同已经解过的字节一起留在_remainData里
+        len = end - data;
+        if (_frame.mask) {
+            uint64_t arrived = min((uint64_t)len, _frame.payloadLen);
+            if (arrived > _maskedSize) {
+                mask(data + _maskedSize, arrived - _maskedSize, (uint8_t*)_frame.maskKey.data(), _maskedSize % 4);
+                _maskedSize = arrived;
+            }
+        }
+
         if (len >= _frame.payloadLen) {
-            if (_frame.mask) {
-                for(int i = 0; i < _frame.payloadLen ; ++i){
-                    data[i] ^= _frame.maskKey[_maskIndex++ % 4];
-                }
-                _maskIndex %= 4;
+            if (_frame.rsv1) {
+                // 媒体数据本身已经压缩过，握手时不协商permessage-deflate
+                logWarn << "permessage-deflate is not negotiated, drop frame, size: " << _frame.payloadLen;
+            } else {
+                onWebsocketFrame((char*)data, _frame.payloadLen);
             }
-            onWebsocketFrame((char*)data, _frame.payloadLen);
             // static int i = 0;
             // string name = "test" + to_string(i++);
             // FILE* fp = fopen(name.data(), "wb");
@@ -146,36 +294,41 @@ void WebsocketContext::decode(unsigned char *data, size_t len)
 
 void WebsocketContext::encodeHeader(const WebsocketFrame& frame, StringBuffer::Ptr& header)
 {
-    // StringBuffer packet;
-    uint8_t one = (frame.finish << 7) | (frame.rsv1 << 6) | (frame.rsv2 << 5) 
+    // 头最长14字节，先在栈上拼好再一次写进header
+    uint8_t buf[14];
+    int size = 0;
+    buf[size++] = (frame.finish << 7) | (frame.rsv1 << 6) | (frame.rsv2 << 5) 
                     | (frame.rsv3 << 4) | (frame.opcode & 0xf);
 
-    header->push_back(one);
-
     auto maskFlag = frame.mask && !frame.maskKey.empty();
-    one = maskFlag << 7;
+    uint8_t one = maskFlag << 7;
     uint64_t len = frame.payloadLen;
 
     if (len < 126) {
-        header->push_back(len | one);
+        buf[size++] = len | one;
     } else if (len <= 0xffff) {
-        header->push_back(one | 126);
+        buf[size++] = one | 126;
 
         auto len_low = htons(len);
-        header->append((char *)&len_low, 2);
+        memcpy(buf + size, &len_low, 2);
+        size += 2;
     } else {
-        header->push_back(one | 127);
+        buf[size++] = one | 127;
 
         uint32_t len_low = htonl(len >> 32);
-        header->append((char *)&len_low, 4);
+        memcpy(buf + size, &len_low, 4);
         
         len_low = htonl(len & 0xFFFFFFFF);
-        header->append((char *)&len_low, 4);
+        memcpy(buf + size + 4, &len_low, 4);
+        size += 8;
     }
 
     if (maskFlag) {
-        header->append(frame.maskKey.data(), 4);
+        memcpy(buf + size, frame.maskKey.data(), 4);
+        size += 4;
     }
+
+    header->append((char*)buf, size);
 }
 
 void WebsocketContext::encodePayload(const WebsocketFrame& frame, Buffer::Ptr& payload)
@@ -186,10 +339,7 @@ void WebsocketContext::encodePayload(const WebsocketFrame& frame, Buffer::Ptr& p
     }
 
     if (frame.mask && !frame.maskKey.empty()) {
-        uint8_t *ptr = (uint8_t*)payload->data();
-        for(int i = 0; i < len ; ++i,++ptr){
-            *(ptr) ^= frame.maskKey[i % 4];
-        }
+        mask((uint8_t*)payload->data(), len, (uint8_t*)frame.maskKey.data());
     }
 }
 
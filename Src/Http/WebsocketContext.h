@@ -71,6 +71,12 @@ public:
 class WebsocketContext
 {
 public:
+    // 按key对data做掩码(异或)，phase为这一帧已经处理过的字节数%4，返回处理完后的phase
+    // x86按cpu支持用avx2/sse2，arm用neon，其他平台按8字节处理
+    static uint32_t mask(uint8_t* data, size_t len, const uint8_t* key, uint32_t phase = 0);
+
+    // 收到的负载边到边解掩码，不完整的帧留在_remainData里，等收齐后回调
+    // 没有协商permessage-deflate，rsv1置位的帧直接丢掉
     void decode(unsigned char *data, size_t len);
     void encodeHeader(const WebsocketFrame& frame, StringBuffer::Ptr& header);
     void encodePayload(const WebsocketFrame& frame, Buffer::Ptr& payload);
@@ -84,7 +90,8 @@ public:
 private:
     int _stage = 1; //1:header 2 byte, 2:header other, 3:payload
     int _otherHeaderSize = 0;
-    uint32_t _maskIndex = 0;
+    // 当前帧已经解掩码的负载字节数
+    uint64_t _maskedSize = 0;
     StringBuffer _remainData;
     function<void(const char* data, int len)> _onWebsocketFrame;
 };
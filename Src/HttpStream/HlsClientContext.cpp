@@ -22,6 +22,13 @@ HlsClientContext::~HlsClientContext()
     if (_timeTask) {
         _timeTask->quit = true;
     }
+
+    for (auto& client : _tsClients) {
+        client->close();
+    }
+    if (_m3u8Client) {
+        _m3u8Client->close();
+    }
 }
 
 bool HlsClientContext::start(const string& localIp, int localPort, const string& url, int timeout)
@@ -35,12 +42,12 @@ bool HlsClientContext::start(const string& localIp, int localPort, const string&
     weak_ptr<HlsClientContext> wSelf = shared_from_this();
 
     _tsDemuxer.setOnDecode([wSelf](const FrameBuffer::Ptr &frame){
-        logInfo << "decode a frame";
         auto self = wSelf.lock();
         if (!self) {
             return ;
         }
 
+        ++self->_frameCount;
         if (self->_frameList.size() == 0) {
             self->_lastPts = frame->pts();
             self->_frameList.emplace(self->_lastPlayStamp, frame);
@@ -93,11 +100,6 @@ bool HlsClientContext::start(const string& localIp, int localPort, const string&
             return 0;
         }
 
-        // TODO 
-        // 1.检查ts队列，是否有ts要解析
-        // 2.检查帧列表，队列较小时，下载ts解析（队列小于下一个要播的ts时长时，下载？或者取10秒和下一个ts时长的较大值）
-
-        logInfo << "start to play";
         self->onPlay();
 
         return 100;
@@ -110,44 +112,186 @@ bool HlsClientContext::start(const string& localIp, int localPort, const string&
         }
     });
 
-    _hlsClient = make_shared<HttpHlsClient>();
-    _hlsClient->start(localIp, localPort, url, timeout);
-    _hlsClient->setOnHttpResponce([wSelf](const HttpParser &parser){
+    _aliveClock.start();
+    loadPlaylist();
+
+    return true;
+}
+
+void HlsClientContext::loadPlaylist()
+{
+    if (_stopped) {
+        return ;
+    }
+
+    if (_m3u8Client && !_m3u8Client->isClosed() && !_m3u8Client->isIdle()) {
+        // 上一次请求还没结束
+        return ;
+    }
+
+    if (!_m3u8Client || !_m3u8Client->isIdle() || _m3u8Client->getOrigin() != HttpHlsTsClient::getOrigin(_m3u8)) {
+        if (_m3u8Client) {
+            _m3u8Client->close();
+        }
+        _m3u8Client = make_shared<HttpHlsTsClient>(_loop, _m3u8.find("https://") == 0);
+        ++_connectionCount;
+    }
+
+    weak_ptr<HlsClientContext> wSelf = shared_from_this();
+    _playlist.clear();
+    _m3u8Client->setOnTsPacket([wSelf](const char* data, int len){
+        auto self = wSelf.lock();
+        if (self) {
+            self->_playlist.append(data, len);
+        }
+    });
+    _m3u8Client->setOnResponse([wSelf](bool ok){
         auto self = wSelf.lock();
         if (!self) {
             return ;
         }
 
-        auto m3u8List = self->_hlsClient->_hlsParser->getM3u8List(self->_hlsClient->_m3u8);
-        if (m3u8List.size() == 0) {
+        string m3u8 = std::move(self->_playlist);
+        self->_playlist.clear();
+        if (!ok) {
+            logWarn << "get m3u8 failed: " << self->_m3u8;
+            self->scheduleRefresh(self->_targetDuration > 0 ? self->_targetDuration * 500 : 1000);
             return ;
         }
+        self->onPlaylist(m3u8);
+    });
 
-        if (self->_hlsClient->_hlsParser->isMutilM3u8()) {
-            // 获取第一个m3u8，可以调整策略
-            self->_m3u8 = m3u8List.begin()->second.url;
-            self->getM3u8();
-        } else {
-            self->putTsList();
-            self->_playClock.start();
-            self->startPlay();
-            // 定时获取m3u8，一次性定时器，获取完后，再继续创建一次性定时器
-            // 定时时间用ts列表里的ts的最短时长
-
-            // if (self->_tsList.size() > 0) {
-            //     _loop->addTimerTask(self->_tsList.begin()->second.duration * 1000, [wSelf](){
-            //         auto self = wSelf.lock();
-            //         if (!self) {
-            //             return 0;
-            //         }
-
-            //         self->getM3u8Inner();
-
-            //         return 0;
-            //     }, nullptr);
-            // }
+    logDebug << "get m3u8: " << _m3u8;
+    _m3u8Client->start(_m3u8, _timeout);
+}
+
+void HlsClientContext::scheduleRefresh(int ms)
+{
+    if (_stopped || _refreshScheduled) {
+        return ;
+    }
+
+    _refreshScheduled = true;
+    weak_ptr<HlsClientContext> wSelf = shared_from_this();
+    _loop->addTimerTask(ms, [wSelf](){
+        auto self = wSelf.lock();
+        if (!self) {
+            return 0;
         }
-    });
+
+        self->_refreshScheduled = false;
+        self->loadPlaylist();
+
+        return 0;
+    }, nullptr);
+}
+
+void HlsClientContext::onPlaylist(const string& m3u8)
+{
+    ++_playlistCount;
+
+    HlsParser parser;
+    auto m3u8List = parser.getM3u8List(m3u8);
+    if (m3u8List.size() == 0) {
+        logWarn << "invalid m3u8: " << _m3u8;
+        scheduleRefresh(_targetDuration > 0 ? _targetDuration * 500 : 1000);
+        return ;
+    }
+
+    if (parser.isMutilM3u8()) {
+        _variants.clear();
+        for (auto& iter : m3u8List) {
+            auto info = iter.second;
+            info.url = getAbsoluteUrl(_m3u8, info.url);
+            _variants.emplace(iter.first, info);
+        }
+        chooseVariant();
+        loadPlaylist();
+
+        return ;
+    }
+
+    onMediaPlaylist(parser, m3u8);
+}
+
+void HlsClientContext::onMediaPlaylist(HlsParser& parser, const string& m3u8)
+{
+    auto tsList = parser.getTsList(m3u8);
+    _live = parser.isLive();
+    _targetDuration = parser.getTargetDuration();
+    if (_targetDuration <= 0 && tsList.size() > 0) {
+        _targetDuration = tsList.begin()->second.duration;
+    }
+
+    bool changed = m3u8 != _lastPlaylist;
+    _lastPlaylist = m3u8;
+
+    // 直播从倒数第三个切片开始
+    if (_lastSeq < 0 && _live && tsList.size() > 3) {
+        auto iter = tsList.end();
+        advance(iter, -3);
+        _lastSeq = (int64_t)iter->first - 1;
+    }
+
+    for (auto& ts : tsList) {
+        auto url = getAbsoluteUrl(_m3u8, ts.second.url);
+        if ((int64_t)ts.first <= _lastSeq) {
+            // 切换码率后，还没开始下载的切片换成新码率的地址
+            auto iter = _segments.find(ts.first);
+            if (iter != _segments.end() && iter->second->state == HlsSegment::Pending) {
+                iter->second->url = url;
+            }
+            continue;
+        }
+
+        auto segment = make_shared<HlsSegment>();
+        segment->seq = ts.first;
+        segment->duration = ts.second.duration;
+        segment->url = url;
+        _segments.emplace(ts.first, segment);
+        _lastSeq = ts.first;
+    }
+
+    if (!_playlistLoaded) {
+        _playlistLoaded = true;
+        _playClock.start();
+        startPlay();
+    }
+
+    if (_live) {
+        // m3u8没有变化时，等半个targetDuration再刷新
+        float interval = _targetDuration > 0 ? _targetDuration : 1;
+        scheduleRefresh(changed ? interval * 1000 : interval * 500);
+    }
+
+    fetchSegments();
+}
+
+bool HlsClientContext::chooseVariant()
+{
+    static float bandwidthRatio = Config::instance()->getAndListen([](const json &config){
+        bandwidthRatio = Config::instance()->get("Hls", "Client", "bandwidthRatio");
+    }, "Hls", "Client", "bandwidthRatio", "", "0.8");
+
+    if (_variants.empty()) {
+        return false;
+    }
+
+    // 没有测出带宽时用最低码率，之后选带宽够用的最高码率
+    auto chosen = _variants.begin();
+    for (auto iter = _variants.begin(); iter != _variants.end(); ++iter) {
+        if (iter->first <= _bandwidth * bandwidthRatio) {
+            chosen = iter;
+        }
+    }
+
+    if (chosen->second.url == _m3u8) {
+        return false;
+    }
+
+    logInfo << "switch variant, bandwidth: " << chosen->first << ", measured: " << _bandwidth << ", url: " << chosen->second.url;
+    _variantBandwidth = chosen->first;
+    _m3u8 = chosen->second.url;
 
     return true;
 }
@@ -182,20 +326,26 @@ void HlsClientContext::onPlay()
 {
     auto frameSrc = _source.lock();
     if (!frameSrc) {
-        logInfo << "src is not exist";
         return ;
     }
-    if (_frameList.size() == 0) {
-        downloadTs();
-    } else if (_frameList.end()->first - _frameList.begin()->first < 5 * 1000) {
-        downloadTs();
+
+    // 长时间没有收到数据的请求断开重试
+    uint64_t now = TimeClock::now();
+    for (auto& iter : _segments) {
+        auto segment = iter.second;
+        auto client = segment->client.lock();
+        if (segment->state == HlsSegment::Fetching && client && now - segment->lastRecvTime > (uint64_t)_timeout * 1000) {
+            logWarn << "download ts timeout: " << segment->url;
+            client->close();
+            break;
+        }
     }
 
+    fetchSegments();
+
     for (auto it = _frameList.begin(); it != _frameList.end();) {
-        logInfo << "it->first: " << it->first << ", _playClock.startToNow(): " << _playClock.startToNow();
         if (it->first < _playClock.startToNow()) {
             _aliveClock.update();
-            logInfo << "input a frame, index: " << it->second->getTrackIndex() << ", time: " << it->second->pts();
             frameSrc->onFrame(it->second);
             it = _frameList.erase(it);
         } else {
@@ -203,159 +353,280 @@ void HlsClientContext::onPlay()
         }
     }
 
-    logInfo << "frame list size: " << _frameList.size();
-    if (_frameList.size() == 0 && _tsList.size() == 0 && _aliveClock.startToNow() > 10 * 1000) {
+    if (_frameList.size() == 0 && _segments.size() == 0 && _aliveClock.startToNow() > 10 * 1000) {
         stop();
     }
 }
 
-void HlsClientContext::downloadTs()
+void HlsClientContext::fetchSegments()
 {
-    if (_tsList.size() == 0) {
+    static int prefetchNum = Config::instance()->getAndListen([](const json &config){
+        prefetchNum = Config::instance()->get("Hls", "Client", "prefetchNum");
+    }, "Hls", "Client", "prefetchNum", "", "3");
+
+    static int bufferMs = Config::instance()->getAndListen([](const json &config){
+        bufferMs = Config::instance()->get("Hls", "Client", "bufferMs");
+    }, "Hls", "Client", "bufferMs", "", "10000");
+
+    if (_stopped) {
         return ;
     }
 
+    // 回调里可能会改_segments，先取出来
+    vector<HlsSegment::Ptr> pending;
+    for (auto& iter : _segments) {
+        if (iter.second->state == HlsSegment::Pending) {
+            pending.push_back(iter.second);
+        }
+    }
+
     weak_ptr<HlsClientContext> wSelf = shared_from_this();
+    for (auto& segment : pending) {
+        if (_fetchingCount >= max(prefetchNum, 1) || getBufferedMs() >= (uint64_t)bufferMs) {
+            break;
+        }
+        if (segment->state != HlsSegment::Pending) {
+            continue;
+        }
 
-    auto iter = _tsList.begin();
-    auto url = iter->second.url;
-    _preTsIndex = iter->first;
-    _tsList.erase(iter);
-    auto httppos = url.find("http://");
-    auto httpspos = url.find("https://");
-    if (httppos != 0 && httpspos != 0) {
-        if (url.find("/") == 0) {
-            url = _originUrl.substr(0, _originUrl.find("/", 8)) + url;
+        auto client = getIdleClient(segment->url);
+        if (!client) {
+            break;
+        }
+
+        uint64_t now = TimeClock::now();
+        if (_fetchingCount == 0) {
+            // 没有下载时的空闲时间不算进带宽
+            _sampleTime = now;
+            _sampleBytes = _recvBytes;
+        }
+        ++_fetchingCount;
+        segment->state = HlsSegment::Fetching;
+        segment->bytes = 0;
+        segment->lastRecvTime = now;
+        segment->cache.clear();
+        segment->client = client;
+
+        client->setOnTsPacket([wSelf, segment](const char* data, int len){
+            auto self = wSelf.lock();
+            if (self) {
+                self->onSegmentData(segment, data, len);
+            }
+        });
+        client->setOnResponse([wSelf, segment](bool ok){
+            auto self = wSelf.lock();
+            if (self) {
+                self->onSegmentDone(segment, ok);
+            }
+        });
+        logTrace << "download ts: " << segment->url;
+        client->start(segment->url, _timeout);
+    }
+}
+
+HttpHlsTsClient::Ptr HlsClientContext::getIdleClient(const string& url)
+{
+    static int prefetchNum = Config::instance()->getAndListen([](const json &config){
+        prefetchNum = Config::instance()->get("Hls", "Client", "prefetchNum");
+    }, "Hls", "Client", "prefetchNum", "", "3");
+
+    auto origin = HttpHlsTsClient::getOrigin(url);
+    for (auto iter = _tsClients.begin(); iter != _tsClients.end();) {
+        if ((*iter)->isClosed()) {
+            iter = _tsClients.erase(iter);
         } else {
-            url = _originUrl.substr(0, _originUrl.rfind("/") + 1) + url;
+            ++iter;
         }
     }
 
-    logInfo << "ts url: " << url
-            << ", _originUrl: " << _originUrl
-            << ", http pos: " << httppos
-            << ", https pos: " << httpspos;
+    for (auto& client : _tsClients) {
+        if (client->isIdle() && client->getOrigin() == origin) {
+            return client;
+        }
+    }
 
-    _tsClient = make_shared<HttpHlsTsClient>();
-    _tsClient->setOnTsPacket([wSelf](const char *data, int len){
-        auto self = wSelf.lock();
-        if (!self) {
-            return ;
+    if (_tsClients.size() >= (size_t)max(prefetchNum, 1)) {
+        // 连接数满了，关掉一个空闲的不同源连接
+        HttpHlsTsClient::Ptr idle;
+        for (auto& client : _tsClients) {
+            if (client->isIdle()) {
+                idle = client;
+                break;
+            }
         }
+        if (!idle) {
+            return nullptr;
+        }
+        idle->close();
+        _tsClients.erase(find(_tsClients.begin(), _tsClients.end(), idle));
+    }
 
-        logInfo << "start to demuxer ts packet";
-        self->_tsDemuxer.onTsPacket((char*)data, len, 0);
-    });
-    _tsClient->start(_localIp, _localPort, url, _timeout);
+    auto client = make_shared<HttpHlsTsClient>(_loop, url.find("https://") == 0);
+    _tsClients.push_back(client);
+    ++_connectionCount;
+
+    return client;
 }
 
-void HlsClientContext::stop()
+void HlsClientContext::onSegmentData(const HlsSegment::Ptr& segment, const char* data, int len)
 {
-    if (_onClose) {
-        _onClose();
+    _recvBytes += len;
+    segment->bytes += len;
+    segment->lastRecvTime = TimeClock::now();
+
+    // 前面的切片都送完了，直接送进解复用器
+    if (_segments.size() > 0 && _segments.begin()->second == segment) {
+        segment->fed = true;
+        _tsDemuxer.onTsPacket((char*)data, len, 0);
+    } else {
+        segment->cache.append(data, len);
     }
 }
 
-void HlsClientContext::pause()
+void HlsClientContext::onSegmentDone(const HlsSegment::Ptr& segment, bool ok)
 {
+    static int maxRetry = Config::instance()->getAndListen([](const json &config){
+        maxRetry = Config::instance()->get("Hls", "Client", "maxRetry");
+    }, "Hls", "Client", "maxRetry", "", "2");
+
+    if (segment->state != HlsSegment::Fetching) {
+        return ;
+    }
+
+    --_fetchingCount;
+    segment->client.reset();
+    if (ok) {
+        segment->state = HlsSegment::Done;
+        ++_segmentCount;
+        updateBandwidth();
+    } else if (!segment->fed && segment->retry < maxRetry) {
+        // 等下一次定时器再重试
+        logWarn << "download ts failed, retry: " << segment->url;
+        ++segment->retry;
+        segment->state = HlsSegment::Pending;
+        segment->cache.clear();
+    } else {
+        logWarn << "download ts failed, skip it: " << segment->url;
+        segment->state = HlsSegment::Done;
+    }
 
+    feedSegments();
+    if (ok) {
+        fetchSegments();
+    }
 }
 
-void HlsClientContext::setOnClose(const function<void()>& cb)
+void HlsClientContext::feedSegments()
 {
-    _onClose = cb;
+    while (_segments.size() > 0) {
+        auto segment = _segments.begin()->second;
+        if (segment->cache.size() > 0) {
+            segment->fed = true;
+            _tsDemuxer.onTsPacket(segment->cache.data(), segment->cache.size(), 0);
+            segment->cache.clear();
+        }
+        if (segment->state != HlsSegment::Done) {
+            break;
+        }
+        _segments.erase(_segments.begin());
+    }
 }
 
-string HlsClientContext::getM3u8()
+void HlsClientContext::updateBandwidth()
 {
-    logInfo << "get M3u8: " << _m3u8;
-    auto httppos = _m3u8.find("http://");
-    auto httpspos = _m3u8.find("https://");
-    if (httppos != 0 && httpspos != 0) {
-        if (_m3u8.find("/") == 0) {
-            _m3u8 = _originUrl.substr(0, _originUrl.find("/", 8)) + _m3u8;
-        } else {
-            _m3u8 = _originUrl.substr(0, _originUrl.rfind("/") + 1) + _m3u8;
-        }
+    uint64_t now = TimeClock::now();
+    uint64_t bytes = _recvBytes - _sampleBytes;
+    uint64_t ms = now - _sampleTime;
+    if (bytes == 0) {
+        return ;
+    }
+    if (ms == 0) {
+        ms = 1;
     }
 
-    logInfo << "ts url: " << _originUrl
-            << ", _m3u8: " << _m3u8
-            << ", http pos: " << httppos
-            << ", https pos: " << httpspos;
-            
-    weak_ptr<HlsClientContext> wSelf = shared_from_this();
-    
-    _hlsClient = make_shared<HttpHlsClient>();
-    _hlsClient->start(_localIp, _localPort, _m3u8, _timeout);
-    _hlsClient->setOnHttpResponce([wSelf](const HttpParser &parser){
-        auto self = wSelf.lock();
-        if (!self) {
-            return ;
-        }
+    // 并发下载时统计总的吞吐量
+    uint64_t sample = bytes * 8 * 1000 / ms;
+    _bandwidth = _bandwidth == 0 ? sample : (_bandwidth * 7 + sample * 3) / 10;
+    _sampleBytes = _recvBytes;
+    _sampleTime = now;
 
-        auto m3u8List = self->_hlsClient->_hlsParser->getM3u8List(self->_hlsClient->_m3u8);
-        if (m3u8List.size() == 0) {
-            return ;
-        }
+    // 直播等下一次刷新时生效，点播马上重新获取m3u8
+    if (chooseVariant() && !_live) {
+        loadPlaylist();
+    }
+}
 
-        if (self->_hlsClient->_hlsParser->isMutilM3u8()) {
-            // 获取第一个m3u8，可以调整策略
-            self->_m3u8 = m3u8List.begin()->second.url;
-            self->getM3u8();
-        } else {
-            self->putTsList();
-            self->_playClock.start();
-            self->startPlay();
+uint64_t HlsClientContext::getBufferedMs()
+{
+    uint64_t ms = 0;
+    if (_frameList.size() > 1) {
+        ms = _frameList.rbegin()->first - _frameList.begin()->first;
+    }
+    for (auto& iter : _segments) {
+        if (iter.second->state != HlsSegment::Pending) {
+            ms += iter.second->duration * 1000;
         }
-    });
+    }
 
-    return "";
+    return ms;
 }
 
-void HlsClientContext::getM3u8Inner()
+string HlsClientContext::getAbsoluteUrl(const string& base, const string& url)
 {
-    weak_ptr<HlsClientContext> wSelf = shared_from_this();
-    _hlsClient = make_shared<HttpHlsClient>();
-    _hlsClient->start(_localIp, _localPort, _m3u8, _timeout);
-    _hlsClient->setOnHttpResponce([wSelf](const HttpParser &parser){
-        auto self = wSelf.lock();
-        if (!self) {
-            return ;
-        }
+    if (url.find("http://") == 0 || url.find("https://") == 0) {
+        return url;
+    }
 
-        self->putTsList();
-    });
+    if (url.find("/") == 0) {
+        return base.substr(0, base.find("/", 8)) + url;
+    }
+
+    return base.substr(0, base.rfind("/") + 1) + url;
 }
 
-void HlsClientContext::putTsList()
+void HlsClientContext::stop()
 {
-    auto tsList = _hlsClient->_hlsParser->getTsList(_hlsClient->_m3u8);
-    // if (_preTsIndex < 0) {
-    //     _preTsIndex = tsList.begin()->first;
-    // }
-    // int curIndex = _tsList.begin()->first;
-    for (auto& ts : tsList) {
-        logInfo << "ts index: " << ts.first << ", cur index: " << _preTsIndex;
-        if (ts.first <= _preTsIndex) {
-            continue;
-        }
-        _tsList.emplace(ts.first, ts.second);
+    if (_stopped) {
+        return ;
     }
 
-    if (_tsList.size() > 0) {
-        weak_ptr<HlsClientContext> wSelf = shared_from_this();
-        _loop->addTimerTask(_tsList.begin()->second.duration * 1000, [wSelf](){
-            auto self = wSelf.lock();
-            if (!self) {
-                return 0;
-            }
+    auto self = shared_from_this();
+    _stopped = true;
+    if (_timeTask) {
+        _timeTask->quit = true;
+    }
 
-            self->getM3u8Inner();
+    auto clients = _tsClients;
+    _tsClients.clear();
+    if (_m3u8Client) {
+        clients.push_back(_m3u8Client);
+        _m3u8Client = nullptr;
+    }
+    for (auto& client : clients) {
+        client->setOnResponse(nullptr);
+        client->setOnTsPacket(nullptr);
+        client->close();
+    }
 
-            return 0;
-        }, nullptr);
+    if (_onClose) {
+        _onClose();
     }
 }
 
-#endif
\ No newline at end of file
+void HlsClientContext::pause()
+{
+
+}
+
+void HlsClientContext::setOnClose(const function<void()>& cb)
+{
+    _onClose = cb;
+}
+
+void HlsClientContext::getProtocolAndType(string& protocol, MediaClientType& type)
+{
+    protocol = "hls";
+    type = _type;
+}
+
+#endif
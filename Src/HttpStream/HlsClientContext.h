@@ -4,8 +4,8 @@
 #ifdef ENABLE_HLS
 
 #include "Common/MediaClient.h"
-#include "HttpStream/HttpHlsClient.h"
 #include "HttpStream/HttpHlsTsClient.h"
+#include "Hls/HlsParser.h"
 #include "Common/FrameMediaSource.h"
 #include "EventPoller/Timer.h"
 #include "Util/TimeClock.h"
@@ -17,9 +17,39 @@
 
 using namespace std;
 
+struct HlsSegment
+{
+    using Ptr = shared_ptr<HlsSegment>;
+
+    enum State
+    {
+        Pending = 0,
+        Fetching,
+        Done
+    };
+
+    uint64_t seq = 0;
+    float duration = 0;
+    string url;
+    State state = Pending;
+    int retry = 0;
+    uint64_t bytes = 0;
+    uint64_t lastRecvTime = 0;
+    // 已经有数据送进了解复用器，失败后不能重下
+    bool fed = false;
+    weak_ptr<HttpHlsTsClient> client;
+    // 前面的切片还没下完时先缓存，轮到它时再送进解复用器
+    StringBuffer cache;
+};
+
+// hls拉流，m3u8和ts都用长连接，按顺序同时预取多个切片，
+// 最前面的切片边收边送进解复用器，按targetDuration刷新直播m3u8，
+// 多码率时按测得的带宽选择码率
 class HlsClientContext : public MediaClient, public enable_shared_from_this<HlsClientContext>
 {
 public:
+    using Ptr = shared_ptr<HlsClientContext>;
+
     HlsClientContext(MediaClientType type, const string& appName, const string& streamName);
     ~HlsClientContext();
 
@@ -29,16 +59,44 @@ public:
     void stop() override;
     void pause() override;
     void setOnClose(const function<void()>& cb) override;
+    void getProtocolAndType(string& protocol, MediaClientType& type) override;
+
+    string getPath() {return _localUrlParser.path_;}
+    string getUrl() {return _originUrl;}
+    string getPlaylistUrl() {return _m3u8;}
+    // 测得的下载带宽，bit/s
+    uint64_t getBandwidth() {return _bandwidth;}
+    // 当前码率的BANDWIDTH，单码率时为0
+    uint64_t getVariantBandwidth() {return _variantBandwidth;}
+    uint64_t getRecvBytes() {return _recvBytes;}
+    uint64_t getSegmentCount() {return _segmentCount;}
+    uint64_t getFrameCount() {return _frameCount;}
+    uint64_t getPlaylistCount() {return _playlistCount;}
+    // 建立过的连接数，复用连接时远小于切片数
+    int getConnectionCount() {return _connectionCount;}
 
 private:
-    string getM3u8();
-    void getM3u8Inner();
-    void putTsList();
+    void loadPlaylist();
+    void scheduleRefresh(int ms);
+    void onPlaylist(const string& m3u8);
+    void onMediaPlaylist(HlsParser& parser, const string& m3u8);
+    bool chooseVariant();
     void startPlay();
     void onPlay();
-    void downloadTs();
+    void fetchSegments();
+    void onSegmentData(const HlsSegment::Ptr& segment, const char* data, int len);
+    void onSegmentDone(const HlsSegment::Ptr& segment, bool ok);
+    void feedSegments();
+    void updateBandwidth();
+    uint64_t getBufferedMs();
+    HttpHlsTsClient::Ptr getIdleClient(const string& url);
+    string getAbsoluteUrl(const string& base, const string& url);
 
 private:
+    bool _live = true;
+    bool _stopped = false;
+    bool _refreshScheduled = false;
+    bool _playlistLoaded = false;
     MediaClientType _type;
     UrlParser _localUrlParser;
 
@@ -46,26 +104,42 @@ private:
     string _localIp;
     int _localPort;
     int _timeout;
-    int _preTsIndex = -1;
+    int _fetchingCount = 0;
+    int _connectionCount = 0;
+    float _targetDuration = 0;
+    int64_t _lastSeq = -1;
     uint64_t _lastPts = 0;
     uint64_t _lastPlayStamp = 0;
+    uint64_t _recvBytes = 0;
+    uint64_t _sampleBytes = 0;
+    uint64_t _sampleTime = 0;
+    uint64_t _bandwidth = 0;
+    uint64_t _variantBandwidth = 0;
+    uint64_t _segmentCount = 0;
+    uint64_t _frameCount = 0;
+    uint64_t _playlistCount = 0;
 
     string _m3u8;
-    
+    string _playlist;
+    string _lastPlaylist;
+
     TsDemuxer _tsDemuxer;
     TimeClock _playClock;
     TimeClock _aliveClock;
     shared_ptr<TimerTask> _timeTask;
     EventLoop::Ptr _loop;
-    HttpHlsClient::Ptr _hlsClient;
-    HttpHlsTsClient::Ptr _tsClient;
+    HttpHlsTsClient::Ptr _m3u8Client;
+    vector<HttpHlsTsClient::Ptr> _tsClients;
     FrameMediaSource::Wptr _source;
 
-    map<int, TsInfo> _tsList;
+    // 码率 -> 子m3u8
+    map<uint64_t, M3u8Info> _variants;
+    // 序号 -> 切片，按顺序送进解复用器，送完后删除
+    map<uint64_t, HlsSegment::Ptr> _segments;
     multimap<int, FrameBuffer::Ptr> _frameList;
 
     function<void()> _onClose;
 };
 
 #endif
-#endif // HlsClientContext_h
\ No newline at end of file
+#endif // HlsClientContext_h
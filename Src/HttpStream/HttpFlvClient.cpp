@@ -262,8 +262,10 @@ void HttpFlvClient::handleVideo(const char* data, int len)
 	uint8_t type = RTMP_VIDEO;
 	uint8_t *payload = (u_char*)data + 11;
 	uint32_t length = len - 11;
-	uint8_t frame_type = (payload[0] >> 4) & 0x0f;
-	uint8_t codec_id = payload[0] & 0x0f;
+    RtmpVideoHeader header;
+    if (!header.parse(payload, length)) {
+        return ;
+    }
 
     uint32_t timestamp = readUint24BE(data + 4); //扩展字段也读了
 
@@ -272,7 +274,7 @@ void HttpFlvClient::handleVideo(const char* data, int len)
 
     if (!_rtmpVideoDecodeTrack) {
         _rtmpVideoDecodeTrack = make_shared<RtmpDecodeTrack>(VideoTrackType);
-        if (_rtmpVideoDecodeTrack->createTrackInfo(VideoTrackType, codec_id) != 0) {
+        if (_rtmpVideoDecodeTrack->createTrackInfo(VideoTrackType, header.codecId_) != 0) {
             _validVideoTrack = false;
             return ;
         }
@@ -287,9 +289,9 @@ void HttpFlvClient::handleVideo(const char* data, int len)
     msg->type_id = RTMP_VIDEO;
     msg->csid = RTMP_CHUNK_VIDEO_ID;
 
-    if (!_avcHeader && frame_type == 1/* && codec_id == RTMP_CODEC_ID_H264*/) {
+    if (!_avcHeader && header.frameType_ == 1/* && codec_id == RTMP_CODEC_ID_H264*/) {
             // logInfo << "payload[1] : " << (int)payload[1];
-        if (payload[1] == 0) {
+        if (header.isConfig()) {
             // sps pps??
             _avcHeaderSize = length;
             _avcHeader = make_shared<StreamBuffer>(length + 1);
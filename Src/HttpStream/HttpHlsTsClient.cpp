@@ -6,98 +6,162 @@
 
 using namespace std;
 
-HttpHlsTsClient::HttpHlsTsClient()
-    :HttpClient(EventLoop::getCurrentLoop())
+HttpHlsTsClient::HttpHlsTsClient(const EventLoop::Ptr& loop, bool enableTls)
+    :HttpClient(loop, enableTls)
 {
+    addHeader("Connection", "keep-alive");
+    setMethod("GET");
 }
 
 HttpHlsTsClient::~HttpHlsTsClient()
 {}
 
-bool HttpHlsTsClient::start(const string& localIp, int localPort, const string& url, int timeout)
+string HttpHlsTsClient::getOrigin(const string& url)
 {
-    weak_ptr<HttpHlsTsClient> wSelf = dynamic_pointer_cast<HttpHlsTsClient>(shared_from_this());
+    UrlParser parser;
+    parser.parse(url);
+    int port = parser.port_;
+    if (port == 0) {
+        port = parser.protocol_ == "https" ? 443 : 80;
+    }
 
-    addHeader("Content-Type", "application/json;charset=UTF-8");
-    setMethod("GET");
-    // setContent(msg);
-    // setOnHttpResponce([client, cb](const HttpParser &parser){
-    //     // logInfo << "uri: " << parser._url;
-    //     // logInfo << "status: " << parser._version;
-    //     // logInfo << "method: " << parser._method;
-    //     // logInfo << "_content: " << parser._content;
-    //     if (parser._url != "200") {
-    //         cb("http error", "");
-    //     }
-    //     try {
-    //         json value = json::parse(parser._content);
-    //         cb("", value);
-    //     } catch (exception& ex) {
-    //         logInfo << "json parse failed: " << ex.what();
-    //         cb(ex.what(), nullptr);
-    //     }
-
-    //     const_cast<shared_ptr<HttpClientApi> &>(client).reset();
-    // });
-    logInfo << "connect to utl: " << url;
+    return parser.protocol_ + "://" + parser.host_ + ":" + to_string(port);
+}
+
+bool HttpHlsTsClient::start(const string& url, int timeout)
+{
+    if (_closed || _requesting) {
+        return false;
+    }
+
+    _url = url;
+    _origin = getOrigin(url);
+    _requesting = true;
+    _statusOk = false;
+    _waitClose = false;
+    _bodyBytes = 0;
+    _chunkedParser = nullptr;
+
+    if (_connected) {
+        logTrace << "reuse connection, url: " << url;
+        sendRequest(url);
+        return true;
+    }
+
+    logInfo << "connect to url: " << url;
+    // 失败时close里会回调onResponse
     if (sendHeader(url, timeout) != 0) {
-        close();
         return false;
     }
 
     return true;
 }
 
-void HttpHlsTsClient::onHttpRequest()
+void HttpHlsTsClient::onConnect()
 {
-    if(_parser._contentLen == 0){
-        //后续没content，本次http请求结束
-        close();
-    }
+    _connected = true;
+    HttpClient::onConnect();
 }
 
-void HttpHlsTsClient::onConnect()
+void HttpHlsTsClient::onHttpRequest()
 {
-    _socket = TcpClient::getSocket();
-    _loop = _socket->getLoop();
+    _statusOk = _parser._status >= 200 && _parser._status < 300;
+    if (!_statusOk) {
+        logWarn << "http status: " << _parser._status << ", url: " << _url;
+    }
 
-    HttpClient::onConnect();
-    sendContent(_request._content.data(), _request._content.size());
+    auto iter = _parser._mapHeaders.find("connection");
+    if (iter != _parser._mapHeaders.end()) {
+        string value = iter->second;
+        _keepAlive = toLower(value) != "close";
+    }
 
-    // auto source = MediaSource::getOrCreate(_localUrlParser.path_, DEFAULT_VHOST
-    //                     , PROTOCOL_RTMP, DEFAULT_TYPE
-    //                     , [this](){
-    //                         return make_shared<RtmpMediaSource>(_localUrlParser);
-    //                     });
+    iter = _parser._mapHeaders.find("transfer-encoding");
+    if (iter != _parser._mapHeaders.end() && toLower(iter->second).find("chunked") != string::npos) {
+        weak_ptr<HttpHlsTsClient> wSelf = dynamic_pointer_cast<HttpHlsTsClient>(shared_from_this());
+        _chunkedParser = make_shared<HttpChunkedParser>();
+        _chunkedParser->setOnHttpBody([wSelf](const char *data, int len){
+            auto self = wSelf.lock();
+            if (!self || !self->_requesting) {
+                return ;
+            }
+            if (!data) {
+                self->onResponse(self->_statusOk);
+                return ;
+            }
+            self->onBody(data, len);
+        });
+        return ;
+    }
 
-    // if (!source) {
-    //     logWarn << "another source is exist: " << _localUrlParser.path_;
-    //     onError("another source is exist");
+    // 没有content-length时以断开连接为结束，这个连接不能再复用
+    _waitClose = _parser._contentLen == -1;
+    if (_waitClose) {
+        _keepAlive = false;
+    }
+}
 
-    //     return ;
-    // }
+void HttpHlsTsClient::onRecvContent(const char *data, uint64_t len)
+{
+    if (!_requesting) {
+        return ;
+    }
 
-    // auto rtmpSrc = dynamic_pointer_cast<RtmpMediaSource>(source);
-    // if (!rtmpSrc) {
-    //     logWarn << "this source is not rtmp: " << source->getProtocol();
-    //     onError("this source is not rtmp");
+    _recvBytes += len;
+    if (_chunkedParser) {
+        _chunkedParser->parse(data, len);
+        return ;
+    }
 
-    //     return ;
-    // }
+    onBody(data, len);
+    if (_parser._contentLen == 0) {
+        onResponse(_statusOk);
+    }
+}
 
-    // _source = rtmpSrc;
+void HttpHlsTsClient::onBody(const char* data, uint64_t len)
+{
+    if (len == 0) {
+        return ;
+    }
+
+    _bodyBytes += len;
+    if (_statusOk) {
+        onTsPacket(data, len);
+    }
 }
 
-void HttpHlsTsClient::onRecvContent(const char *data, uint64_t len)
+void HttpHlsTsClient::onResponse(bool ok)
 {
-    logInfo << "recv content: " << len;
-    onTsPacket(data, len);
+    // 回调里可能会释放这个连接
+    auto self = shared_from_this();
+    _requesting = false;
+    if (!_keepAlive) {
+        _closed = true;
+    }
+
+    auto cb = _onResponse;
+    if (cb) {
+        cb(ok);
+    }
+
+    if (!_keepAlive) {
+        close();
+    }
 }
 
 void HttpHlsTsClient::close()
 {
+    auto self = shared_from_this();
+    _closed = true;
+    if (_requesting) {
+        onResponse(_waitClose && _statusOk && _bodyBytes > 0);
+    }
+
     if (_onClose) {
-        _onClose();
+        auto cb = _onClose;
+        _onClose = nullptr;
+        cb();
     }
 
     HttpClient::close();
@@ -105,7 +169,7 @@ void HttpHlsTsClient::close()
 
 void HttpHlsTsClient::onError(const string& err)
 {
-    logInfo << "get a error: " << err;
+    logInfo << "get a error: " << err << ", url: " << _url;
 
     close();
 }
@@ -115,9 +179,19 @@ void HttpHlsTsClient::setOnTsPacket(const function<void(const char* tsPacket, in
     _onTsPacket = cb;
 }
 
+void HttpHlsTsClient::setOnResponse(const function<void(bool ok)>& cb)
+{
+    _onResponse = cb;
+}
+
+void HttpHlsTsClient::setOnClose(const function<void()>& cb)
+{
+    _onClose = cb;
+}
+
 void HttpHlsTsClient::onTsPacket(const char* tsPacket, int len)
 {
     if (_onTsPacket) {
         _onTsPacket(tsPacket, len);
     }
-}
\ No newline at end of file
+}
@@ -2,6 +2,7 @@
 #define HttpTsClient_h
 
 #include "Http/HttpClient.h"
+#include "Http/HttpChunkedParser.h"
 
 #include <string>
 #include <memory>
@@ -9,11 +10,13 @@
 
 using namespace std;
 
+// hls拉流用的长连接，同一个连接上依次请求m3u8或者ts，收到的数据边收边回调
+// 一个连接同时只有一个请求，上一个请求结束后才能发下一个
 class HttpHlsTsClient : public HttpClient
 {
 public:
     using Ptr = shared_ptr<HttpHlsTsClient>;
-    HttpHlsTsClient();
+    HttpHlsTsClient(const EventLoop::Ptr& loop, bool enableTls = false);
     ~HttpHlsTsClient();
 
 public:
@@ -21,20 +24,47 @@ public:
     void onHttpRequest() override;
     void onRecvContent(const char *data, uint64_t len) override;
     void onConnect() override;
+    void onError(const string& err) override;
     void close() override;
 
 public:
-    bool start(const string& localIp, int localPort, const string& url, int timeout);
-    void onTsPacket(const char* tsPacket, int len);
-    void onError(const string& err);
+    // 第一次请求时建立连接，之后复用连接
+    bool start(const string& url, int timeout);
+    bool isIdle() {return !_requesting && !_closed;}
+    bool isClosed() {return _closed;}
+    // scheme://host:port，同源的请求才能复用连接
+    string getOrigin() {return _origin;}
+    uint64_t getRecvBytes() {return _recvBytes;}
+
     void setOnTsPacket(const function<void(const char* tsPacket, int len)>& cb);
+    // 请求结束，失败或者连接中途断开时ok为false
+    void setOnResponse(const function<void(bool ok)>& cb);
+    void setOnClose(const function<void()>& cb);
+
+    static string getOrigin(const string& url);
+
+private:
+    void onTsPacket(const char* tsPacket, int len);
+    void onBody(const char* data, uint64_t len);
+    void onResponse(bool ok);
 
 private:
-    EventLoop::Ptr _loop;
-    Socket::Ptr _socket;
+    bool _connected = false;
+    bool _requesting = false;
+    bool _closed = false;
+    bool _keepAlive = true;
+    bool _statusOk = false;
+    bool _waitClose = false;
+    uint64_t _recvBytes = 0;
+    uint64_t _bodyBytes = 0;
+    string _origin;
+    string _url;
+    // chunked编码的响应才有
+    HttpChunkedParser::Ptr _chunkedParser;
 
     function<void(const char* tsPacket, int len)> _onTsPacket;
+    function<void(bool ok)> _onResponse;
     function<void()> _onClose;
 };
 
-#endif //HttpHlsClient_h
\ No newline at end of file
+#endif //HttpHlsClient_h
@@ -18,8 +18,6 @@ using namespace std;
 JT1078DecodeTrack::JT1078DecodeTrack(int trackIndex)
 {
     _index = trackIndex;
-	_state.index =0;
-	_state.valprev =0;
     // _frame = make_shared<FrameBuffer>();
 }
 
@@ -58,18 +56,19 @@ void JT1078DecodeTrack::onRtpPacket(const JT1078RtpPacket::Ptr& rtp)
             }
 
             int startSize = 0;
-            if (rtp->getCodecType() == "h264" || rtp->getCodecType() == "h265" || rtp->getCodecType() == "h266") {
+            if (rtp->getCodecType() == CodecH264 || rtp->getCodecType() == CodecH265 || rtp->getCodecType() == CodecH266) {
                 startSize = 4;
             }
 
             _frame = FrameBuffer::createFrame(rtp->getCodecType(), startSize, VideoTrackType, 0);
         } else if (rtp->getTrackType() == "audio") {
-            logDebug << "rtp->getCodecType() : " << rtp->getCodecType() << ", rtp->getCodecType() != adpcma = " << (rtp->getCodecType() != "adpcma");
-            if (rtp->getCodecType() != "adpcma" && rtp->getCodecType() != "g726") {
+            logDebug << "rtp->getCodecType() : " << rtp->getCodecType() << ", rtp->getCodecType() != adpcma = " << (rtp->getCodecType() != CodecAdpcma);
+            if (rtp->getCodecType() != CodecAdpcma && rtp->getCodecType() != CodecG726) {
                 _trackInfo = TrackInfo::createTrackInfo(rtp->getCodecType());
             } else {
                 _trackInfo = TrackInfo::createTrackInfo("g711a");
                 _originAudioCodec = rtp->getCodecType();
+                _audioNormalizer = make_shared<AudioNormalizer>(_originAudioCodec, "g711a");
             }
             if (_trackInfo) {
                 onTrackInfo(_trackInfo);
@@ -80,7 +79,7 @@ void JT1078DecodeTrack::onRtpPacket(const JT1078RtpPacket::Ptr& rtp)
             }
 
             int startSize = 0;
-            if (rtp->getCodecType() == "aac") {
+            if (rtp->getCodecType() == CodecAAC) {
                 startSize = 7;
             }
 
@@ -143,7 +142,7 @@ void JT1078DecodeTrack::onFrame(const FrameBuffer::Ptr& frame)
 
     logTrace << "stream path: " << _trackInfo->_parser.path_ << ", pts: " << frame->pts() << " size: " << frame->size();
     // if (!_ready && _trackInfo->trackType_ == "video") {
-    //     if (_trackInfo->codec_ == "h264") {
+    //     if (_trackInfo->codec_ == CodecH264) {
     //         auto h264Frame = dynamic_pointer_cast<H264Frame>(frame);
     //         auto h264Track = dynamic_pointer_cast<H264Track>(_trackInfo);
     //         // logInfo << "h264 frame type: " << (int)h264Frame->getNalType();
@@ -160,7 +159,7 @@ void JT1078DecodeTrack::onFrame(const FrameBuffer::Ptr& frame)
     //                 _onReady();
     //             }
     //         }
-    //     } else if (_trackInfo->codec_ == "h265") {
+    //     } else if (_trackInfo->codec_ == CodecH265) {
     //         auto h265Frame = dynamic_pointer_cast<H265Frame>(frame);
     //         auto h265Track = dynamic_pointer_cast<H265Track>(_trackInfo);
     //         if (h265Frame->getNalType() == H265_SPS) {
@@ -179,7 +178,7 @@ void JT1078DecodeTrack::onFrame(const FrameBuffer::Ptr& frame)
     //         }
     //     }
     // } else if (!_setAacCfg && _trackInfo->trackType_ == "audio") {
-    //     if (_trackInfo->codec_ == "aac") {
+    //     if (_trackInfo->codec_ == CodecAAC) {
     //         auto aacTrack = dynamic_pointer_cast<AacTrack>(_trackInfo);
     //         aacTrack->setAacInfo(string(frame->data(), 7));
     //         _setAacCfg = true;
@@ -197,91 +196,12 @@ void JT1078DecodeTrack::onFrame(const FrameBuffer::Ptr& frame)
     //     }
     // }
 
-    if (_originAudioCodec == "adpcma") {
-        uint8_t* payload = (uint8_t*)frame->data();
-        uint8_t* start = payload;
-        uint64_t size = frame->size();
-        if (payload[0] == 0x00 && payload[1] == 0x01 && 
-                ((payload[2] & 0xff) == (size - 4) / 2) && payload[3] == 0x00)
-        {
-            payload += 8;
-            size -= 8;
-
-            _state.valprev = (uint16_t)(((start[5] << 8) & 0xff00) | (start[4] & 0xff));
-            _state.index = start[6];
-        } else {
-            payload += 4;
-            size -= 4;
-
-            _state.valprev = (uint16_t)(((start[1] << 8) & 0xff00) | (start[0] & 0xff));
-            _state.index = start[2];
+    if (_audioNormalizer) {
+        auto newFrame = _audioNormalizer->normalize(frame);
+        if (!newFrame) {
+            return ;
         }
 
-        uint16_t* pcm = new uint16_t[size*2];
-        adpcm_decoder((char*)payload, (short*)pcm, size * 2, &_state);
-        uint8_t* pcmdata = new uint8_t[size*4];
-        for (int i = 0, k = 0; i < size*2; i++)
-        {
-            short s = pcm[i];
-            pcmdata[k++] = (uint8_t)(s & 0xff);
-            pcmdata[k++] = (uint8_t)((s >> 8) & 0xff);
-        }
-
-        auto newFrame = FrameBuffer::createFrame("g711a", 0, frame->_index, 0);
-        // auto pcmFrame = make_shared<FrameBuffer>();
-        // pcmFrame->_buffer.assign((char*)pcmdata, size * 4);
-        
-        newFrame->_buffer.resize(size * 2);
-        _g711aEncode.pcm_2_alaw((const int16_t *)pcmdata, (uint8_t *)newFrame->data(), size * 2);
-
-        newFrame->_dts = frame->_pts;
-        newFrame->_index = _trackInfo->index_;
-        newFrame->_codec = _trackInfo->codec_;
-        newFrame->_trackType = _trackInfo->trackType_ == "video" ? VideoTrackType : AudioTrackType;
-        if (_onFrame) {
-            _onFrame(newFrame);
-        }
-
-        delete[] pcm;
-        delete[] pcmdata;
-
-        return ;
-    } else if (_originAudioCodec == "g726") {
-        int rateBits = 16;
-        int bitrate = 0;
-        uint64_t size = frame->size();
-        uint64_t pcmSize;
-        switch (rateBits) {
-        case 16:
-            bitrate = 8000 * 2;
-            pcmSize = (2 * size * 120 + 30) / 30;
-            break;
-        case 24:
-            bitrate = 8000 * 3;
-            pcmSize = (2 * size * 80 + 30) / 30;
-            break;
-        case 32:
-            bitrate = 8000 * 4;
-            pcmSize = (2 * size * 60 + 30) / 30;
-            break;
-        case 40:
-            bitrate = 8000 * 5;
-            pcmSize = (2 * size * 40 + 30) / 30;
-            break;
-        default:
-            break;
-        }
-        g726_init(&_state726, bitrate);
-        uint8_t* pcmdata = new uint8_t[pcmSize];
-
-        int result = g726_decode(&_state726, (short*)pcmdata, (const unsigned char*)frame->data(), size);
-        auto newFrame = FrameBuffer::createFrame("g711a", 0, frame->_index, 0);
-        // auto pcmFrame = make_shared<FrameBuffer>();
-        // pcmFrame->_buffer.assign((char*)pcmdata, size * 4);
-        
-        newFrame->_buffer.resize(result);
-        _g711aEncode.pcm_2_alaw((const int16_t *)pcmdata, (uint8_t *)newFrame->data(), result);
-
         newFrame->_dts = frame->_pts;
         newFrame->_index = _trackInfo->index_;
         newFrame->_codec = _trackInfo->codec_;
@@ -290,7 +210,6 @@ void JT1078DecodeTrack::onFrame(const FrameBuffer::Ptr& frame)
             _onFrame(newFrame);
         }
 
-        delete[] pcmdata;
         return ;
     }
 
@@ -305,13 +224,13 @@ void JT1078DecodeTrack::onFrame(const FrameBuffer::Ptr& frame)
 
 void JT1078DecodeTrack::createFrame()
 {
-    if (_trackInfo->codec_ == "h264") {
+    if (_trackInfo->codec_ == CodecH264) {
         _frame = make_shared<H264Frame>();
         _frame->_startSize = 4;
-    } else if (_trackInfo->codec_ == "h265") {
+    } else if (_trackInfo->codec_ == CodecH265) {
         _frame = make_shared<H265Frame>();
         _frame->_startSize = 4;
-    } else if (_trackInfo->codec_ == "aac" || _trackInfo->codec_ == "g711a" || _trackInfo->codec_ == "g711u") {
+    } else if (_trackInfo->codec_ == CodecAAC || _trackInfo->codec_ == CodecG711A || _trackInfo->codec_ == CodecG711U) {
         _frame = make_shared<FrameBuffer>();
     }
 }
@@ -5,9 +5,7 @@
 #include "Common/Track.h"
 #include "Common/Frame.h"
 #include "JT1078RtpPacket.h"
-#include "PcmTranscode/AdpcmaTranscode.h"
-#include "PcmTranscode/G711Transcode.h"
-#include "PcmTranscode/G726Transcode.h"
+#include "PcmTranscode/AudioNormalizer.h"
 
 #include <unordered_map>
 
@@ -50,9 +48,7 @@ private:
     int _type;
     uint16_t _lastSeq = 0;
     string _originAudioCodec;
-    adpcm_state _state;
-    g726_state_t _state726;
-    G711Transcode _g711aEncode;
+    AudioNormalizer::Ptr _audioNormalizer;
     FrameBuffer::Ptr _frame;
     shared_ptr<TrackInfo> _trackInfo;
     function<void()> _onReady;
@@ -34,6 +34,7 @@ public:
     void onFrame(const FrameBuffer::Ptr& frame) override;
     void onReady() override;
     uint64_t getBytes() override { return _ring ? _ring->getBytes() : 0;}
+    vector<DataQueKeyframeInfo> getKeyframeIndex() override { return _ring ? _ring->getKeyframeIndex() : vector<DataQueKeyframeInfo>();}
     unordered_map<int/*index*/, JT1078DecodeTrack::Ptr> getDecodeTrack()
     {
         return _mapJT1078DecodeTrack;
@@ -58,29 +58,29 @@ uint8_t JT1078RtpPacket::getPt()
     }
 }
 
-string JT1078RtpPacket::getCodecType()
+CodecId JT1078RtpPacket::getCodecType()
 {
     switch (getPt()) {
     case 6:
-        _codec = "g711a";
+        _codec = CodecG711A;
         break;
     case 7:
-        _codec = "g711u";
+        _codec = CodecG711U;
         break;
     case 8:
-        _codec = "g726";
+        _codec = CodecG726;
         break;
     case 19:
-        _codec = "aac";
+        _codec = CodecAAC;
         break;
     case 26:
-        _codec = "adpcma";
+        _codec = CodecAdpcma;
         break;
     case 98:
-        _codec = "h264";
+        _codec = CodecH264;
         break;
     case 99:
-        _codec = "h265";
+        _codec = CodecH265;
         break;
     default:
         logTrace << "invalid payload type: " << (int)getPt();
@@ -120,7 +120,7 @@ public:
     char* data();
     size_t size();
     StreamBuffer::Ptr buffer();
-    string getCodecType();
+    CodecId getCodecType();
     JT1078_STREAM_TYPE getStreamType();
     JT1078_SUBMARK getSubMark();
     bool getMark();
@@ -156,7 +156,7 @@ private:
     uint16_t            _lastFrameInterval;      //与上一帧的时间间隔
     uint16_t            _bodyLen;                //数据体长度
     uint16_t            _payloadIndex;
-    string              _codec;
+    CodecId             _codec;
     string              _type;
     std::string         _simCode;
     JT1078RtpHeader* _header;
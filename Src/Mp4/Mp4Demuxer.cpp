@@ -524,6 +524,85 @@ int MP4Demuxer::mov_reader_seek(int64_t* timestamp)
 	return 0;
 }
 
+int MP4Demuxer::mov_reader_read_keyframe(int64_t target, int64_t lastDts, bool reverse, int64_t* dts)
+{
+	int i;
+	mov_track_t* track = NULL;
+
+	for (i = 0; i < _track_count; i++)
+	{
+		if (MOV_VIDEO == _tracks[i]->handler_type && _tracks[i]->stbl.stss_count > 0)
+		{
+			track = _tracks[i].get();
+			break;
+		}
+	}
+	if (NULL == track || 0 == track->mdhd.timescale)
+		return -1;
+
+	size_t count = track->stbl.stss_count;
+	for (size_t j = 0; j < count; j++)
+	{
+		if (track->stbl.stss[j] < 1 || track->stbl.stss[j] > track->sample_count)
+			return -1;
+	}
+
+	auto syncDts = [track](size_t j) -> int64_t {
+		return track->samples[track->stbl.stss[j] - 1]->dts * 1000 / track->mdhd.timescale;
+	};
+	// 第一个dts大于(orEqual时为大于等于)clock的同步帧，stss按dts递增
+	auto bound = [&](int64_t clock, bool orEqual) -> size_t {
+		size_t start = 0, end = count;
+		while (start < end)
+		{
+			size_t mid = (start + end) / 2;
+			int64_t value = syncDts(mid);
+			if (value > clock || (orEqual && value == clock))
+				end = mid;
+			else
+				start = mid + 1;
+		}
+		return start;
+	};
+
+	size_t idx;
+	if (!reverse)
+	{
+		size_t first = bound(lastDts, false);
+		if (first == count)
+			return 0;
+		size_t last = bound(target, false);
+		if (last <= first)
+			return 2;
+		idx = last - 1;
+	}
+	else
+	{
+		size_t end = bound(lastDts, true);
+		if (end == 0)
+			return 0;
+		size_t begin = bound(target, true);
+		if (begin >= end)
+			return 2;
+		idx = begin;
+	}
+
+	size_t sampleIdx = track->stbl.stss[idx] - 1;
+	struct mov_sample_t* sample = track->samples[sampleIdx].get();
+
+	auto frame = make_shared<StreamBuffer>();
+	frame->setCapacity(sample->bytes + 1);
+	seek(sample->offset);
+	read(frame->data(), sample->bytes);
+
+	// 退出关键帧模式时从这里继续读
+	track->sample_offset = sampleIdx + 1;
+	*dts = syncDts(idx);
+	onFrame(frame, track->tkhd.track_ID, sample->pts * 1000 / track->mdhd.timescale, sample->dts * 1000 / track->mdhd.timescale, sample->flags);
+
+	return 1;
+}
+
 int MP4Demuxer::mov_reader_getinfo()
 {
 	int i;
@@ -555,7 +634,7 @@ int MP4Demuxer::mov_reader_getinfo()
                     trackInfo->_height = entry->u.visual.height;
                     // trackInfo->_hvcc = entry->extra_data;
 					trackInfo->setConfig(entry->extra_data);
-                    trackInfo->codec_ = "h265";
+                    trackInfo->codec_ = CodecH265;
                     trackInfo->payloadType_ = 96;
                     trackInfo->trackType_ = "video";
                     trackInfo->samplerate_ = 90000;
@@ -570,7 +649,7 @@ int MP4Demuxer::mov_reader_getinfo()
                     auto trackInfo = make_shared<AacTrack>();
                     trackInfo->index_ = track->tkhd.track_ID;
                     trackInfo->channel_ = entry->u.audio.channelcount;
-                    trackInfo->codec_ = "aac";
+                    trackInfo->codec_ = CodecAAC;
                     trackInfo->payloadType_ = 97;
                     trackInfo->trackType_ = "audio";
                     trackInfo->samplerate_ = entry->u.audio.samplerate;
@@ -583,7 +662,7 @@ int MP4Demuxer::mov_reader_getinfo()
 					auto trackInfo = make_shared<G711aTrack>();
                     trackInfo->index_ = track->tkhd.track_ID;
                     trackInfo->channel_ = entry->u.audio.channelcount;
-                    trackInfo->codec_ = "g711a";
+                    trackInfo->codec_ = CodecG711A;
                     trackInfo->payloadType_ = 8;
                     trackInfo->trackType_ = "audio";
                     trackInfo->samplerate_ = entry->u.audio.samplerate;
@@ -595,7 +674,7 @@ int MP4Demuxer::mov_reader_getinfo()
 					auto trackInfo = make_shared<G711uTrack>();
                     trackInfo->index_ = track->tkhd.track_ID;
                     trackInfo->channel_ = entry->u.audio.channelcount;
-                    trackInfo->codec_ = "g711u";
+                    trackInfo->codec_ = CodecG711U;
                     trackInfo->payloadType_ = 0;
                     trackInfo->trackType_ = "audio";
                     trackInfo->samplerate_ = entry->u.audio.samplerate;
@@ -607,7 +686,7 @@ int MP4Demuxer::mov_reader_getinfo()
 					auto trackInfo = make_shared<Mp3Track>();
                     trackInfo->index_ = track->tkhd.track_ID;
                     trackInfo->channel_ = entry->u.audio.channelcount;
-                    trackInfo->codec_ = "mp3";
+                    trackInfo->codec_ = CodecMP3;
                     trackInfo->payloadType_ = 14;
                     trackInfo->trackType_ = "audio";
                     trackInfo->samplerate_ = entry->u.audio.samplerate;
@@ -39,6 +39,9 @@ public:
     int mov_reader_read(void* buffer, size_t bytes);
     int mov_reader_read2();
     int mov_reader_seek(int64_t* timestamp);
+    // 只读视频轨的同步帧，正放读(lastDts, target]里最后一个，倒放读[target, lastDts)里第一个，单位毫秒
+    // 返回1读到了，2区间里没有同步帧，0没有更多同步帧，-1没有stss
+    int mov_reader_read_keyframe(int64_t target, int64_t lastDts, bool reverse, int64_t* dts);
     uint64_t mov_reader_getduration();
 
 protected:
@@ -62,7 +62,7 @@ void Mp4FileReader::onFrame(const StreamBuffer::Ptr& buffer, int trackIndex, int
 
     auto trackInfo = _mapTrackInfo[trackIndex];
     FrameBuffer::Ptr frame;
-    if (trackInfo->codec_ == "h265" || trackInfo->codec_ == "h264") {
+    if (trackInfo->codec_ == CodecH265 || trackInfo->codec_ == CodecH264) {
         uint32_t offset = 0;
         uint64_t bytes = buffer->size();
         auto data = buffer->data();
@@ -75,7 +75,7 @@ void Mp4FileReader::onFrame(const StreamBuffer::Ptr& buffer, int trackIndex, int
                 return ;
             }
             // memcpy(data + offset, "\x0\x0\x0\x1", 4);
-            if (trackInfo->codec_ == "h265" ) {
+            if (trackInfo->codec_ == CodecH265 ) {
                 frame = make_shared<H265Frame>();
             } else {
                 frame = make_shared<H264Frame>();
@@ -106,7 +106,7 @@ void Mp4FileReader::onFrame(const StreamBuffer::Ptr& buffer, int trackIndex, int
         // frame->_codec = trackInfo->codec_;
 
         return ;
-    } else if (trackInfo->codec_ == "h264") {
+    } else if (trackInfo->codec_ == CodecH264) {
         // frame = make_shared<H264Frame>();
         // frame->_buffer.assign("\x0\x0\x0\x1", 4);
         // frame->_buffer.append(buffer->data(), buffer->size());
@@ -116,7 +116,7 @@ void Mp4FileReader::onFrame(const StreamBuffer::Ptr& buffer, int trackIndex, int
         // frame->_index = trackIndex;
         // frame->_dts = dts;
         // frame->_codec = trackInfo->codec_;
-    } else if (trackInfo->codec_ == "aac") {
+    } else if (trackInfo->codec_ == CodecAAC) {
         auto aacTrack = dynamic_pointer_cast<AacTrack>(trackInfo);
         string adts = aacTrack->getAdtsHeader(buffer->size());
         if (adts.size() != 7) {
@@ -131,7 +131,7 @@ void Mp4FileReader::onFrame(const StreamBuffer::Ptr& buffer, int trackIndex, int
         frame->_index = trackIndex;
         frame->_dts = dts;
         frame->_codec = trackInfo->codec_;
-    } else if (trackInfo->codec_ == "g711a" || trackInfo->codec_ == "g711u" || trackInfo->codec_ == "mp3") {
+    } else if (trackInfo->codec_ == CodecG711A || trackInfo->codec_ == CodecG711U || trackInfo->codec_ == CodecMP3) {
         frame = make_shared<FrameBuffer>();
         frame->_buffer.assign(buffer->data(), buffer->size());
         frame->_trackType = AudioTrackType;
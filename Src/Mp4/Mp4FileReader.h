@@ -30,6 +30,7 @@ public:
     void onReady() override;
 
     bool open();
+    int getFileSize() {return _file.getFileSize();}
 
 public:
     void setOnFrame(const std::function<void (const FrameBuffer::Ptr &frame)>& cb);
@@ -152,6 +152,22 @@ int PsDemuxer::onPsStream(char* ps_data, int ps_size, uint32_t timestamp, uint32
     int incomplete_len = ps_size;
     char *next_ps_pack = ps_data;
 
+    // 先把上个视频PES剩下的负载直接写进帧里，不经过_remainBuffer
+    if (_videoPesRemain > 0 && ps_data && ps_size > 0) {
+        int len = min(_videoPesRemain, ps_size);
+        if (_videoFrame) {
+            _videoFrame->_buffer.append(ps_data, len);
+        }
+        _videoPesRemain -= len;
+        ps_data += len;
+        ps_size -= len;
+        incomplete_len = ps_size;
+        next_ps_pack = ps_data;
+        if (ps_size == 0) {
+            return 0;
+        }
+    }
+
     if (!_remainBuffer.empty()) {
         _remainBuffer.append(ps_data, ps_size);
         incomplete_len = _remainBuffer.size();
@@ -340,7 +356,7 @@ int PsDemuxer::onPsStream(char* ps_data, int ps_size, uint32_t timestamp, uint32
                     _audio_es_id = es_id;
                     _audio_es_type = type;
                     if (_audio_es_type == STREAM_TYPE_AUDIO_AAC) {
-                        _audioCodec = "aac";
+                        _audioCodec = CodecAAC;
                         // auto trackInfo = make_shared<AacTrack>();
                         // trackInfo->index_ = AudioTrackType;
                         // trackInfo->codec_ = "aac";
@@ -350,7 +366,7 @@ int PsDemuxer::onPsStream(char* ps_data, int ps_size, uint32_t timestamp, uint32
                         // auto trackInfo = AacTrack::createTrack(AudioTrackType, 97, 44100);
                         // addTrackInfo(trackInfo);
                     } else if (_audio_es_type == STREAM_TYPE_AUDIO_G711) {
-                        _audioCodec = "g711a";
+                        _audioCodec = CodecG711A;
                         // auto trackInfo = make_shared<G711aTrack>();
                         // trackInfo->index_ = AudioTrackType;
                         // trackInfo->codec_ = "g711a";
@@ -359,7 +375,7 @@ int PsDemuxer::onPsStream(char* ps_data, int ps_size, uint32_t timestamp, uint32
                         // addTrackInfo(trackInfo);
                         // _firstAac = false;
                     } else if (_audio_es_type == STREAM_TYPE_AUDIO_G711ULAW) {
-                        _audioCodec = "g711u";
+                        _audioCodec = CodecG711U;
                         // auto trackInfo = make_shared<G711uTrack>();
                         // trackInfo->index_ = AudioTrackType;
                         // trackInfo->codec_ = "g711u";
@@ -368,12 +384,12 @@ int PsDemuxer::onPsStream(char* ps_data, int ps_size, uint32_t timestamp, uint32
                         // addTrackInfo(trackInfo);
                         // _firstAac = false;
                     } else if (_audio_es_type == STREAM_TYPE_AUDIO_G711ULAW) {
-                        _audioCodec = "mp3";
+                        _audioCodec = CodecMP3;
                         // auto trackInfo = Mp3Track::createTrack(AudioTrackType, 14, 44100);
                         // addTrackInfo(trackInfo);
                         // _firstAac = false;
                     } else if (_audio_es_type == STREAM_TYPE_AUDIO_OPUS) {
-                        _audioCodec = "opus";
+                        _audioCodec = CodecOpus;
                         // auto trackInfo = OpusTrack::createTrack(AudioTrackType, 14, 44100);
                         // addTrackInfo(trackInfo);
                         // _firstAac = false;
@@ -390,12 +406,12 @@ int PsDemuxer::onPsStream(char* ps_data, int ps_size, uint32_t timestamp, uint32
                     _video_es_id = es_id;
                     _video_es_type = type;
                     if (_video_es_type == STREAM_TYPE_VIDEO_H264) {
-                        _videoCodec = "h264";
+                        _videoCodec = CodecH264;
                         // auto trackInfo = H264Track::createTrack(VideoTrackType, 96, 90000);
                         // addTrackInfo(trackInfo);
                         // _firstVps = false;
                     } else if (_video_es_type == STREAM_TYPE_VIDEO_HEVC) {
-                        _videoCodec = "h265";
+                        _videoCodec = CodecH265;
                         // auto trackInfo = make_shared<H265Track>();
                         // trackInfo->index_ = VideoTrackType;
                         // trackInfo->codec_ = "h265";
@@ -405,11 +421,11 @@ int PsDemuxer::onPsStream(char* ps_data, int ps_size, uint32_t timestamp, uint32
                         // auto trackInfo = H265Track::createTrack(VideoTrackType, 96, 90000);
                         // addTrackInfo(trackInfo);
                     } else if (_video_es_type == STREAM_TYPE_VIDEO_VP8) {
-                        _videoCodec = "vp8";
+                        _videoCodec = CodecVP8;
                     } else if (_video_es_type == STREAM_TYPE_VIDEO_VP9) {
-                        _videoCodec = "vp9";
+                        _videoCodec = CodecVP9;
                     } else if (_video_es_type == STREAM_TYPE_VIDEO_AV1) {
-                        _videoCodec = "av1";
+                        _videoCodec = CodecAV1;
                     }
                     addTrackInfo(TrackInfo::createTrackInfo(_videoCodec));
                 }
@@ -433,9 +449,9 @@ int PsDemuxer::onPsStream(char* ps_data, int ps_size, uint32_t timestamp, uint32
 			&& next_ps_pack[2] == (char)0x01
 			&& (next_ps_pack[3] == (char)_video_es_id || next_ps_pack[3] == (char)0xE2))
         {
-            if (next_ps_pack[3] == (char)0xE2 && (int)_video_es_id == 0 && _videoCodec == "unknown") {
+            if (next_ps_pack[3] == (char)0xE2 && (int)_video_es_id == 0 && _videoCodec == CodecUnknown) {
                 // 兼容ffmpeg生成的ps流
-                _videoCodec = "h264";
+                _videoCodec = CodecH264;
                 auto trackInfo = H264Track::createTrack(VideoTrackType, 96, 90000);
                 addTrackInfo(trackInfo);
                 // _firstVps = false;
@@ -461,19 +477,13 @@ int PsDemuxer::onPsStream(char* ps_data, int ps_size, uint32_t timestamp, uint32
                 return -1;
             }
 
-            // logInfo << "incomplete_len: " << incomplete_len;
-            // logInfo << "end - next_ps_pack: " << (end - next_ps_pack);
-            // logInfo << "need_len: " << (sizeof(PsePacket) + pse_pack->stuffingLength + payloadlen);
-            if (incomplete_len < sizeof(PsePacket) + pse_pack->stuffingLength + payloadlen) {
+            // 只要求PES头完整，负载可以分多次到达，边收边写入帧
+            if (incomplete_len < sizeof(PsePacket) + pse_pack->stuffingLength) {
                 _remainBuffer.assign(next_ps_pack, incomplete_len);
                 logInfo << "_remainBuffer size: " << _remainBuffer.size();
                 return -1;
             }
 
-            if (incomplete_len < 19) {
-                return -1;
-            }
-
             unsigned char pts_dts_flags = (pse_pack->info[1] & 0xF0) >> 6;
             //in a frame of data, pts is obtained from the first PSE packet
             if (/*pse_index == 0 && */pts_dts_flags > 0) {
@@ -499,7 +509,7 @@ int PsDemuxer::onPsStream(char* ps_data, int ps_size, uint32_t timestamp, uint32
             if (_videoFrame && _newPs /*(_lastVideoPts != -1 && _lastVideoPts != video_pts)*/) {
                 // onDecode(_videoStream);
                 _newPs = false;
-                if (_videoCodec != "unknown" && _videoFrame->size() > 0) {
+                if (_videoCodec != CodecUnknown && _videoFrame->size() > 0) {
                     // static int i = 0;
                     // string name = "testpsvod" + to_string(i++) + ".h264";
                     // FILE* fp = fopen(name.c_str(), "ab+");
@@ -507,17 +517,18 @@ int PsDemuxer::onPsStream(char* ps_data, int ps_size, uint32_t timestamp, uint32
                     // fclose(fp);
 
                     // logInfo << "decode a frame";
+                    _lastVideoFrameSize = _videoFrame->size();
                     onDecode(_videoFrame, VideoTrackType, video_pts, video_pts);
                 }
                 _videoFrame = createFrame(VideoTrackType);
+                if (_videoFrame) {
+                    _videoFrame->_buffer.reserve(_lastVideoFrameSize + _lastVideoFrameSize / 4);
+                }
             }
-            
+
+            int avail = min(payloadlen, (int)(end - next_ps_pack));
             if (_videoFrame) {
-                if (_videoFrame->_buffer.empty()) {
-                    _videoFrame->_buffer.assign(next_ps_pack, payloadlen);
-                } else {
-                    _videoFrame->_buffer.append(next_ps_pack, payloadlen);
-                }
+                _videoFrame->_buffer.append(next_ps_pack, avail);
             }
             _lastVideoPts = video_pts;
 
@@ -525,9 +536,14 @@ int PsDemuxer::onPsStream(char* ps_data, int ps_size, uint32_t timestamp, uint32
             // logInfo << "payloadlen: " << payloadlen;
             // logInfo << "complete_len: " << complete_len;
 
-            next_ps_pack = next_ps_pack + payloadlen;
-            complete_len = complete_len + payloadlen;
+            next_ps_pack = next_ps_pack + avail;
+            complete_len = complete_len + avail;
             incomplete_len = ps_size - complete_len;
+            if (avail < payloadlen) {
+                // 负载没收全，剩余部分在下次输入时直接写入帧
+                _videoPesRemain = payloadlen - avail;
+                break;
+            }
         }
      	else if (next_ps_pack
 			&& next_ps_pack[0] == (char)0x00
@@ -639,10 +655,10 @@ int PsDemuxer::onPsStream(char* ps_data, int ps_size, uint32_t timestamp, uint32
                         //      channel_id.c_str(), get_ps_map_type_str(audio_es_type).c_str());
                         logWarn << "audio id is: " << (int)_audio_es_type << ", but it is a aac" << endl;
                         _audio_es_type = STREAM_TYPE_AUDIO_AAC;
-                        _audioCodec = "aac";
+                        _audioCodec = CodecAAC;
                         auto trackInfo = make_shared<AacTrack>();
                         trackInfo->index_ = AudioTrackType;
-                        trackInfo->codec_ = "aac";
+                        trackInfo->codec_ = CodecAAC;
                         trackInfo->trackType_ = "audio";
                         trackInfo->samplerate_ = 90000;
                         trackInfo->payloadType_ = 97;
@@ -668,7 +684,7 @@ int PsDemuxer::onPsStream(char* ps_data, int ps_size, uint32_t timestamp, uint32
             // hasAudio = true;
             //Buffer::Ptr audio_frame = std::make_shared<BufferOffset<StringBuffer> >(std::move(audio_stream));
             // _decoder->_on_decode(0, _audio_es_type, 1, audio_pts, audio_pts, audio_stream.data(), audio_stream.size());
-            if (_audioCodec != "unknown") {
+            if (_audioCodec != CodecUnknown) {
                 onDecode(audio_stream, AudioTrackType, audio_pts, audio_pts);
             }
 
@@ -745,6 +761,61 @@ int PsDemuxer::onPsStream(char* ps_data, int ps_size, uint32_t timestamp, uint32
     return 0;
 }
 
+int PsDemuxer::findKeyframe(const char* data, int size, uint64_t& pts)
+{
+    const uint8_t* p = (const uint8_t*)data;
+    int pos = 0;
+    while (pos + 14 <= size) {
+        if (p[pos] != 0x00 || p[pos + 1] != 0x00 || p[pos + 2] != 0x01 || p[pos + 3] != 0xBA) {
+            ++pos;
+            continue;
+        }
+
+        int pack = pos;
+        int cur = pos + 14 + (p[pos + 13] & 0x07);
+        while (cur + 9 <= size && p[cur] == 0x00 && p[cur + 1] == 0x00 && p[cur + 2] == 0x01 && p[cur + 3] != 0xBA) {
+            uint8_t streamId = p[cur + 3];
+            if (streamId < 0xE0 || streamId > 0xEF) {
+                // 系统头、psm、音频pes等，按长度跳过
+                cur += 6 + ((p[cur + 4] << 8) | p[cur + 5]);
+                continue;
+            }
+
+            int payload = cur + 9 + p[cur + 8];
+            if (payload + 5 > size) {
+                break;
+            }
+            const uint8_t* nal = p + payload;
+            int startSize = 0;
+            if (nal[0] == 0x00 && nal[1] == 0x00 && nal[2] == 0x01) {
+                startSize = 3;
+            } else if (nal[0] == 0x00 && nal[1] == 0x00 && nal[2] == 0x00 && nal[3] == 0x01) {
+                startSize = 4;
+            }
+            bool key = false;
+            if (startSize > 0) {
+                if (_videoCodec == CodecH265) {
+                    // vps/sps/pps和irap
+                    int type = (nal[startSize] >> 1) & 0x3F;
+                    key = (type >= 16 && type <= 21) || (type >= 32 && type <= 34);
+                } else {
+                    // sps/pps和idr
+                    int type = nal[startSize] & 0x1F;
+                    key = type == 5 || type == 7 || type == 8;
+                }
+            }
+            if (key) {
+                pts = (p[cur + 7] & 0x80) ? parsePsTimestamp(p + cur + 9) / 90 : 0;
+                return pack;
+            }
+            break;
+        }
+        pos = pack + 4;
+    }
+
+    return -1;
+}
+
 int PsDemuxer::seek(char* ps_data, int ps_size, uint32_t timestamp, uint32_t ssrc, bool live)
 {
     int err = 0;
@@ -864,9 +935,9 @@ int PsDemuxer::seek(char* ps_data, int ps_size, uint32_t timestamp, uint32_t ssr
 			&& next_ps_pack[2] == (char)0x01
 			&& (next_ps_pack[3] == (char)_video_es_id || next_ps_pack[3] == (char)0xE2))
         {
-            if (next_ps_pack[3] == (char)0xE2 && (int)_video_es_id == 0 && _videoCodec == "unknown") {
+            if (next_ps_pack[3] == (char)0xE2 && (int)_video_es_id == 0 && _videoCodec == CodecUnknown) {
                 // 兼容ffmpeg生成的ps流
-                _videoCodec = "h264";
+                _videoCodec = CodecH264;
                 auto trackInfo = H264Track::createTrack(VideoTrackType, 96, 90000);
                 addTrackInfo(trackInfo);
                 // _firstVps = false;
@@ -1077,9 +1148,9 @@ void PsDemuxer::onDecode(const FrameBuffer::Ptr& frame, int index, uint64_t pts,
     frame->_trackType = index;
     frame->_codec = index == VideoTrackType ? _videoCodec : _audioCodec;
 
-    if (index == AudioTrackType && _audioCodec == "aac") {
+    if (index == AudioTrackType && _audioCodec == CodecAAC) {
         frame->_startSize = 7;
-    } else if (index == VideoTrackType && (_videoCodec == "h264" || _videoCodec == "h265" || _videoCodec == "h266")) {
+    } else if (index == VideoTrackType && (_videoCodec == CodecH264 || _videoCodec == CodecH265 || _videoCodec == CodecH266)) {
         frame->_startSize = 0;
         if (readUint32BE(frame->data()) == 1) {
             frame->_startSize = 4;
@@ -1089,7 +1160,7 @@ void PsDemuxer::onDecode(const FrameBuffer::Ptr& frame, int index, uint64_t pts,
         // logInfo << "frame->_startSize: " << frame->_startSize;
     }
     if (index == VideoTrackType) {
-        if (_videoCodec == "h265") {
+        if (_videoCodec == CodecH265) {
             auto h265frame = dynamic_pointer_cast<H265Frame>(frame);
             h265frame->split([this, h265frame](const FrameBuffer::Ptr &subFrame){
                 // if (_firstVps || _firstSps || _firstPps) {
@@ -1120,7 +1191,7 @@ void PsDemuxer::onDecode(const FrameBuffer::Ptr& frame, int index, uint64_t pts,
                     _onFrame(subFrame);
                 }
             });
-        } else if (_videoCodec == "h264") {
+        } else if (_videoCodec == CodecH264) {
             auto h264frame = dynamic_pointer_cast<H264Frame>(frame);
             h264frame->split([this, h264frame](const FrameBuffer::Ptr &subFrame){
                 // if (_firstSps || _firstPps) {
@@ -1219,6 +1290,9 @@ void PsDemuxer::onReady(int trackType)
 
 void PsDemuxer::clear()
 {
+    // 没收完的帧也丢掉，seek后不会把之前位置的帧输出出去
+    _videoFrame = nullptr;
+    _videoPesRemain = 0;
     _remainBuffer.clear();
     _videoStream.clear();
 }
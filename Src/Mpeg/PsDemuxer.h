@@ -57,6 +57,9 @@ public:
     uint64_t  parsePsTimestamp(const uint8_t* p);
     virtual int onPsStream(char* ps_data, int ps_size, uint32_t timestamp, uint32_t ssrc, bool live = false);
     virtual int seek(char* ps_data, int ps_size, uint32_t timestamp, uint32_t ssrc, bool live = false);
+    // 查找视频关键帧所在的ps包，返回包头的偏移，没有完整的关键帧包时返回-1
+    // 只看每个ps包里第一个视频pes负载开头的nal类型，不解出帧，pts单位为毫秒
+    int findKeyframe(const char* data, int size, uint64_t& pts);
 
     void setOnDecode(const function<void(const FrameBuffer::Ptr& frame)> cb);
     void onDecode(const FrameBuffer::Ptr& data, int index, uint64_t pts, uint64_t dts);
@@ -87,8 +90,12 @@ private:
     uint8_t _audio_es_id = 0;
     uint8_t _video_es_id = 0;
     uint64_t _lastVideoPts = -1;
-    string _audioCodec = "unknown";
-    string _videoCodec = "unknown";
+    // 上个视频PES还没收完的负载长度，后续数据直接追加到_videoFrame
+    int _videoPesRemain = 0;
+    // 上一个视频帧大小，用于新帧预分配
+    size_t _lastVideoFrameSize = 0;
+    CodecId _audioCodec = CodecUnknown;
+    CodecId _videoCodec = CodecUnknown;
     TimeClock _timeClock;
     StringBuffer _remainBuffer;
     StringBuffer _videoStream;
@@ -34,11 +34,11 @@ void PsMuxer::onFrame(const FrameBuffer::Ptr& frame)
     // if (frame->keyFrame()) {
     //     if (!_sendMetaFrame) {
     //         auto track = _mapTrackInfo[frame->getTrackIndex()];
-    //         if (track->codec_ == "h264") {
+    //         if (track->codec_ == CodecH264) {
     //             auto h264Track = dynamic_pointer_cast<H264Track>(track);
     //             encode(h264Track->_sps);
     //             encode(h264Track->_pps);
-    //         } else if (track->codec_ == "h265") {
+    //         } else if (track->codec_ == CodecH265) {
     //             auto h265Track = dynamic_pointer_cast<H265Track>(track);
     //             encode(h265Track->_vps);
     //             encode(h265Track->_sps);
@@ -74,15 +74,15 @@ void PsMuxer::addTrackInfo(const shared_ptr<TrackInfo>& trackInfo)
     if (trackInfo->trackType_ == "video") {
         _mapStampAdjust[trackInfo->index_] = make_shared<VideoStampAdjust>(25);
         _mapStreamId[trackInfo->index_] = _lastVideoId++;
-        if (trackInfo->codec_ == "h264") {
+        if (trackInfo->codec_ == CodecH264) {
             _videoCodec = STREAM_TYPE_VIDEO_H264;
-        } else if (trackInfo->codec_ == "h265") {
+        } else if (trackInfo->codec_ == CodecH265) {
             _videoCodec = STREAM_TYPE_VIDEO_HEVC;
-        } else if (trackInfo->codec_ == "vp8") {
+        } else if (trackInfo->codec_ == CodecVP8) {
             _videoCodec = STREAM_TYPE_VIDEO_VP8;
-        } else if (trackInfo->codec_ == "vp9") {
+        } else if (trackInfo->codec_ == CodecVP9) {
             _videoCodec = STREAM_TYPE_VIDEO_VP9;
-        } else if (trackInfo->codec_ == "av1") {
+        } else if (trackInfo->codec_ == CodecAV1) {
             _videoCodec = STREAM_TYPE_VIDEO_AV1;
         } else {
             throw runtime_error("unsupport video codec: " + trackInfo->codec_);
@@ -90,15 +90,15 @@ void PsMuxer::addTrackInfo(const shared_ptr<TrackInfo>& trackInfo)
     } else if (trackInfo->trackType_ == "audio") {
         _mapStampAdjust[trackInfo->index_] = make_shared<AudioStampAdjust>(0);
         _mapStreamId[trackInfo->index_] = _lastAudioId++;
-        if (trackInfo->codec_ == "aac") {
+        if (trackInfo->codec_ == CodecAAC) {
             _audioCodec = STREAM_TYPE_AUDIO_AAC;
-        } else if (trackInfo->codec_ == "g711a") {
+        } else if (trackInfo->codec_ == CodecG711A) {
             _audioCodec = STREAM_TYPE_AUDIO_G711;
-        } else if (trackInfo->codec_ == "g711u") {
+        } else if (trackInfo->codec_ == CodecG711U) {
             _audioCodec = STREAM_TYPE_AUDIO_G711ULAW;
-        } else if (trackInfo->codec_ == "mp3") {
+        } else if (trackInfo->codec_ == CodecMP3) {
             _audioCodec = STREAM_TYPE_AUDIO_MP3;
-        } else if (trackInfo->codec_ == "opus") {
+        } else if (trackInfo->codec_ == CodecOpus) {
             _audioCodec = STREAM_TYPE_AUDIO_OPUS;
         } else {
             throw runtime_error("unsupport audio codec: " + trackInfo->codec_);
@@ -343,7 +343,12 @@ void TsDemuxer::pushConsumerMessage(shared_ptr<TsMessage> msg)
     }
 
     int index = msg->is_video() ? VideoTrackType : AudioTrackType;
-    onDecode((char*)msg->packet_data_.data(), msg->packet_data_.size(), index, msg->pts_, msg->dts_);
+    auto info = pidInfo(msg->pid_);
+    if (info) {
+        info->last_pes_size_ = msg->packet_data_.size();
+    }
+    // PES数据直接移交给帧，不再拷贝
+    onDecode(std::move(msg->packet_data_), index, msg->pts_, msg->dts_);
 
     msgs_[msg->pid_] = nullptr;
 }
@@ -402,24 +407,16 @@ void TsPacketHeader::demux(const StreamBuffer::Ptr& buffer)
 
     sync_ = payload[0];
     pid_ = payload[1] << 8 | payload[2];
-    logDebug << "all byte pid: " << (int)pid_;
-    logDebug << "payload[1]: " << (int)payload[1];
-    logDebug << "payload[2]: " << (int)payload[2];
     transport_error_indicator_ = (pid_ >> 15) & 0x01;
     payload_unit_start_indicator_ = (pid_ >> 14) & 0x01;
     transport_priority_ = (pid_ >> 13) & 0x01;
     pid_ &= 0x1FFF;
 
-    logDebug << "pid: " << (int)pid_;
-    logDebug << "payload_unit_start_indicator_: " << (int)payload_unit_start_indicator_;
-
     continuity_counter_ = payload[3];
     transport_scrambling_control_ = (continuity_counter_ >> 6) & 0x03;
     adaptation_field_control_ = (continuity_counter_ >> 4) & 0x03;
     continuity_counter_ &= 0x0F;
 
-    logDebug << "continuity_counter_: " << (int)continuity_counter_;
-
     buffer->substr(4);
 }
 
@@ -456,7 +453,6 @@ void TsPayload::demux(TsDemuxer *ctx, TsPacket *pkt, const StreamBuffer::Ptr& bu
         return ;
     }
 
-    logDebug << "ts pid: " << (int) (pkt->header_->pid_);
     if (pkt->header_->pid_ == TSPidTablePAT)
     {
         logTrace << "demux pat";
@@ -482,7 +478,6 @@ void TsPayload::demux(TsDemuxer *ctx, TsPacket *pkt, const StreamBuffer::Ptr& bu
     // }
     if (info && (info->pid_type_ == TsPidType::TsPidTypeAudio || info->pid_type_ == TsPidType::TsPidTypeVideo))
     {
-        logTrace << "demux media data";
         auto msg = ctx->message(info->pid_);
         if (!msg) {
             return ;
@@ -498,12 +493,10 @@ void TsPayload::demux(TsDemuxer *ctx, TsPacket *pkt, const StreamBuffer::Ptr& bu
             int32_t size = buffer->size();
             msg->append((int8_t*)buffer->data(), size);
             buffer->substr(size);
-            logDebug << "PES: msg size :" << size;
             return;
         }
         else
         {
-            logDebug << "msg->packet_start_code_prefix_" << (int)msg->packet_start_code_prefix_;
             if (msg->packet_start_code_prefix_ == 0x01)
             {
                 ctx->pushConsumerMessage(msg);
@@ -538,6 +531,9 @@ int TsPayloadPES::demux(TsDemuxer *ctx, TsPacket *pkt, const StreamBuffer::Ptr&
             return -1;
         }
         PES_packet_length_ = readUint16BE(payload + 4);
+        // 解析对象会被复用，没带时间戳的PES不能沿用上一个的值
+        PTS_ = 0;
+        DTS_ = 0;
         int pos = 6;
         int index = 6;
         if (stream_id_ != PES_program_stream_map &&
@@ -779,6 +775,12 @@ int TsPayloadPES::demux(TsDemuxer *ctx, TsPacket *pkt, const StreamBuffer::Ptr&
             }
             // msg->packet_data_ = new int8_t[msg->packet_data_size_];
             // memcpy(msg->packet_data_, payload + pos, cpSize);
+            // 按PES长度预分配，长度为0时参考该pid上一个PES的大小
+            if (PES_packet_length_ > 0) {
+                msg->packet_data_.reserve(msg->packet_data_size_);
+            } else if (pid->last_pes_size_ > 0) {
+                msg->packet_data_.reserve(pid->last_pes_size_ + pid->last_pes_size_ / 4);
+            }
             msg->packet_data_.assign(payload + pos, cpSize);
             pos += cpSize;
             msg->parsed_data_size_ += cpSize;
@@ -1136,6 +1138,18 @@ void TsDemuxer::onDecode(const char* data, int len, int index, uint64_t pts, uin
         return ;
     }
 
+    StringBuffer buffer;
+    buffer.assign(data, len);
+    onDecode(std::move(buffer), index, pts, dts);
+}
+
+void TsDemuxer::onDecode(StringBuffer&& data, int index, uint64_t pts, uint64_t dts)
+{
+    int len = data.size();
+    if (len == 0) {
+        return ;
+    }
+
     // if (index == VideoTrackType) {
     //     FILE* fp = fopen("testts.h264", "ab+");
     //     fwrite(data, len, 1, fp);
@@ -1165,7 +1179,7 @@ void TsDemuxer::onDecode(const char* data, int len, int index, uint64_t pts, uin
 
     if (index == AudioTrackType) {
         frame = FrameBuffer::createFrame(_audioCodec, 0, AudioTrackType, false);
-        if (_audioCodec == "aac") {
+        if (_audioCodec == CodecAAC) {
             // frame = make_shared<AacFrame>();
             frame->_startSize = 7;
         } else {
@@ -1187,7 +1201,7 @@ void TsDemuxer::onDecode(const char* data, int len, int index, uint64_t pts, uin
         dts = dts == 0 ? pts : dts;
         logDebug << "pts: " << pts;
         logDebug << "dts: " << dts;
-        frame->_buffer.assign(data, len);
+        frame->_buffer = std::move(data);
         frame->_pts = pts / 90; // pts * 1000 / 90000,计算为毫秒
         frame->_dts = dts / 90;
         frame->_index = index;
@@ -1195,7 +1209,7 @@ void TsDemuxer::onDecode(const char* data, int len, int index, uint64_t pts, uin
         frame->_codec = index == VideoTrackType ? _videoCodec : _audioCodec;
 
         if (index == VideoTrackType) {
-            if (_videoCodec == "h265") {
+            if (_videoCodec == CodecH265) {
                 frame->_startSize = 4;
                 if (readUint32BE(frame->data()) != 1) {
                     frame->_startSize = 3;
@@ -1236,7 +1250,7 @@ void TsDemuxer::onDecode(const char* data, int len, int index, uint64_t pts, uin
                     }
                 });
                 return ;
-            } else if (_videoCodec == "h264") {
+            } else if (_videoCodec == CodecH264) {
                 frame->_startSize = 4;
                 if (readUint32BE(frame->data()) != 1) {
                     frame->_startSize = 3;
@@ -1412,17 +1426,44 @@ bool searchTs(char* data, int size, int& pos)
     return false;
 }
 
+void TsDemuxer::demuxPacket(char* data)
+{
+    if (!_packet) {
+        _packet = make_shared<TsPacket>();
+        _packetBuffer = StreamBuffer::create();
+    }
+    // substr会移动偏移，复用前先复位
+    _packetBuffer->useAllBuffer();
+    _packetBuffer->move(data, tsPacketSize, false);
+
+    _packet->demux(this, _packetBuffer);
+}
+
 void TsDemuxer::onTsPacket(char* data, int size, uint32_t timestamp)
 {
+    StringBuffer pending;
     if (_remainBuffer.size() > 0) {
-        _remainBuffer.append(data, size);
-        data = _remainBuffer.data();
-        size = _remainBuffer.size();
-        _remainBuffer.clear();
+        if (_remainBuffer.size() < tsPacketSize && _remainBuffer.data()[0] == 0x47) {
+            // 只补齐上次剩下的那一个包，剩余输入原地解析
+            int len = min(size, (int)(tsPacketSize - _remainBuffer.size()));
+            _remainBuffer.append(data, len);
+            data += len;
+            size -= len;
+            if (_remainBuffer.size() < tsPacketSize) {
+                return ;
+            }
+            demuxPacket(_remainBuffer.data());
+            _remainBuffer.clear();
+        } else {
+            // 剩余数据没有对齐，拼接后重新搜索同步字节
+            _remainBuffer.append(data, size);
+            pending = std::move(_remainBuffer);
+            _remainBuffer.clear();
+            data = pending.data();
+            size = pending.size();
+        }
     }
 
-    logDebug << "input size: " << size;
-    logDebug << "timestamp: " << timestamp;
 
     while (size >= tsPacketSize) {
         if(data[0] != 0x47) {
@@ -1443,17 +1484,12 @@ void TsDemuxer::onTsPacket(char* data, int size, uint32_t timestamp)
                 return;
             }
         }
-        TsPacket packet;
-        StreamBuffer::Ptr buffer = StreamBuffer::create();
-        buffer->move(data, tsPacketSize, false);
-
-        packet.demux(this, buffer);
+        demuxPacket(data);
 
         data += tsPacketSize;
         size -= tsPacketSize;
     }
 
-    logDebug << "after demux size: " << size;
 
     if (size != 0) {
         _remainBuffer.assign(data, size);
@@ -82,6 +82,8 @@ struct TsPidInfo
     TsPidType pid_type_{TsPidTypeReserved};
     TSPidTable pid_{TSPidTable::TSPidTableNULL};
     uint8_t seq_{16};
+    // 上一个PES的负载大小，PES_packet_length为0时用来预分配
+    int32_t last_pes_size_{0};
 };
 
 class TsMessage
@@ -107,6 +109,8 @@ public:
     bool isEnd();
 };
 
+class TsPacket;
+
 class TsDemuxer
 {
 public:
@@ -120,6 +124,7 @@ public:
 
     void setOnDecode(const function<void(const FrameBuffer::Ptr& frame)> cb);
     void onDecode(const char* data, int len, int index, uint64_t pts, uint64_t dts);
+    void onDecode(StringBuffer&& data, int index, uint64_t pts, uint64_t dts);
     void addTrackInfo(const shared_ptr<TrackInfo>& trackInfo);
     void setOnTrackInfo(const function<void(const shared_ptr<TrackInfo>& trackInfo)>& cb);
     void setOnReady(const function<void()>& cb);
@@ -131,6 +136,9 @@ public:
     void createTrackInfo(const string& codec, int type);
     void clear();
 
+private:
+    void demuxPacket(char* data);
+
 private:
     bool _hasAudio = false;
     bool _hasVideo = false;
@@ -143,11 +151,14 @@ private:
     uint8_t _audio_es_type = 0;
     uint8_t _video_es_type = 0;
     int64_t _lastVideoPts = -1;
-    string _audioCodec = "unknwon";
-    string _videoCodec = "unknwon";
+    CodecId _audioCodec = CodecUnknown;
+    CodecId _videoCodec = CodecUnknown;
     TimeClock _timeClock;
     StringBuffer _remainBuffer;
     StringBuffer _videoStream;
+    // 每个ts包复用同一个解析对象和buffer，避免逐包分配
+    shared_ptr<TsPacket> _packet;
+    StreamBuffer::Ptr _packetBuffer;
     unordered_map<int, shared_ptr<TrackInfo>> _mapTrackInfo;
     function<void(const FrameBuffer::Ptr& frame)> _onFrame;
     function<void(const shared_ptr<TrackInfo>& trackInfo)> _onTrackInfo;
@@ -170,28 +170,28 @@ void TsMuxer::addTrackInfo(const shared_ptr<TrackInfo>& trackInfo)
     _mapTrackInfo[trackInfo->index_] = trackInfo;
     if (trackInfo->trackType_ == "video") {
         _mapStreamId[trackInfo->index_] = _lastVideoId++;
-        if (trackInfo->codec_ == "h264") {
+        if (trackInfo->codec_ == CodecH264) {
             _videoCodec = STREAM_TYPE_VIDEO_H264;
-        } else if (trackInfo->codec_ == "h265") {
+        } else if (trackInfo->codec_ == CodecH265) {
             _videoCodec = STREAM_TYPE_VIDEO_HEVC;
-        } else if (trackInfo->codec_ == "vp8") {
+        } else if (trackInfo->codec_ == CodecVP8) {
             _videoCodec = STREAM_TYPE_VIDEO_VP8;
-        } else if (trackInfo->codec_ == "vp9") {
+        } else if (trackInfo->codec_ == CodecVP9) {
             _videoCodec = STREAM_TYPE_VIDEO_VP9;
-        } else if (trackInfo->codec_ == "av1") {
+        } else if (trackInfo->codec_ == CodecAV1) {
             _videoCodec = STREAM_TYPE_VIDEO_AV1;
         }
     } else if (trackInfo->trackType_ == "audio") {
         _mapStreamId[trackInfo->index_] = _lastAudioId++;
-        if (trackInfo->codec_ == "aac") {
+        if (trackInfo->codec_ == CodecAAC) {
             _audioCodec = STREAM_TYPE_AUDIO_AAC;
-        } else if (trackInfo->codec_ == "g711a") {
+        } else if (trackInfo->codec_ == CodecG711A) {
             _audioCodec = STREAM_TYPE_AUDIO_G711;
-        } else if (trackInfo->codec_ == "g711u") {
+        } else if (trackInfo->codec_ == CodecG711U) {
             _audioCodec = STREAM_TYPE_AUDIO_G711ULAW;
-        } else if (trackInfo->codec_ == "mp3") {
+        } else if (trackInfo->codec_ == CodecMP3) {
             _audioCodec = STREAM_TYPE_AUDIO_MP3;
-        } else if (trackInfo->codec_ == "opus") {
+        } else if (trackInfo->codec_ == CodecOpus) {
             _audioCodec = STREAM_TYPE_AUDIO_OPUS;
         }
     }
@@ -314,9 +314,9 @@ int TsMuxer::make_pes_packet(const FrameBuffer::Ptr& frame)
 	int frameSize = frame->size();
 	int pesSize = frame->size() + 19; //frame size + pes header size
 
-	if (frame->_codec == "h265") {
+	if (frame->_codec == CodecH265) {
 		pesSize += 7;
-	} else if (frame->_codec == "h264") {
+	} else if (frame->_codec == CodecH264) {
 		pesSize += 6;
 	}
     
@@ -356,12 +356,12 @@ int TsMuxer::make_pes_packet(const FrameBuffer::Ptr& frame)
 		}
 		bits.i_data += nRet;
 
-		if (frame->_codec == "h265") {
+		if (frame->_codec == CodecH265) {
 			bits_write(&bits, 32, 0x00000001);
 			bits_write(&bits, 8, 0x46);
 			bits_write(&bits, 8, 0x01);
 			bits_write(&bits, 8, 0x50);
-		} else if (frame->_codec == "h264") {
+		} else if (frame->_codec == CodecH264) {
 			bits_write(&bits, 32, 0x00000001);
 			bits_write(&bits, 8, 0x09);
 			bits_write(&bits, 8, 0xF0);
@@ -399,12 +399,12 @@ int TsMuxer::make_pes_packet(const FrameBuffer::Ptr& frame)
 		}
 		bits.i_data += nRet;
 
-		if (frame->_codec == "h265") {
+		if (frame->_codec == CodecH265) {
 			bits_write(&bits, 32, 0x00000001);
 			bits_write(&bits, 8, 0x46);
 			bits_write(&bits, 8, 0x01);
 			bits_write(&bits, 8, 0x50);
-		} else if (frame->_codec == "h264") {
+		} else if (frame->_codec == CodecH264) {
 			bits_write(&bits, 32, 0x00000001);
 			bits_write(&bits, 8, 0x09);
 			bits_write(&bits, 8, 0xF0);
@@ -268,3 +268,70 @@ void adpcm_decoder(char *indata, short *outdata, int len, adpcm_state *state)
 	state->valprev = valpred;
 	state->index = index;
 }
+
+/*
+ * 对每个(index, delta)预先算好带符号的vpdiff和下一个index，
+ * 解码时每个采样只需两次查表、一次加法和一次限幅
+ */
+class AdpcmTable
+{
+public:
+	AdpcmTable()
+	{
+		for (int index = 0; index < 89; index++) {
+			int step = stepsizeTable[index];
+			for (int delta = 0; delta < 16; delta++) {
+				int vpdiff = step >> 3;
+				if ( delta & 4 ) vpdiff += step;
+				if ( delta & 2 ) vpdiff += step>>1;
+				if ( delta & 1 ) vpdiff += step>>2;
+				diff[index][delta] = (delta & 8) ? -vpdiff : vpdiff;
+
+				int next = index + indexTable[delta];
+				if ( next < 0 ) next = 0;
+				if ( next > 88 ) next = 88;
+				nextIndex[index][delta] = next;
+			}
+		}
+	}
+
+	static const AdpcmTable &instance()
+	{
+		static AdpcmTable table;
+		return table;
+	}
+
+public:
+	int diff[89][16];
+	unsigned char nextIndex[89][16];
+};
+
+void adpcm_decoder_table(const char *indata, short *outdata, int len, adpcm_state *state)
+{
+	const AdpcmTable &table = AdpcmTable::instance();
+	const unsigned char *inp = (const unsigned char *)indata;
+	int valpred = state->valprev;
+	int index = state->index;
+	if ( index < 0 ) index = 0;
+	if ( index > 88 ) index = 88;
+
+	for ( int i = 0; i < len; i++ ) {
+		int delta = (i & 1) ? (inp[i >> 1] & 0xf) : (inp[i >> 1] >> 4);
+
+		valpred += table.diff[index][delta];
+		if ( valpred > 32767 )
+			valpred = 32767;
+		else if ( valpred < -32768 )
+			valpred = -32768;
+		index = table.nextIndex[index][delta];
+
+#ifdef ADPCM_ENDIAN_SWAP
+		outdata[i] = swap_int16(valpred);
+#else
+		outdata[i] = valpred;
+#endif
+	}
+
+	state->valprev = valpred;
+	state->index = index;
+}
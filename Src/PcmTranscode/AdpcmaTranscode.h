@@ -11,6 +11,9 @@ void adpcm_coder(short *indata, char *outdata, int len, adpcm_state *state);
 
 void adpcm_decoder(char *indata, short *outdata, int len, adpcm_state *state);
 
+/* 与adpcm_decoder结果一致，用预计算的(index, delta)表代替逐位计算 */
+void adpcm_decoder_table(const char *indata, short *outdata, int len, adpcm_state *state);
+
 
 #endif
 
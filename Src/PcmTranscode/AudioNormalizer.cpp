@@ -0,0 +1,144 @@
+#include "AudioNormalizer.h"
+#include "G711Transcode.h"
+#include "Logger.h"
+#include "Common/Config.h"
+#include "Codec/G711Track.h"
+
+#include <chrono>
+
+using namespace std;
+
+static uint64_t nowUs()
+{
+    return chrono::duration_cast<chrono::microseconds>(
+        chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+AudioNormalizer::AudioNormalizer(const string& srcCodec, const string& dstCodec)
+    :_srcCodec(srcCodec)
+    ,_dstCodec(dstCodec)
+{
+    _adpcmState.valprev = 0;
+    _adpcmState.index = 0;
+}
+
+bool AudioNormalizer::isSupported(const string& srcCodec)
+{
+    return srcCodec == "adpcma" || srcCodec == "g726";
+}
+
+string AudioNormalizer::getTargetCodec()
+{
+    static string targetCodec = Config::instance()->getAndListen([](const json &config){
+        targetCodec = Config::instance()->get("Util", "audioNormalize");
+    }, "Util", "audioNormalize");
+
+    if (targetCodec == "g711a" || targetCodec == "g711u") {
+        return targetCodec;
+    }
+
+    return "";
+}
+
+shared_ptr<TrackInfo> AudioNormalizer::createTrackInfo(int index)
+{
+    if (_dstCodec == "g711u") {
+        return G711uTrack::createTrack(index, 0, 8000);
+    }
+
+    return G711aTrack::createTrack(index, 8, 8000);
+}
+
+void AudioNormalizer::setG726BitRate(int bitRate)
+{
+    _g726BitRate = bitRate;
+    _g726Inited = false;
+}
+
+const short* AudioNormalizer::decodeAdpcm(const uint8_t* data, size_t size, size_t& samples)
+{
+    if (size < 4) {
+        return nullptr;
+    }
+
+    // 海思的adpcm帧头，带有解码器状态
+    if (size >= 8 && data[0] == 0x00 && data[1] == 0x01 && 
+            data[2] == (size - 4) / 2 && data[3] == 0x00)
+    {
+        _adpcmState.valprev = (short)((data[5] << 8) | data[4]);
+        _adpcmState.index = data[6];
+        data += 8;
+        size -= 8;
+    } else {
+        _adpcmState.valprev = (short)((data[1] << 8) | data[0]);
+        _adpcmState.index = data[2];
+        data += 4;
+        size -= 4;
+    }
+
+    samples = size * 2;
+    if (_pcm.size() < samples) {
+        _pcm.resize(samples);
+    }
+    adpcm_decoder_table((const char*)data, _pcm.data(), samples, &_adpcmState);
+
+    return _pcm.data();
+}
+
+const short* AudioNormalizer::decodeG726(const uint8_t* data, size_t size, size_t& samples)
+{
+    if (!_g726Inited) {
+        g726_init(&_g726State, _g726BitRate);
+        _g726Inited = true;
+    }
+
+    // 每个采样至少2bit
+    size_t maxSamples = size * 4;
+    if (_pcm.size() < maxSamples) {
+        _pcm.resize(maxSamples);
+    }
+    int result = g726_decode(&_g726State, _pcm.data(), data, size);
+    if (result <= 0) {
+        return nullptr;
+    }
+    samples = result;
+
+    return _pcm.data();
+}
+
+FrameBuffer::Ptr AudioNormalizer::normalize(const FrameBuffer::Ptr& frame)
+{
+    auto start = nowUs();
+    auto data = (const uint8_t*)frame->data() + frame->startSize();
+    size_t size = frame->size() - frame->startSize();
+
+    size_t samples = 0;
+    const short* pcm = nullptr;
+    if (_srcCodec == "adpcma") {
+        pcm = decodeAdpcm(data, size, samples);
+    } else if (_srcCodec == "g726") {
+        pcm = decodeG726(data, size, samples);
+    }
+
+    if (!pcm || samples == 0) {
+        return nullptr;
+    }
+
+    auto newFrame = FrameBuffer::createFrame(_dstCodec, 0, frame->_index, 0);
+    newFrame->_buffer.resize(samples);
+    if (_dstCodec == "g711u") {
+        G711Transcode::pcm_2_ulaw(pcm, (uint8_t*)newFrame->data(), samples);
+    } else {
+        G711Transcode::pcm_2_alaw(pcm, (uint8_t*)newFrame->data(), samples);
+    }
+    newFrame->_pts = frame->_pts;
+    newFrame->_dts = frame->_dts;
+    newFrame->_index = frame->_index;
+    newFrame->_codec = _dstCodec;
+    newFrame->_trackType = AudioTrackType;
+
+    ++_frameCount;
+    _costUs += nowUs() - start;
+
+    return newFrame;
+}
@@ -0,0 +1,59 @@
+#ifndef AudioNormalizer_H
+#define AudioNormalizer_H
+
+#include <string>
+#include <memory>
+#include <vector>
+
+#include "Common/Frame.h"
+#include "Common/Track.h"
+#include "AdpcmaTranscode.h"
+#include "G726Transcode.h"
+
+using namespace std;
+
+// 把adpcma/g726音频帧转换成g711a/g711u，不依赖ffmpeg
+// 每个流每个音轨一个实例，有协议源时才创建，转换结果由所有协议源共享
+class AudioNormalizer
+{
+public:
+    using Ptr = shared_ptr<AudioNormalizer>;
+
+    AudioNormalizer(const string& srcCodec, const string& dstCodec);
+    ~AudioNormalizer() = default;
+
+public:
+    // srcCodec是否需要转换
+    static bool isSupported(const string& srcCodec);
+    // 读取配置Util.audioNormalize，为空表示不转换
+    static string getTargetCodec();
+
+    // 转换后的track信息
+    shared_ptr<TrackInfo> createTrackInfo(int index);
+    // 转换失败返回nullptr
+    FrameBuffer::Ptr normalize(const FrameBuffer::Ptr& frame);
+
+    // g726的码率，单位bit/s，默认16000
+    void setG726BitRate(int bitRate);
+
+    uint64_t getFrameCount() {return _frameCount;}
+    uint64_t getCostUs() {return _costUs;}
+
+private:
+    const short* decodeAdpcm(const uint8_t* data, size_t size, size_t& samples);
+    const short* decodeG726(const uint8_t* data, size_t size, size_t& samples);
+
+private:
+    bool _g726Inited = false;
+    int _g726BitRate = 16000;
+    uint64_t _frameCount = 0;
+    uint64_t _costUs = 0;
+    string _srcCodec;
+    string _dstCodec;
+    adpcm_state _adpcmState;
+    g726_state_t _g726State;
+    // 解码后的pcm，复用避免每帧分配
+    vector<short> _pcm;
+};
+
+#endif //AudioNormalizer_H
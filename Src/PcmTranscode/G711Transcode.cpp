@@ -312,38 +312,86 @@ ulaw2alaw(
 
 ///////////////////////////////////////////////////////////////////
 
+/*
+ * linear2alaw只用到pcm的高13位，linear2ulaw只用到高14位，
+ * 预先算好全部结果，编解码时每个采样只需要查一次表
+ */
+class G711Table
+{
+public:
+	G711Table()
+	{
+		for (int i = 0; i < 8192; i++) {
+			alaw[i] = linear2alaw((short)(i << 3));
+		}
+		for (int i = 0; i < 16384; i++) {
+			ulaw[i] = linear2ulaw((short)(i << 2));
+		}
+		for (int i = 0; i < 256; i++) {
+			alaw2pcm[i] = alaw2linear(i);
+			ulaw2pcm[i] = ulaw2linear(i);
+		}
+	}
+
+	static const G711Table &instance()
+	{
+		static G711Table table;
+		return table;
+	}
+
+public:
+	unsigned char alaw[8192];
+	unsigned char ulaw[16384];
+	short alaw2pcm[256];
+	short ulaw2pcm[256];
+};
+
+const unsigned char *G711Transcode::alaw_table()
+{
+	return G711Table::instance().alaw;
+}
+
+const unsigned char *G711Transcode::ulaw_table()
+{
+	return G711Table::instance().ulaw;
+}
+
 void G711Transcode::pcm_2_alaw(const short *src_16lepcm, unsigned char *dst_alaw, unsigned int sample_cnt)
 {
-	for (int i = 0; i < sample_cnt; i++)
+	const unsigned char *table = G711Table::instance().alaw;
+	for (unsigned int i = 0; i < sample_cnt; i++)
 	{
-		dst_alaw[i] = linear2alaw(src_16lepcm[i]);
+		dst_alaw[i] = table[(unsigned short)src_16lepcm[i] >> 3];
 	}
 }
 
 
 void G711Transcode::alaw_2_pcm(const unsigned char *src_alaw, short *dst_16lepcm, unsigned int sample_cnt)
 {
-	for (int i = 0; i < sample_cnt; i++)
+	const short *table = G711Table::instance().alaw2pcm;
+	for (unsigned int i = 0; i < sample_cnt; i++)
 	{
-		dst_16lepcm[i] = alaw2linear(src_alaw[i]);
+		dst_16lepcm[i] = table[src_alaw[i]];
 	}
 }
 
 
 void G711Transcode::pcm_2_ulaw(const short *src_16lepcm, unsigned char *dst_ulaw, unsigned int sample_cnt)
 {
-	for (int i = 0; i < sample_cnt; i++)
+	const unsigned char *table = G711Table::instance().ulaw;
+	for (unsigned int i = 0; i < sample_cnt; i++)
 	{
-		dst_ulaw[i] = linear2ulaw(src_16lepcm[i]);
+		dst_ulaw[i] = table[(unsigned short)src_16lepcm[i] >> 2];
 	}
 }
 
 
 void G711Transcode::ulaw_2_pcm(const unsigned char *src_ulaw, short *dst_16lepcm, unsigned int sample_cnt)
 {
-	for (int i = 0; i < sample_cnt; i++)
+	const short *table = G711Table::instance().ulaw2pcm;
+	for (unsigned int i = 0; i < sample_cnt; i++)
 	{
-		dst_16lepcm[i] = ulaw2linear(src_ulaw[i]);
+		dst_16lepcm[i] = table[src_ulaw[i]];
 	}
 }
 
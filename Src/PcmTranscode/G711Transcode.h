@@ -10,6 +10,10 @@ public:
     static void ulaw_2_pcm(const unsigned char *src_ulaw, short *dst_16lepcm, unsigned int sample_cnt);
     static void alaw_2_ulaw(const unsigned char *src_alaw, char *dst_ulaw, unsigned int sample_cnt);
     static void ulaw_2_alaw(const unsigned char *src_ulaw, char *dst_alaw, unsigned int sample_cnt);
+
+    // 预计算的编码表，a-law以pcm的高13位为下标，u-law以高14位为下标
+    static const unsigned char *alaw_table();
+    static const unsigned char *ulaw_table();
 };
 
 #endif
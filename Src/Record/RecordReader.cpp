@@ -103,6 +103,159 @@ void RecordReader::close()
     _onFrame = nullptr;
 }
 
+void RecordReader::updateScale(float scale)
+{
+    static float trickPlayScale = Config::instance()->getAndListen([](const json &config){
+        trickPlayScale = Config::instance()->get("Record", "trickPlayScale");
+    }, "Record", "trickPlayScale", "", "", "4");
+
+    weak_ptr<RecordReader> wSelf = shared_from_this();
+    _loop->async([wSelf, scale](){
+        auto self = wSelf.lock();
+        if (!self) {
+            return ;
+        }
+
+        bool trickPlay = scale < 0 || (trickPlayScale > 1 && scale >= trickPlayScale);
+        bool trickEnd = false;
+        uint64_t endDts = 0;
+        {
+            lock_guard<mutex> lck(self->_mtxFrameList);
+            if (trickPlay) {
+                if (self->_trickPlay) {
+                    // 变速时从上一个关键帧重新计时，输出的时间戳保持递增
+                    self->_trickOutDts += self->_trickClock.startToNow();
+                    self->_trickStartDts = self->_trickLastDts;
+                } else {
+                    self->_trickOutDts = self->_lastFrameTime / (self->_scale > 0 ? self->_scale : 1);
+                    self->_trickStartDts = self->_lastFrameTime;
+                    self->_trickLastDts = self->_lastFrameTime;
+                    self->_frameList.clear();
+                    self->_trickFrameList.clear();
+                }
+                logInfo << "trick play, scale: " << scale << ", start: " << self->_trickStartDts;
+                self->_trickPlay = true;
+                self->_trickEnd = false;
+                self->_trickBytes = 0;
+                self->_trickLastBytes = 0;
+                self->_trickClock.start();
+                self->_scale = scale;
+                return ;
+            }
+
+            if (self->_trickPlay) {
+                logInfo << "trick play end, scale: " << scale << ", position: " << self->_trickLastDts;
+                self->_trickPlay = false;
+                self->_trickFrameList.clear();
+                self->_frameList.clear();
+                self->_lastFrameTime = self->_trickLastDts;
+                trickEnd = true;
+                endDts = self->_trickLastDts;
+            }
+            self->_scale = scale;
+            self->_clock.update();
+            self->_baseDts = self->_lastFrameTime;
+        }
+
+        // 子类会重新seek并加锁，放到锁外
+        if (trickEnd) {
+            self->onTrickPlayEnd(endDts);
+        }
+    }, true);
+}
+
+int RecordReader::onTrickPlayTimer()
+{
+    static int trickPlayBitrate = Config::instance()->getAndListen([](const json &config){
+        trickPlayBitrate = Config::instance()->get("Record", "trickPlayBitrate");
+    }, "Record", "trickPlayBitrate", "", "", "0");
+
+    if (_trickReading) {
+        return 10;
+    }
+
+    uint64_t now = _trickClock.startToNow();
+    // 在锁里取出帧，回调放到锁外，避免上层回调里再操作reader时死锁
+    list<FrameBuffer::Ptr> frames;
+    {
+        lock_guard<mutex> lck(_mtxFrameList);
+        // 切到关键帧模式前已经发出去的读任务，读到的帧直接丢掉
+        _frameList.clear();
+        if (!_trickFrameList.empty()) {
+            _trickLastBytes = 0;
+            _lastFrameTime = _trickLastDts;
+        }
+        frames.swap(_trickFrameList);
+    }
+
+    for (auto& frame : frames) {
+        frame->_dts = _trickOutDts + now;
+        frame->_pts = frame->_dts;
+        _trickBytes += frame->size();
+        _trickLastBytes += frame->size();
+        if (_onFrame) {
+            _onFrame(frame);
+        }
+    }
+
+    if (_trickEnd || _isPause) {
+        return 10;
+    }
+
+    // 按码率限速，倍速越高跳过的关键帧越多，输出码率和正常播放差不多
+    uint64_t bytesPerMs = trickPlayBitrate * 1000 / 8 / 1000;
+    auto duration = getDuration();
+    if (bytesPerMs == 0 && duration > 0) {
+        bytesPerMs = getFileSize() / duration;
+    }
+    if (bytesPerMs > 0 && _trickBytes + _trickLastBytes > now * bytesPerMs) {
+        return 10;
+    }
+
+    bool reverse = _scale < 0;
+    int64_t offset = now * (reverse ? -_scale : _scale);
+    int64_t target = reverse ? (int64_t)_trickStartDts - offset : _trickStartDts + offset;
+    if (target < 0) {
+        target = 0;
+    }
+
+    _trickReading = true;
+    weak_ptr<RecordReader> wSelf = shared_from_this();
+    int64_t lastDts = _trickLastDts;
+    auto task = make_shared<WorkTask>();
+    task->priority_ = 100;
+    task->func_ = [wSelf, target, lastDts, reverse](){
+        auto self = wSelf.lock();
+        if (!self) {
+            return ;
+        }
+        int64_t dts = 0;
+        int ret = self->readKeyframe(target, lastDts, reverse, dts);
+        self->_loop->async([wSelf, ret, dts, reverse](){
+            auto self = wSelf.lock();
+            if (!self) {
+                return ;
+            }
+            self->_trickReading = false;
+            if (ret == 1) {
+                self->_trickLastDts = dts;
+            } else if (ret == 0) {
+                logInfo << "trick play reach the " << (reverse ? "begin" : "end");
+                self->_trickEnd = true;
+                if (!reverse) {
+                    self->stop();
+                }
+            } else if (ret < 0) {
+                logWarn << "trick play is not supported: " << self->_filePath;
+                self->_trickEnd = true;
+            }
+        }, true);
+    };
+    _workLoop->addOrderTask(task);
+
+    return 10;
+}
+
 void RecordReader::setOnTrackInfo(const function<void(const TrackInfo::Ptr& trackInfo)>& cb)
 {
     _onTrackInfo = cb;
@@ -42,8 +42,33 @@ public:
     void setOnFrame(const function<void(const FrameBuffer::Ptr& frame)>& cb);
     void setOnClose(const function<void()>& cb);
 
+protected:
+    // 倍速播放，超过Record.trickPlayScale或倒放时只读关键帧
+    // 读关键帧在workLoop里执行，读到的帧放到_trickFrameList，dts返回关键帧的位置
+    // target为按当前速度算出的播放位置，lastDts为上一个关键帧的位置
+    // 返回1读到了关键帧，2还没到下一个关键帧，0到头了，-1不支持
+    virtual int readKeyframe(int64_t target, int64_t lastDts, bool reverse, int64_t& dts) {return -1;}
+    // 退出关键帧模式后从lastDts继续正常读
+    virtual void onTrickPlayEnd(uint64_t lastDts) {}
+    // 文件平均码率，用于关键帧模式的限速
+    virtual uint64_t getFileSize() {return 0;}
+
+    void updateScale(float scale);
+    // 关键帧模式下的定时器，返回下次执行的间隔
+    int onTrickPlayTimer();
+
 protected:
     bool _isPause = false;
+    bool _trickPlay = false;
+    bool _trickReading = false;
+    bool _trickEnd = false;
+    int64_t _trickLastDts = -1;
+    uint64_t _trickStartDts = 0;
+    uint64_t _trickOutDts = 0;
+    uint64_t _trickBytes = 0;
+    // 上一个关键帧(含sps/pps)的大小，用来预估下一个
+    uint64_t _trickLastBytes = 0;
+    TimeClock _trickClock;
     int _loopCount = 1;
     int _curLoopCount = 0;
     float _scale = 1;
@@ -56,6 +81,7 @@ protected:
     TimeClock _clock;
     mutex _mtxFrameList;
     list<FrameBuffer::Ptr> _frameList;
+    list<FrameBuffer::Ptr> _trickFrameList;
     function<void(const TrackInfo::Ptr& trackInfo)> _onTrackInfo;
     function<void()> _onReady;
     function<void()> _onClose;
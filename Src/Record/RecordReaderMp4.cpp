@@ -100,6 +100,12 @@ bool RecordReaderMp4::initMp4()
             return ;
         }
         lock_guard<mutex> lck(self->_mtxFrameList);
+        if (self->_readingKeyframe) {
+            if (frame->_trackType == VideoTrackType) {
+                self->_trickFrameList.push_back(frame);
+            }
+            return ;
+        }
         self->_frameList.push_back(frame);
         // self->_onFrame(frame);
         // self->_lastFrameTime = frame->dts();
@@ -167,6 +173,10 @@ bool RecordReaderMp4::start()
             return 0;
         }
 
+        if (self->_trickPlay) {
+            return self->onTrickPlayTimer();
+        }
+
         if (self->_isPause) {
             return 40;
         }
@@ -354,9 +364,34 @@ void RecordReaderMp4::pause(bool isPause)
 
 void RecordReaderMp4::scale(float scale)
 {
-    _scale = scale;
-    _clock.update();
-    _baseDts = _lastFrameTime;
+    updateScale(scale);
+}
+
+int RecordReaderMp4::readKeyframe(int64_t target, int64_t lastDts, bool reverse, int64_t& dts)
+{
+    if (!_mp4Reader) {
+        return -1;
+    }
+    _readingKeyframe = true;
+    int ret = _mp4Reader->mov_reader_read_keyframe(target, lastDts, reverse, &dts);
+    _readingKeyframe = false;
+
+    return ret;
+}
+
+void RecordReaderMp4::onTrickPlayEnd(uint64_t lastDts)
+{
+    // 其他track还停在进入关键帧模式的位置，重新seek一次
+    seek(lastDts);
+}
+
+uint64_t RecordReaderMp4::getFileSize()
+{
+    if (_mp4Reader) {
+        return _mp4Reader->getFileSize();
+    }
+
+    return 0;
 }
 
 uint64_t RecordReaderMp4::getDuration()
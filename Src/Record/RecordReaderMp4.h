@@ -26,10 +26,17 @@ public:
     void scale(float scale) override;
     uint64_t getDuration() override;
 
+protected:
+    int readKeyframe(int64_t target, int64_t lastDts, bool reverse, int64_t& dts) override;
+    void onTrickPlayEnd(uint64_t lastDts) override;
+    uint64_t getFileSize() override;
+
 private:
     bool initMp4();
 
 private:
+    // 只在workLoop里读写
+    bool _readingKeyframe = false;
     Mp4FileReader::Ptr _mp4Reader;
 };
 
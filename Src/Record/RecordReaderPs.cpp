@@ -69,6 +69,17 @@ bool RecordReaderPs::start()
             return ;
         }
         lock_guard<mutex> lck(self->_mtxFrameList);
+        if (self->_readingKeyframe) {
+            // 只要关键帧和前面的参数集
+            if (self->_gotKeyframe || frame->_trackType != VideoTrackType) {
+                return ;
+            }
+            if (frame->keyFrame() || frame->metaFrame()) {
+                self->_trickFrameList.push_back(frame);
+            }
+            self->_gotKeyframe = frame->keyFrame();
+            return ;
+        }
         self->_frameList.push_back(frame);
     });
     _demuxer->setOnReady([wSelf](){
@@ -99,6 +110,10 @@ bool RecordReaderPs::start()
             return 0;
         }
 
+        if (self->_trickPlay) {
+            return self->onTrickPlayTimer();
+        }
+
         if (self->_isPause) {
             return 40;
         }
@@ -266,9 +281,185 @@ void RecordReaderPs::pause(bool isPause)
 
 void RecordReaderPs::scale(float scale)
 {
-    _scale = scale;
-    _clock.update();
-    _baseDts = _lastFrameTime;
+    updateScale(scale);
+}
+
+void RecordReaderPs::buildKeyframeIndex()
+{
+    static const int kChunkSize = 1024 * 1024;
+    // 每个任务扫的块数
+    static const int kStepChunks = 4;
+    // 关键帧包跨两块数据时，下一块从重叠的位置开始再找一次
+    static const int kOverlap = 4096;
+
+    _indexBuilding = true;
+    // 中间穿插了正常读文件的任务，扫完恢复文件位置
+    uint64_t readPos = _file.tell();
+    uint64_t chunkOffset = _indexOffset;
+    _file.seek(chunkOffset);
+    for (int i = 0; i < kStepChunks; ++i) {
+        auto buffer = _file.read(kChunkSize);
+        if (!buffer || buffer->size() == 0) {
+            _indexBuilt = true;
+            break;
+        }
+        int size = buffer->size();
+        int pos = 0;
+        while (pos < size) {
+            uint64_t pts = 0;
+            int offset = _demuxer->findKeyframe(buffer->data() + pos, size - pos, pts);
+            if (offset < 0) {
+                break;
+            }
+            uint64_t fileOffset = chunkOffset + pos + offset;
+            if (_keyframeIndex.empty() || fileOffset > _keyframeIndex.back().offset) {
+                // 同一帧的sps、pps、idr可能分在几个ps包里，只记第一个
+                if (_keyframeIndex.empty() || pts != _keyframeIndex.back().dts) {
+                    _keyframeIndex.push_back({fileOffset, pts});
+                }
+            }
+            pos += offset + 4;
+        }
+        if (size < kChunkSize) {
+            _indexBuilt = true;
+            break;
+        }
+        chunkOffset += size - kOverlap;
+        _file.seek(chunkOffset);
+    }
+    _indexOffset = chunkOffset;
+    _file.seek(readPos);
+
+    if (_indexBuilt) {
+        _indexBuilding = false;
+        logInfo << "build ps keyframe index: " << _filePath << ", keyframes: " << _keyframeIndex.size();
+        return ;
+    }
+
+    weak_ptr<RecordReaderPs> wSelf = dynamic_pointer_cast<RecordReaderPs>(shared_from_this());
+    auto task = make_shared<WorkTask>();
+    task->priority_ = 100;
+    task->func_ = [wSelf](){
+        auto self = wSelf.lock();
+        if (!self) {
+            return ;
+        }
+        self->buildKeyframeIndex();
+    };
+    _workLoop->addOrderTask(task);
+}
+
+int RecordReaderPs::readKeyframe(int64_t target, int64_t lastDts, bool reverse, int64_t& dts)
+{
+    static const int kReadSize = 256 * 1024;
+    static const int kMaxReadSize = 4 * 1024 * 1024;
+
+    if (!_indexBuilt && !_indexBuilding) {
+        buildKeyframeIndex();
+    }
+    if (_keyframeIndex.empty()) {
+        // 扫完了也没有关键帧才是不支持
+        return _indexBuilt ? -1 : 2;
+    }
+
+    // 第一个dts大于(orEqual时为大于等于)clock的关键帧
+    auto bound = [this](int64_t clock, bool orEqual) -> size_t {
+        size_t start = 0, end = _keyframeIndex.size();
+        while (start < end) {
+            size_t mid = (start + end) / 2;
+            int64_t value = _keyframeIndex[mid].dts;
+            if (value > clock || (orEqual && value == clock)) {
+                end = mid;
+            } else {
+                start = mid + 1;
+            }
+        }
+        return start;
+    };
+
+    size_t index;
+    if (!reverse) {
+        size_t first = bound(lastDts, false);
+        size_t last = bound(target, false);
+        if (last > first) {
+            // 索引还没扫到target时，先出已经扫到的关键帧
+            index = last - 1;
+        } else if (!_indexBuilt) {
+            return 2;
+        } else if (first == _keyframeIndex.size()) {
+            return 0;
+        } else {
+            return 2;
+        }
+    } else {
+        // 索引从头开始扫，扫过lastDts后前面的关键帧才是全的
+        if (!_indexBuilt && (int64_t)_keyframeIndex.back().dts < lastDts) {
+            return 2;
+        }
+        size_t end = bound(lastDts, true);
+        if (end == 0) {
+            return 0;
+        }
+        size_t begin = bound(target, true);
+        if (begin >= end) {
+            return 2;
+        }
+        index = begin;
+    }
+
+    _file.seek(_keyframeIndex[index].offset);
+    _demuxer->clear();
+    _readingKeyframe = true;
+    _gotKeyframe = false;
+    int total = 0;
+    while (!_gotKeyframe && total < kMaxReadSize) {
+        auto buffer = _file.read(kReadSize);
+        if (!buffer || buffer->size() == 0) {
+            break;
+        }
+        _demuxer->onPsStream(buffer->data(), buffer->size(), 0, 0);
+        total += buffer->size();
+    }
+    _readingKeyframe = false;
+    _demuxer->clear();
+
+    dts = _keyframeIndex[index].dts;
+    return 1;
+}
+
+void RecordReaderPs::onTrickPlayEnd(uint64_t lastDts)
+{
+    weak_ptr<RecordReaderPs> wSelf = dynamic_pointer_cast<RecordReaderPs>(shared_from_this());
+    auto task = make_shared<WorkTask>();
+    task->priority_ = 100;
+    task->func_ = [wSelf, lastDts](){
+        auto self = wSelf.lock();
+        if (!self) {
+            return ;
+        }
+
+        // 直接从最后一个关键帧所在的ps包继续读
+        uint64_t offset = 0;
+        for (auto& keyframe : self->_keyframeIndex) {
+            if (keyframe.dts > lastDts) {
+                break;
+            }
+            offset = keyframe.offset;
+        }
+        self->_file.seek(offset);
+        self->_demuxer->clear();
+
+        lock_guard<mutex> lck(self->_mtxFrameList);
+        self->_frameList.clear();
+        self->_clock.update();
+        self->_baseDts = lastDts;
+    };
+    _workLoop->addOrderTask(task);
+}
+
+uint64_t RecordReaderPs::getFileSize()
+{
+    return _file.getFileSize();
 }
 
 uint64_t RecordReaderPs::getDuration()
@@ -1,11 +1,19 @@
 ﻿#ifndef RecordReaderPs_H
 #define RecordReaderPs_H
 
+#include <vector>
+
 #include "RecordReader.h"
 #include "Mpeg/PsDemuxer.h"
 
 using namespace std;
 
+struct PsKeyframeIndex
+{
+    uint64_t offset;
+    uint64_t dts;
+};
+
 class RecordReaderPs : public RecordReader
 {
 public:
@@ -26,8 +34,26 @@ public:
 
     void getDurationFromFile();
 
+protected:
+    int readKeyframe(int64_t target, int64_t lastDts, bool reverse, int64_t& dts) override;
+    void onTrickPlayEnd(uint64_t lastDts) override;
+    uint64_t getFileSize() override;
+
+private:
+    // ps没有索引，第一次倍速时开始从头扫文件，记下关键帧所在ps包的偏移
+    // 每个任务只扫几M，扫完再投递下一个任务，不会长时间占住workLoop
+    void buildKeyframeIndex();
+
 private:
     bool _isReading = false;
+    // 以下只在workLoop里读写
+    bool _readingKeyframe = false;
+    bool _gotKeyframe = false;
+    bool _indexBuilding = false;
+    bool _indexBuilt = false;
+    // 索引扫到的文件位置
+    uint64_t _indexOffset = 0;
+    vector<PsKeyframeIndex> _keyframeIndex;
     int _state = 0; // 1 : get first stamp; 2: get last stamp
     uint64_t _firstDts = 0;
     uint64_t _duration = 0;
@@ -17,7 +17,7 @@ AV1Frame::Ptr RtmpDecodeAV1::createFrame()
 {
     auto frame = make_shared<AV1Frame>();
     frame->_startSize = 0;
-    frame->_codec = "av1";
+    frame->_codec = CodecAV1;
     frame->_index = _trackInfo->index_;
     frame->_trackType = VideoTrackType;
 
@@ -27,51 +27,34 @@ AV1Frame::Ptr RtmpDecodeAV1::createFrame()
 void RtmpDecodeAV1::decode(const RtmpMessage::Ptr& msg)
 {
     uint8_t *payload = (uint8_t *)msg->payload->data();
-    auto end = payload + msg->length;
-    bool isEnhance = (payload[0] >> 4) & 0b1000;
-    uint8_t packet_type;
+    int length = msg->length;
 
-    if (isEnhance) {
-        packet_type = payload[0] & 0x0f;
-    } else {
-        packet_type = payload[1];
+    RtmpVideoHeader header;
+    if (!header.parse(payload, length)) {
+        return ;
     }
 
-    int length = msg->length;
-    if (/*_first && */packet_type == 0) {
+    if (header.isConfig()) {
         logInfo << "get a flv config";
-        // rtmp header 5 bytes, av1 header 4 bytes
-        if (length < 9) {
+        // rtmp header 5 bytes, av1C 4 bytes, 后面是configOBUs
+        int index = header.headerSize_ + 4;
+        if (length <= index) {
             return ;
         }
 
         auto frame = FrameBuffer::createFrame("av1", 0, _trackInfo->index_, false);
         frame->_pts = frame->_dts = msg->abs_timestamp;
-        frame->_buffer.append((char*)payload + 9, length - 9);
+        frame->_buffer.append((char*)payload + index, length - index);
         _trackInfo->setVps(frame);
         onFrame(frame);
-    } else {
-        // i b p
-        int num = 5;
-        int32_t cts = 0;
-
-        // if (isEnhance) {
-        //     if (packet_type == 1 || packet_type == 3) {
-        //         if (packet_type == 1) {
-        //             cts = (((payload[num] << 16) | (payload[num + 1] << 8) | (payload[num + 2])) + 0xff800000) ^ 0xff800000;
-        //             num += 3;
-        //         }
-        //     } else {
-        //         return ;
-        //     }
-        // }
-
-        payload += num;
-        if(payload < end) {
+    } else if (header.isFrame()) {
+        // i b p，av01的CodedFrames没有cts，legacy头里带的cts照样用上
+        int num = header.headerSize_;
+        if(num < length) {
             auto frame = FrameBuffer::createFrame("av1", 0, _trackInfo->index_, false);
             frame->_pts = frame->_dts = msg->abs_timestamp;
-            frame->_pts += cts;
-            frame->_buffer.append((char*)payload, end - payload);
+            frame->_pts += header.cts_;
+            frame->_buffer.append((char*)payload + num, length - num);
             
             onFrame(frame);
         }
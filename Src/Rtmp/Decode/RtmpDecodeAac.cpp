@@ -26,7 +26,7 @@ void RtmpDecodeAac::decode(const RtmpMessage::Ptr& msg)
         auto frame = make_shared<AacFrame>();
         
         frame->_startSize = 7;
-        frame->_codec = "aac";
+        frame->_codec = CodecAAC;
         frame->_index = _trackInfo->index_;
         frame->_trackType = AudioTrackType;
         frame->_dts = frame->_pts = msg->abs_timestamp;
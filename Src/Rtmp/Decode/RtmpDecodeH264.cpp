@@ -18,7 +18,7 @@ H264Frame::Ptr RtmpDecodeH264::createFrame()
 {
     auto frame = make_shared<H264Frame>();
     frame->_startSize = 4;
-    frame->_codec = "h264";
+    frame->_codec = CodecH264;
     frame->_index = _trackInfo->index_;
     frame->_trackType = VideoTrackType;
 
@@ -33,21 +33,32 @@ void RtmpDecodeH264::decode(const RtmpMessage::Ptr& msg)
     int stamp = msg->abs_timestamp;
 
     int length = msg->length;
-    if (/*_first && */payload[1] == 0) {
+    RtmpVideoHeader header;
+    if (!header.parse(payload, length)) {
+        return ;
+    }
+
+    if (/*_first && */header.isConfig()) {
         // sps pps
         // rtmp 头(5) + avcc 前八个字节(8) = 13；第11个字节是sps的数量；12、13字节是sps的长度
 
         // sps
-        if (length < 13) {
+        int index = header.headerSize_ + 5;
+        if (length < index + 3) {
             return ;
         }
-        int spsNum = payload[10] & 0x1f;
+        int spsNum = payload[index] & 0x1f;
         int spsCount = 0;
-        int index = 11;
+        index += 1;
         while (spsCount < spsNum) {
-            // 这里应该判断一下，剩余长度够不够
+            if (index + 2 > length) {
+                return ;
+            }
             int spsLen =(payload[index] & 0x000000FF) << 8 | (payload[index+1] & 0x000000FF);
             index += 2;
+            if (index + spsLen > length) {
+                return ;
+            }
             auto frame = createFrame();
             frame->_buffer.append((char*)payload + index, spsLen);
             frame->_pts = frame->_dts = stamp;
@@ -60,12 +71,21 @@ void RtmpDecodeH264::decode(const RtmpMessage::Ptr& msg)
         }
 
         // pps
+        if (index >= length) {
+            return ;
+        }
         int ppsNum = payload[index] & 0x1f;
         int ppsCount = 0;
         index += 1;
         while (ppsCount < ppsNum) {
+            if (index + 2 > length) {
+                return ;
+            }
             int ppsLen =(payload[index] & 0x000000FF) << 8 | (payload[index+1] & 0x000000FF);
             index += 2;
+            if (index + ppsLen > length) {
+                return ;
+            }
             auto frame = createFrame();
             frame->_buffer.append((char*)payload + index, ppsLen);
             frame->_pts = frame->_dts = stamp;
@@ -79,19 +99,22 @@ void RtmpDecodeH264::decode(const RtmpMessage::Ptr& msg)
         }
 
         // _first = false;
-    } else {
+    } else if (header.isFrame()) {
         // i b p
         int len =0;
-        int num =5;
-        uint8_t *cts_ptr = (uint8_t *)(payload + 2);
-        int32_t cts = (((cts_ptr[0] << 16) | (cts_ptr[1] << 8) | (cts_ptr[2])) + 0xff800000) ^ 0xff800000;
+        int num = header.headerSize_;
+        int32_t cts = header.cts_;
 
-        while(num < length) {
+        while(num + 4 <= length) {
 
             len = (payload[num] & 0x000000FF) << 24 | (payload[num+1] & 0x000000FF) << 16 | 
                     (payload[num+2] & 0x000000FF) << 8 | payload[num+3] & 0x000000FF;
 
             num += 4;
+            if (len <= 0 || num + len > length) {
+                logWarn << "invalid h264 nalu length: " << len;
+                return ;
+            }
 
             auto frame = createFrame();
             frame->_buffer.append((char*)payload + num, len);
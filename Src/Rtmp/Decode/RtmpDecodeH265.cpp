@@ -17,7 +17,7 @@ H265Frame::Ptr RtmpDecodeH265::createFrame()
 {
     auto frame = make_shared<H265Frame>();
     frame->_startSize = 4;
-    frame->_codec = "h265";
+    frame->_codec = CodecH265;
     frame->_index = _trackInfo->index_;
     frame->_trackType = VideoTrackType;
 
@@ -29,32 +29,39 @@ H265Frame::Ptr RtmpDecodeH265::createFrame()
 void RtmpDecodeH265::decode(const RtmpMessage::Ptr& msg)
 {
     uint8_t *payload = (uint8_t *)msg->payload->data();
-    bool isEnhance = (payload[0] >> 4) & 0b1000;
-    uint8_t packet_type;
+    int length = msg->length;
 
-    if (isEnhance) {
-        packet_type = payload[0] & 0x0f;
-    } else {
-        packet_type = payload[1];
+    RtmpVideoHeader header;
+    if (!header.parse(payload, length)) {
+        return ;
     }
 
-    int length = msg->length;
-    if (/*_first && */packet_type == 0) {
+    if (header.isConfig()) {
         logInfo << "get a flv config";
-        // rtmp header 5 bytes, hvcc 22 bytes
-        if (length < 28) {
+        // rtmp header 5 bytes, hvcc 22 bytes, numOfArrays 1 byte
+        int index = header.headerSize_ + 22;
+        if (length < index + 1) {
             return ;
         }
 
-        int numOfArr = payload[27];
-        int index = 28;
+        int numOfArr = payload[index++];
         logInfo << "numOfArr is : " << numOfArr;
         for (int i = 0; i < numOfArr; ++i) {
+            if (index + 3 > length) {
+                return ;
+            }
             int len =(payload[index + 1] & 0xFF) << 8 | (payload[index + 2] & 0xFF);
             index += 3;
             for (int j = 0; j < len; ++j) {
+                if (index + 2 > length) {
+                    return ;
+                }
                 int naluLen =(payload[index] & 0xFF) << 8 | (payload[index + 1] & 0xFF);
                 index += 2;
+                if (index + naluLen > length) {
+                    logWarn << "invalid hvcc nalu length: " << naluLen;
+                    return ;
+                }
 
                 auto frame = createFrame();
                 frame->_pts = frame->_dts = msg->abs_timestamp;
@@ -73,33 +80,25 @@ void RtmpDecodeH265::decode(const RtmpMessage::Ptr& msg)
                 onFrame(frame);
             }
         }
-    } else {
-        // i b p
+    } else if (header.isFrame()) {
+        // i b p，sequence end、metadata等不是帧数据
         int len =0;
-        int num =5;
-        int32_t cts = 0;
-
-        if (isEnhance) {
-            if (packet_type == 1 || packet_type == 3) {
-                if (packet_type == 1) {
-                    cts = (((payload[num] << 16) | (payload[num + 1] << 8) | (payload[num + 2])) + 0xff800000) ^ 0xff800000;
-                    num += 3;
-                }
-            } else {
-                return ;
-            }
-        }
+        int num = header.headerSize_;
 
-        while(num < length) {
+        while(num + 4 <= length) {
 
             len = (payload[num] & 0x000000FF) << 24 | (payload[num+1] & 0x000000FF) << 16 | 
                     (payload[num+2] & 0x000000FF) << 8 | payload[num+3] & 0x000000FF;
 
             num += 4;
+            if (len <= 0 || num + len > length) {
+                logWarn << "invalid h265 nalu length: " << len;
+                return ;
+            }
 
             auto frame = createFrame();
             frame->_pts = frame->_dts = msg->abs_timestamp;
-            frame->_pts += cts;
+            frame->_pts += header.cts_;
             frame->_buffer.append((char*)payload + num, len);
             
             onFrame(frame);
@@ -16,7 +16,7 @@ RtmpDecodeVPX::~RtmpDecodeVPX()
 FrameBuffer::Ptr RtmpDecodeVPX::createFrame()
 {
     FrameBuffer::Ptr frame;
-    if (_trackInfo->codec_ == "vp8") {
+    if (_trackInfo->codec_ == CodecVP8) {
         frame = make_shared<VP8Frame>();
     } else {
         frame = make_shared<VP9Frame>();
@@ -32,56 +32,33 @@ FrameBuffer::Ptr RtmpDecodeVPX::createFrame()
 void RtmpDecodeVPX::decode(const RtmpMessage::Ptr& msg)
 {
     uint8_t *payload = (uint8_t *)msg->payload->data();
-    auto end = payload + msg->length;
-    bool isEnhance = (payload[0] >> 4) & 0b1000;
-    uint8_t packet_type;
+    int length = msg->length;
 
-    if (isEnhance) {
-        packet_type = payload[0] & 0x0f;
-    } else {
-        packet_type = payload[1];
+    RtmpVideoHeader header;
+    if (!header.parse(payload, length)) {
+        return ;
     }
 
-    int length = msg->length;
-    if (/*_first && */packet_type == 0) {
+    if (header.isConfig()) {
         logInfo << "get a flv config";
-        // rtmp header 5 bytes, VPX header 8 bytes
-        if (length < 9) {
+        // rtmp header 5 bytes, vpcC的version和flags 4 bytes, 后面是VPCodecConfigurationRecord
+        int index = header.headerSize_ + 4;
+        if (length <= index) {
             return ;
         }
 
-        // auto frame = FrameBuffer::createFrame(_trackInfo->codec_, 0, _trackInfo->index_, false);
-        // frame->_pts = frame->_dts = msg->abs_timestamp;
-        // frame->_buffer.append((char*)payload + 5, length - 5);
-        // _trackInfo->setVps(frame);
         auto vp9Track = dynamic_pointer_cast<VP9Track>(_trackInfo);
-        // ffmpeg推过来的，rtmp header后还多了4个字节01 00 00 00
-        // 但是我encode的时候，没有加也正常播放
-        vp9Track->setConfig(string((char*)payload + 5 + 4, length - 5 - 4));
-        // onFrame(frame);
-    } else {
-        // i b p
-        int num = 5;
-        int32_t cts = 0;
-
-        // ffmpeg推过来的流没有cts字段
-        // if (isEnhance) {
-        //     if (packet_type == 1 || packet_type == 3) {
-        //         if (packet_type == 1) {
-        //             cts = (((payload[num] << 16) | (payload[num + 1] << 8) | (payload[num + 2])) + 0xff800000) ^ 0xff800000;
-        //             num += 3;
-        //         }
-        //     } else {
-        //         return ;
-        //     }
-        // }
-
-        payload += num;
-        if(payload < end) {
+        if (vp9Track) {
+            vp9Track->setConfig(string((char*)payload + index, length - index));
+        }
+    } else if (header.isFrame()) {
+        // i b p，vp09的CodedFrames没有cts
+        int num = header.headerSize_;
+        if(num < length) {
             auto frame = FrameBuffer::createFrame(_trackInfo->codec_, 0, _trackInfo->index_, false);
             frame->_pts = frame->_dts = msg->abs_timestamp;
-            frame->_pts += cts;
-            frame->_buffer.append((char*)payload, end - payload);
+            frame->_pts += header.cts_;
+            frame->_buffer.append((char*)payload + num, length - num);
             
             onFrame(frame);
         }
@@ -20,19 +20,19 @@ RtmpEncode::Ptr RtmpEncode::create(const shared_ptr<TrackInfo>& trackInfo)
 {
     logInfo << "codec: " << trackInfo->codec_;
     RtmpEncode::Ptr source;
-    if (trackInfo->codec_ == "h264") {
+    if (trackInfo->codec_ == CodecH264) {
         source = make_shared<RtmpEncodeH264>(trackInfo);
-    } else if (trackInfo->codec_ == "h265") {
+    } else if (trackInfo->codec_ == CodecH265) {
         source =  make_shared<RtmpEncodeH265>(trackInfo);
-    } else if (trackInfo->codec_ == "aac") {
+    } else if (trackInfo->codec_ == CodecAAC) {
         source =  make_shared<RtmpEncodeAac>(trackInfo);
-    } else if (trackInfo->codec_ == "vp9") {
+    } else if (trackInfo->codec_ == CodecVP9) {
         source =  make_shared<RtmpEncodeVPX>(trackInfo);
-    } else if (trackInfo->codec_ == "av1") {
+    } else if (trackInfo->codec_ == CodecAV1) {
         source =  make_shared<RtmpEncodeAV1>(trackInfo);
-    } else if (trackInfo->codec_ == "g711a" || trackInfo->codec_ == "g711u"
-            || trackInfo->codec_ == "mp3" || trackInfo->codec_ == "opus"
-            || trackInfo->codec_ == "adpcma") {
+    } else if (trackInfo->codec_ == CodecG711A || trackInfo->codec_ == CodecG711U
+            || trackInfo->codec_ == CodecMP3 || trackInfo->codec_ == CodecOpus
+            || trackInfo->codec_ == CodecAdpcma) {
         source =  make_shared<RtmpEncodeCommon>(trackInfo);
     } else {
         return nullptr;
@@ -108,7 +108,7 @@ void RtmpEncodeAV1::encode(const FrameBuffer::Ptr& frame)
     memcpy(data, frame->data(), length);
 
     msg->payload->setSize(index + length);
-    msg->abs_timestamp = _lastStamp;
+    msg->abs_timestamp = frame->pts();
     msg->trackIndex_ = _trackInfo->index_;
     msg->length = index + length;
     msg->type_id = RTMP_VIDEO;
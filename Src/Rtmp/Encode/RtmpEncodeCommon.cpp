@@ -8,13 +8,13 @@ using namespace std;
 int getFalg(const shared_ptr<TrackInfo>& trackInfo)
 {
     int audioType;
-    if (trackInfo->codec_ == "g711a") {
+    if (trackInfo->codec_ == CodecG711A) {
         audioType = RTMP_CODEC_ID_G711A;
-    } else if (trackInfo->codec_ == "g711u") {
+    } else if (trackInfo->codec_ == CodecG711U) {
         audioType = RTMP_CODEC_ID_G711U;
-    } else if (trackInfo->codec_ == "mp3") {
+    } else if (trackInfo->codec_ == CodecMP3) {
         audioType = RTMP_CODEC_ID_MP3;
-    } else if (trackInfo->codec_ == "adpcma") {
+    } else if (trackInfo->codec_ == CodecAdpcma) {
         audioType = RTMP_CODEC_ID_ADPCM;
     } else {
         return 0;
@@ -161,7 +161,7 @@ void RtmpEncodeH265::encode(const FrameBuffer::Ptr& frame)
     auto msg = make_shared<RtmpMessage>();
 
     if (!_append && !_vecFrame.empty()) {
-        if (_lastStamp != frame->pts() || frame->startSize() > 0) {
+        if (_lastStamp != frame->dts() || frame->startSize() > 0) {
             auto msg = make_shared<RtmpMessage>();
             msg->payload = make_shared<StreamBuffer>(_msgLength + 1);
             
@@ -249,7 +249,8 @@ void RtmpEncodeH265::encode(const FrameBuffer::Ptr& frame)
     }
     _vecFrame.push_back(frame);
 
-    _lastStamp = frame->pts();
+    // 和h264一样，rtmp的时间戳是dts，pts用cts表示
+    _lastStamp = frame->dts();
 }
 
 
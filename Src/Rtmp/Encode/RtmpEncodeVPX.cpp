@@ -29,7 +29,7 @@ string RtmpEncodeVPX::getConfig()
 
     string vpxConfig = _trackInfo->getConfig();
 
-    config.resize(5  + vpxConfig.size());
+    config.resize(9  + vpxConfig.size());
     auto data = (char*)config.data();
 
     if (_enhanced) {
@@ -38,11 +38,6 @@ string RtmpEncodeVPX::getConfig()
         *data++ = 'p';
         *data++ = '0';
         *data++ = '9';
-        // ffmpeg推的流，后面还有四个字节，不加也可以播
-        // *data++ = 0x01;
-        // *data++ = 0x00;
-        // *data++ = 0x00;
-        // *data++ = 0x00;
     } else {
         *data++ = 0x1c; //key frame, AVC
         *data++ = 0x00; //avc sequence header
@@ -50,6 +45,11 @@ string RtmpEncodeVPX::getConfig()
         *data++ = 0x00; //composit time
         *data++ = 0x00; //composit time
     }
+    // 和ffmpeg一样带上vpcC的version(1)和flags(0)，解码时会跳过这四个字节
+    *data++ = 0x01;
+    *data++ = 0x00;
+    *data++ = 0x00;
+    *data++ = 0x00;
 
     memcpy(data, vpxConfig.data(), vpxConfig.size()); 
 
@@ -107,7 +107,7 @@ void RtmpEncodeVPX::encode(const FrameBuffer::Ptr& frame)
     memcpy(data, frame->data(), length);
 
     msg->payload->setSize(index + length);
-    msg->abs_timestamp = _lastStamp;
+    msg->abs_timestamp = frame->pts();
     msg->trackIndex_ = _trackInfo->index_;
     msg->length = index + length;
     msg->type_id = RTMP_VIDEO;
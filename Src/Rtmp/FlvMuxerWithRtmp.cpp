@@ -92,6 +92,10 @@ void FlvMuxerWithRtmp::onPlay()
 	if (!_playReader) {
 		logDebug << "set _playReader, path: " << _urlParser.path_;
 		_playReader = rtmpSrc->getRing()->attach(EventLoop::getCurrentLoop(), true);
+		DataQueStartPolicy policy;
+		if (DataQueStartPolicy::parseParam(_urlParser.vecParam_, policy)) {
+			_playReader->setStartPolicy(policy);
+		}
 		_playReader->setGetInfoCB([wSelf]() {
 			auto self = wSelf.lock();
 			ClientInfo ret;
@@ -216,30 +220,16 @@ bool FlvMuxerWithRtmp::sendMediaData(uint8_t type, uint64_t timestamp, const Str
 
 	if (type == RTMP_VIDEO) {
 		if (!_hasKeyFrame) {
-			bool isEnhance = (payload->data()[0] >> 4) & 0b1000;
-			uint8_t frame_type;// = (payload->data()[0] >> 4) & 0x0f;
-			uint8_t codec_id;// = payload->data()[0] & 0x0f;
-			if (isEnhance) {
-				if (payload_size < 5) {
-					return false;
-				}
-				frame_type = (payload->data()[0] >> 4) & 0b0111;
-				if (readUint32BE((char*)payload->data() + 1) == fourccH265) {
-					codec_id = RTMP_CODEC_ID_H265;
-				} else if (readUint32BE((char*)payload->data() + 1) == fourccAV1) {
-					codec_id = RTMP_CODEC_ID_AV1;
-				} else if (readUint32BE((char*)payload->data() + 1) == fourccVP9) {
-					codec_id = RTMP_CODEC_ID_VP9;
-				}
-			} else {
-				frame_type = (payload->data()[0] >> 4) & 0x0f;
-				codec_id = payload->data()[0] & 0x0f;
+			RtmpVideoHeader header;
+			if (!header.parse((uint8_t*)payload->data(), payload_size)) {
+				return false;
 			}
 
-			logTrace << "frame_type : " << (int)frame_type << ", codec_id: " << (int)codec_id
+			logTrace << "frame_type : " << (int)header.frameType_ << ", codec_id: " << header.codecId_
 					<< ", timestamp: " << timestamp << ", path: " << _urlParser.path_;
 
-			if (frame_type == 1/* && (codec_id == RTMP_CODEC_ID_H264 || codec_id == RTMP_CODEC_ID_H265)*/) {
+			// 序列头已经在onPlay里发过了，从第一个关键帧开始发
+			if (header.isKeyFrame()) {
 				_hasKeyFrame = true;
 			}
 			else {
@@ -1,4 +1,5 @@
 #include "Rtmp.h"
+#include "Util/String.h"
 
 using namespace std;
 
@@ -98,4 +99,73 @@ int getIdByCodecName(int trackType, const string& codeName)
     }
 
     return 0;
-}
\ No newline at end of file
+}
+int getCodecIdByFourcc(uint32_t fourcc)
+{
+    if (fourcc == fourccH264) {
+        return RTMP_CODEC_ID_H264;
+    } else if (fourcc == fourccH265) {
+        return RTMP_CODEC_ID_H265;
+    } else if (fourcc == fourccAV1) {
+        return RTMP_CODEC_ID_AV1;
+    } else if (fourcc == fourccVP9) {
+        return RTMP_CODEC_ID_VP9;
+    }
+
+    return 0;
+}
+
+uint32_t getFourccByCodecId(int codecId)
+{
+    switch (codecId)
+    {
+    case RTMP_CODEC_ID_H264:
+        return fourccH264;
+    case RTMP_CODEC_ID_H265:
+        return fourccH265;
+    case RTMP_CODEC_ID_AV1:
+        return fourccAV1;
+    case RTMP_CODEC_ID_VP9:
+        return fourccVP9;
+    default:
+        return 0;
+    }
+}
+
+bool RtmpVideoHeader::parse(const uint8_t* payload, uint32_t length)
+{
+    if (!payload || length < 5) {
+        return false;
+    }
+
+    enhanced_ = payload[0] & 0x80;
+    if (enhanced_) {
+        frameType_ = (payload[0] >> 4) & 0x07;
+        packetType_ = payload[0] & 0x0f;
+        fourcc_ = readUint32BE((char*)payload + 1);
+        codecId_ = getCodecIdByFourcc(fourcc_);
+        cts_ = 0;
+        headerSize_ = 5;
+        if (packetType_ == RTMP_PACKET_TYPE_CODED_FRAMES && (fourcc_ == fourccH264 || fourcc_ == fourccH265)) {
+            if (length < 8) {
+                return false;
+            }
+            // SI24
+            cts_ = (int32_t)(readUint24BE((char*)payload + 5) << 8) >> 8;
+            headerSize_ = 8;
+        }
+    } else {
+        frameType_ = (payload[0] >> 4) & 0x0f;
+        codecId_ = payload[0] & 0x0f;
+        packetType_ = payload[1];
+        fourcc_ = getFourccByCodecId(codecId_);
+        cts_ = (int32_t)(readUint24BE((char*)payload + 2) << 8) >> 8;
+        headerSize_ = 5;
+        // legacy只有0-2，其他值既不是配置也不是帧
+        if (packetType_ > RTMP_PACKET_TYPE_SEQUENCE_END) {
+            packetType_ = 0xff;
+        }
+    }
+
+    return true;
+}
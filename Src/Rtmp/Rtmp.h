@@ -50,11 +50,48 @@ static const int RTMP_StreamID_MEDIA    = 0;
 static const int RTMP_AVC_SEQUENCE_HEADER = 0x18;
 static const int RTMP_AAC_SEQUENCE_HEADER = 0x19;
 
+// Enhanced RTMP扩展视频头的PacketType，legacy的AVCPacketType 0-2和前三个对应
+static const int RTMP_PACKET_TYPE_SEQUENCE_START        = 0;
+static const int RTMP_PACKET_TYPE_CODED_FRAMES          = 1;
+static const int RTMP_PACKET_TYPE_SEQUENCE_END          = 2;
+static const int RTMP_PACKET_TYPE_CODED_FRAMESX         = 3; // 没有cts
+static const int RTMP_PACKET_TYPE_METADATA              = 4;
+static const int RTMP_PACKET_TYPE_MPEG2TS_SEQUENCE_START = 5;
+
+static uint32_t fourccH264 = (unsigned)('a') << 24 | 'v' << 16 | 'c' << 8 | '1';
 static uint32_t fourccH265 = (unsigned)('h') << 24 | 'v' << 16 | 'c' << 8 | '1';
 static uint32_t fourccAV1 = (unsigned)('a') << 24 | 'v' << 16 | '0' << 8 | '1';
 static uint32_t fourccVP9 = (unsigned)('v') << 24 | 'p' << 16 | '0' << 8 | '9';
 
 std::string getCodecNameById(int trackType, int codeId);
 int getIdByCodecName(int trackType, const std::string& codeName);
+// FourCC和legacy codec id互转，不支持的返回0
+int getCodecIdByFourcc(uint32_t fourcc);
+uint32_t getFourccByCodecId(int codecId);
+
+// 视频tag头，legacy是 FrameType(4) CodecID(4) AVCPacketType(8) CompositionTime(24)，
+// enhanced是 IsExHeader(1) FrameType(3) PacketType(4) FourCC(32)，
+// 只有avc1/hvc1的CodedFrames后面带cts
+class RtmpVideoHeader
+{
+public:
+    // 头不完整返回false
+    bool parse(const uint8_t* payload, uint32_t length);
+
+    bool isConfig() const {return packetType_ == RTMP_PACKET_TYPE_SEQUENCE_START;}
+    bool isFrame() const {return packetType_ == RTMP_PACKET_TYPE_CODED_FRAMES || packetType_ == RTMP_PACKET_TYPE_CODED_FRAMESX;}
+    bool isKeyFrame() const {return frameType_ == 1 && isFrame();}
+
+public:
+    bool enhanced_ = false;
+    uint8_t frameType_ = 0;
+    uint8_t packetType_ = 0;
+    // enhanced时由FourCC转换，不认识的FourCC为0
+    int codecId_ = 0;
+    uint32_t fourcc_ = 0;
+    int32_t cts_ = 0;
+    // 头的长度，后面就是配置或者帧数据
+    uint32_t headerSize_ = 0;
+};
 
 #endif
\ No newline at end of file
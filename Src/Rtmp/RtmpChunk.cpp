@@ -23,62 +23,82 @@ int RtmpChunk::parse(const StreamBuffer::Ptr& buffer)
 		return 0;
 	}
 
-    char* buf = buffer->data();
+    uint8_t* buf = (uint8_t*)buffer->data();
 	uint32_t size = buffer->size();
     uint32_t bytesUsed = 0;
 
+    // 上次剩下的只会是不完整的chunk头，补够一个头的字节单独解析，
+    // 消息体直接从socket读到的数据拷进消息的payload，不经过_remainBuffer
     if (_remainBuffer.size() > 0) {
-        _remainBuffer.append(buf, size);
-        buf = _remainBuffer.data();
-        size = _remainBuffer.size();
+        uint32_t remainSize = _remainBuffer.size();
+        uint32_t appendSize = min(size, kMaxChunkHeaderLen - remainSize);
+        _remainBuffer.append((char*)buf, appendSize);
+        _stagedBytes += appendSize;
+
+        uint32_t headerBytesUsed = 0;
+        ret = parseChunkHeader((uint8_t*)_remainBuffer.data(), _remainBuffer.size(), headerBytesUsed);
+        if (ret == 0) {
+            return 0;
+        }
+        _remainBuffer.clear();
+        if (ret < 0) {
+            return ret;
+        }
+        bytesUsed = headerBytesUsed - remainSize;
     }
 
-    do {
+    while (true) {
         if (_state == PARSE_HEADER) {
-            ret = parseChunkHeader((uint8_t*)buf, size, bytesUsed);
-        }
-        else if (_state == PARSE_BODY)
-        {
-            ret = parseChunkBody((uint8_t*)buf, size, bytesUsed);
-            if (ret > 0 && _chunkStreamId >= 0) {
-                auto& rtmpMsg = _messages[_chunkStreamId];
-
-                if (rtmpMsg.index == rtmpMsg.length) {
-                    if (rtmpMsg.timestamp >= 0xffffff) {
-						// logInfo << "rtmpMsg._timestamp: " << rtmpMsg.abs_timestamp;
-                        rtmpMsg.abs_timestamp += rtmpMsg.extend_timestamp;
-                    }
-                    else {
-						// logInfo << "rtmpMsg._timestamp: " << rtmpMsg._timestamp 
-						// 			<< ", _chunkStreamId: " << _chunkStreamId
-						// 			<< ", rtmpMsg.timestamp: " << rtmpMsg.timestamp;
-                        rtmpMsg.abs_timestamp += rtmpMsg.timestamp;
-                    }
-
-                    if (_onRtmpChunk) {
-                        _onRtmpChunk(rtmpMsg);
-                    }
-                    _chunkStreamId = -1;
-                    // rtmpMsg.clear();
-					rtmpMsg.index = 0;
-					rtmpMsg.timestamp = 0;
-					rtmpMsg.extend_timestamp = 0;
-					rtmpMsg.payload = nullptr;
-                }
+            if (bytesUsed >= size) {
+                break;
+            }
+            ret = parseChunkHeader(buf, size, bytesUsed);
+            if (ret == 0) {
+                _remainBuffer.assign((char*)buf + bytesUsed, size - bytesUsed);
+                _stagedBytes += size - bytesUsed;
+                break;
+            } else if (ret < 0) {
+                return ret;
             }
         }
-    } while (ret > 0);
 
-    // logInfo << "bytesUsed: " << bytesUsed << ", size: " << size;
-    if (bytesUsed < size) {
-        _remainBuffer.assign((char*)buf + bytesUsed, size - bytesUsed);
-    } else if (_remainBuffer.size() > 0) {
-        _remainBuffer.clear();
+        ret = parseChunkBody(buf, size, bytesUsed);
+        if (ret < 0) {
+            return ret;
+        }
+        if (_state == PARSE_BODY) {
+            // 数据用完了，chunk剩下的部分等下次读
+            break;
+        }
     }
 	
     return ret;
 }
 
+void RtmpChunk::onMessage(RtmpMessage& rtmpMsg)
+{
+    if (rtmpMsg.timestamp >= 0xffffff) {
+        // logInfo << "rtmpMsg._timestamp: " << rtmpMsg.abs_timestamp;
+        rtmpMsg.abs_timestamp += rtmpMsg.extend_timestamp;
+    }
+    else {
+        // logInfo << "rtmpMsg._timestamp: " << rtmpMsg._timestamp 
+        // 			<< ", _chunkStreamId: " << _chunkStreamId
+        // 			<< ", rtmpMsg.timestamp: " << rtmpMsg.timestamp;
+        rtmpMsg.abs_timestamp += rtmpMsg.timestamp;
+    }
+
+    if (_onRtmpChunk) {
+        _onRtmpChunk(rtmpMsg);
+    }
+    _chunkStreamId = -1;
+    // rtmpMsg.clear();
+    rtmpMsg.index = 0;
+    rtmpMsg.timestamp = 0;
+    rtmpMsg.extend_timestamp = 0;
+    rtmpMsg.payload = nullptr;
+}
+
 int RtmpChunk::parseChunkHeader(uint8_t* buf, uint32_t size, uint32_t &bytesUsed)
 {
     // logInfo << "parseChunkHeader, _remainBuffer.size(): " << _remainBuffer.size();
@@ -102,7 +122,7 @@ int RtmpChunk::parseChunkHeader(uint8_t* buf, uint32_t size, uint32_t &bytesUsed
 	uint8_t flags = buf[headerBytesUsed];
 	headerBytesUsed += 1;
 
-	uint8_t csid = flags & 0x3f; // chunk stream id
+	uint32_t csid = flags & 0x3f; // chunk stream id
 	if (csid == 0) { // csid [64, 319] 
 		if (size < (headerBytesUsed + 2)) {
 			// logInfo << "left size is < 2";
@@ -117,7 +137,7 @@ int RtmpChunk::parseChunkHeader(uint8_t* buf, uint32_t size, uint32_t &bytesUsed
 			// logInfo << "left size is < 3";
 			return 0;
 		}
-		csid += buf[headerBytesUsed + 1] * 255 + buf[headerBytesUsed] + 64;
+		csid = buf[headerBytesUsed + 1] * 256 + buf[headerBytesUsed] + 64;
 		headerBytesUsed += 2;
 	}
 
@@ -197,6 +217,7 @@ int RtmpChunk::parseChunkHeader(uint8_t* buf, uint32_t size, uint32_t &bytesUsed
 		msg.payload = make_shared<StreamBuffer>(msg.length + 1);
 	}
 
+	_chunkRemain = min(msg.length - msg.index, _inChunkSize);
 	_state = PARSE_BODY;
 	// buffer.Retrieve(bytesUsed);
     // logInfo << "bytesUsed: " << bytesUsed << ", buf_size: " << buf_size;
@@ -212,73 +233,31 @@ int RtmpChunk::parseChunkHeader(uint8_t* buf, uint32_t size, uint32_t &bytesUsed
 
 int RtmpChunk::parseChunkBody(uint8_t* buf, uint32_t size, uint32_t &bytesUsed)
 {
-    // logInfo << "parseChunkHeader, _remainBuffer.size(): " << _remainBuffer.size();
-	// uint32_t bytes_used = 0;
-	// uint8_t* buf = (uint8_t*)_remainBuffer.data();
-	// uint32_t buf_size = _remainBuffer.size();
-
-    // if (_remainBuffer.size() > 0) {
-    //     _remainBuffer.append(buffer->data(), buf_size);
-    //     buf = (uint8_t*)_remainBuffer.data();
-    //     buf_size = _remainBuffer.size();
-    //     _remainBuffer.clear();
-    // }
-
-	if (size <= bytesUsed) {
-		return 0;
-	}
-
-	uint32_t bodyBytesUsed = bytesUsed;
-
 	if (_chunkStreamId < 0) {
 		logInfo << "_chunkStreamId < 0";
 		return -1;
 	}
 
 	auto& msg = _messages[_chunkStreamId];
-	uint32_t chunkSize = msg.length - msg.index;
-
-	if (chunkSize > _inChunkSize) {
-		chunkSize = _inChunkSize;
-	}
-
-	// logInfo << "size: " << size;
-	// logInfo << "payload size: " << msg.payload->size();
-	// logInfo << "chunkSize: " << chunkSize;
-	// logInfo << "bodyBytesUsed: " << bodyBytesUsed;
-	// logInfo << "msg.index: " << msg.index;
-	// logInfo << "msg.length: " << msg.length;
-	if (size < (chunkSize + bodyBytesUsed)) {
-		return 0;
-	}
-
-	if ((msg.index + chunkSize > msg.length) || msg.index + chunkSize > msg.payload->size()) {
+	if ((msg.index + _chunkRemain > msg.length) || msg.index + _chunkRemain > msg.payload->size()) {
 		return -1;
 	}
 
-	memcpy(msg.payload->data() + msg.index, buf + bodyBytesUsed, chunkSize);
-	bodyBytesUsed += chunkSize;
+	// 一个chunk可能分在几次读里，收到多少先拷多少
+	uint32_t chunkSize = min(_chunkRemain, size - bytesUsed);
+	memcpy(msg.payload->data() + msg.index, buf + bytesUsed, chunkSize);
+	bytesUsed += chunkSize;
 	msg.index += chunkSize;
-	
-	// logInfo << "size: " << size;
-	// logInfo << "chunkSize: " << chunkSize;
-	// logInfo << "bodyBytesUsed: " << bodyBytesUsed;
-	// logInfo << "msg.index: " << msg.index;
+	_chunkRemain -= chunkSize;
 
-	if (msg.index >= msg.length ||
-		msg.index%_inChunkSize == 0) {
+	if (_chunkRemain == 0) {
 		_state = PARSE_HEADER;
+		if (msg.index == msg.length) {
+			onMessage(msg);
+		}
 	}
 
-	// buffer.Retrieve(bytes_used);
-    // logInfo << "bytes_used: " << bytes_used << ", buf_size: " << buf_size;
-    // if (buf_size > bytes_used) {
-    //     _remainBuffer.assign((char*)buf + bytes_used, buf_size - bytes_used);
-    // } else {
-    //     _remainBuffer.clear();
-    // }
-	bytesUsed = bodyBytesUsed;
-	return bytesUsed;
+	return chunkSize;
 }
 
 StreamBuffer::Ptr RtmpChunk::createBasicHeader(uint8_t fmt, uint32_t csid)
@@ -48,9 +48,13 @@ public:
 
 	void setSocket(const Socket::Ptr& socket) {_socket = socket;}
 
+	// 因为chunk头跨了两次读而暂存的字节数，消息体不会暂存
+	uint64_t getStagedBytes() const {return _stagedBytes;}
+
 private:
 	int parseChunkHeader(uint8_t* buf, uint32_t buf_size, uint32_t &bytes_used);
 	int parseChunkBody(uint8_t* buf, uint32_t buf_size, uint32_t &bytes_used);
+	void onMessage(RtmpMessage& msg);
 	StreamBuffer::Ptr createBasicHeader(uint8_t fmt, uint32_t csid);
 	int createMessageHeader(uint8_t fmt, RtmpMessage& rtmp_msg, uint64_t dts);
 
@@ -65,6 +69,9 @@ private:
 	uint64_t _lastAudioPts = 0;
 	uint32_t _inChunkSize = 128;
 	uint32_t _outChunkSize = 128;
+	// 当前chunk还没收到的消息体字节数
+	uint32_t _chunkRemain = 0;
+	uint64_t _stagedBytes = 0;
 	VideoStampAdjust _videoStampAdjust;
 	AudioStampAdjust _audioStampAdjust;
     StringBuffer _remainBuffer;
@@ -74,6 +81,8 @@ private:
 
 	const int kDefaultStreamId = 1;
 	const int kChunkMessageHeaderLen[4] = { 11, 7, 3, 0 };
+	// basic header 3 + message header 11 + extended timestamp 4
+	const uint32_t kMaxChunkHeaderLen = 18;
 };
 
 
@@ -535,8 +535,10 @@ bool RtmpClient::handleVideo(RtmpMessage& rtmp_msg)
 	uint8_t type = RTMP_VIDEO;
 	uint8_t *payload = (uint8_t *)rtmp_msg.payload->data();
 	uint32_t length = rtmp_msg.length;
-	uint8_t frame_type = (payload[0] >> 4) & 0x0f;
-	uint8_t codec_id = payload[0] & 0x0f;
+    RtmpVideoHeader header;
+    if (!header.parse(payload, length)) {
+        return false;
+    }
 
     // shared_ptr<char> tmpPayload(new char[rtmp_msg.length], std::default_delete<char[]>());
     // memcpy(tmpPayload.get(), payload, rtmp_msg.length);
@@ -558,7 +560,7 @@ bool RtmpClient::handleVideo(RtmpMessage& rtmp_msg)
 
     if (!_rtmpVideoDecodeTrack) {
         _rtmpVideoDecodeTrack = make_shared<RtmpDecodeTrack>(VideoTrackType);
-        if (_rtmpVideoDecodeTrack->createTrackInfo(VideoTrackType, codec_id) != 0) {
+        if (_rtmpVideoDecodeTrack->createTrackInfo(VideoTrackType, header.codecId_) != 0) {
             _validVideoTrack = false;
             return false;
         }
@@ -566,9 +568,9 @@ bool RtmpClient::handleVideo(RtmpMessage& rtmp_msg)
     }
 
     auto msg = make_shared<RtmpMessage>(std::move(rtmp_msg));
-    if (!_avcHeader && frame_type == 1/* && codec_id == RTMP_CODEC_ID_H264*/) {
+    if (!_avcHeader && header.frameType_ == 1/* && codec_id == RTMP_CODEC_ID_H264*/) {
             // logInfo << "payload[1] : " << (int)payload[1];
-        if (payload[1] == 0) {
+        if (header.isConfig()) {
             // sps pps??
             _avcHeaderSize = length;
             _avcHeader = make_shared<StreamBuffer>(length + 1);
@@ -370,7 +370,7 @@ bool RtmpConnection::handleNotify(RtmpMessage& rtmp_msg)
                     // Find video
                     if ((int)val.amfNumber_ != 0) {
                         videocodecid = val.amfNumber_;
-                    } else if (val.type_ = AMF_STRING) {
+                    } else if (val.type_ == AMF_STRING) {
                         videocodecid = getIdByCodecName(VideoTrackType, val.amfString_);
                     }
                 } else if (key == "audiocodecid") {
@@ -378,7 +378,7 @@ bool RtmpConnection::handleNotify(RtmpMessage& rtmp_msg)
                     // Find audio
                     if ((int)val.amfNumber_ != 0) {
                         audiocodecid = val.amfNumber_;
-                    } else if (val.type_ = AMF_STRING) {
+                    } else if (val.type_ == AMF_STRING) {
                         audiocodecid = getIdByCodecName(AudioTrackType, val.amfString_);
                     }
                 } else if (key == "audiodatarate") {
@@ -409,12 +409,9 @@ bool RtmpConnection::handleNotify(RtmpMessage& rtmp_msg)
 
             if (!_rtmpVideoDecodeTrack && videocodecid) {
                 _rtmpVideoDecodeTrack = make_shared<RtmpDecodeTrack>(VideoTrackType);
-                if (videocodecid == fourccH265) {
-                    videocodecid = RTMP_CODEC_ID_H265;
-                } else if (videocodecid == fourccAV1) {
-                    videocodecid = RTMP_CODEC_ID_AV1;
-                } else if (videocodecid == fourccVP9) {
-                    videocodecid = RTMP_CODEC_ID_VP9;
+                // enhanced rtmp的metadata里videocodecid是FourCC
+                if (getCodecIdByFourcc(videocodecid)) {
+                    videocodecid = getCodecIdByFourcc(videocodecid);
                 }
                 if (_rtmpVideoDecodeTrack->createTrackInfo(VideoTrackType, videocodecid) != 0) {
                     // _validVideoTrack = false;
@@ -502,37 +499,16 @@ bool RtmpConnection::handleVideo(RtmpMessage& rtmp_msg)
 	uint8_t type = RTMP_VIDEO;
 	uint8_t *payload = (uint8_t *)rtmp_msg.payload->data();
 	uint32_t length = rtmp_msg.length;
-    if (length < 2) {
+
+    RtmpVideoHeader header;
+    if (!header.parse(payload, length)) {
         return false;
     }
-    
-    bool isEnhance = (payload[0] >> 4) & 0b1000;
-	uint8_t frame_type;
-	uint8_t codec_id;
-    uint8_t packet_type;
 
-    if (isEnhance) {
-        if (length < 5) {
-            return false;
-        }
-        frame_type = (payload[0] >> 4) & 0b0111;
-        packet_type = payload[0] & 0x0f;
-        if (readUint32BE((char*)payload + 1) == fourccH265) {
-            codec_id = RTMP_CODEC_ID_H265;
-        } else if (readUint32BE((char*)payload + 1) == fourccAV1) {
-            codec_id = RTMP_CODEC_ID_AV1;
-        } else if (readUint32BE((char*)payload + 1) == fourccVP9) {
-            codec_id = RTMP_CODEC_ID_VP9;
-        } else {
-            if (!rtmpSrc->isReady()) {
-                close();
-                return false;
-            }
-        }
-    } else {
-        frame_type = (payload[0] >> 4) & 0x0f;
-        codec_id = payload[0] & 0x0f;
-        packet_type = payload[1];
+    if (!_rtmpVideoDecodeTrack && header.codecId_ == 0) {
+        logWarn << "unsupported video fourcc: " << header.fourcc_ << ", path: " << _urlParser.path_;
+        _validVideoTrack = false;
+        return false;
     }
 
     // shared_ptr<char> tmpPayload(new char[rtmp_msg.length], std::default_delete<char[]>());
@@ -555,17 +531,18 @@ bool RtmpConnection::handleVideo(RtmpMessage& rtmp_msg)
 
     if (!_rtmpVideoDecodeTrack) {
         _rtmpVideoDecodeTrack = make_shared<RtmpDecodeTrack>(VideoTrackType);
-        if (_rtmpVideoDecodeTrack->createTrackInfo(VideoTrackType, codec_id) != 0) {
+        if (_rtmpVideoDecodeTrack->createTrackInfo(VideoTrackType, header.codecId_) != 0) {
             _validVideoTrack = false;
             return false;
         }
         rtmpSrc->addTrack(_rtmpVideoDecodeTrack);
     }
 
+    // metadata、sequence end等包照样转发给播放端，解码时会跳过
     auto msg = make_shared<RtmpMessage>(std::move(rtmp_msg));
-    if (!_avcHeader && frame_type == 1/* && codec_id == RTMP_CODEC_ID_H264*/) {
+    if (!_avcHeader && header.frameType_ == 1/* && codec_id == RTMP_CODEC_ID_H264*/) {
             // logInfo << "payload[1] : " << (int)payload[1];
-        if (packet_type == 0) {
+        if (header.isConfig()) {
             // sps pps??
             _avcHeaderSize = length;
             _avcHeader = make_shared<StreamBuffer>(length + 1);;
@@ -1008,6 +985,10 @@ void RtmpConnection::responsePlay(const MediaSource::Ptr &src)
         }, nullptr);
 
         _playReader = rtmpSrc->getRing()->attach(_loop, true);
+        DataQueStartPolicy policy;
+        if (DataQueStartPolicy::parseParam(_urlParser.vecParam_, policy)) {
+            _playReader->setStartPolicy(policy);
+        }
         _playReader->setGetInfoCB([wSelf]() {
             auto self = wSelf.lock();
             ClientInfo ret;
@@ -1292,9 +1273,8 @@ bool RtmpConnection::isKeyFrame(const StreamBuffer::Ptr& payload, uint32_t paylo
         return false;
     }
 
-	uint8_t frame_type = (payload->data()[0] >> 4) & 0x0f;
-	uint8_t codec_id = payload->data()[0] & 0x0f;
-	return (frame_type == 1 && (codec_id == RTMP_CODEC_ID_H264 || codec_id == RTMP_CODEC_ID_H265));
+	RtmpVideoHeader header;
+	return header.parse((uint8_t*)payload->data(), payload_size) && header.isKeyFrame();
 }
 
 void RtmpConnection::sendRtmpChunks(uint32_t csid, RtmpMessage& rtmp_msg)
@@ -33,19 +33,19 @@ void RtmpDecodeTrack::createDecoder()
 {
     weak_ptr<RtmpDecodeTrack> wSelf = shared_from_this();
     if (!_decoder) {
-        if (_trackInfo->codec_ == "h264") {
+        if (_trackInfo->codec_ == CodecH264) {
             _decoder = dynamic_pointer_cast<RtmpDecode>(make_shared<RtmpDecodeH264>(_trackInfo));
-        } else if (_trackInfo->codec_ == "h265") {
+        } else if (_trackInfo->codec_ == CodecH265) {
             _decoder = dynamic_pointer_cast<RtmpDecode>(make_shared<RtmpDecodeH265>(_trackInfo));
-        } else if (_trackInfo->codec_ == "aac") {
+        } else if (_trackInfo->codec_ == CodecAAC) {
             _decoder = dynamic_pointer_cast<RtmpDecode>(make_shared<RtmpDecodeAac>(_trackInfo));
-        } else if (_trackInfo->codec_ == "g711a" || _trackInfo->codec_ == "g711u"
-                    || _trackInfo->codec_ == "mp3" || _trackInfo->codec_ == "opus" 
-                    || _trackInfo->codec_ == "adpcma") {
+        } else if (_trackInfo->codec_ == CodecG711A || _trackInfo->codec_ == CodecG711U
+                    || _trackInfo->codec_ == CodecMP3 || _trackInfo->codec_ == CodecOpus 
+                    || _trackInfo->codec_ == CodecAdpcma) {
             _decoder = dynamic_pointer_cast<RtmpDecode>(make_shared<RtmpDecodeCommon>(_trackInfo));
-        } else if (_trackInfo->codec_ == "av1") {
+        } else if (_trackInfo->codec_ == CodecAV1) {
             _decoder = dynamic_pointer_cast<RtmpDecode>(make_shared<RtmpDecodeAV1>(_trackInfo));
-        } else if (_trackInfo->codec_ == "vp8" || _trackInfo->codec_ == "vp9") {
+        } else if (_trackInfo->codec_ == CodecVP8 || _trackInfo->codec_ == CodecVP9) {
             _decoder = dynamic_pointer_cast<RtmpDecode>(make_shared<RtmpDecodeVPX>(_trackInfo));
         }
 
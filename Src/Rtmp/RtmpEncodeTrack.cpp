@@ -32,8 +32,8 @@ void RtmpEncodeTrack::startEncode()
             }
         });
         _encoder->setEnhanced(_enhanced);
-        _encoder->setEnhanced(_enableFastPts);
-        if (_trackInfo->codec_ == "vp8" || _trackInfo->codec_ == "vp9" || _trackInfo->codec_ == "av1") {
+        _encoder->setFastPts(_enableFastPts);
+        if (_trackInfo->codec_ == CodecVP8 || _trackInfo->codec_ == CodecVP9 || _trackInfo->codec_ == CodecAV1) {
             _encoder->setEnhanced(true);
         }
     }
@@ -203,7 +203,13 @@ void RtmpMediaSource::addTrack(const shared_ptr<TrackInfo>& track)
 
     MediaSource::addTrack(track);
     if (track->trackType_ == "video") {
-        _metaData["videocodecid"] = AmfObject(getIdByCodecName(VideoTrackType, track->codec_));
+        // av1/vp9只能用enhanced rtmp发，videocodecid要填FourCC
+        int codecId = getIdByCodecName(VideoTrackType, track->codec_);
+        if (_enhanced || track->codec_ == CodecAV1 || track->codec_ == CodecVP9) {
+            _metaData["videocodecid"] = AmfObject((double)getFourccByCodecId(codecId));
+        } else {
+            _metaData["videocodecid"] = AmfObject(codecId);
+        }
         _metaData["videodatarate"] = AmfObject(5000);
     } else {
         _metaData["audiocodecid"] = AmfObject(getIdByCodecName(AudioTrackType, track->codec_));
@@ -264,14 +270,14 @@ void RtmpMediaSource::addTrack(const shared_ptr<TrackInfo>& track)
         });
         rtmpTrack->startEncode();
 
-        if (!_aacHeader && track->codec_ == "aac") {
+        if (!_aacHeader && track->codec_ == CodecAAC) {
             auto config = rtmpTrack->getConfig();
             _aacHeaderSize = config.size();
             _aacHeader = make_shared<StreamBuffer>(_aacHeaderSize + 1);
             memcpy(_aacHeader->data(), config.data(), _aacHeaderSize);
         } else if (!_avcHeader && track->trackType_ == "video") {
             auto config = rtmpTrack->getConfig();
-            if (track->codec_ == "h264" || track->codec_ == "h265" || track->codec_ == "av1") {
+            if (track->codec_ == CodecH264 || track->codec_ == CodecH265 || track->codec_ == CodecAV1 || track->codec_ == CodecVP9) {
                 _avcHeaderSize = config.size();
                 _avcHeader = make_shared<StreamBuffer>(_avcHeaderSize + 1);
                 memcpy(_avcHeader->data(), config.data(), _avcHeaderSize);
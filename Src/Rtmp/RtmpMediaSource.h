@@ -51,6 +51,7 @@ public:
     int playerCount();
     void getClientList(const function<void(const list<ClientInfo>& info)>& func) override;
     uint64_t getBytes() override { return _ring ? _ring->getBytes() : 0;}
+    vector<DataQueKeyframeInfo> getKeyframeIndex() override { return _ring ? _ring->getKeyframeIndex() : vector<DataQueKeyframeInfo>();}
 
     void setEnhanced(bool enhanced) {_enhanced = enhanced;}
     void setFastPts(bool enabled) {_enableFastPts = enabled;}
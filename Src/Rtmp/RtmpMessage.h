@@ -46,19 +46,12 @@ public:
 
     bool isKeyFrame() const
     {
-        bool isEnhance = (payload->data()[0] >> 4) & 0b1000;
-        uint8_t frame_type;
-        uint8_t packet_type;
-
-        if (isEnhance) {
-            frame_type = (payload->data()[0] >> 4) & 0b0111;
-            packet_type = payload->data()[0] & 0x0f;
-            return type_id == RTMP_VIDEO && frame_type == 1 && (packet_type == 1 || packet_type == 3);
-        } else {
-            frame_type = (payload->data()[0] >> 4) & 0x0f;
-            packet_type = payload->data()[1];
-            return type_id == RTMP_VIDEO && frame_type == 1 && packet_type == 1;
+        if (type_id != RTMP_VIDEO || !payload) {
+            return false;
         }
+
+        RtmpVideoHeader header;
+        return header.parse((uint8_t*)payload->data(), length) && header.isKeyFrame();
     }
 
 public:
@@ -66,7 +59,7 @@ public:
 
     uint8_t  type_id = 0;
     uint8_t  codecId = 0;
-    uint8_t  csid = 0;
+    uint32_t csid = 0;
 
     uint32_t index = 0;
     uint32_t timestamp = 0;
@@ -19,7 +19,7 @@ FrameBuffer::Ptr RtpDecodeAac::createFrame()
 {
     auto frame = make_shared<FrameBuffer>();
     frame->_startSize = 7;
-    frame->_codec = "aac";
+    frame->_codec = CodecAAC;
     frame->_index = _trackInfo->index_;
     frame->_trackType = AudioTrackType;
 
@@ -34,7 +34,7 @@ H264Frame::Ptr RtpDecodeH264::createFrame()
 {
     auto frame = make_shared<H264Frame>();
     frame->_startSize = 4;
-    frame->_codec = "h264";
+    frame->_codec = CodecH264;
     frame->_index = _trackInfo->index_;
     frame->_trackType = VideoTrackType;
 
@@ -32,7 +32,7 @@ H265Frame::Ptr RtpDecodeH265::createFrame()
 {
     auto frame = make_shared<H265Frame>();
     frame->_startSize = 4;
-    frame->_codec = "h265";
+    frame->_codec = CodecH265;
     frame->_index = _trackInfo->index_;
     frame->_trackType = VideoTrackType;
 
@@ -20,19 +20,19 @@ using namespace std;
 RtpDecoder::Ptr RtpDecoder::creatDecoder(const shared_ptr<TrackInfo>& trackInfo)
 {
     logDebug << "codec: " << trackInfo->codec_;
-    if (trackInfo->codec_ == "h264") {
+    if (trackInfo->codec_ == CodecH264) {
         return make_shared<RtpDecodeH264>(trackInfo);
-    } else if (trackInfo->codec_ == "aac") {
+    } else if (trackInfo->codec_ == CodecAAC) {
         return make_shared<RtpDecodeAac>(trackInfo);
-    } else if (trackInfo->codec_ == "h265") {
+    } else if (trackInfo->codec_ == CodecH265) {
         return make_shared<RtpDecodeH265>(trackInfo);
-    } else if (trackInfo->codec_ == "mp3") {
+    } else if (trackInfo->codec_ == CodecMP3) {
         return make_shared<RtpDecodeMp3>(trackInfo);
-    } else if (trackInfo->codec_ == "vp8") {
+    } else if (trackInfo->codec_ == CodecVP8) {
         return make_shared<RtpDecodeVp8>(trackInfo);
-    } else if (trackInfo->codec_ == "vp9") {
+    } else if (trackInfo->codec_ == CodecVP9) {
         return make_shared<RtpDecodeVP9>(trackInfo);
-    } else if (trackInfo->codec_ == "av1") {
+    } else if (trackInfo->codec_ == CodecAV1) {
         return make_shared<RtpDecodeAV1>(trackInfo);
     } else {
         return make_shared<RtpDecodeCommon>(trackInfo);
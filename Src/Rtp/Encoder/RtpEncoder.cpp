@@ -22,19 +22,19 @@ RtpEncoder::Ptr RtpEncoder::create(const shared_ptr<TrackInfo>& trackInfo)
 {
     logInfo << "codec: " << trackInfo->codec_;
     RtpEncoder::Ptr encoder;
-    if (trackInfo->codec_ == "h264") {
+    if (trackInfo->codec_ == CodecH264) {
         encoder = make_shared<RtpEncodeH264>(trackInfo);
-    } else if (trackInfo->codec_ == "h265") {
+    } else if (trackInfo->codec_ == CodecH265) {
         encoder = make_shared<RtpEncodeH265>(trackInfo);
-    } else if (trackInfo->codec_ == "aac") {
+    } else if (trackInfo->codec_ == CodecAAC) {
         encoder = make_shared<RtpEncodeAac>(trackInfo);
-    } else if (trackInfo->codec_ == "mp3") {
+    } else if (trackInfo->codec_ == CodecMP3) {
         encoder = make_shared<RtpEncodeMp3>(trackInfo);
-    } else if (trackInfo->codec_ == "vp8") {
+    } else if (trackInfo->codec_ == CodecVP8) {
         encoder = make_shared<RtpEncodeVP8>(trackInfo);
-    } else if (trackInfo->codec_ == "vp9") {
+    } else if (trackInfo->codec_ == CodecVP9) {
         encoder = make_shared<RtpEncodeVP9>(trackInfo);
-    } else if (trackInfo->codec_ == "av1") {
+    } else if (trackInfo->codec_ == CodecAV1) {
         encoder = make_shared<RtpEncodeAV1>(trackInfo);
     } else {
         encoder = make_shared<RtpEncodeCommon>(trackInfo);
@@ -134,7 +134,15 @@ bool RtpContext::init()
 
     });
 
-    _sort = make_shared<RtpSort>(256);
+    // 旧的配置文件没有这两项时保持原来的256个包的排序深度
+    static int jitterDepth = Config::instance()->getAndListen([](const json& config){
+        jitterDepth = Config::instance()->get("Rtp", "jitterDepth", "", "", "256");
+    }, "Rtp", "jitterDepth", "", "", "256");
+    static int jitterMaxWait = Config::instance()->getAndListen([](const json& config){
+        jitterMaxWait = Config::instance()->get("Rtp", "jitterMaxWait", "", "", "100");
+    }, "Rtp", "jitterMaxWait", "", "", "100");
+
+    _sort = make_shared<RtpSort>(jitterDepth, jitterMaxWait);
     _sort->setOnRtpPacket([wSelf](const RtpPacket::Ptr& rtp){
         // logInfo << "decode rtp seq: " << rtp->getSeq() << ", rtp size: " << rtp->size() << ", rtp time: " << rtp->getStamp();
         auto self = wSelf.lock();
@@ -155,6 +163,7 @@ bool RtpContext::init()
             }
         }
     });
+    _sort->startTimer(_loop);
 
     _timeClock.start();
         
@@ -226,10 +235,16 @@ void RtpContext::onRtpPacket(const RtpPacket::Ptr& rtp, struct sockaddr* addr, i
 
     if (!_loop->isCurrent()) {
         weak_ptr<RtpContext> wSelf = shared_from_this();
-        _loop->async([wSelf, rtp, addr, len, sort](){
+        // addr指向收包线程的栈内存，切换线程前需要拷贝
+        shared_ptr<sockaddr_storage> peerAddr;
+        if (addr) {
+            peerAddr = make_shared<sockaddr_storage>();
+            memcpy(peerAddr.get(), addr, std::min((size_t)len, sizeof(sockaddr_storage)));
+        }
+        _loop->async([wSelf, rtp, peerAddr, len, sort](){
             auto self = wSelf.lock();
             if (self) {
-                self->onRtpPacket(rtp, addr, len, sort);
+                self->onRtpPacket(rtp, (struct sockaddr*)peerAddr.get(), len, sort);
             }
         }, true);
 
@@ -264,7 +279,8 @@ void RtpContext::onRtpPacket(const RtpPacket::Ptr& rtp, struct sockaddr* addr, i
     rtp->trackIndex_ = 0;
     
     if (sort) {
-        _sort->onRtpPacket(rtp);
+        // udp才需要重排
+        _sort->inputRtp(rtp);
     } else {
         if (_payloadType == "ps" || _payloadType == "ts") {
             rtp->trackIndex_ = VideoTrackType;
@@ -301,6 +317,16 @@ void RtpContext::heartbeat()
         timeout = 5000;
     }
 
+    if (_sort) {
+        auto& stats = _sort->getStatistics();
+        if (stats.lost > _lastRtpLost) {
+            logInfo << "rtp loss, uri: " << _uri << ", received: " << stats.received
+                    << ", lost: " << stats.lost << ", reordered: " << stats.reordered
+                    << ", late: " << stats.late << ", duplicate: " << stats.duplicate;
+            _lastRtpLost = stats.lost;
+        }
+    }
+
     if (_timeClock.startToNow() > timeout) {
         logInfo << "alive is false";
         _alive = false;
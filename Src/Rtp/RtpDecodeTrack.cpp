@@ -20,7 +20,7 @@ RtpDecodeTrack::RtpDecodeTrack(int trackIndex)
     :_index(trackIndex)
 {
     _trackInfo = make_shared<TrackInfo>();
-    _trackInfo->codec_ = "ps";
+    _trackInfo->codec_ = CodecPS;
     _trackInfo->index_ = 0;
     _trackInfo->samplerate_ = 90000;
 
@@ -196,14 +196,14 @@ void RtpDecodeTrack::onFrame(const FrameBuffer::Ptr& frame)
             _onFrame(frame);
         }
     } else {
-        if (_trackInfo->codec_ == "h265") {
+        if (_trackInfo->codec_ == CodecH265) {
             auto h265frame = dynamic_pointer_cast<H265Frame>(frame);
             h265frame->split([this, h265frame](const FrameBuffer::Ptr &subFrame){
                 if (_onFrame) {
                     _onFrame(subFrame);
                 }
             });
-        } else if (_trackInfo->codec_ == "h264") {
+        } else if (_trackInfo->codec_ == CodecH264) {
             auto h264frame = dynamic_pointer_cast<H264Frame>(frame);
             h264frame->split([this, h264frame](const FrameBuffer::Ptr &subFrame){
                 if (_onFrame) {
@@ -3,11 +3,10 @@
 
 
 #include <string>
-#include <unordered_map>
-#include <mutex>
 #include <memory>
 
 #include "RtpContext.h"
+#include "Common/SsrcRouteTable.h"
 
 using namespace std;
 
@@ -30,9 +29,9 @@ public:
 
 private:
     bool _isInited = false;
-    mutex _contextLck;
     // EventLoop::Ptr _loop;
-    unordered_map<uint32_t, RtpContext::Ptr> _mapContext;
+    // 所有loop的收包线程共用，查找不加锁
+    SsrcRouteTable<RtpContext> _mapContext;
 };
 
 #endif //RtpManager_h
\ No newline at end of file
@@ -36,6 +36,7 @@ public:
     int playerCount() override;
     void getClientList(const function<void(const list<ClientInfo>& info)>& func) override;
     uint64_t getBytes() override { return _ring ? _ring->getBytes() : 0;}
+    vector<DataQueKeyframeInfo> getKeyframeIndex() override { return _ring ? _ring->getKeyframeIndex() : vector<DataQueKeyframeInfo>();}
     unordered_map<int/*index*/, RtpDecodeTrack::Ptr> getDecodeTrack()
     {
         return _mapRtpDecodeTrack;
@@ -100,9 +100,9 @@ RtpPacket::RtpPacket(const StreamBuffer::Ptr& buffer, int rtpOverTcpHeaderSize)
     _data = StreamBuffer::create();
     _size = buffer->size() + _rtpOverTcpHeaderSize;
     if (_rtpOverTcpHeaderSize == 4) {
-        char* rtpBuffer = new char[_size];
-        memcpy(rtpBuffer + 4, buffer->data(), _size - 4);
-        _data->move(rtpBuffer, _size);
+        _data->setCapacity(_size + 1);
+        _data->setSize(_size);
+        memcpy(_data->data() + 4, buffer->data(), _size - 4);
     } else {
         // logInfo << "buffer size: " << buffer->size();
         _data->assign(buffer->data(), _size);
@@ -1,73 +1,190 @@
 ﻿#include <cstdlib>
 #include <string>
 #include <algorithm>
-#include <cctype>
-#include <arpa/inet.h>
 
 #include "RtpSort.h"
 #include "Logger.h"
-#include "Util/String.h"
+#include "Util/TimeClock.h"
 
 using namespace std;
 
-RtpSort::RtpSort(int maxQueSize)
-    :_maxQueSize(maxQueSize)
-{}
+RtpSort::RtpSort(int depth, int maxWaitMs)
+    :_maxWaitMs(maxWaitMs)
+{
+    int size = 16;
+    while (size < depth && size < 32768) {
+        size <<= 1;
+    }
+    _mask = size - 1;
+    _ring.resize(size);
+}
 
-void RtpSort::inputRtp(const RtpPacket::Ptr& rtp)
+void RtpSort::inputRtp(const RtpPacket::Ptr& rtp, uint64_t now)
 {
+    uint16_t seq = rtp->getSeq();
+    ++_stats.received;
+
     if (_firstRtp) {
         _firstRtp = false;
+        _nextSeq = seq;
+        _maxSeq = seq;
+    }
+
+    uint16_t lastNextSeq = _nextSeq;
+    int16_t diff = seq - _nextSeq;
+    if (diff < 0) {
+        if (-diff > (int)_ring.size()) {
+            // 远远落后于窗口，认为对端重新开始编号
+            logInfo << "rtp seq reset, expect: " << _nextSeq << ", cur seq: " << seq;
+            ++_stats.reset;
+            flush();
+            _nextSeq = seq;
+            _maxSeq = seq;
+        } else {
+            ++_stats.late;
+            return ;
+        }
+    } else if (diff > _mask) {
+        // 超出窗口，先把窗口推进到能放下这个包
+        advance(seq - _mask);
+    }
+
+    auto& slot = _ring[seq & _mask];
+    if (slot) {
+        ++_stats.duplicate;
+        return ;
+    }
+
+    if ((int16_t)(seq - _maxSeq) > 0) {
+        _maxSeq = seq;
+    } else if (seq != _maxSeq) {
+        ++_stats.reordered;
+    }
+
+    if (seq == _nextSeq) {
         onRtpPacket(rtp);
-        _lastRtpSeq = rtp->getSeq();
+        ++_nextSeq;
+        releaseInOrder();
+    } else {
+        slot = rtp;
+        ++_count;
+    }
+
+    if (_count == 0) {
+        _waitStart = 0;
         return ;
     }
 
-    uint16_t curSeq = _lastRtpSeq + 1;
-    if (rtp->getSeq() != curSeq) {
-        logInfo << "loss rtp, last seq + 1: " << curSeq << ", cur seq: " << rtp->getSeq();
-        if (_setSeq.find(rtp->getSeq()) == _setSeq.end()) {
-            // _mapRtp[rtp->getSeq()] = rtp;
-            _mapRtp.emplace(rtp->getSeq(), rtp);
-            _setSeq.emplace(rtp->getSeq());
-            logInfo << "add seq: " << rtp->getSeq();
-        }
+    if (_maxWaitMs <= 0) {
+        return ;
+    }
+
+    if (now == 0) {
+        now = TimeClock::now();
+    }
+    if (_waitStart == 0 || _nextSeq != lastNextSeq) {
+        // 队头有推进，重新计时
+        _waitStart = now;
     } else {
-        onRtpPacket(rtp);
-        _lastRtpSeq = rtp->getSeq();
+        checkWait(now);
     }
+}
 
-    // for (auto iter : _mapRtp) {
-    //     logInfo << "iter seq is: " << iter.first << endl;
-    // }
+void RtpSort::checkWait(uint64_t now)
+{
+    if (_maxWaitMs <= 0 || _count == 0 || _waitStart == 0) {
+        return ;
+    }
 
-    // for (auto iter : _setSeq) {
-    //     logInfo << "set iter seq is: " << iter << endl;
-    // }
+    if (now == 0) {
+        now = TimeClock::now();
+    }
+    if (now - _waitStart >= (uint64_t)_maxWaitMs) {
+        skipGap();
+        _waitStart = _count > 0 ? now : 0;
+    }
+}
+
+void RtpSort::startTimer(const EventLoop::Ptr& loop)
+{
+    if (_maxWaitMs <= 0 || !loop) {
+        return ;
+    }
+
+    // 检查间隔取等待时间的一半，超时后最多再晚半个maxWaitMs放行
+    int interval = max(_maxWaitMs / 2, 5);
+    weak_ptr<RtpSort> wSelf = shared_from_this();
+    loop->addTimerTask(interval, [wSelf, interval](){
+        auto self = wSelf.lock();
+        if (!self) {
+            return 0;
+        }
+
+        self->checkWait();
+        return interval;
+    }, [](bool success, shared_ptr<TimerTask>){
 
-    while (true) {
-        if (_mapRtp.empty()) {
+    });
+}
+
+void RtpSort::releaseInOrder()
+{
+    while (_count > 0) {
+        auto& slot = _ring[_nextSeq & _mask];
+        if (!slot) {
             break;
         }
-        auto iter = _mapRtp.begin();
-        auto rtpSend = iter->second;
-        if ((_mapRtp.size() >= _maxQueSize) || 
-            (_mapRtp.size() > 0 && rtpSend->getSeq() == (uint16_t)(_lastRtpSeq + 1))) {
-            // auto it = _mapRtp.begin();
-            _lastRtpSeq = rtpSend->getSeq();
-            auto seq = iter->first;
-            onRtpPacket(rtpSend);
-            _setSeq.erase(iter->first);
-            _mapRtp.erase(iter);
+        auto rtp = std::move(slot);
+        slot = nullptr;
+        --_count;
+        ++_nextSeq;
+        onRtpPacket(rtp);
+    }
+}
+
+void RtpSort::skipGap()
+{
+    // 跳到下一个已收到的包，中间的seq算作丢失
+    while (_count > 0 && !_ring[_nextSeq & _mask]) {
+        ++_stats.lost;
+        ++_nextSeq;
+    }
+    releaseInOrder();
+}
+
+void RtpSort::advance(uint16_t seq)
+{
+    // 跨度超过整个窗口时只需扫描一圈，剩下的seq直接算作丢失
+    int distance = (uint16_t)(seq - _nextSeq);
+    int scan = min(distance, (int)_ring.size());
+    for (int i = 0; i < scan; ++i, ++_nextSeq) {
+        auto& slot = _ring[_nextSeq & _mask];
+        if (slot) {
+            auto rtp = std::move(slot);
+            slot = nullptr;
+            --_count;
+            onRtpPacket(rtp);
         } else {
-            break;
+            ++_stats.lost;
         }
     }
+    _stats.lost += distance - scan;
+    _nextSeq = seq;
+    releaseInOrder();
+}
+
+void RtpSort::flush()
+{
+    while (_count > 0) {
+        skipGap();
+    }
+    _waitStart = 0;
 }
 
 void RtpSort::onRtpPacket(const RtpPacket::Ptr& rtp)
 {
     // logInfo << "on rtp packet seq : " << rtp->getSeq();
+    ++_stats.released;
     if (_onRtpPacket) {
         _onRtpPacket(rtp);
     }
@@ -78,28 +195,18 @@ void RtpSort::setOnRtpPacket(const function<void(const RtpPacket::Ptr& rtp)>& cb
     _onRtpPacket = cb;
 }
 
-vector<uint16_t> RtpSort::
-getLossSeq()
+vector<uint16_t> RtpSort::getLossSeq()
 {
     vector<uint16_t> vecSeq;
-    if (_firstRtp) {
+    if (_firstRtp || _count == 0) {
         return vecSeq;
     }
 
-    int curSeq = _lastRtpSeq;
-    for (auto& iter : _mapRtp) {
-        if (curSeq == -1) {
-            curSeq = iter.first;
-            continue;
+    for (uint16_t seq = _nextSeq; seq != _maxSeq; ++seq) {
+        if (!_ring[seq & _mask]) {
+            vecSeq.push_back(seq);
         }
-        logInfo << "iter.first: " << iter.first << ", curSeq: " << curSeq;
-        uint16_t diff = iter.first - (uint16_t)curSeq;
-        for (int i = 1; i < diff; ++i) {
-            vecSeq.push_back(curSeq + i);
-        }
-
-        curSeq = iter.first;
     }
 
     return vecSeq;
-}
\ No newline at end of file
+}
@@ -1,50 +1,74 @@
 ﻿#ifndef RtpSort_H
 #define RtpSort_H
 
-#include <map>
 #include <string>
 #include <memory>
-#include <iostream>
 #include <vector>
-#include <set>
+#include <functional>
 
 #include "Net/Buffer.h"
 #include "RtpPacket.h"
 #include "Log/Logger.h"
+#include "EventPoller/EventLoop.h"
 
 using namespace std;
 
-struct myCompare {
-    bool operator()(const uint16_t& l, const uint16_t& r)const
-    {
-        static constexpr uint16_t SEQ_MAX = (std::numeric_limits<uint16_t>::max)();
-        static constexpr uint16_t kBreakpoint = SEQ_MAX >> 1 + 1;
-
-        if (l - r == kBreakpoint) {
-            return l > r;
-        }
-
-        return l != r && static_cast<uint16_t>(l - r) > kBreakpoint;
-    }
-};
-
-class RtpSort
+// rtp乱序重排，按seq & mask索引的定长环形缓冲
+// 缺包时最多缓存depth个包或等待maxWaitMs，超过就跳过缺失的seq
+class RtpSort : public enable_shared_from_this<RtpSort>
 {
 public:
     using Ptr = shared_ptr<RtpSort>;
-    RtpSort(int maxQueSize = 25);
 
-    void inputRtp(const RtpPacket::Ptr& rtp);
+    struct Statistics
+    {
+        uint64_t received = 0;
+        uint64_t released = 0;
+        // 最终没等到，被跳过的seq数
+        uint64_t lost = 0;
+        // 晚于更大seq到达的包
+        uint64_t reordered = 0;
+        uint64_t duplicate = 0;
+        // 对应seq已经输出或跳过后才到达，丢弃
+        uint64_t late = 0;
+        uint64_t reset = 0;
+    };
+
+    // depth会向上取整为2的幂，maxWaitMs <= 0时只按depth强制输出
+    RtpSort(int depth = 256, int maxWaitMs = 0);
+
+    // now为0时取当前时间(毫秒)
+    void inputRtp(const RtpPacket::Ptr& rtp, uint64_t now = 0);
     void onRtpPacket(const RtpPacket::Ptr& rtp);
     void setOnRtpPacket(const function<void(const RtpPacket::Ptr& rtp)>& cb);
+    // 缓冲窗口内还缺的seq，可用于nack
     vector<uint16_t> getLossSeq();
-    
+    const Statistics& getStatistics() const {return _stats;}
+    // 按顺序输出全部缓存的包
+    void flush();
+    // 队头缺包等待超过maxWaitMs时跳过，now为0时取当前时间
+    void checkWait(uint64_t now = 0);
+    // 在所属loop上定时checkWait，没有新包到达时缺包也能按时放行，maxWaitMs <= 0时不启动
+    void startTimer(const EventLoop::Ptr& loop);
+
+private:
+    void releaseInOrder();
+    void skipGap();
+    void advance(uint16_t seq);
+
 private:
     bool _firstRtp = true;
-    uint16_t _lastRtpSeq = -1;
-    int _maxQueSize;
-    set<uint16_t> _setSeq;
-    map<uint16_t, RtpPacket::Ptr, myCompare> _mapRtp;
+    // 下一个要输出的seq
+    uint16_t _nextSeq = 0;
+    // 收到过的最大seq
+    uint16_t _maxSeq = 0;
+    uint16_t _mask;
+    int _count = 0;
+    int _maxWaitMs;
+    // 队头开始缺包的时间
+    uint64_t _waitStart = 0;
+    Statistics _stats;
+    vector<RtpPacket::Ptr> _ring;
     function<void(const RtpPacket::Ptr& rtp)> _onRtpPacket;
 };
 
@@ -1,6 +1,7 @@
 ﻿#include <sys/socket.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
+#include <cmath>
 
 #include "RtspConnection.h"
 #include "Logger.h"
@@ -35,6 +36,10 @@ RtspConnection::~RtspConnection()
         // rtspSrc->delOnDetach(this);
     }
 
+    if (_multicast) {
+        _multicast->leave(this);
+    }
+
     if (_playReader) {
         PlayerInfo info;
         info.ip = _socket->getPeerIp();
@@ -684,7 +689,36 @@ void RtspConnection::handleSetup()
             _mapRtcpTransport.emplace(index * 2 + 1, rtcpTrans);
         }
     } else if (trans.find("multicast") != string::npos) {
-
+        if (_isPublish) {
+            sendUnsupportedTransport();
+            return ;
+        }
+        // 同一个流的组播观众共用一组socket，第一个track SETUP时加入
+        if (!_multicast) {
+            weak_ptr<RtspConnection> wSelf = static_pointer_cast<RtspConnection>(shared_from_this());
+            _multicast = RtspMulticast::join(rtspSrc, _loop, this, [wSelf](){
+                auto self = wSelf.lock();
+                if (self) {
+                    self->_loop->async([wSelf](){
+                        auto self = wSelf.lock();
+                        if (self) {
+                            self->close();
+                        }
+                    }, true);
+                }
+            });
+            if (!_multicast) {
+                sendNotAcceptable();
+                return ;
+            }
+        }
+        int port = _multicast->getRtpPort(index);
+        if (port < 0) {
+            sendNotAcceptable();
+            return ;
+        }
+        trans = "RTP/AVP;multicast;destination=" + _multicast->getGroup() + ";source=" + _socket->getLocalIp()
+                + ";port=" + to_string(port) + "-" + to_string(port + 1) + ";ttl=" + to_string(_multicast->getTtl());
     } else {
         auto socketRtp = make_shared<Socket>(_loop);
         auto socketRtcp = make_shared<Socket>(_loop);
@@ -778,13 +812,16 @@ void RtspConnection::handlePlay()
         return ;
     }
     
+    // 负数为倒放，倍速较大或倒放时点播只发关键帧
+    string scaleStr;
     auto it = _parser._mapHeaders.find("scale");
     if (it != _parser._mapHeaders.end()) {
-        float scale = stof(it->second);
+        float scale = atof(it->second.data());
         // _source->scale();
         auto reader = rtspSrc->getReader();
-        if (reader) {
+        if (reader && fabs(scale) > 0.01) {
             reader->scale(scale);
+            scaleStr = it->second;
             logDebug << "rtsp scale: " << scale;
         }
     }
@@ -848,16 +885,30 @@ void RtspConnection::handlePlay()
         range = "npt=" + startTime + "-" + endTime;
     }
 
+    // 组播在PLAY时才开始发送
+    if (_multicast && !_multicast->play(this)) {
+        sendNotAcceptable();
+        return ;
+    }
+
     std::stringstream ss;
     ss << "RTSP/1.0 200 OK\r\n"
        << "CSeq: " << _parser._mapHeaders["cseq"] << "\r\n"
        << "Session: " << _sessionId << "\r\n"
        << "Range: " << range << "\r\n"
-       << "RTP-Info: " << rtpInfo << "\r\n"
-       << "\r\n";
+       << "RTP-Info: " << rtpInfo << "\r\n";
+    if (!scaleStr.empty()) {
+        ss << "Scale: " << scaleStr << "\r\n";
+    }
+    ss << "\r\n";
 
     sendMessage(ss.str());
 
+    // 组播由RtspMulticast统一发送
+    if (_multicast) {
+        return ;
+    }
+
     if (!_playReader/* && _rtp_type != Rtsp::RTP_MULTICAST*/) {
         weak_ptr<RtspConnection> weak_self = static_pointer_cast<RtspConnection>(shared_from_this());
         // if (!_sendTimer) {
@@ -900,6 +951,10 @@ void RtspConnection::handlePlay()
         }, nullptr);
         
         _playReader = rtspSrc->getRing()->attach(_loop, true);
+        DataQueStartPolicy policy;
+        if (DataQueStartPolicy::parseParam(_urlParser.vecParam_, policy)) {
+            _playReader->setStartPolicy(policy);
+        }
         _playReader->setGetInfoCB([weak_self]() {
             auto self = weak_self.lock();
             ClientInfo ret;
@@ -976,13 +1031,16 @@ void RtspConnection::handlePlay()
 
 void RtspConnection::handlePause()
 {
-    if (_mapRtpTransport.empty() || _sessionId.empty()) {
+    if ((_mapRtpTransport.empty() && !_multicast) || _sessionId.empty()) {
         sendSessionNotFound();
         return ;
     }
     if (!_isPublish && _source.lock()) {
         // _source->pause();
     }
+    if (_multicast) {
+        _multicast->pause(this);
+    }
     
     std::stringstream ss;
     ss << "RTSP/1.0 200 OK\r\n"
@@ -1001,6 +1059,11 @@ void RtspConnection::handleTeardown()
 
     sendMessage(ss.str());
 
+    if (_multicast) {
+        _multicast->leave(this);
+        _multicast = nullptr;
+    }
+
     close();
 }
 
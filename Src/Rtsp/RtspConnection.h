@@ -7,6 +7,7 @@
 #include "RtspMediaSource.h"
 #include "RtspRtpTransport.h"
 #include "RtspRtcpTransport.h"
+#include "RtspMulticast.h"
 #include "Common/UrlParser.h"
 
 #include <string>
@@ -80,6 +81,7 @@ private:
     UrlParser _urlParser;
     RtspMediaSource::Wptr _source;
     RtspMediaSource::QueType::DataQueReaderT::Ptr _playReader;
+    RtspMulticast::Ptr _multicast;
     // int : index
     unordered_map<int, RtspRtpTransport::Ptr> _mapRtpTransport;
     // int : index
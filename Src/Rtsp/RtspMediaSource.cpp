@@ -328,7 +328,7 @@ void RtspMediaSource::onFrame(const FrameBuffer::Ptr& frame)
         return ;
     }
     // logInfo << "on muxer a frame, pts: " << frame->pts();
-    // if (frame->codec() == "h264") {
+    // if (frame->codec() == CodecH264) {
     //     static int i = 0;
     //     string name = "test" + to_string(++i) + ".264";
     //     FILE* fp = fopen(name.data(), "ab+");
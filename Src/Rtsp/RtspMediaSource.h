@@ -42,6 +42,7 @@ public:
     virtual int playerCount() override;
     virtual void getClientList(const function<void(const list<ClientInfo>& info)>& func) override;
     uint64_t getBytes() override { return _ring ? _ring->getBytes() : 0;}
+    vector<DataQueKeyframeInfo> getKeyframeIndex() override { return _ring ? _ring->getKeyframeIndex() : vector<DataQueKeyframeInfo>();}
 
     virtual void addControl2Index(const string& control, int index)
     {
@@ -0,0 +1,488 @@
+#include <set>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+
+#include "RtspMulticast.h"
+#include "Logger.h"
+#include "Common/Config.h"
+#include "Common/Define.h"
+
+using namespace std;
+
+mutex RtspMulticast::_mtx;
+unordered_map<string, RtspMulticast::Ptr> RtspMulticast::_mapMulticast;
+
+// 地址池，由_mtx保护
+static set<uint32_t> g_usedGroup;
+static set<int> g_usedPort;
+static uint32_t g_groupCursor = 0;
+static int g_portCursor = 0;
+
+// rfc要求sr间隔不小于5秒
+static const int kSenderReportInterval = 5000;
+
+RtspMulticast::RtspMulticast(const RtspMediaSource::Ptr& source, const EventLoop::Ptr& loop)
+    :_loop(loop)
+    ,_source(source)
+{
+    _key = source->getPath() + "_" + source->getVhost() + "_" + source->getType();
+}
+
+RtspMulticast::~RtspMulticast()
+{
+    logDebug << "~RtspMulticast, key: " << _key;
+    lock_guard<mutex> lck(_mtx);
+    free();
+}
+
+RtspMulticast::Ptr RtspMulticast::join(const RtspMediaSource::Ptr& source, const EventLoop::Ptr& loop,
+                                    void* key, const function<void()>& onDetach)
+{
+    RtspMulticast::Ptr multicast;
+    lock_guard<mutex> lck(_mtx);
+    string mapKey = source->getPath() + "_" + source->getVhost() + "_" + source->getType();
+    auto iter = _mapMulticast.find(mapKey);
+    if (iter != _mapMulticast.end()) {
+        multicast = iter->second;
+    } else {
+        multicast = make_shared<RtspMulticast>(source, loop);
+        if (!multicast->alloc()) {
+            return nullptr;
+        }
+        _mapMulticast[mapKey] = multicast;
+    }
+    multicast->_mapViewer[key] = onDetach;
+    logInfo << "join multicast: " << mapKey << ", group: " << multicast->_group
+            << ", viewers: " << multicast->_mapViewer.size();
+
+    return multicast;
+}
+
+bool RtspMulticast::play(void* key)
+{
+    {
+        lock_guard<mutex> lck(_mtx);
+        if (_stopped || _mapViewer.find(key) == _mapViewer.end()) {
+            return false;
+        }
+        _setPlaying.insert(key);
+    }
+
+    if (_loop->isCurrent()) {
+        updateSend();
+        return _reader != nullptr;
+    }
+
+    weak_ptr<RtspMulticast> wSelf = shared_from_this();
+    _loop->async([wSelf](){
+        auto self = wSelf.lock();
+        if (self) {
+            self->updateSend();
+        }
+    }, true);
+
+    return true;
+}
+
+void RtspMulticast::pause(void* key)
+{
+    {
+        lock_guard<mutex> lck(_mtx);
+        if (_setPlaying.erase(key) == 0 || !_setPlaying.empty()) {
+            return ;
+        }
+    }
+
+    weak_ptr<RtspMulticast> wSelf = shared_from_this();
+    _loop->async([wSelf](){
+        auto self = wSelf.lock();
+        if (self) {
+            self->updateSend();
+        }
+    }, true);
+}
+
+void RtspMulticast::leave(void* key)
+{
+    {
+        lock_guard<mutex> lck(_mtx);
+        if (_mapViewer.erase(key) == 0 || _stopped) {
+            return ;
+        }
+        if (!_mapViewer.empty()) {
+            // 只剩暂停的观众时暂停发送
+            if (_setPlaying.erase(key) && _setPlaying.empty()) {
+                weak_ptr<RtspMulticast> wSelf = shared_from_this();
+                _loop->async([wSelf](){
+                    auto self = wSelf.lock();
+                    if (self) {
+                        self->updateSend();
+                    }
+                }, true);
+            }
+            return ;
+        }
+        _setPlaying.clear();
+        _stopped = true;
+        auto iter = _mapMulticast.find(_key);
+        if (iter != _mapMulticast.end() && iter->second.get() == this) {
+            _mapMulticast.erase(iter);
+        }
+    }
+
+    logInfo << "no multicast viewer, stop: " << _key << ", group: " << _group;
+    auto self = shared_from_this();
+    _loop->async([self](){
+        self->stop();
+    }, true);
+}
+
+int RtspMulticast::getRtpPort(int index)
+{
+    auto iter = _mapPort.find(index);
+    if (iter == _mapPort.end()) {
+        return -1;
+    }
+    return iter->second;
+}
+
+int RtspMulticast::getViewerCount()
+{
+    lock_guard<mutex> lck(_mtx);
+    return _mapViewer.size();
+}
+
+bool RtspMulticast::alloc()
+{
+    static string addrMin = Config::instance()->getAndListen([](const json &){
+        addrMin = Config::instance()->get("Rtsp", "Server", "Server1", "multicastAddrMin");
+    }, "Rtsp", "Server", "Server1", "multicastAddrMin", "239.1.0.0");
+
+    static string addrMax = Config::instance()->getAndListen([](const json &){
+        addrMax = Config::instance()->get("Rtsp", "Server", "Server1", "multicastAddrMax");
+    }, "Rtsp", "Server", "Server1", "multicastAddrMax", "239.1.255.255");
+
+    static int portMin = Config::instance()->getAndListen([](const json &){
+        portMin = Config::instance()->get("Rtsp", "Server", "Server1", "multicastPortMin");
+    }, "Rtsp", "Server", "Server1", "multicastPortMin", "30000");
+
+    static int portMax = Config::instance()->getAndListen([](const json &){
+        portMax = Config::instance()->get("Rtsp", "Server", "Server1", "multicastPortMax");
+    }, "Rtsp", "Server", "Server1", "multicastPortMax", "31000");
+
+    static int ttl = Config::instance()->getAndListen([](const json &){
+        ttl = Config::instance()->get("Rtsp", "Server", "Server1", "multicastTtl");
+    }, "Rtsp", "Server", "Server1", "multicastTtl", "16");
+
+    auto source = _source.lock();
+    if (!source) {
+        return false;
+    }
+    _ttl = ttl;
+
+    // 组播地址，按主机序比较
+    struct in_addr minAddr, maxAddr;
+    if (inet_pton(AF_INET, addrMin.data(), &minAddr) != 1 || inet_pton(AF_INET, addrMax.data(), &maxAddr) != 1) {
+        logWarn << "invalid multicast address range: " << addrMin << "-" << addrMax;
+        return false;
+    }
+    uint32_t low = ntohl(minAddr.s_addr);
+    uint32_t high = ntohl(maxAddr.s_addr);
+    if (low > high || !IN_MULTICAST(low) || !IN_MULTICAST(high)) {
+        logWarn << "invalid multicast address range: " << addrMin << "-" << addrMax;
+        return false;
+    }
+    uint64_t count = (uint64_t)high - low + 1;
+    for (uint64_t i = 0; i < count; ++i) {
+        uint32_t addr = low + (g_groupCursor + i) % count;
+        // 跳过.0和.255，部分设备不认
+        if ((addr & 0xFF) == 0 || (addr & 0xFF) == 0xFF || g_usedGroup.count(addr)) {
+            continue;
+        }
+        _groupAddr = addr;
+        g_groupCursor = (addr - low + 1) % count;
+        break;
+    }
+    if (_groupAddr == 0) {
+        logWarn << "multicast address pool is exhausted";
+        return false;
+    }
+    g_usedGroup.insert(_groupAddr);
+
+    char group[INET_ADDRSTRLEN] = {0};
+    struct in_addr groupAddr;
+    groupAddr.s_addr = htonl(_groupAddr);
+    inet_ntop(AF_INET, &groupAddr, group, sizeof(group));
+    _group = group;
+
+    // 每个track一对端口，rtp为偶数
+    int low_port = (portMin + 1) & ~1;
+    int pairs = (portMax - low_port + 1) / 2;
+    for (auto& iter : source->getTrack()) {
+        int port = -1;
+        for (int i = 0; i < pairs; ++i) {
+            int candidate = low_port + (g_portCursor + i) % pairs * 2;
+            if (g_usedPort.count(candidate)) {
+                continue;
+            }
+            port = candidate;
+            g_portCursor = (g_portCursor + i + 1) % pairs;
+            break;
+        }
+        if (port < 0) {
+            logWarn << "multicast port pool is exhausted";
+            free();
+            return false;
+        }
+        g_usedPort.insert(port);
+        _mapPort[iter.first] = port;
+    }
+
+    return !_mapPort.empty();
+}
+
+void RtspMulticast::free()
+{
+    if (_groupAddr) {
+        g_usedGroup.erase(_groupAddr);
+        _groupAddr = 0;
+    }
+    for (auto& iter : _mapPort) {
+        g_usedPort.erase(iter.second);
+    }
+    _mapPort.clear();
+}
+
+void RtspMulticast::updateSend()
+{
+    bool playing = false;
+    {
+        lock_guard<mutex> lck(_mtx);
+        playing = !_stopped && !_setPlaying.empty();
+    }
+
+    if (!playing) {
+        if (_reader) {
+            logInfo << "no multicast viewer is playing, pause: " << _key;
+            stopSend();
+        }
+        return ;
+    }
+    if (_reader || start()) {
+        return ;
+    }
+
+    // 启动失败，通知在播放的观众断开，地址和端口等没有观众后再归还
+    vector<function<void()>> callbacks;
+    {
+        lock_guard<mutex> lck(_mtx);
+        for (auto key : _setPlaying) {
+            auto iter = _mapViewer.find(key);
+            if (iter != _mapViewer.end() && iter->second) {
+                callbacks.push_back(iter->second);
+            }
+        }
+        _setPlaying.clear();
+    }
+    for (auto& callback : callbacks) {
+        callback();
+    }
+}
+
+bool RtspMulticast::start()
+{
+    static string iface = Config::instance()->getAndListen([](const json &){
+        iface = Config::instance()->get("Rtsp", "Server", "Server1", "multicastInterface");
+    }, "Rtsp", "Server", "Server1", "multicastInterface");
+
+    static int loopback = Config::instance()->getAndListen([](const json &){
+        loopback = Config::instance()->get("Rtsp", "Server", "Server1", "multicastLoop");
+    }, "Rtsp", "Server", "Server1", "multicastLoop");
+
+    auto source = _source.lock();
+    if (!source || _stopped) {
+        return false;
+    }
+
+    for (auto& iter : _mapPort) {
+        auto track = source->getTrack(iter.first);
+        if (!track) {
+            continue;
+        }
+
+        Socket::Ptr sockets[2];
+        for (int i = 0; i < 2; ++i) {
+            auto socket = make_shared<Socket>(_loop);
+            if (socket->createSocket(SOCKET_UDP) < 0) {
+                logError << "create multicast socket failed: " << _key;
+                if (sockets[0]) {
+                    sockets[0]->close();
+                }
+                stopSend();
+                return false;
+            }
+            // rtcp绑定在组播地址的rtp端口+1上并加入组，接收观众的rr
+            int ret = 0;
+            if (i == 0) {
+                ret = socket->bind(0, iface.empty() ? "0.0.0.0" : iface.data());
+            } else {
+                ret = socket->bind(iter.second + 1, _group.data());
+                if (ret == 0) {
+                    ret = socket->joinMulticast(_group, iface);
+                }
+            }
+            if (ret < 0) {
+                logError << "bind multicast socket failed: " << _key << ", group: " << _group
+                         << ", port: " << (i == 0 ? 0 : iter.second + 1);
+                // bind失败时socket已经关闭
+                if (sockets[0]) {
+                    sockets[0]->close();
+                }
+                stopSend();
+                return false;
+            }
+            socket->setMulticastTtl(_ttl);
+            socket->setMulticastLoop(loopback);
+            if (!iface.empty()) {
+                socket->setMulticastIf(iface);
+            }
+
+            struct sockaddr_in peer = {};
+            peer.sin_family = AF_INET;
+            peer.sin_port = htons(iter.second + i);
+            peer.sin_addr.s_addr = htonl(_groupAddr);
+            socket->bindPeerAddr((struct sockaddr*)&peer);
+            socket->addToEpoll();
+            sockets[i] = socket;
+        }
+
+        auto rtpTrans = make_shared<RtspRtpTransport>(Transport_MULTICAST, TransportData_Media, track, sockets[0]);
+        auto rtcpTrans = make_shared<RtspRtcpTransport>(Transport_MULTICAST, TransportData_Data, track, sockets[1]);
+        rtpTrans->setRtcp(rtcpTrans);
+        rtpTrans->start();
+        rtcpTrans->start();
+        _mapRtpTransport[iter.first] = rtpTrans;
+        _mapRtcpTransport[iter.first] = rtcpTrans;
+    }
+
+    weak_ptr<RtspMulticast> wSelf = shared_from_this();
+    uint32_t seq = ++_sendSeq;
+    _reader = source->getRing()->attach(_loop, true);
+    _reader->setReadCB([wSelf](const RtspMediaSource::DataType &pack) {
+        auto self = wSelf.lock();
+        if (!self || self->_stopped) {
+            return ;
+        }
+        for (auto& rtp : *pack) {
+            auto iter = self->_mapRtpTransport.find(rtp->trackIndex_);
+            if (iter != self->_mapRtpTransport.end()) {
+                int bytes = iter->second->sendRtpPacket(rtp, true);
+                self->_sendBytes += bytes;
+                self->_intervalSendBytes += bytes;
+            }
+        }
+    });
+    _reader->setDetachCB([wSelf]() {
+        auto self = wSelf.lock();
+        if (self) {
+            self->onDetach();
+        }
+    });
+    _reader->setGetInfoCB([wSelf]() {
+        ClientInfo ret;
+        auto self = wSelf.lock();
+        if (!self) {
+            return ret;
+        }
+        ret.ip_ = self->_group;
+        ret.port_ = self->_mapPort.empty() ? 0 : self->_mapPort.begin()->second;
+        ret.protocol_ = PROTOCOL_RTSP;
+        ret.bitrate_ = self->_lastBitrate;
+        ret.info_["transport"] = "multicast";
+        ret.info_["viewers"] = to_string(self->getViewerCount());
+        ret.close_ = [wSelf](){
+            auto self = wSelf.lock();
+            if (self) {
+                self->_loop->async([wSelf](){
+                    auto self = wSelf.lock();
+                    if (self) {
+                        self->onDetach();
+                    }
+                }, true);
+            }
+        };
+        return ret;
+    });
+
+    _loop->addTimerTask(kSenderReportInterval, [wSelf, seq](){
+        auto self = wSelf.lock();
+        if (!self || self->_stopped || self->_sendSeq != seq || !self->_reader) {
+            return 0;
+        }
+        self->_lastBitrate = self->_intervalSendBytes / (kSenderReportInterval / 1000.0);
+        self->_intervalSendBytes = 0;
+        self->sendSenderReport();
+        return kSenderReportInterval;
+    }, nullptr);
+
+    logInfo << "start multicast: " << _key << ", group: " << _group << ", tracks: " << _mapRtpTransport.size();
+
+    return true;
+}
+
+void RtspMulticast::sendSenderReport()
+{
+    for (auto& iter : _mapRtcpTransport) {
+        iter.second->sendRtcpPacket();
+    }
+}
+
+void RtspMulticast::stopSend()
+{
+    // 读取器析构时会回调detach，暂停不是流下线
+    if (_reader) {
+        _reader->setDetachCB(nullptr);
+        _reader = nullptr;
+    }
+    for (auto& iter : _mapRtpTransport) {
+        iter.second->getSocket()->close();
+    }
+    for (auto& iter : _mapRtcpTransport) {
+        iter.second->getSocket()->close();
+    }
+    _mapRtpTransport.clear();
+    _mapRtcpTransport.clear();
+}
+
+void RtspMulticast::stop()
+{
+    stopSend();
+
+    lock_guard<mutex> lck(_mtx);
+    free();
+}
+
+void RtspMulticast::onDetach()
+{
+    unordered_map<void*, function<void()>> viewers;
+    {
+        lock_guard<mutex> lck(_mtx);
+        if (_stopped) {
+            return ;
+        }
+        _stopped = true;
+        viewers.swap(_mapViewer);
+        auto iter = _mapMulticast.find(_key);
+        if (iter != _mapMulticast.end() && iter->second.get() == this) {
+            _mapMulticast.erase(iter);
+        }
+    }
+
+    logInfo << "multicast source detached: " << _key;
+    stop();
+    for (auto& iter : viewers) {
+        if (iter.second) {
+            iter.second();
+        }
+    }
+}
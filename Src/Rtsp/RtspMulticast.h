@@ -0,0 +1,85 @@
+#ifndef RtspMulticast_H
+#define RtspMulticast_H
+
+#include <unordered_map>
+#include <unordered_set>
+#include <string>
+#include <memory>
+#include <mutex>
+#include <functional>
+
+#include "RtspMediaSource.h"
+#include "RtspRtpTransport.h"
+#include "RtspRtcpTransport.h"
+#include "EventPoller/EventLoop.h"
+
+using namespace std;
+
+// rtsp组播发送，同一个流的所有组播观众共用一个读取器和一组socket
+// 每个流从地址池分配一个组播地址，每个track分配一对rtp/rtcp端口
+// SETUP时加入并分配地址，PLAY后才发送，所有观众都PAUSE时暂停发送
+// TEARDOWN或断开时离开，没有观众后停止发送并归还地址和端口
+class RtspMulticast : public enable_shared_from_this<RtspMulticast>
+{
+public:
+    using Ptr = shared_ptr<RtspMulticast>;
+    using Wptr = weak_ptr<RtspMulticast>;
+
+    RtspMulticast(const RtspMediaSource::Ptr& source, const EventLoop::Ptr& loop);
+    ~RtspMulticast();
+
+public:
+    // 加入流的组播，没有时创建，分配失败返回nullptr
+    // onDetach在流下线时回调，观众应断开连接
+    static RtspMulticast::Ptr join(const RtspMediaSource::Ptr& source, const EventLoop::Ptr& loop,
+                                    void* key, const function<void()>& onDetach);
+    void leave(void* key);
+    // 和当前loop相同时同步启动，启动失败返回false；否则异步启动，失败时通过onDetach通知观众
+    bool play(void* key);
+    void pause(void* key);
+
+    string getGroup() {return _group;}
+    int getTtl() {return _ttl;}
+    // rtcp端口为rtp端口+1，没有该track时返回-1
+    int getRtpPort(int index);
+    int getViewerCount();
+    uint64_t getSendBytes() {return _sendBytes;}
+
+private:
+    bool alloc();
+    void free();
+    // 在_loop里执行，按是否有观众在播放启动或暂停发送
+    void updateSend();
+    bool start();
+    void stopSend();
+    void stop();
+    void onDetach();
+    void sendSenderReport();
+
+private:
+    bool _stopped = false;
+    int _ttl = 16;
+    uint32_t _groupAddr = 0;
+    uint64_t _sendBytes = 0;
+    uint64_t _intervalSendBytes = 0;
+    // 每次启动加一，暂停后旧的sr定时器退出
+    uint32_t _sendSeq = 0;
+    float _lastBitrate = 0;
+    string _key;
+    string _group;
+    EventLoop::Ptr _loop;
+    RtspMediaSource::Wptr _source;
+    RtspMediaSource::QueType::DataQueReaderT::Ptr _reader;
+    // index : rtp端口
+    unordered_map<int, int> _mapPort;
+    unordered_map<int, RtspRtpTransport::Ptr> _mapRtpTransport;
+    unordered_map<int, RtspRtcpTransport::Ptr> _mapRtcpTransport;
+    unordered_map<void*, function<void()>> _mapViewer;
+    // PLAY之后、PAUSE之前的观众
+    unordered_set<void*> _setPlaying;
+
+    static mutex _mtx;
+    static unordered_map<string/*uri_vhost_type*/, RtspMulticast::Ptr> _mapMulticast;
+};
+
+#endif //RtspMulticast_H
@@ -41,15 +41,15 @@ static shared_ptr<TrackInfo> createTrackBySdp(const shared_ptr<SdpMedia>& media)
         }
         aacTrackInfo->setAacInfo(aac_cfg);
         trackInfo = aacTrackInfo;
-        trackInfo->codec_ = "aac";
+        trackInfo->codec_ = CodecAAC;
     } else if (strcasecmp(media->codec_.data(), "pcma") == 0) {
         auto g711aTrackInfo = make_shared<G711aTrack>();
         trackInfo = g711aTrackInfo;
-        trackInfo->codec_ = "g711a";
+        trackInfo->codec_ = CodecG711A;
     } else if (strcasecmp(media->codec_.data(), "pcmu") == 0) {
         auto g711uTrackInfo = make_shared<G711uTrack>();
         trackInfo = g711uTrackInfo;
-        trackInfo->codec_ = "g711u";
+        trackInfo->codec_ = CodecG711U;
     } else if (strcasecmp(media->codec_.data(), "h264") == 0) {
         logInfo << "createTrackBySdp h264";
         auto h264TrackInfo = H264Track::createTrack(media->index_, media->payloadType_, media->samplerate_);;
@@ -81,7 +81,7 @@ static shared_ptr<TrackInfo> createTrackBySdp(const shared_ptr<SdpMedia>& media)
         h264TrackInfo->setPps(ppsFrame);
         logInfo << "createTrackBySdp start trackInfo";
         trackInfo = h264TrackInfo;
-        trackInfo->codec_ = "h264";
+        trackInfo->codec_ = CodecH264;
         logInfo << "createTrackBySdp trackInfo";
     } else if (strcasecmp(media->codec_.data(), "h265") == 0) {
         auto h265TrackInfo = make_shared<H265Track>();
@@ -106,7 +106,7 @@ static shared_ptr<TrackInfo> createTrackBySdp(const shared_ptr<SdpMedia>& media)
         h265TrackInfo->setSps(spsFrame);
         h265TrackInfo->setPps(ppsFrame);
         trackInfo = h265TrackInfo;
-        trackInfo->codec_ = "h265";
+        trackInfo->codec_ = CodecH265;
     }
 
     if (trackInfo) {
@@ -127,7 +127,7 @@ RtspPsDecodeTrack::RtspPsDecodeTrack(int trackIndex, const shared_ptr<SdpMedia>&
     ,_media(media)
 {
     _trackInfo = make_shared<TrackInfo>();
-    _trackInfo->codec_ = "ps";
+    _trackInfo->codec_ = CodecPS;
     _trackInfo->index_ = media->index_;
     _trackInfo->samplerate_ = media->samplerate_;
 
@@ -142,9 +142,9 @@ RtspPsDecodeTrack::RtspPsDecodeTrack(int trackIndex, const shared_ptr<SdpMedia>&
 void RtspPsDecodeTrack::onRtpPacket(const RtpPacket::Ptr& rtp, bool start)
 {
     // if (_trackInfo->trackType_ == "video") {
-    //     if (_trackInfo->codec_ == "h264") {
+    //     if (_trackInfo->codec_ == CodecH264) {
     //         start = RtpDecodeH264::isStartGop(rtp);
-    //     } else if (_trackInfo->codec_ == "h265") {
+    //     } else if (_trackInfo->codec_ == CodecH265) {
     //         start = RtpDecodeH265::isStartGop(rtp);
     //     } else {
     //         start = true;
@@ -251,9 +251,9 @@ void RtspPsDecodeTrack::onFrame(const FrameBuffer::Ptr& frame)
 {
     int samples = 1;
     if (frame->getTrackType() == AudioTrackType) {
-        if (frame->codec() == "aac") {
+        if (frame->codec() == CodecAAC) {
             samples = 1024;
-        } else if (frame->codec() == "g711a" || frame->codec() == "g711u") {
+        } else if (frame->codec() == CodecG711A || frame->codec() == CodecG711U) {
             samples = frame->size() - frame->startSize();
         }
     }
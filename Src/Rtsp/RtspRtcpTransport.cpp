@@ -50,6 +50,10 @@ void RtspRtcpTransport::onSendRtp(const RtpPacket::Ptr& rtp)
 }
 
 void RtspRtcpTransport::onRtcpPacket(const StreamBuffer::Ptr& buffer) {
+    // 组播的sr由定时器发送，不逐个回复rr，开启组播回环时也会收到自己发的sr
+    if (_transType == Transport_MULTICAST) {
+        return ;
+    }
     sendRtcpPacket();
 }
 
@@ -7,6 +7,7 @@
 #include "Rtp/RtpPacket.h"
 #include "Logger.h"
 #include "Util/String.h"
+#include "Common/Config.h"
 #include "Rtp/Decoder/RtpDecodeH264.h"
 
 using namespace std;
@@ -23,8 +24,15 @@ RtspRtpTransport::RtspRtpTransport(int transType, int dataType, const RtspTrack:
 
 void RtspRtpTransport::start() {
     RtspRtpTransport::Wptr wSelf = shared_from_this();
-    // TODO get limits from config
-    _sort = make_shared<RtpSort>(25);
+    // 旧的配置文件没有这两项时保持原来的256个包的排序深度
+    static int jitterDepth = Config::instance()->getAndListen([](const json& config){
+        jitterDepth = Config::instance()->get("Rtp", "jitterDepth", "", "", "256");
+    }, "Rtp", "jitterDepth", "", "", "256");
+    static int jitterMaxWait = Config::instance()->getAndListen([](const json& config){
+        jitterMaxWait = Config::instance()->get("Rtp", "jitterMaxWait", "", "", "100");
+    }, "Rtp", "jitterMaxWait", "", "", "100");
+
+    _sort = make_shared<RtpSort>(jitterDepth, jitterMaxWait);
     _sort->setOnRtpPacket([wSelf](const RtpPacket::Ptr& rtp){
         // logInfo << "decode rtp seq: " << rtp->getSeq() << ", rtp size: " << rtp->size() << ", rtp time: " << rtp->getStamp();
         auto self = wSelf.lock();
@@ -32,6 +40,7 @@ void RtspRtpTransport::start() {
             self->_track->onRtpPacket(rtp, false);
         }
     });
+    _sort->startTimer(_socket->getLoop());
     _socket->setReadCb([wSelf](const StreamBuffer::Ptr& buffer, struct sockaddr* addr, int len){
         // TODO 保存对端地址，udp发送时需要
         auto self = wSelf.lock();
@@ -156,6 +165,7 @@ int RtspRtpTransport::sendRtpPacket(const RtpPacket::Ptr &packet, bool flag)
             // setSendFlushFlag(true);
         }
             break;
+        case Transport_MULTICAST:
         case Transport_UDP: {
             // setSendFlushFlag(false);
             // int i = 0;
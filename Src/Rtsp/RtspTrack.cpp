@@ -46,23 +46,23 @@ static shared_ptr<TrackInfo> createTrackBySdp(const shared_ptr<SdpMedia>& media)
         }
         aacTrackInfo->setAacInfo(aac_cfg);
         trackInfo = aacTrackInfo;
-        trackInfo->codec_ = "aac";
+        trackInfo->codec_ = CodecAAC;
     } else if (strcasecmp(media->codec_.data(), "pcma") == 0) {
         auto g711aTrackInfo = make_shared<G711aTrack>();
         trackInfo = g711aTrackInfo;
-        trackInfo->codec_ = "g711a";
+        trackInfo->codec_ = CodecG711A;
     } else if (strcasecmp(media->codec_.data(), "pcmu") == 0) {
         auto g711uTrackInfo = make_shared<G711uTrack>();
         trackInfo = g711uTrackInfo;
-        trackInfo->codec_ = "g711u";
+        trackInfo->codec_ = CodecG711U;
     } else if (strcasecmp(media->codec_.data(), "opus") == 0) {
         auto opusTrackInfo = make_shared<OpusTrack>();
         trackInfo = opusTrackInfo;
-        trackInfo->codec_ = "opus";
+        trackInfo->codec_ = CodecOpus;
     } else if (strcasecmp(media->codec_.data(), "mp3") == 0) {
         auto mp3Track = make_shared<Mp3Track>();
         trackInfo = mp3Track;
-        trackInfo->codec_ = "mp3";
+        trackInfo->codec_ = CodecMP3;
     } else if (strcasecmp(media->codec_.data(), "h264") == 0) {
         logTrace << "createTrackBySdp h264";
         auto h264TrackInfo = H264Track::createTrack(media->index_, media->payloadType_, media->samplerate_);
@@ -121,19 +121,19 @@ static shared_ptr<TrackInfo> createTrackBySdp(const shared_ptr<SdpMedia>& media)
         h265TrackInfo->setSps(spsFrame);
         h265TrackInfo->setPps(ppsFrame);
         trackInfo = h265TrackInfo;
-        trackInfo->codec_ = "h265";
+        trackInfo->codec_ = CodecH265;
     } else if (strcasecmp(media->codec_.data(), "vp9") == 0) {
         auto vp9Track = make_shared<VP9Track>();
         trackInfo = vp9Track;
-        trackInfo->codec_ = "vp9";
+        trackInfo->codec_ = CodecVP9;
     } else if (strcasecmp(media->codec_.data(), "vp8") == 0) {
         auto vp8Track = make_shared<VP8Track>();
         trackInfo = vp8Track;
-        trackInfo->codec_ = "vp8";
+        trackInfo->codec_ = CodecVP8;
     } else if (strcasecmp(media->codec_.data(), "av1") == 0) {
         auto av1Track = make_shared<AV1Track>();
         trackInfo = av1Track;
-        trackInfo->codec_ = "av1";
+        trackInfo->codec_ = CodecAV1;
     } 
 
     if (trackInfo) {
@@ -180,9 +180,9 @@ void RtspDecodeTrack::onRtpPacket(const RtpPacket::Ptr& rtp, bool start)
     // _ring->write(rtp, true);
 
     if (_trackInfo->trackType_ == "video") {
-        if (_trackInfo->codec_ == "h264") {
+        if (_trackInfo->codec_ == CodecH264) {
             start = RtpDecodeH264::isStartGop(rtp);
-        } else if (_trackInfo->codec_ == "h265") {
+        } else if (_trackInfo->codec_ == CodecH265) {
             start = RtpDecodeH265::isStartGop(rtp);
         } else {
             start = true;
@@ -236,9 +236,9 @@ void RtspDecodeTrack::onFrame(const FrameBuffer::Ptr& frame)
 {
     int samples = 1;
     if (_type == AudioTrackType) {
-        if (_trackInfo->codec_ == "aac") {
+        if (_trackInfo->codec_ == CodecAAC) {
             samples = 1024;
-        } else if (_trackInfo->codec_ == "g711a" || _trackInfo->codec_ == "g711u") {
+        } else if (_trackInfo->codec_ == CodecG711A || _trackInfo->codec_ == CodecG711U) {
             samples = frame->size() - frame->startSize();
         }
     }
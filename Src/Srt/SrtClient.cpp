@@ -56,15 +56,32 @@ bool SrtClient::start(const string& localIp, int localPort, const string& url, i
         return false;
     }
 
-    if (_socket->connect(_peerUrlParser.host_, _peerUrlParser.port_, timeout) != 0) {
+    if (_request != "push" && _request != "pull") {
+        logWarn << "invalid request: " << _request;
         close();
-        logInfo << "TcpClient::connect, ip: " << _peerUrlParser.host_ << ", peerPort: " 
-                << _peerUrlParser.port_ << ", failed";
-
         return false;
     }
 
     weak_ptr<SrtClient> wSelf = shared_from_this();
+    // 握手完成后再开始推拉流，连接失败或超时走onError
+    _socket->setConnectCb([wSelf](bool ok){
+        auto self = wSelf.lock();
+        if (!self) {
+            return ;
+        }
+
+        if (!ok) {
+            self->onError("connect to " + self->_url + " failed");
+            return ;
+        }
+
+        if (self->_request == "push") {
+            self->handlePush();
+        } else {
+            self->initPull();
+        }
+    });
+
     _socket->setErrorCb([wSelf](){
         auto self = wSelf.lock();
         if (!self) {
@@ -97,12 +114,11 @@ bool SrtClient::start(const string& localIp, int localPort, const string& url, i
         self->_acceptSocket = acceptSocket;
     });
 
-    if (_request == "push") {
-        handlePush();
-    } else if (_request == "pull") {
-        initPull();
-    } else {
-        onError("invalid request: " + _request);
+    if (_socket->connect(_peerUrlParser.host_, _peerUrlParser.port_, timeout) != 0) {
+        close();
+        logInfo << "SrtClient::connect, ip: " << _peerUrlParser.host_ << ", peerPort: " 
+                << _peerUrlParser.port_ << ", failed";
+
         return false;
     }
 
@@ -228,6 +228,10 @@ void SrtConnection::onPlayTs(const TsMediaSource::Ptr &tsSrc)
     if (!_playTsReader) {
 		logInfo << "set _playTsReader";
 		_playTsReader = tsSrc->getRing()->attach(_loop, true);
+		DataQueStartPolicy policy;
+		if (DataQueStartPolicy::parseParam(_urlParser.vecParam_, policy)) {
+			_playTsReader->setStartPolicy(policy);
+		}
 		_playTsReader->setGetInfoCB([wSelf]() {
 			auto self = wSelf.lock();
 			ClientInfo ret;
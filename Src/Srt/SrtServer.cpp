@@ -21,90 +21,89 @@ SrtServer::Ptr& SrtServer::instance()
 
 void SrtServer::start(const string& ip, int port, int count, int sockType)
 {
-    static int listened = false;
+    // srt同一个端口只能有一个listener，只在一个loop上监听，
+    // accept出来的连接再轮询分到各个srt loop上，握手和收发不会都挤在一个线程
+    auto loop = SrtEventLoopPool::instance()->getLoopByCircle();
+    SrtSocket::Ptr socket = make_shared<SrtSocket>(loop, true);
+    socket->createSocket(0);
+    if (socket->bind(port, ip.data()) == -1) {
+        logInfo << "bind srt failed, port: " << port;
+        return ;
+    }
+
+    logTrace << "start listen =====================";
+    if (socket->listen(1024) == -1) {
+        logInfo << "listen srt failed, port: " << port;
+        return ;
+    }
+
+    logDebug << "socket fd: " << socket->getFd();
     SrtServer::Wptr wSelf = shared_from_this();
-    SrtEventLoopPool::instance()->for_each_loop([ip, port, wSelf, sockType](const SrtEventLoop::Ptr& loop){
+    SrtSocket::Wptr wSocket = socket;
+    socket->setAcceptCb([wSocket, wSelf](){
+        auto socket = wSocket.lock();
         auto self = wSelf.lock();
-        if (!self) {
+        if (!socket || !self) {
             return ;
         }
 
-        SrtSocket::Ptr socket = make_shared<SrtSocket>(loop, true);
-        socket->createSocket(0);
-        if (socket->bind(port, ip.data()) == -1) {
-            logInfo << "bind udp failed, port: " << port;
+        // 一次可读可能对应多个已完成握手的连接，取完为止
+        while (true) {
+            auto acceptFd = socket->accept();
+            if (acceptFd < 0) {
+                break;
+            }
+            self->onAccept(acceptFd);
+        }
+    });
+    socket->addToEpoll();
+
+    lock_guard<mutex> lck(_mtx);
+    _udpSockets[port].emplace_back(socket);
+}
+
+void SrtServer::onAccept(int acceptFd)
+{
+    auto loop = SrtEventLoopPool::instance()->getLoopByCircle();
+    SrtServer::Wptr wSelf = shared_from_this();
+    // 连接的回调都在所属的loop里执行
+    loop->async([wSelf, loop, acceptFd](){
+        auto self = wSelf.lock();
+        if (!self) {
+            srt_close(acceptFd);
             return ;
         }
-        
-        // if (!listened) {
-            logTrace << "start listen =====================";
-            if (socket->listen(1024) == -1) {
-                logInfo << "listen udp failed, port: " << port;
-                return ;
-            }
-            // listened = true;
-        // }
 
-        logDebug << "socket fd: " << socket->getFd();
-        socket->addToEpoll();
-        socket->setAcceptCb([socket, wSelf](){
-            auto acceptFd = socket->accept();
-            auto acceptSocket = make_shared<SrtSocket>(socket->getLoop(), acceptFd);
-            acceptSocket->addToEpoll();
+        auto acceptSocket = make_shared<SrtSocket>(loop, acceptFd);
+        auto conn = make_shared<SrtConnection>(loop, acceptSocket);
+
+        logTrace << "add srt conn: " << acceptFd;
+        {
+            lock_guard<mutex> lck(self->_mtx);
+            self->_mapSrtConn.emplace(acceptFd, conn);
+        }
 
-            auto conn = make_shared<SrtConnection>(socket->getLoop(), acceptSocket);
-            
+        conn->setOnClose([wSelf, acceptFd](){
             auto self = wSelf.lock();
             if (!self) {
                 return ;
             }
-            // int acceptFd = acceptSocket->getFd();
-            logTrace << "add srt conn: " << acceptFd;
-            self->_mapSrtConn.emplace(acceptFd, conn);
-
-            conn->setOnClose([wSelf, acceptFd](){
-                auto self = wSelf.lock();
-                if (!self) {
-                    return ;
-                }
-                logTrace << "erase srt conn: " << acceptFd;
-                self->_mapSrtConn.erase(acceptFd);
-            });
-            conn->init();
-            weak_ptr<SrtConnection> wConn = conn;
-            acceptSocket->setReadCb([wConn, wSelf](const StreamBuffer::Ptr& buffer, struct sockaddr* addr, int len){
-                auto conn = wConn.lock();
-                if (!conn) {
-                    return 0;
-                }
-                conn->onRead(buffer, addr, len);
+            logTrace << "erase srt conn: " << acceptFd;
+            lock_guard<mutex> lck(self->_mtx);
+            self->_mapSrtConn.erase(acceptFd);
+        });
+        weak_ptr<SrtConnection> wConn = conn;
+        acceptSocket->setReadCb([wConn](const StreamBuffer::Ptr& buffer, struct sockaddr* addr, int len){
+            auto conn = wConn.lock();
+            if (!conn) {
                 return 0;
-            });
+            }
+            conn->onRead(buffer, addr, len);
+            return 0;
         });
-        // static auto rtpManager = WebrtcContextManager::instance();
-        // rtpManager->init(loop);
-        // socket->setReadCb([socket, wSelf](const StreamBuffer::Ptr& buffer, struct sockaddr* addr, int len){
-        //     // create rtpmanager
-        //     // rtpManager->onUdpPacket(socket, buffer, addr, len);
-
-        //     auto acceptFd = socket->accept();
-        //     auto acceptSocket = make_shared<SrtSocket>(socket->getLoop(), acceptFd);
-
-        //     auto conn = make_shared<SrtConnection>(socket->getLoop(), socket);
-        //     conn->onRead(buffer, addr, len);
-
-        //     auto self = wSelf.lock();
-        //     if (!self) {
-        //         return -1;
-        //     }
-        //     self->_mapSrtConn.emplace(socket->getFd(), conn);
-
-        //     return 0;
-        // });
-        // // socket->setRecvBuf(4 * 1024 * 1024);
-        lock_guard<mutex> lck(self->_mtx);
-        self->_udpSockets[port].emplace_back(socket);
-    });
+        acceptSocket->addToEpoll();
+        conn->init();
+    }, true);
 }
 
 void SrtServer::stopByPort(int port, int count, int sockType)
@@ -38,6 +38,9 @@ public:
     
     void for_each_socket(const function<void(const SrtSocket::Ptr &)> &cb);
 
+private:
+    void onAccept(int acceptFd);
+
 private:
     mutex _mtx;
     // int : port
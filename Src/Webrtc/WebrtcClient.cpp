@@ -272,7 +272,7 @@ void WebrtcClient::initPusher()
         }
     }
 
-    // if (!videoInfo || videoInfo->codec_ != "h264") {
+    // if (!videoInfo || videoInfo->codec_ != CodecH264) {
     //     throw runtime_error("only surpport h264 now");
     // }
 
@@ -312,18 +312,18 @@ void WebrtcClient::initPusherLocalSdpMedia(stringstream& ss, const shared_ptr<Tr
     int audiossrc = 10000;
     int videossrc = 20000;
     if (audioInfo) {
-        if (audioInfo->codec_ == "g711a") {
+        if (audioInfo->codec_ == CodecG711A) {
             ss << "m=audio 9 UDP/TLS/RTP/SAVPF 8\r\n"
                << "a=rtpmap:8 PCMA/8000\r\n";
-        } else if (audioInfo->codec_ == "g711u") {
+        } else if (audioInfo->codec_ == CodecG711U) {
             ss << "m=audio 9 UDP/TLS/RTP/SAVPF 0\r\n"
                << "a=rtpmap:0 PCMU/8000\r\n";
-        } else if (audioInfo->codec_ == "opus") {
+        } else if (audioInfo->codec_ == CodecOpus) {
             ss << "m=audio 9 UDP/TLS/RTP/SAVPF 111\r\n"
                << "a=rtpmap:111 opus/48000/2\r\n"
                << "a=rtcp-fb:111 transport-cc\r\n"
                << "a=fmtp:111 minptime=10;useinbandfec=1\r\n";
-        } else if (audioInfo->codec_ == "aac") {
+        } else if (audioInfo->codec_ == CodecAAC) {
             ss << "m=audio 9 UDP/TLS/RTP/SAVPF 97\r\n"
                << "a=rtpmap:97 MPEG4-GENERIC/" << audioInfo->samplerate_ << "/" << audioInfo->channel_ << "\r\n"
                << "a=fmtp:97 streamtype=5;profile-level-id=1;mode=AAC-hbr;"
@@ -357,7 +357,7 @@ void WebrtcClient::initPusherLocalSdpMedia(stringstream& ss, const shared_ptr<Tr
     }
 
     if (videoInfo) {
-        if (videoInfo->codec_ == "h264") {
+        if (videoInfo->codec_ == CodecH264) {
             ss << "m=video 9 UDP/TLS/RTP/SAVPF 106\r\n"
                << "a=rtpmap:106 H264/90000\r\n"
                << "a=rtcp-fb:106 goog-remb\r\n"
@@ -366,7 +366,7 @@ void WebrtcClient::initPusherLocalSdpMedia(stringstream& ss, const shared_ptr<Tr
                << "a=rtcp-fb:106 nack\r\n"
                << "a=rtcp-fb:106 nack pli\r\n"
                << "a=fmtp:106 level-asymmetry-allowed=1;packetization-mode=1;profile-level-id=42e01f\r\n";
-        } else if (videoInfo->codec_ == "h265") {
+        } else if (videoInfo->codec_ == CodecH265) {
             ss << "m=video 9 UDP/TLS/RTP/SAVPF 106\r\n"
                << "a=rtpmap:106 H265/90000\r\n"
                << "a=rtcp-fb:106 goog-remb\r\n"
@@ -375,7 +375,7 @@ void WebrtcClient::initPusherLocalSdpMedia(stringstream& ss, const shared_ptr<Tr
                << "a=rtcp-fb:106 nack\r\n"
                << "a=rtcp-fb:106 nack pli\r\n"
                << "a=fmtp:106 level-asymmetry-allowed=1;packetization-mode=1;profile-level-id=42e01f\r\n";
-        } else if (videoInfo->codec_ == "vp8") {
+        } else if (videoInfo->codec_ == CodecVP8) {
             ss << "m=video 9 UDP/TLS/RTP/SAVPF 96\r\n"
                << "a=rtpmap:96 VP8/90000\r\n"
                << "a=rtcp-fb:96 goog-remb\r\n"
@@ -383,7 +383,7 @@ void WebrtcClient::initPusherLocalSdpMedia(stringstream& ss, const shared_ptr<Tr
                << "a=rtcp-fb:96 ccm fir\r\n"
                << "a=rtcp-fb:96 nack\r\n"
                << "a=rtcp-fb:96 nack pli\r\n";
-        } else if (videoInfo->codec_ == "vp9") {
+        } else if (videoInfo->codec_ == CodecVP9) {
             ss << "m=video 9 UDP/TLS/RTP/SAVPF 100\r\n"
                << "a=rtpmap:100 VP9/90000\r\n"
                << "a=rtcp-fb:100 goog-remb\r\n"
@@ -392,7 +392,7 @@ void WebrtcClient::initPusherLocalSdpMedia(stringstream& ss, const shared_ptr<Tr
                << "a=rtcp-fb:100 nack\r\n"
                << "a=rtcp-fb:100 nack pli\r\n"
                << "a=fmtp:100 profile-id=2\r\n";
-        } else if (videoInfo->codec_ == "av1") {
+        } else if (videoInfo->codec_ == CodecAV1) {
             ss << "m=video 9 UDP/TLS/RTP/SAVPF 45\r\n"
                << "a=rtpmap:45 AV1/90000\r\n"
                << "a=rtcp-fb:45 goog-remb\r\n"
@@ -110,7 +110,7 @@ void WebrtcContext::initPlayer(const string& appName, const string& streamName,
         }
     }
 
-    // if (!videoInfo || videoInfo->codec_ != "h264") {
+    // if (!videoInfo || videoInfo->codec_ != CodecH264) {
     //     throw runtime_error("only surpport h264 now");
     // }
 
@@ -310,7 +310,7 @@ void WebrtcContext::negotiatePlayValid(const shared_ptr<TrackInfo>& videoInfo, c
             bool first = true;
             bool isH264 = true;
             if (videoInfo) {
-                isH264 = videoInfo->codec_ == "h264";
+                isH264 = videoInfo->codec_ == CodecH264;
             }
 
             // cloneTrack(trackInfo, videoInfo);
@@ -319,7 +319,7 @@ void WebrtcContext::negotiatePlayValid(const shared_ptr<TrackInfo>& videoInfo, c
                 logTrace << "video/audio codec:" << ptIter.second->codec_;
                 logTrace << "video/audio pt:" << ptIter.first;
                 logTrace << "videoInfo->codec_:" << videoInfo->codec_;
-                if (videoInfo && strcasecmp(ptIter.second->codec_.data(), videoInfo->codec_.data()) == 0) {
+                if (videoInfo && strcasecmp(ptIter.second->codec_.data(), videoInfo->codec_.name().data()) == 0) {
                     findFlag = true;
                     if (isH264) {
                         if (first) {
@@ -331,13 +331,13 @@ void WebrtcContext::negotiatePlayValid(const shared_ptr<TrackInfo>& videoInfo, c
                             remotePtInfo = ptIter.second;
                             break;
                         }
-                    } else if (strcasecmp(videoInfo->codec_.data(), "av1") == 0) {
+                    } else if (videoInfo->codec_ == CodecAV1) {
                         if (ptIter.second->fmtp_.find("profile=0") != string::npos) {
                             remotePtInfo = ptIter.second;
                         } else if (!remotePtInfo) {
                             remotePtInfo = ptIter.second;
                         }
-                    } else if (strcasecmp(videoInfo->codec_.data(), "h265") == 0) {
+                    } else if (videoInfo->codec_ == CodecH265) {
                         if (ptIter.second->fmtp_.find("profile-id=2") != string::npos) {
                             remotePtInfo = ptIter.second;
                         } else if (!remotePtInfo) {
@@ -411,15 +411,15 @@ void WebrtcContext::negotiatePlayValid(const shared_ptr<TrackInfo>& videoInfo, c
                     remotePtInfo = ptIter.second;
                     first = false;
                 }
-                if (audioInfo && ((strcasecmp(ptIter.second->codec_.data(), audioInfo->codec_.data()) == 0) || 
-                    (audioInfo->codec_ == "g711a" && ptIter.second->codec_ == "PCMA") || 
-                    (audioInfo->codec_ == "g711u" && ptIter.second->codec_ == "PCMU") ||
-                    (audioInfo->codec_ == "aac" && ptIter.second->codec_ == "MPEG4-GENERIC"))) {
+                if (audioInfo && ((strcasecmp(ptIter.second->codec_.data(), audioInfo->codec_.name().data()) == 0) || 
+                    (audioInfo->codec_ == CodecG711A && ptIter.second->codec_ == "PCMA") || 
+                    (audioInfo->codec_ == CodecG711U && ptIter.second->codec_ == "PCMU") ||
+                    (audioInfo->codec_ == CodecAAC && ptIter.second->codec_ == "MPEG4-GENERIC"))) {
                     remotePtInfo = ptIter.second;
                     findFlag = true;
                     break;
                 }
-                if (ptIter.second->codec_ == "opus") {
+                if (ptIter.second->codec_ == CodecOpus) {
                     opusPtInfo = ptIter.second;
                 }
             }
@@ -900,12 +900,12 @@ void WebrtcContext::onStunPacket(const Socket::Ptr& socket, const WebrtcStun& st
     }
 
     if (!_addr && addr) {
-        _socket = socket;
+        std::atomic_store(&_socket, socket);
 	    _addrLen = len;
         _addr = (struct sockaddr*)malloc(len);
 	    memcpy(_addr, addr, len);
 
-        _loop = socket->getLoop();
+        std::atomic_store(&_loop, socket->getLoop());
 
         if (!_isPlayer) {
             auto rtcSrc = _source.lock();
@@ -948,16 +948,7 @@ void WebrtcContext::onStunPacket(const Socket::Ptr& socket, const WebrtcStun& st
             });
         }
 
-        _loop->addTimerTask(2000, [wSelf](){
-            auto self = wSelf.lock();
-            if (!self) {
-                return 0;
-            }
-
-            self->onManager();
-
-            return 2000;
-        }, nullptr);
+        addManagerTimer();
     }
 
         
@@ -1019,12 +1010,12 @@ void WebrtcContext::onDtlsPacket(const Socket::Ptr& socket, const StreamBuffer::
     _dtlsSession->onDtls(socket, buffer, addr, len);
 
     if (!_addr && addr) {
-        _socket = socket;
+        std::atomic_store(&_socket, socket);
 	    _addrLen = len;
         _addr = (struct sockaddr*)malloc(len);
 	    memcpy(_addr, addr, len);
 
-        _loop = socket->getLoop();
+        std::atomic_store(&_loop, socket->getLoop());
     }
 
     // cerr << "WebrtcContext::_srtpSession =============== " << _srtpSession;
@@ -1040,12 +1031,12 @@ void WebrtcContext::onRtcpPacket(const Socket::Ptr& socket, const StreamBuffer::
 
     // logInfo << "WebrtcContext::onRtcpPacket =============== " << buffer->size();
     if (!_addr && addr) {
-        _socket = socket;
+        std::atomic_store(&_socket, socket);
 	    _addrLen = len;
         _addr = (struct sockaddr*)malloc(len);
 	    memcpy(_addr, addr, len);
 
-        _loop = socket->getLoop();
+        std::atomic_store(&_loop, socket->getLoop());
     }
 
 	nackHeartBeat();
@@ -1415,21 +1406,74 @@ void WebrtcContext::startPlay(const MediaSource::Ptr &src)
     }
 }
 
-void WebrtcContext::changeLoop(const EventLoop::Ptr& loop)
+void WebrtcContext::addManagerTimer()
 {
-    if (!loop) {
+    weak_ptr<WebrtcContext> wSelf = shared_from_this();
+    auto loop = _loop;
+    _loop->addTimerTask(2000, [wSelf, loop](){
+        auto self = wSelf.lock();
+        if (!self) {
+            return 0;
+        }
+
+        // 已迁移到其他loop，由新loop上的定时器接管
+        if (self->_loop != loop) {
+            return 0;
+        }
+
+        self->onManager();
+
+        return 2000;
+    }, nullptr);
+}
+
+uint64_t WebrtcContext::pollSendBytes()
+{
+    uint64_t bytes = _totalRtpBytes - _lastPollBytes;
+    _lastPollBytes = _totalRtpBytes;
+
+    return bytes;
+}
+
+void WebrtcContext::changeLoop(const EventLoop::Ptr& loop, const Socket::Ptr& socket)
+{
+    if (!loop || loop == _loop) {
+        return ;
+    }
+
+    weak_ptr<WebrtcContext> wSelf = shared_from_this();
+    if (_loop && !_loop->isCurrent()) {
+        _loop->async([wSelf, loop, socket](){
+            auto self = wSelf.lock();
+            if (self) {
+                self->changeLoop(loop, socket);
+            }
+        }, false);
         return ;
     }
 
+    logInfo << "webrtc context change loop to: " << loop->getEpollFd();
+
     // 切换线程，再开始发送数据
     _playReader = nullptr;
-    _loop = loop;
-    if (_isPlayer) {
-        auto src = _source.lock();
-        if (src) {
-            startPlay(src);
-        }
+    if (socket) {
+        std::atomic_store(&_socket, socket);
     }
+    std::atomic_store(&_loop, loop);
+
+    _loop->async([wSelf](){
+        auto self = wSelf.lock();
+        if (!self) {
+            return ;
+        }
+        self->addManagerTimer();
+        if (self->_isPlayer) {
+            auto src = self->_source.lock();
+            if (src) {
+                self->startPlay(src);
+            }
+        }
+    }, false);
 }
 
 void WebrtcContext::close()
@@ -1437,7 +1481,7 @@ void WebrtcContext::close()
     logInfo << "close webrtc context";
     _alive = false;
     if (_addr) {
-        auto hash = ntohl(((sockaddr_in*)_addr)->sin_addr.s_addr) << 32 + ntohs(((sockaddr_in*)_addr)->sin_port);
+        auto hash = WebrtcContextManager::sockAddrHash(_addr);
         WebrtcContextManager::instance()->delContext(hash);
     }
     WebrtcContextManager::instance()->delContext(_username);
@@ -41,8 +41,14 @@ public:
     void onStunPacket(const Socket::Ptr& socket, const WebrtcStun& stunReq, struct sockaddr* addr, int len);
     void onDtlsPacket(const Socket::Ptr& socket, const StreamBuffer::Ptr& stunReq, struct sockaddr* addr, int len);
     void onRtcpPacket(const Socket::Ptr& socket, const StreamBuffer::Ptr& stunReq, struct sockaddr* addr, int len);
-    EventLoop::Ptr getLoop() {return _loop;}
-    void changeLoop(const EventLoop::Ptr& loop);
+    // 迁移时由所属loop修改，其他loop读取，通过原子操作发布
+    EventLoop::Ptr getLoop() {return std::atomic_load(&_loop);}
+    Socket::Ptr getSocket() {return std::atomic_load(&_socket);}
+    bool isPlayer() {return _isPlayer;}
+    // 距上次调用新增的发送字节数，用于挑选重负载的会话
+    uint64_t pollSendBytes();
+    // 迁移到其他loop，socket为目标loop上同端口的udp socket
+    void changeLoop(const EventLoop::Ptr& loop, const Socket::Ptr& socket = nullptr);
     void close();
 
     string getLocalSdp();
@@ -62,6 +68,7 @@ private:
     void sendMedia(const RtpPacket::Ptr& rtp);
     void sendRtcpPli(int ssrc);
     void onManager();
+    void addManagerTimer();
     void checkAndSendRtcpNack();
     void onRecvDtlsApplicationData(const char* data, int len);
     void sendDatachannel(uint16_t streamId, uint32_t ppid, const char *msg, size_t len);
@@ -99,6 +106,7 @@ private:
     uint64_t _resendRtpPack_10s;
     uint64_t _totalRtpCnt = 0;
     uint64_t _totalRtpBytes = 0;
+    uint64_t _lastPollBytes = 0;
     uint32_t _lastRtpTs = 0;
 
     float _lossPercent;
@@ -4,13 +4,60 @@
 #include "Net/Socket.h"
 #include "WebrtcStun.h"
 #include "Webrtc.h"
+#include "WebrtcServer.h"
+#include "WebrtcForwarder.h"
+#include "EventPoller/EventLoopPool.h"
 
 using namespace std;
 
 static thread_local unordered_map<uint64_t, WebrtcContext::Wptr> _mapContextPerThread;
 
-uint64_t sockAddrHash(struct sockaddr_in* saddr) {
-	return ntohl(saddr->sin_addr.s_addr) << 32 + ntohs(saddr->sin_port);
+// 收包线程的buffer和addr都会被复用，转发前需要拷贝
+static WebrtcForwardPacket makeForwardPacket(int type, const WebrtcContext::Ptr& context, struct sockaddr* addr, int len)
+{
+    WebrtcForwardPacket pkt;
+    pkt.type = type;
+    pkt.context = context;
+    pkt.addrLen = std::min((size_t)len, sizeof(sockaddr_storage));
+    memcpy(&pkt.addr, addr, pkt.addrLen);
+
+    return pkt;
+}
+
+static inline StreamBuffer::Ptr copyBuffer(const StreamBuffer::Ptr& buffer)
+{
+    auto copy = StreamBuffer::create();
+    copy->assign(buffer->data(), buffer->size());
+
+    return copy;
+}
+
+// 会话已迁移到其他loop
+static inline bool isOtherLoop(const Socket::Ptr& socket, const WebrtcContext::Ptr& context)
+{
+    auto loop = context->getLoop();
+    return loop && socket->getLoop() != loop;
+}
+
+uint64_t WebrtcContextManager::sockAddrHash(const struct sockaddr* addr)
+{
+    if (addr->sa_family == AF_INET6) {
+        // fnv-1a，最高位置1，与ipv4的取值范围错开
+        auto addr6 = (const struct sockaddr_in6*)addr;
+        uint64_t hash = 14695981039346656037ULL;
+        auto bytes = (const uint8_t*)&addr6->sin6_addr;
+        for (int i = 0; i < 16; ++i) {
+            hash = (hash ^ bytes[i]) * 1099511628211ULL;
+        }
+        auto port = (const uint8_t*)&addr6->sin6_port;
+        hash = (hash ^ port[0]) * 1099511628211ULL;
+        hash = (hash ^ port[1]) * 1099511628211ULL;
+
+        return hash | (1ULL << 63);
+    }
+
+    auto addr4 = (const struct sockaddr_in*)addr;
+    return ((uint64_t)ntohl(addr4->sin_addr.s_addr) << 16) | ntohs(addr4->sin_port);
 }
 
 WebrtcContextManager::WebrtcContextManager()
@@ -43,6 +90,7 @@ void WebrtcContextManager::init(const EventLoop::Ptr& loop)
     });
 
     WebrtcContext::initDtlsCert();
+    WebrtcForwarder::instance()->init(EventLoopPool::instance()->getThreadSize());
 }
 
 void WebrtcContextManager::onUdpPacket(const Socket::Ptr& socket, const StreamBuffer::Ptr& buffer, struct sockaddr* addr, int len)
@@ -75,14 +123,15 @@ void WebrtcContextManager::onUdpPacket(const Socket::Ptr& socket, const StreamBu
 
 void WebrtcContextManager::onDtlsPacket(const Socket::Ptr& socket, const StreamBuffer::Ptr& buffer, struct sockaddr* addr, int len)
 {
-	uint64_t hash = sockAddrHash((struct sockaddr_in*)addr);
+	uint64_t hash = sockAddrHash(addr);
 	logInfo << "on dtls packet, size is [" << buffer->size() << "]";
     
 	auto context = getContext(hash);
 	if (context) {
-        if (socket->getLoop() != context->getLoop()) {
-            logInfo << "changeLoop ========= ";
-            // context->changeLoop(socket->getLoop());
+        if (isOtherLoop(socket, context)) {
+            auto pkt = makeForwardPacket(kForwardDtls, context, addr, len);
+            pkt.buffer = copyBuffer(buffer);
+            WebrtcForwarder::instance()->forward(context->getLoop(), std::move(pkt));
             return ;
         }
 
@@ -93,12 +142,14 @@ void WebrtcContextManager::onDtlsPacket(const Socket::Ptr& socket, const StreamB
 void WebrtcContextManager::onRtcpPacket(const Socket::Ptr& socket, const StreamBuffer::Ptr& buffer, struct sockaddr* addr, int len)
 {
 	//logInfo << "on rtcp packet. size is [" << buf->size() << "]";
-	uint64_t hash = sockAddrHash((struct sockaddr_in*)addr);
+	uint64_t hash = sockAddrHash(addr);
     
 	auto context = getContext(hash);
 	if (context) {
-        if (socket->getLoop() != context->getLoop()) {
-            logInfo << "changeLoop ========= ";
+        if (isOtherLoop(socket, context)) {
+            auto pkt = makeForwardPacket(kForwardRtcp, context, addr, len);
+            pkt.buffer = copyBuffer(buffer);
+            WebrtcForwarder::instance()->forward(context->getLoop(), std::move(pkt));
             return ;
         }
 		context->onRtcpPacket(socket, buffer, addr, len);
@@ -118,18 +169,23 @@ void WebrtcContextManager::onStunPacket(const Socket::Ptr& socket, const StreamB
 	auto context = getContext(username);
 
 	if (context) {
-        if (context->getLoop() && socket->getLoop() != context->getLoop()) {
-            logInfo << "changeLoop ========= ";
-            return ;
+		uint64_t hash = sockAddrHash(addr);
+        {
+            std::lock_guard<std::mutex> lock(_addrToContextLck);
+            auto it = _mapAddrToContext.find(hash);
+            if (it == _mapAddrToContext.end()) {
+                _mapAddrToContext[hash] = context;	
+            }
         }
-        context->onStunPacket(socket, stunReq, addr, len);
 
-		uint64_t hash = sockAddrHash((struct sockaddr_in*)addr);
-		std::lock_guard<std::mutex> lock(_addrToContextLck);
-		auto it = _mapAddrToContext.find(hash);
-		if (it == _mapAddrToContext.end()) {
-			_mapAddrToContext[hash] = context;	
+        if (isOtherLoop(socket, context)) {
+            // stun请求在目标loop重新解析
+            auto pkt = makeForwardPacket(kForwardStun, context, addr, len);
+            pkt.buffer = copyBuffer(buffer);
+            WebrtcForwarder::instance()->forward(context->getLoop(), std::move(pkt));
+            return ;
         }
+        context->onStunPacket(socket, stunReq, addr, len);
 	} else {
         logWarn << "find contex failed by username: " << username;
     }
@@ -137,11 +193,14 @@ void WebrtcContextManager::onStunPacket(const Socket::Ptr& socket, const StreamB
 
 void WebrtcContextManager::onRtpPacket(const Socket::Ptr& socket, const RtpPacket::Ptr& rtp, struct sockaddr* addr, int len)
 {
-    uint64_t hash = sockAddrHash((struct sockaddr_in*)addr);
+    uint64_t hash = sockAddrHash(addr);
     auto context = getContext(hash);
 	if (context) {
-        if (socket->getLoop() != context->getLoop()) {
-            logInfo << "changeLoop ========= ";
+        if (isOtherLoop(socket, context)) {
+            // rtp包在构造时已拷贝数据，可直接转发
+            auto pkt = makeForwardPacket(kForwardRtp, context, addr, len);
+            pkt.rtp = rtp;
+            WebrtcForwarder::instance()->forward(context->getLoop(), std::move(pkt));
             return ;
         }
 		context->onRtpPacket(socket, rtp, addr, len);
@@ -150,6 +209,8 @@ void WebrtcContextManager::onRtpPacket(const Socket::Ptr& socket, const RtpPacke
 
 void WebrtcContextManager::heartbeat()
 {
+    rebalance();
+
     for (auto iter = _mapContextPerThread.begin(); iter != _mapContextPerThread.end();) {
         auto context = iter->second.lock();
         if (!context || !context->isAlive()) {
@@ -171,6 +232,48 @@ void WebrtcContextManager::heartbeat()
     }
 }
 
+void WebrtcContextManager::rebalance()
+{
+    auto curLoop = EventLoop::getCurrentLoop();
+    auto target = EventLoopPool::instance()->getMigrateTarget(curLoop);
+    if (!target) {
+        return ;
+    }
+
+    // 每次只迁移当前loop上发送量最大的一个播放会话，避免来回迁移
+    WebrtcContext::Ptr heavyContext;
+    uint64_t maxBytes = 0;
+    for (auto& iter : _mapContextPerThread) {
+        auto context = iter.second.lock();
+        if (!context || !context->isAlive() || !context->isPlayer() || context->getLoop() != curLoop) {
+            continue;
+        }
+        auto bytes = context->pollSendBytes();
+        if (bytes > maxBytes) {
+            maxBytes = bytes;
+            heavyContext = context;
+        }
+    }
+
+    if (!heavyContext) {
+        return ;
+    }
+
+    auto socket = heavyContext->getSocket();
+    if (!socket || socket->getSocketType() != SOCKET_UDP) {
+        return ;
+    }
+
+    auto targetSocket = WebrtcServer::instance()->getUdpSocket(socket->getLocalPort(), target);
+    if (!targetSocket) {
+        return ;
+    }
+
+    logInfo << "migrate webrtc context from loop " << curLoop->getEpollFd() << " to loop " 
+            << target->getEpollFd() << ", bytes: " << maxBytes;
+    heavyContext->changeLoop(target, targetSocket);
+}
+
 void WebrtcContextManager::addContext(const string& key, const WebrtcContext::Ptr& context)
 {
     logDebug << "add context: " << key;
@@ -202,7 +305,7 @@ void WebrtcContextManager::delContext(uint64_t hash)
 {
     logDebug << "del context: " << hash;
 
-    lock_guard<mutex> loc(_contextLck);
+    lock_guard<mutex> loc(_addrToContextLck);
     _mapAddrToContext.erase(hash);
 }
 
@@ -220,7 +323,7 @@ WebrtcContext::Ptr WebrtcContextManager::getContext(uint64_t hash)
                 auto key = iter->first;
                 delContex = context;
                 _mapContextPerThread.erase(iter);
-                lock_guard<mutex> loc(_contextLck);
+                lock_guard<mutex> loc(_addrToContextLck);
                 _mapAddrToContext.erase(key);
 
                 // return nullptr;
@@ -23,10 +23,14 @@ public:
 
 public:
     static WebrtcContextManager::Ptr& instance();
+    // 兼容ipv4和ipv6的地址端口hash
+    static uint64_t sockAddrHash(const struct sockaddr* addr);
 
     void init(const EventLoop::Ptr& loop);
     void onUdpPacket(const Socket::Ptr& socket, const StreamBuffer::Ptr& buffer, struct sockaddr* addr, int len);
     void heartbeat();
+    // 当前loop负载过高时，把重负载的播放会话迁移到空闲loop
+    void rebalance();
     void addContext(const string& key, const WebrtcContext::Ptr& context);
     WebrtcContext::Ptr getContext(const string& key);
     void delContext(const string& key);
@@ -39,17 +39,17 @@ static shared_ptr<TrackInfo> createTrackBySdp(int index, const shared_ptr<Webrtc
         }
         aacTrackInfo->setAacInfo(aac_cfg);
         trackInfo = aacTrackInfo;
-        trackInfo->codec_ = "aac";
+        trackInfo->codec_ = CodecAAC;
         trackInfo->trackType_ = "audio";
     } else if (strcasecmp(piInfo->codec_.data(), "pcma") == 0) {
         auto g711aTrackInfo = make_shared<G711aTrack>();
         trackInfo = g711aTrackInfo;
-        trackInfo->codec_ = "g711a";
+        trackInfo->codec_ = CodecG711A;
         trackInfo->trackType_ = "audio";
     } else if (strcasecmp(piInfo->codec_.data(), "pcmu") == 0) {
         auto g711uTrackInfo = make_shared<G711uTrack>();
         trackInfo = g711uTrackInfo;
-        trackInfo->codec_ = "g711u";
+        trackInfo->codec_ = CodecG711U;
         trackInfo->trackType_ = "audio";
     } else if (strcasecmp(piInfo->codec_.data(), "h264") == 0) {
         logInfo << "createTrackBySdp h264";
@@ -108,7 +108,7 @@ static shared_ptr<TrackInfo> createTrackBySdp(int index, const shared_ptr<Webrtc
         // h265TrackInfo->setSps(spsFrame);
         // h265TrackInfo->setPps(ppsFrame);
         trackInfo = h265TrackInfo;
-        trackInfo->codec_ = "h265";
+        trackInfo->codec_ = CodecH265;
         trackInfo->trackType_ = "video";
     }
 
@@ -197,11 +197,11 @@ void WebrtcDecodeTrack::onFrame(const FrameBuffer::Ptr& frame)
 {
     // int samples = 1;
     // if (_type == AudioTrackType) {
-    //     if (_trackInfo->codec_ == "aac") {
+    //     if (_trackInfo->codec_ == CodecAAC) {
     //         samples = 1024;
     //         auto track = dynamic_pointer_cast<AacTrack>(_trackInfo);
     //         track->setAacInfo(string(frame->data(), 7));
-    //     } else if (_trackInfo->codec_ == "g711a") {
+    //     } else if (_trackInfo->codec_ == CodecG711A) {
     //         samples = frame->size() - frame->startSize();
     //     }
     //     // if (_onReady) {
@@ -209,7 +209,7 @@ void WebrtcDecodeTrack::onFrame(const FrameBuffer::Ptr& frame)
     //     // }
     // } else {
     //     if (!_ready) {
-    //         if (_trackInfo->codec_ == "h264") {
+    //         if (_trackInfo->codec_ == CodecH264) {
     //             auto h264Track = dynamic_pointer_cast<H264Track>(_trackInfo);
     //             auto h264Frame = dynamic_pointer_cast<H264Frame>(frame);
     //             if (!h264Track->_sps || !h264Track->_pps) {
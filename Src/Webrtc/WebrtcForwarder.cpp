@@ -0,0 +1,120 @@
+#include "WebrtcForwarder.h"
+#include "Logger.h"
+#include "WebrtcStun.h"
+
+#include <mutex>
+
+using namespace std;
+
+WebrtcForwarder::Ptr& WebrtcForwarder::instance()
+{
+    static WebrtcForwarder::Ptr instance = make_shared<WebrtcForwarder>();
+    return instance;
+}
+
+void WebrtcForwarder::init(int loopSize)
+{
+    std::call_once(_initFlag, [this, loopSize](){
+        _loopSize = loopSize;
+        for (int i = 0; i < loopSize; ++i) {
+            auto inbox = unique_ptr<Inbox>(new Inbox());
+            for (int j = 0; j < loopSize; ++j) {
+                inbox->queues.emplace_back(new QueueType(64));
+            }
+            _inboxes.emplace_back(std::move(inbox));
+        }
+    });
+}
+
+void WebrtcForwarder::forward(const EventLoop::Ptr& to, WebrtcForwardPacket&& pkt)
+{
+    auto from = EventLoop::getCurrentLoop();
+    int fromId = from ? from->getEpollID() : -1;
+    int toId = to->getEpollID();
+
+    _forwardCount.fetch_add(1, std::memory_order_relaxed);
+
+    if (fromId < 0 || fromId >= _loopSize || toId < 0 || toId >= _loopSize) {
+        // 不是EventLoopPool里的loop，退化为逐包投递
+        _fallbackCount.fetch_add(1, std::memory_order_relaxed);
+        auto packet = make_shared<WebrtcForwardPacket>(std::move(pkt));
+        to->async([packet](){
+            WebrtcForwarder::dispatch(*packet);
+        }, false);
+        return ;
+    }
+
+    auto& inbox = _inboxes[toId];
+    inbox->queues[fromId]->enqueue(std::move(pkt));
+
+    // 目标loop已有待执行的drain，不需要再唤醒
+    if (inbox->scheduled.exchange(true, std::memory_order_acq_rel)) {
+        return ;
+    }
+
+    _batchCount.fetch_add(1, std::memory_order_relaxed);
+    weak_ptr<WebrtcForwarder> wSelf = shared_from_this();
+    to->async([wSelf, toId](){
+        auto self = wSelf.lock();
+        if (self) {
+            self->drain(toId);
+        }
+    }, false);
+}
+
+void WebrtcForwarder::drain(int toId)
+{
+    auto& inbox = _inboxes[toId];
+    // 先清标记再取数据，保证清标记之后入队的报文要么被本次取到，要么会触发新的drain
+    inbox->scheduled.store(false, std::memory_order_release);
+
+    WebrtcForwardPacket pkt;
+    for (auto& queue : inbox->queues) {
+        while (queue->try_dequeue(pkt)) {
+            dispatch(pkt);
+        }
+    }
+}
+
+void WebrtcForwarder::dispatch(WebrtcForwardPacket& pkt)
+{
+    auto context = pkt.context.lock();
+    if (!context) {
+        return ;
+    }
+
+    // 转发过程中context又迁移了，继续转发
+    auto loop = context->getLoop();
+    if (loop && !loop->isCurrent()) {
+        WebrtcForwarder::instance()->forward(loop, std::move(pkt));
+        return ;
+    }
+
+    auto socket = context->getSocket();
+    auto addr = (struct sockaddr*)&pkt.addr;
+    switch (pkt.type) {
+        case kForwardStun: {
+            WebrtcStun stunReq;
+            if (0 != stunReq.parse(pkt.buffer->data(), pkt.buffer->size())) {
+                logError << "parse stun packet failed";
+                break;
+            }
+            context->onStunPacket(socket, stunReq, addr, pkt.addrLen);
+            break;
+        }
+        case kForwardDtls: {
+            context->onDtlsPacket(socket, pkt.buffer, addr, pkt.addrLen);
+            break;
+        }
+        case kForwardRtp: {
+            context->onRtpPacket(socket, pkt.rtp, addr, pkt.addrLen);
+            break;
+        }
+        case kForwardRtcp: {
+            context->onRtcpPacket(socket, pkt.buffer, addr, pkt.addrLen);
+            break;
+        }
+        default:
+            break;
+    }
+}
@@ -0,0 +1,80 @@
+#ifndef WebrtcForwarder_h
+#define WebrtcForwarder_h
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <memory>
+#include <sys/socket.h>
+
+#include "WebrtcContext.h"
+#include "EventPoller/EventLoop.h"
+#include "ReadWriteQueue/readerwriterqueue.h"
+
+using namespace std;
+
+enum WebrtcForwardType {
+    kForwardStun = 1,
+    kForwardDtls,
+    kForwardRtp,
+    kForwardRtcp
+};
+
+class WebrtcForwardPacket
+{
+public:
+    int type = 0;
+    int addrLen = 0;
+    sockaddr_storage addr;
+    WebrtcContext::Wptr context;
+    // stun/dtls/rtcp的原始数据拷贝，收包线程的buffer会被复用
+    StreamBuffer::Ptr buffer;
+    RtpPacket::Ptr rtp;
+};
+
+// 收包的loop和context所在loop不同时，把报文转交给context所在loop
+// 每对(收包loop, 目标loop)一个单生产者单消费者无锁队列，
+// 目标loop空闲时才投递一次async，由目标loop一次取完所有积压的报文
+class WebrtcForwarder : public enable_shared_from_this<WebrtcForwarder> {
+public:
+    using Ptr = shared_ptr<WebrtcForwarder>;
+    using QueueType = moodycamel::ReaderWriterQueue<WebrtcForwardPacket>;
+
+    WebrtcForwarder() = default;
+    ~WebrtcForwarder() = default;
+
+public:
+    static WebrtcForwarder::Ptr& instance();
+
+    // loopSize为EventLoopPool的线程数，可重复调用
+    void init(int loopSize);
+    // 在收包loop上调用
+    void forward(const EventLoop::Ptr& to, WebrtcForwardPacket&& pkt);
+
+    uint64_t getForwardCount() {return _forwardCount.load(std::memory_order_relaxed);}
+    uint64_t getBatchCount() {return _batchCount.load(std::memory_order_relaxed);}
+    uint64_t getFallbackCount() {return _fallbackCount.load(std::memory_order_relaxed);}
+
+    static void dispatch(WebrtcForwardPacket& pkt);
+
+private:
+    void drain(int toId);
+
+private:
+    class Inbox
+    {
+    public:
+        std::atomic<bool> scheduled{false};
+        // 下标为收包loop的id
+        vector<unique_ptr<QueueType>> queues;
+    };
+
+    int _loopSize = 0;
+    std::once_flag _initFlag;
+    vector<unique_ptr<Inbox>> _inboxes;
+    std::atomic<uint64_t> _forwardCount{0};
+    std::atomic<uint64_t> _batchCount{0};
+    std::atomic<uint64_t> _fallbackCount{0};
+};
+
+#endif //WebrtcForwarder_h
@@ -180,7 +180,7 @@ void WebrtcMediaSource::addTrack(const shared_ptr<TrackInfo>& track)
             rtcTrack->startEncode();
     }
 
-    if (track->codec_ == "g711a" || track->codec_ == "g711u") {
+    if (track->codec_ == CodecG711A || track->codec_ == CodecG711U) {
         _channels = track->channel_;
     }
 }
@@ -265,12 +265,12 @@ void WebrtcMediaSource::onFrame(const FrameBuffer::Ptr& frame)
         return ;
     }
     // logInfo << "on muxer a frame, pts: " << frame->pts() << ", nal type: " << (int)frame->getNalType();
-    // if (frame->codec() == "h264") {
+    // if (frame->codec() == CodecH264) {
     //     FILE* fp = fopen("test2.264", "ab+");
     //     fwrite(frame->_buffer.data(), 1, frame->_buffer.size(), fp);
     //     fclose(fp);
     // }
-    if (frame->_codec == "g711a" || frame->_codec == "g711u") {
+    if (frame->_codec == CodecG711A || frame->_codec == CodecG711U) {
         processG711(frame, it->second);
     } else {
         it->second->onFrame(frame);
@@ -37,6 +37,7 @@ public:
     int playerCount() override;
     void getClientList(const function<void(const list<ClientInfo>& info)>& func) override;
     uint64_t getBytes() override { return _ring ? _ring->getBytes() : 0;}
+    vector<DataQueKeyframeInfo> getKeyframeIndex() override { return _ring ? _ring->getKeyframeIndex() : vector<DataQueKeyframeInfo>();}
 
     QueType::Ptr getRing() {return _ring;}
     void processG711(const FrameBuffer::Ptr& frame, const WebrtcEncodeTrack::Ptr& track);
@@ -91,4 +91,21 @@ void WebrtcServer::for_each_socket(const function<void(const Socket::Ptr &)> &cb
             cb(socket);
         }
     }
-}
\ No newline at end of file
+}
+
+Socket::Ptr WebrtcServer::getUdpSocket(int port, const EventLoop::Ptr& loop)
+{
+    lock_guard<mutex> lck(_mtx);
+    auto iter = _udpSockets.find(port);
+    if (iter == _udpSockets.end()) {
+        return nullptr;
+    }
+
+    for (auto& socket : iter->second) {
+        if (socket->getLoop() == loop) {
+            return socket;
+        }
+    }
+
+    return nullptr;
+}
@@ -34,6 +34,8 @@ public:
     
     void for_each_server(const function<void(const TcpServer::Ptr &)> &cb);
     void for_each_socket(const function<void(const Socket::Ptr &)> &cb);
+    // 获取同一端口上属于指定loop的udp socket，用于会话迁移
+    Socket::Ptr getUdpSocket(int port, const EventLoop::Ptr& loop);
 
 private:
     mutex _mtx;
@@ -0,0 +1,249 @@
+// adpcma/g726转g711测试
+// 1. 查表实现和原来的逐采样实现逐个采样比较: g711a/g711u编码覆盖全部65536个pcm值，adpcm解码覆盖全部index
+// 2. AudioNormalizer的输出和原来jt1078的转换流程(解析帧头 + adpcm_decoder/g726_decode + linear2alaw/linear2ulaw)逐字节一致，
+//    g726跨帧保持解码器状态，各码率都和连续解码的结果一致
+// 3. 吞吐量，单位: 帧/核秒
+// 编译: 先编译整个工程，再链接lib/、Base/lib下的静态库
+// 运行: ./audioNormalize [帧数]
+
+#include <iostream>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <unistd.h>
+
+#include "PcmTranscode/AdpcmaTranscode.h"
+#include "PcmTranscode/G711Transcode.h"
+#include "PcmTranscode/G726Transcode.h"
+#include "PcmTranscode/AudioNormalizer.h"
+#include "Log/Logger.h"
+
+using namespace std;
+
+// G711Transcode.cpp里的逐采样实现
+extern unsigned char linear2alaw(short pcm_val);
+extern unsigned char linear2ulaw(short pcm_val);
+
+// 每帧40ms，8k采样
+static const int kSamples = 320;
+
+static bool g_ok = true;
+
+static void check(bool cond, const string& name)
+{
+    cout << (cond ? "ok     " : "FAILED ") << name << endl;
+    g_ok = g_ok && cond;
+}
+
+static void testG711()
+{
+    vector<short> pcm(65536);
+    for (int i = 0; i < 65536; ++i) {
+        pcm[i] = (short)(i - 32768);
+    }
+    vector<unsigned char> out(pcm.size());
+
+    G711Transcode::pcm_2_alaw(pcm.data(), out.data(), pcm.size());
+    bool same = true;
+    for (size_t i = 0; i < pcm.size(); ++i) {
+        same = same && out[i] == linear2alaw(pcm[i]);
+    }
+    check(same, "g711a table matches linear2alaw for every pcm value");
+
+    G711Transcode::pcm_2_ulaw(pcm.data(), out.data(), pcm.size());
+    same = true;
+    for (size_t i = 0; i < pcm.size(); ++i) {
+        same = same && out[i] == linear2ulaw(pcm[i]);
+    }
+    check(same, "g711u table matches linear2ulaw for every pcm value");
+}
+
+static void testAdpcmTable()
+{
+    vector<char> adpcm(kSamples / 2);
+    vector<short> expect(kSamples);
+    vector<short> pcm(kSamples);
+    bool same = true;
+    for (int round = 0; round < 20; ++round) {
+        for (auto& ch : adpcm) {
+            ch = rand();
+        }
+        for (int index = 0; index <= 88; ++index) {
+            short valprev = rand();
+            adpcm_state legacy = {valprev, (char)index};
+            adpcm_state table = legacy;
+            adpcm_decoder(adpcm.data(), expect.data(), kSamples, &legacy);
+            adpcm_decoder_table(adpcm.data(), pcm.data(), kSamples, &table);
+            same = same && pcm == expect && legacy.valprev == table.valprev && legacy.index == table.index;
+        }
+    }
+    check(same, "adpcm table decoder matches adpcm_decoder for every start index");
+}
+
+static FrameBuffer::Ptr makeFrame(const vector<unsigned char>& data)
+{
+    auto frame = make_shared<FrameBuffer>();
+    frame->_buffer.assign((char*)data.data(), data.size());
+    frame->_trackType = AudioTrackType;
+
+    return frame;
+}
+
+static void encodeG711(const string& codec, const short* pcm, int samples, vector<unsigned char>& out)
+{
+    out.resize(samples);
+    for (int i = 0; i < samples; ++i) {
+        out[i] = codec == "g711u" ? linear2ulaw(pcm[i]) : linear2alaw(pcm[i]);
+    }
+}
+
+// 原来jt1078的adpcma转换: 每帧从帧头取解码器状态
+static void legacyAdpcm(const vector<unsigned char>& data, const string& codec, vector<unsigned char>& out)
+{
+    auto start = data.data();
+    auto payload = data.data();
+    size_t size = data.size();
+    adpcm_state state;
+    if (start[0] == 0x00 && start[1] == 0x01 && start[2] == (size - 4) / 2 && start[3] == 0x00) {
+        payload += 8;
+        size -= 8;
+        state.valprev = (short)(((start[5] << 8) & 0xff00) | start[4]);
+        state.index = start[6];
+    } else {
+        payload += 4;
+        size -= 4;
+        state.valprev = (short)(((start[1] << 8) & 0xff00) | start[0]);
+        state.index = start[2];
+    }
+    vector<short> pcm(size * 2);
+    adpcm_decoder((char*)payload, pcm.data(), size * 2, &state);
+    encodeG711(codec, pcm.data(), pcm.size(), out);
+}
+
+static void testAdpcmNormalizer(const string& codec, bool hisiHeader)
+{
+    AudioNormalizer normalizer("adpcma", codec);
+    bool same = true;
+    int frames = 0;
+    vector<unsigned char> expect;
+    for (int i = 0; i < 500; ++i) {
+        vector<unsigned char> data;
+        short valprev = rand();
+        int index = rand() % 89;
+        if (hisiHeader) {
+            data = {0x00, 0x01, (unsigned char)(kSamples / 4 + 2), 0x00, (unsigned char)(valprev & 0xff),
+                    (unsigned char)(valprev >> 8), (unsigned char)index, 0x00};
+        } else {
+            data = {(unsigned char)(valprev & 0xff), (unsigned char)(valprev >> 8), (unsigned char)index, 0x00};
+        }
+        for (int j = 0; j < kSamples / 2; ++j) {
+            data.push_back(rand());
+        }
+
+        auto frame = normalizer.normalize(makeFrame(data));
+        legacyAdpcm(data, codec, expect);
+        same = same && frame && frame->size() == expect.size() && memcmp(frame->data(), expect.data(), expect.size()) == 0;
+        frames += !!frame;
+    }
+    check(same && frames == 500, "adpcma -> " + codec + (hisiHeader ? " with hisi header" : "") + " matches the legacy path");
+}
+
+// g726各码率，解码器状态跨帧保持，和连续调用g726_decode的结果一致
+static void testG726Normalizer(int bitRate)
+{
+    AudioNormalizer normalizer("g726", "g711a");
+    normalizer.setG726BitRate(bitRate);
+    g726_state_t state;
+    g726_init(&state, bitRate);
+
+    bool same = true;
+    int bytes = kSamples * (bitRate / 8000) / 8;
+    vector<short> pcm(kSamples);
+    vector<unsigned char> expect;
+    for (int i = 0; i < 500; ++i) {
+        vector<unsigned char> data(bytes);
+        for (auto& ch : data) {
+            ch = rand();
+        }
+        auto frame = normalizer.normalize(makeFrame(data));
+        int samples = g726_decode(&state, pcm.data(), data.data(), data.size());
+        encodeG711("g711a", pcm.data(), samples, expect);
+        same = same && samples == kSamples && frame && frame->size() == expect.size()
+            && memcmp(frame->data(), expect.data(), expect.size()) == 0;
+    }
+    check(same, "g726 " + to_string(bitRate / 1000) + "k -> g711a matches continuous g726_decode");
+}
+
+static double cpuSeconds()
+{
+    return (double)clock() / CLOCKS_PER_SEC;
+}
+
+static void report(const string& name, int frames, double seconds)
+{
+    cout << name << ": " << frames << " frames, " << seconds * 1000 << " ms cpu, "
+         << (uint64_t)(frames / seconds) << " frames/core-second, "
+         << seconds * 1000000 / frames << " us/frame" << endl;
+}
+
+int main(int argc, char** argv)
+{
+    Logger::instance()->addChannel(std::make_shared<ConsoleChannel>("ConsoleChannel", LError));
+    Logger::instance()->setLevel(LError);
+    int frames = argc > 1 ? atoi(argv[1]) : 100000;
+
+    testG711();
+    testAdpcmTable();
+    testAdpcmNormalizer("g711a", false);
+    testAdpcmNormalizer("g711u", false);
+    testAdpcmNormalizer("g711a", true);
+    for (int bitRate : {16000, 24000, 32000, 40000}) {
+        testG726Normalizer(bitRate);
+    }
+
+    vector<char> adpcm(kSamples / 2);
+    for (auto& ch : adpcm) {
+        ch = rand();
+    }
+    vector<short> pcm(kSamples * 2);
+    vector<unsigned char> g711(kSamples * 2);
+
+    // 旧实现: 逐位解码 + 逐采样分段查找
+    double start = cpuSeconds();
+    for (int i = 0; i < frames; ++i) {
+        adpcm_state state = {0, 0};
+        adpcm_decoder(adpcm.data(), pcm.data(), kSamples, &state);
+        for (int j = 0; j < kSamples; ++j) {
+            g711[j] = linear2alaw(pcm[j]);
+        }
+    }
+    report("adpcma -> g711a (legacy)", frames, cpuSeconds() - start);
+
+    start = cpuSeconds();
+    for (int i = 0; i < frames; ++i) {
+        adpcm_state state = {0, 0};
+        adpcm_decoder_table(adpcm.data(), pcm.data(), kSamples, &state);
+        G711Transcode::pcm_2_alaw(pcm.data(), g711.data(), kSamples);
+    }
+    report("adpcma -> g711a (table)", frames, cpuSeconds() - start);
+
+    // g726 16k: 每帧80字节
+    vector<unsigned char> g726(kSamples / 4);
+    for (auto& ch : g726) {
+        ch = rand();
+    }
+    g726_state_t state726;
+    g726_init(&state726, 16000);
+    start = cpuSeconds();
+    for (int i = 0; i < frames; ++i) {
+        int samples = g726_decode(&state726, pcm.data(), g726.data(), g726.size());
+        G711Transcode::pcm_2_alaw(pcm.data(), g711.data(), samples);
+    }
+    report("g726 -> g711a (table)", frames, cpuSeconds() - start);
+
+    cout << (g_ok ? "ok" : "FAILED") << endl;
+    _exit(g_ok ? 0 : 1);
+}
@@ -0,0 +1,334 @@
+// StreamBuffer分配测试，对比BufferPool和系统分配器
+// 1. churn: 单线程按包大小分布分配，保留最近1024个，模拟rtp/ts/rtmp包的生命周期
+// 2. cross: 一个线程分配，另一个线程释放，模拟loop之间转发
+// 3. threads: 4个线程同时churn，一半的包交给下一个线程释放
+// 4. exit: 短命线程退出时，比线程缓存更晚析构的thread_local还在释放buffer(类似Socket的接收buffer)，
+//    同时其他线程在复用回收的缓存对象
+// 5. string: 上层先拼好std::string再交给StringBuffer，对比直接move和拷贝进池子里的块，
+//    用来评估StringBuffer走池子是否划算
+// 每种模式在单独的子进程里跑，统计吞吐和结束时的RSS
+// glibc只能从堆顶归还内存，池里留着的块会卡住下面已释放的内存，所以另外给出malloc_trim之后的RSS
+// 对比jemalloc: LD_PRELOAD=libjemalloc.so ./bufferPool，malloc模式即为jemalloc
+// 编译: 先编译整个工程，再链接Base/lib下的libbase.a
+// 运行: ./bufferPool [每个线程的分配次数(万)]
+
+#include <iostream>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <vector>
+#include <deque>
+#include <atomic>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <dlfcn.h>
+#include <malloc.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "Net/Buffer.h"
+#include "Net/BufferPool.h"
+
+using namespace std;
+
+static const size_t kWindow = 1024;
+static const int kThreads = 4;
+
+// 大致的包大小分布: rtp/ts包居多，少量信令和大帧
+static size_t packetSize(uint32_t& seed)
+{
+    seed = seed * 1103515245 + 12345;
+    int r = (seed >> 16) % 100;
+    if (r < 45) {
+        return 1200 + (seed >> 8) % 200;
+    } else if (r < 65) {
+        return 188 * 7;
+    } else if (r < 80) {
+        return 32 + (seed >> 8) % 200;
+    } else if (r < 92) {
+        return 4096;
+    } else if (r < 98) {
+        return 8192 + (seed >> 8) % 40000;
+    }
+    return 100000;
+}
+
+static StreamBuffer* newBuffer(uint32_t& seed)
+{
+    auto buffer = new StreamBuffer(packetSize(seed));
+    // 写一下首尾，保证内存真的被用到
+    auto data = buffer->data();
+    data[0] = 1;
+    data[buffer->size() - 1] = 1;
+
+    return buffer;
+}
+
+static long rssKb()
+{
+    long pages = 0, rss = 0;
+    FILE* fp = fopen("/proc/self/statm", "r");
+    if (fp) {
+        if (fscanf(fp, "%ld %ld", &pages, &rss) != 2) {
+            rss = 0;
+        }
+        fclose(fp);
+    }
+
+    return rss * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+static void churn(uint64_t count, uint32_t seed)
+{
+    deque<StreamBuffer*> window;
+    for (uint64_t i = 0; i < count; ++i) {
+        window.push_back(newBuffer(seed));
+        if (window.size() > kWindow) {
+            delete window.front();
+            window.pop_front();
+        }
+    }
+    for (auto buffer : window) {
+        delete buffer;
+    }
+}
+
+// 批量交接，队列本身的开销尽量小
+class Handoff
+{
+public:
+    void push(vector<StreamBuffer*>& batch)
+    {
+        lock_guard<mutex> lock(_mtx);
+        _items.insert(_items.end(), batch.begin(), batch.end());
+        batch.clear();
+    }
+
+    void pop(vector<StreamBuffer*>& out)
+    {
+        lock_guard<mutex> lock(_mtx);
+        out.swap(_items);
+    }
+
+private:
+    mutex _mtx;
+    vector<StreamBuffer*> _items;
+};
+
+static void cross(uint64_t count)
+{
+    Handoff handoff;
+    atomic<bool> done{false};
+    thread consumer([&](){
+        vector<StreamBuffer*> items;
+        while (true) {
+            bool last = done.load();
+            handoff.pop(items);
+            for (auto buffer : items) {
+                delete buffer;
+            }
+            items.clear();
+            if (last) {
+                break;
+            }
+            this_thread::yield();
+        }
+    });
+
+    uint32_t seed = 1;
+    vector<StreamBuffer*> batch;
+    for (uint64_t i = 0; i < count; ++i) {
+        batch.push_back(newBuffer(seed));
+        if (batch.size() == 64) {
+            handoff.push(batch);
+        }
+    }
+    handoff.push(batch);
+    done = true;
+    consumer.join();
+}
+
+static void threads(uint64_t count)
+{
+    vector<Handoff> handoffs(kThreads);
+    vector<thread> workers;
+    for (int t = 0; t < kThreads; ++t) {
+        workers.emplace_back([&handoffs, count, t](){
+            uint32_t seed = t + 1;
+            deque<StreamBuffer*> window;
+            vector<StreamBuffer*> batch, incoming;
+            for (uint64_t i = 0; i < count; ++i) {
+                auto buffer = newBuffer(seed);
+                if (i & 1) {
+                    batch.push_back(buffer);
+                    if (batch.size() == 64) {
+                        handoffs[(t + 1) % kThreads].push(batch);
+                    }
+                } else {
+                    window.push_back(buffer);
+                    if (window.size() > kWindow) {
+                        delete window.front();
+                        window.pop_front();
+                    }
+                }
+                if ((i & 255) == 0) {
+                    handoffs[t].pop(incoming);
+                    for (auto item : incoming) {
+                        delete item;
+                    }
+                    incoming.clear();
+                }
+            }
+            handoffs[(t + 1) % kThreads].push(batch);
+            for (auto item : window) {
+                delete item;
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    for (auto& handoff : handoffs) {
+        vector<StreamBuffer*> rest;
+        handoff.pop(rest);
+        for (auto item : rest) {
+            delete item;
+        }
+    }
+}
+
+// 模拟上层拼好的帧/信令字符串，池子打开时拷贝进池子的块，关闭时move进StringBuffer
+static void strings(uint64_t count, bool pool)
+{
+    uint32_t seed = 1;
+    deque<Buffer*> window;
+    for (uint64_t i = 0; i < count; ++i) {
+        string str(packetSize(seed), 'x');
+        Buffer* buffer;
+        if (pool) {
+            buffer = new StreamBuffer(str.data(), str.size());
+        } else {
+            buffer = new StringBuffer(std::move(str));
+        }
+        buffer->data()[0] = 1;
+        window.push_back(buffer);
+        if (window.size() > kWindow) {
+            delete window.front();
+            window.pop_front();
+        }
+    }
+    for (auto buffer : window) {
+        delete buffer;
+    }
+}
+
+// 先于线程缓存构造，所以在缓存回收之后才析构
+struct LateFree
+{
+    vector<StreamBuffer*> buffers;
+
+    ~LateFree()
+    {
+        for (auto buffer : buffers) {
+            delete buffer;
+        }
+    }
+};
+
+static thread_local LateFree t_lateFree;
+
+static void exitThreads(uint64_t count)
+{
+    uint64_t rounds = max<uint64_t>(count / 10000, 10);
+    for (uint64_t round = 0; round < rounds; ++round) {
+        vector<thread> workers;
+        for (int t = 0; t < kThreads; ++t) {
+            workers.emplace_back([t, round](){
+                auto& late = t_lateFree;
+                uint32_t seed = t + round + 1;
+                churn(kWindow, seed);
+                for (int i = 0; i < 64; ++i) {
+                    late.buffers.push_back(newBuffer(seed));
+                }
+            });
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+}
+
+// 返回每秒百万次分配
+static double run(const string& name, uint64_t count, bool pool)
+{
+    auto start = chrono::steady_clock::now();
+    uint64_t total = count;
+    if (name == "churn") {
+        churn(count, 1);
+    } else if (name == "cross") {
+        cross(count);
+    } else if (name == "string") {
+        strings(count, pool);
+    } else if (name == "exit") {
+        exitThreads(count);
+        total = max<uint64_t>(count / 10000, 10) * kThreads * (kWindow + 64);
+    } else {
+        threads(count);
+        total = count * kThreads;
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    return total / seconds / 1e6;
+}
+
+int main(int argc, char** argv)
+{
+    uint64_t count = (argc > 1 ? atoi(argv[1]) : 200) * 10000ULL;
+    string allocator = dlsym(RTLD_DEFAULT, "mallctl") ? "jemalloc" : "system malloc";
+
+    bool ok = true;
+    for (string name : {"churn", "cross", "threads", "exit", "string"}) {
+        for (bool pool : {false, true}) {
+            int fds[2];
+            if (pipe(fds) != 0) {
+                return 1;
+            }
+            pid_t pid = fork();
+            if (pid == 0) {
+                close(fds[0]);
+                BufferPool::setEnable(pool);
+                double mops = run(name, count, pool);
+                auto stat = BufferPool::getStatistic();
+                long rss = rssKb();
+                malloc_trim(0);
+                char line[256];
+                int len = snprintf(line, sizeof(line), "%.2f Mallocs/s, rss %ld KB (trimmed %ld KB), pool hit %.1f%%, cached %llu KB, live %lld, peak %lld KB",
+                                   mops, rss, rssKb(), stat.allocs ? 100.0 * stat.hits / stat.allocs : 0,
+                                   (unsigned long long)stat.cachedBytes / 1024, (long long)stat.liveBytes, (long long)stat.peakBytes / 1024);
+                if (write(fds[1], line, len) != len) {
+                    _exit(1);
+                }
+                // 全部释放后在用字节应为0
+                _exit(stat.liveBytes == 0 ? 0 : 1);
+            }
+            close(fds[1]);
+            char line[256] = {0};
+            if (read(fds[0], line, sizeof(line) - 1) < 0) {
+                line[0] = 0;
+            }
+            close(fds[0]);
+            int status = 0;
+            waitpid(pid, &status, 0);
+            ok = ok && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+            string label = pool ? "BufferPool" : allocator;
+            if (name == "string") {
+                label = pool ? "BufferPool copy" : "StringBuffer move";
+            }
+            cout << name << " " << label << ": " << line << endl;
+        }
+    }
+
+    cout << (ok ? "ok" : "FAILED") << endl;
+    _exit(ok ? 0 : 1);
+}
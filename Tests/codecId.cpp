@@ -0,0 +1,151 @@
+// 对比帧上用string和CodecId保存编码类型的开销
+// 先检查名字映射: 内置名字一一对应，其他名字分配动态id并保留原名，动态id用完后为unknown，字符串比较不增加id
+// 再模拟1000路转发: 每帧创建时赋值编码，再经过几次按编码分发(ts/rtp/webrtc)
+// 编译: g++ -std=c++11 -O2 -I. -ISrc Tests/codecId.cpp Src/Common/CodecId.cpp -o codecId -lpthread
+// 运行: ./codecId [路数] [每路帧数]
+
+#include <iostream>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <unistd.h>
+
+#include "Common/CodecId.h"
+
+using namespace std;
+
+static bool g_ok = true;
+
+static void check(bool cond, const string& name)
+{
+    cout << (cond ? "ok     " : "FAILED ") << name << endl;
+    g_ok = g_ok && cond;
+}
+
+static void testLookup()
+{
+    check(CodecId("h264") == CodecH264 && CodecId(string("ulpfec")) == CodecUlpfec, "builtin names map to their type");
+    check(CodecId("h264").name() == "h264" && CodecId(CodecOpus).name() == "opus", "name of builtin codec");
+    check(CodecId("").empty() && CodecId().name().empty(), "empty name is invalid");
+    check(CodecId("h26") != CodecH264 && CodecId("h2644") != CodecH264, "prefix and longer names are not builtin");
+
+    CodecId mjpeg("mjpeg");
+    check(mjpeg.name() == "mjpeg" && mjpeg != CodecUnknown && mjpeg.id() >= CodecBuiltinEnd, "other names keep their name");
+    check(CodecId(string("mjpeg")) == mjpeg && CodecId("mjpeg").id() == mjpeg.id(), "same name gets the same id");
+    check(CodecId("pcm") != mjpeg, "different names get different ids");
+
+    CodecId h265("h265");
+    check(h265 == "h265" && h265 != "h264" && "h265" == h265 && h265 != string("foo"), "string comparisons");
+    check(mjpeg == "mjpeg" && mjpeg != "pcm" && mjpeg != "never-seen", "string comparisons with dynamic names");
+    check(CodecId("foo") != "bar", "different dynamic names compare unequal");
+    check(CodecId((CodecType)60000) == CodecUnknown, "out of range type is unknown");
+
+    // 动态id用完后都落在unknown上，已分配的名字不受影响
+    for (int i = 0; i < CodecId::kMaxDynamicNum * 2; ++i) {
+        CodecId codec("codec" + to_string(i));
+    }
+    CodecId overflow("codec" + to_string(CodecId::kMaxDynamicNum * 2 - 1));
+    check(overflow == CodecUnknown && overflow.name() == "unknown", "names beyond the dynamic ids are unknown");
+    check(CodecId("mjpeg") == mjpeg && mjpeg.name() == "mjpeg", "earlier dynamic names still resolve");
+}
+
+static uint64_t nowUs()
+{
+    return chrono::duration_cast<chrono::microseconds>(
+        chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+class StringFrame
+{
+public:
+    string _codec;
+};
+
+class IdFrame
+{
+public:
+    CodecId _codec;
+};
+
+static int dispatchString(const StringFrame& frame)
+{
+    if (frame._codec == "h264") {
+        return 1;
+    } else if (frame._codec == "h265") {
+        return 2;
+    } else if (frame._codec == "aac") {
+        return 3;
+    } else if (frame._codec == "g711a" || frame._codec == "g711u") {
+        return 4;
+    } else if (frame._codec == "opus") {
+        return 5;
+    }
+    return 0;
+}
+
+static int dispatchId(const IdFrame& frame)
+{
+    switch (frame._codec.type()) {
+        case CodecH264: return 1;
+        case CodecH265: return 2;
+        case CodecAAC: return 3;
+        case CodecG711A:
+        case CodecG711U: return 4;
+        case CodecOpus: return 5;
+        default: return 0;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    int streams = argc > 1 ? atoi(argv[1]) : 1000;
+    int frames = argc > 2 ? atoi(argv[2]) : 2000;
+
+    testLookup();
+
+    // 每路一个源track，音视频交替
+    vector<string> trackNames;
+    vector<CodecId> trackIds;
+    const char* names[] = {"h264", "aac", "h265", "g711a", "opus", "g711u"};
+    for (int i = 0; i < streams; ++i) {
+        trackNames.push_back(names[i % 6]);
+        trackIds.push_back(names[i % 6]);
+    }
+
+    // 每帧: 解包时赋值，转发到3个协议各分发一次，再拷贝给一个子帧
+    uint64_t sum = 0;
+    auto start = nowUs();
+    for (int f = 0; f < frames; ++f) {
+        for (int s = 0; s < streams; ++s) {
+            StringFrame frame;
+            frame._codec = trackNames[s];
+            sum += dispatchString(frame) + dispatchString(frame) + dispatchString(frame);
+            StringFrame sub;
+            sub._codec = frame._codec;
+            sum += sub._codec.size();
+        }
+    }
+    auto stringUs = nowUs() - start;
+
+    start = nowUs();
+    for (int f = 0; f < frames; ++f) {
+        for (int s = 0; s < streams; ++s) {
+            IdFrame frame;
+            frame._codec = trackIds[s];
+            sum += dispatchId(frame) + dispatchId(frame) + dispatchId(frame);
+            IdFrame sub;
+            sub._codec = frame._codec;
+            sum += sub._codec.id();
+        }
+    }
+    auto idUs = nowUs() - start;
+
+    uint64_t total = (uint64_t)streams * frames;
+    cout << "streams: " << streams << ", frames per stream: " << frames << ", check: " << sum << endl;
+    cout << "string codec: " << stringUs << " us, " << stringUs * 1000.0 / total << " ns/frame" << endl;
+    cout << "codec id:     " << idUs << " us, " << idUs * 1000.0 / total << " ns/frame" << endl;
+
+    cout << (g_ok ? "ok" : "FAILED") << endl;
+    _exit(g_ok ? 0 : 1);
+}
@@ -0,0 +1,259 @@
+// 模拟大量观众同时加入时GOP缓存回放的开销
+// 1. 回放: gop中间取的快照从gop的关键帧开始，按序号逐个回放，不重复不遗漏
+// 2. 淘汰: 快照存活期间淘汰旧gop、缓存溢出或清空缓存，快照里的数据不变，快照释放后数据随之释放
+// 3. 加入风暴: 写入过程中多个loop不断加入reader，每个reader从关键帧开始连续收到后面所有数据
+// 4. 性能: 对比旧实现(每次加入拷贝整份list<list<pair<bool, T>>>)和共享快照
+// 编译: 先编译整个工程，再链接lib/、Base/lib下的静态库
+// 运行: ./dataQueJoinStorm [加入次数] [gop帧数]
+
+#include <iostream>
+#include <chrono>
+#include <list>
+#include <memory>
+#include <string>
+#include <vector>
+#include <thread>
+#include <future>
+#include <cstdlib>
+#include <unistd.h>
+
+#include "Common/DataQue.h"
+#include "EventPoller/EventLoopPool.h"
+#include "Log/Logger.h"
+
+using namespace std;
+
+using FrameType = shared_ptr<string>;
+using LegacyGop = list<list<pair<bool, FrameType>>>;
+
+static bool g_ok = true;
+
+static void check(bool cond, const string& name)
+{
+    cout << (cond ? "ok     " : "FAILED ") << name << endl;
+    g_ok = g_ok && cond;
+}
+
+static uint64_t nowUs()
+{
+    return chrono::duration_cast<chrono::microseconds>(
+        chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// 数据内容就是写入时的序号
+static FrameType makeFrame(int seq)
+{
+    return make_shared<string>(to_string(seq));
+}
+
+// 快照内容是否正好是[begin, end)，序号和数据都连续，关键帧在gop的整数倍位置
+static bool replayExact(const DataQueSnapshot<FrameType>& snapshot, int begin, int end, int gopFrames)
+{
+    int expect = begin;
+    bool ok = true;
+    snapshot.forEach([&](uint64_t seq, bool isKey, const FrameType& data){
+        ok = ok && (int)seq == expect && stoi(*data) == expect && isKey == (expect % gopFrames == 0);
+        ++expect;
+    });
+
+    return ok && expect == end;
+}
+
+static void testReplay()
+{
+    const int gopFrames = 30;
+    DataQueStorage<FrameType> storage(1000, 2);
+    // 第二个gop写到一半，跨过存储块的边界
+    for (int i = 0; i < 45; ++i) {
+        storage.write(makeFrame(i), i % gopFrames == 0);
+    }
+
+    auto snapshot = storage.snapshot();
+    check(snapshot.beginSeq() == 0 && snapshot.endSeq() == 45, "mid gop snapshot covers the cached gops");
+    check(replayExact(snapshot, 0, 45, gopFrames), "mid gop snapshot replays every frame once in order");
+
+    DataQueStartPolicy policy;
+    policy.mode = START_FROM_LATEST_KEY;
+    snapshot = storage.snapshot(policy);
+    check(replayExact(snapshot, 30, 45, gopFrames), "latest snapshot replays from the current gop keyframe");
+
+    // 快照之后的写入不会出现在快照里
+    for (int i = 45; i < 80; ++i) {
+        storage.write(makeFrame(i), i % gopFrames == 0);
+    }
+    check(replayExact(snapshot, 30, 45, gopFrames), "later writes do not leak into a snapshot");
+}
+
+static void testEviction()
+{
+    const int gopFrames = 30;
+    DataQueStorage<FrameType> storage(200, 2);
+    for (int i = 0; i < 45; ++i) {
+        storage.write(makeFrame(i), i % gopFrames == 0);
+    }
+    auto snapshot = storage.snapshot();
+    weak_ptr<string> first;
+    snapshot.forEach([&first](uint64_t seq, bool isKey, const FrameType& data){
+        if (seq == 0) {
+            first = data;
+        }
+    });
+
+    // 超过gop个数，旧gop被淘汰
+    for (int i = 45; i < 150; ++i) {
+        storage.write(makeFrame(i), i % gopFrames == 0);
+    }
+    check(storage.snapshot().beginSeq() == 90, "old gops are evicted from the storage");
+    check(replayExact(snapshot, 0, 45, gopFrames), "snapshot survives gop eviction");
+
+    // 一个gop超过缓存上限，整个缓存被清空
+    for (int i = 150; i < 400; ++i) {
+        storage.write(makeFrame(i), i == 150);
+    }
+    check(replayExact(snapshot, 0, 45, gopFrames), "snapshot survives a cache overflow reset");
+
+    storage.clearCache();
+    check(storage.snapshot().empty(), "clearCache empties the storage");
+    check(replayExact(snapshot, 0, 45, gopFrames) && !first.expired(), "snapshot survives clearCache");
+
+    snapshot = DataQueSnapshot<FrameType>();
+    check(first.expired(), "evicted data is freed with the last snapshot");
+}
+
+static void runOnLoop(const EventLoop::Ptr& loop, const function<void()>& func)
+{
+    promise<void> prom;
+    loop->async([&prom, &func](){
+        func();
+        prom.set_value();
+    }, false);
+    prom.get_future().get();
+}
+
+class JoinReader
+{
+public:
+    DataQue<FrameType>::DataQueReaderT::Ptr reader;
+    vector<int> seqs;
+};
+
+static void testJoinStorm()
+{
+    const int gopFrames = 25;
+    const int frames = 2000;
+    vector<EventLoop::Ptr> loops;
+    EventLoopPool::instance()->for_each_loop([&loops](const EventLoop::Ptr& loop){
+        loops.push_back(loop);
+    });
+
+    auto que = make_shared<DataQue<FrameType>>(1000, nullptr, 2);
+    vector<shared_ptr<JoinReader>> readers;
+    mutex mtx;
+    thread writer([&](){
+        for (int i = 0; i < frames; ++i) {
+            que->write(makeFrame(i), i % gopFrames == 0);
+            if (i % 10 == 0) {
+                this_thread::sleep_for(chrono::microseconds(200));
+            }
+        }
+    });
+
+    // 写入过程中在各个loop上不断加入，大部分落在gop中间
+    for (int i = 0; i < 60; ++i) {
+        auto joinReader = make_shared<JoinReader>();
+        auto loop = loops[i % loops.size()];
+        loop->async([que, loop, joinReader](){
+            joinReader->reader = que->attach(loop, true);
+            joinReader->reader->setReadCB([joinReader](const FrameType& data){
+                joinReader->seqs.push_back(stoi(*data));
+            });
+        }, false);
+        {
+            lock_guard<mutex> lck(mtx);
+            readers.push_back(joinReader);
+        }
+        this_thread::sleep_for(chrono::microseconds(300));
+    }
+    writer.join();
+    // 等各个loop派发完
+    for (auto& loop : loops) {
+        runOnLoop(loop, [](){});
+    }
+
+    int exact = 0;
+    for (auto& joinReader : readers) {
+        auto& seqs = joinReader->seqs;
+        bool ok = !seqs.empty() && seqs.front() % gopFrames == 0 && seqs.back() == frames - 1;
+        for (size_t i = 1; ok && i < seqs.size(); ++i) {
+            ok = seqs[i] == seqs[i - 1] + 1;
+        }
+        exact += ok;
+    }
+    cout << "join storm: " << readers.size() << " readers on " << loops.size() << " loops, "
+         << exact << " exact" << endl;
+    check(exact == (int)readers.size(), "every reader starts at a keyframe and gets each later frame once in order");
+}
+
+int main(int argc, char** argv)
+{
+    Logger::instance()->addChannel(std::make_shared<ConsoleChannel>("ConsoleChannel", LError));
+    Logger::instance()->setLevel(LError);
+    EventLoopPool::instance()->init(3, 0, false);
+
+    int joins = argc > 1 ? atoi(argv[1]) : 10000;
+    int gopFrames = argc > 2 ? atoi(argv[2]) : 240;
+
+    testReplay();
+    testEviction();
+    testJoinStorm();
+
+    auto frame = make_shared<string>(1400, 'a');
+
+    LegacyGop legacy;
+    legacy.emplace_back();
+    DataQueStorage<FrameType> storage(gopFrames * 2, 1);
+    for (int i = 0; i < gopFrames; ++i) {
+        bool isKey = i == 0;
+        legacy.back().emplace_back(isKey, frame);
+        storage.write(frame, isKey);
+    }
+
+    uint64_t replayed = 0;
+    auto start = nowUs();
+    for (int i = 0; i < joins; ++i) {
+        // 旧实现: attach时clone一次，flushGop时再拷贝一次
+        auto clone = legacy;
+        auto cache = clone;
+        for (auto& gop : cache) {
+            for (auto& pr : gop) {
+                replayed += pr.second->size() > 0;
+            }
+        }
+    }
+    auto legacyUs = nowUs() - start;
+
+    start = nowUs();
+    for (int i = 0; i < joins; ++i) {
+        auto snapshot = storage.snapshot();
+        snapshot.forEach([&replayed](uint64_t seq, bool isKey, const FrameType& data) {
+            replayed += data->size() > 0;
+        });
+    }
+    auto snapshotUs = nowUs() - start;
+
+    // 只取快照，不回放，衡量加入本身在锁内的开销
+    start = nowUs();
+    for (int i = 0; i < joins; ++i) {
+        auto snapshot = storage.snapshot();
+        replayed += snapshot.empty();
+    }
+    auto takeUs = nowUs() - start;
+
+    cout << "joins: " << joins << ", gop frames: " << gopFrames << ", replayed: " << replayed << endl;
+    cout << "legacy copy:     " << legacyUs << " us, " << (double)legacyUs / joins << " us/join" << endl;
+    cout << "shared snapshot: " << snapshotUs << " us, " << (double)snapshotUs / joins << " us/join" << endl;
+    cout << "snapshot only:   " << takeUs << " us, " << (double)takeUs / joins << " us/join" << endl;
+
+    cout << (g_ok ? "ok" : "FAILED") << endl;
+    _exit(g_ok ? 0 : 1);
+}
@@ -0,0 +1,348 @@
+// 边缘回源测试，源站用本机回环地址上只listen的端口模拟，回源客户端注册为fake协议，
+// 连上源站后创建流，过一会儿就绪，再过一会儿才有关键帧(模拟源站gop到达)
+// 媒体流注册表是进程全局的，没法在一个进程里同时跑边缘和源站两个服务，所以不走真实的rtmp
+// 1. 合并: 多个loop同时请求同一个流，只回源一次，所有请求都在关键帧到达后才就绪
+// 2. 空闲: 有播放者时保持回源，没有播放者超过idleLingerMs后停止回源并释放流
+// 3. 切换: 第一个源站不通时切到下一个，不通的源站排到后面，探测连通后恢复
+// 4. 失败: 所有源站都不通时所有请求都收到失败
+// 编译: 先编译整个工程，再链接lib/下的静态库(libcommon需要--whole-archive)
+// 运行: ./edgeRelay
+
+#include <iostream>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+#include <functional>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+
+#include "Common/EdgeRelay.h"
+#include "Common/MediaSource.h"
+#include "Common/MediaClient.h"
+#include "Common/Config.h"
+#include "Net/TcpClient.h"
+#include "EventPoller/EventLoopPool.h"
+#include "Util/TimeClock.h"
+#include "Log/Logger.h"
+
+using namespace std;
+
+static const int kKeyframeDelayMs = 200;
+static const int kWaiters = 16;
+
+static mutex g_mtx;
+// url -> 回源次数
+static unordered_map<string, int> g_starts;
+static atomic<int> g_closed{0};
+
+class FakeSource : public MediaSource
+{
+public:
+    using Ptr = shared_ptr<FakeSource>;
+
+    FakeSource(const UrlParser& urlParser, const EventLoop::Ptr& loop)
+        :MediaSource(urlParser, loop)
+    {
+        auto track = make_shared<TrackInfo>();
+        track->trackType_ = "video";
+        _tracks[0] = track;
+    }
+
+    vector<DataQueKeyframeInfo> getKeyframeIndex() override
+    {
+        return keyframeTime ? vector<DataQueKeyframeInfo>(1) : vector<DataQueKeyframeInfo>();
+    }
+
+    unordered_map<int, shared_ptr<TrackInfo>> getTrackInfo() override {return _tracks;}
+    int playerCount() override {return players;}
+
+public:
+    atomic<uint64_t> keyframeTime{0};
+    atomic<int> players{0};
+
+private:
+    unordered_map<int, shared_ptr<TrackInfo>> _tracks;
+};
+
+class FakeClient : public TcpClient, public MediaClient
+{
+public:
+    FakeClient(const string& path)
+        :TcpClient(EventLoop::getCurrentLoop())
+        ,_path(path)
+    {}
+
+    bool start(const string& localIp, int localPort, const string& url, int timeout) override
+    {
+        {
+            lock_guard<mutex> lck(g_mtx);
+            ++g_starts[url];
+        }
+        UrlParser parser;
+        parser.parse(url);
+        if (TcpClient::create(localIp, localPort) < 0 || TcpClient::connect(parser.host_, parser.port_, timeout) < 0) {
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    void stop() override {close();}
+    void setOnClose(const function<void()>& cb) override {_onClose = cb;}
+
+    void addOnReady(void* key, const function<void()>& onReady) override
+    {
+        lock_guard<mutex> lck(_mtx);
+        auto src = _source.lock();
+        if (src) {
+            src->addOnReady(key, onReady);
+            return ;
+        }
+        _mapOnReady.emplace(key, onReady);
+    }
+
+    void onConnect() override
+    {
+        UrlParser parser;
+        parser.path_ = _path;
+        parser.protocol_ = "fake";
+        auto loop = getLoop();
+        auto source = MediaSource::getOrCreate(_path, "default", "fake", "default", [parser, loop](){
+            return make_shared<FakeSource>(parser, loop);
+        });
+        auto src = dynamic_pointer_cast<FakeSource>(source);
+        if (!src) {
+            close();
+            return ;
+        }
+        src->setOrigin();
+        {
+            lock_guard<mutex> lck(_mtx);
+            _source = src;
+            for (auto& iter : _mapOnReady) {
+                src->addOnReady(iter.first, iter.second);
+            }
+            _mapOnReady.clear();
+        }
+
+        weak_ptr<FakeSource> wSrc = src;
+        loop->addTimerTask(30, [wSrc](){
+            auto src = wSrc.lock();
+            if (src) {
+                src->onReady();
+            }
+            return 0;
+        }, nullptr);
+        loop->addTimerTask(30 + kKeyframeDelayMs, [wSrc](){
+            auto src = wSrc.lock();
+            if (src) {
+                src->keyframeTime = TimeClock::now();
+            }
+            return 0;
+        }, nullptr);
+    }
+
+    void onError(const string& err) override {close();}
+
+    void close() override
+    {
+        if (getSocket()) {
+            ++g_closed;
+        }
+        if (_onClose) {
+            auto cb = _onClose;
+            _onClose = nullptr;
+            cb();
+        }
+        TcpClient::close();
+    }
+
+private:
+    string _path;
+    mutex _mtx;
+    weak_ptr<FakeSource> _source;
+    function<void()> _onClose;
+    unordered_map<void*, function<void()>> _mapOnReady;
+};
+
+// 只listen不accept，连接在backlog里也能建立
+static int listenOn(int port)
+{
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    int on = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(addr);
+    if (bind(fd, (sockaddr*)&addr, len) != 0 || listen(fd, 128) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static int localPort(int fd)
+{
+    sockaddr_in addr = {};
+    socklen_t len = sizeof(addr);
+    getsockname(fd, (sockaddr*)&addr, &len);
+    return ntohs(addr.sin_port);
+}
+
+// 分配一个端口后关掉，连接会被拒绝
+static int closedPort()
+{
+    int fd = listenOn(0);
+    int port = localPort(fd);
+    close(fd);
+    return port;
+}
+
+static bool waitFor(const function<bool()>& pred, int ms)
+{
+    auto deadline = chrono::steady_clock::now() + chrono::milliseconds(ms);
+    while (!pred()) {
+        if (chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        this_thread::sleep_for(chrono::milliseconds(10));
+    }
+    return true;
+}
+
+static int starts(const string& url)
+{
+    lock_guard<mutex> lck(g_mtx);
+    return g_starts[url];
+}
+
+static bool originHealthy(const string& endpoint)
+{
+    for (auto& info : EdgeRelay::instance()->getOriginInfo()) {
+        if (info.endpoint == endpoint) {
+            return info.healthy;
+        }
+    }
+    return true;
+}
+
+struct Result
+{
+    atomic<int> ready{0};
+    atomic<int> fail{0};
+    // 最早的就绪时间
+    atomic<uint64_t> firstReady{0};
+};
+
+static void request(const string& uri, int count, Result& result)
+{
+    for (int i = 0; i < count; ++i) {
+        auto loop = EventLoopPool::instance()->getLoopByCircle();
+        loop->async([uri, i, &result](){
+            EdgeRelay::instance()->pullFromOrigin(uri, "default", (void*)(intptr_t)(i + 1), [&result](){
+                uint64_t expected = 0;
+                result.firstReady.compare_exchange_strong(expected, TimeClock::now());
+                ++result.ready;
+            }, [&result](){
+                ++result.fail;
+            });
+        }, false);
+    }
+}
+
+static void setConfig(const string& key, const string& value)
+{
+    Config::instance()->setAndUpdate(value, "Cdn", key);
+}
+
+static bool check(bool ok, const string& msg)
+{
+    cout << (ok ? "[ok] " : "[FAILED] ") << msg << endl;
+    return ok;
+}
+
+int main(int argc, char** argv)
+{
+    Logger::instance()->addChannel(std::make_shared<ConsoleChannel>("ConsoleChannel", LError));
+    Logger::instance()->setLevel(LError);
+    EventLoopPool::instance()->init(4, true, false);
+
+    MediaClient::registerCreateClient("fake", [](MediaClientType type, const string& appName, const string& streamName){
+        return make_shared<FakeClient>("/" + appName + "/" + streamName);
+    });
+
+    int originFd = listenOn(0);
+    string origin = "127.0.0.1:" + to_string(localPort(originFd));
+    int downPort = closedPort();
+    string down = "127.0.0.1:" + to_string(downPort);
+
+    setConfig("protocol", "fake");
+    setConfig("origins", origin);
+    setConfig("idleLingerMs", "30000");
+    setConfig("originCheckMs", "300");
+    setConfig("keyframeWaitMs", "2000");
+
+    bool ok = true;
+
+    // 1. 合并
+    Result first;
+    request("/live/a", kWaiters, first);
+    bool ready = waitFor([&](){return first.ready == kWaiters;}, 3000);
+    ok &= check(ready, "all waiters ready: " + to_string(first.ready));
+    ok &= check(starts("fake://" + origin + "/live/a") == 1, "one pull for " + to_string(kWaiters) + " waiters");
+    auto src = dynamic_pointer_cast<FakeSource>(MediaSource::get("/live/a", "default"));
+    ok &= check(src && src->keyframeTime && first.firstReady >= src->keyframeTime, "waiters released after keyframe");
+
+    Result late;
+    request("/live/a", 4, late);
+    ok &= check(waitFor([&](){return late.ready == 4;}, 1000) && starts("fake://" + origin + "/live/a") == 1, "late waiters share the session");
+
+    // 2. 空闲
+    if (src) {
+        src->players = 1;
+    }
+    setConfig("idleLingerMs", "300");
+    this_thread::sleep_for(chrono::milliseconds(1500));
+    ok &= check(MediaSource::get("/live/a", "default") != nullptr, "keep pulling while playing");
+    int closed = g_closed;
+    if (src) {
+        src->players = 0;
+    }
+    src = nullptr;
+    ok &= check(waitFor([&](){return !MediaSource::get("/live/a", "default") && EdgeRelay::instance()->getSessionCount() == 0;}, 3000)
+                && g_closed == closed + 1, "stop pulling after idle linger");
+
+    // 3. 切换
+    setConfig("origins", down + "," + origin);
+    Result failover;
+    request("/live/b", 4, failover);
+    ok &= check(waitFor([&](){return failover.ready == 4;}, 3000), "failover to the second origin");
+    ok &= check(!originHealthy(down), "first origin marked down");
+
+    Result reorder;
+    request("/live/c", 1, reorder);
+    ok &= check(waitFor([&](){return reorder.ready == 1;}, 3000) && starts("fake://" + down + "/live/c") == 0, "down origin is skipped");
+
+    int downFd = listenOn(downPort);
+    ok &= check(downFd >= 0 && waitFor([&](){return originHealthy(down);}, 3000), "down origin recovered by probe");
+
+    // 4. 失败
+    setConfig("origins", "127.0.0.1:" + to_string(closedPort()));
+    Result fail;
+    request("/live/d", 4, fail);
+    bool failed = waitFor([&](){return fail.fail == 4;}, 3000);
+    ok &= check(failed && fail.ready == 0, "all waiters failed: " + to_string(fail.fail) + ", ready: " + to_string(fail.ready));
+    // b和c没有播放者，也会在空闲后结束
+    ok &= check(waitFor([&](){return EdgeRelay::instance()->getSessionCount() == 0;}, 3000), "all sessions removed");
+
+    close(originFd);
+    close(downFd);
+
+    cout << (ok ? "ok" : "FAILED") << endl;
+    _exit(ok ? 0 : 1);
+}
@@ -0,0 +1,285 @@
+// enhanced rtmp(FourCC)视频tag解析测试，用手工拼的flv tag(和ffmpeg 6推流的格式一致)
+// 1. RtmpVideoHeader: legacy/enhanced头、avc1/hvc1 CodedFrames的cts、CodedFramesX、不认识的FourCC、截断的头
+// 2. hvc1: SequenceStart解析出vps/sps/pps，CodedFrames带cts，CodedFramesX不带，Metadata和SequenceEnd不出帧，NALU长度越界不崩
+// 3. av01/vp09: SequenceStart解析出配置，CodedFrames出帧，Metadata不出帧
+// 4. 往返: 解出来的h265帧和vp9配置用enhanced编码后再解码，内容和cts不变
+// 编译: 先编译整个工程，再链接lib/、Base/lib下的静态库
+// 运行: ./enhancedRtmp
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <unistd.h>
+
+#include "Rtmp/Rtmp.h"
+#include "Rtmp/RtmpMessage.h"
+#include "Rtmp/Decode/RtmpDecodeH265.h"
+#include "Rtmp/Decode/RtmpDecodeAV1.h"
+#include "Rtmp/Decode/RtmpDecodeVPX.h"
+#include "Rtmp/Encode/RtmpEncodeH265.h"
+#include "Rtmp/Encode/RtmpEncodeVPX.h"
+#include "Codec/H265Track.h"
+#include "Codec/AV1Track.h"
+#include "Codec/VP9Track.h"
+#include "Log/Logger.h"
+
+using namespace std;
+
+static bool g_ok = true;
+
+static void check(bool cond, const string& name)
+{
+    cout << (cond ? "ok     " : "FAILED ") << name << endl;
+    g_ok = g_ok && cond;
+}
+
+static RtmpMessage::Ptr createMsg(const string& tag, uint32_t timestamp)
+{
+    auto msg = make_shared<RtmpMessage>();
+    msg->payload = make_shared<StreamBuffer>(tag.size() + 1);
+    memcpy(msg->payload->data(), tag.data(), tag.size());
+    msg->payload->setSize(tag.size());
+    msg->length = tag.size();
+    msg->abs_timestamp = timestamp;
+    msg->type_id = RTMP_VIDEO;
+    msg->csid = RTMP_CHUNK_VIDEO_ID;
+
+    return msg;
+}
+
+static string enhancedHeader(int frameType, int packetType, const char* fourcc)
+{
+    string header;
+    header.push_back((char)(0x80 | frameType << 4 | packetType));
+    header.append(fourcc, 4);
+
+    return header;
+}
+
+static string nalu32(const string& nalu)
+{
+    string data;
+    uint32_t size = nalu.size();
+    data.push_back((char)(size >> 24));
+    data.push_back((char)(size >> 16));
+    data.push_back((char)(size >> 8));
+    data.push_back((char)size);
+
+    return data + nalu;
+}
+
+static string payloadOf(const FrameBuffer::Ptr& frame)
+{
+    return string(frame->data() + frame->startSize(), frame->size() - frame->startSize());
+}
+
+// 假的hevc nalu，只有nal头是对的，sps够长让编码器能取到profile这些字段
+static const string kVps = string("\x40\x01\x0c\x01\xff\xff", 6);
+static const string kSps = string("\x42\x01\x01\x01\x60\x00\x00\x03\x00\x90\x00\x00\x03\x00\x00\x03\x00\x5d\xa0\x02\x80\x80\x2d\x16", 24);
+static const string kPps = string("\x44\x01\xc1\x72\xb4\x62", 6);
+static const string kIdr = string("\x26\x01\xaf\x06\xb8\x63", 6);
+static const string kTrail = string("\x02\x01\xd0\x28\x97", 5);
+
+static string hvcc()
+{
+    // 22字节的hvcC头，numOfArrays，然后每种参数集一个数组
+    string config(22, '\0');
+    config[0] = 0x01;
+    config.push_back(3);
+    for (auto& nalu : {kVps, kSps, kPps}) {
+        config.push_back((char)(0x80 | ((nalu[0] >> 1) & 0x3f)));
+        config.append("\x00\x01", 2);
+        config.push_back((char)(nalu.size() >> 8));
+        config.push_back((char)nalu.size());
+        config += nalu;
+    }
+
+    return config;
+}
+
+static void testHeader()
+{
+    RtmpVideoHeader header;
+    check(header.parse((uint8_t*)"\x17\x01\xff\xff\xd8\x00", 6) && !header.enhanced_ && header.codecId_ == RTMP_CODEC_ID_H264
+          && header.isKeyFrame() && header.cts_ == -40 && header.headerSize_ == 5, "legacy avc, negative cts");
+
+    string tag = enhancedHeader(1, RTMP_PACKET_TYPE_CODED_FRAMES, "hvc1") + string("\x00\x00\x28", 3);
+    check(header.parse((uint8_t*)tag.data(), tag.size()) && header.enhanced_ && header.codecId_ == RTMP_CODEC_ID_H265
+          && header.isKeyFrame() && header.cts_ == 40 && header.headerSize_ == 8, "enhanced hvc1 coded frames");
+    check(!header.parse((uint8_t*)tag.data(), 6), "enhanced hvc1 coded frames without cts");
+
+    tag = enhancedHeader(2, RTMP_PACKET_TYPE_CODED_FRAMESX, "hvc1");
+    check(header.parse((uint8_t*)tag.data(), tag.size()) && header.isFrame() && !header.isKeyFrame()
+          && header.cts_ == 0 && header.headerSize_ == 5, "enhanced hvc1 coded frames x");
+
+    tag = enhancedHeader(1, RTMP_PACKET_TYPE_CODED_FRAMES, "av01");
+    check(header.parse((uint8_t*)tag.data(), tag.size()) && header.codecId_ == RTMP_CODEC_ID_AV1
+          && header.headerSize_ == 5, "enhanced av01 coded frames has no cts");
+
+    tag = enhancedHeader(1, RTMP_PACKET_TYPE_METADATA, "vp09");
+    check(header.parse((uint8_t*)tag.data(), tag.size()) && header.codecId_ == RTMP_CODEC_ID_VP9
+          && !header.isFrame() && !header.isConfig(), "enhanced vp09 metadata");
+
+    tag = enhancedHeader(1, RTMP_PACKET_TYPE_SEQUENCE_START, "vvc1");
+    check(header.parse((uint8_t*)tag.data(), tag.size()) && header.codecId_ == 0, "unknown fourcc");
+    check(!header.parse((uint8_t*)tag.data(), 3), "truncated header");
+
+    tag = enhancedHeader(1, RTMP_PACKET_TYPE_CODED_FRAMESX, "hvc1") + nalu32(kIdr);
+    auto msg = createMsg(tag, 0);
+    check(msg->isKeyFrame(), "RtmpMessage::isKeyFrame enhanced");
+    msg->length = 1;
+    check(!msg->isKeyFrame(), "RtmpMessage::isKeyFrame short payload");
+}
+
+static void testH265()
+{
+    auto track = H265Track::createTrack(VideoTrackType, 96, 90000);
+    RtmpDecodeH265 decoder(track);
+    vector<FrameBuffer::Ptr> frames;
+    decoder.setOnFrame([&frames](const FrameBuffer::Ptr& frame){
+        frames.push_back(frame);
+    });
+
+    decoder.decode(createMsg(enhancedHeader(1, RTMP_PACKET_TYPE_SEQUENCE_START, "hvc1") + hvcc(), 0));
+    check(track->_vps && track->_sps && track->_pps && payloadOf(track->_sps) == kSps
+          && frames.size() == 3, "hvc1 sequence start");
+    frames.clear();
+
+    string tag = enhancedHeader(1, RTMP_PACKET_TYPE_CODED_FRAMES, "hvc1") + string("\x00\x00\x50", 3)
+                 + nalu32(kIdr) + nalu32(kTrail);
+    decoder.decode(createMsg(tag, 1000));
+    check(frames.size() == 2 && payloadOf(frames[0]) == kIdr && payloadOf(frames[1]) == kTrail
+          && frames[0]->dts() == 1000 && frames[0]->pts() == 1080, "hvc1 coded frames with cts");
+    frames.clear();
+
+    decoder.decode(createMsg(enhancedHeader(2, RTMP_PACKET_TYPE_CODED_FRAMESX, "hvc1") + nalu32(kTrail), 1040));
+    check(frames.size() == 1 && payloadOf(frames[0]) == kTrail && frames[0]->pts() == 1040, "hvc1 coded frames x");
+    frames.clear();
+
+    // metadata里是amf编码的colorInfo
+    decoder.decode(createMsg(enhancedHeader(1, RTMP_PACKET_TYPE_METADATA, "hvc1") + string("\x02\x00\x09" "colorInfo\x03\x00\x00\x09", 16), 1080));
+    decoder.decode(createMsg(enhancedHeader(1, RTMP_PACKET_TYPE_SEQUENCE_END, "hvc1"), 1080));
+    check(frames.empty(), "hvc1 metadata and sequence end are not frames");
+
+    tag = enhancedHeader(2, RTMP_PACKET_TYPE_CODED_FRAMESX, "hvc1") + nalu32(kTrail);
+    tag[8] = 0x7f;
+    decoder.decode(createMsg(tag, 1120));
+    decoder.decode(createMsg(enhancedHeader(1, RTMP_PACKET_TYPE_SEQUENCE_START, "hvc1") + hvcc().substr(0, 30), 0));
+    check(frames.empty(), "hvc1 truncated nalu");
+
+    // legacy的hevc也要用上cts
+    decoder.decode(createMsg(string("\x1c\x01\x00\x00\x28", 5) + nalu32(kIdr), 2000));
+    check(frames.size() == 1 && frames[0]->pts() == 2040, "legacy hevc cts");
+}
+
+static void testAV1()
+{
+    auto track = AV1Track::createTrack(VideoTrackType, 96, 90000);
+    RtmpDecodeAV1 decoder(track);
+    vector<FrameBuffer::Ptr> frames;
+    decoder.setOnFrame([&frames](const FrameBuffer::Ptr& frame){
+        frames.push_back(frame);
+    });
+
+    // av1C四个字节，后面是sequence header obu
+    string obu("\x0a\x0b\x00\x00\x00\x24\xc6\xab\xdf\x3e\xfe\x24\x04", 13);
+    decoder.decode(createMsg(enhancedHeader(1, RTMP_PACKET_TYPE_SEQUENCE_START, "av01") + string("\x81\x08\x0c\x00", 4) + obu, 0));
+    check(track->_sequence && payloadOf(track->_sequence) == obu, "av01 sequence start");
+    frames.clear();
+
+    string frame("\x12\x00\x32\x05\x10\x00\x00\x00\x00", 9);
+    decoder.decode(createMsg(enhancedHeader(1, RTMP_PACKET_TYPE_CODED_FRAMES, "av01") + frame, 40));
+    decoder.decode(createMsg(enhancedHeader(1, RTMP_PACKET_TYPE_METADATA, "av01") + string("\x02\x00\x00", 3), 40));
+    check(frames.size() == 1 && payloadOf(frames[0]) == frame && frames[0]->pts() == 40, "av01 coded frames");
+}
+
+static void testVP9()
+{
+    auto track = VP9Track::createTrack(VideoTrackType, 96, 90000);
+    RtmpDecodeVPX decoder(track);
+    vector<FrameBuffer::Ptr> frames;
+    decoder.setOnFrame([&frames](const FrameBuffer::Ptr& frame){
+        frames.push_back(frame);
+    });
+
+    // vpcC: version 1, flags 0, profile 2, level 40, 10bit 4:2:0
+    string record("\x02\x28\xa2\x01\x01\x01\x00\x00", 8);
+    decoder.decode(createMsg(enhancedHeader(1, RTMP_PACKET_TYPE_SEQUENCE_START, "vp09") + string("\x01\x00\x00\x00", 4) + record, 0));
+    check(track->getConfig() == record, "vp09 sequence start");
+
+    string frame("\x82\x49\x83\x42\x00", 5);
+    decoder.decode(createMsg(enhancedHeader(1, RTMP_PACKET_TYPE_CODED_FRAMES, "vp09") + frame, 40));
+    decoder.decode(createMsg(enhancedHeader(1, RTMP_PACKET_TYPE_SEQUENCE_END, "vp09"), 80));
+    check(frames.size() == 1 && payloadOf(frames[0]) == frame, "vp09 coded frames");
+
+    // 编码出的序列头再解码，配置不变
+    RtmpEncodeVPX encoder(track);
+    encoder.setEnhanced(true);
+    auto other = VP9Track::createTrack(VideoTrackType, 96, 90000);
+    RtmpDecodeVPX otherDecoder(other);
+    otherDecoder.decode(createMsg(encoder.getConfig(), 0));
+    check(other->getConfig() == record, "vp09 config round trip");
+}
+
+static void testH265RoundTrip()
+{
+    auto track = H265Track::createTrack(VideoTrackType, 96, 90000);
+    RtmpDecodeH265 decoder(track);
+    vector<FrameBuffer::Ptr> frames;
+    decoder.setOnFrame([&frames](const FrameBuffer::Ptr& frame){
+        frames.push_back(frame);
+    });
+    decoder.decode(createMsg(enhancedHeader(1, RTMP_PACKET_TYPE_SEQUENCE_START, "hvc1") + hvcc(), 0));
+    decoder.decode(createMsg(enhancedHeader(1, RTMP_PACKET_TYPE_CODED_FRAMES, "hvc1") + string("\x00\x00\x00", 3) + nalu32(kIdr), 0));
+    decoder.decode(createMsg(enhancedHeader(2, RTMP_PACKET_TYPE_CODED_FRAMES, "hvc1") + string("\x00\x00\x28", 3) + nalu32(kTrail), 40));
+    decoder.decode(createMsg(enhancedHeader(2, RTMP_PACKET_TYPE_CODED_FRAMES, "hvc1") + string("\x00\x00\x28", 3) + nalu32(kTrail), 80));
+
+    RtmpEncodeH265 encoder(track);
+    encoder.setEnhanced(true);
+    vector<RtmpMessage::Ptr> msgs;
+    encoder.setOnRtmpPacket([&msgs](const RtmpMessage::Ptr& msg, bool start){
+        msgs.push_back(msg);
+    });
+    for (auto& frame : frames) {
+        encoder.encode(frame);
+    }
+
+    auto other = H265Track::createTrack(VideoTrackType, 96, 90000);
+    RtmpDecodeH265 otherDecoder(other);
+    vector<FrameBuffer::Ptr> otherFrames;
+    otherDecoder.setOnFrame([&otherFrames](const FrameBuffer::Ptr& frame){
+        otherFrames.push_back(frame);
+    });
+    otherDecoder.decode(createMsg(encoder.getConfig(), 0));
+    check(other->_vps && payloadOf(other->_vps) == kVps && payloadOf(other->_sps) == kSps
+          && payloadOf(other->_pps) == kPps, "hvc1 config round trip");
+
+    // 最后一帧还缓存在编码器里
+    bool keyFrame = !msgs.empty() && msgs[0]->isKeyFrame();
+    otherFrames.clear();
+    for (auto& msg : msgs) {
+        otherDecoder.decode(createMsg(string(msg->payload->data(), msg->length), msg->abs_timestamp));
+    }
+    bool same = otherFrames.size() + 1 == frames.size();
+    for (size_t i = 0; same && i < otherFrames.size(); ++i) {
+        same = payloadOf(otherFrames[i]) == payloadOf(frames[i]) && otherFrames[i]->pts() == frames[i]->pts()
+               && otherFrames[i]->dts() == frames[i]->dts();
+    }
+    check(keyFrame && same, "hvc1 frames round trip");
+}
+
+int main(int argc, char** argv)
+{
+    Logger::instance()->addChannel(std::make_shared<ConsoleChannel>("ConsoleChannel", LError));
+    Logger::instance()->setLevel(LError);
+
+    testHeader();
+    testH265();
+    testAV1();
+    testVP9();
+    testH265RoundTrip();
+
+    cout << (g_ok ? "ok" : "FAILED") << endl;
+    _exit(g_ok ? 0 : 1);
+}
@@ -0,0 +1,429 @@
+// hls拉流测试，本机回环地址上起一个简单的http服务，返回固定的m3u8，每个ts响应前等待一段时间
+// 1. 预取: 多个切片同时下载，总耗时远小于逐个下载，同时下载的数量不超过prefetchNum
+// 2. 长连接: 连接数远小于请求数
+// 3. 顺序: 所有切片按顺序解出全部的帧
+// 4. 码率: 开始用最低码率，测出带宽后切到高码率
+// 5. 刷新: 直播m3u8按targetDuration刷新，不会频繁请求
+// 6. 响应格式: chunked编码的响应能收全并复用连接，没有content-length时以断开为结束且不再复用，
+//    状态行没有原因短语时按状态码判断
+// 编译: 先编译整个工程，再链接lib/下的静态库(libmpeg/libcommon需要--whole-archive)
+// 运行: ./hlsPull
+
+#include <iostream>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <string>
+#include <cstdlib>
+#include <unordered_map>
+#include <functional>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+
+#include "HttpStream/HlsClientContext.h"
+#include "HttpStream/HttpHlsTsClient.h"
+#include "Mpeg/TsMuxer.h"
+#include "Mpeg/TsDemuxer.h"
+#include "Codec/H264Track.h"
+#include "Codec/H264Frame.h"
+#include "Common/Config.h"
+#include "EventPoller/EventLoopPool.h"
+#include "Log/Logger.h"
+
+using namespace std;
+
+static const int kSegments = 12;
+static const int kFramesPerSegment = 25;
+static const int kDelayMs = 200;
+static const int kPrefetch = 3;
+
+static vector<string> g_segments;
+
+static mutex g_mtx;
+// path -> 请求次数
+static unordered_map<string, int> g_requests;
+static atomic<int> g_accepts{0};
+static atomic<int> g_inflight{0};
+static atomic<int> g_maxInflight{0};
+static uint64_t g_startTime = 0;
+
+static uint64_t nowMs()
+{
+    return chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static FrameBuffer::Ptr makeFrame(int nalType, int size, int pts)
+{
+    auto frame = FrameBuffer::createFrame(CodecH264, 4, VideoTrackType, false);
+    string data("\x00\x00\x00\x01", 4);
+    data.push_back((char)(0x60 | nalType));
+    for (int i = 1; i < size; ++i) {
+        data.push_back((char)(rand() % 250 + 4));
+    }
+    frame->_buffer.assign(data.data(), data.size());
+    frame->_pts = frame->_dts = pts;
+    frame->_index = VideoTrackType;
+    frame->_trackType = VideoTrackType;
+    frame->_codec = CodecH264;
+
+    return frame;
+}
+
+// 每个切片一个gop，时间戳连续
+static void makeSegments()
+{
+    auto track = H264Track::createTrack(VideoTrackType, 96, 90000);
+    for (int seg = 0; seg < kSegments; ++seg) {
+        string ts;
+        TsMuxer muxer;
+        muxer.addTrackInfo(track);
+        muxer.startEncode();
+        muxer.setOnTsPacket([&ts](const StreamBuffer::Ptr& pkt, int pts, int dts, bool keyframe){
+            ts.append(pkt->data(), pkt->size());
+        });
+        for (int i = 0; i < kFramesPerSegment; ++i) {
+            int pts = 1000 + (seg * kFramesPerSegment + i) * 40;
+            if (i == 0) {
+                for (auto& frame : {makeFrame(7, 20, pts), makeFrame(8, 4, pts), makeFrame(5, 20000, pts)}) {
+                    muxer.onFrame(frame);
+                }
+            } else {
+                muxer.onFrame(makeFrame(1, 2000 + rand() % 3000, pts));
+            }
+        }
+        g_segments.push_back(ts);
+    }
+}
+
+// 本地按顺序解复用所有切片得到的帧数
+static int demuxFrames()
+{
+    int frames = 0;
+    TsDemuxer demuxer;
+    demuxer.setOnDecode([&frames](const FrameBuffer::Ptr& frame){
+        ++frames;
+    });
+    for (auto& ts : g_segments) {
+        demuxer.onTsPacket((char*)ts.data(), ts.size(), 0);
+    }
+    return frames;
+}
+
+static string vodPlaylist()
+{
+    string m3u8 = "#EXTM3U\n#EXT-X-VERSION:3\n#EXT-X-TARGETDURATION:1\n#EXT-X-MEDIA-SEQUENCE:0\n";
+    for (int i = 0; i < kSegments; ++i) {
+        m3u8 += "#EXTINF:1.000,\nseg" + to_string(i) + ".ts\n";
+    }
+    return m3u8 + "#EXT-X-ENDLIST\n";
+}
+
+// 每秒多一个切片，保留最近4个
+static string livePlaylist()
+{
+    int last = (nowMs() - g_startTime) / 1000 + 3;
+    string m3u8 = "#EXTM3U\n#EXT-X-VERSION:3\n#EXT-X-TARGETDURATION:1\n#EXT-X-MEDIA-SEQUENCE:" + to_string(last - 3) + "\n";
+    for (int i = last - 3; i <= last; ++i) {
+        m3u8 += "#EXTINF:1.000,\nseg" + to_string(i) + ".ts\n";
+    }
+    return m3u8;
+}
+
+static bool response(const string& path, string& body)
+{
+    if (path == "/vod/master.m3u8") {
+        body = "#EXTM3U\n"
+               "#EXT-X-STREAM-INF:PROGRAM-ID=1,BANDWIDTH=100000,RESOLUTION=320x240\nlow/index.m3u8\n"
+               "#EXT-X-STREAM-INF:PROGRAM-ID=1,BANDWIDTH=2000000,RESOLUTION=1280x720\nhigh/index.m3u8\n";
+        return true;
+    }
+    if (path == "/vod/low/index.m3u8" || path == "/vod/high/index.m3u8") {
+        body = vodPlaylist();
+        return true;
+    }
+    if (path == "/live/index.m3u8") {
+        body = livePlaylist();
+        return true;
+    }
+
+    auto pos = path.rfind("/seg");
+    if (pos == string::npos) {
+        return false;
+    }
+    int index = atoi(path.data() + pos + 4);
+    body = g_segments[index % kSegments];
+    return true;
+}
+
+static string chunkedBody(const string& body)
+{
+    string out;
+    for (size_t pos = 0; pos < body.size(); pos += 1000) {
+        size_t len = min<size_t>(1000, body.size() - pos);
+        char size[16];
+        snprintf(size, sizeof(size), "%zx\r\n", len);
+        out += size;
+        out.append(body, pos, len);
+        out += "\r\n";
+    }
+    return out + "0\r\n\r\n";
+}
+
+static void serve(int fd)
+{
+    string buffer;
+    char buf[4096];
+    while (true) {
+        auto end = buffer.find("\r\n\r\n");
+        if (end == string::npos) {
+            int n = recv(fd, buf, sizeof(buf), 0);
+            if (n <= 0) {
+                break;
+            }
+            buffer.append(buf, n);
+            continue;
+        }
+
+        string header = buffer.substr(0, end);
+        buffer.erase(0, end + 4);
+        auto first = header.find(' ');
+        auto second = header.find(' ', first + 1);
+        string path = header.substr(first + 1, second - first - 1);
+        path = path.substr(0, path.find('?'));
+        bool keepAlive = header.find("Connection: close") == string::npos;
+        {
+            lock_guard<mutex> lck(g_mtx);
+            ++g_requests[path];
+        }
+
+        string body;
+        bool isTs = path.find(".ts") != string::npos;
+        if (isTs) {
+            int inflight = ++g_inflight;
+            int expected = g_maxInflight;
+            while (inflight > expected && !g_maxInflight.compare_exchange_weak(expected, inflight)) {}
+            this_thread::sleep_for(chrono::milliseconds(kDelayMs));
+        }
+        bool found = response(path, body);
+        bool chunked = path.find("/chunked/") == 0;
+        bool closeDelimited = path.find("/close/") == 0;
+        string rsp = found ? (path.find("/noreason/") == 0 ? "HTTP/1.1 200\r\n" : "HTTP/1.1 200 OK\r\n") : "HTTP/1.1 404 Not Found\r\n";
+        if (chunked) {
+            rsp += "Transfer-Encoding: chunked\r\n";
+            body = chunkedBody(body);
+        } else if (closeDelimited) {
+            // 不带content-length和connection，发完就断开
+            keepAlive = false;
+        } else {
+            rsp += "Content-Length: " + to_string(body.size()) + "\r\n";
+        }
+        if (!closeDelimited) {
+            rsp += keepAlive ? "Connection: keep-alive\r\n" : "Connection: close\r\n";
+        }
+        rsp += "\r\n" + body;
+        size_t sent = 0;
+        while (sent < rsp.size()) {
+            int n = send(fd, rsp.data() + sent, rsp.size() - sent, MSG_NOSIGNAL);
+            if (n <= 0) {
+                break;
+            }
+            sent += n;
+        }
+        if (isTs) {
+            --g_inflight;
+        }
+        if (!keepAlive) {
+            break;
+        }
+    }
+    close(fd);
+}
+
+static int startServer()
+{
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    int on = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(addr);
+    if (bind(fd, (sockaddr*)&addr, len) != 0 || listen(fd, 128) != 0) {
+        return -1;
+    }
+    getsockname(fd, (sockaddr*)&addr, &len);
+
+    thread([fd](){
+        while (true) {
+            int conn = accept(fd, nullptr, nullptr);
+            if (conn < 0) {
+                break;
+            }
+            ++g_accepts;
+            thread(serve, conn).detach();
+        }
+    }).detach();
+
+    return ntohs(addr.sin_port);
+}
+
+static int requests(const function<bool(const string& path)>& pred)
+{
+    lock_guard<mutex> lck(g_mtx);
+    int count = 0;
+    for (auto& iter : g_requests) {
+        if (pred(iter.first)) {
+            count += iter.second;
+        }
+    }
+    return count;
+}
+
+static bool waitFor(const function<bool()>& pred, int ms)
+{
+    auto deadline = chrono::steady_clock::now() + chrono::milliseconds(ms);
+    while (!pred()) {
+        if (chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        this_thread::sleep_for(chrono::milliseconds(10));
+    }
+    return true;
+}
+
+static HlsClientContext::Ptr startClient(const EventLoop::Ptr& loop, const string& stream, const string& url)
+{
+    auto client = make_shared<HlsClientContext>(MediaClientType_Pull, "hls", stream);
+    atomic<bool> done{false};
+    loop->async([&](){
+        client->start("0.0.0.0", 0, url, 5);
+        done = true;
+    }, true);
+    while (!done) {
+        this_thread::sleep_for(chrono::milliseconds(1));
+    }
+    return client;
+}
+
+struct Fetch
+{
+    bool done = false;
+    bool ok = false;
+    bool idle = false;
+    bool closed = false;
+    bool checked = false;
+    string body;
+};
+
+// 用同一个连接请求url，等到响应结束
+static Fetch fetch(const EventLoop::Ptr& loop, const HttpHlsTsClient::Ptr& client, const string& url)
+{
+    auto result = make_shared<Fetch>();
+    loop->async([client, result, url](){
+        client->setOnTsPacket([result](const char* data, int len){
+            result->body.append(data, len);
+        });
+        client->setOnResponse([client, result](bool ok){
+            result->ok = ok;
+            result->done = true;
+        });
+        if (!client->start(url, 5)) {
+            result->done = true;
+        }
+    }, true);
+    waitFor([result](){return result->done;}, 3000);
+    // 回调之后连接的状态
+    this_thread::sleep_for(chrono::milliseconds(50));
+    loop->async([client, result](){
+        result->idle = client->isIdle();
+        result->closed = client->isClosed();
+        result->checked = true;
+    }, true);
+    waitFor([result](){return result->checked;}, 1000);
+    return *result;
+}
+
+static bool check(bool ok, const string& msg)
+{
+    cout << (ok ? "[ok] " : "[FAILED] ") << msg << endl;
+    return ok;
+}
+
+int main(int argc, char** argv)
+{
+    Logger::instance()->addChannel(std::make_shared<ConsoleChannel>("ConsoleChannel", LError));
+    Logger::instance()->setLevel(LError);
+    H264Track::registerTrackInfo();
+    H264Frame::registerFrame();
+    EventLoopPool::instance()->init(1, true, false);
+    srand(1);
+
+    Config::instance()->setAndUpdate(kPrefetch, "Hls", "Client", "prefetchNum");
+    Config::instance()->setAndUpdate(600000, "Hls", "Client", "bufferMs");
+
+    makeSegments();
+    g_startTime = nowMs();
+    int port = startServer();
+    string base = "http://127.0.0.1:" + to_string(port);
+    auto loop = EventLoopPool::instance()->getLoopByCircle();
+
+    bool ok = true;
+
+    // 1. 预取
+    uint64_t start = nowMs();
+    auto vod = startClient(loop, "vod", base + "/vod/master.m3u8");
+    bool finished = waitFor([&](){return vod->getSegmentCount() == kSegments;}, 10000);
+    uint64_t cost = nowMs() - start;
+    ok &= check(finished && cost < kSegments * kDelayMs / 2, "download " + to_string(vod->getSegmentCount()) + " segments in " + to_string(cost) + "ms");
+    ok &= check(g_maxInflight >= 2 && g_maxInflight <= kPrefetch, "max parallel downloads: " + to_string(g_maxInflight));
+
+    // 2. 长连接
+    int total = requests([](const string& path){return path.find("/vod/") == 0;});
+    ok &= check(g_accepts <= kPrefetch + 1 && vod->getConnectionCount() <= kPrefetch + 1,
+                to_string(total) + " requests on " + to_string(g_accepts) + " connections");
+
+    // 3. 顺序，和本地按顺序解出来的帧数一样
+    int frames = demuxFrames();
+    ok &= check(waitFor([&](){return (int)vod->getFrameCount() == frames;}, 1000),
+                "demuxed frames: " + to_string(vod->getFrameCount()) + "/" + to_string(frames));
+
+    // 4. 码率
+    int low = requests([](const string& path){return path.find("/vod/low/seg") == 0;});
+    int high = requests([](const string& path){return path.find("/vod/high/seg") == 0;});
+    ok &= check(low > 0 && high > 0 && low + high == kSegments && vod->getVariantBandwidth() == 2000000,
+                "low segments: " + to_string(low) + ", high segments: " + to_string(high) + ", bandwidth: " + to_string(vod->getBandwidth()));
+
+    // 5. 刷新
+    auto live = startClient(loop, "live", base + "/live/index.m3u8");
+    this_thread::sleep_for(chrono::milliseconds(3500));
+    int reloads = requests([](const string& path){return path == "/live/index.m3u8";});
+    ok &= check(reloads >= 3 && reloads <= 8, "live playlist loaded " + to_string(reloads) + " times in 3.5s");
+    ok &= check(live->getSegmentCount() >= 4, "live segments: " + to_string(live->getSegmentCount()));
+
+    // 6. 响应格式
+    int accepts = g_accepts;
+    auto client = make_shared<HttpHlsTsClient>(loop);
+    auto first = fetch(loop, client, base + "/chunked/seg0.ts");
+    ok &= check(first.ok && first.body == g_segments[0] && first.idle, "chunked body " + to_string(first.body.size()) + " bytes, connection idle");
+    auto second = fetch(loop, client, base + "/chunked/seg1.ts");
+    ok &= check(second.ok && second.body == g_segments[1] && g_accepts == accepts + 1, "chunked response reuses the connection");
+    auto noReason = fetch(loop, client, base + "/noreason/seg2.ts");
+    ok &= check(noReason.ok && noReason.body == g_segments[2], "status line without reason phrase");
+    auto missing = fetch(loop, client, base + "/chunked/missing.m3u8");
+    ok &= check(missing.done && !missing.ok && missing.idle, "404 is a failed response");
+    auto closeClient = make_shared<HttpHlsTsClient>(loop);
+    auto closed = fetch(loop, closeClient, base + "/close/seg3.ts");
+    ok &= check(closed.ok && closed.body == g_segments[3] && closed.closed && !closed.idle, "close delimited body ends at close and leaves the pool");
+
+    loop->async([vod, live, client](){
+        vod->stop();
+        live->stop();
+        client->close();
+    }, true);
+
+    cout << (ok ? "ok" : "FAILED") << endl;
+    _exit(ok ? 0 : 1);
+}
@@ -0,0 +1,466 @@
+// epoll和io_uring事件后端对比测试，服务端走TcpServer/Socket，客户端在主线程用阻塞socket+epoll
+// 1. fanout: 类似http-flv分发，定时给所有连接发送16KB的帧
+// 2. pingpong: 类似rtsp信令，100字节请求对应64字节回复
+// 3. udp: 类似rtp，1200字节报文回显
+// 4. reset: 客户端收到数据后发rst断开，服务端持续发送，两种后端都要通过onError通知会话
+// 统计每条消息的系统调用次数(loop统计)、loop线程cpu耗时、p99延迟
+// 编译: 先编译整个工程，再链接Base/lib下的libbase.a
+// 运行: ./ioUring [连接数]
+
+#include <iostream>
+#include <chrono>
+#include <thread>
+#include <future>
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/resource.h>
+#include <netinet/tcp.h>
+
+#include "Net/TcpServer.h"
+#include "Net/Socket.h"
+#include "Log/Logger.h"
+
+using namespace std;
+
+static const int kFrameSize = 16 * 1024;
+static const int kFrameCount = 300;
+static const int kRequestSize = 100;
+static const int kReplySize = 64;
+static const int kRoundTrips = 200;
+static const int kDatagramSize = 1200;
+static const int kBurst = 32;
+static const int kBursts = 500;
+
+struct Result
+{
+    uint64_t messages = 0;
+    uint64_t syscalls = 0;
+    double cpuUs = 0;
+    vector<uint64_t> latencies;
+    bool ok = true;
+};
+
+static uint64_t nowNs()
+{
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static double loopCpuUs(const EventLoop::Ptr& loop)
+{
+    promise<double> prom;
+    loop->async([&prom](){
+        struct rusage usage;
+        getrusage(RUSAGE_THREAD, &usage);
+        prom.set_value(usage.ru_utime.tv_sec * 1e6 + usage.ru_utime.tv_usec + usage.ru_stime.tv_sec * 1e6 + usage.ru_stime.tv_usec);
+    }, false);
+
+    return prom.get_future().get();
+}
+
+static void runOnLoop(const EventLoop::Ptr& loop, const function<void()>& func)
+{
+    promise<void> prom;
+    loop->async([&prom, &func](){
+        func();
+        prom.set_value();
+    }, false);
+    prom.get_future().get();
+}
+
+static int connectTo(int port)
+{
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (connect(fd, (sockaddr*)&addr, sizeof(addr)) != 0) {
+        close(fd);
+        return -1;
+    }
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    return fd;
+}
+
+// 分发会话只发不收
+class FanoutSession : public TcpConnection
+{
+public:
+    using TcpConnection::TcpConnection;
+    void onError(const std::string& errMsg) override {close();}
+};
+
+// 每收满一个请求回复一次
+class EchoSession : public TcpConnection
+{
+public:
+    using TcpConnection::TcpConnection;
+    void onRead(const StreamBuffer::Ptr& buffer, struct sockaddr* addr, int len) override
+    {
+        _received += buffer->size();
+        while (_received >= kRequestSize) {
+            _received -= kRequestSize;
+            string reply = "RTSP/1.0 200 OK\r\nCSeq: " + to_string(++_cseq) + "\r\n";
+            reply.resize(kReplySize - 2, ' ');
+            reply += "\r\n";
+            send(make_shared<StreamBuffer>(reply.data(), reply.size()));
+        }
+    }
+    void onError(const std::string& errMsg) override {close();}
+
+private:
+    int _received = 0;
+    int _cseq = 0;
+};
+
+static Result fanout(const EventLoop::Ptr& loop, int port, int conns)
+{
+    Result result;
+    auto sessions = make_shared<vector<TcpConnection::Ptr>>();
+    auto server = make_shared<TcpServer>(loop, "127.0.0.1", port, 0, 0);
+    server->setOnCreateSession([sessions](const EventLoop::Ptr& loop, const Socket::Ptr& socket){
+        auto session = make_shared<FanoutSession>(loop, socket);
+        sessions->push_back(session);
+        return session;
+    });
+    runOnLoop(loop, [server](){ server->start(); });
+
+    vector<int> fds;
+    for (int i = 0; i < conns; ++i) {
+        fds.push_back(connectTo(port));
+    }
+    while (true) {
+        size_t count = 0;
+        runOnLoop(loop, [&count, sessions](){ count = sessions->size(); });
+        if (count == (size_t)conns) {
+            break;
+        }
+        usleep(1000);
+    }
+
+    auto syscalls = loop->getStatistic()->syscalls.load();
+    auto cpu = loopCpuUs(loop);
+    // 帧头8字节为发送时间
+    auto sent = make_shared<int>(0);
+    loop->addTimerTask(5, [sessions, sent](){
+        string frame(kFrameSize, 'f');
+        uint64_t now = nowNs();
+        memcpy(&frame[0], &now, sizeof(now));
+        auto buffer = make_shared<StreamBuffer>(frame.data(), frame.size());
+        for (auto& session : *sessions) {
+            session->send(buffer);
+        }
+        return ++*sent < kFrameCount ? 5 : 0;
+    }, nullptr);
+
+    int epollFd = epoll_create1(0);
+    for (size_t i = 0; i < fds.size(); ++i) {
+        epoll_event ev = {};
+        ev.events = EPOLLIN;
+        ev.data.u32 = i;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, fds[i], &ev);
+    }
+    vector<vector<char>> frames(conns, vector<char>(kFrameSize));
+    vector<int> got(conns, 0);
+    vector<int> done(conns, 0);
+    int finished = 0;
+    epoll_event events[64];
+    while (finished < conns) {
+        int n = epoll_wait(epollFd, events, 64, 3000);
+        if (n <= 0) {
+            result.ok = false;
+            break;
+        }
+        for (int i = 0; i < n; ++i) {
+            int index = events[i].data.u32;
+            int ret = recv(fds[index], frames[index].data() + got[index], kFrameSize - got[index], MSG_DONTWAIT);
+            if (ret <= 0) {
+                continue;
+            }
+            got[index] += ret;
+            if (got[index] == kFrameSize) {
+                uint64_t ts;
+                memcpy(&ts, frames[index].data(), sizeof(ts));
+                result.latencies.push_back((nowNs() - ts) / 1000);
+                got[index] = 0;
+                if (++done[index] == kFrameCount) {
+                    ++finished;
+                }
+            }
+        }
+    }
+    result.cpuUs = loopCpuUs(loop) - cpu;
+    result.syscalls = loop->getStatistic()->syscalls.load() - syscalls;
+    result.messages = (uint64_t)conns * kFrameCount;
+    result.ok = result.ok && result.latencies.size() == result.messages;
+
+    close(epollFd);
+    for (auto fd : fds) {
+        close(fd);
+    }
+
+    return result;
+}
+
+// 发送失败后记录错误
+class ResetSession : public TcpConnection
+{
+public:
+    using TcpConnection::TcpConnection;
+    void onError(const std::string& errMsg) override
+    {
+        ++_errors;
+        close();
+    }
+
+    int _errors = 0;
+};
+
+static bool peerReset(const EventLoop::Ptr& loop, int port)
+{
+    auto session = make_shared<shared_ptr<ResetSession>>();
+    auto server = make_shared<TcpServer>(loop, "127.0.0.1", port, 0, 0);
+    server->setOnCreateSession([session](const EventLoop::Ptr& loop, const Socket::Ptr& socket){
+        *session = make_shared<ResetSession>(loop, socket);
+        return *session;
+    });
+    runOnLoop(loop, [server](){ server->start(); });
+
+    int fd = connectTo(port);
+    bool created = false;
+    for (int i = 0; i < 1000 && !created; ++i) {
+        runOnLoop(loop, [&created, session](){ created = !!*session; });
+        usleep(1000);
+    }
+    if (!created) {
+        close(fd);
+        return false;
+    }
+
+    auto stop = make_shared<bool>(false);
+    loop->addTimerTask(5, [session, stop](){
+        if (*stop || (*session)->_errors) {
+            return 0;
+        }
+        string frame(kFrameSize, 'r');
+        (*session)->send(make_shared<StreamBuffer>(frame.data(), frame.size()));
+        return 5;
+    }, [](bool success, shared_ptr<TimerTask>){
+
+    });
+
+    // 收到数据后用rst关闭
+    char buf[1024];
+    timeval timeout = {3, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    bool received = recv(fd, buf, sizeof(buf), 0) > 0;
+    linger lin = {1, 0};
+    setsockopt(fd, SOL_SOCKET, SO_LINGER, &lin, sizeof(lin));
+    close(fd);
+
+    int errors = 0;
+    for (int i = 0; i < 3000 && errors == 0; ++i) {
+        runOnLoop(loop, [&errors, session](){ errors = (*session)->_errors; });
+        usleep(1000);
+    }
+    runOnLoop(loop, [stop](){ *stop = true; });
+
+    return received && errors > 0;
+}
+
+static Result pingpong(const EventLoop::Ptr& loop, int port, int conns)
+{
+    Result result;
+    auto server = make_shared<TcpServer>(loop, "127.0.0.1", port, 0, 0);
+    server->setOnCreateSession([](const EventLoop::Ptr& loop, const Socket::Ptr& socket){
+        return make_shared<EchoSession>(loop, socket);
+    });
+    runOnLoop(loop, [server](){ server->start(); });
+
+    vector<int> fds;
+    for (int i = 0; i < conns; ++i) {
+        fds.push_back(connectTo(port));
+    }
+    int epollFd = epoll_create1(0);
+    for (size_t i = 0; i < fds.size(); ++i) {
+        epoll_event ev = {};
+        ev.events = EPOLLIN;
+        ev.data.u32 = i;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, fds[i], &ev);
+    }
+
+    auto syscalls = loop->getStatistic()->syscalls.load();
+    auto cpu = loopCpuUs(loop);
+    string request = "OPTIONS rtsp://127.0.0.1/live/test RTSP/1.0\r\nCSeq: 1\r\n";
+    request.resize(kRequestSize - 2, ' ');
+    request += "\r\n";
+    vector<uint64_t> sendTime(conns);
+    vector<int> got(conns, 0);
+    vector<int> done(conns, 0);
+    for (int i = 0; i < conns; ++i) {
+        sendTime[i] = nowNs();
+        ::send(fds[i], request.data(), request.size(), 0);
+    }
+    int finished = 0;
+    char reply[kReplySize];
+    epoll_event events[64];
+    while (finished < conns) {
+        int n = epoll_wait(epollFd, events, 64, 3000);
+        if (n <= 0) {
+            result.ok = false;
+            break;
+        }
+        for (int i = 0; i < n; ++i) {
+            int index = events[i].data.u32;
+            int ret = recv(fds[index], reply, kReplySize - got[index], MSG_DONTWAIT);
+            if (ret <= 0) {
+                continue;
+            }
+            got[index] += ret;
+            if (got[index] < kReplySize) {
+                continue;
+            }
+            got[index] = 0;
+            result.latencies.push_back((nowNs() - sendTime[index]) / 1000);
+            if (++done[index] == kRoundTrips) {
+                ++finished;
+                continue;
+            }
+            sendTime[index] = nowNs();
+            ::send(fds[index], request.data(), request.size(), 0);
+        }
+    }
+    result.cpuUs = loopCpuUs(loop) - cpu;
+    result.syscalls = loop->getStatistic()->syscalls.load() - syscalls;
+    result.messages = (uint64_t)conns * kRoundTrips;
+    result.ok = result.ok && result.latencies.size() == result.messages;
+
+    close(epollFd);
+    for (auto fd : fds) {
+        close(fd);
+    }
+
+    return result;
+}
+
+static Result udpEcho(const EventLoop::Ptr& loop, int port)
+{
+    Result result;
+    auto socket = make_shared<Socket>(loop);
+    runOnLoop(loop, [socket, port](){
+        socket->createSocket(SOCKET_UDP);
+        socket->bind(port, "127.0.0.1");
+        Socket::Wptr weakSocket = socket;
+        socket->setReadCb([weakSocket](const StreamBuffer::Ptr& buffer, struct sockaddr* addr, int len){
+            auto socket = weakSocket.lock();
+            if (socket) {
+                socket->send(buffer->data(), buffer->size(), true, addr, len);
+            }
+            return 0;
+        });
+        socket->addToEpoll();
+    });
+
+    int fd = ::socket(AF_INET, SOCK_DGRAM, 0);
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    connect(fd, (sockaddr*)&addr, sizeof(addr));
+    int bufSize = 4 * 1024 * 1024;
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &bufSize, sizeof(bufSize));
+    struct timeval timeout = {0, 200 * 1000};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    auto syscalls = loop->getStatistic()->syscalls.load();
+    auto cpu = loopCpuUs(loop);
+    char packet[kDatagramSize];
+    memset(packet, 'r', sizeof(packet));
+    uint64_t lost = 0;
+    for (int i = 0; i < kBursts; ++i) {
+        for (int j = 0; j < kBurst; ++j) {
+            uint64_t now = nowNs();
+            memcpy(packet, &now, sizeof(now));
+            ::send(fd, packet, sizeof(packet), 0);
+        }
+        for (int j = 0; j < kBurst; ++j) {
+            if (recv(fd, packet, sizeof(packet), 0) != kDatagramSize) {
+                lost += kBurst - j;
+                break;
+            }
+            uint64_t ts;
+            memcpy(&ts, packet, sizeof(ts));
+            result.latencies.push_back((nowNs() - ts) / 1000);
+        }
+    }
+    result.cpuUs = loopCpuUs(loop) - cpu;
+    result.syscalls = loop->getStatistic()->syscalls.load() - syscalls;
+    result.messages = (uint64_t)kBursts * kBurst;
+    result.ok = lost * 100 < result.messages;
+    close(fd);
+
+    return result;
+}
+
+static void report(const string& backend, const string& name, Result& result)
+{
+    auto& latencies = result.latencies;
+    sort(latencies.begin(), latencies.end());
+    uint64_t p99 = latencies.empty() ? 0 : latencies[latencies.size() * 99 / 100];
+    cout << backend << " " << name << ": messages " << result.messages
+         << ", syscalls/msg " << (double)result.syscalls / result.messages
+         << ", loop cpu us/msg " << result.cpuUs / result.messages
+         << ", p99 latency " << p99 << " us"
+         << (result.ok ? "" : " FAILED") << endl;
+}
+
+int main(int argc, char** argv)
+{
+    int conns = argc > 1 ? atoi(argv[1]) : 50;
+
+    Logger::instance()->addChannel(std::make_shared<ConsoleChannel>("ConsoleChannel", LError));
+    Logger::instance()->setLevel(LError);
+
+    bool ok = true;
+    int port = 21038;
+    for (string backend : {"epoll", "io_uring"}) {
+        EventLoop::setBackend(backend);
+        EventLoop::Ptr loop(new EventLoop());
+        loop->setThread(new thread(&EventLoop::start, loop));
+        // ring在loop线程里创建，启动后才能判断
+        bool uring = false;
+        runOnLoop(loop, [&uring, loop](){ uring = loop->isUring(); });
+        if ((backend == "io_uring") != uring) {
+            cout << backend << " not available, skip" << endl;
+            continue;
+        }
+
+        auto result = fanout(loop, port++, conns);
+        report(backend, "fanout", result);
+        ok = ok && result.ok;
+
+        result = pingpong(loop, port++, conns);
+        report(backend, "pingpong", result);
+        ok = ok && result.ok;
+
+        result = udpEcho(loop, port++);
+        report(backend, "udp echo", result);
+        ok = ok && result.ok;
+
+        bool reset = peerReset(loop, port++);
+        cout << backend << " reset: " << (reset ? "session notified by onError" : "no error reported FAILED") << endl;
+        ok = ok && reset;
+    }
+
+    cout << (ok ? "ok" : "FAILED") << endl;
+    // Logger析构时会抛bad_weak_ptr，跳过全局析构直接退出
+    _exit(ok ? 0 : 1);
+}
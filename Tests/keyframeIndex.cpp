@@ -0,0 +1,134 @@
+// gop缓存关键帧索引和快速启动测试，每200ms写一个10帧的gop
+// 1. 索引: 只保留gopCacheCount个关键帧，序号和写入时间递增
+// 2. 快速启动: cache从最旧的gop开始，latest从最新的关键帧开始，back从backMs之前最近的关键帧开始
+// 3. 播放参数: startMode和startBackMs的解析
+// 编译: 先编译整个工程，再链接lib/、Base/lib下的静态库
+// 运行: ./keyframeIndex
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <chrono>
+#include <unordered_map>
+#include <unistd.h>
+
+#include "Common/DataQue.h"
+#include "Log/Logger.h"
+
+using namespace std;
+
+static bool g_ok = true;
+
+static void check(bool cond, const string& name)
+{
+    cout << (cond ? "ok     " : "FAILED ") << name << endl;
+    g_ok = g_ok && cond;
+}
+
+using FrameType = shared_ptr<string>;
+
+// 快照里第一个数据是否为关键帧，以及数据个数
+static void firstAndCount(const DataQueSnapshot<FrameType>& snapshot, bool& firstKey, int& count)
+{
+    firstKey = false;
+    count = 0;
+    snapshot.forEach([&](uint64_t seq, bool isKey, const FrameType& data){
+        if (count++ == 0) {
+            firstKey = isKey;
+        }
+    });
+}
+
+static DataQueStartPolicy makePolicy(int mode, uint64_t backMs = 0)
+{
+    DataQueStartPolicy policy;
+    policy.mode = mode;
+    policy.backMs = backMs;
+
+    return policy;
+}
+
+static void testIndex()
+{
+    const int gopFrames = 10;
+    DataQueStorage<FrameType> storage(1000, 3);
+    auto frame = make_shared<string>(100, 'a');
+
+    check(storage.getKeyframeIndex().empty(), "empty storage has no keyframes");
+
+    for (int gop = 0; gop < 5; ++gop) {
+        if (gop > 0) {
+            this_thread::sleep_for(chrono::milliseconds(200));
+        }
+        for (int i = 0; i < gopFrames; ++i) {
+            storage.write(frame, i == 0);
+        }
+    }
+
+    auto index = storage.getKeyframeIndex();
+    check(index.size() == 3, "index keeps gopCacheCount keyframes");
+    if (index.size() != 3) {
+        return ;
+    }
+    check(index[0].seq == 20 && index[1].seq == 30 && index[2].seq == 40, "index seqs are the gop starts");
+    check(index[1].time >= index[0].time + 150 && index[2].time >= index[1].time + 150, "index times follow the writes");
+
+    bool firstKey = false;
+    int count = 0;
+    auto snapshot = storage.snapshot(makePolicy(START_FROM_CACHE));
+    firstAndCount(snapshot, firstKey, count);
+    check(snapshot.beginSeq() == 20 && firstKey && count == 30, "cache starts from the oldest gop");
+
+    snapshot = storage.snapshot(makePolicy(START_FROM_LATEST_KEY));
+    firstAndCount(snapshot, firstKey, count);
+    check(snapshot.beginSeq() == 40 && firstKey && count == 10, "latest starts from the newest keyframe");
+
+    // 三个关键帧分别在约400ms、200ms、0ms之前
+    snapshot = storage.snapshot(makePolicy(START_FROM_BACK_MS, 300));
+    firstAndCount(snapshot, firstKey, count);
+    check(snapshot.beginSeq() == 20 && firstKey && count == 30, "back 300ms starts from the keyframe 400ms ago");
+
+    snapshot = storage.snapshot(makePolicy(START_FROM_BACK_MS, 100));
+    firstAndCount(snapshot, firstKey, count);
+    check(snapshot.beginSeq() == 30 && firstKey && count == 20, "back 100ms starts from the keyframe 200ms ago");
+
+    snapshot = storage.snapshot(makePolicy(START_FROM_BACK_MS, 10000));
+    check(snapshot.beginSeq() == 20, "back beyond the cache starts from the oldest keyframe");
+
+    // 写入后新gop进入索引，最旧的被淘汰
+    for (int i = 0; i < gopFrames; ++i) {
+        storage.write(frame, i == 0);
+    }
+    index = storage.getKeyframeIndex();
+    check(index.size() == 3 && index[0].seq == 30 && index[2].seq == 50, "new gop pushes out the oldest");
+
+    storage.clearCache();
+    check(storage.getKeyframeIndex().empty(), "clearCache empties the index");
+}
+
+static void testParam()
+{
+    DataQueStartPolicy policy;
+    check(!DataQueStartPolicy::parseParam({{"foo", "bar"}}, policy), "no startMode keeps the default");
+
+    check(DataQueStartPolicy::parseParam({{"startMode", "latest"}}, policy)
+          && policy.mode == START_FROM_LATEST_KEY, "startMode=latest");
+    check(DataQueStartPolicy::parseParam({{"startMode", "back"}, {"startBackMs", "1500"}}, policy)
+          && policy.mode == START_FROM_BACK_MS && policy.backMs == 1500, "startMode=back with startBackMs");
+    check(DataQueStartPolicy::parseParam({{"startMode", "cache"}}, policy)
+          && policy.mode == START_FROM_CACHE, "startMode=cache");
+}
+
+int main(int argc, char** argv)
+{
+    Logger::instance()->addChannel(std::make_shared<ConsoleChannel>("ConsoleChannel", LError));
+    Logger::instance()->setLevel(LError);
+
+    testIndex();
+    testParam();
+
+    cout << (g_ok ? "ok" : "FAILED") << endl;
+    _exit(g_ok ? 0 : 1);
+}
@@ -0,0 +1,82 @@
+// loop负载均衡测试，用连接数模拟各loop的负载(空闲loop的运行占比接近0)
+// 1. 放置: 默认策略留在收包的loop，负载策略选最闲的loop，prefer在slack内时留在prefer
+// 2. 迁移: 迁移阈值为0或不是负载策略时不迁移，评分差超过阈值才返回目标loop
+// 编译: 先编译整个工程，再链接lib/、Base/lib下的静态库
+// 运行: ./loopBalance
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <unistd.h>
+
+#include "EventPoller/EventLoopPool.h"
+#include "Log/Logger.h"
+
+using namespace std;
+
+static bool g_ok = true;
+
+static void check(bool cond, const string& name)
+{
+    cout << (cond ? "ok     " : "FAILED ") << name << endl;
+    g_ok = g_ok && cond;
+}
+
+int main(int argc, char** argv)
+{
+    Logger::instance()->addChannel(std::make_shared<ConsoleChannel>("ConsoleChannel", LError));
+    Logger::instance()->setLevel(LError);
+
+    auto pool = EventLoopPool::instance();
+    pool->init(3, 0, false);
+    // 等loop跑起来，算出初始负载
+    this_thread::sleep_for(chrono::milliseconds(300));
+
+    vector<EventLoop::Ptr> loops;
+    pool->for_each_loop([&loops](const EventLoop::Ptr& loop){
+        loops.push_back(loop);
+    });
+
+    // 评分约为 250、0、125
+    loops[0]->addConnection(100);
+    loops[2]->addConnection(50);
+    cout << "score: " << pool->getLoopScore(loops[0]) << " " << pool->getLoopScore(loops[1])
+         << " " << pool->getLoopScore(loops[2]) << endl;
+
+    pool->setBalancePolicy(BALANCE_NONE);
+    check(pool->getLoopForSession(loops[0]) == loops[0], "none policy keeps the receiving loop");
+
+    pool->setBalancePolicy(BALANCE_LOAD);
+    pool->setBalanceSlack(100);
+    check(pool->getLoopForSession(loops[0]) == loops[1], "load policy moves away from the busiest loop");
+    check(pool->getLoopForSession(loops[1]) == loops[1], "load policy keeps the idlest loop");
+    check(pool->getLoopForSession(loops[2]) == loops[1], "load policy moves when outside slack");
+    pool->setBalanceSlack(200);
+    check(pool->getLoopForSession(loops[2]) == loops[2], "load policy keeps prefer within slack");
+
+    pool->setMigrateThreshold(0);
+    check(!pool->getMigrateTarget(loops[0]), "no migration when threshold is 0");
+
+    pool->setMigrateThreshold(200);
+    pool->setBalancePolicy(BALANCE_NONE);
+    check(!pool->getMigrateTarget(loops[0]), "no migration with none policy");
+
+    pool->setBalancePolicy(BALANCE_LOAD);
+    check(pool->getMigrateTarget(loops[0]) == loops[1], "busy loop migrates to the idlest loop");
+    check(!pool->getMigrateTarget(loops[2]), "no migration below threshold");
+    check(!pool->getMigrateTarget(loops[1]), "idlest loop does not migrate");
+
+    pool->setMigrateThreshold(300);
+    check(!pool->getMigrateTarget(loops[0]), "no migration when threshold is above the gap");
+
+    // 迁移一部分连接后差距变小，不再继续迁移，避免来回迁移
+    pool->setMigrateThreshold(200);
+    loops[0]->addConnection(-60);
+    loops[1]->addConnection(60);
+    check(!pool->getMigrateTarget(loops[0]), "no migration after load evens out");
+
+    cout << (g_ok ? "ok" : "FAILED") << endl;
+    _exit(g_ok ? 0 : 1);
+}
@@ -0,0 +1,155 @@
+// 慢回调追踪测试，回调里sleep模拟卡住loop的模块
+// 1. TcpServer的会话按会话类型记录，不再记成Socket.cpp里的addEvent
+// 2. TcpClient按客户端类型记录
+// 3. 其他直接注册读回调的socket按setReadCb的调用位置记录
+// 编译: 先编译整个工程，再链接Base/lib下的libbase.a
+// 运行: ./loopTrace
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <future>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+
+#include "Net/TcpServer.h"
+#include "Net/TcpClient.h"
+#include "Net/Socket.h"
+#include "EventPoller/EventLoopPool.h"
+#include "Log/Logger.h"
+
+using namespace std;
+
+static const int kTcpPort = 19601;
+static const int kUdpPort = 19602;
+static const int kSlowMs = 20;
+
+static bool g_ok = true;
+
+static void check(bool cond, const string& name)
+{
+    cout << (cond ? "ok     " : "FAILED ") << name << endl;
+    g_ok = g_ok && cond;
+}
+
+static void runOnLoop(const EventLoop::Ptr& loop, const function<void()>& func)
+{
+    promise<void> prom;
+    loop->async([&prom, &func](){
+        func();
+        prom.set_value();
+    }, false);
+    prom.get_future().get();
+}
+
+// 收到请求后卡一下再回复
+class SlowSession : public TcpConnection
+{
+public:
+    using TcpConnection::TcpConnection;
+    void onRead(const StreamBuffer::Ptr& buffer, struct sockaddr* addr, int len) override
+    {
+        this_thread::sleep_for(chrono::milliseconds(kSlowMs));
+        send(make_shared<StreamBuffer>(buffer->data(), buffer->size()));
+    }
+    void onError(const std::string& errMsg) override {close();}
+};
+
+class SlowClient : public TcpClient
+{
+public:
+    using TcpClient::TcpClient;
+    void onConnect() override
+    {
+        send(make_shared<StreamBuffer>("ping", 4));
+    }
+    void onRead(const StreamBuffer::Ptr& buffer, struct sockaddr* addr, int len) override
+    {
+        this_thread::sleep_for(chrono::milliseconds(kSlowMs));
+        received = true;
+    }
+
+    atomic<bool> received{false};
+};
+
+static bool hasSite(const vector<SlowCallbackInfo>& top, const string& site)
+{
+    for (auto& info : top) {
+        if (info.type == "event" && info.site == site) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+int main(int argc, char** argv)
+{
+    Logger::instance()->addChannel(std::make_shared<ConsoleChannel>("ConsoleChannel", LError));
+    Logger::instance()->setLevel(LError);
+    EventLoopPool::instance()->init(1, true, false);
+    auto loop = EventLoopPool::instance()->getLoopByCircle();
+    auto stat = loop->getStatistic();
+    stat->slowTracer.setThreshold(kSlowMs * 1000 / 2);
+
+    auto server = make_shared<TcpServer>(loop, "127.0.0.1", kTcpPort, 0, 0);
+    server->setOnCreateSession([](const EventLoop::Ptr& loop, const Socket::Ptr& socket){
+        return make_shared<SlowSession>(loop, socket);
+    });
+    runOnLoop(loop, [server](){ server->start(); });
+
+    shared_ptr<SlowClient> client;
+    runOnLoop(loop, [&client, loop](){
+        client = make_shared<SlowClient>(loop);
+        client->create("127.0.0.1");
+        client->connect("127.0.0.1", kTcpPort);
+    });
+
+    auto udpSocket = make_shared<Socket>(loop);
+    int udpLine = 0;
+    runOnLoop(loop, [&udpSocket, &udpLine](){
+        udpSocket->createSocket(SOCKET_UDP);
+        udpSocket->bind(kUdpPort, "127.0.0.1");
+        udpSocket->addToEpoll();
+        auto onUdp = [](const StreamBuffer::Ptr& buffer, struct sockaddr* addr, int len){
+            this_thread::sleep_for(chrono::milliseconds(kSlowMs));
+            return 0;
+        };
+        udpLine = __LINE__ + 1;
+        udpSocket->setReadCb(onUdp);
+    });
+
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(kUdpPort);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    sendto(fd, "rtp", 3, 0, (sockaddr*)&addr, sizeof(addr));
+    close(fd);
+
+    for (int i = 0; i < 100 && !client->received; ++i) {
+        this_thread::sleep_for(chrono::milliseconds(20));
+    }
+    this_thread::sleep_for(chrono::milliseconds(100));
+    check(client->received, "client got the reply");
+
+    auto top = stat->slowTracer.getTop();
+    for (auto& info : top) {
+        cout << info.type << " " << info.site << " " << info.duration << "us" << endl;
+    }
+    bool socketSite = false;
+    for (auto& info : top) {
+        socketSite = socketSite || info.site.find("Socket.cpp") != string::npos;
+    }
+    check(hasSite(top, "SlowSession"), "server session reported by its type");
+    check(hasSite(top, "SlowClient"), "tcp client reported by its type");
+    string udpSite = string(__FILE__) + ":" + to_string(udpLine);
+    check(hasSite(top, udpSite), "udp socket reported at its setReadCb call, " + udpSite);
+    check(!socketSite, "no slow callback reported at Socket.cpp");
+
+    cout << (g_ok ? "ok" : "FAILED") << endl;
+    _exit(g_ok ? 0 : 1);
+}
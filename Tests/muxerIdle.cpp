@@ -0,0 +1,447 @@
+// 转协议源空闲回收测试，每路流用一个帧源当源站(和点播文件一样)，按25fps、2秒gop喂h264帧
+// 每路流先有一个rtmp播放者看一会儿(模拟巡检)，之后只有少数流一直有人看
+// 1. 回收: 没人看的流的rtmp源在muxerIdleTime后释放，帧源再过muxerIdleTime释放，有人看的流不受影响
+// 2. 资源: 分别在子进程里跑回收(muxerIdleTime=1000)和不回收(muxerIdleTime很大)，统计稳定后的cpu和rss
+// 3. 暖启动: rtmp源回收后再来播放者，第一个包就是关键帧，不用等下一个gop
+// 4. 直接挂在帧源上的reader(录像、转码这类，不是sink)还在时帧源不回收，reader走了才回收
+// 编译: 先编译整个工程，再链接lib/、Base/lib下的静态库
+// 运行: ./muxerIdle [流数] [一直有人看的百分比]
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <functional>
+#include <cstdlib>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+
+#include "Common/FrameMediaSource.h"
+#include "Common/Config.h"
+#include "Common/Define.h"
+#include "Codec/H264Track.h"
+#include "Codec/H264Frame.h"
+#include "Rtmp/RtmpMediaSource.h"
+#include "EventPoller/EventLoopPool.h"
+#include "Util/TimeClock.h"
+#include "Log/Logger.h"
+
+using namespace std;
+
+static const int kFrameMs = 40;
+static const int kGopFrames = 50;
+static const int kLingerMs = 1000;
+
+// 假的nalu，只有nal头和first_mb_in_slice是对的，rtmp转封装不解析内容
+static const string kSps = string("\x67\x42\xc0\x1e\xda\x02\x80\xbf\xe5\x84\x00\x00\x03\x00\x04\x00\x00\x03\x00\xca\x3c\x58\xb9\x20", 24);
+static const string kPps = string("\x68\xce\x3c\x80", 4);
+
+// 源站，帧源没有sink时会当成点播文件释放掉，这里和推流一样没人看也一直在
+class Origin : public FrameMediaSource
+{
+public:
+    using Ptr = shared_ptr<Origin>;
+
+    Origin(const UrlParser& urlParser, const EventLoop::Ptr& loop)
+        :FrameMediaSource(urlParser, loop)
+    {}
+
+    void delSink(const MediaSource::Ptr& sink) override
+    {
+        MediaSource::delSink(sink);
+        getRing()->delOnWrite(sink.get());
+    }
+};
+
+class Stream
+{
+public:
+    using Ptr = shared_ptr<Stream>;
+
+    string path;
+    EventLoop::Ptr loop;
+    Origin::Ptr origin;
+    uint64_t index = 0;
+    atomic<bool> stop{false};
+};
+
+class Player
+{
+public:
+    using Ptr = shared_ptr<Player>;
+
+    Stream::Ptr stream;
+    RtmpMediaSource::Wptr source;
+    RtmpMediaSource::RingType::DataQueReaderT::Ptr reader;
+    uint64_t start = 0;
+    atomic<uint64_t> firstKey{0};
+    atomic<bool> firstIsKey{false};
+    atomic<uint64_t> packets{0};
+};
+
+// 直接读帧源的reader，不是帧源的sink
+class FrameViewer
+{
+public:
+    using Ptr = shared_ptr<FrameViewer>;
+
+    Stream::Ptr stream;
+    FrameMediaSource::Wptr source;
+    MediaSource::FrameRingType::DataQueReaderT::Ptr reader;
+    atomic<uint64_t> frames{0};
+};
+
+static FrameBuffer::Ptr createNalu(const string& nalu, uint64_t stamp)
+{
+    auto frame = H264Frame::createFrame(4, 0, true);
+    frame->_trackType = VideoTrackType;
+    frame->_buffer.append(nalu.data(), nalu.size());
+    frame->_pts = frame->_dts = stamp;
+
+    return frame;
+}
+
+static string randomSlice(uint8_t nalHeader, size_t size)
+{
+    string nalu(size, '\0');
+    for (size_t i = 0; i < size; ++i) {
+        nalu[i] = (char)rand();
+    }
+    nalu[0] = (char)nalHeader;
+    // first_mb_in_slice = 0，新的一帧
+    nalu[1] = (char)0x88;
+
+    return nalu;
+}
+
+static string g_idr;
+static string g_p;
+
+static void feed(const Stream::Ptr& stream)
+{
+    weak_ptr<Stream> wStream = stream;
+    stream->loop->addTimerTask(kFrameMs, [wStream]() -> uint64_t {
+        auto stream = wStream.lock();
+        if (!stream || stream->stop) {
+            return 0;
+        }
+        uint64_t stamp = stream->index * kFrameMs;
+        if (stream->index % kGopFrames == 0) {
+            stream->origin->onFrame(createNalu(kSps, stamp));
+            stream->origin->onFrame(createNalu(kPps, stamp));
+            stream->origin->onFrame(createNalu(g_idr, stamp));
+        } else {
+            stream->origin->onFrame(createNalu(g_p, stamp));
+        }
+        ++stream->index;
+
+        return kFrameMs;
+    }, nullptr);
+}
+
+static Stream::Ptr createStream(int i)
+{
+    auto stream = make_shared<Stream>();
+    stream->path = "/live/cam" + to_string(i);
+    stream->loop = EventLoopPool::instance()->getLoopByCircle();
+
+    UrlParser parser;
+    parser.path_ = stream->path;
+    parser.vhost_ = DEFAULT_VHOST;
+    parser.protocol_ = PROTOCOL_FRAME;
+    parser.type_ = DEFAULT_TYPE;
+    auto loop = stream->loop;
+    auto source = MediaSource::getOrCreate(parser.path_, parser.vhost_, parser.protocol_, parser.type_, [parser, loop](){
+        return make_shared<Origin>(parser, loop);
+    });
+    stream->origin = dynamic_pointer_cast<Origin>(source);
+    stream->origin->setOrigin();
+    loop->async([stream](){
+        stream->origin->addTrack(H264Track::createTrack(0, 96, 90000));
+        feed(stream);
+    }, false);
+
+    return stream;
+}
+
+static Player::Ptr play(const Stream::Ptr& stream)
+{
+    auto player = make_shared<Player>();
+    player->stream = stream;
+    player->start = TimeClock::now();
+    auto loop = stream->loop;
+    loop->async([player, loop](){
+        UrlParser parser;
+        parser.path_ = player->stream->path;
+        parser.vhost_ = DEFAULT_VHOST;
+        parser.protocol_ = PROTOCOL_RTMP;
+        parser.type_ = DEFAULT_TYPE;
+        MediaSource::getOrCreateAsync(parser.path_, parser.vhost_, parser.protocol_, parser.type_,
+        [player, loop](const MediaSource::Ptr& src){
+            loop->async([player, loop, src](){
+                auto rtmpSrc = dynamic_pointer_cast<RtmpMediaSource>(src);
+                if (!rtmpSrc || !rtmpSrc->getRing()) {
+                    return ;
+                }
+                player->source = rtmpSrc;
+                player->reader = rtmpSrc->getRing()->attach(loop, true);
+                Player* ptr = player.get();
+                player->reader->setReadCB([ptr](const RtmpMediaSource::RingDataType& pktList){
+                    if (pktList->empty()) {
+                        return ;
+                    }
+                    if (ptr->packets++ == 0) {
+                        ptr->firstIsKey = pktList->front()->isKeyFrame();
+                    }
+                    if (!ptr->firstKey && pktList->front()->isKeyFrame()) {
+                        ptr->firstKey = TimeClock::now();
+                    }
+                });
+            }, true);
+        },
+        [parser]() -> MediaSource::Ptr {
+            return make_shared<RtmpMediaSource>(parser, nullptr, true);
+        }, player.get());
+    }, false);
+
+    return player;
+}
+
+// 在转协议用的帧源上挂一个reader，帧源要先由rtmp播放者建出来
+static FrameViewer::Ptr watchFrames(const Stream::Ptr& stream)
+{
+    auto viewer = make_shared<FrameViewer>();
+    viewer->stream = stream;
+    auto loop = stream->loop;
+    loop->async([viewer, loop](){
+        auto muxerSource = viewer->stream->origin->getMuxerSource();
+        auto frameSrc = dynamic_pointer_cast<FrameMediaSource>(muxerSource[PROTOCOL_FRAME][DEFAULT_TYPE].lock());
+        if (!frameSrc || !frameSrc->getRing()) {
+            return ;
+        }
+        viewer->source = frameSrc;
+        viewer->reader = frameSrc->getRing()->attach(loop, true);
+        FrameViewer* ptr = viewer.get();
+        viewer->reader->setReadCB([ptr](const MediaSource::FrameRingDataType&){
+            ++ptr->frames;
+        });
+    }, false);
+
+    return viewer;
+}
+
+static void stopWatch(const FrameViewer::Ptr& viewer)
+{
+    viewer->stream->loop->async([viewer](){
+        viewer->reader = nullptr;
+    }, false);
+}
+
+static void stopPlay(const Player::Ptr& player)
+{
+    player->stream->loop->async([player](){
+        player->reader = nullptr;
+        auto src = player->source.lock();
+        if (src) {
+            src->delConnection(player.get());
+        }
+    }, false);
+}
+
+// 活着的rtmp源和帧源个数
+static void countSources(const vector<Stream::Ptr>& streams, int& rtmpCount, int& frameCount)
+{
+    rtmpCount = 0;
+    frameCount = 0;
+    for (auto& stream : streams) {
+        for (auto& protocol : stream->origin->getMuxerSource()) {
+            for (auto& type : protocol.second) {
+                if (!type.second.lock()) {
+                    continue;
+                }
+                if (protocol.first == PROTOCOL_RTMP) {
+                    ++rtmpCount;
+                } else if (protocol.first == PROTOCOL_FRAME) {
+                    ++frameCount;
+                }
+            }
+        }
+    }
+}
+
+static uint64_t cpuUs()
+{
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec * 1000000ULL + usage.ru_utime.tv_usec
+           + usage.ru_stime.tv_sec * 1000000ULL + usage.ru_stime.tv_usec;
+}
+
+static long rssKB()
+{
+    long pages = 0;
+    long resident = 0;
+    FILE* fp = fopen("/proc/self/statm", "r");
+    if (fp) {
+        if (fscanf(fp, "%ld %ld", &pages, &resident) != 2) {
+            resident = 0;
+        }
+        fclose(fp);
+    }
+
+    return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+static bool check(bool cond, const string& name)
+{
+    cout << (cond ? "ok     " : "FAILED ") << name << endl;
+    return cond;
+}
+
+static void sleepMs(int ms)
+{
+    this_thread::sleep_for(chrono::milliseconds(ms));
+}
+
+// 子进程里跑一种模式，idleTime为转协议源的空闲回收时间
+static bool run(const string& name, int idleTime, int streamCount, int watchPercent)
+{
+    Config::instance()->set(idleTime, "Util", "muxerIdleTime");
+    EventLoopPool::instance()->init(4, true, false);
+    sleepMs(100);
+
+    vector<Stream::Ptr> streams;
+    for (int i = 0; i < streamCount; ++i) {
+        streams.push_back(createStream(i));
+    }
+    // 等源站就绪
+    sleepMs(1000);
+
+    vector<Player::Ptr> players;
+    for (auto& stream : streams) {
+        players.push_back(play(stream));
+    }
+    sleepMs(2000);
+
+    bool ok = true;
+    int rtmpCount = 0;
+    int frameCount = 0;
+    int played = 0;
+    for (auto& player : players) {
+        played += player->packets > 0;
+    }
+    ok &= check(played == streamCount, name + ": all streams played, " + to_string(played) + "/" + to_string(streamCount));
+
+    int watched = max(streamCount * watchPercent / 100, 1);
+    for (int i = watched; i < streamCount; ++i) {
+        stopPlay(players[i]);
+    }
+    // 转协议源和帧源先后各空闲计时一次
+    sleepMs(idleTime < 10000 ? idleTime * 2 + 1000 : 3000);
+
+    countSources(streams, rtmpCount, frameCount);
+    bool reclaim = idleTime < 10000;
+    ok &= check(reclaim ? rtmpCount == watched && frameCount == watched
+                        : rtmpCount == streamCount && frameCount == streamCount,
+                name + ": live rtmp sources " + to_string(rtmpCount) + ", frame sources " + to_string(frameCount));
+
+    uint64_t watchedPackets = 0;
+    for (int i = 0; i < watched; ++i) {
+        watchedPackets += players[i]->packets;
+    }
+
+    auto startCpu = cpuUs();
+    auto startTime = TimeClock::now();
+    sleepMs(5000);
+    double cpu = (cpuUs() - startCpu) / 10.0 / (TimeClock::now() - startTime);
+    cout << name << ": " << streamCount << " streams, " << watched << " watched, cpu " << cpu << "%, rss "
+         << rssKB() / 1024 << "MB" << endl;
+
+    uint64_t packets = 0;
+    for (int i = 0; i < watched; ++i) {
+        packets += players[i]->packets;
+    }
+    ok &= check(packets > watchedPackets, name + ": watched streams keep playing");
+
+    if (reclaim) {
+        // 帧源也回收以后的新播放者，源站回放缓存的gop
+        auto cold = play(streams[streamCount - 1]);
+        sleepMs(500);
+        ok &= check(cold->firstKey && cold->firstIsKey && cold->firstKey - cold->start < 200,
+                    name + ": first packet after reclaim is a keyframe, " + to_string(cold->firstKey - cold->start) + "ms");
+
+        // rtmp源回收后帧源还在空闲计时内，新的rtmp源从帧源缓存的gop开始
+        auto warm = play(streams[streamCount - 2]);
+        sleepMs(200);
+        stopPlay(warm);
+        sleepMs(idleTime + 300);
+        countSources(streams, rtmpCount, frameCount);
+        // 有人看的、cold的rtmp源，加上还在空闲计时的帧源
+        ok &= check(rtmpCount == watched + 1 && frameCount == watched + 2,
+                    name + ": rtmp source reclaimed, frame source lingering");
+        auto again = play(streams[streamCount - 2]);
+        sleepMs(500);
+        ok &= check(again->firstKey && again->firstIsKey && again->firstKey - again->start < 200,
+                    name + ": warm start from lingering frame source, " + to_string(again->firstKey - again->start) + "ms");
+        stopPlay(cold);
+        stopPlay(again);
+
+        // rtmp播放者走后，帧源上只剩一个不是sink的reader
+        auto holder = play(streams[streamCount - 3]);
+        sleepMs(500);
+        auto viewer = watchFrames(streams[streamCount - 3]);
+        sleepMs(200);
+        stopPlay(holder);
+        sleepMs(idleTime * 2 + 500);
+        uint64_t frames = viewer->frames;
+        sleepMs(500);
+        ok &= check(viewer->source.lock() && frames > 0 && viewer->frames > frames,
+                    name + ": frame source with a non-sink reader is kept, " + to_string(viewer->frames) + " frames");
+        stopWatch(viewer);
+        sleepMs(idleTime * 2 + 500);
+        ok &= check(!viewer->source.lock(), name + ": frame source reclaimed after the reader leaves");
+    }
+
+    for (auto& stream : streams) {
+        stream->stop = true;
+    }
+
+    return ok;
+}
+
+static bool runInChild(const string& name, int idleTime, int streamCount, int watchPercent)
+{
+    cout.flush();
+    pid_t pid = fork();
+    if (pid == 0) {
+        bool ok = run(name, idleTime, streamCount, watchPercent);
+        cout.flush();
+        _exit(ok ? 0 : 1);
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+int main(int argc, char** argv)
+{
+    int streamCount = argc > 1 ? atoi(argv[1]) : 300;
+    int watchPercent = argc > 2 ? atoi(argv[2]) : 3;
+
+    Logger::instance()->addChannel(std::make_shared<ConsoleChannel>("ConsoleChannel", LError));
+    Logger::instance()->setLevel(LError);
+    srand(1);
+    // 2秒gop，约2Mbps
+    g_idr = randomSlice(0x65, 40000);
+    g_p = randomSlice(0x41, 9000);
+
+    bool ok = runInChild("keep idle muxers", 3600000, streamCount, watchPercent);
+    ok &= runInChild("reclaim idle muxers", kLingerMs, streamCount, watchPercent);
+
+    cout << (ok ? "ok" : "FAILED") << endl;
+    _exit(ok ? 0 : 1);
+}
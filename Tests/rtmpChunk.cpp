@@ -0,0 +1,244 @@
+// rtmp chunk解析测试，按推流端的格式拼chunk流，再按各种大小切开喂给RtmpChunk::parse
+// 1. 正确性: 音视频两个csid交错、扩展时间戳、3字节basic header的csid，任意切分下重组出的消息都和原始的一样
+// 2. 拷贝次数: 消息体只从socket数据拷一次到payload，暂存的只有跨两次读的chunk头，统计暂存字节占比
+// 3. 吞吐: 模拟5Mbps推流60秒的数据量，按1400和64K两种读大小喂入，统计解析速度
+// 编译: 先编译整个工程，再链接lib/、Base/lib下的静态库
+// 运行: ./rtmpChunk
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+
+#include "Rtmp/Rtmp.h"
+#include "Rtmp/RtmpChunk.h"
+#include "Log/Logger.h"
+
+using namespace std;
+
+static const uint32_t kChunkSize = 4096;
+
+static bool g_ok = true;
+
+static void check(bool cond, const string& name)
+{
+    cout << (cond ? "ok     " : "FAILED ") << name << endl;
+    g_ok = g_ok && cond;
+}
+
+struct Message
+{
+    uint32_t csid;
+    uint8_t typeId;
+    uint32_t timestamp;
+    string payload;
+};
+
+static void basicHeader(string& out, uint8_t fmt, uint32_t csid)
+{
+    if (csid >= 64 + 256) {
+        out.push_back((char)(fmt << 6 | 1));
+        out.push_back((char)((csid - 64) & 0xff));
+        out.push_back((char)((csid - 64) >> 8));
+    } else if (csid >= 64) {
+        out.push_back((char)(fmt << 6));
+        out.push_back((char)(csid - 64));
+    } else {
+        out.push_back((char)(fmt << 6 | csid));
+    }
+}
+
+static void uint24(string& out, uint32_t value)
+{
+    out.push_back((char)(value >> 16));
+    out.push_back((char)(value >> 8));
+    out.push_back((char)value);
+}
+
+static void uint32(string& out, uint32_t value)
+{
+    out.push_back((char)(value >> 24));
+    uint24(out, value);
+}
+
+static void appendChunk(string& out, const Message& msg, size_t offset)
+{
+    bool ext = msg.timestamp >= 0xffffff;
+    if (offset == 0) {
+        basicHeader(out, 0, msg.csid);
+        uint24(out, ext ? 0xffffff : msg.timestamp);
+        uint24(out, msg.payload.size());
+        out.push_back((char)msg.typeId);
+        out.append("\x01\x00\x00\x00", 4);
+    } else {
+        basicHeader(out, 3, msg.csid);
+    }
+    if (ext) {
+        uint32(out, msg.timestamp);
+    }
+    out.append(msg.payload, offset, min((size_t)kChunkSize, msg.payload.size() - offset));
+}
+
+// 和RtmpChunk::createChunk一样: 第一个chunk用fmt0，后面的用fmt3，扩展时间戳每个chunk都带
+// 每两个消息的chunk交错发送，检查按csid分别重组
+static string serialize(const vector<Message>& msgs)
+{
+    string out;
+    for (size_t i = 0; i < msgs.size(); i += 2) {
+        size_t end = min(i + 2, msgs.size());
+        for (size_t offset = 0; ; offset += kChunkSize) {
+            bool more = false;
+            for (size_t j = i; j < end; ++j) {
+                if (offset < msgs[j].payload.size()) {
+                    appendChunk(out, msgs[j], offset);
+                    more = true;
+                }
+            }
+            if (!more) {
+                break;
+            }
+        }
+    }
+
+    return out;
+}
+
+static string randomPayload(size_t size)
+{
+    string payload(size, '\0');
+    for (auto& c : payload) {
+        c = (char)rand();
+    }
+
+    return payload;
+}
+
+// 按切分函数把数据切开喂进去，返回解析出的消息
+template <typename Slicer>
+static vector<Message> feed(const string& stream, const Slicer& slicer, uint64_t& staged)
+{
+    vector<Message> out;
+    RtmpChunk chunk;
+    chunk.setInChunkSize(kChunkSize);
+    chunk.setOnRtmpChunk([&out](const RtmpMessage msg){
+        out.push_back({msg.csid, msg.type_id, (uint32_t)msg.abs_timestamp, string(msg.payload->data(), msg.length)});
+    });
+
+    size_t offset = 0;
+    while (offset < stream.size()) {
+        size_t len = min(slicer(), stream.size() - offset);
+        auto buffer = make_shared<StreamBuffer>(stream.data() + offset, len);
+        chunk.parse(buffer);
+        offset += len;
+    }
+    staged = chunk.getStagedBytes();
+
+    return out;
+}
+
+static bool same(const vector<Message>& a, const vector<Message>& b)
+{
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (a[i].csid != b[i].csid || a[i].typeId != b[i].typeId
+            || a[i].timestamp != b[i].timestamp || a[i].payload != b[i].payload) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// 按完成顺序排，交错发送时短消息先完成
+static vector<Message> completeOrder(const vector<Message>& msgs)
+{
+    vector<Message> out;
+    for (size_t i = 0; i < msgs.size(); i += 2) {
+        if (i + 1 < msgs.size() && (msgs[i + 1].payload.size() + kChunkSize - 1) / kChunkSize
+                                     < (msgs[i].payload.size() + kChunkSize - 1) / kChunkSize) {
+            out.push_back(msgs[i + 1]);
+            out.push_back(msgs[i]);
+        } else {
+            out.push_back(msgs[i]);
+            if (i + 1 < msgs.size()) {
+                out.push_back(msgs[i + 1]);
+            }
+        }
+    }
+
+    return out;
+}
+
+static void testCorrectness()
+{
+    vector<Message> msgs;
+    uint32_t stamp = 0;
+    for (int i = 0; i < 200; ++i) {
+        // 视频大小不一，有的跨好几个chunk；音频小包
+        msgs.push_back({RTMP_CHUNK_VIDEO_ID, RTMP_VIDEO, stamp, randomPayload(i % 25 == 0 ? 60000 : 500 + rand() % 12000)});
+        msgs.push_back({RTMP_CHUNK_AUDIO_ID, RTMP_AUDIO, stamp, randomPayload(200 + rand() % 300)});
+        stamp += 40;
+    }
+    // 扩展时间戳和两种长度的basic header
+    msgs.push_back({RTMP_CHUNK_VIDEO_ID, RTMP_VIDEO, 0x1000000, randomPayload(10000)});
+    msgs.push_back({100, RTMP_NOTIFY, 0x1000000, randomPayload(300)});
+    msgs.push_back({1000, RTMP_VIDEO, 5000, randomPayload(9000)});
+    msgs.push_back({RTMP_CHUNK_AUDIO_ID, RTMP_AUDIO, 5000, randomPayload(100)});
+
+    auto stream = serialize(msgs);
+    auto expect = completeOrder(msgs);
+    uint64_t staged = 0;
+
+    check(same(feed(stream, [&stream](){return stream.size();}, staged), expect), "whole stream in one read");
+    check(same(feed(stream, [](){return (size_t)1;}, staged), expect), "one byte per read");
+    check(same(feed(stream, [](){return (size_t)7;}, staged), expect), "seven bytes per read");
+    check(same(feed(stream, [](){return (size_t)(1 + rand() % 3000);}, staged), expect), "random reads");
+    check(same(feed(stream, [](){return (size_t)1400;}, staged), expect), "1400 bytes per read");
+    cout << "staged " << staged << " of " << stream.size() << " bytes with 1400 byte reads" << endl;
+    // 每次读最多暂存一个chunk头
+    check(staged <= (stream.size() / 1400 + 1) * 18, "only chunk headers are staged");
+}
+
+static void testThroughput()
+{
+    // 5Mbps，25帧，60秒，每秒一个大的关键帧
+    vector<Message> msgs;
+    uint32_t stamp = 0;
+    for (int i = 0; i < 25 * 60; ++i) {
+        size_t size = i % 25 == 0 ? 120000 : 20000;
+        msgs.push_back({RTMP_CHUNK_VIDEO_ID, RTMP_VIDEO, stamp, randomPayload(size)});
+        msgs.push_back({RTMP_CHUNK_AUDIO_ID, RTMP_AUDIO, stamp, randomPayload(400)});
+        stamp += 40;
+    }
+    auto stream = serialize(msgs);
+    auto expect = completeOrder(msgs);
+
+    for (size_t readSize : {(size_t)1400, (size_t)65536}) {
+        uint64_t staged = 0;
+        auto start = chrono::steady_clock::now();
+        auto out = feed(stream, [readSize](){return readSize;}, staged);
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        cout << "read " << readSize << ": " << stream.size() / 1024 / 1024 << "MB in " << seconds << "s, "
+             << (int)(stream.size() / seconds / 1024 / 1024) << "MB/s, staged " << staged << " bytes ("
+             << staged * 100.0 / stream.size() << "%)" << endl;
+        check(same(out, expect), "throughput stream with " + to_string(readSize) + " byte reads");
+    }
+}
+
+int main(int argc, char** argv)
+{
+    Logger::instance()->addChannel(std::make_shared<ConsoleChannel>("ConsoleChannel", LError));
+    Logger::instance()->setLevel(LError);
+    srand(1);
+
+    testCorrectness();
+    testThroughput();
+
+    cout << (g_ok ? "ok" : "FAILED") << endl;
+    _exit(g_ok ? 0 : 1);
+}
@@ -0,0 +1,300 @@
+// RtpSort单元测试和性能对比
+// 用例: seq回绕、重复包、突发丢包、迟到包、超时跳过，没有新包时由loop上的定时器跳过
+// 性能: 与原来map+set实现的RtpSort对比1%和5%乱序下的耗时
+// 编译: 先编译整个工程，再链接lib/下的静态库；工程默认不开优化，RtpSort.cpp需要和本文件一起按-O2编译
+// 运行: ./rtpSort [轮数]
+
+#include <iostream>
+#include <chrono>
+#include <thread>
+#include <future>
+#include <vector>
+#include <map>
+#include <set>
+#include <cassert>
+#include <cstdlib>
+#include <unistd.h>
+#include <arpa/inet.h>
+
+#include "Rtp/RtpSort.h"
+#include "EventPoller/EventLoopPool.h"
+
+using namespace std;
+
+static RtpPacket::Ptr makeRtp(uint16_t seq)
+{
+    auto buffer = StreamBuffer::create();
+    buffer->setCapacity(RtpPacket::kRtpHeaderSize + 1);
+    buffer->setSize(RtpPacket::kRtpHeaderSize);
+    auto data = (uint8_t*)buffer->data();
+    memset(data, 0, RtpPacket::kRtpHeaderSize);
+    data[0] = 0x80;
+    data[2] = seq >> 8;
+    data[3] = seq & 0xFF;
+
+    return make_shared<RtpPacket>(buffer);
+}
+
+// 原来的实现，只用于性能对比
+struct LegacyCompare {
+    bool operator()(const uint16_t& l, const uint16_t& r)const
+    {
+        static constexpr uint16_t SEQ_MAX = (std::numeric_limits<uint16_t>::max)();
+        static constexpr uint16_t kBreakpoint = SEQ_MAX >> 1 + 1;
+
+        if (l - r == kBreakpoint) {
+            return l > r;
+        }
+
+        return l != r && static_cast<uint16_t>(l - r) > kBreakpoint;
+    }
+};
+
+class LegacyRtpSort
+{
+public:
+    LegacyRtpSort(int maxQueSize) :_maxQueSize(maxQueSize) {}
+
+    void inputRtp(const RtpPacket::Ptr& rtp)
+    {
+        if (_firstRtp) {
+            _firstRtp = false;
+            onRtpPacket(rtp);
+            _lastRtpSeq = rtp->getSeq();
+            return ;
+        }
+
+        uint16_t curSeq = _lastRtpSeq + 1;
+        if (rtp->getSeq() != curSeq) {
+            if (_setSeq.find(rtp->getSeq()) == _setSeq.end()) {
+                _mapRtp.emplace(rtp->getSeq(), rtp);
+                _setSeq.emplace(rtp->getSeq());
+            }
+        } else {
+            onRtpPacket(rtp);
+            _lastRtpSeq = rtp->getSeq();
+        }
+
+        while (!_mapRtp.empty()) {
+            auto iter = _mapRtp.begin();
+            auto rtpSend = iter->second;
+            if ((_mapRtp.size() >= _maxQueSize) || rtpSend->getSeq() == (uint16_t)(_lastRtpSeq + 1)) {
+                _lastRtpSeq = rtpSend->getSeq();
+                onRtpPacket(rtpSend);
+                _setSeq.erase(iter->first);
+                _mapRtp.erase(iter);
+            } else {
+                break;
+            }
+        }
+    }
+
+    void onRtpPacket(const RtpPacket::Ptr& rtp)
+    {
+        if (_onRtpPacket) {
+            _onRtpPacket(rtp);
+        }
+    }
+
+    function<void(const RtpPacket::Ptr& rtp)> _onRtpPacket;
+
+private:
+    bool _firstRtp = true;
+    uint16_t _lastRtpSeq = -1;
+    int _maxQueSize;
+    set<uint16_t> _setSeq;
+    map<uint16_t, RtpPacket::Ptr, LegacyCompare> _mapRtp;
+};
+
+static vector<uint16_t> feed(RtpSort& sort, const vector<uint16_t>& seqs, uint64_t now = 1)
+{
+    vector<uint16_t> out;
+    sort.setOnRtpPacket([&out](const RtpPacket::Ptr& rtp){
+        out.push_back(rtp->getSeq());
+    });
+    for (auto seq : seqs) {
+        sort.inputRtp(makeRtp(seq), now);
+    }
+
+    return out;
+}
+
+static void testWrap()
+{
+    RtpSort sort(64);
+    auto out = feed(sort, {65533, 65535, 65534, 1, 0, 2});
+    assert((out == vector<uint16_t>{65533, 65534, 65535, 0, 1, 2}));
+    assert(sort.getStatistics().reordered == 2);
+    assert(sort.getStatistics().lost == 0);
+}
+
+static void testDuplicate()
+{
+    RtpSort sort(64);
+    auto out = feed(sort, {10, 12, 12, 11, 11, 10, 13});
+    assert((out == vector<uint16_t>{10, 11, 12, 13}));
+    assert(sort.getStatistics().duplicate == 1);
+    assert(sort.getStatistics().late == 2);
+}
+
+static void testBurstLoss()
+{
+    // 20..29整段丢失，超出窗口后跳过
+    RtpSort sort(16);
+    vector<uint16_t> seqs;
+    for (uint16_t seq = 0; seq < 20; ++seq) {
+        seqs.push_back(seq);
+    }
+    for (uint16_t seq = 30; seq < 60; ++seq) {
+        seqs.push_back(seq);
+    }
+    auto out = feed(sort, seqs);
+    sort.flush();
+    assert(out.size() == 50);
+    for (size_t i = 1; i < out.size(); ++i) {
+        assert((int16_t)(out[i] - out[i - 1]) > 0);
+    }
+    assert(sort.getStatistics().lost == 10);
+}
+
+static void testLateArrival()
+{
+    RtpSort sort(64, 100);
+    vector<uint16_t> out;
+    sort.setOnRtpPacket([&out](const RtpPacket::Ptr& rtp){
+        out.push_back(rtp->getSeq());
+    });
+    sort.inputRtp(makeRtp(100), 1000);
+    sort.inputRtp(makeRtp(102), 1000);
+    sort.inputRtp(makeRtp(103), 1050);
+    // 等待中，还有nack的机会
+    assert(out.size() == 1);
+    assert((sort.getLossSeq() == vector<uint16_t>{101}));
+    sort.inputRtp(makeRtp(104), 1100);
+    // 超时，跳过101
+    assert((out == vector<uint16_t>{100, 102, 103, 104}));
+    assert(sort.getStatistics().lost == 1);
+    // 101迟到，丢弃
+    sort.inputRtp(makeRtp(101), 1110);
+    assert(out.size() == 4);
+    assert(sort.getStatistics().late == 1);
+}
+
+static void testWaitWithoutInput()
+{
+    RtpSort sort(64, 100);
+    vector<uint16_t> out;
+    sort.setOnRtpPacket([&out](const RtpPacket::Ptr& rtp){
+        out.push_back(rtp->getSeq());
+    });
+    sort.inputRtp(makeRtp(100), 1000);
+    sort.inputRtp(makeRtp(102), 1000);
+    sort.inputRtp(makeRtp(103), 1010);
+    sort.checkWait(1050);
+    assert(out.size() == 1);
+    // 之后不再有包到达，定时检查也要跳过101
+    sort.checkWait(1100);
+    assert((out == vector<uint16_t>{100, 102, 103}));
+    assert(sort.getStatistics().lost == 1);
+    sort.checkWait(1300);
+    assert(out.size() == 3);
+}
+
+static void testWaitTimer()
+{
+    EventLoopPool::instance()->init(1, 0, false);
+    auto loop = EventLoopPool::instance()->getLoopByCircle();
+    auto sort = make_shared<RtpSort>(64, 100);
+    auto out = make_shared<vector<uint16_t>>();
+    sort->setOnRtpPacket([out](const RtpPacket::Ptr& rtp){
+        out->push_back(rtp->getSeq());
+    });
+    loop->async([sort, loop](){
+        sort->startTimer(loop);
+        sort->inputRtp(makeRtp(100));
+        sort->inputRtp(makeRtp(102));
+    }, true);
+    this_thread::sleep_for(chrono::milliseconds(300));
+
+    // 在loop线程上取结果
+    auto size = make_shared<promise<size_t>>();
+    loop->async([out, size](){
+        size->set_value(out->size());
+    }, true);
+    assert(size->get_future().get() == 2);
+}
+
+static vector<uint16_t> makeSeqs(int reorderPercent)
+{
+    // 正好一轮seq，重复输入时seq自然回绕
+    int count = 65536;
+    vector<uint16_t> seqs;
+    for (int i = 0; i < count; ++i) {
+        seqs.push_back(i);
+    }
+    // 相邻的包随机交换，距离1~3
+    for (int i = 0; i + 4 < count; ++i) {
+        if (rand() % 100 < reorderPercent) {
+            swap(seqs[i], seqs[i + 1 + rand() % 3]);
+        }
+    }
+
+    return seqs;
+}
+
+template <typename Sort>
+static double bench(Sort& sort, const vector<RtpPacket::Ptr>& rtps, int rounds)
+{
+    size_t out = 0;
+    sort._onRtpPacket = [&out](const RtpPacket::Ptr& rtp){ ++out; };
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < rounds; ++i) {
+        for (auto& rtp : rtps) {
+            sort.inputRtp(rtp);
+        }
+    }
+    double ns = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+
+    return ns / rtps.size() / rounds;
+}
+
+struct RingSort
+{
+    RingSort() :sort(256, 100)
+    {
+        sort.setOnRtpPacket([this](const RtpPacket::Ptr& rtp){ _onRtpPacket(rtp); });
+    }
+    void inputRtp(const RtpPacket::Ptr& rtp) {sort.inputRtp(rtp);}
+
+    RtpSort sort;
+    function<void(const RtpPacket::Ptr& rtp)> _onRtpPacket;
+};
+
+int main(int argc, char** argv)
+{
+    testWrap();
+    testDuplicate();
+    testBurstLoss();
+    testLateArrival();
+    testWaitWithoutInput();
+    testWaitTimer();
+    cout << "unit tests passed" << endl;
+
+    int rounds = argc > 1 ? atoi(argv[1]) : 20;
+    srand(1);
+    for (int percent : {1, 5}) {
+        auto seqs = makeSeqs(percent);
+        vector<RtpPacket::Ptr> rtps;
+        for (auto seq : seqs) {
+            rtps.push_back(makeRtp(seq));
+        }
+        LegacyRtpSort legacy(256);
+        RingSort ring;
+        double legacyNs = bench(legacy, rtps, rounds);
+        double ringNs = bench(ring, rtps, rounds);
+        cout << percent << "% reorder: map+set " << legacyNs << " ns/pkt, ring " << ringNs << " ns/pkt" << endl;
+    }
+
+    // Logger析构时会抛bad_weak_ptr，跳过全局析构直接退出
+    _exit(0);
+}
@@ -0,0 +1,333 @@
+// rtsp组播测试，开启IP_MULTICAST_LOOP后在本机回环网卡上收组播
+// 1. 共享: 多个观众加入同一个流，分到同一个组播地址和端口，PLAY之前不发送，每个包只发送一次，所有接收端都能收到
+// 2. sr: 每5秒在rtcp端口发送一次sr，源端口为rtp端口+1
+// 3. 暂停: 所有观众PAUSE后停止发送，再次PLAY后恢复
+// 4. 引用计数: 观众全部离开后停止发送，地址和端口归还到池里，再次加入时重新分配
+// 5. 隔离: 不同的流分到不同的组播地址
+// 6. 启动失败: rtcp端口被占用时PLAY失败，在播放的观众收到通知，已创建的socket被关闭
+// 编译: 先编译整个工程，再链接lib/下的静态库(libcommon需要--whole-archive)
+// 运行: ./rtspMulticast
+
+#include <iostream>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <functional>
+#include <unistd.h>
+#include <fcntl.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+
+#include "Rtsp/RtspMulticast.h"
+#include "Rtsp/RtspMediaSource.h"
+#include "Rtp/RtpPacket.h"
+#include "Common/Config.h"
+#include "Common/Define.h"
+#include "EventPoller/EventLoopPool.h"
+#include "Log/Logger.h"
+
+using namespace std;
+
+static const int kViewers = 3;
+static const int kPackets = 50;
+static const int kPayloadSize = 200;
+
+class FakeTrack : public RtspTrack
+{
+public:
+    using Ptr = shared_ptr<FakeTrack>;
+
+    FakeTrack()
+    {
+        _trackInfo = make_shared<TrackInfo>();
+        _trackInfo->index_ = 0;
+        _trackInfo->trackType_ = "audio";
+        _trackInfo->samplerate_ = 8000;
+        _trackInfo->payloadType_ = 0;
+        _ssrc = 0x1234;
+    }
+
+    void setOnRtpPacket(const function<void(const RtpPacket::Ptr& rtp, bool start)>& cb) override {_onRtpPacket = cb;}
+    void onRtpPacket(const RtpPacket::Ptr& rtp, bool start) override
+    {
+        if (_onRtpPacket) {
+            _onRtpPacket(rtp, start);
+        }
+    }
+    shared_ptr<TrackInfo> getTrackInfo() override {return _trackInfo;}
+    int getTrackIndex() override {return 0;}
+
+private:
+    shared_ptr<TrackInfo> _trackInfo;
+    function<void(const RtpPacket::Ptr& rtp, bool start)> _onRtpPacket;
+};
+
+// 加入组播的接收端，组播地址和端口可以被多个socket同时绑定
+static int joinGroup(const string& group, int port)
+{
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    int on = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on));
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = inet_addr(group.data());
+    if (bind(fd, (sockaddr*)&addr, sizeof(addr)) != 0) {
+        close(fd);
+        return -1;
+    }
+    ip_mreq mreq = {};
+    mreq.imr_multiaddr.s_addr = inet_addr(group.data());
+    mreq.imr_interface.s_addr = htonl(INADDR_LOOPBACK);
+    if (setsockopt(fd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) != 0) {
+        close(fd);
+        return -1;
+    }
+    fcntl(fd, F_SETFL, O_NONBLOCK);
+    return fd;
+}
+
+// 收完socket里所有的包，返回包数，srcPort为最后一个包的源端口
+static int drain(int fd, int& bytes, int* srcPort = nullptr)
+{
+    int count = 0;
+    char buf[2048];
+    while (true) {
+        sockaddr_in addr = {};
+        socklen_t len = sizeof(addr);
+        int n = recvfrom(fd, buf, sizeof(buf), 0, (sockaddr*)&addr, &len);
+        if (n <= 0) {
+            break;
+        }
+        bytes += n;
+        ++count;
+        if (srcPort) {
+            *srcPort = ntohs(addr.sin_port);
+        }
+    }
+    return count;
+}
+
+static bool waitFor(const function<bool()>& pred, int ms)
+{
+    auto deadline = chrono::steady_clock::now() + chrono::milliseconds(ms);
+    while (!pred()) {
+        if (chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        this_thread::sleep_for(chrono::milliseconds(10));
+    }
+    return true;
+}
+
+// 在loop里同步执行
+static void runIn(const EventLoop::Ptr& loop, const function<void()>& func)
+{
+    atomic<bool> done{false};
+    loop->async([&](){
+        func();
+        done = true;
+    }, true);
+    while (!done) {
+        this_thread::sleep_for(chrono::milliseconds(1));
+    }
+}
+
+static RtspMediaSource::Ptr createSource(const string& path, const EventLoop::Ptr& loop, FakeTrack::Ptr& track)
+{
+    UrlParser parser;
+    parser.path_ = path;
+    parser.vhost_ = "default";
+    parser.type_ = "default";
+    parser.protocol_ = PROTOCOL_RTSP;
+    RtspMediaSource::Ptr source;
+    runIn(loop, [&](){
+        source = make_shared<RtspMediaSource>(parser, loop);
+        track = make_shared<FakeTrack>();
+        source->addTrack(track);
+    });
+    return source;
+}
+
+static void sendPackets(const EventLoop::Ptr& loop, const FakeTrack::Ptr& track, int count)
+{
+    static uint16_t seq = 0;
+    runIn(loop, [&](){
+        for (int i = 0; i < count; ++i) {
+            // 每个包都带mark，写入一次环形缓存
+            auto rtp = RtpPacket::create(track->getTrackInfo(), kPayloadSize + 12, seq * 20, track->getSsrc(), seq, true);
+            ++seq;
+            track->onRtpPacket(rtp, i == 0);
+        }
+    });
+}
+
+static bool check(bool ok, const string& msg)
+{
+    cout << (ok ? "[ok] " : "[FAILED] ") << msg << endl;
+    return ok;
+}
+
+int main(int argc, char** argv)
+{
+    Logger::instance()->addChannel(std::make_shared<ConsoleChannel>("ConsoleChannel", LError));
+    Logger::instance()->setLevel(LError);
+    EventLoopPool::instance()->init(2, true, false);
+
+    Config::instance()->setAndUpdate("127.0.0.1", "Rtsp", "Server", "Server1", "multicastInterface");
+    Config::instance()->setAndUpdate(true, "Rtsp", "Server", "Server1", "multicastLoop");
+    Config::instance()->setAndUpdate(1, "Rtsp", "Server", "Server1", "multicastTtl");
+    Config::instance()->setAndUpdate(31000, "Rtsp", "Server", "Server1", "multicastPortMin");
+    Config::instance()->setAndUpdate(31100, "Rtsp", "Server", "Server1", "multicastPortMax");
+
+    auto loop = EventLoopPool::instance()->getLoopByCircle();
+    FakeTrack::Ptr track;
+    auto source = createSource("/live/multicast", loop, track);
+
+    bool ok = true;
+
+    // 1. 共享
+    vector<RtspMulticast::Ptr> viewers;
+    vector<int> keys(kViewers);
+    for (int i = 0; i < kViewers; ++i) {
+        auto viewerLoop = EventLoopPool::instance()->getLoopByCircle();
+        viewers.push_back(RtspMulticast::join(source, viewerLoop, &keys[i], nullptr));
+    }
+    bool shared = viewers[0] != nullptr;
+    for (auto& viewer : viewers) {
+        shared &= viewer == viewers[0];
+    }
+    ok &= check(shared && viewers[0]->getViewerCount() == kViewers, "viewers share one sender");
+    if (!shared) {
+        cout << "FAILED" << endl;
+        _exit(1);
+    }
+    auto multicast = viewers[0];
+    string group = multicast->getGroup();
+    int port = multicast->getRtpPort(0);
+    ok &= check(IN_MULTICAST(ntohl(inet_addr(group.data()))) && port >= 31000 && port % 2 == 0, "group: " + group + ", port: " + to_string(port));
+
+    vector<int> rtpFds, rtcpFds;
+    for (int i = 0; i < kViewers; ++i) {
+        rtpFds.push_back(joinGroup(group, port));
+        rtcpFds.push_back(joinGroup(group, port + 1));
+    }
+    sendPackets(loop, track, 5);
+    this_thread::sleep_for(chrono::milliseconds(100));
+    int tmp = 0;
+    ok &= check(drain(rtpFds[0], tmp) == 0 && multicast->getSendBytes() == 0, "nothing is sent before PLAY");
+
+    bool played = true;
+    for (int i = 0; i < kViewers; ++i) {
+        played &= multicast->play(&keys[i]);
+    }
+    ok &= check(played, "play");
+    // PLAY后读取器从缓存开始发送，PLAY之前写入的包也会发出
+    int expected = kPackets + 5;
+    // 等读取器挂上环形缓存
+    this_thread::sleep_for(chrono::milliseconds(100));
+    sendPackets(loop, track, kPackets);
+
+    vector<int> received(kViewers, 0);
+    int bytes = 0;
+    waitFor([&](){
+        bool all = true;
+        for (int i = 0; i < kViewers; ++i) {
+            received[i] += drain(rtpFds[i], bytes);
+            all &= received[i] >= expected;
+        }
+        return all;
+    }, 2000);
+    bool allReceived = true;
+    for (int i = 0; i < kViewers; ++i) {
+        allReceived &= received[i] == expected;
+    }
+    ok &= check(allReceived, "every receiver got " + to_string(received[0]) + "/" + to_string(expected));
+    ok &= check(multicast->getSendBytes() == (uint64_t)expected * (kPayloadSize + 12 + 4), "sent each packet once, bytes: " + to_string(multicast->getSendBytes()));
+
+    // 2. sr
+    int rtcpBytes = 0;
+    int srPort = 0;
+    bool gotSr = waitFor([&](){
+        return drain(rtcpFds[0], rtcpBytes, &srPort) > 0;
+    }, 6000);
+    ok &= check(gotSr && rtcpBytes > 0, "sender report on rtcp port");
+    ok &= check(srPort == port + 1, "sender report comes from rtp port + 1: " + to_string(srPort));
+
+    // 3. 暂停
+    for (int i = 0; i < kViewers; ++i) {
+        multicast->pause(&keys[i]);
+    }
+    this_thread::sleep_for(chrono::milliseconds(100));
+    uint64_t pausedBytes = multicast->getSendBytes();
+    sendPackets(loop, track, 5);
+    this_thread::sleep_for(chrono::milliseconds(100));
+    tmp = 0;
+    ok &= check(drain(rtpFds[0], tmp) == 0 && multicast->getSendBytes() == pausedBytes, "stop sending when every viewer paused");
+
+    multicast->play(&keys[2]);
+    this_thread::sleep_for(chrono::milliseconds(100));
+    sendPackets(loop, track, 1);
+    ok &= check(waitFor([&](){return drain(rtpFds[0], tmp) > 0;}, 1000), "resume sending after PLAY");
+
+    // 4. 引用计数
+    multicast->leave(&keys[0]);
+    multicast->leave(&keys[1]);
+    ok &= check(multicast->getViewerCount() == 1, "still sending with one viewer");
+    sendPackets(loop, track, 1);
+    tmp = 0;
+    ok &= check(waitFor([&](){return drain(rtpFds[2], tmp) > 0;}, 1000), "last viewer still receives");
+
+    multicast->leave(&keys[2]);
+    this_thread::sleep_for(chrono::milliseconds(100));
+    uint64_t sent = multicast->getSendBytes();
+    sendPackets(loop, track, 5);
+    this_thread::sleep_for(chrono::milliseconds(100));
+    tmp = 0;
+    ok &= check(drain(rtpFds[2], tmp) == 0 && multicast->getSendBytes() == sent, "stop sending after all viewers left");
+
+    int key = 0;
+    auto again = RtspMulticast::join(source, loop, &key, nullptr);
+    ok &= check(again && again != multicast, "rejoin creates a new sender");
+
+    // 5. 隔离
+    FakeTrack::Ptr otherTrack;
+    auto other = createSource("/live/other", loop, otherTrack);
+    int otherKey = 0;
+    auto otherMulticast = RtspMulticast::join(other, loop, &otherKey, nullptr);
+    ok &= check(otherMulticast && otherMulticast->getGroup() != again->getGroup()
+                && otherMulticast->getRtpPort(0) != again->getRtpPort(0), "streams get different groups");
+    again->leave(&key);
+    otherMulticast->leave(&otherKey);
+
+    // 6. 启动失败，占住rtcp端口(不设置reuse)
+    int failKey = 0;
+    atomic<int> detached{0};
+    auto failed = RtspMulticast::join(source, loop, &failKey, [&detached](){ ++detached; });
+    int blocker = socket(AF_INET, SOCK_DGRAM, 0);
+    sockaddr_in blockAddr = {};
+    blockAddr.sin_family = AF_INET;
+    blockAddr.sin_port = htons(failed->getRtpPort(0) + 1);
+    blockAddr.sin_addr.s_addr = inet_addr(failed->getGroup().data());
+    bool blocked = bind(blocker, (sockaddr*)&blockAddr, sizeof(blockAddr)) == 0;
+    played = true;
+    runIn(loop, [&](){ played = failed->play(&failKey); });
+    ok &= check(blocked && !played && detached == 1, "play fails and notifies the viewer when the rtcp port is taken");
+    sendPackets(loop, track, 5);
+    this_thread::sleep_for(chrono::milliseconds(100));
+    ok &= check(failed->getSendBytes() == 0, "failed sender does not send");
+    failed->leave(&failKey);
+    close(blocker);
+
+    for (int fd : rtpFds) {
+        close(fd);
+    }
+    for (int fd : rtcpFds) {
+        close(fd);
+    }
+
+    cout << (ok ? "ok" : "FAILED") << endl;
+    _exit(ok ? 0 : 1);
+}
@@ -0,0 +1,284 @@
+// gb28181 sip注册/保活风暴测试
+// 1. 本地起sip udp服务，每个设备一个udp socket，先REGISTER收到401，带digest鉴权再REGISTER收到200，统计每秒注册数
+// 2. 每个设备发多轮保活，统计每秒保活数，检查都收到200
+// 3. nonce不对时重新挑战，密码错误收到403，未注册设备的保活默认交给上下文处理，打开rejectUnregisteredKeepalive时收到403
+// 4. 注册信息落盘后重新加载，设备仍是已注册状态；清掉上下文(模拟重启)后保活直接恢复，不用重新注册
+// 编译: 打开ENABLE_PROJECT_GB2818SIP编译整个工程，再链接GB28181SIP/lib下的libgb28181Sip.a和lib、Base/lib下的库
+// 运行: ./sipStorm [设备数] [线程数]
+
+#include <iostream>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <string>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+
+#include "EventPoller/EventLoopPool.h"
+#include "Common/Config.h"
+#include "Log/Logger.h"
+#include "Util/MD5.h"
+#include "GB28181SIP/GB28181SIPServer.h"
+#include "GB28181SIP/GB28181SIPManager.h"
+#include "GB28181SIP/GB28181SIPRegistrar.h"
+
+using namespace std;
+
+static const int kPort = 25060;
+static const int kKeepaliveRounds = 10;
+static const char* kServerId = "34020000002000000001";
+static const char* kRealm = "3402000000";
+static const char* kPassword = "12345678";
+static const char* kRegistryFile = "/tmp/sipStormRegistry.json";
+
+struct Device
+{
+    int fd = -1;
+    int port = 0;
+    string id;
+    string nonce;
+    int cseq = 1;
+};
+
+static int createSocket(int& port)
+{
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+    bind(fd, (sockaddr*)&addr, sizeof(addr));
+
+    socklen_t len = sizeof(addr);
+    getsockname(fd, (sockaddr*)&addr, &len);
+    port = ntohs(addr.sin_port);
+
+    sockaddr_in server = {};
+    server.sin_family = AF_INET;
+    server.sin_port = htons(kPort);
+    server.sin_addr.s_addr = inet_addr("127.0.0.1");
+    connect(fd, (sockaddr*)&server, sizeof(server));
+
+    timeval tv = {2, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    int buf = 1024 * 1024;
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &buf, sizeof(buf));
+
+    return fd;
+}
+
+static string md5Hex(const string& text)
+{
+    return MD5(text).hexdigest();
+}
+
+static string registerMsg(Device& device, bool auth, const string& password = kPassword)
+{
+    string uri = string("sip:") + kServerId + "@" + kRealm;
+    string msg = "REGISTER " + uri + " SIP/2.0\r\n"
+        "Via: SIP/2.0/UDP 127.0.0.1:" + to_string(device.port) + ";rport;branch=z9hG4bK" + to_string(device.cseq) + "\r\n"
+        "From: <sip:" + device.id + "@" + kRealm + ">;tag=" + to_string(device.port) + "\r\n"
+        "To: <sip:" + device.id + "@" + kRealm + ">\r\n"
+        "Call-ID: reg" + device.id + "\r\n"
+        "CSeq: " + to_string(device.cseq++) + " REGISTER\r\n"
+        "Contact: <sip:" + device.id + "@127.0.0.1:" + to_string(device.port) + ">\r\n"
+        "Max-Forwards: 70\r\n"
+        "Expires: 3600\r\n";
+
+    if (auth) {
+        string ha1 = md5Hex(device.id + ":" + kRealm + ":" + password);
+        string ha2 = md5Hex("REGISTER:" + uri);
+        string response = md5Hex(ha1 + ":" + device.nonce + ":00000001:abcdef:auth:" + ha2);
+        msg += "Authorization: Digest username=\"" + device.id + "\",realm=\"" + kRealm + "\",nonce=\"" + device.nonce
+            + "\",uri=\"" + uri + "\",response=\"" + response + "\",algorithm=MD5,qop=auth,nc=00000001,cnonce=\"abcdef\"\r\n";
+    }
+    msg += "Content-Length: 0\r\n\r\n";
+
+    return msg;
+}
+
+static string keepaliveMsg(Device& device)
+{
+    string body = "<?xml version=\"1.0\" encoding=\"GB2312\"?>\r\n"
+        "<Notify>\r\n<CmdType>Keepalive</CmdType>\r\n<SN>" + to_string(device.cseq) + "</SN>\r\n"
+        "<DeviceID>" + device.id + "</DeviceID>\r\n<Status>OK</Status>\r\n</Notify>\r\n";
+
+    return string("MESSAGE sip:") + kServerId + "@" + kRealm + " SIP/2.0\r\n"
+        "Via: SIP/2.0/UDP 127.0.0.1:" + to_string(device.port) + ";rport;branch=z9hG4bK" + to_string(device.cseq) + "\r\n"
+        "From: <sip:" + device.id + "@" + kRealm + ">;tag=" + to_string(device.port) + "\r\n"
+        "To: <sip:" + kServerId + "@" + kRealm + ">\r\n"
+        "Call-ID: ka" + device.id + to_string(device.cseq) + "\r\n"
+        "CSeq: " + to_string(device.cseq++) + " MESSAGE\r\n"
+        "Content-Type: Application/MANSCDP+xml\r\n"
+        "Max-Forwards: 70\r\n"
+        "Content-Length: " + to_string(body.size()) + "\r\n\r\n" + body;
+}
+
+static string recvStatus(Device& device, string* nonce = nullptr)
+{
+    char buf[2048];
+    int len = recv(device.fd, buf, sizeof(buf) - 1, 0);
+    if (len <= 0) {
+        return "timeout";
+    }
+    buf[len] = '\0';
+
+    string msg(buf, len);
+    if (nonce) {
+        auto pos = msg.find("nonce=\"");
+        if (pos != string::npos) {
+            pos += 7;
+            *nonce = msg.substr(pos, msg.find('"', pos) - pos);
+        }
+    }
+
+    return msg.substr(8, 3);
+}
+
+// 每个线程负责一部分设备，多个线程同时收发
+template <typename Func>
+static double runStorm(vector<Device>& devices, int threads, const Func& func)
+{
+    auto start = chrono::steady_clock::now();
+    vector<thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&devices, &func, t, threads](){
+            for (size_t i = t; i < devices.size(); i += threads) {
+                func(devices[i]);
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char** argv)
+{
+    int deviceCount = argc > 1 ? atoi(argv[1]) : 2000;
+    int threads = argc > 2 ? atoi(argv[2]) : 4;
+
+    Logger::instance()->addChannel(std::make_shared<ConsoleChannel>("ConsoleChannel", LError));
+    Logger::instance()->setLevel(LError);
+    EventLoopPool::instance()->init(threads, true, false);
+
+    unlink(kRegistryFile);
+    Config::instance()->set(kRealm, "SipServer", "Server", "realm");
+    Config::instance()->set(kPassword, "SipServer", "Server", "password");
+    Config::instance()->set(kRegistryFile, "GB28181", "Sip", "registryFile");
+    GB28181SIPServer::instance()->start("127.0.0.1", kPort, threads, 2);
+    this_thread::sleep_for(chrono::milliseconds(200));
+
+    vector<Device> devices(deviceCount);
+    for (int i = 0; i < deviceCount; ++i) {
+        devices[i].fd = createSocket(devices[i].port);
+        devices[i].id = to_string(34020000001320000000ULL + i);
+    }
+
+    bool ok = true;
+
+    // 注册：401挑战 + 带鉴权的200
+    atomic<int> registered{0};
+    double regSeconds = runStorm(devices, threads, [&registered](Device& device){
+        string msg = registerMsg(device, false);
+        send(device.fd, msg.data(), msg.size(), 0);
+        if (recvStatus(device, &device.nonce) != "401") {
+            return ;
+        }
+        msg = registerMsg(device, true);
+        send(device.fd, msg.data(), msg.size(), 0);
+        if (recvStatus(device) == "200") {
+            ++registered;
+        }
+    });
+    cout << "register: " << registered << "/" << deviceCount << " in " << regSeconds << "s, "
+         << (int)(registered / regSeconds) << " registrations/s" << endl;
+    ok = ok && registered == deviceCount;
+
+    // nonce不对时重新挑战，密码错误回403
+    Device bad;
+    bad.fd = createSocket(bad.port);
+    bad.id = "34020000001329999999";
+    string msg = registerMsg(bad, false);
+    send(bad.fd, msg.data(), msg.size(), 0);
+    recvStatus(bad, &bad.nonce);
+    bad.nonce += "0";
+    msg = registerMsg(bad, true);
+    send(bad.fd, msg.data(), msg.size(), 0);
+    string status = recvStatus(bad, &bad.nonce);
+    cout << "register with stale nonce: " << status << endl;
+    ok = ok && status == "401";
+    msg = registerMsg(bad, true, "wrong");
+    send(bad.fd, msg.data(), msg.size(), 0);
+    status = recvStatus(bad);
+    cout << "register with wrong password: " << status << endl;
+    ok = ok && status == "403";
+
+    // 保活：每轮先给所有设备发完再收
+    atomic<int> alive{0};
+    double kaSeconds = runStorm(devices, threads, [&alive](Device& device){
+        for (int round = 0; round < kKeepaliveRounds; ++round) {
+            string msg = keepaliveMsg(device);
+            send(device.fd, msg.data(), msg.size(), 0);
+        }
+        for (int round = 0; round < kKeepaliveRounds; ++round) {
+            if (recvStatus(device) == "200") {
+                ++alive;
+            }
+        }
+    });
+    int total = deviceCount * kKeepaliveRounds;
+    cout << "keepalive: " << alive << "/" << total << " in " << kaSeconds << "s, "
+         << (int)(alive / kaSeconds) << " keepalives/s, fast path "
+         << GB28181SIPManager::instance()->getKeepaliveCount() << endl;
+    ok = ok && alive == total && GB28181SIPManager::instance()->getKeepaliveCount() >= (uint64_t)total;
+    ok = ok && GB28181SIPManager::instance()->getContextCount() >= (size_t)deviceCount;
+
+    // 默认未注册设备的保活交给上下文处理，不在快速路径上回复
+    Config::instance()->setAndUpdate(0, "GB28181", "Sip", "rejectUnregisteredKeepalive");
+    auto keepaliveCount = GB28181SIPManager::instance()->getKeepaliveCount();
+    msg = keepaliveMsg(bad);
+    send(bad.fd, msg.data(), msg.size(), 0);
+    status = recvStatus(bad);
+    cout << "keepalive from unregistered device, reject off: " << status << endl;
+    ok = ok && status != "403" && GB28181SIPManager::instance()->getKeepaliveCount() == keepaliveCount;
+
+    // 打开rejectUnregisteredKeepalive后未注册的设备保活回403
+    Config::instance()->setAndUpdate(1, "GB28181", "Sip", "rejectUnregisteredKeepalive");
+    msg = keepaliveMsg(bad);
+    send(bad.fd, msg.data(), msg.size(), 0);
+    status = recvStatus(bad);
+    cout << "keepalive from unregistered device: " << status << endl;
+    ok = ok && status == "403";
+
+    // 落盘后重新加载
+    ok = ok && GB28181SIPRegistrar::instance()->save(kRegistryFile);
+    auto restored = make_shared<GB28181SIPRegistrar>();
+    restored->load(kRegistryFile);
+    cout << "restored registrations: " << restored->getRegistrationCount() << endl;
+    ok = ok && restored->getRegistrationCount() == (size_t)deviceCount && restored->isRegistered(devices[0].id);
+
+    // 模拟重启丢了上下文，设备换了端口发保活，直接恢复
+    GB28181SIPManager::instance()->delContext(devices[0].id);
+    ::close(devices[0].fd);
+    devices[0].fd = createSocket(devices[0].port);
+    msg = keepaliveMsg(devices[0]);
+    send(devices[0].fd, msg.data(), msg.size(), 0);
+    status = recvStatus(devices[0]);
+    cout << "keepalive after restart: " << status << endl;
+    ok = ok && status == "200" && GB28181SIPManager::instance()->getContext(devices[0].id);
+
+    for (auto& device : devices) {
+        ::close(device.fd);
+    }
+    ::close(bad.fd);
+    unlink(kRegistryFile);
+
+    cout << (ok ? "ok" : "FAILED") << endl;
+    // Logger析构时会抛bad_weak_ptr，跳过全局析构直接退出
+    _exit(ok ? 0 : 1);
+}
@@ -0,0 +1,333 @@
+// 关键帧截图测试，用libx264把合成的320x240画面编成gop为25的h264，喂给帧源
+// 1. 截图: 默认源分辨率的jpeg，只给宽度时按源宽高比算高度，webp也能编码
+// 2. 缓存: 同一个gop内的并发请求只解码一次，同一尺寸只编码一次
+// 3. 来了新的关键帧后重新解码；流不存在时抛异常
+// 编译: cmake -DENABLE_FFMPEG=ON -DENABLE_PROJECT_SNAPSHOT=ON，ffmpeg需要带libx264和libwebp
+// 运行: ./snapshot
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <future>
+#include <thread>
+#include <chrono>
+#include <unistd.h>
+
+#include "Ffmpeg/Snapshot.h"
+#include "Common/FrameMediaSource.h"
+#include "Common/Define.h"
+#include "Codec/H264Track.h"
+#include "Codec/H264Frame.h"
+#include "EventPoller/EventLoopPool.h"
+#include "WorkPoller/WorkLoopPool.h"
+#include "Log/Logger.h"
+
+extern "C" {
+#include <libavutil/opt.h>
+}
+
+using namespace std;
+
+static const string kPath = "/live/snapshot";
+static const int kWidth = 320;
+static const int kHeight = 240;
+static const int kGop = 25;
+
+static bool g_ok = true;
+
+static void check(bool cond, const string& name)
+{
+    cout << (cond ? "ok     " : "FAILED ") << name << endl;
+    g_ok = g_ok && cond;
+}
+
+// 帧源没有sink时会当成点播文件释放掉，这里和推流一样一直在
+class Origin : public FrameMediaSource
+{
+public:
+    using Ptr = shared_ptr<Origin>;
+
+    Origin(const UrlParser& urlParser, const EventLoop::Ptr& loop)
+        :FrameMediaSource(urlParser, loop)
+    {}
+
+    void delSink(const MediaSource::Ptr& sink) override
+    {
+        MediaSource::delSink(sink);
+        getRing()->delOnWrite(sink.get());
+    }
+};
+
+// 生成输入码流，每个包是一帧annexb数据
+static vector<string> encodeSource(int frames)
+{
+    vector<string> packets;
+    auto codec = avcodec_find_encoder_by_name("libx264");
+    if (!codec) {
+        return packets;
+    }
+
+    auto ctx = avcodec_alloc_context3(codec);
+    ctx->width = kWidth;
+    ctx->height = kHeight;
+    ctx->time_base = (AVRational){1, 25};
+    ctx->framerate = (AVRational){25, 1};
+    ctx->pix_fmt = AV_PIX_FMT_YUV420P;
+    ctx->gop_size = kGop;
+    ctx->max_b_frames = 0;
+    av_opt_set(ctx->priv_data, "preset", "ultrafast", 0);
+    av_opt_set(ctx->priv_data, "x264-params", "scenecut=0", 0);
+    if (avcodec_open2(ctx, codec, NULL) < 0) {
+        avcodec_free_context(&ctx);
+        return packets;
+    }
+
+    auto frame = av_frame_alloc();
+    frame->format = AV_PIX_FMT_YUV420P;
+    frame->width = kWidth;
+    frame->height = kHeight;
+    av_frame_get_buffer(frame, 0);
+    auto pkt = av_packet_alloc();
+
+    auto receive = [&](){
+        while (avcodec_receive_packet(ctx, pkt) >= 0) {
+            packets.emplace_back((char*)pkt->data, pkt->size);
+            av_packet_unref(pkt);
+        }
+    };
+
+    for (int i = 0; i < frames; ++i) {
+        av_frame_make_writable(frame);
+        for (int y = 0; y < kHeight; ++y) {
+            for (int x = 0; x < kWidth; ++x) {
+                frame->data[0][y * frame->linesize[0] + x] = (uint8_t)(x + y + i * 3);
+            }
+        }
+        for (int y = 0; y < kHeight / 2; ++y) {
+            for (int x = 0; x < kWidth / 2; ++x) {
+                frame->data[1][y * frame->linesize[1] + x] = (uint8_t)(128 + y);
+                frame->data[2][y * frame->linesize[2] + x] = (uint8_t)(64 + x);
+            }
+        }
+        frame->pts = i;
+        avcodec_send_frame(ctx, frame);
+        receive();
+    }
+    avcodec_send_frame(ctx, NULL);
+    receive();
+
+    av_packet_free(&pkt);
+    av_frame_free(&frame);
+    avcodec_free_context(&ctx);
+
+    return packets;
+}
+
+// 按起始码拆成nalu，参数集交给track，其他的送进帧源
+static void inputPacket(const Origin::Ptr& origin, const H264Track::Ptr& track, const string& packet, uint64_t stamp)
+{
+    vector<size_t> starts;
+    for (size_t i = 0; i + 3 <= packet.size(); ++i) {
+        if (packet[i] == 0 && packet[i + 1] == 0 && packet[i + 2] == 1) {
+            starts.push_back(i + 3);
+            i += 2;
+        }
+    }
+
+    for (size_t n = 0; n < starts.size(); ++n) {
+        size_t end = n + 1 < starts.size() ? starts[n + 1] - 3 : packet.size();
+        // 4字节起始码前面多出来的0
+        while (end > starts[n] && packet[end - 1] == 0) {
+            --end;
+        }
+
+        auto frame = H264Frame::createFrame(4, 0, true);
+        frame->_trackType = VideoTrackType;
+        frame->_buffer.append(packet.data() + starts[n], end - starts[n]);
+        frame->_pts = frame->_dts = stamp;
+
+        int nalType = packet[starts[n]] & 0x1f;
+        if (nalType == 7) {
+            track->setSps(frame);
+        } else if (nalType == 8) {
+            track->setPps(frame);
+        }
+        origin->onFrame(frame);
+    }
+}
+
+// 在帧源的loop里喂[begin, end)的帧，等喂完再返回
+static void feed(const Origin::Ptr& origin, const H264Track::Ptr& track, const vector<string>& packets, int begin, int end)
+{
+    promise<void> done;
+    origin->getLoop()->async([&](){
+        for (int i = begin; i < end; ++i) {
+            inputPacket(origin, track, packets[i], i * 40);
+        }
+        done.set_value();
+    }, false);
+    done.get_future().wait();
+}
+
+struct Result
+{
+    string err;
+    string image;
+};
+
+static shared_future<Result> request(const SnapshotOption& option)
+{
+    auto result = make_shared<promise<Result>>();
+    Snapshot::getSnapshot(kPath, DEFAULT_VHOST, DEFAULT_TYPE, option, [result](const string& err, const string& image){
+        result->set_value({err, image});
+    });
+
+    return result->get_future().share();
+}
+
+// 解码图片，返回宽高
+static bool imageSize(const string& image, AVCodecID codecId, int& width, int& height)
+{
+    auto codec = avcodec_find_decoder(codecId);
+    if (!codec) {
+        return false;
+    }
+
+    auto ctx = avcodec_alloc_context3(codec);
+    if (avcodec_open2(ctx, codec, NULL) < 0) {
+        avcodec_free_context(&ctx);
+        return false;
+    }
+
+    string data = image;
+    data.append(AV_INPUT_BUFFER_PADDING_SIZE, '\0');
+    auto pkt = av_packet_alloc();
+    pkt->data = (uint8_t*)data.data();
+    pkt->size = image.size();
+    auto frame = av_frame_alloc();
+    bool ok = avcodec_send_packet(ctx, pkt) >= 0;
+    avcodec_send_packet(ctx, NULL);
+    ok = ok && avcodec_receive_frame(ctx, frame) >= 0;
+    if (ok) {
+        width = frame->width;
+        height = frame->height;
+    }
+
+    av_frame_free(&frame);
+    av_packet_free(&pkt);
+    avcodec_free_context(&ctx);
+
+    return ok;
+}
+
+static SnapshotOption makeOption(const string& format, int width, int height)
+{
+    SnapshotOption option;
+    option.format_ = format;
+    option.width_ = width;
+    option.height_ = height;
+
+    return option;
+}
+
+int main(int argc, char** argv)
+{
+    Logger::instance()->addChannel(std::make_shared<ConsoleChannel>("ConsoleChannel", LError));
+    Logger::instance()->setLevel(LError);
+    av_log_set_level(AV_LOG_ERROR);
+    EventLoopPool::instance()->init(1, true, false);
+    WorkLoopPool::instance()->init(2, true, false);
+
+    auto packets = encodeSource(kGop * 2 + 2);
+    check((int)packets.size() == kGop * 2 + 2, "encode source with libx264");
+    if (packets.empty()) {
+        _exit(1);
+    }
+
+    bool thrown = false;
+    try {
+        request(makeOption("jpeg", 0, 0));
+    } catch (const exception& ex) {
+        thrown = true;
+    }
+    check(thrown, "missing stream throws");
+
+    UrlParser parser;
+    parser.path_ = kPath;
+    parser.vhost_ = DEFAULT_VHOST;
+    parser.protocol_ = PROTOCOL_FRAME;
+    parser.type_ = DEFAULT_TYPE;
+    auto loop = EventLoopPool::instance()->getLoopByCircle();
+    auto source = MediaSource::getOrCreate(parser.path_, parser.vhost_, parser.protocol_, parser.type_, [parser, loop](){
+        return make_shared<Origin>(parser, loop);
+    });
+    auto origin = dynamic_pointer_cast<Origin>(source);
+    origin->setOrigin();
+    auto track = H264Track::createTrack(0, 96, 90000);
+    promise<void> added;
+    loop->async([&](){
+        origin->addTrack(track);
+        added.set_value();
+    }, false);
+    added.get_future().wait();
+
+    // 第一个关键帧让track就绪，等源就绪后再从头喂，关键帧在下一帧到来时才完整
+    feed(origin, track, packets, 0, 1);
+    this_thread::sleep_for(chrono::milliseconds(800));
+    feed(origin, track, packets, 0, 5);
+
+    int width = 0;
+    int height = 0;
+    auto result = request(makeOption("jpeg", 0, 0)).get();
+    check(result.err.empty() && result.image.size() > 2 && (uint8_t)result.image[0] == 0xff && (uint8_t)result.image[1] == 0xd8,
+          "jpeg snapshot " + to_string(result.image.size()) + " bytes " + result.err);
+    bool decoded = imageSize(result.image, AV_CODEC_ID_MJPEG, width, height);
+    check(decoded && width == kWidth && height == kHeight, "default size is the source size, " + to_string(width) + "x" + to_string(height));
+
+    auto snapshot = Snapshot::get(kPath, DEFAULT_VHOST, DEFAULT_TYPE);
+    check(snapshot && snapshot->getDecodeCount() == 1 && snapshot->getEncodeCount() == 1, "first request decodes and encodes once");
+    if (!snapshot) {
+        _exit(1);
+    }
+
+    // 同一个gop内的并发请求，两种尺寸格式
+    vector<shared_future<Result>> jpegs;
+    vector<shared_future<Result>> webps;
+    vector<thread> threads;
+    mutex mtx;
+    for (int i = 0; i < 8; ++i) {
+        threads.emplace_back([&, i](){
+            auto future = request(i % 2 ? makeOption("webp", 160, 120) : makeOption("jpeg", 160, 0));
+            lock_guard<mutex> lck(mtx);
+            (i % 2 ? webps : jpegs).push_back(future);
+        });
+    }
+    for (auto& thd : threads) {
+        thd.join();
+    }
+
+    bool allOk = true;
+    for (auto& future : jpegs) {
+        auto res = future.get();
+        allOk = allOk && res.err.empty() && imageSize(res.image, AV_CODEC_ID_MJPEG, width, height) && width == 160 && height == 120;
+    }
+    check(allOk, "width only keeps the source aspect ratio");
+    allOk = true;
+    for (auto& future : webps) {
+        auto res = future.get();
+        allOk = allOk && res.err.empty() && res.image.compare(0, 4, "RIFF") == 0 && res.image.compare(8, 4, "WEBP") == 0;
+    }
+    check(allOk, "webp snapshot");
+    check(snapshot->getDecodeCount() == 1, "concurrent requests in one gop decode once");
+    check(snapshot->getEncodeCount() == 3, "each size is encoded once, " + to_string(snapshot->getEncodeCount()));
+
+    // 新的gop
+    feed(origin, track, packets, 5, kGop + 2);
+    result = request(makeOption("jpeg", 0, 0)).get();
+    check(result.err.empty() && snapshot->getDecodeCount() == 2 && snapshot->getEncodeCount() == 4,
+          "new keyframe decodes again");
+    check(Snapshot::getCount() == 1, "one snapshot per stream");
+
+    cout << (g_ok ? "ok" : "FAILED") << endl;
+    _exit(g_ok ? 0 : 1);
+}
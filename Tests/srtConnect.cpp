@@ -0,0 +1,167 @@
+// srt非阻塞连接测试，本机回环地址上起SrtServer，多个srt loop
+// 1. 并发: 同时发起多个连接，握手在loop的srt epoll上完成，统计每秒建连数
+// 2. 不阻塞: 每个loop上跑5ms的定时器，建连过程中定时器的最大延迟远小于连接超时
+//    (每个srt客户端socket有自己的收发线程，核数少时延迟主要来自线程调度)
+// 3. 超时: 连接没有监听的端口，在超时时间附近回调失败，loop不被卡住
+// 编译: 先编译整个工程(打开ENABLE_SRT)，再链接lib/、Base/lib下的静态库和libsrt
+// 运行: ./srtConnect [连接数] [loop数]
+
+#include <iostream>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <string>
+#include <cstdlib>
+#include <unistd.h>
+
+#include "Srt/SrtServer.h"
+#include "Net/SrtSocket.h"
+#include "EventPoller/EventLoopPool.h"
+#include "Log/Logger.h"
+
+using namespace std;
+
+static const int kPort = 16666;
+static const int kDeadPort = 16667;
+static const int kTimerMs = 5;
+
+static uint64_t nowMs()
+{
+    return chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// 每个loop上一个定时器，记录两次触发之间超出间隔的最大值
+struct StallProbe
+{
+    atomic<uint64_t> last{0};
+    atomic<uint64_t> maxStall{0};
+    atomic<bool> stop{false};
+};
+
+static void startProbe(const SrtEventLoop::Ptr& loop, const shared_ptr<StallProbe>& probe)
+{
+    loop->addTimerTask(kTimerMs, [probe]() -> uint64_t {
+        if (probe->stop) {
+            return 0;
+        }
+        uint64_t now = nowMs();
+        uint64_t last = probe->last.exchange(now);
+        if (last && now - last > kTimerMs && now - last - kTimerMs > probe->maxStall) {
+            probe->maxStall = now - last - kTimerMs;
+        }
+        return kTimerMs;
+    }, nullptr);
+}
+
+static uint64_t resetProbes(vector<shared_ptr<StallProbe>>& probes)
+{
+    uint64_t maxStall = 0;
+    for (auto& probe : probes) {
+        maxStall = max(maxStall, probe->maxStall.exchange(0));
+    }
+    return maxStall;
+}
+
+int main(int argc, char** argv)
+{
+    int connCount = argc > 1 ? atoi(argv[1]) : 200;
+    int loopCount = argc > 2 ? atoi(argv[2]) : 4;
+
+    Logger::instance()->addChannel(std::make_shared<ConsoleChannel>("ConsoleChannel", LError));
+    Logger::instance()->setLevel(LError);
+    SrtSocket::initSrt();
+    // 推流的source挂在普通loop上
+    EventLoopPool::instance()->init(2, true, false);
+    SrtEventLoopPool::instance()->init(loopCount, true, false);
+    this_thread::sleep_for(chrono::milliseconds(100));
+
+    vector<shared_ptr<StallProbe>> probes;
+    SrtEventLoopPool::instance()->for_each_loop([&probes](const SrtEventLoop::Ptr& loop){
+        auto probe = make_shared<StallProbe>();
+        startProbe(loop, probe);
+        probes.push_back(probe);
+    });
+
+    SrtServer::instance()->start("127.0.0.1", kPort, 0, 0);
+    this_thread::sleep_for(chrono::milliseconds(200));
+    resetProbes(probes);
+
+    bool ok = true;
+
+    // 并发建连
+    atomic<int> connected{0};
+    atomic<int> failed{0};
+    vector<SrtSocket::Ptr> sockets;
+
+    auto start = nowMs();
+    for (int i = 0; i < connCount; ++i) {
+        auto loop = SrtEventLoopPool::instance()->getLoopByCircle();
+        auto socket = make_shared<SrtSocket>(loop, false);
+        socket->createSocket(0);
+        // 带上推流的streamid，服务端不会因为找不到path马上断开
+        string streamId = "#!::r=live/srt" + to_string(i) + ",m=publish";
+        socket->setsockopt(socket->getFd(), SOL_SOCKET, SRTO_STREAMID, streamId.data(), streamId.size());
+        SrtSocket::Wptr wSocket = socket;
+        socket->setConnectCb([&connected, &failed, wSocket](bool success){
+            if (success) {
+                ++connected;
+                return ;
+            }
+            // 和SrtClient一样，失败后关掉socket
+            ++failed;
+            auto socket = wSocket.lock();
+            if (socket) {
+                socket->close();
+            }
+        });
+        socket->setErrorCb([](){});
+        if (socket->connect("127.0.0.1", kPort, 3000) != 0) {
+            ++failed;
+        }
+        sockets.push_back(socket);
+    }
+    while (connected + failed < connCount && nowMs() - start < 10000) {
+        this_thread::sleep_for(chrono::milliseconds(1));
+    }
+    double seconds = (nowMs() - start) / 1000.0;
+    uint64_t connectStall = resetProbes(probes);
+    cout << "connect: " << connected << "/" << connCount << " in " << seconds << "s, "
+         << (int)(connected / max(seconds, 0.001)) << " connects/s, failed " << failed
+         << ", max loop stall " << connectStall << "ms" << endl;
+    ok = ok && connected == connCount && connectStall < 500;
+
+    // 连接失败时回调失败，不卡loop
+    auto loop = SrtEventLoopPool::instance()->getLoopByCircle();
+    auto dead = make_shared<SrtSocket>(loop, false);
+    dead->createSocket(0);
+    atomic<int> deadResult{-1};
+    atomic<uint64_t> deadTime{0};
+    start = nowMs();
+    dead->setConnectCb([&deadResult, &deadTime, start](bool success){
+        deadTime = nowMs() - start;
+        deadResult = success;
+    });
+    dead->connect("127.0.0.1", kDeadPort, 1000);
+    while (deadResult == -1 && nowMs() - start < 5000) {
+        this_thread::sleep_for(chrono::milliseconds(1));
+    }
+    uint64_t deadStall = resetProbes(probes);
+    cout << "connect to dead port: " << (deadResult == 0 ? "failed" : deadResult == 1 ? "connected" : "no callback")
+         << " after " << deadTime << "ms, max loop stall " << deadStall << "ms" << endl;
+    ok = ok && deadResult == 0 && deadTime >= 900 && deadTime < 2000 && deadStall < 500;
+
+    for (auto& probe : probes) {
+        probe->stop = true;
+    }
+
+    for (auto& socket : sockets) {
+        socket->getLoop()->async([socket](){
+            socket->close();
+        }, true);
+    }
+    this_thread::sleep_for(chrono::milliseconds(100));
+
+    cout << (ok ? "ok" : "FAILED") << endl;
+    _exit(ok ? 0 : 1);
+}
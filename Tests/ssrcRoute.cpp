@@ -0,0 +1,176 @@
+// ssrc路由测试
+// 1. 每个loop一个udp socket绑定同一端口并开启reuseport分流，发送10000个ssrc，检查每个ssrc只落到一个socket
+// 2. 10000个ssrc填入SsrcRouteTable，多线程查找，与加锁的unordered_map对比耗时
+// 3. 查找的同时不停增删，旧快照按epoch回收，读者拿到的内容始终正确(可加-fsanitize=address检查释放时机)
+// 编译: 先编译整个工程，再链接Base/lib下的libbase.a
+// 运行: ./ssrcRoute [线程数]
+
+#include <iostream>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <unordered_map>
+#include <cstdlib>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+
+#include "Net/Socket.h"
+#include "EventPoller/EventLoopPool.h"
+#include "Common/SsrcRouteTable.h"
+#include "Log/Logger.h"
+
+using namespace std;
+
+static const int kSsrcCount = 10000;
+static const int kPort = 20036;
+
+struct Context
+{
+    uint32_t ssrc;
+};
+
+static bool testSteering(int count)
+{
+    vector<Socket::Ptr> sockets;
+    EventLoopPool::instance()->for_each_loop([&sockets, count](const EventLoop::Ptr& loop){
+        auto socket = make_shared<Socket>(loop);
+        socket->createSocket(SOCKET_UDP);
+        if (socket->bind(kPort, "127.0.0.1") == -1) {
+            return ;
+        }
+        socket->setReusePortSteering(8, count);
+        socket->setNoBlocked();
+        sockets.push_back(socket);
+    });
+    if (sockets.size() != (size_t)count) {
+        cout << "bind failed" << endl;
+        return false;
+    }
+
+    int sender = socket(AF_INET, SOCK_DGRAM, 0);
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(kPort);
+    addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+
+    // ssrc -> 收到它的socket序号
+    unordered_map<uint32_t, int> owner;
+    size_t received = 0;
+    bool ok = true;
+    char rtp[64] = {(char)0x80, 96};
+    for (int base = 0; base < kSsrcCount; base += 100) {
+        // 每个ssrc发两次，分批发送，避免超出接收缓冲
+        for (int round = 0; round < 2; ++round) {
+            for (int i = base; i < base + 100; ++i) {
+                uint32_t ssrc = htonl(0x10000000 + i * 7919);
+                memcpy(rtp + 8, &ssrc, 4);
+                sendto(sender, rtp, sizeof(rtp), 0, (sockaddr*)&addr, sizeof(addr));
+            }
+        }
+        for (int index = 0; index < count; ++index) {
+            char buf[64];
+            while (recv(sockets[index]->getFd(), buf, sizeof(buf), 0) == sizeof(buf)) {
+                uint32_t ssrc;
+                memcpy(&ssrc, buf + 8, 4);
+                ssrc = ntohl(ssrc);
+                auto iter = owner.emplace(ssrc, index).first;
+                ok = ok && iter->second == index && (int)(ssrc % count) == index;
+                ++received;
+            }
+        }
+    }
+    ::close(sender);
+
+    cout << "steering: " << count << " sockets, received " << received << ", ssrc " << owner.size()
+         << (ok ? ", each ssrc on one socket" : ", ssrc split across sockets") << endl;
+
+    return ok && owner.size() == kSsrcCount;
+}
+
+template <typename Find>
+static double bench(int threads, const Find& find)
+{
+    int loops = 200;
+    auto start = chrono::steady_clock::now();
+    vector<thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&find, loops](){
+            size_t hit = 0;
+            for (int n = 0; n < loops; ++n) {
+                for (int i = 0; i < kSsrcCount; ++i) {
+                    hit += find(0x10000000 + i * 7919) ? 1 : 0;
+                }
+            }
+            if (hit != (size_t)loops * kSsrcCount) {
+                cout << "lookup miss" << endl;
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    double ns = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+
+    return ns / loops / kSsrcCount;
+}
+
+int main(int argc, char** argv)
+{
+    int threads = argc > 1 ? atoi(argv[1]) : 4;
+
+    Logger::instance()->addChannel(std::make_shared<ConsoleChannel>("ConsoleChannel", LError));
+    Logger::instance()->setLevel(LError);
+    EventLoopPool::instance()->init(threads, true, false);
+
+    bool ok = testSteering(threads);
+
+    SsrcRouteTable<Context> table;
+    mutex mtx;
+    unordered_map<uint32_t, shared_ptr<Context>> locked;
+    for (int i = 0; i < kSsrcCount; ++i) {
+        uint32_t ssrc = 0x10000000 + i * 7919;
+        auto context = make_shared<Context>();
+        context->ssrc = ssrc;
+        table.emplace(ssrc, context);
+        locked[ssrc] = context;
+    }
+    ok = ok && table.size() == kSsrcCount;
+    cout << "table size: " << table.size() << endl;
+
+    double lockNs = bench(threads, [&mtx, &locked](uint32_t ssrc){
+        lock_guard<mutex> lock(mtx);
+        auto iter = locked.find(ssrc);
+        return iter == locked.end() ? nullptr : iter->second;
+    });
+    double tableNs = bench(threads, [&table](uint32_t ssrc){
+        return table.find(ssrc);
+    });
+    cout << threads << " threads: mutex map " << lockNs << " ns/lookup, route table " << tableNs << " ns/lookup" << endl;
+
+    // 查找过程中增删，读者不受影响
+    atomic<bool> wrong(false);
+    thread writer([&table](){
+        for (int i = 0; i < 20000; ++i) {
+            uint32_t ssrc = 0x70000000 + i;
+            table.emplace(ssrc, make_shared<Context>());
+            table.erase(ssrc);
+        }
+    });
+    double busyNs = bench(threads, [&table, &wrong](uint32_t ssrc){
+        auto context = table.find(ssrc);
+        if (!context || context->ssrc != ssrc) {
+            wrong = true;
+        }
+        return context;
+    });
+    writer.join();
+    ok = ok && !wrong && table.size() == kSsrcCount;
+    cout << "route table with concurrent writer: " << busyNs << " ns/lookup" << endl;
+
+    cout << (ok ? "ok" : "FAILED") << endl;
+    // Logger析构时会抛bad_weak_ptr，跳过全局析构直接退出
+    _exit(ok ? 0 : 1);
+}
@@ -0,0 +1,318 @@
+// tls握手和加密吞吐测试，客户端和服务端在同一线程内通过内存bio对接
+// 对比: 每个连接新建SSL_CTX(原来的做法) / 共用SSL_CTX完整握手 / 票据复用握手(tls1.3和tls1.2)
+// 吞吐: 单核SSL_write加密后由对端读出的速率
+// tcp: TcpServer+TlsContext的回显服务，客户端连两次，第二次必须用票据复用成功；ktls开关各跑一遍(开启时握手直接写socket)
+// 编译: 需要完整的openssl(libssl+libcrypto)，TlsContext.cpp和TlsTicketKeys.cpp与本文件一起编译，再链接Base/lib/libbase.a
+// 运行: ./tlsHandshake [证书目录]，默认使用conf/下的sms.com.key和sms.com.crt
+
+#include <iostream>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+
+#include <arpa/inet.h>
+
+#include "Ssl/TlsContext.h"
+#include "Ssl/TlsTicketKeys.h"
+#include "Net/TcpServer.h"
+#include "Net/TcpConnection.h"
+#include "EventPoller/EventLoopPool.h"
+#include "Log/Logger.h"
+
+using namespace std;
+
+static string g_keyFile;
+static string g_crtFile;
+
+// 原来每个连接都新建SSL_CTX并加载证书
+static SSL_CTX* newServerCtx()
+{
+    SSL_CTX* ctx = SSL_CTX_new(TLS_method());
+    SSL_CTX_set_verify(ctx, SSL_VERIFY_NONE, NULL);
+    SSL_CTX_set_cipher_list(ctx, "ALL");
+    SSL_CTX_use_certificate_file(ctx, g_crtFile.c_str(), SSL_FILETYPE_PEM);
+    SSL_CTX_use_PrivateKey_file(ctx, g_keyFile.c_str(), SSL_FILETYPE_PEM);
+    SSL_CTX_check_private_key(ctx);
+
+    return ctx;
+}
+
+struct Pair
+{
+    SSL* client = nullptr;
+    SSL* server = nullptr;
+
+    Pair(SSL_CTX* clientCtx, SSL_CTX* serverCtx)
+    {
+        client = SSL_new(clientCtx);
+        server = SSL_new(serverCtx);
+        BIO *clientBio, *serverBio;
+        BIO_new_bio_pair(&clientBio, 64 * 1024, &serverBio, 64 * 1024);
+        SSL_set_bio(client, clientBio, clientBio);
+        SSL_set_bio(server, serverBio, serverBio);
+        SSL_set_connect_state(client);
+        SSL_set_accept_state(server);
+    }
+
+    ~Pair()
+    {
+        // 未正常关闭的会话会被标记为不可复用
+        SSL_shutdown(client);
+        SSL_shutdown(server);
+        SSL_free(client);
+        SSL_free(server);
+    }
+
+    bool handshake()
+    {
+        for (int i = 0; i < 100; ++i) {
+            int c = SSL_do_handshake(client);
+            int s = SSL_do_handshake(server);
+            if (c == 1 && s == 1) {
+                // tls1.3的票据在握手之后发送，客户端读一次才能拿到
+                char buf[1];
+                SSL_read(client, buf, sizeof(buf));
+                return true;
+            }
+        }
+
+        return false;
+    }
+};
+
+static SSL_SESSION* g_session = nullptr;
+
+static int onNewSession(SSL* ssl, SSL_SESSION* session)
+{
+    if (g_session) {
+        SSL_SESSION_free(g_session);
+    }
+    g_session = session;
+
+    return 1;
+}
+
+static SSL_CTX* newClientCtx(int maxVersion)
+{
+    SSL_CTX* ctx = SSL_CTX_new(TLS_method());
+    SSL_CTX_set_verify(ctx, SSL_VERIFY_NONE, NULL);
+    SSL_CTX_set_max_proto_version(ctx, maxVersion);
+    SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+    SSL_CTX_sess_set_new_cb(ctx, onNewSession);
+
+    return ctx;
+}
+
+// 返回每秒握手次数，resume时检查每次都复用成功
+static double benchHandshake(SSL_CTX* clientCtx, const shared_ptr<SSL_CTX>& serverCtx, bool resume, int count, bool& ok)
+{
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < count; ++i) {
+        SSL_CTX* perConnCtx = serverCtx ? nullptr : newServerCtx();
+        {
+            Pair pair(clientCtx, serverCtx ? serverCtx.get() : perConnCtx);
+            if (resume && g_session) {
+                SSL_set_session(pair.client, g_session);
+            }
+            ok = ok && pair.handshake();
+            if (resume && i > 0) {
+                ok = ok && SSL_session_reused(pair.client);
+            }
+        }
+        if (perConnCtx) {
+            SSL_CTX_free(perConnCtx);
+        }
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    return count / seconds;
+}
+
+static double benchThroughput(SSL_CTX* clientCtx, const shared_ptr<SSL_CTX>& serverCtx, int megabytes)
+{
+    Pair pair(clientCtx, serverCtx.get());
+    pair.handshake();
+
+    vector<char> data(16 * 1024, 'a');
+    vector<char> out(64 * 1024);
+    size_t total = (size_t)megabytes * 1024 * 1024;
+    size_t received = 0;
+    auto start = chrono::steady_clock::now();
+    while (received < total) {
+        // 服务端加密写入，客户端读出解密
+        SSL_write(pair.server, data.data(), data.size());
+        int n;
+        while ((n = SSL_read(pair.client, out.data(), out.size())) > 0) {
+            received += n;
+        }
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    return received / seconds / 1e6;
+}
+
+class EchoConnection : public TcpConnection
+{
+public:
+    EchoConnection(const EventLoop::Ptr& loop, const Socket::Ptr& socket)
+        :TcpConnection(loop, socket, true)
+    {}
+
+    void onRead(const StreamBuffer::Ptr& buffer, struct sockaddr* addr, int len) override
+    {
+        auto echo = make_shared<StreamBuffer>();
+        echo->assign(buffer->data(), buffer->size());
+        send(echo);
+    }
+};
+
+// 阻塞的openssl客户端，发一次数据并等回显，返回是否复用了会话
+static bool echoOverTcp(SSL_CTX* clientCtx, int port, bool& ok)
+{
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+    timeval timeout = {3, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    if (connect(fd, (sockaddr*)&addr, sizeof(addr)) != 0) {
+        close(fd);
+        ok = false;
+        return false;
+    }
+
+    SSL* ssl = SSL_new(clientCtx);
+    SSL_set_fd(ssl, fd);
+    if (g_session) {
+        SSL_set_session(ssl, g_session);
+    }
+    string ping = "ping over tls";
+    char buf[64] = {0};
+    // 读回显时顺带收下服务端的tls1.3票据
+    bool echo = SSL_connect(ssl) == 1 && SSL_write(ssl, ping.data(), ping.size()) == (int)ping.size()
+                && SSL_read(ssl, buf, sizeof(buf)) == (int)ping.size() && ping == buf;
+    bool reused = SSL_session_reused(ssl);
+    ok = ok && echo;
+
+    SSL_shutdown(ssl);
+    SSL_free(ssl);
+    close(fd);
+
+    return reused;
+}
+
+static void testResumeOverTcp(bool ktls, bool& ok)
+{
+    static int port = 20037;
+    TlsContext::setEnableKtls(ktls);
+    auto loop = EventLoopPool::instance()->getLoopByCircle();
+    auto server = make_shared<TcpServer>(loop, "127.0.0.1", ++port, 0, 0);
+    server->setOnCreateSession([](const EventLoop::Ptr& loop, const Socket::Ptr& socket) -> TcpConnection::Ptr {
+        return make_shared<EchoConnection>(loop, socket);
+    });
+    server->start();
+    usleep(100 * 1000);
+
+    for (int version : {TLS1_3_VERSION, TLS1_2_VERSION}) {
+        // 前面的测试留下的会话不能带到第一个连接上
+        if (g_session) {
+            SSL_SESSION_free(g_session);
+            g_session = nullptr;
+        }
+        SSL_CTX* clientCtx = newClientCtx(version);
+        bool first = echoOverTcp(clientCtx, port, ok);
+        bool second = g_session && echoOverTcp(clientCtx, port, ok);
+        ok = ok && !first && second;
+        cout << "tcp " << (ktls ? "ktls on" : "ktls off") << ", " << (version == TLS1_3_VERSION ? "tls1.3" : "tls1.2")
+             << ": second connection " << (second ? "resumed with ticket" : "full handshake") << endl;
+        SSL_CTX_free(clientCtx);
+    }
+}
+
+static bool kernelTlsAvailable()
+{
+    int listenFd = socket(AF_INET, SOCK_STREAM, 0);
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(addr);
+    bind(listenFd, (sockaddr*)&addr, sizeof(addr));
+    listen(listenFd, 1);
+    getsockname(listenFd, (sockaddr*)&addr, &len);
+    connect(fd, (sockaddr*)&addr, sizeof(addr));
+    bool ok = setsockopt(fd, IPPROTO_TCP, TCP_ULP, "tls", sizeof("tls")) == 0;
+    close(fd);
+    close(listenFd);
+
+    return ok;
+}
+
+int main(int argc, char** argv)
+{
+    string dir = argc > 1 ? argv[1] : "conf";
+    g_keyFile = dir + "/sms.com.key";
+    g_crtFile = dir + "/sms.com.crt";
+
+    Logger::instance()->addChannel(std::make_shared<ConsoleChannel>("ConsoleChannel", LError));
+    Logger::instance()->setLevel(LError);
+
+    TlsContext::setKeyFile(g_keyFile, g_crtFile);
+    auto serverCtx = TlsContext::getSslCtx(true);
+    bool ok = serverCtx && serverCtx == TlsContext::getSslCtx(true);
+    if (!ok) {
+        cout << "load cert failed" << endl;
+        _exit(1);
+    }
+
+    int count = 300;
+    for (int version : {TLS1_3_VERSION, TLS1_2_VERSION}) {
+        SSL_CTX* clientCtx = newClientCtx(version);
+        string name = version == TLS1_3_VERSION ? "tls1.3" : "tls1.2";
+        double perConn = benchHandshake(clientCtx, nullptr, false, count, ok);
+        double shared = benchHandshake(clientCtx, serverCtx, false, count, ok);
+        double resumed = benchHandshake(clientCtx, serverCtx, true, count, ok);
+        cout << name << " handshakes/s: per-connection ctx " << perConn << ", shared ctx " << shared
+             << ", ticket resume " << resumed << endl;
+
+        if (version == TLS1_3_VERSION) {
+            double mbps = benchThroughput(clientCtx, serverCtx, 256);
+            cout << name << " encrypt+decrypt throughput: " << mbps << " MB/s per core" << endl;
+        }
+        if (g_session) {
+            SSL_SESSION_free(g_session);
+            g_session = nullptr;
+        }
+        SSL_CTX_free(clientCtx);
+    }
+
+    // 密钥轮换后旧票据仍可复用，服务端换发新票据
+    SSL_CTX* clientCtx = newClientCtx(TLS1_3_VERSION);
+    TlsTicketKeys::instance().setLifetime(1);
+    benchHandshake(clientCtx, serverCtx, true, 2, ok);
+    auto oldSession = g_session;
+    SSL_SESSION_up_ref(oldSession);
+    sleep(2);
+    // 另一个客户端完整握手，服务端签发票据时轮换密钥
+    benchHandshake(clientCtx, serverCtx, false, 1, ok);
+    Pair pair(clientCtx, serverCtx.get());
+    SSL_set_session(pair.client, oldSession);
+    ok = ok && pair.handshake() && SSL_session_reused(pair.client);
+    cout << "resume after key rotation: " << (SSL_session_reused(pair.client) ? "yes" : "no") << endl;
+
+    TlsTicketKeys::instance().setLifetime(3600);
+    EventLoopPool::instance()->init(1, true, false);
+    testResumeOverTcp(false, ok);
+    testResumeOverTcp(true, ok);
+
+    cout << "kernel tls: " << (kernelTlsAvailable() ? "available" : "not available, user space fallback") << endl;
+    cout << (ok ? "ok" : "FAILED") << endl;
+    // Logger析构时会抛bad_weak_ptr，跳过全局析构直接退出
+    _exit(ok ? 0 : 1);
+}
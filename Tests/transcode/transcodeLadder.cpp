@@ -0,0 +1,265 @@
+// 多码率转码关键帧对齐测试
+// 用libx264把合成的640x360画面编成gop为7的h264当输入，TranscodeVideo解码一次，
+// 两路输出(libx264 640x360、libopenh264 320x180)都按gop 10编码
+// 检查: 两路输出的IDR都在同一个解码帧上，且都在gop的整数倍位置；gop为0时使用默认值25
+// 只给宽或高的输出按源的宽高比计算另一边
+// 编译: cmake -DENABLE_FFMPEG=ON -DENABLE_PROJECT_TRANSCODELADDER=ON，ffmpeg需要带libx264和libopenh264
+// 运行: ./transcodeLadder [帧数]
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <unistd.h>
+
+#include "Ffmpeg/TranscodeVideo.h"
+#include "Log/Logger.h"
+
+extern "C" {
+#include <libavutil/opt.h>
+}
+
+using namespace std;
+
+static bool g_ok = true;
+
+static void check(bool cond, const string& name)
+{
+    cout << (cond ? "ok     " : "FAILED ") << name << endl;
+    g_ok = g_ok && cond;
+}
+
+// 生成输入码流，每个包是一帧annexb数据
+static vector<string> encodeSource(int width, int height, int frames, int gop)
+{
+    vector<string> packets;
+    auto codec = avcodec_find_encoder_by_name("libx264");
+    if (!codec) {
+        return packets;
+    }
+
+    auto ctx = avcodec_alloc_context3(codec);
+    ctx->width = width;
+    ctx->height = height;
+    ctx->time_base = (AVRational){1, 25};
+    ctx->framerate = (AVRational){25, 1};
+    ctx->pix_fmt = AV_PIX_FMT_YUV420P;
+    ctx->gop_size = gop;
+    ctx->max_b_frames = 0;
+    av_opt_set(ctx->priv_data, "preset", "ultrafast", 0);
+    av_opt_set(ctx->priv_data, "x264-params", "scenecut=0", 0);
+    if (avcodec_open2(ctx, codec, NULL) < 0) {
+        avcodec_free_context(&ctx);
+        return packets;
+    }
+
+    auto frame = av_frame_alloc();
+    frame->format = AV_PIX_FMT_YUV420P;
+    frame->width = width;
+    frame->height = height;
+    av_frame_get_buffer(frame, 0);
+    auto pkt = av_packet_alloc();
+
+    auto receive = [&](){
+        while (avcodec_receive_packet(ctx, pkt) >= 0) {
+            packets.emplace_back((char*)pkt->data, pkt->size);
+            av_packet_unref(pkt);
+        }
+    };
+
+    for (int i = 0; i < frames; ++i) {
+        av_frame_make_writable(frame);
+        // 移动的渐变，每帧都有变化
+        for (int y = 0; y < height; ++y) {
+            for (int x = 0; x < width; ++x) {
+                frame->data[0][y * frame->linesize[0] + x] = (uint8_t)(x + y + i * 3);
+            }
+        }
+        for (int y = 0; y < height / 2; ++y) {
+            for (int x = 0; x < width / 2; ++x) {
+                frame->data[1][y * frame->linesize[1] + x] = (uint8_t)(128 + y + i * 2);
+                frame->data[2][y * frame->linesize[2] + x] = (uint8_t)(64 + x + i * 5);
+            }
+        }
+        frame->pts = i;
+        avcodec_send_frame(ctx, frame);
+        receive();
+    }
+    avcodec_send_frame(ctx, NULL);
+    receive();
+
+    av_packet_free(&pkt);
+    av_frame_free(&frame);
+    avcodec_free_context(&ctx);
+
+    return packets;
+}
+
+// annexb数据里是否有IDR
+static bool hasIdr(const StreamBuffer::Ptr& packet)
+{
+    auto data = (const uint8_t*)packet->data();
+    size_t size = packet->size();
+    for (size_t i = 0; i + 3 < size; ++i) {
+        if (data[i] == 0 && data[i + 1] == 0 && data[i + 2] == 1 && (data[i + 3] & 0x1f) == 5) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static vector<int> idrIndexes(const vector<bool>& keys, size_t count)
+{
+    vector<int> ret;
+    for (size_t i = 0; i < count && i < keys.size(); ++i) {
+        if (keys[i]) {
+            ret.push_back(i);
+        }
+    }
+
+    return ret;
+}
+
+static void testLadder(const vector<string>& source, int gop, int expectGop)
+{
+    vector<bool> keys264;
+    vector<bool> keysOpenh264;
+    {
+        TranscodeVideo transcode(AV_CODEC_ID_H264);
+
+        VideoEncodeOption high;
+        high.name_ = "360p";
+        high.codec_ = "libx264";
+        high.gop_ = gop;
+        transcode.addBranch(high)->setOnPacket([&keys264](const StreamBuffer::Ptr& packet){
+            keys264.push_back(hasIdr(packet));
+        });
+
+        VideoEncodeOption low;
+        low.name_ = "180p";
+        low.codec_ = "libopenh264";
+        low.height_ = 180;
+        low.bitrate_ = 300000;
+        low.gop_ = 50;
+        transcode.addBranch(low)->setOnPacket([&keysOpenh264](const StreamBuffer::Ptr& packet){
+            keysOpenh264.push_back(hasIdr(packet));
+        });
+
+        transcode.initDecode();
+        for (auto& data : source) {
+            auto frame = make_shared<FrameBuffer>();
+            frame->_buffer.assign(data.data(), data.size());
+            transcode.inputFrame(frame);
+        }
+    }
+
+    // 没有b帧，输出顺序和解码顺序一致，x264有lookahead，只比较两路都已输出的部分
+    size_t count = min(keys264.size(), keysOpenh264.size());
+    auto idr264 = idrIndexes(keys264, count);
+    auto idrOpenh264 = idrIndexes(keysOpenh264, count);
+    cout << "gop " << gop << ": libx264 " << keys264.size() << " packets, libopenh264 "
+         << keysOpenh264.size() << " packets, idr:";
+    for (auto index : idr264) {
+        cout << " " << index;
+    }
+    cout << endl;
+
+    bool onGop = !idr264.empty();
+    for (size_t i = 0; i < idr264.size(); ++i) {
+        onGop = onGop && idr264[i] == (int)i * expectGop;
+    }
+    string name = "gop " + to_string(gop) + ": ";
+    check(count > (size_t)expectGop * 2, name + "both branches produce output");
+    check(idr264 == idrOpenh264, name + "idr on the same decoded frames in both branches");
+    check(onGop, name + "idr every " + to_string(expectGop) + " frames");
+}
+
+// 解码第一个输出包，得到输出的分辨率
+static bool packetSize(const StreamBuffer::Ptr& packet, int& width, int& height)
+{
+    auto codec = avcodec_find_decoder(AV_CODEC_ID_H264);
+    auto ctx = avcodec_alloc_context3(codec);
+    if (avcodec_open2(ctx, codec, NULL) < 0) {
+        avcodec_free_context(&ctx);
+        return false;
+    }
+
+    string data(packet->data(), packet->size());
+    data.append(AV_INPUT_BUFFER_PADDING_SIZE, '\0');
+    auto pkt = av_packet_alloc();
+    pkt->data = (uint8_t*)data.data();
+    pkt->size = packet->size();
+    auto frame = av_frame_alloc();
+    bool ok = avcodec_send_packet(ctx, pkt) >= 0;
+    avcodec_send_packet(ctx, NULL);
+    ok = ok && avcodec_receive_frame(ctx, frame) >= 0;
+    if (ok) {
+        width = frame->width;
+        height = frame->height;
+    }
+
+    av_frame_free(&frame);
+    av_packet_free(&pkt);
+    avcodec_free_context(&ctx);
+
+    return ok;
+}
+
+static void testSize(const vector<string>& source, int width, int height, int expectWidth, int expectHeight)
+{
+    StreamBuffer::Ptr first;
+    {
+        TranscodeVideo transcode(AV_CODEC_ID_H264);
+
+        VideoEncodeOption option;
+        option.name_ = "size";
+        option.codec_ = "libx264";
+        option.width_ = width;
+        option.height_ = height;
+        transcode.addBranch(option)->setOnPacket([&first](const StreamBuffer::Ptr& packet){
+            if (!first) {
+                first = packet;
+            }
+        });
+
+        transcode.initDecode();
+        for (auto& data : source) {
+            auto frame = make_shared<FrameBuffer>();
+            frame->_buffer.assign(data.data(), data.size());
+            transcode.inputFrame(frame);
+        }
+    }
+
+    int outWidth = 0;
+    int outHeight = 0;
+    bool decoded = first && packetSize(first, outWidth, outHeight);
+    check(decoded && outWidth == expectWidth && outHeight == expectHeight,
+          "width " + to_string(width) + " height " + to_string(height) + " encodes "
+          + to_string(outWidth) + "x" + to_string(outHeight));
+}
+
+int main(int argc, char** argv)
+{
+    Logger::instance()->addChannel(std::make_shared<ConsoleChannel>("ConsoleChannel", LError));
+    Logger::instance()->setLevel(LError);
+    av_log_set_level(AV_LOG_ERROR);
+    int frames = argc > 1 ? atoi(argv[1]) : 150;
+
+    // 输入的gop和输出不同，输出的关键帧位置只由TranscodeVideo决定
+    auto source = encodeSource(640, 360, frames, 7);
+    check((int)source.size() == frames, "encode source with libx264");
+    if (source.empty()) {
+        _exit(1);
+    }
+
+    testLadder(source, 10, 10);
+    testLadder(source, 0, 25);
+
+    testSize(source, 320, 0, 320, 180);
+    testSize(source, 0, 180, 320, 180);
+    testSize(source, 0, 0, 640, 360);
+
+    cout << (g_ok ? "ok" : "FAILED") << endl;
+    _exit(g_ok ? 0 : 1);
+}
@@ -0,0 +1,227 @@
+// 点播倍速测试，用PsMuxer生成一段每秒一个gop的ps文件，idr里写上gop序号
+// 1. 快进: 8倍速时只输出sps/pps/idr，gop序号递增，输出的时间戳递增
+// 2. 限速: 8倍速和16倍速的输出码率都不超过文件平均码率，16倍速跳过更多的gop
+// 3. 倒放: -8倍速时gop序号递减
+// 4. 恢复: 回到1倍速后重新输出p帧，从最后一个关键帧附近继续
+// 编译: 先编译整个工程，再链接lib/下的静态库(libmpeg/libcommon需要--whole-archive)
+// 运行: ./trickPlay
+
+#include <iostream>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <vector>
+#include <string>
+#include <cstdlib>
+#include <unistd.h>
+
+#include "Record/RecordReaderPs.h"
+#include "Mpeg/PsMuxer.h"
+#include "Codec/H264Track.h"
+#include "Codec/H264Frame.h"
+#include "Common/Config.h"
+#include "EventPoller/EventLoopPool.h"
+#include "WorkPoller/WorkLoopPool.h"
+#include "Util/File.h"
+#include "Log/Logger.h"
+
+using namespace std;
+
+static const int kGops = 60;
+static const int kGopSize = 25;
+static const int kIdrSize = 20000;
+static const string kRoot = "/tmp/trickPlayTest";
+
+// gop序号写在nal头后面，加4避开起始码
+static FrameBuffer::Ptr makeFrame(int nalType, int size, int pts, int gop = 0)
+{
+    auto frame = FrameBuffer::createFrame(CodecH264, 4, VideoTrackType, false);
+    string data("\x00\x00\x00\x01", 4);
+    data.push_back((char)(0x60 | nalType));
+    data.push_back((char)(gop + 4));
+    for (int i = 1; i < size; ++i) {
+        data.push_back((char)(rand() % 250 + 4));
+    }
+    frame->_buffer.assign(data.data(), data.size());
+    frame->_pts = frame->_dts = pts;
+    frame->_index = VideoTrackType;
+    frame->_trackType = VideoTrackType;
+    frame->_codec = CodecH264;
+
+    return frame;
+}
+
+static uint64_t makeFile(const string& path)
+{
+    string ps;
+    auto track = H264Track::createTrack(VideoTrackType, 96, 90000);
+    PsMuxer muxer;
+    muxer.addTrackInfo(track);
+    muxer.startEncode();
+    muxer.setOnPsFrame([&ps](const FrameBuffer::Ptr& pkt){
+        ps.append(pkt->data(), pkt->size());
+    });
+
+    // 从1秒开始，避开pts为0
+    for (int i = 0; i < kGops * kGopSize; ++i) {
+        int pts = 1000 + i * 40;
+        if (i % kGopSize == 0) {
+            int gop = i / kGopSize;
+            for (auto& frame : {makeFrame(7, 20, pts), makeFrame(8, 4, pts), makeFrame(5, kIdrSize, pts, gop)}) {
+                muxer.onFrame(frame);
+            }
+        } else {
+            muxer.onFrame(makeFrame(1, 2000 + rand() % 3000, pts));
+        }
+    }
+
+    File::createDir(kRoot.data(), 0777);
+    File::saveFile(ps, path.data());
+    return ps.size();
+}
+
+struct Output
+{
+    uint64_t dts;
+    int nalType;
+    int gop;
+    size_t size;
+};
+
+static mutex g_mtx;
+static vector<Output> g_output;
+
+static vector<Output> collect(int ms)
+{
+    {
+        lock_guard<mutex> lck(g_mtx);
+        g_output.clear();
+    }
+    this_thread::sleep_for(chrono::milliseconds(ms));
+    lock_guard<mutex> lck(g_mtx);
+    return g_output;
+}
+
+static vector<int> gops(const vector<Output>& output)
+{
+    vector<int> ret;
+    for (auto& out : output) {
+        if (out.nalType == 5) {
+            ret.push_back(out.gop);
+        }
+    }
+    return ret;
+}
+
+static size_t bytes(const vector<Output>& output)
+{
+    size_t ret = 0;
+    for (auto& out : output) {
+        ret += out.size;
+    }
+    return ret;
+}
+
+static bool check(bool ok, const string& msg)
+{
+    cout << (ok ? "[ok] " : "[FAILED] ") << msg << endl;
+    return ok;
+}
+
+int main(int argc, char** argv)
+{
+    Logger::instance()->addChannel(std::make_shared<ConsoleChannel>("ConsoleChannel", LError));
+    Logger::instance()->setLevel(LError);
+    H264Track::registerTrackInfo();
+    H264Frame::registerFrame();
+    EventLoopPool::instance()->init(1, true, false);
+    WorkLoopPool::instance()->init(1, true, false);
+    srand(1);
+
+    uint64_t fileSize = makeFile(kRoot + "/test.ps");
+    // 文件平均码率，每毫秒字节数
+    double bytesPerMs = (double)fileSize / ((kGops * kGopSize - 1) * 40);
+    Config::instance()->setAndUpdate(kRoot, "Record", "rootPath");
+    Config::instance()->setAndUpdate(4, "Record", "trickPlayScale");
+
+    auto reader = make_shared<RecordReaderPs>("/file/vod1/test.ps/1");
+    reader->setOnFrame([](const FrameBuffer::Ptr& frame){
+        Output out;
+        out.dts = frame->dts();
+        out.nalType = frame->data()[frame->startSize()] & 0x1F;
+        out.gop = out.nalType == 5 ? (uint8_t)frame->data()[frame->startSize() + 1] - 4 : -1;
+        out.size = frame->size();
+        lock_guard<mutex> lck(g_mtx);
+        g_output.push_back(out);
+    });
+    auto loop = EventLoopPool::instance()->getLoopByCircle();
+    loop->async([reader](){
+        reader->start();
+    }, true);
+
+    bool ok = true;
+    auto normal = collect(1000);
+    ok &= check(!normal.empty(), "normal play, frames: " + to_string(normal.size()));
+
+    // 1. 快进
+    reader->scale(8);
+    auto fast = collect(2000);
+    bool onlyKey = !fast.empty();
+    bool increasing = true;
+    for (size_t i = 0; i < fast.size(); ++i) {
+        onlyKey &= fast[i].nalType == 5 || fast[i].nalType == 7 || fast[i].nalType == 8;
+        if (i > 0) {
+            increasing &= fast[i].dts >= fast[i - 1].dts;
+        }
+    }
+    auto fastGops = gops(fast);
+    for (size_t i = 1; i < fastGops.size(); ++i) {
+        increasing &= fastGops[i] > fastGops[i - 1];
+    }
+    ok &= check(onlyKey, "only keyframes at 8x, frames: " + to_string(fast.size()));
+    ok &= check(increasing && fastGops.size() >= 3, "gops and timestamps increase, keyframes: " + to_string(fastGops.size()));
+    int fastSpan = fastGops.empty() ? 0 : fastGops.back() - fastGops.front();
+    // 2秒8倍速大约前进16个gop
+    ok &= check(fastSpan >= 10 && fastSpan <= 18, "8x advances " + to_string(fastSpan) + " gops in 2s");
+
+    // 2. 限速，允许多出一个关键帧
+    double budget = bytesPerMs * 2000 + kIdrSize * 2;
+    ok &= check(bytes(fast) <= budget, "8x bitrate " + to_string(bytes(fast) / 2) + " B/s within average " + to_string((int)(bytesPerMs * 1000)));
+
+    reader->scale(16);
+    auto faster = collect(1000);
+    auto fasterGops = gops(faster);
+    int fasterSpan = fasterGops.empty() ? 0 : fasterGops.back() - fasterGops.front();
+    ok &= check(bytes(faster) <= bytesPerMs * 1000 + kIdrSize * 2, "16x bitrate " + to_string(bytes(faster)) + " B/s within average");
+    ok &= check(fasterSpan >= 10, "16x advances " + to_string(fasterSpan) + " gops in 1s");
+
+    // 3. 倒放
+    reader->scale(-8);
+    auto backward = collect(2000);
+    auto backGops = gops(backward);
+    bool decreasing = backGops.size() >= 3;
+    for (size_t i = 1; i < backGops.size(); ++i) {
+        decreasing &= backGops[i] < backGops[i - 1];
+    }
+    bool monotonic = true;
+    for (size_t i = 1; i < backward.size(); ++i) {
+        monotonic &= backward[i].dts >= backward[i - 1].dts;
+    }
+    ok &= check(decreasing && monotonic, "reverse gops decrease with increasing timestamps, keyframes: " + to_string(backGops.size()));
+
+    // 4. 恢复
+    int lastGop = backGops.empty() ? 0 : backGops.back();
+    reader->scale(1);
+    auto resume = collect(1500);
+    bool hasP = false;
+    for (auto& out : resume) {
+        hasP |= out.nalType == 1;
+    }
+    auto resumeGops = gops(resume);
+    ok &= check(hasP && !resumeGops.empty() && resumeGops.front() >= lastGop - 1 && resumeGops.front() <= lastGop + 2,
+                "normal play resumes near gop " + to_string(lastGop) + ": " + (resumeGops.empty() ? string("none") : to_string(resumeGops.front())));
+
+    File::deleteFile((kRoot + "/test.ps").data());
+    cout << (ok ? "ok" : "FAILED") << endl;
+    _exit(ok ? 0 : 1);
+}
@@ -0,0 +1,158 @@
+// webrtc跨loop转发测试
+// 1. sockAddrHash: ipv4端口和地址都参与hash，ipv6不同地址不冲突，ipv4和ipv6取值范围错开
+// 2. 批量转发: 一个loop连续转发大量报文只唤醒目标loop少数几次，所有报文都被目标loop取走
+// 3. 多个收包loop同时转发到同一个loop，各自的队列互不影响
+// 4. 不是EventLoopPool里的线程转发时退化为逐包投递
+// 编译: 先编译整个工程，再链接lib/、Base/lib下的静态库，libusrsctp.a不是PIC，需要-no-pie
+// 运行: ./webrtcForward [报文数]
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <set>
+#include <thread>
+#include <chrono>
+#include <cstring>
+#include <cstdlib>
+#include <unistd.h>
+#include <arpa/inet.h>
+
+#include "Webrtc/WebrtcContextManager.h"
+#include "Webrtc/WebrtcForwarder.h"
+#include "EventPoller/EventLoopPool.h"
+#include "Log/Logger.h"
+
+using namespace std;
+
+static bool g_ok = true;
+
+static void check(bool cond, const string& name)
+{
+    cout << (cond ? "ok     " : "FAILED ") << name << endl;
+    g_ok = g_ok && cond;
+}
+
+static uint64_t hash4(const string& ip, int port)
+{
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    inet_pton(AF_INET, ip.data(), &addr.sin_addr);
+
+    return WebrtcContextManager::sockAddrHash((sockaddr*)&addr);
+}
+
+static uint64_t hash6(const string& ip, int port)
+{
+    sockaddr_in6 addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin6_family = AF_INET6;
+    addr.sin6_port = htons(port);
+    inet_pton(AF_INET6, ip.data(), &addr.sin6_addr);
+
+    return WebrtcContextManager::sockAddrHash((sockaddr*)&addr);
+}
+
+static void testHash()
+{
+    check(hash4("192.168.1.10", 5000) == ((uint64_t)0xc0a8010a << 16 | 5000), "ipv4 hash is ip << 16 | port");
+    check(hash4("192.168.1.10", 5000) != hash4("192.168.1.10", 5001), "ipv4 port changes hash");
+    check(hash4("192.168.1.10", 5000) != hash4("192.168.1.11", 5000), "ipv4 address changes hash");
+
+    // 只有第三段或端口不同的地址
+    set<uint64_t> hashes;
+    int count = 0;
+    for (int i = 0; i < 256; ++i) {
+        char ip[64];
+        snprintf(ip, sizeof(ip), "2001:db8:%x::1", i);
+        hashes.insert(hash6(ip, 5000));
+        hashes.insert(hash6(ip, 5001));
+        count += 2;
+    }
+    check((int)hashes.size() == count, "ipv6 hashes do not collide");
+
+    bool high = true;
+    for (auto hash : hashes) {
+        high = high && (hash >> 63);
+    }
+    check(high && !(hash4("255.255.255.255", 65535) >> 63), "ipv4 and ipv6 hashes use separate ranges");
+    check(hash6("::ffff:192.168.1.10", 5000) != hash4("192.168.1.10", 5000), "v4-mapped ipv6 differs from ipv4");
+}
+
+// 转发count个报文，返回还没被取走的报文数
+static int forwardFrom(const EventLoop::Ptr& from, const EventLoop::Ptr& to, int count)
+{
+    auto buffers = make_shared<vector<weak_ptr<StreamBuffer>>>();
+    auto forward = [buffers, to, count](){
+        for (int i = 0; i < count; ++i) {
+            WebrtcForwardPacket pkt;
+            pkt.type = kForwardRtcp;
+            pkt.buffer = StreamBuffer::create();
+            pkt.buffer->assign("rtcp", 4);
+            buffers->push_back(pkt.buffer);
+            WebrtcForwarder::instance()->forward(to, std::move(pkt));
+        }
+    };
+
+    if (from) {
+        from->async(forward, true);
+    } else {
+        forward();
+    }
+    this_thread::sleep_for(chrono::milliseconds(500));
+
+    int left = 0;
+    for (auto& buffer : *buffers) {
+        left += !buffer.expired();
+    }
+    return left + count - (int)buffers->size();
+}
+
+static void testForward(int count)
+{
+    vector<EventLoop::Ptr> loops;
+    EventLoopPool::instance()->for_each_loop([&loops](const EventLoop::Ptr& loop){
+        loops.push_back(loop);
+    });
+    auto forwarder = WebrtcForwarder::instance();
+
+    auto forwardCount = forwarder->getForwardCount();
+    auto batchCount = forwarder->getBatchCount();
+    auto fallbackCount = forwarder->getFallbackCount();
+    int left = forwardFrom(loops[0], loops[1], count);
+    auto batches = forwarder->getBatchCount() - batchCount;
+    cout << "forward " << count << " packets, wakeups " << batches << endl;
+    check(left == 0, "all packets are drained by the target loop");
+    check(forwarder->getForwardCount() - forwardCount == (uint64_t)count, "forward count");
+    check(batches >= 1 && batches <= (uint64_t)count / 10, "burst costs few wakeups");
+    check(forwarder->getFallbackCount() == fallbackCount, "pool loops use the queues");
+
+    // 两个收包loop同时转发
+    int left0 = 0;
+    int left2 = 0;
+    thread thd([&](){ left2 = forwardFrom(loops[2], loops[1], count); });
+    left0 = forwardFrom(loops[0], loops[1], count);
+    thd.join();
+    check(left0 == 0 && left2 == 0, "two producers drain into one loop");
+
+    fallbackCount = forwarder->getFallbackCount();
+    left = forwardFrom(nullptr, loops[1], 100);
+    check(left == 0 && forwarder->getFallbackCount() - fallbackCount == 100, "non-pool thread falls back to async");
+}
+
+int main(int argc, char** argv)
+{
+    Logger::instance()->addChannel(std::make_shared<ConsoleChannel>("ConsoleChannel", LError));
+    Logger::instance()->setLevel(LError);
+    int count = argc > 1 ? atoi(argv[1]) : 100000;
+
+    testHash();
+
+    EventLoopPool::instance()->init(3, 0, false);
+    WebrtcForwarder::instance()->init(EventLoopPool::instance()->getThreadSize());
+    testForward(count);
+
+    cout << (g_ok ? "ok" : "FAILED") << endl;
+    _exit(g_ok ? 0 : 1);
+}
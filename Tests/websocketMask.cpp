@@ -0,0 +1,194 @@
+// websocket掩码测试
+// 1. 正确性: 各种长度、起始phase、非对齐地址下WebsocketContext::mask和逐字节异或结果一致
+// 2. 分片解码: 客户端带掩码的帧按各种大小切开喂给decode，回调出的负载和原始的一样，rsv1置位的帧被丢掉
+// 3. 吞吐: 逐字节解掩码和mask的GB/s对比
+// 编译: 先编译整个工程，再链接lib/、Base/lib下的静态库
+// 运行: ./websocketMask
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <functional>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+
+#include "Http/WebsocketContext.h"
+#include "Log/Logger.h"
+
+using namespace std;
+
+static bool g_ok = true;
+
+static void check(bool cond, const string& name)
+{
+    cout << (cond ? "ok     " : "FAILED ") << name << endl;
+    g_ok = g_ok && cond;
+}
+
+static string randomPayload(size_t size)
+{
+    string payload(size, '\0');
+    for (auto& c : payload) {
+        c = (char)rand();
+    }
+
+    return payload;
+}
+
+// 原来的做法
+static void maskByByte(uint8_t* data, size_t len, const uint8_t* key, uint32_t phase)
+{
+    for (size_t i = 0; i < len; ++i) {
+        data[i] ^= key[phase++ % 4];
+    }
+}
+
+static void testMask()
+{
+    uint8_t key[4] = {0x12, 0x9a, 0x5c, 0xe7};
+    auto payload = randomPayload(1100);
+
+    bool same = true;
+    for (size_t offset = 0; offset < 8; ++offset) {
+        for (size_t len = 0; len + offset <= payload.size(); len += (len < 300 ? 1 : 37)) {
+            for (uint32_t phase = 0; phase < 4; ++phase) {
+                string expect = payload;
+                string out = payload;
+                maskByByte((uint8_t*)&expect[offset], len, key, phase);
+                uint32_t next = WebsocketContext::mask((uint8_t*)&out[offset], len, key, phase);
+                same = same && out == expect && next == (phase + len) % 4;
+            }
+        }
+    }
+    check(same, "mask matches byte loop for all lengths, phases and offsets");
+
+    // 分几段做，phase接上后和一次做的一样
+    string once = payload;
+    string pieces = payload;
+    WebsocketContext::mask((uint8_t*)&once[0], once.size(), key);
+    uint32_t phase = 0;
+    for (size_t pos = 0; pos < pieces.size();) {
+        size_t len = min((size_t)(1 + rand() % 97), pieces.size() - pos);
+        phase = WebsocketContext::mask((uint8_t*)&pieces[pos], len, key, phase);
+        pos += len;
+    }
+    check(once == pieces, "mask keeps phase across pieces");
+}
+
+// 按客户端的格式拼带掩码的帧
+static string clientFrame(const string& payload, bool rsv1 = false)
+{
+    WebsocketFrame frame;
+    frame.finish = 1;
+    frame.rsv1 = rsv1;
+    frame.rsv2 = 0;
+    frame.rsv3 = 0;
+    frame.opcode = OpcodeType_BINARY;
+    frame.mask = 1;
+    frame.payloadLen = payload.size();
+    frame.maskKey = randomPayload(4);
+
+    WebsocketContext ctx;
+    auto header = make_shared<StringBuffer>();
+    ctx.encodeHeader(frame, header);
+    Buffer::Ptr body = make_shared<StringBuffer>(payload);
+    ctx.encodePayload(frame, body);
+
+    return string(header->data(), header->size()) + string(body->data(), body->size());
+}
+
+template <typename Slicer>
+static vector<string> feed(const string& stream, const Slicer& slicer)
+{
+    vector<string> out;
+    WebsocketContext ctx;
+    ctx.setOnWebsocketFrame([&out](const char* data, int len){
+        out.emplace_back(data, len);
+    });
+
+    // 和socket一样，每次读到的数据在自己的缓冲区里，decode会就地解掩码
+    size_t offset = 0;
+    while (offset < stream.size()) {
+        size_t len = min(slicer(), stream.size() - offset);
+        string read = stream.substr(offset, len);
+        ctx.decode((unsigned char*)&read[0], len);
+        offset += len;
+    }
+
+    return out;
+}
+
+static void testDecode()
+{
+    vector<string> payloads;
+    string stream;
+    for (size_t size : {0, 1, 3, 125, 126, 127, 1000, 65535, 65536, 300000}) {
+        payloads.push_back(randomPayload(size));
+        stream += clientFrame(payloads.back());
+    }
+    for (int i = 0; i < 50; ++i) {
+        payloads.push_back(randomPayload(rand() % 5000));
+        stream += clientFrame(payloads.back());
+    }
+
+    check(feed(stream, [&stream](){return stream.size();}) == payloads, "whole stream in one read");
+    check(feed(stream, [](){return (size_t)1;}) == payloads, "one byte per read");
+    check(feed(stream, [](){return (size_t)7;}) == payloads, "seven bytes per read");
+    check(feed(stream, [](){return (size_t)1400;}) == payloads, "1400 bytes per read");
+    check(feed(stream, [](){return (size_t)(1 + rand() % 3000);}) == payloads, "random reads");
+
+    auto compressed = clientFrame(randomPayload(500), true) + clientFrame(payloads[4]);
+    auto out = feed(compressed, [](){return (size_t)100;});
+    check(out.size() == 1 && out[0] == payloads[4], "rsv1 frame is dropped");
+}
+
+static void testThroughput()
+{
+    uint8_t key[4] = {0x12, 0x9a, 0x5c, 0xe7};
+    string data = randomPayload(1024 * 1024);
+    int rounds = 2000;
+
+    auto bench = [&](const string& name, const function<void(uint8_t*, size_t, uint32_t)>& func){
+        auto start = chrono::steady_clock::now();
+        for (int i = 0; i < rounds; ++i) {
+            func((uint8_t*)&data[0], data.size(), i);
+        }
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        double gbps = (double)data.size() * rounds / seconds / 1024 / 1024 / 1024;
+        cout << name << ": " << gbps << " GB/s" << endl;
+
+        return gbps;
+    };
+
+    double byByte = bench("byte loop", [&key](uint8_t* p, size_t len, uint32_t phase){
+        maskByByte(p, len, key, phase);
+    });
+    double simd = bench("WebsocketContext::mask", [&key](uint8_t* p, size_t len, uint32_t phase){
+        WebsocketContext::mask(p, len, key, phase);
+    });
+    // 1400字节一片，模拟按mtu读到的数据
+    double slices = bench("WebsocketContext::mask 1400 byte pieces", [&key](uint8_t* p, size_t len, uint32_t phase){
+        for (size_t pos = 0; pos < len; pos += 1400) {
+            phase = WebsocketContext::mask(p + pos, min((size_t)1400, len - pos), key, phase);
+        }
+    });
+
+    cout << "speedup " << simd / byByte << "x, with pieces " << slices / byByte << "x" << endl;
+    check(simd > byByte, "mask is faster than byte loop");
+}
+
+int main(int argc, char** argv)
+{
+    Logger::instance()->addChannel(std::make_shared<ConsoleChannel>("ConsoleChannel", LError));
+    Logger::instance()->setLevel(LError);
+    srand(1);
+
+    testMask();
+    testDecode();
+    testThroughput();
+
+    cout << (g_ok ? "ok" : "FAILED") << endl;
+    _exit(g_ok ? 0 : 1);
+}
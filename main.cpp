@@ -95,6 +95,7 @@
 #include "Log/Logger.h"
 #include "EventLoopPool.h"
 #include "WorkPoller/WorkLoopPool.h"
+#include "Net/BufferPool.h"
 #include "Common/Config.h"
 #include "Util/Thread.h"
 #include "Common/Heartbeat.h"
@@ -149,15 +150,20 @@ int main(int argc, char** argv)
             configPath = argv[++i];
         }
     }
+    // config，loop的事件后端需要在创建loop之前确定
+    Config::instance()->load(configPath);
+    string backend = Config::instance()->get("EventLoopPool", "backend", "", "", "epoll");
+    EventLoop::setBackend(backend);
+
     // 多线程开启epoll
     EventLoopPool::instance()->init(0, true, true);
     WorkLoopPool::instance()->init(0, true, true);
 #ifdef ENABLE_SRT
-    SrtEventLoopPool::instance()->init(1, true, true);
+    // srt的连接分散到多个loop上，0表示cpu核数
+    int srtLoopSize = Config::instance()->get("EventLoopPool", "srtSize", "", "", "0");
+    SrtEventLoopPool::instance()->init(srtLoopSize, true, true);
 #endif
 
-    // config
-    Config::instance()->load(configPath);
     auto configJson = Config::instance()->getConfig();
 
     int consoleLog = Config::instance()->get("Log", "console");
@@ -198,6 +204,25 @@ int main(int argc, char** argv)
 
     Logger::instance()->setLevel((LogLevel)logLevel);
 
+    // 连接级负载均衡
+    static int balancePolicy = Config::instance()->getAndListen([](const json &config){
+        balancePolicy = Config::instance()->get("EventLoopPool", "balancePolicy");
+        EventLoopPool::instance()->setBalancePolicy(balancePolicy);
+    }, "EventLoopPool", "balancePolicy");
+    EventLoopPool::instance()->setBalancePolicy(balancePolicy);
+
+    int balanceSlack = Config::instance()->get("EventLoopPool", "balanceSlack", "", "", "100");
+    EventLoopPool::instance()->setBalanceSlack(balanceSlack);
+    int migrateThreshold = Config::instance()->get("EventLoopPool", "migrateThreshold");
+    EventLoopPool::instance()->setMigrateThreshold(migrateThreshold);
+
+    // 包缓存内存池，关闭后新分配直接走malloc
+    static int bufferPool = Config::instance()->getAndListen([](const json &config){
+        bufferPool = Config::instance()->get("Util", "bufferPool", "", "", "0");
+        BufferPool::setEnable(bufferPool);
+    }, "Util", "bufferPool", "", "", "0");
+    BufferPool::setEnable(bufferPool);
+
     setFileLimits();
     setCoreLimits();
 
@@ -205,6 +230,10 @@ int main(int argc, char** argv)
     auto sslKey = Config::instance()->get("Ssl", "key");
     auto sslCrt = Config::instance()->get("Ssl", "cert");
     TlsContext::setKeyFile(sslKey, sslCrt);
+    int ktls = Config::instance()->get("Ssl", "ktls", "", "", "0");
+    TlsContext::setEnableKtls(ktls);
+    int ticketLifetime = Config::instance()->get("Ssl", "ticketLifetime", "", "", "3600");
+    TlsContext::setTicketLifetime(ticketLifetime);
 #endif
 
 #ifdef ENABLE_HOOK